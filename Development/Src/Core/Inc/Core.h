@@ -206,6 +206,7 @@ class FCompactIndex;
 class FExec;
 class FGuid;
 class FMemStack;
+class FFrameArena;
 class FPackageInfo;
 class FTransactionBase;
 class FUnknown;
@@ -362,6 +363,12 @@ public:
 	 * @param Physical	[out] size of physical allocations	
 	 */
 	virtual void GetAllocationInfo( SIZE_T& Virtual, SIZE_T& Physical ) { Virtual = Physical = 0; }
+	/**
+	 * Returns the number of Malloc and Realloc calls made so far, used for allocations per frame stats.
+	 *
+	 * @return number of calls, 0 if not tracked
+	 */
+	virtual DWORD GetAllocationCount() { return 0; }
 };
 
 // Configuration database cache.
@@ -385,6 +392,7 @@ public:
 	virtual void Detach( const TCHAR* Filename )=0;
 	virtual void Exit()=0;
 	virtual void Dump( FOutputDevice& Ar )=0;
+	virtual DWORD GetGeneration()=0;
 	virtual ~FConfigCache() {};
 };
 
@@ -533,6 +541,7 @@ class FOutputDeviceRedirector;
 
 // Core globals.
 extern FMemStack				GMem;
+extern FFrameArena				GFrameArena;
 extern FOutputDeviceRedirectorBase*	GLog;
 extern FOutputDevice*			GNull;
 extern FOutputDevice*			GThrow;
@@ -557,6 +566,8 @@ extern TCHAR					GTrue[64], GFalse[64], GYes[64], GNo[64], GNone[64];
 extern DOUBLE					GSecondsPerCycle;
 extern INT						GScriptCycles;
 extern DWORD					GPageSize;
+extern DWORD					GNumHardwareThreads;
+extern DWORD					GGameThreadId;
 extern DWORD					GUglyHackFlags;
 extern UBOOL					GIsEditor;
 extern UBOOL					GIsUCC;
@@ -622,7 +633,10 @@ extern "C" TCHAR GPackage[];
 #include "UnMath.h"						// Vector math functions.
 #include "FCallbackDevice.h"			// Base class for callback devices.
 #include "UnThreadingBase.h"			// Non-platform specific multi-threaded support.
+#include "UnProfiler.h"					// Hierarchical frame profiler.
+#include "UnMemTag.h"					// Allocation tagging.
 #include "FOutputDeviceRedirector.h"	// Output redirector.
+#include "UnPackageCompression.h"		// Chunk compressed packages.
 
 // Worker class for tracking loading errors in the editor
 class FEdLoadError
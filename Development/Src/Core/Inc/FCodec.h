@@ -27,82 +27,16 @@ class FCodecBWT : public FCodec
 {
 private:
 	enum {MAX_BUFFER_SIZE=0x40000}; /* Hand tuning suggests this is an ideal size */
-	static BYTE* CompressBuffer;
-	static INT CompressLength;
-	static INT ClampedBufferCompare( const INT* P1, const INT* P2 )
-	{
-		BYTE* B1 = CompressBuffer + *P1;
-		BYTE* B2 = CompressBuffer + *P2;
-		for( INT Count=CompressLength-Max(*P1,*P2); Count>0; Count--,B1++,B2++ )
-		{
-			if( *B1 < *B2 )
-				return -1;
-			else if( *B1 > *B2 )
-				return 1;
-		}
-		return *P1 - *P2;
-	}
+	UBOOL bParallel;	// Whether blocks are transformed on the threads of GThreadPool.
 public:
-	UBOOL Encode( FArchive& In, FArchive& Out )
-	{
-		TArray<BYTE> CompressBufferArray(MAX_BUFFER_SIZE);
-		TArray<INT>  CompressPosition   (MAX_BUFFER_SIZE+1);
-		CompressBuffer = &CompressBufferArray(0);
-		INT i, First=0, Last=0;
-		while( !In.AtEnd() )
-		{
-			CompressLength = Min<INT>( In.TotalSize()-In.Tell(), MAX_BUFFER_SIZE );
-			In.Serialize( CompressBuffer, CompressLength );
-			for( i=0; i<CompressLength+1; i++ )
-				CompressPosition(i) = i;
-			appQsort( &CompressPosition(0), CompressLength+1, sizeof(INT), (QSORT_COMPARE)ClampedBufferCompare );
-			for( i=0; i<CompressLength+1; i++ )
-				if( CompressPosition(i)==1 )
-					First = i;
-				else if( CompressPosition(i)==0 )
-					Last = i;
-			Out << CompressLength << First << Last;
-			for( i=0; i<CompressLength+1; i++ )
-				Out << CompressBuffer[CompressPosition(i)?CompressPosition(i)-1:0];
-			//warnf(TEXT("Compression table"));
-			//for( i=0; i<CompressLength+1; i++ )
-			//	warnf(TEXT("    %03i: %s"),CompressPosition(i)?CompressBuffer[CompressPosition(i)-1]:-1,ANSI_TO_TCHAR((ANSICHAR*)CompressBuffer+CompressPosition(i)));
-		}
-		return 0;
-	}
-	UBOOL Decode( FArchive& In, FArchive& Out )
-	{
-		TArray<BYTE> DecompressBuffer(MAX_BUFFER_SIZE+1);
-		TArray<INT>  Temp(MAX_BUFFER_SIZE+1);
-		INT DecompressLength, DecompressCount[256+1], RunningTotal[256+1], i, j;
-		while( !In.AtEnd() )
-		{
-			INT First, Last;
-			In << DecompressLength << First << Last;
-			check(DecompressLength<=MAX_BUFFER_SIZE+1);
-			check(DecompressLength<=In.TotalSize()-In.Tell());
-			In.Serialize( &DecompressBuffer(0), ++DecompressLength );
-			for( i=0; i<257; i++ )
-				DecompressCount[ i ]=0;
-			for( i=0; i<DecompressLength; i++ )
-				DecompressCount[ i!=Last ? DecompressBuffer(i) : 256 ]++;
-			INT Sum = 0;
-			for( i=0; i<257; i++ )
-			{
-				RunningTotal[i] = Sum;
-				Sum += DecompressCount[i];
-				DecompressCount[i] = 0;
-			}
-			for( i=0; i<DecompressLength; i++ )
-			{
-				INT Index = i!=Last ? DecompressBuffer(i) : 256;
-				Temp(RunningTotal[Index] + DecompressCount[Index]++) = i;
-			}
-			for( i=First,j=0 ; j<DecompressLength-1; i=Temp(i),j++ )
-				Out << DecompressBuffer(i);
-		}
-		return 1;
-	}
+	FCodecBWT( UBOOL InParallel=1 )
+	: bParallel( InParallel )
+	{}
+	// Sorts the Length+1 suffixes of Data, including the empty one, in linear time. A suffix
+	// sorts after the longer suffixes it is a prefix of.
+	static void SortSuffixes( const BYTE* Data, INT Length, INT* Positions );
+	UBOOL Encode( FArchive& In, FArchive& Out );
+	UBOOL Decode( FArchive& In, FArchive& Out );
 };
 
 /*-----------------------------------------------------------------------------
@@ -364,17 +298,18 @@ private:
 	TArray<FCodec*> Codecs;
 	void Code( FArchive& In, FArchive& Out, INT Step, INT First, UBOOL (FCodec::*Func)(FArchive&,FArchive&) )
 	{
-		TArray<BYTE> InData, OutData;
+		TArray<BYTE> InData;
 		for( INT i=0; i<Codecs.Num(); i++ )
 		{
+			// Each stage writes into a buffer sized after its input, which the next stage reads
+			// in place, so stage outputs are neither copied nor regrown.
+			TArray<BYTE> OutData;
+			if( i<Codecs.Num()-1 )
+				OutData.Empty( (i ? InData.Num() : In.TotalSize()-In.Tell()) / 8 * 9 + 64 );
 			FBufferReader Reader(InData);
 			FBufferWriter Writer(OutData);
 			(Codecs(First + Step*i)->*Func)( *(i ? &Reader : &In), *(i<Codecs.Num()-1 ? &Writer : &Out) );
-			if( i<Codecs.Num()-1 )
-			{
-				InData = OutData;
-				OutData.Empty();
-			}
+			ExchangeArray( InData, OutData );
 		}
 	}
 public:
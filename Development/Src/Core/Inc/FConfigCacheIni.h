@@ -174,12 +174,159 @@ public:
 	}
 };
 
+// Section and key of a value in the typed lookup cache.
+struct FConfigValueKey
+{
+	FName Section, Key;
+
+	FConfigValueKey()
+	{}
+	FConfigValueKey( FName InSection, FName InKey )
+	: Section( InSection )
+	, Key( InKey )
+	{}
+	UBOOL operator==( const FConfigValueKey& Other ) const
+	{
+		return Section==Other.Section && Key==Other.Key;
+	}
+	friend DWORD GetTypeHash( const FConfigValueKey& ValueKey )
+	{
+		return GetTypeHash(ValueKey.Section) ^ (GetTypeHash(ValueKey.Key) * 23);
+	}
+};
+
+// A config value, parsed once into typed slots when the lookup cache is built.
+struct FConfigValue
+{
+	FString String;
+	INT		IntValue;
+	FLOAT	FloatValue;
+	UBOOL	BoolValue;
+
+	FConfigValue()
+	{}
+	FConfigValue( const FString& InString )
+	: String( InString )
+	, IntValue( appAtoi(*InString) )
+	, FloatValue( appAtof(*InString) )
+	, BoolValue( appStricmp(*InString,TEXT("True"))==0 || appAtoi(*InString)==1 )
+	{}
+};
+
+// All values of one config file, keyed by section and key name.
+typedef TMap<FConfigValueKey,FConfigValue> FConfigValueMap;
+
 // Set of all cached config files.
 class FConfigCacheIni : public FConfigCache, public TMap<FString,FConfigFile>
 {
+private:
+	// Typed lookup cache per file, keyed by file name. Built lazily the first time a
+	// file is queried and discarded whenever the file is modified, reloaded or unloaded.
+	TMap<FName,FConfigValueMap> ValueCaches;
+	// Incremented whenever the contents of any file have changed.
+	DWORD Generation;
+	// Section last handed out for modification by GetSectionPrivate, its file and the CRC
+	// of its contents at the time. Checked for changes before the caches are used again.
+	FConfigSection* PendingSection;
+	FString PendingFilename;
+	DWORD PendingSectionCrc;
+
+	// Discards the lookup cache of the passed in file or of all files if NULL.
+	void InvalidateValueCache( const TCHAR* Filename )
+	{
+		Generation++;
+		if( !Filename )
+		{
+			ValueCaches.Empty();
+		}
+		else if( FName::GetInitialized() )
+		{
+			FName FileName( Filename, FNAME_Find );
+			if( FileName!=NAME_None )
+				ValueCaches.Remove( FileName );
+		}
+	}
+	// Returns a CRC of the keys and values of a section.
+	static DWORD GetSectionCrc( FConfigSection* Sec )
+	{
+		DWORD Crc = Sec->Num();
+		for( FConfigSection::TIterator It(*Sec); It; ++It )
+		{
+			Crc = appMemCrc( *It.Key(), It.Key().Len()*sizeof(TCHAR), Crc );
+			Crc = appMemCrc( *It.Value(), It.Value().Len()*sizeof(TCHAR), Crc );
+		}
+		return Crc;
+	}
+	// Invalidates the caches if the section last handed out by GetSectionPrivate was modified.
+	// Needs to be called before the file maps change, which might move the section.
+	void CheckPendingSection()
+	{
+		if( PendingSection )
+		{
+			FConfigSection* Sec = PendingSection;
+			PendingSection = NULL;
+			if( GetSectionCrc(Sec)!=PendingSectionCrc )
+				InvalidateValueCache( *PendingFilename );
+		}
+	}
+	// Builds the lookup cache of a file. Names are added intrinsically so they survive
+	// name garbage collection for as long as the cache references them.
+	void BuildValueCache( FConfigFile* File, FConfigValueMap& Values )
+	{
+		for( FConfigFile::TIterator It(*File); It; ++It )
+		{
+			if( It.Key().Len()>=NAME_SIZE )
+				continue;
+			FName SectionName( *It.Key(), FNAME_Intrinsic );
+			for( FConfigSection::TIterator It2(It.Value()); It2; ++It2 )
+			{
+				if( It2.Key().Len()>=NAME_SIZE )
+					continue;
+				FConfigValueKey ValueKey( SectionName, FName(*It2.Key(),FNAME_Intrinsic) );
+				if( !Values.Find(ValueKey) )
+				{
+					// Cache what a lookup of the section returns, as keys might have several values.
+					Values.Set( ValueKey, FConfigValue(*It.Value().Find(It2.Key())) );
+				}
+			}
+		}
+	}
+	// Looks up a value in the typed lookup cache, building it for the file if necessary.
+	// Returns 0 if the cache can't answer the query, in which case the caller needs to
+	// use the string maps, otherwise Value is set to the cached value or NULL if the key
+	// doesn't exist.
+	UBOOL FindCachedValue( const TCHAR* Section, const TCHAR* Key, const TCHAR* Filename, FConfigValue*& Value )
+	{
+		Value = NULL;
+		CheckPendingSection();
+		if( !FName::GetInitialized() || appStrlen(Filename)>=NAME_SIZE || appStrlen(Section)>=NAME_SIZE || appStrlen(Key)>=NAME_SIZE )
+			return 0;
+
+		FConfigValueMap* Values = ValueCaches.Find( FName(Filename,FNAME_Find) );
+		if( !Values )
+		{
+			FConfigFile* File = Find( Filename, 0 );
+			if( !File )
+				return 0;
+			Values = &ValueCaches.Set( FName(Filename,FNAME_Intrinsic), FConfigValueMap() );
+			BuildValueCache( File, *Values );
+		}
+
+		// Names that don't exist can't be in the cache.
+		FName SectionName( Section, FNAME_Find ), KeyName( Key, FNAME_Find );
+		if( (SectionName==NAME_None && *Section) || (KeyName==NAME_None && *Key) )
+			return 1;
+
+		Value = Values->Find( FConfigValueKey(SectionName,KeyName) );
+		return 1;
+	}
+
 public:
 	// Basic functions.
 	FConfigCacheIni()
+	: Generation( 0 )
+	, PendingSection( NULL )
+	, PendingSectionCrc( 0 )
 	{}
 	~FConfigCacheIni()
 	{
@@ -188,6 +335,7 @@ public:
 	FConfigFile* Find( const TCHAR* InFilename, UBOOL CreateIfNotFound )
 	{
 		FFilename Filename( InFilename  );
+		CheckPendingSection();
 			
 		// Get file.
 		FConfigFile* Result = TMap<FString,FConfigFile>::Find( *Filename );
@@ -195,11 +343,13 @@ public:
 		{
 			Result = &Set( *Filename, FConfigFile() );
 			Result->Read( *Filename );
+			InvalidateValueCache( *Filename );
 		}
 		return Result;
 	}
 	void Flush( UBOOL Read, const TCHAR* Filename=NULL )
 	{
+		CheckPendingSection();
 		for( TIterator It(*this); It; ++It )
 			if( !Filename || It.Key()==Filename )
 				It.Value().Write( *It.Key() );
@@ -209,13 +359,17 @@ public:
 				Remove(Filename);
 			else
 				Empty();
+			InvalidateValueCache( Filename );
 		}
 	}
 	void UnloadFile( const TCHAR* Filename )
 	{
 		FConfigFile* File = Find( Filename, 1 );
 		if( File )
+		{
 			Remove( Filename );
+			InvalidateValueCache( Filename );
+		}
 	}
 	void Detach( const TCHAR* Filename )
 	{
@@ -223,8 +377,25 @@ public:
 		if( File )
 			File->NoSave = 1;
 	}
+	DWORD GetGeneration()
+	{
+		CheckPendingSection();
+		return Generation;
+	}
 	UBOOL GetString( const TCHAR* Section, const TCHAR* Key, FString& Value, const TCHAR* Filename )
 	{
+		FConfigValue* CachedValue;
+		if( FindCachedValue( Section, Key, Filename, CachedValue ) )
+		{
+			if( !CachedValue )
+			{
+				Value = TEXT("");
+				return 0;
+			}
+			Value = CachedValue->String;
+			return 1;
+		}
+
 		Value = TEXT("");
 		FConfigFile* File = Find( Filename, 0 );
 		if( !File )
@@ -260,7 +431,13 @@ public:
 		if( !Sec && Force )
 			Sec = &File->Set( Section, FConfigSection() );
 		if( Sec && (Force || !Const) )
+		{
+			// The caller is allowed to modify the section, the caches are only invalidated if it does.
 			File->Dirty = 1;
+			PendingSection		= Sec;
+			PendingFilename		= Filename;
+			PendingSectionCrc	= GetSectionCrc( Sec );
+		}
 		return Sec;
 	}
 	void SetString( const TCHAR* Section, const TCHAR* Key, const TCHAR* Value, const TCHAR* Filename )
@@ -274,11 +451,13 @@ public:
 		{
 			Sec->Add( Key, Value );
 			File->Dirty = 1;
+			InvalidateValueCache( Filename );
 		}
 		else if( appStricmp(**Str,Value)!=0 )
 		{
 			File->Dirty = (appStrcmp(**Str,Value)!=0);
 			*Str = Value;
+			InvalidateValueCache( Filename );
 		}
 	}
 	void EmptySection( const TCHAR* Section, const TCHAR* Filename )
@@ -291,6 +470,7 @@ public:
 			{
 				Sec->Empty();
 				File->Dirty = 1;
+				InvalidateValueCache( Filename );
 			}
 		}
 	}
@@ -319,6 +499,15 @@ public:
 		const TCHAR*	Filename
 	)
 	{
+		FConfigValue* CachedValue;
+		if( FindCachedValue( Section, Key, Filename, CachedValue ) )
+		{
+			if( !CachedValue )
+				return 0;
+			Value = CachedValue->IntValue;
+			return 1;
+		}
+
 		FString Text; 
 		if( GetString( Section, Key, Text, Filename ) )
 		{
@@ -335,6 +524,15 @@ public:
 		const TCHAR*	Filename
 	)
 	{
+		FConfigValue* CachedValue;
+		if( FindCachedValue( Section, Key, Filename, CachedValue ) )
+		{
+			if( !CachedValue )
+				return 0;
+			Value = CachedValue->FloatValue;
+			return 1;
+		}
+
 		FString Text; 
 		if( GetString( Section, Key, Text, Filename ) )
 		{
@@ -351,6 +549,15 @@ public:
 		const TCHAR*	Filename
 	)
 	{
+		FConfigValue* CachedValue;
+		if( FindCachedValue( Section, Key, Filename, CachedValue ) )
+		{
+			if( !CachedValue )
+				return 0;
+			Value = CachedValue->BoolValue;
+			return 1;
+		}
+
 		FString Text; 
 		if( GetString( Section, Key, Text, Filename ) )
 		{
@@ -0,0 +1,144 @@
+/*=============================================================================
+	FMallocTagProxy.h: FMalloc proxy attributing allocations to memory tags.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/**
+ * FMalloc proxy prefixing every allocation with a small header recording its size
+ * and the memory tag that was active on the allocating thread, and accounting for
+ * it in GMemoryTagTracker. Not thread safe by itself, it needs to be used by a
+ * FMallocThreadSafeProxy so the tracker is only ever modified with the lock held.
+ *
+ * Physical allocations are passed through untagged as they are already accounted
+ * for by the memory stats and callers might rely on their alignment.
+ */
+class FMallocTagProxy : public FMalloc
+{
+private:
+	/** Header stored in front of each allocation, 16 bytes to preserve the alignment of the used malloc */
+	struct FAllocHeader
+	{
+		/** Size of allocation as requested by caller */
+		DWORD	Size;
+		/** Tag the allocation is accounted for */
+		INT		Tag;
+		/** Index of sample recorded for allocation, INDEX_NONE if none */
+		INT		SampleIndex;
+		/** Sentinel used to catch pointers not allocated via this proxy */
+		DWORD	Magic;
+	};
+	enum { HEADER_MAGIC = 0x7A6E3E71 };
+
+	/** Malloc we're based on, aka using under the hood							*/
+	FMalloc*		UsedMalloc;
+
+	/**
+	 * Returns the header of the passed in allocation.
+	 *
+	 * @param	Ptr		Pointer returned by Malloc or Realloc
+	 * @return	header of allocation
+	 */
+	static FORCEINLINE FAllocHeader* GetHeader( void* Ptr )
+	{
+		FAllocHeader* Header = ((FAllocHeader*) Ptr) - 1;
+		checkSlow(Header->Magic == HEADER_MAGIC);
+		return Header;
+	}
+
+public:
+	/**
+	 * Constructor for memory tagging proxy malloc that takes a malloc to be used.
+	 *
+	 * @param	InMalloc	FMalloc that is going to be used for actual allocations
+	 */
+	FMallocTagProxy( FMalloc* InMalloc )
+	:	UsedMalloc( InMalloc )
+	{}
+
+	// FMalloc interface.
+
+	void* Malloc( DWORD Size )
+	{
+		FAllocHeader* Header	= (FAllocHeader*) UsedMalloc->Malloc( Size + sizeof(FAllocHeader) );
+		Header->Size			= Size;
+		Header->Tag				= GMemoryTagTracker.GetCurrentTag();
+		Header->Magic			= HEADER_MAGIC;
+		Header->SampleIndex		= GMemoryTagTracker.TrackAlloc( Header->Tag, Size );
+		return Header + 1;
+	}
+	void* Realloc( void* Ptr, DWORD NewSize )
+	{
+		if( Ptr == NULL )
+		{
+			return NewSize ? Malloc( NewSize ) : NULL;
+		}
+		if( NewSize == 0 )
+		{
+			Free( Ptr );
+			return NULL;
+		}
+
+		// The allocation keeps the tag of whoever allocated it originally.
+		FAllocHeader*	OldHeader	= GetHeader( Ptr );
+		DWORD			OldSize		= OldHeader->Size;
+		FAllocHeader*	Header		= (FAllocHeader*) UsedMalloc->Realloc( OldHeader, NewSize + sizeof(FAllocHeader) );
+		GMemoryTagTracker.TrackRealloc( Header->Tag, OldSize, NewSize, Header->SampleIndex );
+		Header->Size = NewSize;
+		return Header + 1;
+	}
+	void Free( void* Ptr )
+	{
+		if( Ptr )
+		{
+			FAllocHeader* Header = GetHeader( Ptr );
+			GMemoryTagTracker.TrackFree( Header->Tag, Header->Size, Header->SampleIndex );
+			Header->Magic = 0;
+			UsedMalloc->Free( Header );
+		}
+	}
+	void* PhysicalAlloc( DWORD Size, ECacheBehaviour InCacheBehaviour )
+	{
+		return UsedMalloc->PhysicalAlloc( Size, InCacheBehaviour );
+	}
+	void PhysicalFree( void* Ptr )
+	{
+		UsedMalloc->PhysicalFree( Ptr );
+	}
+	/**
+	 * Passes request for gathering memory allocations for both virtual and physical allocations
+	 * on to used memory manager.
+	 *
+	 * @param Virtual	[out] size of virtual allocations
+	 * @param Physical	[out] size of physical allocations
+	 */
+	void GetAllocationInfo( SIZE_T& Virtual, SIZE_T& Physical )
+	{
+		UsedMalloc->GetAllocationInfo( Virtual, Physical );
+	}
+	void DumpAllocs()
+	{
+		UsedMalloc->DumpAllocs();
+	}
+	void HeapCheck()
+	{
+		UsedMalloc->HeapCheck();
+	}
+	void Init( UBOOL Reset )
+	{
+		GMemoryTagTracker.Init();
+		UsedMalloc->Init( Reset );
+	}
+	void Exit()
+	{
+		UsedMalloc->Exit();
+	}
+	void DumpMemoryImage()
+	{
+		UsedMalloc->DumpMemoryImage();
+	}
+};
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
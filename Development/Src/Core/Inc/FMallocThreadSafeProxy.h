@@ -17,6 +17,8 @@ private:
 	FMalloc*		UsedMalloc;
 	/** Object used for synchronization via a scoped lock						*/
 	FSynchronize*	SynchronizationObject;
+	/** Number of Malloc and Realloc calls										*/
+	DWORD			AllocationCount;
 
 public:
 	/**
@@ -28,7 +30,8 @@ public:
 	 */
 	FMallocThreadSafeProxy( FMalloc* InMalloc, FSynchronize* InSynchronizationObject )
 	:	UsedMalloc( InMalloc ),
-		SynchronizationObject( InSynchronizationObject )
+		SynchronizationObject( InSynchronizationObject ),
+		AllocationCount( 0 )
 	{}
 
 	// FMalloc interface.
@@ -36,11 +39,13 @@ public:
 	void* Malloc( DWORD Size )
 	{
 		FScopeLock ScopeLock( SynchronizationObject );
+		AllocationCount++;
 		return UsedMalloc->Malloc( Size );
 	}
 	void* Realloc( void* Ptr, DWORD NewSize )
 	{
 		FScopeLock ScopeLock( SynchronizationObject );
+		AllocationCount++;
 		return UsedMalloc->Realloc( Ptr, NewSize );
 	}
 	void Free( void* Ptr )
@@ -95,6 +100,15 @@ public:
 		FScopeLock ScopeLock( SynchronizationObject );
 		UsedMalloc->Exit();
 	}
+	/**
+	 * Returns the number of Malloc and Realloc calls made so far.
+	 *
+	 * @return number of calls
+	 */
+	DWORD GetAllocationCount()
+	{
+		return AllocationCount;
+	}
 };
 
 /*-----------------------------------------------------------------------------
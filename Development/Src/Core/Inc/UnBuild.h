@@ -16,6 +16,16 @@
 
 #define DEMOVERSION		0
 
+// Trace scopes are cheap enough to be left enabled in final release builds.
+#ifndef DO_TRACE
+	#define DO_TRACE	1
+#endif
+
+// Tagging every allocation costs a 16 byte header so it needs to be enabled explicitly.
+#ifndef TRACK_MEMORY_TAGS
+	#define TRACK_MEMORY_TAGS	0
+#endif
+
 #endif
 
 /*-----------------------------------------------------------------------------
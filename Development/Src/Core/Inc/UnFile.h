@@ -124,6 +124,11 @@ VARARG_DECL( const void, static const void, VARARG_NONE, EdLoadErrorf, VARARG_NO
 void appDebugBreak();
 UBOOL appIsDebuggerPresent();
 
+#if !DEFINED_appCaptureStackBackTrace
+// Platforms without cheap callstack capture don't capture any frames.
+inline DWORD appCaptureStackBackTrace( QWORD* BackTrace, DWORD MaxDepth, DWORD FramesToSkip ) { return 0; }
+#endif
+
 // Define NO_LOGGING to strip out all writing to log files, OutputDebugString(), etc.
 // This is needed for consoles that require no logging (Xbox, Xenon)
 #ifndef NO_LOGGING
@@ -303,6 +308,7 @@ UBOOL appUpdateFileModTime( TCHAR* Filename );
 
 const TCHAR* appCmdLine();
 const TCHAR* appBaseDir();
+const TCHAR* appExecutableName();
 const TCHAR* appComputerName();
 const TCHAR* appUserName();
 
@@ -331,12 +337,32 @@ DWORD appCycles();
 DOUBLE appSeconds();
 #endif
 
+#if !DEFINED_appCycles64
+QWORD appCycles64();
+#endif
+
 void appSystemTime( INT& Year, INT& Month, INT& DayOfWeek, INT& Day, INT& Hour, INT& Min, INT& Sec, INT& MSec );
 SQWORD appSystemTime64();
 const TCHAR* appTimestamp();
 DOUBLE appSecondsSlow();
 void appSleep( FLOAT Seconds );
 
+/*-----------------------------------------------------------------------------
+	Thread functions.
+-----------------------------------------------------------------------------*/
+
+#if !DEFINED_appThreadLocalStorage
+DWORD appGetCurrentThreadId();
+DWORD appAllocTlsSlot();
+void appSetTlsValue( DWORD SlotIndex, void* Value );
+void* appGetTlsValue( DWORD SlotIndex );
+void appFreeTlsSlot( DWORD SlotIndex );
+#endif
+
+#if !DEFINED_appMemoryBarrier
+void appMemoryBarrier();
+#endif
+
 /*-----------------------------------------------------------------------------
 	Character type functions.
 -----------------------------------------------------------------------------*/
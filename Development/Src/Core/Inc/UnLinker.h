@@ -90,6 +90,7 @@ public:
 	INT     ImportCount,	ImportOffset;
 	FGuid	Guid;
 	TArray<FGenerationInfo> Generations;
+	TArray<FCompressedChunk> CompressedChunks;	// Only stored with PKG_StoreCompressed.
 
 	// Constructor.
 	FPackageFileSummary();
@@ -150,6 +151,7 @@ class ULinkerLoad : public ULinker, public FArchive
 	INT						ExportHash[256];
 	TArray<FLazyLoader*>	LazyLoaders;
 	FArchive*				Loader;
+	UBOOL					bStoredCompressed;	// Whether the file is chunk compressed, in which case offsets don't point into the file on disk.
 
 	ULinkerLoad( UObject* InParent, const TCHAR* InFilename, DWORD InLoadFlags );
 
@@ -162,6 +164,19 @@ class ULinkerLoad : public ULinker, public FArchive
 	UObject* Create( UClass* ObjectClass, FName ObjectName, DWORD LoadFlags, UBOOL Checked );
 	void Preload( UObject* Object );
 
+	/**
+	 * Returns the offset of a lazy loader's payload in the file on disk, which only
+	 * exists if the package isn't chunk compressed.
+	 *
+	 * @param	LazyLoader	Lazy loader serialized by this linker
+	 * @return	offset in bytes from beginning of file to beginning of data
+	 */
+	DWORD GetFileOffset( FLazyLoader& LazyLoader )
+	{
+		check(!bStoredCompressed);
+		return LazyLoader.GetOffset();
+	}
+
 private:
 	UObject* CreateExport( INT Index );
 	UObject* CreateImport( INT Index );
@@ -175,6 +175,147 @@ private:
 	FMemStack::FTaggedMemory* SavedChunk;
 };
 
+/*-----------------------------------------------------------------------------
+	FFrameArena.
+-----------------------------------------------------------------------------*/
+
+//
+// Contiguous linear allocator for temporary arrays and strings built by the game
+// thread during a frame, see TFrameArray and FFrameString. Unlike FMemStack it
+// lives in a single block so FArray can tell whether its data was allocated from
+// the arena with two compares. Allocations are freed in LIFO order by rewinding
+// the top of the arena, anything else is reclaimed at the end of the frame.
+// Allocations that don't fit or are made by other threads fail so callers can
+// fall back to the heap. Arena memory may only be freed by the owning thread.
+//
+class FFrameArena
+{
+public:
+	// Main functions.
+	void Init( INT Size );
+	void Exit();
+	void Tick();
+
+	// Whether the passed in pointer was allocated from the arena.
+	FORCEINLINE UBOOL Contains( const void* Ptr ) const
+	{
+		return (BYTE*)Ptr >= Base && (BYTE*)Ptr < End;
+	}
+
+	// Size of an allocation made from the arena.
+	FORCEINLINE INT GetAllocationSize( const void* Ptr ) const
+	{
+		checkSlow(Contains(Ptr));
+		return ((FAllocHeader*)Ptr - 1)->Size;
+	}
+
+	// Allocation functions, Allocate and Realloc return NULL if the request can't be satisfied.
+	void* Allocate( INT Size );
+	void* Realloc( void* Ptr, INT NewSize );
+	void Free( void* Ptr );
+
+	// Statistics of the last completed frame.
+	DWORD GetLastFrameAllocations() const	{ return LastFrameAllocations; }
+	INT GetLastFramePeakBytes() const		{ return LastFramePeakBytes; }
+	DWORD GetLastFrameFallbacks() const		{ return LastFrameFallbacks; }
+
+private:
+	// Header in front of each allocation, 16 bytes to keep the data aligned.
+	struct FAllocHeader
+	{
+		INT Size;
+		INT Padding[3];
+	};
+
+	// Variables.
+	void*	Memory;					// Memory backing the arena, as returned by appMalloc.
+	BYTE*	Base;					// Start of arena, NULL if not initialized.
+	BYTE*	Top;					// First free byte.
+	BYTE*	End;					// End of arena.
+	DWORD	OwnerThreadId;			// Only the thread that initialized the arena may allocate from it.
+	INT		LiveAllocations;		// Number of allocations that haven't been freed yet.
+	DWORD	FrameAllocations;		// Allocations made this frame.
+	INT		FramePeakBytes;			// Highest number of bytes in use this frame.
+	DWORD	FrameFallbacks;			// Requests this frame that couldn't be satisfied.
+	DWORD	LastFrameAllocations;	// Statistics of the last completed frame.
+	INT		LastFramePeakBytes;
+	DWORD	LastFrameFallbacks;
+	UBOOL	bWarnedAboutLeak;		// Whether the leak warning has been emitted already.
+};
+
+/*-----------------------------------------------------------------------------
+	Frame arena containers.
+-----------------------------------------------------------------------------*/
+
+//
+// Array whose initial storage is allocated from the frame arena. It can be passed
+// to anything taking a TArray as FArray keeps growing it inside the arena. Must be
+// a local variable of a function running on the game thread, it may not outlive
+// the frame. Falls back to the heap if the arena is exhausted.
+//
+template<class T> class TFrameArray : public TArray<T>
+{
+public:
+	TFrameArray( INT Slack )
+	: TArray<T>()
+	{
+		this->Data = GFrameArena.Allocate( Slack*sizeof(T) );
+		if( this->Data )
+		{
+			this->ArrayMax = Slack;
+		}
+	}
+	~TFrameArray()
+	{
+		if( GFrameArena.Contains( this->Data ) )
+		{
+			this->Remove( 0, this->ArrayNum );
+			GFrameArena.Free( this->Data );
+			this->Data		= NULL;
+			this->ArrayMax	= 0;
+		}
+	}
+};
+
+//
+// String whose initial storage is allocated from the frame arena, with the same
+// restrictions as TFrameArray.
+//
+class FFrameString : public FString
+{
+public:
+	FFrameString( INT Slack, const TCHAR* In=TEXT("") )
+	: FString()
+	{
+		Data = GFrameArena.Allocate( Slack*sizeof(TCHAR) );
+		if( Data )
+		{
+			ArrayMax = Slack;
+		}
+		*this = In;
+	}
+	FFrameString& operator=( const TCHAR* Other )
+	{
+		FString::operator=( Other );
+		return *this;
+	}
+	FFrameString& operator=( const FString& Other )
+	{
+		FString::operator=( Other );
+		return *this;
+	}
+	~FFrameString()
+	{
+		if( GFrameArena.Contains( Data ) )
+		{
+			GFrameArena.Free( Data );
+			Data		= NULL;
+			ArrayNum	= 0;
+			ArrayMax	= 0;
+		}
+	}
+};
+
 /*-----------------------------------------------------------------------------
 	The End.
 -----------------------------------------------------------------------------*/
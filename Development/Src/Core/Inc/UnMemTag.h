@@ -0,0 +1,376 @@
+/*=============================================================================
+	UnMemTag.h: Allocation tagging and per tag memory accounting.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/*-----------------------------------------------------------------------------
+	Definitions.
+-----------------------------------------------------------------------------*/
+
+/** Maximum number of distinct tags, including one per UClass that allocated objects */
+#define MAX_MEMORY_TAGS				2048
+/** Maximum length of a tag name, including terminator */
+#define MAX_MEMORY_TAG_NAME			64
+/** Maximum number of live sampled allocations */
+#define MAX_MEMORY_SAMPLES			16384
+/** Number of return addresses recorded per sampled allocation */
+#define MEMORY_SAMPLE_DEPTH			12
+
+/**
+ * Tags named up front by FMemoryTagTracker::Init, so MEMORY_TAG_SCOPE never needs to
+ * register a tag while allocations are being made on several threads.
+ */
+enum EMemoryTag
+{
+	MEMORY_TAG_Untagged,		// Allocations outside of any tag scope.
+	MEMORY_TAG_OtherClasses,	// UClasses once the tag table is full.
+	MEMORY_TAG_Names,
+	MEMORY_TAG_UnrealScript,
+	MEMORY_TAG_Packages,
+	MEMORY_TAG_SpawnActor,
+	MEMORY_TAG_Net,
+	MEMORY_TAG_FrameArena,
+	MEMORY_TAG_BuiltinCount
+};
+
+/**
+ * Accounting of a single tag. Updated by FMallocTagProxy, which is used inside the
+ * thread safe proxy so all counters are modified while the malloc lock is held.
+ */
+struct FMemoryTagStats
+{
+	/** Human readable name of tag */
+	TCHAR	Name[MAX_MEMORY_TAG_NAME];
+	/** Bytes currently allocated */
+	SQWORD	LiveBytes;
+	/** Highest value LiveBytes has ever had */
+	SQWORD	PeakBytes;
+	/** Number of allocations currently live */
+	INT		LiveAllocations;
+	/** Total number of allocations, including freed ones */
+	QWORD	TotalAllocations;
+	/** Total number of bytes ever allocated */
+	QWORD	TotalBytes;
+	/** TotalAllocations at the beginning of the current frame */
+	QWORD	FrameStartAllocations;
+	/** TotalBytes at the beginning of the current frame */
+	QWORD	FrameStartBytes;
+	/** Smoothed number of allocations per frame */
+	FLOAT	AllocationsPerFrame;
+	/** Smoothed number of bytes allocated per frame */
+	FLOAT	BytesPerFrame;
+};
+
+/**
+ * Callstack of a live sampled allocation.
+ */
+struct FMemoryTagSample
+{
+	/** Return addresses, innermost first, zero terminated if less than MEMORY_SAMPLE_DEPTH */
+	QWORD	BackTrace[MEMORY_SAMPLE_DEPTH];
+	/** Size of allocation */
+	DWORD	Size;
+	/** Tag of allocation */
+	INT		Tag;
+	/** Next free sample if unused */
+	INT		NextFree;
+	/** Whether the sample belongs to a live allocation */
+	UBOOL	bLive;
+};
+
+/*-----------------------------------------------------------------------------
+	FMemoryTagTracker.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Registry of memory tags and their statistics. Tags are pushed per thread via
+ * FScopedMemoryTag and picked up by FMallocTagProxy for every allocation made while
+ * the scope is active. Everything is stored in fixed size tables so the tracker
+ * never needs to allocate memory itself. There is no constructor as the global
+ * instance is used by the allocator before static constructors have run, all
+ * members are valid when zero.
+ */
+class FMemoryTagTracker
+{
+public:
+	/**
+	 * Returns the index of the tag with the passed in name, registering it if needed.
+	 * Tags used by MEMORY_TAG_SCOPE are builtin, this is for tags only known at runtime.
+	 *
+	 * @param	Name	Name of tag
+	 * @return	index of tag, MEMORY_TAG_Untagged if the tag table is full
+	 */
+	INT RegisterTag( const TCHAR* Name );
+
+	/**
+	 * Returns the tag used for objects of the passed in class, registering it if needed.
+	 *
+	 * @param	Class	Class to retrieve tag for
+	 * @return	index of tag
+	 */
+	INT GetClassTag( UClass* Class );
+
+	/**
+	 * @return the tag active on the calling thread
+	 */
+	FORCEINLINE INT GetCurrentTag() const
+	{
+		return bInitialized ? (INT)(PTRINT) appGetTlsValue( TlsSlot ) : MEMORY_TAG_Untagged;
+	}
+
+	/**
+	 * Sets the tag active on the calling thread.
+	 *
+	 * @param	Tag		Tag to set
+	 */
+	FORCEINLINE void SetCurrentTag( INT Tag )
+	{
+		if( bInitialized )
+		{
+			appSetTlsValue( TlsSlot, (void*)(PTRINT) Tag );
+		}
+	}
+
+	/**
+	 * Allocates the thread local storage slot and names the builtin tags. Called by
+	 * FMallocTagProxy::Init once the platform has been initialized.
+	 */
+	void Init();
+
+	/**
+	 * Accounts for a new allocation. Needs to be called with the malloc lock held.
+	 *
+	 * @param	Tag		Tag of allocation
+	 * @param	Size	Size of allocation
+	 * @return	index of recorded sample or INDEX_NONE if the allocation wasn't sampled
+	 */
+	FORCEINLINE INT TrackAlloc( INT Tag, DWORD Size )
+	{
+		FMemoryTagStats& Stats = Tags[Tag];
+		Stats.LiveBytes += Size;
+		Stats.LiveAllocations++;
+		Stats.TotalAllocations++;
+		Stats.TotalBytes += Size;
+		if( Stats.LiveBytes > Stats.PeakBytes )
+		{
+			Stats.PeakBytes = Stats.LiveBytes;
+		}
+		if( SampleRate && ++SampleCounter >= SampleRate )
+		{
+			SampleCounter = 0;
+			return RecordSample( Tag, Size );
+		}
+		return INDEX_NONE;
+	}
+
+	/**
+	 * Accounts for an allocation being freed. Needs to be called with the malloc lock held.
+	 *
+	 * @param	Tag			Tag of allocation
+	 * @param	Size		Size of allocation
+	 * @param	SampleIndex	Index of sample recorded for the allocation, INDEX_NONE if none
+	 */
+	FORCEINLINE void TrackFree( INT Tag, DWORD Size, INT SampleIndex )
+	{
+		FMemoryTagStats& Stats = Tags[Tag];
+		Stats.LiveBytes -= Size;
+		Stats.LiveAllocations--;
+		if( SampleIndex != INDEX_NONE )
+		{
+			FreeSample( SampleIndex );
+		}
+	}
+
+	/**
+	 * Accounts for an allocation being resized. Needs to be called with the malloc lock held.
+	 *
+	 * @param	Tag			Tag of allocation
+	 * @param	OldSize		Previous size of allocation
+	 * @param	NewSize		New size of allocation
+	 * @param	SampleIndex	Index of sample recorded for the allocation, INDEX_NONE if none
+	 */
+	FORCEINLINE void TrackRealloc( INT Tag, DWORD OldSize, DWORD NewSize, INT SampleIndex )
+	{
+		FMemoryTagStats& Stats = Tags[Tag];
+		Stats.LiveBytes += (SQWORD) NewSize - (SQWORD) OldSize;
+		if( NewSize > OldSize )
+		{
+			Stats.TotalBytes += NewSize - OldSize;
+		}
+		if( Stats.LiveBytes > Stats.PeakBytes )
+		{
+			Stats.PeakBytes = Stats.LiveBytes;
+		}
+		if( SampleIndex != INDEX_NONE )
+		{
+			Samples[SampleIndex].Size = NewSize;
+		}
+	}
+
+	/**
+	 * Enables or disables callstack sampling. Samples of allocations that are still
+	 * live stay valid when the rate changes.
+	 *
+	 * @param	InSampleRate	Record the callstack of one in this many allocations, 0 to disable
+	 */
+	void SetSampleRate( DWORD InSampleRate );
+
+	/**
+	 * Updates per frame allocation rates. Called once per frame by the engine loop.
+	 */
+	void AdvanceFrame();
+
+	/**
+	 * Remembers the current live bytes and allocations of all tags for a later diff.
+	 */
+	void TakeSnapshot();
+
+	/**
+	 * Logs the tags with the most memory allocated.
+	 *
+	 * @param	Ar			Output device to log to
+	 * @param	Count		Maximum number of tags to log
+	 * @param	SortBy		"LIVE", "PEAK", "RATE" or "COUNT"
+	 */
+	void Report( FOutputDevice& Ar, INT Count, const TCHAR* SortBy );
+
+	/**
+	 * Logs the tags that changed the most since the last snapshot.
+	 *
+	 * @param	Ar			Output device to log to
+	 * @param	Count		Maximum number of tags to log
+	 */
+	void ReportDiff( FOutputDevice& Ar, INT Count );
+
+	/**
+	 * Logs the callstacks responsible for most of the sampled live memory.
+	 *
+	 * @param	Ar			Output device to log to
+	 * @param	Count		Maximum number of callstacks to log
+	 */
+	void ReportSamples( FOutputDevice& Ar, INT Count );
+
+	/**
+	 * Writes the current state of all tags, and their change since the last snapshot,
+	 * to a CSV file so captures from different points in time can be compared offline.
+	 *
+	 * @param	Filename	File to write to
+	 * @return	TRUE if successful, FALSE otherwise
+	 */
+	UBOOL WriteCSV( const TCHAR* Filename );
+
+private:
+	/**
+	 * Records the callstack of the current allocation.
+	 *
+	 * @param	Tag		Tag of allocation
+	 * @param	Size	Size of allocation
+	 * @return	index of sample or INDEX_NONE if the sample pool is exhausted
+	 */
+	INT RecordSample( INT Tag, DWORD Size );
+
+	/**
+	 * Returns a sample to the free list.
+	 *
+	 * @param	SampleIndex	Sample to free
+	 */
+	void FreeSample( INT SampleIndex );
+
+	/**
+	 * Names the builtin tags if that hasn't happened yet. Index 0 is also used for all
+	 * allocations made before the tracker was initialized.
+	 */
+	void AddBuiltinTags();
+
+	/**
+	 * Adds a tag without checking whether it already exists. Needs to be called with
+	 * the registration lock held.
+	 *
+	 * @param	Name	Name of tag
+	 * @return	index of tag, INDEX_NONE if the tag table is full
+	 */
+	INT AddTag( const TCHAR* Name );
+
+	/** Whether the thread local storage slot has been allocated */
+	UBOOL				bInitialized;
+	/** Thread local storage slot holding the current tag of each thread */
+	DWORD				TlsSlot;
+	/** Critical section protecting tag registration */
+	FCriticalSection*	RegistrationSynch;
+	/** Registered tags */
+	FMemoryTagStats		Tags[MAX_MEMORY_TAGS];
+	/** Number of registered tags */
+	INT					TagCount;
+	/** Open addressing hash of UClass pointers to tags */
+	UClass*				ClassHashKeys[MAX_MEMORY_TAGS * 2];
+	/** Tags of classes in ClassHashKeys */
+	INT					ClassHashTags[MAX_MEMORY_TAGS * 2];
+	/** Live bytes of all tags at the time of the last snapshot */
+	SQWORD				SnapshotBytes[MAX_MEMORY_TAGS];
+	/** Live allocations of all tags at the time of the last snapshot */
+	INT					SnapshotAllocations[MAX_MEMORY_TAGS];
+	/** Time of the last snapshot, 0 if none has been taken */
+	DOUBLE				SnapshotTime;
+	/** Record the callstack of one in this many allocations, 0 if sampling is disabled */
+	DWORD				SampleRate;
+	/** Number of allocations since the last sample was recorded */
+	DWORD				SampleCounter;
+	/** Pool of samples, allocated the first time sampling is enabled */
+	FMemoryTagSample*	Samples;
+	/** Head of free list of samples */
+	INT					FirstFreeSample;
+	/** Number of allocations that weren't sampled because the pool was exhausted */
+	DWORD				DroppedSamples;
+};
+
+/** Global memory tag tracker */
+extern FMemoryTagTracker GMemoryTagTracker;
+
+/*-----------------------------------------------------------------------------
+	FScopedMemoryTag.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Utility class setting the memory tag of the calling thread for its life time.
+ * Scopes nest, the previous tag is restored on destruction.
+ */
+struct FScopedMemoryTag
+{
+	/**
+	 * Constructor, setting the tag.
+	 *
+	 * @param	Tag		Tag to use for allocations made in this scope
+	 */
+	FORCEINLINE FScopedMemoryTag( INT Tag )
+	{
+		PreviousTag = GMemoryTagTracker.GetCurrentTag();
+		GMemoryTagTracker.SetCurrentTag( Tag );
+	}
+
+	/**
+	 * Destructor, restoring the previous tag.
+	 */
+	FORCEINLINE ~FScopedMemoryTag()
+	{
+		GMemoryTagTracker.SetCurrentTag( PreviousTag );
+	}
+
+private:
+	/** Tag that was active when the scope was entered */
+	INT	PreviousTag;
+};
+
+#if TRACK_MEMORY_TAGS
+	/** Tags all allocations made in the enclosing scope with one of the builtin tags, e.g. MEMORY_TAG_SCOPE(Net). */
+	#define MEMORY_TAG_SCOPE(Tag)			FScopedMemoryTag MemoryTagScope( MEMORY_TAG_##Tag );
+	/** Tags all allocations made in the enclosing scope with the tag of the passed in class. */
+	#define MEMORY_TAG_CLASS_SCOPE(Class)	FScopedMemoryTag MemoryTagScope( GMemoryTagTracker.GetClassTag( Class ) );
+#else
+	#define MEMORY_TAG_SCOPE(Tag)
+	#define MEMORY_TAG_CLASS_SCOPE(Class)
+#endif
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -52,6 +52,7 @@ enum EPackageFlags
 	PKG_ServerSideOnly  = 0x0004,   // Only needed on the server side.
 	PKG_Cooked			= 0x0008,	// Whether this package has been cooked for the target platform.
 	PKG_Unsecure        = 0x0010,   // Not trusted.
+	PKG_StoreCompressed	= 0x0020,	// Stored in compressed chunks, see appCompressPackage.
 	PKG_Need			= 0x8000,	// Client needs to download this package.
 };
 
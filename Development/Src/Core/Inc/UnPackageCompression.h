@@ -0,0 +1,175 @@
+/*=============================================================================
+	UnPackageCompression.h: Packages stored in independently compressed chunks.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/*-----------------------------------------------------------------------------
+	Definitions.
+-----------------------------------------------------------------------------*/
+
+/** Default size of the uncompressed chunks appCompressPackage splits a package into */
+#define PACKAGE_CHUNK_SIZE			131072
+/** Number of decompressed chunks FArchiveCompressedPackageReader keeps in memory */
+#define PACKAGE_CHUNK_SLOTS			4
+/** Number of chunks following the one being read that are decompressed ahead of use */
+#define PACKAGE_CHUNK_PREFETCH		2
+
+/**
+ * Location of a chunk of a package stored with PKG_StoreCompressed. The chunks cover the
+ * whole uncompressed package in order, so all offsets stored inside the package, like the
+ * ones of the name, import and export tables, refer to the uncompressed data.
+ */
+struct FCompressedChunk
+{
+	/** Offset of the chunk in the uncompressed package */
+	INT		UncompressedOffset;
+	/** Size of the chunk once decompressed */
+	INT		UncompressedSize;
+	/** Offset of the zlib compressed chunk in the file */
+	INT		CompressedOffset;
+	/** Size of the zlib compressed chunk in the file */
+	INT		CompressedSize;
+
+	friend FArchive& operator<<( FArchive& Ar, FCompressedChunk& Chunk )
+	{
+		return Ar << Chunk.UncompressedOffset << Chunk.UncompressedSize << Chunk.CompressedOffset << Chunk.CompressedSize;
+	}
+};
+
+/*-----------------------------------------------------------------------------
+	FArchiveCompressedPackageReader.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Reads the uncompressed data of a package stored with PKG_StoreCompressed, used by
+ * ULinkerLoad in place of the plain file reader.
+ *
+ * Only the chunks that are actually read from get decompressed. Whenever reading moves
+ * on to another chunk, the compressed data of the chunks following it is read and handed
+ * to GThreadPool to be decompressed while the current chunk is being consumed. Precache
+ * does the same for all chunks of the range it is passed, so the chunks of large exports
+ * are decompressed in parallel. Without a thread pool chunks are decompressed on demand.
+ */
+class FArchiveCompressedPackageReader : public FArchive
+{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param	InReader	Reader of the compressed file, owned by this archive from now on
+	 * @param	InChunks	Chunk table of the package summary
+	 * @param	InError		Device errors are logged to
+	 */
+	FArchiveCompressedPackageReader( FArchive* InReader, const TArray<FCompressedChunk>& InChunks, FOutputDevice* InError );
+
+	/**
+	 * Destructor, waiting for outstanding decompression and deleting the file reader.
+	 */
+	virtual ~FArchiveCompressedPackageReader();
+
+	// FArchive interface.
+	virtual void Serialize( void* V, INT Length );
+	virtual void Seek( INT InPos );
+	virtual INT Tell();
+	virtual INT TotalSize();
+	virtual void Precache( INT HintCount );
+	virtual UBOOL Close();
+
+private:
+	friend class FChunkDecompressWork;
+
+	/** Buffers of a chunk that is decompressed or being decompressed */
+	struct FChunkSlot
+	{
+		/** Chunk held, or INDEX_NONE if the slot is unused */
+		INT				ChunkIndex;
+		/** Value of UseCount when the chunk was last requested, used for eviction */
+		DWORD			LastUse;
+		/** Whether the chunk is being decompressed by the thread pool */
+		UBOOL			bPending;
+		/** Whether decompression failed, written by the worker decompressing the chunk */
+		UBOOL			bFailed;
+		/** Size of the compressed data */
+		INT				CompressedSize;
+		/** Size of the decompressed data */
+		INT				UncompressedSize;
+		/** Compressed data read from the file, grown to the largest chunk held */
+		TArray<BYTE>	CompressedData;
+		/** Decompressed data, grown to the largest chunk held */
+		TArray<BYTE>	UncompressedData;
+		/** Triggered once the thread pool is done with the slot, NULL without thread pool */
+		FEvent*			DoneEvent;
+
+		/**
+		 * Decompresses CompressedData into UncompressedData.
+		 *
+		 * @return	TRUE if successful
+		 */
+		UBOOL Decompress();
+	};
+
+	/**
+	 * Returns the index of the chunk holding an uncompressed offset, or INDEX_NONE.
+	 */
+	INT FindChunk( INT Offset ) const;
+
+	/**
+	 * Makes sure a chunk is held by a slot, reading it and starting decompression if it
+	 * isn't. Evicts the least recently requested slot other than the current chunk's.
+	 *
+	 * @return	slot holding the chunk, or NULL if reading the compressed data failed
+	 */
+	FChunkSlot* RequestChunk( INT ChunkIndex );
+
+	/**
+	 * Waits for the decompression of a slot to finish.
+	 */
+	void WaitForSlot( FChunkSlot& Slot );
+
+	/**
+	 * Makes a chunk the one being read from, prefetching the chunks following it.
+	 *
+	 * @return	FALSE if the chunk couldn't be read or decompressed
+	 */
+	UBOOL SetCurrentChunk( INT ChunkIndex );
+
+	/** Reader of the compressed file */
+	FArchive*					Reader;
+	/** Chunk table */
+	TArray<FCompressedChunk>	Chunks;
+	/** Device errors are logged to */
+	FOutputDevice*				Error;
+	/** Current uncompressed position */
+	INT							Pos;
+	/** Size of the uncompressed package */
+	INT							Size;
+	/** Chunk being read from, or INDEX_NONE */
+	INT							CurrentChunk;
+	/** Decompressed slot of CurrentChunk */
+	FChunkSlot*					CurrentSlot;
+	/** Number of chunk requests made, used to find the least recently requested slot */
+	DWORD						UseCount;
+	/** Decompressed chunks */
+	FChunkSlot					Slots[PACKAGE_CHUNK_SLOTS];
+};
+
+/*-----------------------------------------------------------------------------
+	Package compression.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Stores a package split into independently zlib compressed chunks, along with a chunk
+ * table in its summary, so ULinkerLoad can seek in it without decompressing the whole
+ * file. Chunks are compressed in parallel.
+ *
+ * @param	SrcFilename		Package to compress
+ * @param	DestFilename	File the compressed package is written to, must differ from SrcFilename
+ * @param	ChunkSize		Size of the uncompressed chunks
+ * @return	TRUE if successful, FALSE if the source isn't an uncompressed package or IO failed
+ */
+UBOOL appCompressPackage( const TCHAR* SrcFilename, const TCHAR* DestFilename, INT ChunkSize=PACKAGE_CHUNK_SIZE );
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
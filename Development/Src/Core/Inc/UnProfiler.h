@@ -0,0 +1,245 @@
+/*=============================================================================
+	UnProfiler.h: Hierarchical, thread aware frame profiler.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/*-----------------------------------------------------------------------------
+	Trace events.
+-----------------------------------------------------------------------------*/
+
+/** Default number of events per thread ring buffer, needs to be a power of two */
+#define TRACE_DEFAULT_BUFFER_SIZE	(64 * 1024)
+
+/**
+ * A single completed, timed scope. Events are recorded when the scope ends so
+ * a parent is always recorded after all of its children.
+ */
+struct FTraceEvent
+{
+	/** Label of scope, needs to persist for the life time of the capture (literal or global) */
+	const TCHAR*	Label;
+	/** appCycles64 when scope was entered */
+	QWORD			StartCycles;
+	/** appCycles64 when scope was left */
+	QWORD			EndCycles;
+	/** Nesting depth of scope on its thread, 0 being the outermost */
+	DWORD			Depth;
+};
+
+/**
+ * Per thread ring buffer of trace events. There is a single producer (the owning
+ * thread) and a single consumer (the thread draining the buffer at the end of the
+ * frame) so no locking is required to record an event. Buffers are never freed
+ * while the engine is running so scopes straddling a capture stop are safe.
+ */
+struct FTraceThreadBuffer
+{
+	/** Id of owning thread */
+	DWORD					ThreadId;
+	/** Ring buffer of events, Capacity entries */
+	FTraceEvent*			Events;
+	/** Number of entries in Events, power of two */
+	DWORD					Capacity;
+	/** Total number of events written, only ever modified by the owning thread */
+	volatile DWORD			WriteCount;
+	/** Total number of events consumed, only ever modified by the draining thread */
+	DWORD					ReadCount;
+	/** Number of events that were overwritten before they could be drained */
+	DWORD					DroppedCount;
+	/** Current scope nesting depth of owning thread */
+	DWORD					Depth;
+	/** Next buffer in global list */
+	FTraceThreadBuffer*		Next;
+
+	/**
+	 * Records a completed scope. Only to be called by the owning thread.
+	 */
+	FORCEINLINE void AddEvent( const TCHAR* Label, QWORD StartCycles, QWORD EndCycles, DWORD InDepth )
+	{
+		FTraceEvent& Event	= Events[WriteCount & (Capacity - 1)];
+		Event.Label			= Label;
+		Event.StartCycles	= StartCycles;
+		Event.EndCycles		= EndCycles;
+		Event.Depth			= InDepth;
+		// Publish the event only once it has been fully written, volatile alone doesn't keep the CPU from reordering the stores.
+		appMemoryBarrier();
+		WriteCount			= WriteCount + 1;
+	}
+};
+
+/*-----------------------------------------------------------------------------
+	FTraceManager.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Owns the per thread event buffers and streams captured events to disk in the
+ * Chrome trace event format (chrome://tracing, Perfetto, ...).
+ */
+class FTraceManager
+{
+public:
+	/** Constructor, initializing all members. */
+	FTraceManager();
+
+	/**
+	 * Starts a new capture, stopping the current one if needed.
+	 *
+	 * @param	Filename		File to stream the capture to
+	 * @param	InBufferSize	Number of events per thread ring buffer, rounded up to a power of two
+	 * @param	InMaxFrames		Number of frames after which the capture stops itself, 0 for no limit
+	 * @return	TRUE if capture was started, FALSE if the output file couldn't be created
+	 */
+	UBOOL StartCapture( const TCHAR* Filename, DWORD InBufferSize = TRACE_DEFAULT_BUFFER_SIZE, DWORD InMaxFrames = 0 );
+
+	/**
+	 * Stops the current capture, if any, drains all buffers and finalizes the output file.
+	 */
+	void StopCapture();
+
+	/**
+	 * Drains all thread buffers to the capture file. Needs to be called once per frame
+	 * by the thread that started the capture.
+	 */
+	void AdvanceFrame();
+
+	/**
+	 * Logs the status of the current capture.
+	 *
+	 * @param	Ar	Output device to log to
+	 */
+	void DumpStatus( FOutputDevice& Ar );
+
+	/**
+	 * @return TRUE if a capture is in progress, FALSE otherwise
+	 */
+	FORCEINLINE UBOOL IsCapturing() const
+	{
+		return bIsCapturing;
+	}
+
+	/**
+	 * Returns the event buffer of the calling thread, creating it if necessary.
+	 * Only valid to call while capturing.
+	 */
+	FORCEINLINE FTraceThreadBuffer* GetThreadBuffer()
+	{
+		FTraceThreadBuffer* Buffer = (FTraceThreadBuffer*) appGetTlsValue( TlsSlot );
+		if( !Buffer )
+		{
+			Buffer = CreateThreadBuffer();
+		}
+		return Buffer;
+	}
+
+private:
+	/** Creates and registers the event buffer of the calling thread. */
+	FTraceThreadBuffer* CreateThreadBuffer();
+
+	/**
+	 * Writes all pending events of the passed in buffer to the capture file.
+	 *
+	 * @param	Buffer	Buffer to drain
+	 */
+	void DrainBuffer( FTraceThreadBuffer* Buffer );
+
+	/**
+	 * Writes the passed in string to the capture file, converting to ANSI.
+	 *
+	 * @param	String	String to write
+	 */
+	void WriteString( const TCHAR* String );
+
+	/** Whether a capture is in progress, checked by every trace scope */
+	volatile UBOOL			bIsCapturing;
+	/** Thread local storage slot holding the per thread event buffer */
+	DWORD					TlsSlot;
+	/** Head of list of all thread buffers */
+	FTraceThreadBuffer*		FirstBuffer;
+	/** Critical section protecting buffer list */
+	FCriticalSection*		BufferListSynch;
+	/** Archive the capture is streamed to */
+	FArchive*				CaptureArchive;
+	/** Name of capture file */
+	TCHAR					CaptureFilename[1024];
+	/** Cycles at which the capture started, all time stamps are relative to it */
+	QWORD					CaptureStartCycles;
+	/** Thread that started capture, drains buffers and is labeled as game thread */
+	DWORD					CaptureThreadId;
+	/** Number of events per thread buffer */
+	DWORD					BufferSize;
+	/** Number of frames captured so far */
+	DWORD					FrameCount;
+	/** Number of frames after which the capture stops itself, 0 for no limit */
+	DWORD					MaxFrames;
+	/** Number of events written */
+	DWORD					EventCount;
+	/** Whether at least one event has been written, used for JSON separators */
+	UBOOL					bWroteEvent;
+};
+
+/** Global trace manager */
+extern FTraceManager GTraceManager;
+
+/*-----------------------------------------------------------------------------
+	FScopedTraceEvent.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Utility class recording the time between its creation and destruction as a trace
+ * event. Scopes nest naturally and cost a single branch when no capture is running.
+ */
+struct FScopedTraceEvent
+{
+	/**
+	 * Constructor, beginning the scope.
+	 *
+	 * @param	InLabel		Label of scope, needs to persist for the life time of the capture
+	 */
+	FORCEINLINE FScopedTraceEvent( const TCHAR* InLabel )
+	{
+		if( GTraceManager.IsCapturing() )
+		{
+			Buffer		= GTraceManager.GetThreadBuffer();
+			Label		= InLabel;
+			Depth		= Buffer->Depth++;
+			StartCycles	= appCycles64();
+		}
+		else
+		{
+			Buffer		= NULL;
+		}
+	}
+
+	/**
+	 * Destructor, ending the scope and recording the event.
+	 */
+	FORCEINLINE ~FScopedTraceEvent()
+	{
+		if( Buffer )
+		{
+			Buffer->AddEvent( Label, StartCycles, appCycles64(), Depth );
+			Buffer->Depth = Depth;
+		}
+	}
+
+private:
+	/** Buffer of the thread this scope lives on, NULL if not capturing */
+	FTraceThreadBuffer*	Buffer;
+	/** Label of scope */
+	const TCHAR*		Label;
+	/** Cycles at scope entry */
+	QWORD				StartCycles;
+	/** Nesting depth at scope entry */
+	DWORD				Depth;
+};
+
+#if DO_TRACE
+	#define TRACE_SCOPE(Label)	FScopedTraceEvent TraceScope( Label );
+#else
+	#define TRACE_SCOPE(Label)
+#endif
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -290,101 +290,171 @@ struct FIteratorList
 -----------------------------------------------------------------------------*/
 
 /**
- * Non- intrusive script call graph profiler, collecting function pointer and cycle count
- * per function for later analysis in a standalone tool.
+ * Aggregated statistics for a single script function, indexed by a stable function id
+ * that is assigned the first time the function is called while profiling.
+ */
+struct FScriptCallGraphFunction
+{
+	/** Path name of function, captured when it was first seen and used as its key */
+	FString		PathName;
+	/** Number of calls */
+	DWORD		Calls;
+	/** Cycles spent in function including callees, recursive calls are only counted once */
+	QWORD		InclusiveCycles;
+	/** Cycles spent in function excluding callees */
+	QWORD		ExclusiveCycles;
+	/** Number of active calls on the script stack, used to handle recursion */
+	DWORD		ActiveCount;
+};
+
+/**
+ * A node in the aggregated call tree, representing a unique call path.
+ */
+struct FScriptCallGraphNode
+{
+	/** Id of function this node represents, INDEX_NONE for the root node */
+	INT			FunctionId;
+	/** Index of parent node, INDEX_NONE for the root node */
+	INT			ParentIndex;
+	/** Index of first child node or INDEX_NONE */
+	INT			FirstChildIndex;
+	/** Index of next sibling node or INDEX_NONE */
+	INT			NextSiblingIndex;
+	/** Number of calls along this path */
+	DWORD		Calls;
+	/** Cycles spent in this path including callees */
+	QWORD		InclusiveCycles;
+	/** Cycles spent in this path excluding callees */
+	QWORD		ExclusiveCycles;
+};
+
+/**
+ * Script call graph profiler, aggregating call counts and inclusive/ exclusive cycles per
+ * function and per call path on the fly. Memory use is bounded by the maximum number of call
+ * tree nodes so it can be left running over long sessions; once the tree is full new call paths
+ * are only accounted for in the per function statistics.
  */
 struct FScriptCallGraph
 {
 	/**
 	 * Constructor
 	 *
-	 * @param InSoftMemoryLimit		Max number of bytes used by call graph data (soft limit).
+	 * @param InSoftMemoryLimit		Max number of bytes used by the call tree.
 	 */
 	FScriptCallGraph( DWORD InSoftMemoryLimit );
 
 	/**
 	 * Resets data collection and memory use.
 	 *
-	 * @param InSoftMemoryLimit		Max number of bytes used by call graph data (soft limit).
+	 * @param InSoftMemoryLimit		Max number of bytes used by the call tree, 0 to keep the current limit.
 	 */
 	void Reset( DWORD InSoftMemoryLimit = 0 );
-	
+
+	/**
+	 * Notifies the profiler that a function is about to be called.
+	 *
+	 * @param Function	Function about to be called
+	 */
+	void BeginFunction( UFunction* Function );
+
 	/**
-	 * Serializes the profiling data to the passed in archive.	
+	 * Notifies the profiler that the most recently begun function has returned.
 	 *
-	 * @param Ar	Archive to serialize data to.
+	 * @param Cycles	Cycles spent in function call
 	 */
-	void Serialize( FArchive& Ar );
-	
+	void EndFunction( DWORD Cycles );
+
 	/**
-	 * Emits the end of frame marker. Needs to be called when there are no script functions
-	 * on the stack. Also responsible for reseting call graph data if memory limit is reached.
+	 * Marks the end of a frame. Needs to be called when there are no script functions on the stack.
 	 */
 	void Tick();
 
 	/**
-	 * Emits function call token to stream.	
-	 *
-	 * @param Function	Function pointer to emit.
+	 * Flushes the function lookup cache, called before garbage is purged as a new function
+	 * might be allocated at the address of a destroyed one.
 	 */
-	inline void EmitFunction( UFunction* Function )
+	void NotifyGC()
 	{
-		Data.AddItem( (DWORD) Function );
+		FunctionToIdMap.Empty();
 	}
 
 	/**
-	 * Emits cycle count token.
+	 * Logs the top functions to the passed in output device.
 	 *
-	 * @param Cycles	Cycle count to emit.
+	 * @param Ar				Output device to log to
+	 * @param Count				Number of functions to log
+	 * @param bSortByInclusive	Whether to sort by inclusive instead of exclusive time
 	 */
-	inline void EmitCycles( DWORD Cycles )
-	{
-		DWORD Value = (Cycles & ~3) | 1;
-		Data.AddItem( Value );
-	}
+	void Report( FOutputDevice& Ar, INT Count, UBOOL bSortByInclusive );
 
 	/**
-	 * Emits frame end marker.	
+	 * Writes the function table and the call tree as two CSV files, <BaseFilename>-Functions.csv
+	 * and <BaseFilename>-CallTree.csv. Function ids are shared between both files.
+	 *
+	 * @param BaseFilename		Filename without extension to derive output filenames from
+	 * @return TRUE if both files were written, FALSE otherwise
 	 */
-	inline void EmitFrameEnd()
-	{
-		DWORD Value = 3;
-		Data.AddItem( Value );
-	}
+	UBOOL WriteCSV( const FString& BaseFilename );
 
 	/**
-	 * Emits end of stream marker.	
+	 * Returns the number of this call graph, unique across all call graphs created. Calls
+	 * in flight compare it rather than the pointer, which may be reused once profiling is
+	 * stopped and started again.
 	 */
-	inline void EmitEnd()
+	DWORD GetGeneration() const
 	{
-		DWORD Value = 0;
-		Data.AddItem( Value );
+		return Generation;
 	}
 
+private:
 	/**
-	 * Figures out whether the passed in value is a frame end marker.
+	 * Returns the stable id for the passed in function, assigning a new one if needed.
 	 *
-	 * return TRUE if the passed in value is a frame end marker, FALSE otherwise
+	 * @param Function	Function to look up
+	 * @return id of function
 	 */
-	inline UBOOL IsFrameEndMarker( DWORD Value )
-	{
-		return Value == 3;
-	}
+	INT GetFunctionId( UFunction* Function );
 
 	/**
-	 * Figures out whether the passed in value is the end marker.
-	 * 
-	 * return TRUE if the passed in value is the end marker, FALSE otherwise
+	 * Finds or adds the child node of ParentIndex for the passed in function.
+	 *
+	 * @param ParentIndex	Index of parent node, INDEX_NONE if the parent isn't tracked
+	 * @param FunctionId	Id of called function
+	 * @return index of child node or INDEX_NONE if the call tree is full
 	 */
-	inline UBOOL IsEndMarker( DWORD Value )
+	INT FindOrAddChild( INT ParentIndex, INT FunctionId );
+
+	/** Entry of shadow call stack */
+	struct FStackEntry
 	{
-		return Value == 0;
-	}
+		/** Call tree node of this call, INDEX_NONE if call tree was full */
+		INT		NodeIndex;
+		/** Id of called function */
+		INT		FunctionId;
+		/** Inclusive cycles of calls made by this call */
+		DWORD	ChildCycles;
+	};
 
-	/** Array of call graph profiling tokens */
-	TArray<DWORD>		Data;
-	/** Soft memory limit call graph profiling data is allowed to reach before it resets itself */
-	DWORD				SoftMemoryLimit;
+	/** Per function statistics, indexed by function id */
+	TArray<FScriptCallGraphFunction>	Functions;
+	/** Map from function path name to function id, ids stay the same across garbage collection */
+	TMap<FString,INT>					PathNameToIdMap;
+	/** Cache of function ids by function, flushed by NotifyGC */
+	TMap<UFunction*,INT>				FunctionToIdMap;
+	/** Call tree, node 0 being the root */
+	TArray<FScriptCallGraphNode>		Nodes;
+	/** Shadow of the script call stack */
+	TArray<FStackEntry>					Stack;
+	/** Max number of call tree nodes */
+	INT									MaxNodes;
+	/** Number of calls that couldn't be added to the call tree as it was full */
+	DWORD								UntrackedCalls;
+	/** Number of frames profiled */
+	DWORD								FrameCount;
+	/** Soft memory limit used to derive max number of nodes from */
+	DWORD								SoftMemoryLimit;
+	/** Unique number of this call graph, see GetGeneration */
+	DWORD								Generation;
 };
 /** Global script call graph profiler */
 extern FScriptCallGraph* GScriptCallGraph;
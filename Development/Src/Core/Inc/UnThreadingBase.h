@@ -582,6 +582,81 @@ public:
 	virtual void ReturnToPool(FQueuedThread* InQueuedThread) = 0;
 };
 
+/*
+ *  Global pool of worker threads for short lived jobs. NULL if the platform
+ *  doesn't provide one, in which case callers do the work themselves.
+ */
+extern FQueuedThreadPool* GThreadPool;
+
+/**
+ * Interface of the body of a parallel loop, see appParallelFor.
+ */
+class FParallelForBody
+{
+public:
+	/**
+	 * Virtual destructor so that child implementations are guaranteed a chance
+	 * to clean up any resources they allocated.
+	 */
+	virtual ~FParallelForBody(void) {}
+
+	/**
+	 * Processes a single index. Called concurrently from several threads so
+	 * implementations may only touch state owned by that index.
+	 *
+	 * @param Index The index to process
+	 */
+	virtual void Execute(INT Index) = 0;
+};
+
+/**
+ * Calls Body.Execute for every index in [0,Num) and returns once all of them
+ * have been processed. The calling thread works on the loop alongside the
+ * threads of GThreadPool. Runs serially if there is no thread pool or another
+ * parallel loop is already running, which also makes nesting safe.
+ *
+ * @param Num The number of indices to process
+ * @param Body The loop body
+ */
+extern void appParallelFor(INT Num,FParallelForBody& Body);
+
+/**
+ * Buffers everything logged while it is in scope, so parallel loop bodies can
+ * log even though GLog isn't thread safe. The messages are forwarded to the log
+ * it replaced, in the order they were logged, once it goes out of scope.
+ */
+class FParallelForLog : public FOutputDeviceRedirectorBase
+{
+public:
+	/**
+	 * Replaces GLog by this device.
+	 */
+	FParallelForLog(void);
+
+	/**
+	 * Restores GLog and forwards the buffered messages to it.
+	 */
+	~FParallelForLog(void);
+
+	// FOutputDevice interface.
+	virtual void Serialize(const TCHAR* V,EName Event);
+
+	// FOutputDeviceRedirectorBase interface.
+	virtual void AddOutputDevice(FOutputDevice* OutputDevice);
+	virtual void RemoveOutputDevice(FOutputDevice* OutputDevice);
+	virtual UBOOL IsRedirectingTo(FOutputDevice* OutputDevice);
+
+private:
+	/** The log replaced by this device */
+	FOutputDeviceRedirectorBase*	Log;
+	/** Protects Lines and Events */
+	FCriticalSection*				Synch;
+	/** The buffered messages */
+	TArray<FString>					Lines;
+	/** The event of each buffered message */
+	TArray<EName>					Events;
+};
+
 /**
  * A base implementation of a queued thread pool. It provides the common
  * methods & members needed to implement a pool.
@@ -663,7 +738,7 @@ public:
 			if (QueuedThreads.Num() > 0)
 			{
 				// Figure out which thread is available
-				INT Index = QueuedThreads.Num();
+				INT Index = QueuedThreads.Num() - 1;
 				// Grab that thread to use
 				Thread = QueuedThreads(Index);
 				// Remove it from the list so no one else grabs it
@@ -406,6 +406,67 @@ inline DOUBLE appSeconds()
 #pragma warning (pop)
 #endif
 
+//
+// 64 bit CPU cycles, related to GSecondsPerCycle. Unlike appCycles this doesn't wrap
+// so it can be used to timestamp events across long captures.
+//
+#define DEFINED_appCycles64 1
+inline QWORD appCycles64()
+{
+	LARGE_INTEGER	Cycles;
+	::QueryPerformanceCounter( &Cycles );
+	return Cycles.QuadPart;
+}
+
+//
+// Thread identification and thread local storage.
+//
+#define DEFINED_appThreadLocalStorage 1
+inline DWORD appGetCurrentThreadId()
+{
+	return ::GetCurrentThreadId();
+}
+inline DWORD appAllocTlsSlot()
+{
+	return ::TlsAlloc();
+}
+inline void appSetTlsValue( DWORD SlotIndex, void* Value )
+{
+	::TlsSetValue( SlotIndex, Value );
+}
+inline void* appGetTlsValue( DWORD SlotIndex )
+{
+	return ::TlsGetValue( SlotIndex );
+}
+inline void appFreeTlsSlot( DWORD SlotIndex )
+{
+	::TlsFree( SlotIndex );
+}
+
+//
+// Full memory barrier, neither the compiler nor the CPU move reads or writes across it.
+//
+#define DEFINED_appMemoryBarrier 1
+inline void appMemoryBarrier()
+{
+	::MemoryBarrier();
+}
+
+//
+// Cheap callstack capture, walking frame pointers. Returns number of frames captured.
+//
+#define DEFINED_appCaptureStackBackTrace 1
+inline DWORD appCaptureStackBackTrace( QWORD* BackTrace, DWORD MaxDepth, DWORD FramesToSkip )
+{
+	void*	Frames[64];
+	DWORD	Depth = ::RtlCaptureStackBackTrace( FramesToSkip + 1, MaxDepth < 64 ? MaxDepth : 64, Frames, NULL );
+	for( DWORD FrameIndex=0; FrameIndex<Depth; FrameIndex++ )
+	{
+		BackTrace[FrameIndex] = (PTRINT) Frames[FrameIndex];
+	}
+	return Depth;
+}
+
 //
 // Memory copy.
 //
@@ -103,6 +103,7 @@ static FOutputDeviceRedirector LogRedirector;
 -----------------------------------------------------------------------------*/
 
 FMemStack				GMem;							/* Global memory stack */
+FFrameArena				GFrameArena;					/* Global arena for per frame temporaries */
 FOutputDeviceRedirectorBase* GLog						= &LogRedirector;			/* Regular logging */
 FOutputDeviceError*		GError							= NULL;						/* Critical errors */
 FOutputDevice*			GNull							= &NullOut;					/* Log to nowhere */
@@ -130,6 +131,8 @@ TCHAR					GNone[64]						= TEXT("None");				/* Localized "none" text */
 DOUBLE					GSecondsPerCycle				= 1.0;						/* Seconds per CPU cycle for this PC */
 INT						GScriptCycles					= 0;						/* Times script execution CPU cycles per tick */
 DWORD					GPageSize						= 4096;						/* Operating system page size */
+DWORD					GNumHardwareThreads				= 1;						/* Number of hardware threads (logical processors) */
+DWORD					GGameThreadId					= 0;						/* Id of the thread that called appInit */
 DWORD					GUglyHackFlags					= 0;						/* Flags for passing around globally hacked stuff */
 UBOOL					GIsEditor						= 0;						/* Whether engine was launched for editing */
 UBOOL					GIsUCC							= 0;						/* Is UCC running? */
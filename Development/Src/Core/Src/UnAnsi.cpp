@@ -12,6 +12,9 @@
 #include <time.h>
 #include <stdio.h>
 #include <stdarg.h>
+#if __UNIX__
+#include <pthread.h>
+#endif
 
 /*-----------------------------------------------------------------------------
 	Time.
@@ -48,6 +51,54 @@ const TCHAR* appTimestamp()
 }
 #endif
 
+//
+// 64 bit cycles on platforms without a native counter, derived from appSeconds.
+//
+#if !DEFINED_appCycles64
+QWORD appCycles64()
+{
+	return (QWORD)(appSeconds() / GSecondsPerCycle);
+}
+#endif
+
+/*-----------------------------------------------------------------------------
+	Threads.
+-----------------------------------------------------------------------------*/
+
+#if !DEFINED_appThreadLocalStorage && __UNIX__
+DWORD appGetCurrentThreadId()
+{
+	return (DWORD)(PTRINT) pthread_self();
+}
+DWORD appAllocTlsSlot()
+{
+	pthread_key_t Key;
+	if( pthread_key_create( &Key, NULL ) != 0 )
+	{
+		return (DWORD) INDEX_NONE;
+	}
+	return (DWORD) Key;
+}
+void appSetTlsValue( DWORD SlotIndex, void* Value )
+{
+	pthread_setspecific( (pthread_key_t) SlotIndex, Value );
+}
+void* appGetTlsValue( DWORD SlotIndex )
+{
+	return pthread_getspecific( (pthread_key_t) SlotIndex );
+}
+void appFreeTlsSlot( DWORD SlotIndex )
+{
+	pthread_key_delete( (pthread_key_t) SlotIndex );
+}
+#endif
+
+#if !DEFINED_appMemoryBarrier && __GNUG__
+void appMemoryBarrier()
+{
+	__sync_synchronize();
+}
+#endif
 
 /*-----------------------------------------------------------------------------
 	Memory functions.
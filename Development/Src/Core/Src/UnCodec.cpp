@@ -0,0 +1,417 @@
+/*=============================================================================
+	UnCodec.cpp: Data compression codecs.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "CorePrivate.h"
+#include "FCodec.h"
+
+/*-----------------------------------------------------------------------------
+	Suffix sorting.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Computes the start or end of the bucket of each character in a suffix array.
+ */
+static void GetBuckets( const INT* Text, INT Num, INT NumChars, INT* Buckets, UBOOL bEnd )
+{
+	appMemzero( Buckets, NumChars * sizeof(INT) );
+	for( INT Index=0; Index<Num; Index++ )
+	{
+		Buckets[Text[Index]]++;
+	}
+	INT Sum = 0;
+	for( INT Char=0; Char<NumChars; Char++ )
+	{
+		Sum += Buckets[Char];
+		Buckets[Char] = bEnd ? Sum : Sum - Buckets[Char];
+	}
+}
+
+/**
+ * Returns whether a suffix is a leftmost S-type suffix, that is smaller than the suffix
+ * following it and larger than the one preceding it.
+ */
+static FORCEINLINE UBOOL IsLMS( const BYTE* Types, INT Index )
+{
+	return Index > 0 && Types[Index] && !Types[Index-1];
+}
+
+/**
+ * Places the L-type suffixes from the already placed suffixes, scanning left to right.
+ */
+static void InduceL( const INT* Text, const BYTE* Types, INT* SA, INT Num, INT NumChars, INT* Buckets )
+{
+	GetBuckets( Text, Num, NumChars, Buckets, 0 );
+	for( INT Index=0; Index<Num; Index++ )
+	{
+		const INT Prev = SA[Index] - 1;
+		if( Prev >= 0 && !Types[Prev] )
+		{
+			SA[Buckets[Text[Prev]]++] = Prev;
+		}
+	}
+}
+
+/**
+ * Places the S-type suffixes from the already placed suffixes, scanning right to left.
+ */
+static void InduceS( const INT* Text, const BYTE* Types, INT* SA, INT Num, INT NumChars, INT* Buckets )
+{
+	GetBuckets( Text, Num, NumChars, Buckets, 1 );
+	for( INT Index=Num-1; Index>=0; Index-- )
+	{
+		const INT Prev = SA[Index] - 1;
+		if( Prev >= 0 && Types[Prev] )
+		{
+			SA[--Buckets[Text[Prev]]] = Prev;
+		}
+	}
+}
+
+/**
+ * Builds the suffix array of a text by induced sorting (SA-IS), in time linear in its
+ * length. Sorts the LMS substrings, names them, recursively sorts the text of names if
+ * the names aren't unique yet, and induces the order of all suffixes from the LMS ones.
+ *
+ * @param	Text		Characters in [0,NumChars), the last of which has to be unique and smallest
+ * @param	SA			[out] start of every suffix, in ascending order
+ * @param	Num			Length of the text
+ * @param	NumChars	Size of the alphabet
+ */
+static void BuildSuffixArray( const INT* Text, INT* SA, INT Num, INT NumChars )
+{
+	if( Num == 1 )
+	{
+		SA[0] = 0;
+		return;
+	}
+
+	// Classify the suffixes into S-type (1) and L-type (0).
+	TArray<BYTE> TypeArray( Num );
+	BYTE* Types = &TypeArray(0);
+	Types[Num-1] = 1;
+	Types[Num-2] = 0;
+	for( INT Index=Num-3; Index>=0; Index-- )
+	{
+		Types[Index] = Text[Index] < Text[Index+1] || (Text[Index] == Text[Index+1] && Types[Index+1]);
+	}
+
+	// Sort the LMS substrings.
+	TArray<INT> BucketArray( NumChars );
+	INT* Buckets = &BucketArray(0);
+	GetBuckets( Text, Num, NumChars, Buckets, 1 );
+	for( INT Index=0; Index<Num; Index++ )
+	{
+		SA[Index] = INDEX_NONE;
+	}
+	for( INT Index=1; Index<Num; Index++ )
+	{
+		if( IsLMS(Types, Index) )
+		{
+			SA[--Buckets[Text[Index]]] = Index;
+		}
+	}
+	InduceL( Text, Types, SA, Num, NumChars, Buckets );
+	InduceS( Text, Types, SA, Num, NumChars, Buckets );
+
+	// Gather the sorted LMS substrings, at most half of the text, at the start of SA.
+	INT NumLMS = 0;
+	for( INT Index=0; Index<Num; Index++ )
+	{
+		if( IsLMS(Types, SA[Index]) )
+		{
+			SA[NumLMS++] = SA[Index];
+		}
+	}
+
+	// Name the LMS substrings, equal substrings getting the same name. No two LMS suffixes
+	// are adjacent, so the name of the one at Pos is stored at NumLMS + Pos/2.
+	for( INT Index=NumLMS; Index<Num; Index++ )
+	{
+		SA[Index] = INDEX_NONE;
+	}
+	INT NumNames = 0;
+	INT PrevPos = INDEX_NONE;
+	for( INT Index=0; Index<NumLMS; Index++ )
+	{
+		const INT Pos = SA[Index];
+		UBOOL bDifferent = 0;
+		for( INT Offset=0; Offset<Num; Offset++ )
+		{
+			if( PrevPos == INDEX_NONE || Text[Pos+Offset] != Text[PrevPos+Offset] || Types[Pos+Offset] != Types[PrevPos+Offset] )
+			{
+				bDifferent = 1;
+				break;
+			}
+			else if( Offset > 0 && (IsLMS(Types, Pos+Offset) || IsLMS(Types, PrevPos+Offset)) )
+			{
+				break;
+			}
+		}
+		if( bDifferent )
+		{
+			NumNames++;
+			PrevPos = Pos;
+		}
+		SA[NumLMS + Pos/2] = NumNames - 1;
+	}
+
+	// Pack the names into the reduced text at the end of SA, in text order.
+	for( INT Index=Num-1, Packed=Num-1; Index>=NumLMS; Index-- )
+	{
+		if( SA[Index] >= 0 )
+		{
+			SA[Packed--] = SA[Index];
+		}
+	}
+
+	// Sort the LMS suffixes through the reduced text, directly if all names are unique.
+	INT* ReducedText = SA + Num - NumLMS;
+	INT* ReducedSA = SA;
+	if( NumNames < NumLMS )
+	{
+		BuildSuffixArray( ReducedText, ReducedSA, NumLMS, NumNames );
+	}
+	else
+	{
+		for( INT Index=0; Index<NumLMS; Index++ )
+		{
+			ReducedSA[ReducedText[Index]] = Index;
+		}
+	}
+
+	// Map the sorted reduced suffixes back to LMS positions, reusing the reduced text.
+	for( INT Index=1, LMSIndex=0; Index<Num; Index++ )
+	{
+		if( IsLMS(Types, Index) )
+		{
+			ReducedText[LMSIndex++] = Index;
+		}
+	}
+	for( INT Index=0; Index<NumLMS; Index++ )
+	{
+		ReducedSA[Index] = ReducedText[ReducedSA[Index]];
+	}
+
+	// Place the sorted LMS suffixes at the end of their buckets and induce all others.
+	for( INT Index=NumLMS; Index<Num; Index++ )
+	{
+		SA[Index] = INDEX_NONE;
+	}
+	GetBuckets( Text, Num, NumChars, Buckets, 1 );
+	for( INT Index=NumLMS-1; Index>=0; Index-- )
+	{
+		const INT Pos = SA[Index];
+		SA[Index] = INDEX_NONE;
+		SA[--Buckets[Text[Pos]]] = Pos;
+	}
+	InduceL( Text, Types, SA, Num, NumChars, Buckets );
+	InduceS( Text, Types, SA, Num, NumChars, Buckets );
+}
+
+/*-----------------------------------------------------------------------------
+	FCodecBWT.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Sorts the Length+1 suffixes of Data, including the empty one, in linear time. A suffix
+ * sorts after the longer suffixes it is a prefix of, which is the order the original
+ * comparison sort produced, so encoded streams are unchanged.
+ *
+ * @param	Data		Block to sort the suffixes of
+ * @param	Length		Length of the block
+ * @param	Positions	[out] start of the suffixes in sorted order, Length+1 entries
+ */
+void FCodecBWT::SortSuffixes( const BYTE* Data, INT Length, INT* Positions )
+{
+	// Characters are shifted up by one so the end of the block can be a character larger than
+	// all others, and the unique smallest character SA-IS requires is appended. Its suffix
+	// sorts first and is dropped.
+	const INT Num = Length + 2;
+	TArray<INT> Text( Num );
+	TArray<INT> SA( Num );
+	for( INT Index=0; Index<Length; Index++ )
+	{
+		Text(Index) = Data[Index] + 1;
+	}
+	Text(Length)	= 257;
+	Text(Length+1)	= 0;
+	BuildSuffixArray( &Text(0), &SA(0), Num, 258 );
+	checkSlow(SA(0)==Length+1);
+	appMemcpy( Positions, &SA(1), (Length + 1) * sizeof(INT) );
+}
+
+/**
+ * Loop body transforming a batch of blocks.
+ */
+class FBWTEncodeBody : public FParallelForBody
+{
+public:
+	/** Batch of blocks, each BlockSize bytes but the last */
+	const BYTE*	Data;
+	/** Total size of the blocks */
+	INT			DataLength;
+	/** Size of a full block */
+	INT			BlockSize;
+	/** Transformed blocks, each at a multiple of BlockSize+1 */
+	BYTE*		Output;
+	/** Row of the rotation starting at the second byte of each block */
+	INT*		First;
+	/** Row of the rotation starting at the first byte of each block */
+	INT*		Last;
+
+	virtual void Execute(INT Index)
+	{
+		const BYTE* Block = Data + Index * BlockSize;
+		const INT Length = Min( BlockSize, DataLength - Index * BlockSize );
+		TArray<INT> Positions( Length + 1 );
+		FCodecBWT::SortSuffixes( Block, Length, &Positions(0) );
+
+		BYTE* BlockOutput = Output + Index * (BlockSize + 1);
+		for( INT i=0; i<Length+1; i++ )
+		{
+			const INT Position = Positions(i);
+			if( Position==1 )
+				First[Index] = i;
+			else if( Position==0 )
+				Last[Index] = i;
+			BlockOutput[i] = Block[Position ? Position-1 : 0];
+		}
+	}
+};
+
+/**
+ * Loop body undoing the transform of a batch of blocks.
+ */
+class FBWTDecodeBody : public FParallelForBody
+{
+public:
+	/** Transformed blocks, each at a multiple of BlockSize+1 */
+	const BYTE*	Data;
+	/** Size of each transformed block, one more than the size of the original */
+	const INT*	Lengths;
+	/** Row of the rotation starting at the second byte of each block */
+	const INT*	First;
+	/** Row of the rotation starting at the first byte of each block */
+	const INT*	Last;
+	/** Size of a full block */
+	INT			BlockSize;
+	/** Original blocks, each at a multiple of BlockSize */
+	BYTE*		Output;
+
+	virtual void Execute(INT Index)
+	{
+		const BYTE* DecompressBuffer = Data + Index * (BlockSize + 1);
+		const INT DecompressLength = Lengths[Index];
+		INT DecompressCount[256+1], RunningTotal[256+1], i, j;
+		TArray<INT> Temp( DecompressLength );
+
+		for( i=0; i<257; i++ )
+			DecompressCount[ i ]=0;
+		for( i=0; i<DecompressLength; i++ )
+			DecompressCount[ i!=Last[Index] ? DecompressBuffer[i] : 256 ]++;
+		INT Sum = 0;
+		for( i=0; i<257; i++ )
+		{
+			RunningTotal[i] = Sum;
+			Sum += DecompressCount[i];
+			DecompressCount[i] = 0;
+		}
+		for( i=0; i<DecompressLength; i++ )
+		{
+			INT CharIndex = i!=Last[Index] ? DecompressBuffer[i] : 256;
+			Temp(RunningTotal[CharIndex] + DecompressCount[CharIndex]++) = i;
+		}
+		BYTE* BlockOutput = Output + Index * BlockSize;
+		for( i=First[Index],j=0 ; j<DecompressLength-1; i=Temp(i),j++ )
+			BlockOutput[j] = DecompressBuffer[i];
+	}
+};
+
+/**
+ * Transforms the input in blocks of MAX_BUFFER_SIZE bytes. Blocks are independent, so
+ * batches of them are transformed in parallel and written out in order.
+ */
+UBOOL FCodecBWT::Encode( FArchive& In, FArchive& Out )
+{
+	const INT BlocksPerBatch = bParallel ? Max<INT>( GNumHardwareThreads, 1 ) * 2 : 1;
+	TArray<BYTE> Data( BlocksPerBatch * MAX_BUFFER_SIZE );
+	TArray<BYTE> Output( BlocksPerBatch * (MAX_BUFFER_SIZE + 1) );
+	TArray<INT> First( BlocksPerBatch );
+	TArray<INT> Last( BlocksPerBatch );
+
+	FBWTEncodeBody Body;
+	Body.Data		= &Data(0);
+	Body.BlockSize	= MAX_BUFFER_SIZE;
+	Body.Output		= &Output(0);
+	Body.First		= &First(0);
+	Body.Last		= &Last(0);
+	while( !In.AtEnd() )
+	{
+		Body.DataLength = Min<INT>( In.TotalSize()-In.Tell(), BlocksPerBatch * MAX_BUFFER_SIZE );
+		In.Serialize( &Data(0), Body.DataLength );
+		const INT NumBlocks = (Body.DataLength + MAX_BUFFER_SIZE - 1) / MAX_BUFFER_SIZE;
+		if( NumBlocks > 1 )
+			appParallelFor( NumBlocks, Body );
+		else
+			Body.Execute( 0 );
+
+		for( INT BlockIndex=0; BlockIndex<NumBlocks; BlockIndex++ )
+		{
+			INT CompressLength = Min( MAX_BUFFER_SIZE, Body.DataLength - BlockIndex * MAX_BUFFER_SIZE );
+			Out << CompressLength << First(BlockIndex) << Last(BlockIndex);
+			Out.Serialize( &Output(BlockIndex * (MAX_BUFFER_SIZE + 1)), CompressLength + 1 );
+		}
+	}
+	return 0;
+}
+
+/**
+ * Undoes the transform, reading batches of blocks and undoing them in parallel.
+ */
+UBOOL FCodecBWT::Decode( FArchive& In, FArchive& Out )
+{
+	const INT BlocksPerBatch = bParallel ? Max<INT>( GNumHardwareThreads, 1 ) * 2 : 1;
+	TArray<BYTE> Data( BlocksPerBatch * (MAX_BUFFER_SIZE + 1) );
+	TArray<BYTE> Output( BlocksPerBatch * MAX_BUFFER_SIZE );
+	TArray<INT> Lengths( BlocksPerBatch );
+	TArray<INT> First( BlocksPerBatch );
+	TArray<INT> Last( BlocksPerBatch );
+
+	FBWTDecodeBody Body;
+	Body.Data		= &Data(0);
+	Body.Lengths	= &Lengths(0);
+	Body.First		= &First(0);
+	Body.Last		= &Last(0);
+	Body.BlockSize	= MAX_BUFFER_SIZE;
+	Body.Output		= &Output(0);
+	while( !In.AtEnd() )
+	{
+		INT NumBlocks = 0;
+		while( NumBlocks<BlocksPerBatch && !In.AtEnd() )
+		{
+			INT DecompressLength;
+			In << DecompressLength << First(NumBlocks) << Last(NumBlocks);
+			check(DecompressLength>0 && DecompressLength<=MAX_BUFFER_SIZE);
+			check(DecompressLength<In.TotalSize()-In.Tell());
+			check(First(NumBlocks)>=0 && First(NumBlocks)<=DecompressLength);
+			Lengths(NumBlocks) = ++DecompressLength;
+			In.Serialize( &Data(NumBlocks * (MAX_BUFFER_SIZE + 1)), DecompressLength );
+			NumBlocks++;
+		}
+		if( NumBlocks > 1 )
+			appParallelFor( NumBlocks, Body );
+		else
+			Body.Execute( 0 );
+
+		for( INT BlockIndex=0; BlockIndex<NumBlocks; BlockIndex++ )
+			Out.Serialize( &Output(BlockIndex * MAX_BUFFER_SIZE), Lengths(BlockIndex) - 1 );
+	}
+	return 1;
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -3598,10 +3598,13 @@ BYTE GRegisterCast( INT CastCode, const Native& Func )
 /**
  * Constructor
  *
- * @param InSoftMemoryLimit		Max number of bytes used by call graph data (soft limit).
+ * @param InSoftMemoryLimit		Max number of bytes used by the call tree.
  */
 FScriptCallGraph::FScriptCallGraph( DWORD InSoftMemoryLimit )
 {
+	static DWORD NextGeneration = 0;
+	Generation = ++NextGeneration;
+
 	check( InSoftMemoryLimit );
 	Reset( InSoftMemoryLimit );
 }
@@ -3609,7 +3612,7 @@ FScriptCallGraph::FScriptCallGraph( DWORD InSoftMemoryLimit )
 /**
  * Resets data collection and memory use.
  *
- * @param InSoftMemoryLimit		Max number of bytes used by call graph data (soft limit).
+ * @param InSoftMemoryLimit		Max number of bytes used by the call tree, 0 to keep the current limit.
  */
 void FScriptCallGraph::Reset( DWORD InSoftMemoryLimit )
 {
@@ -3617,84 +3620,279 @@ void FScriptCallGraph::Reset( DWORD InSoftMemoryLimit )
 	{
 		SoftMemoryLimit = InSoftMemoryLimit;
 	}
+	MaxNodes		= Max<INT>( SoftMemoryLimit / sizeof(FScriptCallGraphNode), 1 );
+	UntrackedCalls	= 0;
+	FrameCount		= 0;
+
+	// Keep functions that are currently on the stack so unwinding still finds them.
+	for( INT FunctionId=0; FunctionId<Functions.Num(); FunctionId++ )
+	{
+		FScriptCallGraphFunction& Function = Functions(FunctionId);
+		Function.Calls				= 0;
+		Function.InclusiveCycles	= 0;
+		Function.ExclusiveCycles	= 0;
+	}
 
-	Data.Empty( SoftMemoryLimit * 11 / 10 / sizeof(DWORD) );
+	// Calls in flight lose their call tree node.
+	for( INT StackIndex=0; StackIndex<Stack.Num(); StackIndex++ )
+	{
+		Stack(StackIndex).NodeIndex		= INDEX_NONE;
+		Stack(StackIndex).ChildCycles	= 0;
+	}
+
+	Nodes.Empty();
+	FScriptCallGraphNode& Root	= Nodes(Nodes.Add());
+	Root.FunctionId				= INDEX_NONE;
+	Root.ParentIndex			= INDEX_NONE;
+	Root.FirstChildIndex		= INDEX_NONE;
+	Root.NextSiblingIndex		= INDEX_NONE;
+	Root.Calls					= 0;
+	Root.InclusiveCycles		= 0;
+	Root.ExclusiveCycles		= 0;
 }
 
 /**
- * Serializes the profiling data to the passed in archive.	
+ * Returns the stable id for the passed in function, assigning a new one if needed.
  *
- * @param Ar	Archive to serialize data to.
+ * @param Function	Function to look up
+ * @return id of function
  */
-void FScriptCallGraph::Serialize( FArchive& Ar )
+INT FScriptCallGraph::GetFunctionId( UFunction* Function )
 {
-	if( Data.Num() )
+	INT* FunctionId = FunctionToIdMap.Find( Function );
+	if( FunctionId )
 	{
-		INT StartIndex	= 0;
-		INT EndIndex	= 0;
+		return *FunctionId;
+	}
 
-		// Skip the first frame as we most likely are in the middle of the call stack.
-		while( StartIndex<Data.Num() && !IsFrameEndMarker(Data(StartIndex)) )
-		{
-			StartIndex++;
-		}
-		check(StartIndex<Data.Num());
+	// Functions reloaded after garbage collection keep the id of their previous incarnation.
+	FString PathName = Function->GetPathName();
+	INT* PathNameId = PathNameToIdMap.Find( PathName );
+	if( PathNameId )
+	{
+		FunctionToIdMap.Set( Function, *PathNameId );
+		return *PathNameId;
+	}
 
-		// Find the end of the call graph data.
-		EndIndex = StartIndex;
-		while( EndIndex<Data.Num() && !IsEndMarker(Data(EndIndex)) )
-		{
-			EndIndex++;
-		}
+	INT NewId							= Functions.AddZeroed();
+	FScriptCallGraphFunction& Entry		= Functions(NewId);
+	Entry.PathName						= PathName;
+	PathNameToIdMap.Set( *PathName, NewId );
+	FunctionToIdMap.Set( Function, NewId );
+	return NewId;
+}
+
+/**
+ * Finds or adds the child node of ParentIndex for the passed in function.
+ *
+ * @param ParentIndex	Index of parent node, INDEX_NONE if the parent isn't tracked
+ * @param FunctionId	Id of called function
+ * @return index of child node or INDEX_NONE if the call tree is full
+ */
+INT FScriptCallGraph::FindOrAddChild( INT ParentIndex, INT FunctionId )
+{
+	if( ParentIndex == INDEX_NONE )
+	{
+		return INDEX_NONE;
+	}
 
-		// Create a list of all functions currently loaded.
-		TArray<UFunction*> Functions;
-		for( TObjectIterator<UFunction> It; It; ++It )
+	// Search children, moving a match to the front of the sibling list as calls tend to repeat.
+	INT PreviousIndex = INDEX_NONE;
+	for( INT ChildIndex=Nodes(ParentIndex).FirstChildIndex; ChildIndex!=INDEX_NONE; ChildIndex=Nodes(ChildIndex).NextSiblingIndex )
+	{
+		if( Nodes(ChildIndex).FunctionId == FunctionId )
 		{
-			Functions.AddItem( *It );
+			if( PreviousIndex != INDEX_NONE )
+			{
+				Nodes(PreviousIndex).NextSiblingIndex	= Nodes(ChildIndex).NextSiblingIndex;
+				Nodes(ChildIndex).NextSiblingIndex		= Nodes(ParentIndex).FirstChildIndex;
+				Nodes(ParentIndex).FirstChildIndex		= ChildIndex;
+			}
+			return ChildIndex;
 		}
+		PreviousIndex = ChildIndex;
+	}
+
+	if( Nodes.Num() >= MaxNodes )
+	{
+		return INDEX_NONE;
+	}
+
+	INT NewIndex					= Nodes.Add();
+	FScriptCallGraphNode& Node		= Nodes(NewIndex);
+	Node.FunctionId					= FunctionId;
+	Node.ParentIndex				= ParentIndex;
+	Node.FirstChildIndex			= INDEX_NONE;
+	Node.NextSiblingIndex			= Nodes(ParentIndex).FirstChildIndex;
+	Node.Calls						= 0;
+	Node.InclusiveCycles			= 0;
+	Node.ExclusiveCycles			= 0;
+	Nodes(ParentIndex).FirstChildIndex = NewIndex;
+	return NewIndex;
+}
+
+/**
+ * Notifies the profiler that a function is about to be called.
+ *
+ * @param Function	Function about to be called
+ */
+void FScriptCallGraph::BeginFunction( UFunction* Function )
+{
+	INT FunctionId		= GetFunctionId( Function );
+	INT ParentIndex		= Stack.Num() ? Stack.Last().NodeIndex : 0;
 
-		// First value to serialize is the number of usecs per cycle. (DOUBLE)
-		DOUBLE usecsPerCycle = GSecondsPerCycle * 1000.0 * 1000.0;
-		Ar << usecsPerCycle;
+	FStackEntry& Entry	= Stack(Stack.Add());
+	Entry.FunctionId	= FunctionId;
+	Entry.NodeIndex		= FindOrAddChild( ParentIndex, FunctionId );
+	Entry.ChildCycles	= 0;
 
-		// Second value is the number of functions that are being serialized (DWORD).
-		DWORD FunctionCount = Functions.Num();
-		Ar << FunctionCount;
+	Functions(FunctionId).ActiveCount++;
+}
 
-		for( INT FunctionIndex=0; FunctionIndex<Functions.Num(); FunctionIndex++ )
+/**
+ * Notifies the profiler that the most recently begun function has returned.
+ *
+ * @param Cycles	Cycles spent in function call
+ */
+void FScriptCallGraph::EndFunction( DWORD Cycles )
+{
+	check(Stack.Num());
+	FStackEntry Entry				= Stack.Pop();
+	DWORD ExclusiveCycles			= Cycles > Entry.ChildCycles ? Cycles - Entry.ChildCycles : 0;
+
+	FScriptCallGraphFunction& Function = Functions(Entry.FunctionId);
+	Function.Calls++;
+	Function.ExclusiveCycles		+= ExclusiveCycles;
+	// Only count the outermost call of recursive functions towards inclusive time.
+	if( --Function.ActiveCount == 0 )
+	{
+		Function.InclusiveCycles	+= Cycles;
+	}
+
+	if( Entry.NodeIndex != INDEX_NONE )
+	{
+		FScriptCallGraphNode& Node	= Nodes(Entry.NodeIndex);
+		Node.Calls++;
+		Node.InclusiveCycles		+= Cycles;
+		Node.ExclusiveCycles		+= ExclusiveCycles;
+	}
+	else
+	{
+		UntrackedCalls++;
+	}
+
+	if( Stack.Num() )
+	{
+		Stack.Last().ChildCycles	+= Cycles;
+	}
+	else
+	{
+		Nodes(0).Calls++;
+		Nodes(0).InclusiveCycles	+= Cycles;
+	}
+}
+
+/**
+ * Marks the end of a frame. Needs to be called when there are no script functions on the stack.
+ */
+void FScriptCallGraph::Tick()
+{
+	FrameCount++;
+}
+
+/** Function ids used to sort a report */
+static TArray<FScriptCallGraphFunction>* GScriptCallGraphSortFunctions;
+static UBOOL GScriptCallGraphSortByInclusive;
+IMPLEMENT_COMPARE_CONSTREF( INT, UnCorSc, 
+{ 
+	const FScriptCallGraphFunction& FunctionA = (*GScriptCallGraphSortFunctions)(A);
+	const FScriptCallGraphFunction& FunctionB = (*GScriptCallGraphSortFunctions)(B);
+	QWORD CyclesA = GScriptCallGraphSortByInclusive ? FunctionA.InclusiveCycles : FunctionA.ExclusiveCycles;
+	QWORD CyclesB = GScriptCallGraphSortByInclusive ? FunctionB.InclusiveCycles : FunctionB.ExclusiveCycles;
+	return CyclesA < CyclesB ? 1 : (CyclesA > CyclesB ? -1 : 0);
+} );
+
+/**
+ * Logs the top functions to the passed in output device.
+ *
+ * @param Ar				Output device to log to
+ * @param Count				Number of functions to log
+ * @param bSortByInclusive	Whether to sort by inclusive instead of exclusive time
+ */
+void FScriptCallGraph::Report( FOutputDevice& Ar, INT Count, UBOOL bSortByInclusive )
+{
+	TArray<INT> SortedIds;
+	for( INT FunctionId=0; FunctionId<Functions.Num(); FunctionId++ )
+	{
+		if( Functions(FunctionId).Calls )
 		{
-			FString			Name		= Functions(FunctionIndex)->GetPathName();
-			DWORD			Length		= Name.Len();
-			DWORD			Pointer		= (DWORD) Functions(FunctionIndex);
-		
-			// Serialize function pointer, length of name in characters and then serialize name without the
-			// trailing '\0' as a chain of ANSI characters.
-			Ar << Pointer;	// (DWORD)
-			Ar << Length;	// (DWORD)
-			for( DWORD i=0; i<Length; i++ )
-			{
-				ANSICHAR ACh = ToAnsi( Name[i] );
-				Ar << ACh;	// (ANSICHAR)
-			}
+			SortedIds.AddItem( FunctionId );
 		}
+	}
+	GScriptCallGraphSortFunctions	= &Functions;
+	GScriptCallGraphSortByInclusive	= bSortByInclusive;
+	if( SortedIds.Num() )
+	{
+		Sort<USE_COMPARE_CONSTREF(INT,UnCorSc)>( &SortedIds(0), SortedIds.Num() );
+	}
 
-		// Serialize raw collected data as tokens of DWORDs.
-		Ar.Serialize( &Data(StartIndex), (EndIndex - StartIndex) * sizeof(DWORD) );
+	const DOUBLE MsecPerCycle	= GSecondsPerCycle * 1000.0;
+	const DOUBLE Frames			= Max<DWORD>( FrameCount, 1 );
+	Ar.Logf( TEXT("Script profile: %u frames, %i functions, %i/%i call tree nodes, %u untracked calls"), FrameCount, Functions.Num(), Nodes.Num(), MaxNodes, UntrackedCalls );
+	Ar.Logf( TEXT("%6s %10s %12s %12s %10s %10s  %s"), TEXT("Id"), TEXT("Calls"), TEXT("Incl (ms)"), TEXT("Excl (ms)"), TEXT("Incl/frm"), TEXT("Excl/frm"), TEXT("Function") );
+	for( INT SortIndex=0; SortIndex<Min(Count,SortedIds.Num()); SortIndex++ )
+	{
+		const FScriptCallGraphFunction& Function = Functions(SortedIds(SortIndex));
+		Ar.Logf( TEXT("%6i %10u %12.2f %12.2f %10.3f %10.3f  %s"),
+			SortedIds(SortIndex),
+			Function.Calls,
+			Function.InclusiveCycles * MsecPerCycle,
+			Function.ExclusiveCycles * MsecPerCycle,
+			Function.InclusiveCycles * MsecPerCycle / Frames,
+			Function.ExclusiveCycles * MsecPerCycle / Frames,
+			*Function.PathName );
 	}
 }
 
 /**
- * Emits the end of frame marker. Needs to be called when there are no script functions
- * on the stack. Also responsible for reseting call graph data if memory limit is reached.
+ * Writes the function table and the call tree as two CSV files, <BaseFilename>-Functions.csv
+ * and <BaseFilename>-CallTree.csv. Function ids are shared between both files.
+ *
+ * @param BaseFilename		Filename without extension to derive output filenames from
+ * @return TRUE if both files were written, FALSE otherwise
  */
-void FScriptCallGraph::Tick()
+UBOOL FScriptCallGraph::WriteCSV( const FString& BaseFilename )
 {
-	EmitFrameEnd();
-	if( (Data.Num()*sizeof(DWORD)) > SoftMemoryLimit )
+	const DOUBLE MsecPerCycle = GSecondsPerCycle * 1000.0;
+
+	FString FunctionsCSV = TEXT("Id,Function,Calls,InclusiveMs,ExclusiveMs") LINE_TERMINATOR;
+	for( INT FunctionId=0; FunctionId<Functions.Num(); FunctionId++ )
+	{
+		const FScriptCallGraphFunction& Function = Functions(FunctionId);
+		FunctionsCSV += FString::Printf( TEXT("%i,%s,%u,%.4f,%.4f") LINE_TERMINATOR,
+			FunctionId,
+			*Function.PathName,
+			Function.Calls,
+			Function.InclusiveCycles * MsecPerCycle,
+			Function.ExclusiveCycles * MsecPerCycle );
+	}
+
+	FString CallTreeCSV = TEXT("NodeId,ParentNodeId,FunctionId,Calls,InclusiveMs,ExclusiveMs") LINE_TERMINATOR;
+	for( INT NodeIndex=0; NodeIndex<Nodes.Num(); NodeIndex++ )
 	{
-		Reset( SoftMemoryLimit );
+		const FScriptCallGraphNode& Node = Nodes(NodeIndex);
+		CallTreeCSV += FString::Printf( TEXT("%i,%i,%i,%u,%.4f,%.4f") LINE_TERMINATOR,
+			NodeIndex,
+			Node.ParentIndex,
+			Node.FunctionId,
+			Node.Calls,
+			Node.InclusiveCycles * MsecPerCycle,
+			Node.ExclusiveCycles * MsecPerCycle );
 	}
+
+	UBOOL bSuccess = appSaveStringToFile( FunctionsCSV, *(BaseFilename + TEXT("-Functions.csv")) );
+	bSuccess = appSaveStringToFile( CallTreeCSV, *(BaseFilename + TEXT("-CallTree.csv")) ) && bSuccess;
+	return bSuccess;
 }
 
 /** Global script call graph profiler */
@@ -3707,37 +3905,38 @@ FScriptCallGraph* GScriptCallGraph = NULL;
 struct FScopedScriptStats
 {
 	/** 
-	 * Constructor, emiting function pointer to stream.
+	 * Constructor, notifying the call graph of the function call.
 	 *
 	 * @param InFunction	Function about to be called.
 	 */
 	FScopedScriptStats( UFunction* InFunction )
 	{
+		Generation = GScriptCallGraph ? GScriptCallGraph->GetGeneration() : 0;
 		if( GScriptCallGraph )
 		{
+			GScriptCallGraph->BeginFunction( InFunction );
 			StartCycles = appCycles();
-			Function	= InFunction;
-			GScriptCallGraph->EmitFunction( Function );
 		}
 	}
 
 	/**
-	 * Destructor, emiting cycles spent in function call.	
+	 * Destructor, notifying the call graph of the cycles spent in function call.
 	 */
 	~FScopedScriptStats()
 	{
-		if( GScriptCallGraph )
+		// Profiling might have been started or stopped by the call itself.
+		if( Generation && GScriptCallGraph && GScriptCallGraph->GetGeneration() == Generation )
 		{
 			DWORD Cycles = appCycles() - StartCycles;
-			GScriptCallGraph->EmitCycles( Cycles );
+			GScriptCallGraph->EndFunction( Cycles );
 		}
 	}
 
 private:
-	/** Function associated with callss */
-	UFunction*	Function;
+	/** Generation of the call graph the call was reported to, 0 if profiling wasn't running */
+	DWORD				Generation;
 	/** Cycle count before function was being called. */
-	DWORD		StartCycles;
+	DWORD				StartCycles;
 };
 
 /*-----------------------------------------------------------------------------
@@ -3899,6 +4098,8 @@ void UObject::ProcessEvent( UFunction* Function, void* Parms, void* UnusedResult
 		return;
 	checkSlow(Function->ParmsSize==0 || Parms!=NULL);
 
+	MEMORY_TAG_SCOPE(UnrealScript);
+
 	if(++ScriptEntryTag == 1)
 	{
 		clock(GScriptCycles);
@@ -120,6 +120,8 @@ FArchive& operator<<( FArchive& Ar, FPackageFileSummary& Sum )
 	}
 	else
 		appErrorf(TEXT("!!oldver << FPackageFileSummary"));
+	if( Sum.PackageFlags & PKG_StoreCompressed )
+		Ar << Sum.CompressedChunks;
 
 	return Ar;
 }
@@ -201,6 +203,7 @@ FString ULinker::GetExportFullName( INT i, const TCHAR* FakeRoot )
 ULinkerLoad::ULinkerLoad( UObject* InParent, const TCHAR* InFilename, DWORD InLoadFlags )
 :	ULinker( InParent, InFilename )
 ,	LoadFlags( InLoadFlags )
+,	bStoredCompressed( 0 )
 {
 	Loader = GFileManager->CreateFileReader( InFilename, 0, GError );
 	if( !Loader )
@@ -225,6 +228,17 @@ ULinkerLoad::ULinkerLoad( UObject* InParent, const TCHAR* InFilename, DWORD InLo
 
 	// Read summary from file.
 	*this << Summary;
+
+	// Read everything past the summary through the chunks of compressed packages. Offsets
+	// stored in the package refer to the uncompressed data, whose summary lacks the flag.
+	if( (Summary.PackageFlags & PKG_StoreCompressed) && Summary.Tag == PACKAGE_FILE_TAG )
+	{
+		Loader = new FArchiveCompressedPackageReader( Loader, Summary.CompressedChunks, GError );
+		Summary.PackageFlags &= ~PKG_StoreCompressed;
+		Summary.CompressedChunks.Empty();
+		bStoredCompressed = 1;
+	}
+
 	// Loader needs to be the same version.
 	Loader->SetVer(Summary.GetFileVersion());
 	Loader->SetLicenseeVer(Summary.GetFileVersionLicensee());
@@ -121,6 +121,146 @@ void FMemStack::FreeChunks( FTaggedMemory* NewTopChunk )
 	}
 }
 
+/*-----------------------------------------------------------------------------
+	FFrameArena implementation.
+-----------------------------------------------------------------------------*/
+
+//
+// Allocate the arena. The calling thread becomes its owner.
+//
+void FFrameArena::Init( INT Size )
+{
+	check(Base==NULL);
+	MEMORY_TAG_SCOPE(FrameArena);
+	Memory					= appMalloc( Size + sizeof(FAllocHeader) );
+	Base					= Align( (BYTE*) Memory, sizeof(FAllocHeader) );
+	Top						= Base;
+	End						= Base + Size;
+	OwnerThreadId			= appGetCurrentThreadId();
+	LiveAllocations			= 0;
+	FrameAllocations		= 0;
+	FramePeakBytes			= 0;
+	FrameFallbacks			= 0;
+	LastFrameAllocations	= 0;
+	LastFramePeakBytes		= 0;
+	LastFrameFallbacks		= 0;
+	bWarnedAboutLeak		= 0;
+}
+
+//
+// Free the arena.
+//
+void FFrameArena::Exit()
+{
+	appFree( Memory );
+	Memory	= NULL;
+	Base	= NULL;
+	Top		= NULL;
+	End		= NULL;
+}
+
+//
+// Called once per frame by the engine loop, the server commandlet and for each
+// package processed by package workers. Reclaims all memory and updates the statistics.
+//
+void FFrameArena::Tick()
+{
+	LastFrameAllocations	= FrameAllocations;
+	LastFramePeakBytes		= FramePeakBytes;
+	LastFrameFallbacks		= FrameFallbacks;
+	FrameAllocations		= 0;
+	FramePeakBytes			= Top - Base;
+	FrameFallbacks			= 0;
+
+	// Reclaiming memory of a container that outlived its frame would corrupt it so we rather let
+	// the arena fill up and fall back to the heap.
+	if( LiveAllocations == 0 )
+	{
+		Top = Base;
+	}
+	else if( !bWarnedAboutLeak )
+	{
+		debugf( NAME_Warning, TEXT("Frame arena: %i allocations outlived their frame, memory won't be reclaimed"), LiveAllocations );
+		bWarnedAboutLeak = 1;
+	}
+}
+
+//
+// Allocate Size bytes, aligned to 16 bytes.
+//
+void* FFrameArena::Allocate( INT Size )
+{
+	if( !Base || appGetCurrentThreadId() != OwnerThreadId )
+	{
+		return NULL;
+	}
+	Size = Align( Size, sizeof(FAllocHeader) );
+	if( Top + sizeof(FAllocHeader) + Size > End )
+	{
+		FrameFallbacks++;
+		return NULL;
+	}
+
+	FAllocHeader* Header	= (FAllocHeader*) Top;
+	Header->Size			= Size;
+	Top						+= sizeof(FAllocHeader) + Size;
+	FramePeakBytes			= Max<INT>( FramePeakBytes, Top - Base );
+	FrameAllocations++;
+	LiveAllocations++;
+	return Header + 1;
+}
+
+//
+// Grow an allocation, in place if it is at the top of the arena.
+//
+void* FFrameArena::Realloc( void* Ptr, INT NewSize )
+{
+	check(Contains(Ptr));
+	check(appGetCurrentThreadId() == OwnerThreadId);
+
+	FAllocHeader*	Header	= (FAllocHeader*) Ptr - 1;
+	INT				OldSize	= Header->Size;
+	NewSize					= Align( NewSize, sizeof(FAllocHeader) );
+	if( (BYTE*) Ptr + OldSize == Top )
+	{
+		if( (BYTE*) Ptr + NewSize > End )
+		{
+			FrameFallbacks++;
+			return NULL;
+		}
+		Header->Size	= NewSize;
+		Top				= (BYTE*) Ptr + NewSize;
+		FramePeakBytes	= Max<INT>( FramePeakBytes, Top - Base );
+		return Ptr;
+	}
+
+	void* NewPtr = Allocate( NewSize );
+	if( NewPtr )
+	{
+		appMemcpy( NewPtr, Ptr, Min( OldSize, NewSize ) );
+		Free( Ptr );
+	}
+	return NewPtr;
+}
+
+//
+// Free an allocation. Memory is only reclaimed right away if it is at the top of the arena.
+// Only the owner can have allocated it so a free from any other thread means a container
+// escaped its frame; that would leave LiveAllocations out of sync and Tick never rewinding.
+//
+void FFrameArena::Free( void* Ptr )
+{
+	check(Contains(Ptr));
+	check(appGetCurrentThreadId() == OwnerThreadId);
+
+	FAllocHeader* Header = (FAllocHeader*) Ptr - 1;
+	if( (BYTE*) Ptr + Header->Size == Top )
+	{
+		Top = (BYTE*) Header;
+	}
+	LiveAllocations--;
+}
+
 /*-----------------------------------------------------------------------------
 	The End.
 -----------------------------------------------------------------------------*/
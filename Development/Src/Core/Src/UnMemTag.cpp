@@ -0,0 +1,500 @@
+/*=============================================================================
+	UnMemTag.cpp: Allocation tagging and per tag memory accounting.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "CorePrivate.h"
+
+/** Global memory tag tracker, relies on zero initialization as it's used before static constructors run */
+FMemoryTagTracker GMemoryTagTracker;
+
+/** Weight of the current frame when smoothing per frame allocation rates */
+#define MEMORY_TAG_RATE_SMOOTHING	0.1f
+
+/** Names of the builtin tags, indexed by EMemoryTag */
+static const TCHAR* GBuiltinMemoryTagNames[MEMORY_TAG_BuiltinCount] =
+{
+	TEXT("Untagged"),
+	TEXT("Class:Other"),
+	TEXT("Names"),
+	TEXT("UnrealScript"),
+	TEXT("Packages"),
+	TEXT("SpawnActor"),
+	TEXT("Net"),
+	TEXT("FrameArena"),
+};
+
+/*-----------------------------------------------------------------------------
+	FMemoryTagTracker implementation.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Allocates the thread local storage slot and names the builtin tags. Called by
+ * FMallocTagProxy::Init once the platform has been initialized.
+ */
+void FMemoryTagTracker::Init()
+{
+	if( !bInitialized )
+	{
+		TlsSlot			= appAllocTlsSlot();
+		bInitialized	= TRUE;
+	}
+	AddBuiltinTags();
+}
+
+/**
+ * Names the builtin tags if that hasn't happened yet. Index 0 is also used for all
+ * allocations made before the tracker was initialized.
+ */
+void FMemoryTagTracker::AddBuiltinTags()
+{
+	if( TagCount == 0 )
+	{
+		for( INT TagIndex=0; TagIndex<MEMORY_TAG_BuiltinCount; TagIndex++ )
+		{
+			appStrcpy( Tags[TagIndex].Name, GBuiltinMemoryTagNames[TagIndex] );
+		}
+		TagCount = MEMORY_TAG_BuiltinCount;
+	}
+}
+
+/**
+ * Adds a tag without checking whether it already exists. Needs to be called with
+ * the registration lock held.
+ *
+ * @param	Name	Name of tag
+ * @return	index of tag, INDEX_NONE if the tag table is full
+ */
+INT FMemoryTagTracker::AddTag( const TCHAR* Name )
+{
+	AddBuiltinTags();
+	if( TagCount == MAX_MEMORY_TAGS )
+	{
+		return INDEX_NONE;
+	}
+	appStrncpy( Tags[TagCount].Name, Name, MAX_MEMORY_TAG_NAME );
+	// Publish the tag after its name has been written as other threads might be iterating over the table.
+	return TagCount++;
+}
+
+/**
+ * Returns the index of the tag with the passed in name, registering it if needed.
+ *
+ * @param	Name	Name of tag
+ * @return	index of tag, MEMORY_TAG_Untagged if the tag table is full
+ */
+INT FMemoryTagTracker::RegisterTag( const TCHAR* Name )
+{
+	// Created lazily as the tracker is constructed before the synchronization factory is set up.
+	if( !RegistrationSynch )
+	{
+		RegistrationSynch = GSynchronizeFactory->CreateCriticalSection();
+	}
+	FScopeLock ScopeLock( RegistrationSynch );
+
+	for( INT TagIndex=0; TagIndex<TagCount; TagIndex++ )
+	{
+		if( appStrncmp( Tags[TagIndex].Name, Name, MAX_MEMORY_TAG_NAME - 1 ) == 0 )
+		{
+			return TagIndex;
+		}
+	}
+	INT TagIndex = AddTag( Name );
+	return TagIndex == INDEX_NONE ? MEMORY_TAG_Untagged : TagIndex;
+}
+
+/**
+ * Returns the tag used for objects of the passed in class, registering it if needed.
+ *
+ * @param	Class	Class to retrieve tag for
+ * @return	index of tag
+ */
+INT FMemoryTagTracker::GetClassTag( UClass* Class )
+{
+	const INT	HashSize	= ARRAY_COUNT(ClassHashKeys);
+	INT			HashIndex	= (INT)((((PTRINT) Class) >> 4) & (HashSize - 1));
+
+	// Lookups don't need to lock as the tag is written before the key.
+	for( ;; )
+	{
+		UClass* Key = ClassHashKeys[HashIndex];
+		if( Key == Class )
+		{
+			return ClassHashTags[HashIndex];
+		}
+		if( Key == NULL )
+		{
+			break;
+		}
+		HashIndex = (HashIndex + 1) & (HashSize - 1);
+	}
+
+	if( !RegistrationSynch )
+	{
+		RegistrationSynch = GSynchronizeFactory->CreateCriticalSection();
+	}
+	FScopeLock ScopeLock( RegistrationSynch );
+
+	// Another thread might have added the class in the meantime, continue probing from where we stopped.
+	while( ClassHashKeys[HashIndex] != NULL )
+	{
+		if( ClassHashKeys[HashIndex] == Class )
+		{
+			return ClassHashTags[HashIndex];
+		}
+		HashIndex = (HashIndex + 1) & (HashSize - 1);
+	}
+
+	TCHAR TagName[MAX_MEMORY_TAG_NAME];
+	appStrcpy( TagName, TEXT("Class:") );
+	appStrncat( TagName, Class->GetName(), MAX_MEMORY_TAG_NAME );
+
+	// Classes share a single tag once the table is full. The hash table is twice the size of
+	// the tag table so it always has room for the class.
+	INT TagIndex = AddTag( TagName );
+	ClassHashTags[HashIndex] = TagIndex == INDEX_NONE ? MEMORY_TAG_OtherClasses : TagIndex;
+	ClassHashKeys[HashIndex] = Class;
+	return ClassHashTags[HashIndex];
+}
+
+/**
+ * Enables or disables callstack sampling. Samples of allocations that are still
+ * live stay valid when the rate changes.
+ *
+ * @param	InSampleRate	Record the callstack of one in this many allocations, 0 to disable
+ */
+void FMemoryTagTracker::SetSampleRate( DWORD InSampleRate )
+{
+	if( InSampleRate && !Samples )
+	{
+		// Allocated from the system heap so the pool itself doesn't show up in the tags.
+		FMemoryTagSample* NewSamples = (FMemoryTagSample*) appSystemMalloc( sizeof(FMemoryTagSample) * MAX_MEMORY_SAMPLES );
+		for( INT SampleIndex=0; SampleIndex<MAX_MEMORY_SAMPLES; SampleIndex++ )
+		{
+			NewSamples[SampleIndex].NextFree	= SampleIndex + 1 < MAX_MEMORY_SAMPLES ? SampleIndex + 1 : INDEX_NONE;
+			NewSamples[SampleIndex].bLive		= FALSE;
+		}
+		FirstFreeSample	= 0;
+		Samples			= NewSamples;
+	}
+	SampleCounter	= 0;
+	SampleRate		= InSampleRate;
+}
+
+/**
+ * Records the callstack of the current allocation.
+ *
+ * @param	Tag		Tag of allocation
+ * @param	Size	Size of allocation
+ * @return	index of sample or INDEX_NONE if the sample pool is exhausted
+ */
+INT FMemoryTagTracker::RecordSample( INT Tag, DWORD Size )
+{
+	INT SampleIndex = FirstFreeSample;
+	if( SampleIndex == INDEX_NONE )
+	{
+		DroppedSamples++;
+		return INDEX_NONE;
+	}
+
+	FMemoryTagSample& Sample = Samples[SampleIndex];
+	FirstFreeSample	= Sample.NextFree;
+
+	// Skip this function and the malloc proxy.
+	DWORD Depth = appCaptureStackBackTrace( Sample.BackTrace, MEMORY_SAMPLE_DEPTH, 2 );
+	for( ; Depth<MEMORY_SAMPLE_DEPTH; Depth++ )
+	{
+		Sample.BackTrace[Depth] = 0;
+	}
+	Sample.Size		= Size;
+	Sample.Tag		= Tag;
+	Sample.NextFree	= INDEX_NONE;
+	Sample.bLive	= TRUE;
+	return SampleIndex;
+}
+
+/**
+ * Returns a sample to the free list.
+ *
+ * @param	SampleIndex	Sample to free
+ */
+void FMemoryTagTracker::FreeSample( INT SampleIndex )
+{
+	Samples[SampleIndex].NextFree	= FirstFreeSample;
+	Samples[SampleIndex].bLive		= FALSE;
+	FirstFreeSample					= SampleIndex;
+}
+
+/**
+ * Updates per frame allocation rates. Called once per frame by the engine loop.
+ */
+void FMemoryTagTracker::AdvanceFrame()
+{
+	for( INT TagIndex=0; TagIndex<TagCount; TagIndex++ )
+	{
+		FMemoryTagStats& Stats		= Tags[TagIndex];
+		QWORD TotalAllocations		= Stats.TotalAllocations;
+		QWORD TotalBytes			= Stats.TotalBytes;
+		Stats.AllocationsPerFrame	= Lerp( Stats.AllocationsPerFrame, (FLOAT)(TotalAllocations - Stats.FrameStartAllocations), MEMORY_TAG_RATE_SMOOTHING );
+		Stats.BytesPerFrame			= Lerp( Stats.BytesPerFrame, (FLOAT)(TotalBytes - Stats.FrameStartBytes), MEMORY_TAG_RATE_SMOOTHING );
+		Stats.FrameStartAllocations	= TotalAllocations;
+		Stats.FrameStartBytes		= TotalBytes;
+	}
+}
+
+/**
+ * Remembers the current live bytes and allocations of all tags for a later diff.
+ */
+void FMemoryTagTracker::TakeSnapshot()
+{
+	for( INT TagIndex=0; TagIndex<MAX_MEMORY_TAGS; TagIndex++ )
+	{
+		SnapshotBytes[TagIndex]			= Tags[TagIndex].LiveBytes;
+		SnapshotAllocations[TagIndex]	= Tags[TagIndex].LiveAllocations;
+	}
+	SnapshotTime = appSeconds();
+}
+
+/** Keys used to sort tags, indexed by tag */
+static SQWORD* GMemoryTagSortKeys;
+IMPLEMENT_COMPARE_CONSTREF( INT, UnMemTag,
+{
+	// Sorts by descending absolute value so diffs show shrinking tags as well.
+	SQWORD KeyA = GMemoryTagSortKeys[A] < 0 ? -GMemoryTagSortKeys[A] : GMemoryTagSortKeys[A];
+	SQWORD KeyB = GMemoryTagSortKeys[B] < 0 ? -GMemoryTagSortKeys[B] : GMemoryTagSortKeys[B];
+	return KeyA < KeyB ? 1 : (KeyA > KeyB ? -1 : 0);
+} );
+
+/**
+ * Logs the tags with the most memory allocated.
+ *
+ * @param	Ar			Output device to log to
+ * @param	Count		Maximum number of tags to log
+ * @param	SortBy		"LIVE", "PEAK", "RATE" or "COUNT"
+ */
+void FMemoryTagTracker::Report( FOutputDevice& Ar, INT Count, const TCHAR* SortBy )
+{
+	const INT		NumTags = TagCount;
+	TArray<SQWORD>	SortKeys( NumTags );
+	TArray<INT>		SortedTags;
+	SQWORD			TotalLiveBytes = 0;
+	INT				TotalLiveAllocations = 0;
+	for( INT TagIndex=0; TagIndex<NumTags; TagIndex++ )
+	{
+		const FMemoryTagStats& Stats = Tags[TagIndex];
+		if( appStricmp( SortBy, TEXT("PEAK") ) == 0 )
+		{
+			SortKeys(TagIndex) = Stats.PeakBytes;
+		}
+		else if( appStricmp( SortBy, TEXT("RATE") ) == 0 )
+		{
+			SortKeys(TagIndex) = (SQWORD) Stats.BytesPerFrame;
+		}
+		else if( appStricmp( SortBy, TEXT("COUNT") ) == 0 )
+		{
+			SortKeys(TagIndex) = Stats.LiveAllocations;
+		}
+		else
+		{
+			SortKeys(TagIndex) = Stats.LiveBytes;
+		}
+		if( Stats.TotalAllocations )
+		{
+			SortedTags.AddItem( TagIndex );
+		}
+		TotalLiveBytes			+= Stats.LiveBytes;
+		TotalLiveAllocations	+= Stats.LiveAllocations;
+	}
+	GMemoryTagSortKeys = &SortKeys(0);
+	if( SortedTags.Num() )
+	{
+		Sort<USE_COMPARE_CONSTREF(INT,UnMemTag)>( &SortedTags(0), SortedTags.Num() );
+	}
+
+	Ar.Logf( TEXT("Memory tags: %i tags, %.2f MByte in %i allocations"), NumTags, TotalLiveBytes / 1024.f / 1024.f, TotalLiveAllocations );
+	Ar.Logf( TEXT("%12s %12s %10s %12s %12s  %s"), TEXT("Live (KB)"), TEXT("Peak (KB)"), TEXT("Allocs"), TEXT("Allocs/frm"), TEXT("KB/frm"), TEXT("Tag") );
+	for( INT SortIndex=0; SortIndex<Min(Count,SortedTags.Num()); SortIndex++ )
+	{
+		const FMemoryTagStats& Stats = Tags[SortedTags(SortIndex)];
+		Ar.Logf( TEXT("%12.1f %12.1f %10i %12.1f %12.2f  %s"),
+			Stats.LiveBytes / 1024.f,
+			Stats.PeakBytes / 1024.f,
+			Stats.LiveAllocations,
+			Stats.AllocationsPerFrame,
+			Stats.BytesPerFrame / 1024.f,
+			Stats.Name );
+	}
+}
+
+/**
+ * Logs the tags that changed the most since the last snapshot.
+ *
+ * @param	Ar			Output device to log to
+ * @param	Count		Maximum number of tags to log
+ */
+void FMemoryTagTracker::ReportDiff( FOutputDevice& Ar, INT Count )
+{
+	if( SnapshotTime == 0 )
+	{
+		Ar.Logf( TEXT("No memory tag snapshot taken, use MEMTAG SNAPSHOT first.") );
+		return;
+	}
+
+	const INT		NumTags = TagCount;
+	TArray<SQWORD>	SortKeys( NumTags );
+	TArray<INT>		SortedTags;
+	SQWORD			TotalDelta = 0;
+	for( INT TagIndex=0; TagIndex<NumTags; TagIndex++ )
+	{
+		SortKeys(TagIndex) = Tags[TagIndex].LiveBytes - SnapshotBytes[TagIndex];
+		if( SortKeys(TagIndex) || Tags[TagIndex].LiveAllocations != SnapshotAllocations[TagIndex] )
+		{
+			SortedTags.AddItem( TagIndex );
+		}
+		TotalDelta += SortKeys(TagIndex);
+	}
+	GMemoryTagSortKeys = &SortKeys(0);
+	if( SortedTags.Num() )
+	{
+		Sort<USE_COMPARE_CONSTREF(INT,UnMemTag)>( &SortedTags(0), SortedTags.Num() );
+	}
+
+	Ar.Logf( TEXT("Memory tag diff over %.1f seconds: %+.2f MByte, %i tags changed"), appSeconds() - SnapshotTime, TotalDelta / 1024.f / 1024.f, SortedTags.Num() );
+	Ar.Logf( TEXT("%12s %10s %12s  %s"), TEXT("Delta (KB)"), TEXT("Allocs"), TEXT("Live (KB)"), TEXT("Tag") );
+	for( INT SortIndex=0; SortIndex<Min(Count,SortedTags.Num()); SortIndex++ )
+	{
+		INT TagIndex = SortedTags(SortIndex);
+		const FMemoryTagStats& Stats = Tags[TagIndex];
+		Ar.Logf( TEXT("%+12.1f %+10i %12.1f  %s"),
+			SortKeys(TagIndex) / 1024.f,
+			Stats.LiveAllocations - SnapshotAllocations[TagIndex],
+			Stats.LiveBytes / 1024.f,
+			Stats.Name );
+	}
+}
+
+/** Live sampled allocations sharing the same callstack */
+struct FMemoryTagSampleGroup
+{
+	/** Sample whose callstack and tag represent the group */
+	INT		SampleIndex;
+	/** Number of sampled allocations */
+	INT		Count;
+	/** Sum of sizes of sampled allocations */
+	QWORD	Bytes;
+};
+
+/** Groups used to sort callstacks */
+static TArray<FMemoryTagSampleGroup>* GMemoryTagSortGroups;
+IMPLEMENT_COMPARE_CONSTREF( INT, UnMemTagSamples,
+{
+	QWORD BytesA = (*GMemoryTagSortGroups)(A).Bytes;
+	QWORD BytesB = (*GMemoryTagSortGroups)(B).Bytes;
+	return BytesA < BytesB ? 1 : (BytesA > BytesB ? -1 : 0);
+} );
+
+/**
+ * Logs the callstacks responsible for most of the sampled live memory.
+ *
+ * @param	Ar			Output device to log to
+ * @param	Count		Maximum number of callstacks to log
+ */
+void FMemoryTagTracker::ReportSamples( FOutputDevice& Ar, INT Count )
+{
+	if( !Samples )
+	{
+		Ar.Logf( TEXT("Memory tag sampling has never been enabled, use MEMTAG SAMPLE RATE=n first.") );
+		return;
+	}
+
+	// Samples are read without holding the malloc lock so the report is approximate while other threads allocate.
+	TArray<FMemoryTagSampleGroup>	Groups;
+	TMap<DWORD,INT>					CRCToGroupMap;
+	for( INT SampleIndex=0; SampleIndex<MAX_MEMORY_SAMPLES; SampleIndex++ )
+	{
+		const FMemoryTagSample& Sample = Samples[SampleIndex];
+		if( !Sample.bLive || Sample.BackTrace[0] == 0 )
+		{
+			continue;
+		}
+		DWORD	CRC			= appMemCrc( Sample.BackTrace, sizeof(Sample.BackTrace), Sample.Tag );
+		INT*	GroupIndex	= CRCToGroupMap.Find( CRC );
+		if( !GroupIndex )
+		{
+			INT NewIndex = Groups.AddZeroed();
+			Groups(NewIndex).SampleIndex = SampleIndex;
+			GroupIndex = &CRCToGroupMap.Set( CRC, NewIndex );
+		}
+		FMemoryTagSampleGroup& Group = Groups(*GroupIndex);
+		Group.Count++;
+		Group.Bytes += Sample.Size;
+	}
+
+	TArray<INT> SortedGroups;
+	for( INT GroupIndex=0; GroupIndex<Groups.Num(); GroupIndex++ )
+	{
+		SortedGroups.AddItem( GroupIndex );
+	}
+	GMemoryTagSortGroups = &Groups;
+	if( SortedGroups.Num() )
+	{
+		Sort<USE_COMPARE_CONSTREF(INT,UnMemTagSamples)>( &SortedGroups(0), SortedGroups.Num() );
+	}
+
+	// Estimates assume the current rate was used for the whole life time of the allocations.
+	const DWORD Scale = Max<DWORD>( SampleRate, 1 );
+	Ar.Logf( TEXT("Sampled allocations: 1 in %u, %i callstacks, %u dropped samples"), SampleRate, Groups.Num(), DroppedSamples );
+	for( INT SortIndex=0; SortIndex<Min(Count,SortedGroups.Num()); SortIndex++ )
+	{
+		const FMemoryTagSampleGroup&	Group	= Groups(SortedGroups(SortIndex));
+		const FMemoryTagSample&			Sample	= Samples[Group.SampleIndex];
+		FString BackTrace;
+		for( INT Depth=0; Depth<MEMORY_SAMPLE_DEPTH && Sample.BackTrace[Depth]; Depth++ )
+		{
+			BackTrace += FString::Printf( TEXT(" 0x%p"), (void*)(PTRINT) Sample.BackTrace[Depth] );
+		}
+		Ar.Logf( TEXT("~%.1f KB in ~%u allocations (%i samples) tagged %s:%s"),
+			Group.Bytes * Scale / 1024.f,
+			Group.Count * Scale,
+			Group.Count,
+			Tags[Sample.Tag].Name,
+			*BackTrace );
+	}
+}
+
+/**
+ * Writes the current state of all tags, and their change since the last snapshot,
+ * to a CSV file so captures from different points in time can be compared offline.
+ *
+ * @param	Filename	File to write to
+ * @return	TRUE if successful, FALSE otherwise
+ */
+UBOOL FMemoryTagTracker::WriteCSV( const TCHAR* Filename )
+{
+	FString CSV = TEXT("Tag,LiveBytes,PeakBytes,LiveAllocations,TotalAllocations,AllocationsPerFrame,BytesPerFrame,DeltaBytes,DeltaAllocations") LINE_TERMINATOR;
+	const INT NumTags = TagCount;
+	for( INT TagIndex=0; TagIndex<NumTags; TagIndex++ )
+	{
+		const FMemoryTagStats& Stats = Tags[TagIndex];
+		if( !Stats.TotalAllocations )
+		{
+			continue;
+		}
+		CSV += FString::Printf( TEXT("%s,%.0f,%.0f,%i,%.0f,%.2f,%.2f,%.0f,%i") LINE_TERMINATOR,
+			Stats.Name,
+			(DOUBLE) Stats.LiveBytes,
+			(DOUBLE) Stats.PeakBytes,
+			Stats.LiveAllocations,
+			(DOUBLE) Stats.TotalAllocations,
+			Stats.AllocationsPerFrame,
+			Stats.BytesPerFrame,
+			SnapshotTime != 0 ? (DOUBLE)(Stats.LiveBytes - SnapshotBytes[TagIndex]) : 0.0,
+			SnapshotTime != 0 ? Stats.LiveAllocations - SnapshotAllocations[TagIndex] : 0 );
+	}
+	return appSaveStringToFile( CSV, Filename );
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
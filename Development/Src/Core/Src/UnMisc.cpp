@@ -84,6 +84,25 @@ VARARG_BODY( void, FOutputDevice::Logf, const TCHAR*, VARARG_NONE )
 
 void FArray::Realloc( INT ElementSize )
 {
+	// Data allocated from the frame arena is never shrunk and grows inside the arena until it is exhausted.
+	if( GFrameArena.Contains( Data ) )
+	{
+		INT OldSize = GFrameArena.GetAllocationSize( Data );
+		INT NewSize = ArrayMax*ElementSize;
+		if( NewSize > OldSize )
+		{
+			void* NewData = GFrameArena.Realloc( Data, NewSize );
+			if( !NewData )
+			{
+				NewData = appMalloc( NewSize );
+				appMemcpy( NewData, Data, OldSize );
+				GFrameArena.Free( Data );
+			}
+			Data = NewData;
+		}
+		return;
+	}
+
 	// Avoid calling appRealloc( NULL, 0 ) as ANSI C mandates returning a valid pointer which is not what we want.
 	if( Data || ArrayMax )
 		Data = appRealloc( Data, ArrayMax*ElementSize );
@@ -1858,6 +1877,7 @@ void appInit( const TCHAR* InCmdLine, FMalloc* InMalloc, FOutputDevice* InLog, F
 {
 	GFileManager = InFileManager;
 	GCallback = InCallbackDevice;
+	GGameThreadId = appGetCurrentThreadId();
 
 	// Init CRC table.
     for( DWORD iCRC=0; iCRC<256; iCRC++ )
@@ -2007,6 +2027,9 @@ void appInit( const TCHAR* InCmdLine, FMalloc* InMalloc, FOutputDevice* InLog, F
 
 	// Memory initalization.
 	GMem.Init( 65536 );
+	INT FrameArenaSize = 1024 * 1024;
+	GConfig->GetInt( TEXT("Core.System"), TEXT("FrameArenaSize"), FrameArenaSize, GEngineIni );
+	GFrameArena.Init( FrameArenaSize );
 
 	// System initialization.
 	GSys = new USystem;
@@ -2034,7 +2057,10 @@ void appInit( const TCHAR* InCmdLine, FMalloc* InMalloc, FOutputDevice* InLog, F
 void appPreExit()
 {
 	debugf( NAME_Exit, TEXT("Preparing to exit.") );
+	// Finalize any trace capture in progress so the file remains readable.
+	GTraceManager.StopCapture();
 	GMem.Exit();
+	GFrameArena.Exit();
 	UObject::StaticExit();
 }
 
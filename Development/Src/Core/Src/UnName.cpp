@@ -220,6 +220,7 @@ FArchive& operator<<( FArchive& Ar, FNameEntry& E )
 
 FNameEntry* AllocateNameEntry( const TCHAR* Name, DWORD Index, DWORD Flags, FNameEntry* HashNext )
 {
+	MEMORY_TAG_SCOPE(Names);
 	FNameEntry* NameEntry = (FNameEntry*)appMalloc( sizeof(FNameEntry) - (NAME_SIZE - appStrlen(Name) - 1)*sizeof(TCHAR) );
 	NameEntry->Index      = Index;
 	NameEntry->Flags      = Flags;
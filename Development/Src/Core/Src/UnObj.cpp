@@ -671,6 +671,127 @@ IMPLEMENT_CLASS(UObject);
 	UObject configuration.
 -----------------------------------------------------------------------------*/
 
+/** Parsed value of a plain property loaded from config, copied over on subsequent loads */
+struct FConfigBlobValue
+{
+	/** Offset of value in object */
+	INT		Offset;
+	/** Size of value in bytes */
+	INT		Size;
+	/** Bits to copy for bool properties, 0 to copy the whole value */
+	DWORD	BitMask;
+	/** Offset of value in FConfigBlob::Data */
+	INT		DataOffset;
+};
+
+/** Property loaded from config that needs to be imported from text on every load, e.g. strings, dynamic arrays and object references */
+struct FConfigBlobFixup
+{
+	/** Property to import */
+	UProperty*		Property;
+	/** Static array element to import, INDEX_NONE for dynamic arrays */
+	INT				ArrayIndex;
+	/** Config value(s) of property, as returned by MultiFind for dynamic arrays */
+	TArray<FString>	Values;
+
+	FConfigBlobFixup( UProperty* InProperty, INT InArrayIndex )
+	:	Property( InProperty )
+	,	ArrayIndex( InArrayIndex )
+	{}
+};
+
+/**
+ * Result of loading the config of a class from a file and section. Subsequent loads copy
+ * the parsed values and only import the remaining properties from text, without looking
+ * up a single key.
+ */
+struct FConfigBlob
+{
+	/** Raw property values */
+	TArray<BYTE>				Data;
+	/** Plain properties whose values are stored in Data */
+	TArray<FConfigBlobValue>	Values;
+	/** Properties imported from text */
+	TArray<FConfigBlobFixup>	Fixups;
+};
+
+/** Identifies the config an object loads, see UObject::LoadConfig */
+struct FConfigBlobKey
+{
+	/** Class whose properties are loaded */
+	UClass*	Class;
+	/** Config file loaded from */
+	FString	Filename;
+	/** Section of per object config, empty otherwise */
+	FString	ObjectSection;
+
+	FConfigBlobKey()
+	{}
+	FConfigBlobKey( UClass* InClass, const FString& InFilename, const FString& InObjectSection )
+	:	Class( InClass )
+	,	Filename( InFilename )
+	,	ObjectSection( InObjectSection )
+	{}
+	UBOOL operator==( const FConfigBlobKey& Other ) const
+	{
+		return Class==Other.Class && Filename==Other.Filename && ObjectSection==Other.ObjectSection;
+	}
+	friend DWORD GetTypeHash( const FConfigBlobKey& Key )
+	{
+		return GetTypeHash(Key.Class) ^ appStrihash(*Key.Filename) ^ (appStrihash(*Key.ObjectSection) * 7);
+	}
+};
+
+/** Maximum number of config blobs kept around, per object config can create one per object */
+#define MAX_CONFIG_BLOBS	4096
+
+/**
+ * Config blobs built by LoadConfig, all built against GConfigBlobsGeneration. Emptied by
+ * PurgeGarbage as they reference classes and names.
+ */
+static TMap<FConfigBlobKey,FConfigBlob> GConfigBlobs;
+/** Config cache generation all blobs in GConfigBlobs were built against */
+static DWORD GConfigBlobsGeneration = 0;
+
+/**
+ * @return TRUE if the value of the passed in property only depends on its config text
+ * and can be copied around as raw bytes, FALSE otherwise
+ */
+static UBOOL IsPlainConfigProperty( UProperty* Property )
+{
+	return	Property->IsA(UByteProperty::StaticClass())
+		||	Property->IsA(UIntProperty::StaticClass())
+		||	Property->IsA(UFloatProperty::StaticClass())
+		||	Property->IsA(UNameProperty::StaticClass())
+		||	Property->IsA(UBoolProperty::StaticClass());
+}
+
+/**
+ * Imports config values into a property of an object.
+ *
+ * @param	Object		Object to import into
+ * @param	Property	Property to import
+ * @param	ArrayIndex	Static array element to import, ignored for dynamic arrays
+ * @param	Values		Config values, as returned by MultiFind for dynamic arrays
+ */
+static void ImportConfigProperty( UObject* Object, UProperty* Property, INT ArrayIndex, const TArray<FString>& Values )
+{
+	UArrayProperty* Array = Cast<UArrayProperty>( Property );
+	if( Array )
+	{
+		FArray* Ptr  = (FArray*)((BYTE*)Object + Property->Offset);
+		INT     Size = Array->Inner->ElementSize;
+		Array->DestroyValue( Ptr );
+		Ptr->AddZeroed( Size, Values.Num() );
+		for( INT i=Values.Num()-1,c=0; i>=0; i--,c++ )
+			Array->Inner->ImportText( *Values(i), (BYTE*)Ptr->GetData() + c*Size, 0, Object );
+	}
+	else
+	{
+		Property->ImportText( *Values(0), (BYTE*)Object + Property->Offset + ArrayIndex*Property->ElementSize, 0, Object );
+	}
+}
+
 //
 // Load configuration.
 //warning: Must be safe on class-default metaobjects.
@@ -691,6 +812,48 @@ void UObject::LoadConfig( UBOOL Propagate, UClass* Class, const TCHAR* InFilenam
 	:	(PerObject && Outer!=GObjTransientPkg)
 	?	GetOuter()->GetName()
 	:	GetClass()->GetConfigName();
+
+	// Blobs built before the config changed can't be used anymore.
+	if( GConfigBlobsGeneration!=GConfig->GetGeneration() )
+	{
+		GConfigBlobs.Empty();
+		GConfigBlobsGeneration = GConfig->GetGeneration();
+	}
+
+	// Copy the result of a previous load if the config hasn't changed since.
+	FConfigBlobKey BlobKey( Class, Filename, PerObject ? FString(GetName()) : FString() );
+	FConfigBlob* Blob = GConfigBlobs.Find( BlobKey );
+	if( Blob )
+	{
+		for( INT i=0; i<Blob->Values.Num(); i++ )
+		{
+			const FConfigBlobValue& Value = Blob->Values(i);
+			BYTE* Dest = (BYTE*)this + Value.Offset;
+			if( Value.BitMask )
+			{
+				BITFIELD Bits;
+				appMemcpy( &Bits, &Blob->Data(Value.DataOffset), sizeof(BITFIELD) );
+				*(BITFIELD*)Dest = (*(BITFIELD*)Dest & ~Value.BitMask) | (Bits & Value.BitMask);
+			}
+			else
+			{
+				appMemcpy( Dest, &Blob->Data(Value.DataOffset), Value.Size );
+			}
+		}
+		if( Blob->Fixups.Num() )
+		{
+			// Copied as importing object references might load classes and recurse, changing GConfigBlobs.
+			TArray<FConfigBlobFixup> Fixups = Blob->Fixups;
+			for( INT i=0; i<Fixups.Num(); i++ )
+			{
+				ImportConfigProperty( this, Fixups(i).Property, Fixups(i).ArrayIndex, Fixups(i).Values );
+			}
+		}
+		return;
+	}
+
+	// Built locally as importing object references might load classes and recurse.
+	FConfigBlob NewBlob;
 	for( TFieldIterator<UProperty,CLASS_IsAUProperty> It(Class); It; ++It )
 	{
 		if( It->PropertyFlags & CPF_Config )
@@ -711,12 +874,9 @@ void UObject::LoadConfig( UBOOL Propagate, UClass* Class, const TCHAR* InFilenam
 					// Only override default properties if there is something to override them with.
 					if( List.Num() )
 					{
-						FArray* Ptr  = (FArray*)((BYTE*)this + It->Offset);
-						INT     Size = Array->Inner->ElementSize;
-						Array->DestroyValue( Ptr );
-						Ptr->AddZeroed( Size, List.Num() );
-						for( INT i=List.Num()-1,c=0; i>=0; i--,c++ )
-							Array->Inner->ImportText( *List(i), (BYTE*)Ptr->GetData() + c*Size, 0, this );
+						ImportConfigProperty( this, *It, 0, List );
+						FConfigBlobFixup* Fixup = new(NewBlob.Fixups) FConfigBlobFixup( *It, INDEX_NONE );
+						Fixup->Values = List;
 					}
 				}
 			}
@@ -741,10 +901,37 @@ void UObject::LoadConfig( UBOOL Propagate, UClass* Class, const TCHAR* InFilenam
 					appSprintf( TempKey, TEXT("%s[%i]"), It->GetName(), i );
 				FString Value;
 				if( GConfig->GetString( *Section, Key, Value, *Filename ) )
-					It->ImportText( *Value, (BYTE*)this + It->Offset + i*It->ElementSize, 0, this );
+				{
+					BYTE* Data = (BYTE*)this + It->Offset + i*It->ElementSize;
+					if( It->ImportText( *Value, Data, 0, this ) && IsPlainConfigProperty( *It ) )
+					{
+						FConfigBlobValue& BlobValue	= NewBlob.Values( NewBlob.Values.AddZeroed() );
+						BlobValue.Offset			= Data - (BYTE*)this;
+						BlobValue.Size				= It->ElementSize;
+						BlobValue.BitMask			= It->IsA(UBoolProperty::StaticClass()) ? ((UBoolProperty*)*It)->BitMask : 0;
+						BlobValue.DataOffset		= NewBlob.Data.Add( It->ElementSize );
+						appMemcpy( &NewBlob.Data(BlobValue.DataOffset), Data, It->ElementSize );
+					}
+					else
+					{
+						// Everything else, including values that failed to import, is imported from text on every load.
+						FConfigBlobFixup* Fixup = new(NewBlob.Fixups) FConfigBlobFixup( *It, i );
+						new(Fixup->Values) FString( Value );
+					}
+				}
 			}
 		}
 	}
+
+	// Importing might have changed the config, in which case the blob is already stale.
+	if( GConfigBlobsGeneration==GConfig->GetGeneration() )
+	{
+		if( GConfigBlobs.Num()>=MAX_CONFIG_BLOBS )
+		{
+			GConfigBlobs.Empty();
+		}
+		GConfigBlobs.Set( BlobKey, NewBlob );
+	}
 }
 
 static void LoadLocalizedProp( UProperty* Prop, const TCHAR *IntName, const TCHAR *SectionName, const TCHAR *KeyPrefix, UObject* Parent, BYTE* Data );
@@ -1545,6 +1732,31 @@ struct FSubItem
 IMPLEMENT_COMPARE_CONSTREF( FSubItem, UnObj, { return B.Max - A.Max; } );
 IMPLEMENT_COMPARE_CONSTREF( FItem, UnObj, { return B.Max - A.Max; } );
 
+/**
+ * Writes the current script profile to CSV files in the profiling directory.
+ *
+ * @param Ar	Output device to log result to
+ */
+static void WriteScriptProfile( FOutputDevice& Ar )
+{
+	// Create unique filename based on time.
+	INT Year, Month, DayOfWeek, Day, Hour, Min, Sec, MSec;
+	appSystemTime( Year, Month, DayOfWeek, Day, Hour, Min, Sec, MSec );
+	FString	BaseFilename = FString::Printf(TEXT("%sProfiling\\%sScript-%i.%02i.%02i-%02i.%02i.%02i"), *appGameDir(), GGameName, Year, Month, Day, Hour, Min, Sec );
+
+	// Create the directory in case it doesn't exist yet.
+	GFileManager->MakeDirectory( *(appGameDir() + TEXT("Profiling\\")) );
+
+	if( GScriptCallGraph->WriteCSV( BaseFilename ) )
+	{
+		Ar.Logf( TEXT("Wrote script profile to %s-*.csv"), *BaseFilename );
+	}
+	else
+	{
+		Ar.Logf( TEXT("Failed to write script profile to %s-*.csv"), *BaseFilename );
+	}
+}
+
 UBOOL UObject::StaticExec( const TCHAR* Cmd, FOutputDevice& Ar )
 {
 	const TCHAR *Str = Cmd;
@@ -1811,37 +2023,49 @@ UBOOL UObject::StaticExec( const TCHAR* Cmd, FOutputDevice& Ar )
 	{
 		if( ParseCommand(&Str,TEXT("START")) )
 		{
-			delete GScriptCallGraph;
-			GScriptCallGraph = new FScriptCallGraph( 32 * 1024 * 1024 );
+			// Memory limit of the call tree in KByte, defaulting to 32 MByte.
+			DWORD MemoryLimit = 32 * 1024;
+			Parse( Str, TEXT("MEMORY="), MemoryLimit );
+
+			// Restarting keeps the call graph so calls in flight still find themselves on its stack.
+			if( GScriptCallGraph )
+				GScriptCallGraph->Reset( Max<DWORD>( MemoryLimit, 1 ) * 1024 );
+			else
+				GScriptCallGraph = new FScriptCallGraph( Max<DWORD>( MemoryLimit, 1 ) * 1024 );
 			return 1;
 		}
 		else if( ParseCommand(&Str,TEXT("STOP")) )
 		{
 			if( GScriptCallGraph )
 			{
-				GScriptCallGraph->EmitEnd();
-
-				// Create unique filename based on time.
-				INT Year, Month, DayOfWeek, Day, Hour, Min, Sec, MSec;
-				appSystemTime( Year, Month, DayOfWeek, Day, Hour, Min, Sec, MSec );
-				FString	Filename = FString::Printf(TEXT("%sProfiling\\%sGame-%i.%02i.%02i-%02i.%02i.%02i.uprof"), *appGameDir(), GGameName, Year, Month, Day, Hour, Min, Sec );
-
-				// Create the directory in case it doesn't exist yet.
-				GFileManager->MakeDirectory( *(appGameDir() + TEXT("Profiling\\")) );
-
-				// Create a file writer and serialize the script profiling data to it.
-				FArchive* Archive = GFileManager->CreateFileWriter( *Filename );
-				if( Archive )
-				{
-					GScriptCallGraph->Serialize( *Archive );
-					delete Archive;
-				}
-
+				WriteScriptProfile( Ar );
 				delete GScriptCallGraph;
 				GScriptCallGraph = NULL;
 			}
 			return 1;
 		}
+		else if( ParseCommand(&Str,TEXT("CSV")) )
+		{
+			if( GScriptCallGraph )
+			{
+				WriteScriptProfile( Ar );
+			}
+			return 1;
+		}
+		else if( ParseCommand(&Str,TEXT("REPORT")) )
+		{
+			if( GScriptCallGraph )
+			{
+				INT Count = 20;
+				Parse( Str, TEXT("N="), Count );
+				GScriptCallGraph->Report( Ar, Count, ParseParam( Str, TEXT("INCLUSIVE") ) );
+			}
+			else
+			{
+				Ar.Logf( TEXT("Script profiling isn't running, use PROFILESCRIPT START") );
+			}
+			return 1;
+		}
 		else if( ParseCommand(&Str,TEXT("RESET"))  )
 		{
 			if( GScriptCallGraph )
@@ -1850,6 +2074,97 @@ UBOOL UObject::StaticExec( const TCHAR* Cmd, FOutputDevice& Ar )
 		}
 		return 0;
 	}
+	else if( ParseCommand(&Str,TEXT("TRACE")) )
+	{
+		if( ParseCommand(&Str,TEXT("START")) )
+		{
+			DWORD BufferSize	= TRACE_DEFAULT_BUFFER_SIZE;
+			DWORD MaxFrames		= 0;
+			Parse( Str, TEXT("BUFFER="), BufferSize );
+			Parse( Str, TEXT("FRAMES="), MaxFrames );
+
+			// Create unique filename based on time.
+			INT Year, Month, DayOfWeek, Day, Hour, Min, Sec, MSec;
+			appSystemTime( Year, Month, DayOfWeek, Day, Hour, Min, Sec, MSec );
+			FString	Filename = FString::Printf(TEXT("%sProfiling\\%sGame-%i.%02i.%02i-%02i.%02i.%02i.json"), *appGameDir(), GGameName, Year, Month, Day, Hour, Min, Sec );
+
+			// Create the directory in case it doesn't exist yet.
+			GFileManager->MakeDirectory( *(appGameDir() + TEXT("Profiling\\")) );
+
+			if( !GTraceManager.StartCapture( *Filename, BufferSize, MaxFrames ) )
+			{
+				Ar.Logf( TEXT("Failed to create trace capture file %s"), *Filename );
+			}
+			return 1;
+		}
+		else if( ParseCommand(&Str,TEXT("STOP")) )
+		{
+			GTraceManager.StopCapture();
+			return 1;
+		}
+		GTraceManager.DumpStatus( Ar );
+		return 1;
+	}
+	else if( ParseCommand(&Str,TEXT("MEMTAG")) )
+	{
+#if TRACK_MEMORY_TAGS
+		INT Count = 30;
+		Parse( Str, TEXT("N="), Count );
+		if( ParseCommand(&Str,TEXT("SNAPSHOT")) )
+		{
+			GMemoryTagTracker.TakeSnapshot();
+			Ar.Logf( TEXT("Took memory tag snapshot.") );
+		}
+		else if( ParseCommand(&Str,TEXT("DIFF")) )
+		{
+			GMemoryTagTracker.ReportDiff( Ar, Count );
+		}
+		else if( ParseCommand(&Str,TEXT("SAMPLE")) )
+		{
+			DWORD SampleRate = 0;
+			Parse( Str, TEXT("RATE="), SampleRate );
+			GMemoryTagTracker.SetSampleRate( SampleRate );
+			if( SampleRate )
+			{
+				Ar.Logf( TEXT("Recording callstacks of 1 in %u allocations."), SampleRate );
+			}
+			else
+			{
+				Ar.Logf( TEXT("Stopped recording allocation callstacks.") );
+			}
+		}
+		else if( ParseCommand(&Str,TEXT("SAMPLES")) )
+		{
+			GMemoryTagTracker.ReportSamples( Ar, Count );
+		}
+		else if( ParseCommand(&Str,TEXT("CSV")) )
+		{
+			// Create unique filename based on time.
+			INT Year, Month, DayOfWeek, Day, Hour, Min, Sec, MSec;
+			appSystemTime( Year, Month, DayOfWeek, Day, Hour, Min, Sec, MSec );
+			FString	Filename = FString::Printf(TEXT("%sProfiling\\%sGame-MemTags-%i.%02i.%02i-%02i.%02i.%02i.csv"), *appGameDir(), GGameName, Year, Month, Day, Hour, Min, Sec );
+			GFileManager->MakeDirectory( *(appGameDir() + TEXT("Profiling\\")) );
+
+			if( GMemoryTagTracker.WriteCSV( *Filename ) )
+			{
+				Ar.Logf( TEXT("Wrote memory tags to %s"), *Filename );
+			}
+			else
+			{
+				Ar.Logf( TEXT("Failed to write memory tags to %s"), *Filename );
+			}
+		}
+		else
+		{
+			FString SortBy( TEXT("LIVE") );
+			Parse( Str, TEXT("SORT="), SortBy );
+			GMemoryTagTracker.Report( Ar, Count, *SortBy );
+		}
+#else
+		Ar.Logf( TEXT("Memory tagging is disabled, rebuild with TRACK_MEMORY_TAGS=1.") );
+#endif
+		return 1;
+	}
 	else
 	{
 		return 0; // Not executed
@@ -2145,6 +2460,8 @@ UObject* UObject::LoadPackage( UObject* InOuter, const TCHAR* Filename, DWORD Lo
     if( *Filename == '\0' )
         return NULL;
 
+	MEMORY_TAG_SCOPE(Packages);
+
 	// Try to load.
 	BeginLoad();
 	try
@@ -2491,14 +2808,10 @@ UBOOL UObject::SavePackage( UObject* InOuter, UObject* Base, DWORD TopLevelFlags
 	if( Cast<UPackage>( InOuter ) )
 		Cast<UPackage>( InOuter )->PackageFlags |= PKG_AllowDownload;
 
-	// Make temp file.
+	// Make temp file, named after the package so processes saving different packages to the same directory don't collide.
 	TCHAR TempFilename[256];
-	appStrncpy( TempFilename, Filename, ARRAY_COUNT(TempFilename) );
-	INT c = appStrlen(TempFilename);
-	while( c>0 && TempFilename[c-1]!=PATH_SEPARATOR[0] && TempFilename[c-1]!='/' && TempFilename[c-1]!=':' )
-		c--;
-	TempFilename[c]=0;
-	appStrcat( TempFilename, TEXT("Save.tmp") );
+	appStrncpy( TempFilename, Filename, ARRAY_COUNT(TempFilename) - 4 );
+	appStrcat( TempFilename, TEXT(".tmp") );
 
 	// Init.
 	GWarn->StatusUpdatef( 0, 0, *LocalizeProgress(TEXT("Saving"),TEXT("Core")), Filename );
@@ -3040,6 +3353,7 @@ UObject* UObject::StaticAllocateObject
 	if( !Obj )
 	{
 		// Create a new object.
+		MEMORY_TAG_CLASS_SCOPE( InClass );
 		Obj = Ptr ? Ptr : (UObject*)appMalloc( Align(InClass->GetPropertiesSize(),InClass->GetMinAlignment()) );
 	}
 	else
@@ -3496,6 +3810,13 @@ void UObject::PurgeGarbage()
 
 	GIsGarbageCollecting = 1; // Set 'I'm garbage collecting' flag - might be checked inside UObject::Destropy etc.
 
+	// Config blobs reference classes and names that might be about to go away.
+	GConfigBlobs.Empty();
+
+	// Function addresses may be reused once the functions are destroyed.
+	if( GScriptCallGraph )
+		GScriptCallGraph->NotifyGC();
+
 	// Notify script debugger to clear its stack, since all FFrames will be destroyed.
 	if ( GDebugger )
 		GDebugger->NotifyGC();
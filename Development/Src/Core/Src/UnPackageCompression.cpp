@@ -0,0 +1,490 @@
+/*=============================================================================
+	UnPackageCompression.cpp: Packages stored in independently compressed chunks.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "CorePrivate.h"
+#include "../../zlib/zlib.h"
+
+/*-----------------------------------------------------------------------------
+	FChunkDecompressWork.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Queued work decompressing a chunk slot of a FArchiveCompressedPackageReader.
+ */
+class FChunkDecompressWork : public FQueuedWork
+{
+	/** Slot to decompress */
+	FArchiveCompressedPackageReader::FChunkSlot* Slot;
+
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param InSlot The slot to decompress
+	 */
+	FChunkDecompressWork(FArchiveCompressedPackageReader::FChunkSlot* InSlot)
+	:	Slot(InSlot)
+	{}
+
+	// FQueuedWork interface.
+
+	virtual void DoWork(void)
+	{
+		Slot->bFailed = !Slot->Decompress();
+	}
+	virtual void Abandon(void)
+	{
+		Slot->bFailed = 1;
+		Slot->DoneEvent->Trigger();
+		delete this;
+	}
+	virtual void Dispose(void)
+	{
+		Slot->DoneEvent->Trigger();
+		delete this;
+	}
+};
+
+/*-----------------------------------------------------------------------------
+	FArchiveCompressedPackageReader.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Decompresses CompressedData into UncompressedData.
+ *
+ * @return	TRUE if successful
+ */
+UBOOL FArchiveCompressedPackageReader::FChunkSlot::Decompress()
+{
+	uLongf DestSize = UncompressedSize;
+	return	uncompress( UncompressedData.GetData(), &DestSize, CompressedData.GetData(), CompressedSize ) == Z_OK
+		&&	DestSize == (uLongf)UncompressedSize;
+}
+
+/**
+ * Constructor.
+ *
+ * @param	InReader	Reader of the compressed file, owned by this archive from now on
+ * @param	InChunks	Chunk table of the package summary
+ * @param	InError		Device errors are logged to
+ */
+FArchiveCompressedPackageReader::FArchiveCompressedPackageReader( FArchive* InReader, const TArray<FCompressedChunk>& InChunks, FOutputDevice* InError )
+:	Reader			( InReader )
+,	Chunks			( InChunks )
+,	Error			( InError )
+,	Pos				( 0 )
+,	Size			( 0 )
+,	CurrentChunk	( INDEX_NONE )
+,	CurrentSlot		( NULL )
+,	UseCount		( 0 )
+{
+	ArIsLoading = ArIsPersistent = 1;
+
+	for( INT ChunkIndex=0; ChunkIndex<Chunks.Num(); ChunkIndex++ )
+	{
+		const FCompressedChunk& Chunk = Chunks(ChunkIndex);
+		if( Chunk.UncompressedOffset != Size || Chunk.UncompressedSize <= 0 || Chunk.CompressedSize <= 0 )
+		{
+			ArIsError = 1;
+			Error->Logf( TEXT("Corrupt chunk table: Chunk=%i/%i UncompressedOffset=%i Expected=%i"), ChunkIndex, Chunks.Num(), Chunk.UncompressedOffset, Size );
+			break;
+		}
+		Size += Chunk.UncompressedSize;
+	}
+
+	for( INT SlotIndex=0; SlotIndex<PACKAGE_CHUNK_SLOTS; SlotIndex++ )
+	{
+		FChunkSlot& Slot		= Slots[SlotIndex];
+		Slot.ChunkIndex			= INDEX_NONE;
+		Slot.LastUse			= 0;
+		Slot.bPending			= 0;
+		Slot.bFailed			= 0;
+		Slot.CompressedSize		= 0;
+		Slot.UncompressedSize	= 0;
+		Slot.DoneEvent			= GThreadPool ? GSynchronizeFactory->CreateSynchEvent() : NULL;
+	}
+}
+
+/**
+ * Destructor, waiting for outstanding decompression and deleting the file reader.
+ */
+FArchiveCompressedPackageReader::~FArchiveCompressedPackageReader()
+{
+	for( INT SlotIndex=0; SlotIndex<PACKAGE_CHUNK_SLOTS; SlotIndex++ )
+	{
+		WaitForSlot( Slots[SlotIndex] );
+		if( Slots[SlotIndex].DoneEvent )
+		{
+			GSynchronizeFactory->Destroy( Slots[SlotIndex].DoneEvent );
+		}
+	}
+	delete Reader;
+}
+
+/**
+ * Returns the index of the chunk holding an uncompressed offset, or INDEX_NONE.
+ */
+INT FArchiveCompressedPackageReader::FindChunk( INT Offset ) const
+{
+	INT Low = 0;
+	INT High = Chunks.Num() - 1;
+	while( Low <= High )
+	{
+		const INT Mid = (Low + High) / 2;
+		const FCompressedChunk& Chunk = Chunks(Mid);
+		if( Offset < Chunk.UncompressedOffset )
+		{
+			High = Mid - 1;
+		}
+		else if( Offset >= Chunk.UncompressedOffset + Chunk.UncompressedSize )
+		{
+			Low = Mid + 1;
+		}
+		else
+		{
+			return Mid;
+		}
+	}
+	return INDEX_NONE;
+}
+
+/**
+ * Waits for the decompression of a slot to finish.
+ */
+void FArchiveCompressedPackageReader::WaitForSlot( FChunkSlot& Slot )
+{
+	if( Slot.bPending )
+	{
+		Slot.DoneEvent->Wait();
+		Slot.bPending = 0;
+	}
+}
+
+/**
+ * Makes sure a chunk is held by a slot, reading it and starting decompression if it
+ * isn't. Evicts the least recently requested slot other than the current chunk's.
+ *
+ * @return	slot holding the chunk, or NULL if reading the compressed data failed
+ */
+FArchiveCompressedPackageReader::FChunkSlot* FArchiveCompressedPackageReader::RequestChunk( INT ChunkIndex )
+{
+	FChunkSlot* Slot = NULL;
+	for( INT SlotIndex=0; SlotIndex<PACKAGE_CHUNK_SLOTS; SlotIndex++ )
+	{
+		FChunkSlot& Candidate = Slots[SlotIndex];
+		if( Candidate.ChunkIndex == ChunkIndex )
+		{
+			Candidate.LastUse = ++UseCount;
+			return &Candidate;
+		}
+		if( &Candidate != CurrentSlot && (!Slot || Candidate.LastUse < Slot->LastUse) )
+		{
+			Slot = &Candidate;
+		}
+	}
+	check(Slot);
+
+	// The evicted chunk may still be in flight.
+	WaitForSlot( *Slot );
+
+	const FCompressedChunk& Chunk = Chunks(ChunkIndex);
+	Slot->ChunkIndex		= INDEX_NONE;
+	Slot->LastUse			= ++UseCount;
+	Slot->bFailed			= 0;
+	Slot->CompressedSize	= Chunk.CompressedSize;
+	Slot->UncompressedSize	= Chunk.UncompressedSize;
+	if( Slot->CompressedData.Num() < Chunk.CompressedSize )
+	{
+		Slot->CompressedData.Add( Chunk.CompressedSize - Slot->CompressedData.Num() );
+	}
+	if( Slot->UncompressedData.Num() < Chunk.UncompressedSize )
+	{
+		Slot->UncompressedData.Add( Chunk.UncompressedSize - Slot->UncompressedData.Num() );
+	}
+
+	// Read on the calling thread so the file is only ever accessed by it.
+	Reader->Seek( Chunk.CompressedOffset );
+	Reader->Serialize( Slot->CompressedData.GetData(), Chunk.CompressedSize );
+	if( Reader->IsError() )
+	{
+		ArIsError = 1;
+		Error->Logf( TEXT("Failed reading compressed chunk %i/%i"), ChunkIndex, Chunks.Num() );
+		return NULL;
+	}
+	Slot->ChunkIndex = ChunkIndex;
+
+	if( GThreadPool )
+	{
+		Slot->bPending = 1;
+		GThreadPool->AddQueuedWork( new FChunkDecompressWork(Slot) );
+	}
+	else
+	{
+		Slot->bFailed = !Slot->Decompress();
+	}
+	return Slot;
+}
+
+/**
+ * Makes a chunk the one being read from, prefetching the chunks following it.
+ *
+ * @return	FALSE if the chunk couldn't be read or decompressed
+ */
+UBOOL FArchiveCompressedPackageReader::SetCurrentChunk( INT ChunkIndex )
+{
+	// Clear the current chunk first so its slot may be reused.
+	CurrentChunk	= INDEX_NONE;
+	CurrentSlot		= NULL;
+
+	FChunkSlot* Slot = RequestChunk( ChunkIndex );
+	if( !Slot )
+	{
+		return 0;
+	}
+
+	// Keep the slot from being evicted by the prefetches.
+	CurrentSlot = Slot;
+	UBOOL bSucceeded = 1;
+	for( INT PrefetchIndex=ChunkIndex+1; PrefetchIndex<=ChunkIndex+PACKAGE_CHUNK_PREFETCH && PrefetchIndex<Chunks.Num() && bSucceeded; PrefetchIndex++ )
+	{
+		bSucceeded = RequestChunk( PrefetchIndex ) != NULL;
+	}
+
+	WaitForSlot( *Slot );
+	if( Slot->bFailed )
+	{
+		// Drop the chunk so it is read again on the next attempt.
+		Slot->ChunkIndex	= INDEX_NONE;
+		ArIsError			= 1;
+		Error->Logf( TEXT("Failed decompressing chunk %i/%i"), ChunkIndex, Chunks.Num() );
+		bSucceeded			= 0;
+	}
+	if( !bSucceeded )
+	{
+		CurrentSlot = NULL;
+		return 0;
+	}
+	CurrentChunk = ChunkIndex;
+	return 1;
+}
+
+void FArchiveCompressedPackageReader::Serialize( void* V, INT Length )
+{
+	while( Length>0 )
+	{
+		if( !CurrentSlot || Pos < Chunks(CurrentChunk).UncompressedOffset || Pos >= Chunks(CurrentChunk).UncompressedOffset + Chunks(CurrentChunk).UncompressedSize )
+		{
+			const INT ChunkIndex = FindChunk( Pos );
+			if( ChunkIndex == INDEX_NONE )
+			{
+				ArIsError = 1;
+				Error->Logf( TEXT("ReadFile beyond EOF %i+%i/%i"), Pos, Length, Size );
+				return;
+			}
+			if( !SetCurrentChunk(ChunkIndex) )
+			{
+				return;
+			}
+		}
+		const FCompressedChunk& Chunk = Chunks(CurrentChunk);
+		const INT Offset = Pos - Chunk.UncompressedOffset;
+		const INT Copy = Min( Length, Chunk.UncompressedSize - Offset );
+		appMemcpy( V, &CurrentSlot->UncompressedData(Offset), Copy );
+		Pos    += Copy;
+		Length -= Copy;
+		V       = (BYTE*)V + Copy;
+	}
+}
+
+void FArchiveCompressedPackageReader::Seek( INT InPos )
+{
+	check(InPos>=0);
+	check(InPos<=Size);
+	Pos = InPos;
+}
+
+INT FArchiveCompressedPackageReader::Tell()
+{
+	return Pos;
+}
+
+INT FArchiveCompressedPackageReader::TotalSize()
+{
+	return Size;
+}
+
+void FArchiveCompressedPackageReader::Precache( INT HintCount )
+{
+	// Start decompressing the chunks of the range, leaving the current chunk's slot alone.
+	const INT FirstChunk = FindChunk( Pos );
+	if( FirstChunk == INDEX_NONE )
+	{
+		return;
+	}
+	const INT End = HintCount >= Size - Pos ? Size : Pos + Max( HintCount, 1 );
+	const INT LastChunk = Min( FindChunk(End - 1), FirstChunk + PACKAGE_CHUNK_SLOTS - 2 );
+	for( INT ChunkIndex=FirstChunk; ChunkIndex<=LastChunk; ChunkIndex++ )
+	{
+		if( !RequestChunk(ChunkIndex) )
+		{
+			return;
+		}
+	}
+}
+
+UBOOL FArchiveCompressedPackageReader::Close()
+{
+	for( INT SlotIndex=0; SlotIndex<PACKAGE_CHUNK_SLOTS; SlotIndex++ )
+	{
+		WaitForSlot( Slots[SlotIndex] );
+	}
+	return Reader->Close() && !ArIsError;
+}
+
+/*-----------------------------------------------------------------------------
+	Package compression.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Loop body compressing the chunks of a package.
+ */
+class FCompressChunksBody : public FParallelForBody
+{
+public:
+	/** Uncompressed package */
+	const BYTE*					Src;
+	/** Compressed chunks, each at a multiple of MaxCompressedSize */
+	BYTE*						Dest;
+	/** Space reserved for each compressed chunk */
+	INT							MaxCompressedSize;
+	/** Chunk table, CompressedSize is filled in */
+	TArray<FCompressedChunk>*	Chunks;
+	/** Number of chunks zlib failed on */
+	FThreadSafeCounter			NumFailed;
+
+	virtual void Execute(INT Index)
+	{
+		FCompressedChunk& Chunk = (*Chunks)(Index);
+		uLongf DestSize = MaxCompressedSize;
+		if( compress2( Dest + Index * MaxCompressedSize, &DestSize, Src + Chunk.UncompressedOffset, Chunk.UncompressedSize, Z_BEST_COMPRESSION ) == Z_OK )
+		{
+			Chunk.CompressedSize = DestSize;
+		}
+		else
+		{
+			NumFailed.Increment();
+		}
+	}
+};
+
+/**
+ * Stores a package split into independently zlib compressed chunks, along with a chunk
+ * table in its summary, so ULinkerLoad can seek in it without decompressing the whole
+ * file. Chunks are compressed in parallel.
+ *
+ * @param	SrcFilename		Package to compress
+ * @param	DestFilename	File the compressed package is written to, must differ from SrcFilename
+ * @param	ChunkSize		Size of the uncompressed chunks
+ * @return	TRUE if successful, FALSE if the source isn't an uncompressed package or IO failed
+ */
+UBOOL appCompressPackage( const TCHAR* SrcFilename, const TCHAR* DestFilename, INT ChunkSize )
+{
+	check(ChunkSize>0);
+
+	TArray<BYTE> Uncompressed;
+	if( !appLoadFileToArray(Uncompressed, SrcFilename) )
+	{
+		debugf( NAME_Warning, TEXT("Failed to read %s"), SrcFilename );
+		return 0;
+	}
+
+	// Only plain packages can be compressed, the uncompressed summary stays in the first chunk.
+	if( Uncompressed.Num() < (INT)sizeof(INT) || *(INT*)Uncompressed.GetData() != PACKAGE_FILE_TAG )
+	{
+		debugf( NAME_Warning, TEXT("%s is not a package"), SrcFilename );
+		return 0;
+	}
+	FPackageFileSummary Summary;
+	FBufferReader SummaryReader( Uncompressed );
+	SummaryReader << Summary;
+	if( SummaryReader.IsError() )
+	{
+		debugf( NAME_Warning, TEXT("%s has a truncated summary"), SrcFilename );
+		return 0;
+	}
+	if( Summary.PackageFlags & PKG_StoreCompressed )
+	{
+		debugf( NAME_Warning, TEXT("%s is already compressed"), SrcFilename );
+		return 0;
+	}
+
+	// Compress the chunks, reserving the worst case zlib size for each so they can be done in parallel.
+	const INT NumChunks = (Uncompressed.Num() + ChunkSize - 1) / ChunkSize;
+	Summary.PackageFlags |= PKG_StoreCompressed;
+	Summary.CompressedChunks.Empty( NumChunks );
+	for( INT ChunkIndex=0; ChunkIndex<NumChunks; ChunkIndex++ )
+	{
+		FCompressedChunk* Chunk		= new(Summary.CompressedChunks)FCompressedChunk;
+		Chunk->UncompressedOffset	= ChunkIndex * ChunkSize;
+		Chunk->UncompressedSize		= Min( ChunkSize, Uncompressed.Num() - Chunk->UncompressedOffset );
+		Chunk->CompressedOffset		= 0;
+		Chunk->CompressedSize		= 0;
+	}
+
+	FCompressChunksBody Body;
+	TArray<BYTE> Compressed;
+	Body.MaxCompressedSize	= ChunkSize + ChunkSize / 100 + 12;
+	Compressed.Add( NumChunks * Body.MaxCompressedSize );
+	Body.Src				= Uncompressed.GetData();
+	Body.Dest				= Compressed.GetData();
+	Body.Chunks				= &Summary.CompressedChunks;
+	appParallelFor( NumChunks, Body );
+	if( Body.NumFailed.GetValue() )
+	{
+		debugf( NAME_Warning, TEXT("Failed compressing %i chunks of %s"), Body.NumFailed.GetValue(), SrcFilename );
+		return 0;
+	}
+
+	// The chunks follow the summary, whose size doesn't depend on the offsets stored in it.
+	TArray<BYTE> SummaryData;
+	FBufferWriter SizeWriter( SummaryData );
+	SizeWriter << Summary;
+	INT CompressedOffset = SummaryData.Num();
+	for( INT ChunkIndex=0; ChunkIndex<NumChunks; ChunkIndex++ )
+	{
+		FCompressedChunk& Chunk	= Summary.CompressedChunks(ChunkIndex);
+		Chunk.CompressedOffset	= CompressedOffset;
+		CompressedOffset		+= Chunk.CompressedSize;
+	}
+
+	FArchive* Writer = GFileManager->CreateFileWriter( DestFilename );
+	if( !Writer )
+	{
+		debugf( NAME_Warning, TEXT("Failed to create %s"), DestFilename );
+		return 0;
+	}
+	*Writer << Summary;
+	check(Writer->Tell()==SummaryData.Num());
+	for( INT ChunkIndex=0; ChunkIndex<NumChunks; ChunkIndex++ )
+	{
+		Writer->Serialize( Body.Dest + ChunkIndex * Body.MaxCompressedSize, Summary.CompressedChunks(ChunkIndex).CompressedSize );
+	}
+	const UBOOL bSucceeded = Writer->Close();
+	delete Writer;
+	if( !bSucceeded )
+	{
+		debugf( NAME_Warning, TEXT("Failed writing %s"), DestFilename );
+		GFileManager->Delete( DestFilename );
+		return 0;
+	}
+
+	debugf( NAME_Log, TEXT("Compressed %s into %i chunks: %i -> %i bytes"), SrcFilename, NumChunks, Uncompressed.Num(), CompressedOffset );
+	return 1;
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
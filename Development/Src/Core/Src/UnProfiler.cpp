@@ -0,0 +1,296 @@
+/*=============================================================================
+	UnProfiler.cpp: Hierarchical, thread aware frame profiler.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "CorePrivate.h"
+
+/** Global trace manager */
+FTraceManager GTraceManager;
+
+/**
+ * Escapes characters that aren't allowed in JSON strings. Labels rarely contain
+ * any so the common case doesn't allocate.
+ *
+ * @param	Label	Label to escape
+ * @return	escaped label
+ */
+static FString EscapeTraceLabel( const TCHAR* Label )
+{
+	if( !appStrchr( Label, '"' ) && !appStrchr( Label, '\\' ) )
+	{
+		return FString( Label );
+	}
+	FString Result;
+	for( const TCHAR* Char=Label; *Char; Char++ )
+	{
+		if( *Char == '"' || *Char == '\\' )
+		{
+			Result += TEXT("\\");
+		}
+		Result += FString::Printf( TEXT("%c"), *Char );
+	}
+	return Result;
+}
+
+/*-----------------------------------------------------------------------------
+	FTraceManager implementation.
+-----------------------------------------------------------------------------*/
+
+/** Constructor, initializing all members. */
+FTraceManager::FTraceManager()
+:	bIsCapturing( FALSE ),
+	TlsSlot( INDEX_NONE ),
+	FirstBuffer( NULL ),
+	BufferListSynch( NULL ),
+	CaptureArchive( NULL ),
+	CaptureStartCycles( 0 ),
+	CaptureThreadId( 0 ),
+	BufferSize( TRACE_DEFAULT_BUFFER_SIZE ),
+	FrameCount( 0 ),
+	MaxFrames( 0 ),
+	EventCount( 0 ),
+	bWroteEvent( FALSE )
+{
+	CaptureFilename[0] = 0;
+}
+
+/**
+ * Starts a new capture, stopping the current one if needed.
+ *
+ * @param	Filename		File to stream the capture to
+ * @param	InBufferSize	Number of events per thread ring buffer, rounded up to a power of two
+ * @param	InMaxFrames		Number of frames after which the capture stops itself, 0 for no limit
+ * @return	TRUE if capture was started, FALSE if the output file couldn't be created
+ */
+UBOOL FTraceManager::StartCapture( const TCHAR* Filename, DWORD InBufferSize, DWORD InMaxFrames )
+{
+	StopCapture();
+
+	// Lazily create synchronization objects as the factory isn't set up during static initialization.
+	if( TlsSlot == (DWORD) INDEX_NONE )
+	{
+		TlsSlot = appAllocTlsSlot();
+	}
+	if( !BufferListSynch )
+	{
+		BufferListSynch = GSynchronizeFactory->CreateCriticalSection();
+	}
+
+	CaptureArchive = GFileManager->CreateFileWriter( Filename );
+	if( !CaptureArchive )
+	{
+		return FALSE;
+	}
+	appStrncpy( CaptureFilename, Filename, ARRAY_COUNT(CaptureFilename) );
+
+	// Buffers created by a previous capture keep their size, only new ones pick up the change.
+	BufferSize			= 1 << appCeilLogTwo( Max<DWORD>( InBufferSize, 1024 ) );
+	MaxFrames			= InMaxFrames;
+	FrameCount			= 0;
+	EventCount			= 0;
+	bWroteEvent			= FALSE;
+	CaptureThreadId		= appGetCurrentThreadId();
+
+	// Discard anything that was recorded by scopes that straddled the previous capture.
+	{
+		FScopeLock ScopeLock( BufferListSynch );
+		for( FTraceThreadBuffer* Buffer=FirstBuffer; Buffer; Buffer=Buffer->Next )
+		{
+			Buffer->ReadCount		= Buffer->WriteCount;
+			Buffer->DroppedCount	= 0;
+		}
+	}
+
+	WriteString( TEXT("{\"traceEvents\":[\n") );
+
+	CaptureStartCycles	= appCycles64();
+	bIsCapturing		= TRUE;
+
+	debugf( NAME_Log, TEXT("Started trace capture to %s"), CaptureFilename );
+	return TRUE;
+}
+
+/**
+ * Stops the current capture, if any, drains all buffers and finalizes the output file.
+ */
+void FTraceManager::StopCapture()
+{
+	if( !bIsCapturing )
+	{
+		return;
+	}
+	bIsCapturing = FALSE;
+
+	// Drain what has been recorded so far and emit thread name meta data.
+	DWORD DroppedCount = 0;
+	{
+		FScopeLock ScopeLock( BufferListSynch );
+		for( FTraceThreadBuffer* Buffer=FirstBuffer; Buffer; Buffer=Buffer->Next )
+		{
+			DrainBuffer( Buffer );
+			DroppedCount += Buffer->DroppedCount;
+
+			FString ThreadName = Buffer->ThreadId == CaptureThreadId ? FString(TEXT("Game thread")) : FString::Printf( TEXT("Thread %u"), Buffer->ThreadId );
+			WriteString( *FString::Printf( TEXT("%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":\"%s\"}}"),
+				bWroteEvent ? TEXT(",\n") : TEXT(""),
+				Buffer->ThreadId,
+				*ThreadName ) );
+			bWroteEvent = TRUE;
+		}
+	}
+	WriteString( TEXT("\n]}\n") );
+
+	delete CaptureArchive;
+	CaptureArchive = NULL;
+
+	debugf( NAME_Log, TEXT("Stopped trace capture to %s: %u frames, %u events, %u dropped"), CaptureFilename, FrameCount, EventCount, DroppedCount );
+}
+
+/**
+ * Drains all thread buffers to the capture file. Needs to be called once per frame
+ * by the thread that started the capture.
+ */
+void FTraceManager::AdvanceFrame()
+{
+	if( !bIsCapturing )
+	{
+		return;
+	}
+
+	{
+		FScopeLock ScopeLock( BufferListSynch );
+		for( FTraceThreadBuffer* Buffer=FirstBuffer; Buffer; Buffer=Buffer->Next )
+		{
+			DrainBuffer( Buffer );
+		}
+	}
+
+	FrameCount++;
+	if( MaxFrames && FrameCount >= MaxFrames )
+	{
+		StopCapture();
+	}
+}
+
+/**
+ * Logs the status of the current capture.
+ *
+ * @param	Ar	Output device to log to
+ */
+void FTraceManager::DumpStatus( FOutputDevice& Ar )
+{
+	if( !bIsCapturing )
+	{
+		Ar.Logf( TEXT("No trace capture in progress.") );
+		return;
+	}
+
+	INT ThreadCount = 0;
+	DWORD DroppedCount = 0;
+	{
+		FScopeLock ScopeLock( BufferListSynch );
+		for( FTraceThreadBuffer* Buffer=FirstBuffer; Buffer; Buffer=Buffer->Next )
+		{
+			ThreadCount++;
+			DroppedCount += Buffer->DroppedCount;
+		}
+	}
+	Ar.Logf( TEXT("Capturing to %s: %u frames, %u events, %i threads, %u dropped events (buffer size %u)"), CaptureFilename, FrameCount, EventCount, ThreadCount, DroppedCount, BufferSize );
+}
+
+/** Creates and registers the event buffer of the calling thread. */
+FTraceThreadBuffer* FTraceManager::CreateThreadBuffer()
+{
+	FTraceThreadBuffer* Buffer	= (FTraceThreadBuffer*) appMalloc( sizeof(FTraceThreadBuffer) );
+	Buffer->ThreadId			= appGetCurrentThreadId();
+	Buffer->Capacity			= BufferSize;
+	Buffer->Events				= (FTraceEvent*) appMalloc( sizeof(FTraceEvent) * Buffer->Capacity );
+	Buffer->WriteCount			= 0;
+	Buffer->ReadCount			= 0;
+	Buffer->DroppedCount		= 0;
+	Buffer->Depth				= 0;
+
+	{
+		FScopeLock ScopeLock( BufferListSynch );
+		Buffer->Next			= FirstBuffer;
+		FirstBuffer				= Buffer;
+	}
+
+	appSetTlsValue( TlsSlot, Buffer );
+	return Buffer;
+}
+
+/**
+ * Writes all pending events of the passed in buffer to the capture file.
+ *
+ * @param	Buffer	Buffer to drain
+ */
+void FTraceManager::DrainBuffer( FTraceThreadBuffer* Buffer )
+{
+	DWORD WriteCount = Buffer->WriteCount;
+	// Pairs with the barrier in AddEvent, events up to WriteCount need to be read after it.
+	appMemoryBarrier();
+
+	// Skip events the producer has lapped.
+	if( WriteCount - Buffer->ReadCount > Buffer->Capacity )
+	{
+		Buffer->DroppedCount	+= WriteCount - Buffer->ReadCount - Buffer->Capacity;
+		Buffer->ReadCount		= WriteCount - Buffer->Capacity;
+	}
+
+	const DOUBLE MicroSecondsPerCycle = GSecondsPerCycle * 1000000.0;
+	for( DWORD EventIndex=Buffer->ReadCount; EventIndex!=WriteCount; EventIndex++ )
+	{
+		// Copy event before checking whether the producer might have been overwriting it in the meantime.
+		FTraceEvent Event = Buffer->Events[EventIndex & (Buffer->Capacity - 1)];
+		appMemoryBarrier();
+		if( Buffer->WriteCount - EventIndex >= Buffer->Capacity )
+		{
+			Buffer->DroppedCount++;
+			continue;
+		}
+		// Events begun before the capture started would have negative time stamps.
+		if( Event.StartCycles < CaptureStartCycles )
+		{
+			continue;
+		}
+
+		WriteString( *FString::Printf( TEXT("%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}"),
+			bWroteEvent ? TEXT(",\n") : TEXT(""),
+			*EscapeTraceLabel( Event.Label ),
+			Buffer->ThreadId,
+			(Event.StartCycles - CaptureStartCycles) * MicroSecondsPerCycle,
+			(Event.EndCycles - Event.StartCycles) * MicroSecondsPerCycle ) );
+		bWroteEvent = TRUE;
+		EventCount++;
+	}
+	Buffer->ReadCount = WriteCount;
+}
+
+/**
+ * Writes the passed in string to the capture file, converting to ANSI.
+ *
+ * @param	String	String to write
+ */
+void FTraceManager::WriteString( const TCHAR* String )
+{
+	check(CaptureArchive);
+
+	FMemMark	Mark(GMem);
+	INT			Length		= appStrlen( String );
+	ANSICHAR*	AnsiString	= new(GMem,Length) ANSICHAR;
+	for( INT CharIndex=0; CharIndex<Length; CharIndex++ )
+	{
+		// Labels are expected to be plain ASCII; replace anything else so the JSON stays valid.
+		TCHAR Char = String[CharIndex];
+		AnsiString[CharIndex] = (Char >= 32 && Char < 127) ? (ANSICHAR) Char : (Char == '\n' ? '\n' : '?');
+	}
+	CaptureArchive->Serialize( AnsiString, Length );
+	Mark.Pop();
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -0,0 +1,192 @@
+/**
+ * UnThreadingBase.cpp -- Contains the platform independent implementations
+ * of the threading helpers declared in UnThreadingBase.h.
+ *
+ * Copyright 2004 Epic Games, Inc. All Rights Reserved.
+ */
+
+#include "CorePrivate.h"
+
+/** Number of parallel loops currently fanned out to the thread pool, at most one */
+static FThreadSafeCounter GActiveParallelFors;
+
+/**
+ * State shared by all threads working on a parallel loop. Owned by the thread
+ * calling appParallelFor, which waits till the last worker is done with it.
+ */
+struct FParallelForState
+{
+	/** The loop body */
+	FParallelForBody*	Body;
+	/** The number of indices to process */
+	INT					Num;
+	/** The next index to process, incremented by whichever thread claims it */
+	FThreadSafeCounter	NextIndex;
+	/** Number of queued work objects that haven't been disposed yet, protected by Synch */
+	INT					NumPendingWorkers;
+	/** Protects NumPendingWorkers */
+	FCriticalSection*	Synch;
+	/** Triggered when the last queued work object is disposed */
+	FEvent*				DoneEvent;
+
+	/**
+	 * Claims and processes indices till there are none left.
+	 */
+	void ProcessIndices(void)
+	{
+		for (INT Index = NextIndex.Increment() - 1; Index < Num; Index = NextIndex.Increment() - 1)
+		{
+			Body->Execute(Index);
+		}
+	}
+
+	/**
+	 * Called by each queued work object once it is done with the state. The state
+	 * may be freed as soon as the lock is released.
+	 */
+	void ReleaseWorker(void)
+	{
+		FScopeLock sl(Synch);
+		if (--NumPendingWorkers == 0)
+		{
+			DoneEvent->Trigger();
+		}
+	}
+};
+
+/**
+ * Queued work helping with a parallel loop.
+ */
+class FParallelForWork : public FQueuedWork
+{
+	/** The loop being worked on */
+	FParallelForState* State;
+
+public:
+	/**
+	 * Constructor
+	 *
+	 * @param InState The loop to work on
+	 */
+	FParallelForWork(FParallelForState* InState)
+	:	State(InState)
+	{}
+
+	// FQueuedWork interface.
+
+	virtual void DoWork(void)
+	{
+		State->ProcessIndices();
+	}
+	virtual void Abandon(void)
+	{
+		State->ReleaseWorker();
+		delete this;
+	}
+	virtual void Dispose(void)
+	{
+		State->ReleaseWorker();
+		delete this;
+	}
+};
+
+/**
+ * Calls Body.Execute for every index in [0,Num) and returns once all of them
+ * have been processed. The calling thread works on the loop alongside the
+ * threads of GThreadPool. Runs serially if there is no thread pool or another
+ * parallel loop is already running, which also makes nesting safe.
+ *
+ * @param Num The number of indices to process
+ * @param Body The loop body
+ */
+void appParallelFor(INT Num,FParallelForBody& Body)
+{
+	INT NumWorkers = Min<INT>(GNumHardwareThreads - 1,Num - 1);
+	if (GThreadPool == NULL || NumWorkers <= 0 || GActiveParallelFors.Increment() != 1)
+	{
+		if (GThreadPool != NULL && NumWorkers > 0)
+		{
+			GActiveParallelFors.Decrement();
+		}
+		for (INT Index = 0; Index < Num; Index++)
+		{
+			Body.Execute(Index);
+		}
+		return;
+	}
+
+	FParallelForState State;
+	State.Body				= &Body;
+	State.Num				= Num;
+	State.NumPendingWorkers	= NumWorkers;
+	State.Synch				= GSynchronizeFactory->CreateCriticalSection();
+	State.DoneEvent			= GSynchronizeFactory->CreateSynchEvent();
+
+	for (INT WorkerIndex = 0; WorkerIndex < NumWorkers; WorkerIndex++)
+	{
+		GThreadPool->AddQueuedWork(new FParallelForWork(&State));
+	}
+
+	// Help out rather than idling, then wait for the workers to let go of the state.
+	State.ProcessIndices();
+	for (;;)
+	{
+		{
+			FScopeLock sl(State.Synch);
+			if (State.NumPendingWorkers == 0)
+			{
+				break;
+			}
+		}
+		State.DoneEvent->Wait();
+	}
+
+	GSynchronizeFactory->Destroy(State.DoneEvent);
+	GSynchronizeFactory->Destroy(State.Synch);
+	GActiveParallelFors.Decrement();
+}
+
+/**
+ * Replaces GLog by this device.
+ */
+FParallelForLog::FParallelForLog(void) :
+	Log(GLog),
+	Synch(GSynchronizeFactory->CreateCriticalSection())
+{
+	GLog = this;
+}
+
+/**
+ * Restores GLog and forwards the buffered messages to it.
+ */
+FParallelForLog::~FParallelForLog(void)
+{
+	GLog = Log;
+	for (INT Index = 0; Index < Lines.Num(); Index++)
+	{
+		Log->Serialize(*Lines(Index),Events(Index));
+	}
+	GSynchronizeFactory->Destroy(Synch);
+}
+
+void FParallelForLog::Serialize(const TCHAR* V,EName Event)
+{
+	FScopeLock sl(Synch);
+	new(Lines) FString(V);
+	Events.AddItem(Event);
+}
+
+void FParallelForLog::AddOutputDevice(FOutputDevice* OutputDevice)
+{
+	Log->AddOutputDevice(OutputDevice);
+}
+
+void FParallelForLog::RemoveOutputDevice(FOutputDevice* OutputDevice)
+{
+	Log->RemoveOutputDevice(OutputDevice);
+}
+
+UBOOL FParallelForLog::IsRedirectingTo(FOutputDevice* OutputDevice)
+{
+	return Log->IsRedirectingTo(OutputDevice);
+}
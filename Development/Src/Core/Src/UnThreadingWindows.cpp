@@ -16,6 +16,8 @@
 FSynchronizeFactory*	GSynchronizeFactory = NULL;
 /** The global thread factory.					*/
 FThreadFactory*			GThreadFactory		= NULL;
+/** The global thread pool.						*/
+FQueuedThreadPool*		GThreadPool			= NULL;
 
 /** Default constructor, initializing Value to 0 */
 FThreadSafeCounter::FThreadSafeCounter()
@@ -583,6 +585,14 @@ FQueuedThreadPoolWin::~FQueuedThreadPoolWin(void)
 	{
 		Destroy();
 	}
+	if (SynchThreadQueue != NULL)
+	{
+		GSynchronizeFactory->Destroy(SynchThreadQueue);
+	}
+	if (SynchWorkQueue != NULL)
+	{
+		GSynchronizeFactory->Destroy(SynchWorkQueue);
+	}
 }
 
 /**
@@ -596,6 +606,15 @@ FQueuedThreadPoolWin::~FQueuedThreadPoolWin(void)
 UBOOL FQueuedThreadPoolWin::Create(DWORD InNumQueuedThreads,DWORD StackSize)
 {
 	UBOOL bWasSuccessful = TRUE;
+	// Create the synchronization objects before the first use
+	if (SynchThreadQueue == NULL)
+	{
+		SynchThreadQueue = GSynchronizeFactory->CreateCriticalSection();
+	}
+	if (SynchWorkQueue == NULL)
+	{
+		SynchWorkQueue = GSynchronizeFactory->CreateCriticalSection();
+	}
 	FScopeLock LockThreads(SynchThreadQueue);
 	FScopeLock LockWork(SynchWorkQueue);
 	// Presize the array so there is no extra memory allocated
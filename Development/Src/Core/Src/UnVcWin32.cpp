@@ -580,6 +580,28 @@ const TCHAR* appBaseDir()
 	return Result;
 }
 
+// Get the full path of this executable.
+const TCHAR* appExecutableName()
+{
+	static TCHAR Result[256]=TEXT("");
+	if( !Result[0] )
+	{
+#if UNICODE
+		if( GUnicode && !GUnicodeOS )
+		{
+			ANSICHAR ACh[256];
+			GetModuleFileNameA( hInstance, ACh, ARRAY_COUNT(ACh) );
+			MultiByteToWideChar( CP_ACP, 0, ACh, -1, Result, ARRAY_COUNT(Result) );
+		}
+		else
+#endif
+		{
+			GetModuleFileName( hInstance, Result, ARRAY_COUNT(Result) );
+		}
+	}
+	return Result;
+}
+
 // Get computer name.
 const TCHAR* appComputerName()
 {
@@ -764,6 +786,7 @@ void appPlatformInit()
 	SYSTEM_INFO SI;
 	GetSystemInfo(&SI);
 	GPageSize = SI.dwPageSize;
+	GNumHardwareThreads = Max<DWORD>( SI.dwNumberOfProcessors, 1 );
 	check(!(GPageSize&(GPageSize-1)));
 	debugf( NAME_Init, TEXT("CPU Page size=%i, Processors=%i"), SI.dwPageSize, SI.dwNumberOfProcessors );
 
@@ -599,7 +599,7 @@ FD3DSceneRenderer::FD3DSceneRenderer(const FSceneContext& InContext):
 
 	// Find visible primitives.
 
-	TArray<UPrimitiveComponent*>	VisiblePrimitives;
+	TFrameArray<UPrimitiveComponent*>	VisiblePrimitives(1024);
 	Scene->GetVisiblePrimitives(Context,ViewFrustum,VisiblePrimitives);
 
 	for(INT PrimitiveIndex = 0;PrimitiveIndex < VisiblePrimitives.Num();PrimitiveIndex++)
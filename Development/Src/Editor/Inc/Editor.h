@@ -102,6 +102,14 @@ const TCHAR* ImportObjectProperties(
 
 extern UBOOL GBuildStaticMeshCollision;
 
+//
+// GScriptFieldReferences - Fields in other packages that the script compiler looked up
+// by name for each class it compiled. Constant and enum values end up in the bytecode as
+// literals, so these lookups aren't visible as object references in the compiled class.
+//
+
+extern TMap<UClass*,TArray<UField*> > GScriptFieldReferences;
+
 //
 // Creating a static mesh from an array of triangles.
 //
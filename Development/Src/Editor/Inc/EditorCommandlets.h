@@ -134,6 +134,13 @@ class UFixAnimNodeCommandlet : public UCommandlet
 	INT Main( const TCHAR* Parms );
 };
 
+class UCollisionBenchmarkCommandlet : public UCommandlet
+{
+	DECLARE_CLASS(UCollisionBenchmarkCommandlet,UCommandlet,CLASS_Transient,Editor);
+	void StaticConstructor();
+	INT Main( const TCHAR* Parms );
+};
+
 
 
 #endif
@@ -62,6 +62,7 @@ enum EJSMeshTriType
 
 #include "UnEdTran.h"
 #include "UnTopics.h"
+#include "UnBspPoints.h"
 
 extern class FGlobalTopicTable GTopics;
 extern class FEditorModeTools GEditorModeTools;
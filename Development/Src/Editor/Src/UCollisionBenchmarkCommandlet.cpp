@@ -0,0 +1,285 @@
+/*=============================================================================
+	UCollisionBenchmarkCommandlet.cpp: Compares the kDOP tree layouts of the
+	static meshes of packages on line, box and point checks.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "EditorPrivate.h"
+
+/*-----------------------------------------------------------------------------
+	FCollisionBenchmarkQueries.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Deterministic set of queries in the space of a static mesh, so all tree
+ * layouts are measured on the same rays, boxes and points.
+ */
+struct FCollisionBenchmarkQueries
+{
+	TArray<FVector>	Starts;
+	TArray<FVector>	Ends;
+	TArray<FVector>	Points;
+	FVector			Extent;
+
+	/**
+	 * Generates the queries.
+	 *
+	 * @param	Bounds		Bounds of the mesh
+	 * @param	NumQueries	Number of queries of each kind
+	 */
+	FCollisionBenchmarkQueries( const FBoxSphereBounds& Bounds, INT NumQueries )
+	{
+		DWORD Seed = 0x1234567;
+		const FLOAT Radius = Max( Bounds.SphereRadius * 1.5f, 1.f );
+		Extent = FVector(1,1,1) * Max( Bounds.SphereRadius * 0.02f, 1.f );
+		for( INT QueryIndex=0; QueryIndex<NumQueries; QueryIndex++ )
+		{
+			// Lines between two points on a sphere around the mesh
+			Starts.AddItem( Bounds.Origin + RandomDirection(Seed) * Radius );
+			Ends.AddItem( Bounds.Origin + RandomDirection(Seed) * Radius );
+			Points.AddItem( Bounds.Origin + FVector(RandomSigned(Seed),RandomSigned(Seed),RandomSigned(Seed)) * Bounds.BoxExtent );
+		}
+	}
+
+private:
+	/** Returns a number in the range -1 to 1 from a linear congruential generator */
+	static FLOAT RandomSigned( DWORD& Seed )
+	{
+		Seed = Seed * 1664525 + 1013904223;
+		return (Seed >> 8) * (2.f / 16777216.f) - 1.f;
+	}
+	/** Returns a unit vector */
+	static FVector RandomDirection( DWORD& Seed )
+	{
+		FVector Direction;
+		do
+		{
+			Direction = FVector(RandomSigned(Seed),RandomSigned(Seed),RandomSigned(Seed));
+		}
+		while( Direction.SizeSquared() > 1.f || Direction.SizeSquared() < KINDA_SMALL_NUMBER );
+		return Direction.SafeNormal();
+	}
+};
+
+/*-----------------------------------------------------------------------------
+	UCollisionBenchmarkCommandlet.
+-----------------------------------------------------------------------------*/
+
+/** Tree layouts the queries are run against */
+enum ECollisionBenchmarkMode
+{
+	CBM_Nodes,
+	CBM_Compact,
+	CBM_Wide
+};
+
+/** Results of a kind of query, used to compare layouts against the first one measured */
+struct FCollisionBenchmarkResults
+{
+	TArray<UBOOL>	Hits;
+	TArray<FLOAT>	Times;
+};
+
+/**
+ * Runs the queries of a kind against the mesh's current tree and logs their
+ * throughput and the average number of nodes visited.
+ *
+ * @param	Name		Name of the run to log
+ * @param	Component	Component of the mesh to query
+ * @param	Queries		Queries to run
+ * @param	Kind		0 for line checks, 1 for box checks and 2 for point checks
+ * @param	Mode		Nodes to run the queries against
+ * @param	Reference	Results of the reference run, filled in if empty
+ */
+static void RunCollisionBenchmark( const TCHAR* Name, UStaticMeshComponent* Component, const FCollisionBenchmarkQueries& Queries, INT Kind, ECollisionBenchmarkMode Mode, FCollisionBenchmarkResults& Reference )
+{
+	FkDOPTree& kDOPTree = Component->StaticMesh->kDOPTree;
+	const UBOOL bFillReference = Reference.Hits.Num() == 0;
+	INT NodesVisited = 0;
+	INT NumHits = 0;
+	INT NumMismatches = 0;
+
+	const DOUBLE StartTime = appSeconds();
+	for( INT QueryIndex=0; QueryIndex<Queries.Points.Num(); QueryIndex++ )
+	{
+		FCheckResult Result(1.f);
+		UBOOL bHit;
+		if( Kind == 0 )
+		{
+			FkDOPLineCollisionCheck Check(&Result,Component,Queries.Starts(QueryIndex),Queries.Ends(QueryIndex));
+			bHit = Mode == CBM_Wide ? kDOPTree.LineCheckWide(Check) : Mode == CBM_Compact ? kDOPTree.LineCheck(Check) : kDOPTree.LineCheckNodes(Check);
+			NodesVisited += Check.NodesVisited;
+		}
+		else if( Kind == 1 )
+		{
+			FkDOPBoxCollisionCheck Check(&Result,Component,Queries.Starts(QueryIndex),Queries.Ends(QueryIndex),Queries.Extent);
+			bHit = Mode == CBM_Compact ? kDOPTree.BoxCheck(Check) : kDOPTree.BoxCheckNodes(Check);
+			NodesVisited += Check.NodesVisited;
+		}
+		else
+		{
+			FkDOPPointCollisionCheck Check(&Result,Component,Queries.Points(QueryIndex),Queries.Extent);
+			bHit = Mode == CBM_Compact ? kDOPTree.PointCheck(Check) : kDOPTree.PointCheckNodes(Check);
+			NodesVisited += Check.NodesVisited;
+		}
+		bHit = bHit != 0;
+		NumHits += bHit;
+
+		// Point checks report the first triangle found, so only whether they hit is compared
+		const FLOAT Time = (bHit && Kind != 2) ? Result.Time : 1.f;
+		if( bFillReference )
+		{
+			Reference.Hits.AddItem( bHit );
+			Reference.Times.AddItem( Time );
+		}
+		else if( Reference.Hits(QueryIndex) != bHit || Abs(Reference.Times(QueryIndex) - Time) > KINDA_SMALL_NUMBER )
+		{
+			NumMismatches++;
+		}
+	}
+	const DOUBLE Seconds = Max( appSeconds() - StartTime, 0.000001 );
+
+	const INT NumQueries = Queries.Points.Num();
+	warnf( TEXT("  %-16s %10.0f queries/s  %6.2f nodes/query  %5i hits  %5i mismatches"), Name, NumQueries / Seconds, (FLOAT)NodesVisited / Max(NumQueries,1), NumHits, NumMismatches );
+}
+
+/**
+ * Builds the mean split and surface area heuristic trees of a mesh and
+ * measures the queries on all their layouts.
+ *
+ * @param	StaticMesh	Mesh to benchmark
+ * @param	Component	Component to query the mesh with
+ * @param	NumQueries	Number of queries of each kind
+ */
+static void BenchmarkStaticMesh( UStaticMesh* StaticMesh, UStaticMeshComponent* Component, INT NumQueries )
+{
+	FkDOPTree OriginalTree = StaticMesh->kDOPTree;
+
+	// Rebuild the trees from the triangles of the loaded one
+	FkDOPTree MeanTree, SurfaceAreaTree;
+	DOUBLE MeanBuildTime, SurfaceAreaBuildTime;
+	{
+		TArray<FkDOPBuildCollisionTriangle> BuildTriangles;
+		for( INT TriangleIndex=0; TriangleIndex<OriginalTree.Triangles.Num(); TriangleIndex++ )
+		{
+			new(BuildTriangles) FkDOPBuildCollisionTriangle(OriginalTree.Triangles(TriangleIndex),StaticMesh->Vertices);
+		}
+		TArray<FkDOPBuildCollisionTriangle> SurfaceAreaTriangles = BuildTriangles;
+
+		DOUBLE StartTime = appSeconds();
+		MeanTree.Build(StaticMesh->Vertices,BuildTriangles,0);
+		MeanBuildTime = appSeconds() - StartTime;
+		MeanTree.BuildWideNodes();
+
+		StartTime = appSeconds();
+		SurfaceAreaTree.Build(StaticMesh->Vertices,SurfaceAreaTriangles,1);
+		SurfaceAreaBuildTime = appSeconds() - StartTime;
+		SurfaceAreaTree.BuildWideNodes();
+	}
+
+	warnf( TEXT("%s: %i triangles, mean %i nodes in %.2f ms, SAH %i nodes in %.2f ms, %i bytes per node, %i compact, %i per wide node"),
+		*StaticMesh->GetPathName(), OriginalTree.Triangles.Num(),
+		MeanTree.Nodes.Num(), MeanBuildTime * 1000.0, SurfaceAreaTree.Nodes.Num(), SurfaceAreaBuildTime * 1000.0,
+		sizeof(FkDOPNode), sizeof(FkDOPCompactNode), sizeof(FkDOPWideNode) );
+
+	Component->StaticMesh = StaticMesh;
+	FCollisionBenchmarkQueries Queries(StaticMesh->Bounds,NumQueries);
+	static const TCHAR* KindNames[3] = { TEXT("Line checks"), TEXT("Box checks"), TEXT("Point checks") };
+	for( INT Kind=0; Kind<3; Kind++ )
+	{
+		warnf( TEXT(" %s"), KindNames[Kind] );
+		FCollisionBenchmarkResults Reference;
+		StaticMesh->kDOPTree = MeanTree;
+		RunCollisionBenchmark( TEXT("mean"), Component, Queries, Kind, CBM_Nodes, Reference );
+		StaticMesh->kDOPTree = SurfaceAreaTree;
+		RunCollisionBenchmark( TEXT("SAH"), Component, Queries, Kind, CBM_Nodes, Reference );
+		RunCollisionBenchmark( TEXT("SAH compact"), Component, Queries, Kind, CBM_Compact, Reference );
+		if( Kind == 0 )
+		{
+			RunCollisionBenchmark( TEXT("SAH wide"), Component, Queries, Kind, CBM_Wide, Reference );
+		}
+	}
+
+	StaticMesh->kDOPTree = OriginalTree;
+	Component->StaticMesh = NULL;
+}
+
+void UCollisionBenchmarkCommandlet::StaticConstructor()
+{
+	IsClient        = 1;
+	IsEditor        = 1;
+	IsServer        = 1;
+	LazyLoad        = 1;
+	ShowErrorCount  = 1;
+}
+
+INT UCollisionBenchmarkCommandlet::Main( const TCHAR* Parms )
+{
+	INT NumQueries = 10000;
+	Parse( Parms, TEXT("QUERIES="), NumQueries );
+	NumQueries = Max( NumQueries, 1 );
+
+	UClass* EditorEngineClass	= UObject::StaticLoadClass( UEditorEngine::StaticClass(), NULL, TEXT("engine-ini:Engine.Engine.EditorEngine"), NULL, LOAD_NoFail, NULL );
+	GEngine = GEditor			= ConstructObject<UEditorEngine>( EditorEngineClass );
+	GEditor->UseSound			= 0;
+	GEditor->InitEditor();
+
+	GIsRequestingExit			= 1;	// so CTRL-C will exit immediately
+
+	// The queries are made in the space of the meshes
+	UStaticMeshComponent* Component = ConstructObject<UStaticMeshComponent>( UStaticMeshComponent::StaticClass() );
+	Component->LocalToWorld = FMatrix::Identity;
+	Component->LocalToWorldDeterminant = 1.f;
+	Component->AddToRoot();
+
+	FString PackageWildcard;
+	while( ParseToken(Parms, PackageWildcard, 0) )
+	{
+		if( PackageWildcard.Len() > 0 && PackageWildcard[0] == '-' )
+			continue;
+
+		TArray<FString> FilesInPath;
+		GFileManager->FindFiles( FilesInPath, *PackageWildcard, 1, 0 );
+
+		for( INT FileIndex = 0; FileIndex < FilesInPath.Num(); FileIndex++ )
+		{
+			const FString &Filename = FilesInPath(FileIndex);
+			UObject* Package;
+
+			warnf(NAME_Log, TEXT("Loading %s"), *Filename);
+
+			try
+			{
+				Package = UObject::LoadPackage( NULL, *Filename, 0 );
+			}
+			catch( ... )
+			{
+				Package = NULL;
+			}
+
+			if( !Package )
+			{
+				warnf(NAME_Log, TEXT("Error loading %s!"), *Filename);
+				continue;
+			}
+
+			for( TObjectIterator<UStaticMesh> It; It; ++It )
+			{
+				if( It->IsIn(Package) && It->kDOPTree.Nodes.Num() && It->kDOPTree.Triangles.Num() )
+				{
+					BenchmarkStaticMesh( *It, Component, NumQueries );
+				}
+			}
+
+			UObject::CollectGarbage(RF_Native);
+		}
+	}
+
+	Component->RemoveFromRoot();
+	return 0;
+}
+IMPLEMENT_CLASS(UCollisionBenchmarkCommandlet)
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
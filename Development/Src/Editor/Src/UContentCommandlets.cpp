@@ -11,6 +11,7 @@ Revision history:
 #include "UnLinker.h"
 #include "EngineAnimClasses.h"
 #include "EngineSequenceClasses.h"
+#include "UnPackageWorkers.h"
 
 /*-----------------------------------------------------------------------------
 	ULoadPackage commandlet.
@@ -632,44 +633,61 @@ INT UResavePackages::Main( const TCHAR* Parms )
 	GLazyLoad					= 1;
 	GIsRequestingExit			= 1;	// so CTRL-C will exit immediately
 
-	// Retrieve list of all packages in .ini paths.
-	TArray<FString> PackageList = GPackageFileCache->GetPackageFileList();
-	if( !PackageList.Num() )
-		return 0;
-
-	// Iterate over all packages.
-	for( INT PackageIndex = 0; PackageIndex < PackageList.Num(); PackageIndex++ )
+	// Workers started by a coordinator process the packages they were assigned.
+	FPackageWorkers Workers( this );
+	if( !Workers.IsWorker() )
 	{
-		const FFilename& Filename = PackageList(PackageIndex);
-		
-		if( GFileManager->IsReadOnly( *Filename) )
-		{
-			warnf(NAME_Log, TEXT("Skipping read-only file %s"), *Filename);
-		}
-		else if( Filename.GetExtension() == TEXT("U") )
-		{
-			warnf(NAME_Log, TEXT("Skipping script file %s"), *Filename);
-		}
-		else
-		{
-			warnf(NAME_Log, TEXT("Loading %s"), *Filename);
+		// Retrieve list of all packages in .ini paths.
+		TArray<FString> PackageList = GPackageFileCache->GetPackageFileList();
+		if( !PackageList.Num() )
+			return 0;
 
-			// Assert if package couldn't be opened so we have no chance of messing up saving later packages.
-			UObject* Package = UObject::LoadPackage( NULL, *Filename, 0 );
-			check(Package);
+		TArray<FString> ResaveList;
+		for( INT PackageIndex = 0; PackageIndex < PackageList.Num(); PackageIndex++ )
+		{
+			const FFilename& Filename = PackageList(PackageIndex);
 			
-			ULevel* Level = FindObject<ULevel>( Package, TEXT("MyLevel") );
-			if( Level )
-			{	
-				UObject::SavePackage( Package, Level, 0, *Filename, GWarn );
+			if( GFileManager->IsReadOnly( *Filename) )
+			{
+				warnf(NAME_Log, TEXT("Skipping read-only file %s"), *Filename);
+			}
+			else if( Filename.GetExtension() == TEXT("U") )
+			{
+				warnf(NAME_Log, TEXT("Skipping script file %s"), *Filename);
 			}
 			else
 			{
-				UObject::SavePackage( Package, NULL, RF_Standalone, *Filename, GWarn );
+				new(ResaveList) FString( Filename );
 			}
 		}
+
+		// Packages are saved over their source.
+		if( Workers.Distribute( ResaveList, 1 ) )
+			return 0;
+	}
+
+	// Iterate over all packages.
+	for( INT PackageIndex = 0; PackageIndex < Workers.Packages.Num(); PackageIndex++ )
+	{
+		const FString& Filename = Workers.Packages(PackageIndex);
+
+		warnf(NAME_Log, TEXT("Loading %s"), *Filename);
+
+		// Assert if package couldn't be opened so we have no chance of messing up saving later packages.
+		UObject* Package = UObject::LoadPackage( NULL, *Filename, 0 );
+		check(Package);
+		
+		ULevel* Level = FindObject<ULevel>( Package, TEXT("MyLevel") );
+		if( Level )
+		{	
+			UObject::SavePackage( Package, Level, 0, *Filename, GWarn );
+		}
+		else
+		{
+			UObject::SavePackage( Package, NULL, RF_Standalone, *Filename, GWarn );
+		}
 	
-		UObject::CollectGarbage(RF_Native);
+		Workers.CollectGarbage( PackageIndex );
 	}
 
 	return 0;
@@ -690,6 +690,460 @@ public:
 	}
 };
 
+/*-----------------------------------------------------------------------------
+	Incremental compilation.
+-----------------------------------------------------------------------------*/
+
+/** Version of the dependency files written next to compiled packages, bump to invalidate them */
+#define SCRIPT_DEPENDENCIES_VERSION	1
+
+/**
+ * Archive hashing the parts of a compiled class that other classes are compiled against:
+ * properties, function signatures, constants, enums, structs, states and default properties.
+ * Function bodies are left out so changing code only affects the class itself. Objects are
+ * hashed by path name which keeps the hash the same across runs.
+ */
+class FArchiveScriptInterfaceCrc : public FArchive
+{
+public:
+	/** Hash of everything serialized so far */
+	DWORD Crc;
+
+	/**
+	 * Constructor.
+	 *
+	 * @param	InCrc	Hash to continue from, e.g. the one of the super class
+	 */
+	FArchiveScriptInterfaceCrc( DWORD InCrc )
+	:	Crc( InCrc )
+	{
+		ArIsSaving = ArIsPersistent = 1;
+	}
+
+	// FArchive interface.
+	void Serialize( void* V, INT Length )
+	{
+		Crc = appMemCrc( V, Length, Crc );
+	}
+	FArchive& operator<<( FName& Name )
+	{
+		HashString( *Name );
+		return *this;
+	}
+	FArchive& operator<<( UObject*& Obj )
+	{
+		HashString( Obj ? *Obj->GetPathName() : TEXT("None") );
+		return *this;
+	}
+
+	/**
+	 * Hashes the interface of a class, not including its super class.
+	 */
+	void HashClass( UClass* Class )
+	{
+		DWORD ClassFlags = Class->ClassFlags & ~(CLASS_Compiled | CLASS_Parsed | CLASS_NeedsDefProps);
+		*this << ClassFlags << Class->ClassConfigName;
+		HashObject( Class->ClassWithin );
+		HashField( Class );
+
+		// Subclasses save their defaults as a delta against these.
+		UClass* SuperClass = Class->GetSuperClass();
+		if( Class->Defaults.Num() && Class->Defaults.Num() == Class->GetPropertiesSize() && (!SuperClass || SuperClass->Defaults.Num()) )
+			Class->SerializeTaggedProperties( *this, &Class->Defaults(0), SuperClass );
+	}
+
+private:
+	void HashString( const TCHAR* String )
+	{
+		Crc = appMemCrc( String, appStrlen(String) * sizeof(TCHAR), Crc );
+	}
+	void HashObject( UObject* Obj )
+	{
+		*this << Obj;
+	}
+	void HashStruct( UStruct* Struct )
+	{
+		HashObject( Struct->GetSuperStruct() );
+		*this << Struct->PropertiesSize << Struct->StructFlags << Struct->MinAlignment;
+		for( UField* Field=Struct->Children; Field; Field=Field->Next )
+			HashField( Field );
+
+		UStruct* SuperStruct = Struct->GetSuperStruct();
+		if( Struct->GetClass()->GetFName() == NAME_Struct && Struct->Defaults.Num() && Struct->Defaults.Num() == Struct->GetPropertiesSize() && (!SuperStruct || SuperStruct->Defaults.Num()) )
+			Struct->SerializeTaggedProperties( *this, &Struct->Defaults(0), SuperStruct );
+	}
+	void HashField( UField* Field )
+	{
+		FName Name = Field->GetFName();
+		*this << Name;
+		HashObject( Field->GetClass() );
+
+		if( UProperty* Property = Cast<UProperty>(Field) )
+		{
+			*this << Property->ArrayDim << Property->ElementSize << Property->PropertyFlags << Property->Offset;
+			if( UByteProperty* ByteProperty = Cast<UByteProperty>(Property) )
+				HashObject( ByteProperty->Enum );
+			else if( UClassProperty* ClassProperty = Cast<UClassProperty>(Property) )
+				HashObject( ClassProperty->MetaClass );
+			if( UObjectProperty* ObjectProperty = Cast<UObjectProperty>(Property) )
+				HashObject( ObjectProperty->PropertyClass );
+			else if( UStructProperty* StructProperty = Cast<UStructProperty>(Property) )
+				HashObject( StructProperty->Struct );
+			else if( UDelegateProperty* DelegateProperty = Cast<UDelegateProperty>(Property) )
+				HashObject( DelegateProperty->Function );
+			else if( UArrayProperty* ArrayProperty = Cast<UArrayProperty>(Property) )
+				HashField( ArrayProperty->Inner );
+			else if( UFixedArrayProperty* FixedArrayProperty = Cast<UFixedArrayProperty>(Property) )
+				HashField( FixedArrayProperty->Inner );
+			else if( UMapProperty* MapProperty = Cast<UMapProperty>(Property) )
+			{
+				HashField( MapProperty->Key );
+				HashField( MapProperty->Value );
+			}
+		}
+		else if( UFunction* Function = Cast<UFunction>(Field) )
+		{
+			// Only the signature, callers don't depend on locals or code.
+			*this << Function->FunctionFlags << Function->iNative << Function->OperPrecedence;
+			for( UField* Parm=Function->Children; Parm; Parm=Parm->Next )
+				if( Cast<UProperty>(Parm) && (((UProperty*)Parm)->PropertyFlags & CPF_Parm) )
+					HashField( Parm );
+		}
+		else if( UState* State = Cast<UState>(Field) )
+		{
+			*this << State->ProbeMask << State->IgnoreMask << State->StateFlags;
+			HashStruct( State );
+		}
+		else if( UStruct* Struct = Cast<UStruct>(Field) )
+			HashStruct( Struct );
+		else if( UConst* Const = Cast<UConst>(Field) )
+			*this << Const->Value;
+		else if( UEnum* Enum = Cast<UEnum>(Field) )
+			*this << Enum->Names;
+	}
+};
+
+/**
+ * Returns the interface hash of a class, which includes the ones of its super classes.
+ *
+ * @param	Class			Class to hash
+ * @param	InterfaceCrcs	Known hashes by class path name, the hashes computed are added
+ * @return	hash of the interface of the class
+ */
+static DWORD GetScriptInterfaceCrc( UClass* Class, TMap<FString,DWORD>& InterfaceCrcs )
+{
+	FString PathName = Class->GetPathName();
+	if( DWORD* Crc = InterfaceCrcs.Find(PathName) )
+		return *Crc;
+
+	FArchiveScriptInterfaceCrc Ar( Class->GetSuperClass() ? GetScriptInterfaceCrc(Class->GetSuperClass(),InterfaceCrcs) : 0 );
+	Ar.HashClass( Class );
+	InterfaceCrcs.Set( *PathName, Ar.Crc );
+	return Ar.Crc;
+}
+
+/**
+ * Archive collecting the classes the classes of a package reference in other packages: their
+ * super classes, the classes of their properties and the classes whose functions and properties
+ * their code uses. Constants and enum values are inlined into the code, so the classes they
+ * come from are added from GScriptFieldReferences and dependson instead.
+ */
+class FArchiveScriptClassReferences : public FArchive
+{
+public:
+	/** Class the objects being serialized belong to */
+	UClass* Referencer;
+	/** Classes in other packages referenced by each class */
+	TMap<UClass*,TArray<UClass*> > References;
+
+	FArchiveScriptClassReferences( UPackage* InPackage )
+	:	Referencer( NULL )
+	,	Package( InPackage )
+	{
+		ArIsSaving = ArIsPersistent = 1;
+	}
+
+	// FArchive interface.
+	FArchive& operator<<( UObject*& Obj )
+	{
+		if( Obj && Referencer )
+			AddReference( Referencer, Obj );
+		return *this;
+	}
+
+	/**
+	 * Records a reference of a class to an object, if it is in a class of another package.
+	 */
+	void AddReference( UClass* InReferencer, UObject* Obj )
+	{
+		// References to subobjects count as references to the top level object.
+		UObject* TopLevel = Obj;
+		while( TopLevel->GetOuter() && TopLevel->GetOuter()->GetOuter() )
+			TopLevel = TopLevel->GetOuter();
+		if( TopLevel->GetOuter() != Package && TopLevel->IsA(UClass::StaticClass()) )
+		{
+			TArray<UClass*>* Classes = References.Find( InReferencer );
+			if( !Classes )
+				Classes = &References.Set( InReferencer, TArray<UClass*>() );
+			Classes->AddUniqueItem( (UClass*)TopLevel );
+		}
+	}
+
+private:
+	UPackage* Package;
+};
+
+/**
+ * A source file of a package to compile.
+ */
+struct FScriptSourceFile
+{
+	/** File name relative to the package's Classes directory */
+	FString	Filename;
+	/** Full path */
+	FString	Path;
+	/** CRC of the contents, 0 if the file couldn't be read */
+	DWORD	Crc;
+};
+
+/**
+ * Hashes the contents of source files. Files are independent so they're hashed in parallel.
+ */
+class FScriptSourceCrcs : public FParallelForBody
+{
+public:
+	/** Files to hash */
+	TArray<FScriptSourceFile> Files;
+
+	// FParallelForBody interface.
+	void Execute( INT Index )
+	{
+		FScriptSourceFile& File = Files(Index);
+		File.Crc = 0;
+		FArchive* Reader = GFileManager->CreateFileReader( *File.Path );
+		if( Reader )
+		{
+			TArray<BYTE> Data( Reader->TotalSize() );
+			if( Data.Num() )
+			{
+				Reader->Serialize( &Data(0), Data.Num() );
+				File.Crc = appMemCrc( &Data(0), Data.Num() );
+			}
+			delete Reader;
+		}
+	}
+};
+
+/**
+ * A reference of a class to a class in another package, as recorded when it was compiled.
+ */
+struct FScriptClassReference
+{
+	/** Name of the referencing class */
+	FString	ClassName;
+	/** Path name of the referenced class */
+	FString	ReferencedPathName;
+	/** Interface hash of the referenced class */
+	DWORD	InterfaceCrc;
+};
+
+/**
+ * Dependency information of a compiled package, saved as <Package>.udep next to it. Records the
+ * hashes of the sources the package was compiled from, the interface hashes of its classes and
+ * the classes in other packages they were compiled against.
+ */
+class FScriptPackageDependencies
+{
+public:
+	/** CRC of each source file by file name */
+	TMap<FString,DWORD>				SourceCrcs;
+	/** Interface hash of each class by name */
+	TMap<FString,DWORD>				InterfaceCrcs;
+	/** References of the classes to classes in other packages */
+	TArray<FScriptClassReference>	References;
+
+	/**
+	 * Records the dependencies of a freshly compiled package.
+	 *
+	 * @param	Package			Compiled package
+	 * @param	Sources			Sources the package was compiled from
+	 * @param	NumSources		Number of entries in Sources
+	 * @param	AllCrcs			Interface hashes by class path name, the hashes of the classes of Package are added
+	 */
+	void Build( UPackage* Package, const FScriptSourceFile* Sources, INT NumSources, TMap<FString,DWORD>& AllCrcs )
+	{
+		for( INT SourceIndex=0; SourceIndex<NumSources; SourceIndex++ )
+			SourceCrcs.Set( *Sources[SourceIndex].Filename, Sources[SourceIndex].Crc );
+
+		for( TObjectIterator<UClass> It; It; ++It )
+			if( It->GetOuter()==Package && It->ScriptText )
+				InterfaceCrcs.Set( It->GetName(), GetScriptInterfaceCrc(*It,AllCrcs) );
+
+		// Collect the references of each class and everything within it, the way they're saved.
+		FArchiveScriptClassReferences Ar( Package );
+		for( FObjectIterator It; It; ++It )
+		{
+			if( It->IsIn(Package) && !(It->GetFlags() & RF_Transient) )
+			{
+				UObject* TopLevel = *It;
+				while( TopLevel->GetOuter() != Package )
+					TopLevel = TopLevel->GetOuter();
+				Ar.Referencer = Cast<UClass>(TopLevel);
+				if( Ar.Referencer && Ar.Referencer->ScriptText )
+					It->Serialize( Ar );
+			}
+		}
+
+		// Add the constants and enums the compiler looked up, and the classes named by dependson.
+		for( TMap<UClass*,TArray<UField*> >::TIterator It(GScriptFieldReferences); It; ++It )
+			if( It.Key()->GetOuter()==Package )
+				for( INT FieldIndex=0; FieldIndex<It.Value().Num(); FieldIndex++ )
+					Ar.AddReference( It.Key(), It.Value()(FieldIndex) );
+		for( TObjectIterator<UClass> It; It; ++It )
+		{
+			if( It->GetOuter()==Package && It->ScriptText )
+			{
+				for( INT NameIndex=0; NameIndex<It->DependentOn.Num(); NameIndex++ )
+				{
+					UClass* DependsOnClass = FindObject<UClass>( ANY_PACKAGE, *It->DependentOn(NameIndex) );
+					if( DependsOnClass )
+						Ar.AddReference( *It, DependsOnClass );
+				}
+			}
+		}
+		for( TMap<UClass*,TArray<UClass*> >::TIterator It(Ar.References); It; ++It )
+		{
+			for( INT ClassIndex=0; ClassIndex<It.Value().Num(); ClassIndex++ )
+			{
+				FScriptClassReference* Reference = new(References) FScriptClassReference;
+				Reference->ClassName			= It.Key()->GetName();
+				Reference->ReferencedPathName	= It.Value()(ClassIndex)->GetPathName();
+				Reference->InterfaceCrc			= GetScriptInterfaceCrc( It.Value()(ClassIndex), AllCrcs );
+			}
+		}
+	}
+
+	/**
+	 * Finds why a package has to be recompiled.
+	 *
+	 * @param	Pkg				Name of the package
+	 * @param	Sources			Current sources of the package
+	 * @param	NumSources		Number of entries in Sources
+	 * @param	AllCrcs			Current interface hashes of the classes of the packages processed so far
+	 * @param	Packages		Names of the packages processed so far
+	 * @return	the reason the package has to be recompiled, empty if it is up to date
+	 */
+	FString FindChange( const TCHAR* Pkg, const FScriptSourceFile* Sources, INT NumSources, const TMap<FString,DWORD>& AllCrcs, const TArray<FString>& Packages ) const
+	{
+		for( INT SourceIndex=0; SourceIndex<NumSources; SourceIndex++ )
+		{
+			const DWORD* Crc = SourceCrcs.Find( Sources[SourceIndex].Filename );
+			if( !Crc || *Crc != Sources[SourceIndex].Crc )
+				return FString::Printf( TEXT("Class %s changed"), *Sources[SourceIndex].Path );
+		}
+		if( SourceCrcs.Num() != NumSources )
+			return FString::Printf( TEXT("Class removed from %s"), Pkg );
+
+		for( INT ReferenceIndex=0; ReferenceIndex<References.Num(); ReferenceIndex++ )
+		{
+			const FScriptClassReference& Reference = References(ReferenceIndex);
+			const DWORD* Crc = AllCrcs.Find( Reference.ReferencedPathName );
+			if( Crc )
+			{
+				if( *Crc != Reference.InterfaceCrc )
+					return FString::Printf( TEXT("%s.%s depends on %s, which changed"), Pkg, *Reference.ClassName, *Reference.ReferencedPathName );
+			}
+			else
+			{
+				// Classes in packages that aren't compiled from script can't change, the others have been removed.
+				INT Dot = Reference.ReferencedPathName.InStr( TEXT(".") );
+				if( Dot != -1 && Packages.FindItemIndex(Reference.ReferencedPathName.Left(Dot)) != INDEX_NONE )
+					return FString::Printf( TEXT("%s.%s depends on %s, which no longer exists"), Pkg, *Reference.ClassName, *Reference.ReferencedPathName );
+			}
+		}
+		return TEXT("");
+	}
+
+	/**
+	 * Loads the dependency information of a package.
+	 *
+	 * @param	Filename	File to load from
+	 * @return	TRUE if the file exists and was written by this version
+	 */
+	UBOOL Load( const TCHAR* Filename )
+	{
+		FString Text;
+		if( !appLoadFileToString( Text, Filename ) )
+			return 0;
+
+		const TCHAR* Str = *Text;
+		FString Line;
+		UBOOL ValidVersion = 0;
+		while( ParseLine( &Str, Line ) )
+		{
+			const TCHAR* LineStr = *Line;
+			FString Type = ParseToken( LineStr, 0 );
+			if( Type == TEXT("Version") )
+			{
+				ValidVersion = appAtoi( *ParseToken(LineStr,0) ) == SCRIPT_DEPENDENCIES_VERSION;
+			}
+			else if( Type == TEXT("Source") )
+			{
+				FString SourceFilename = ParseToken( LineStr, 0 );
+				SourceCrcs.Set( *SourceFilename, ParseCrc(*ParseToken(LineStr,0)) );
+			}
+			else if( Type == TEXT("Interface") )
+			{
+				FString ClassName = ParseToken( LineStr, 0 );
+				InterfaceCrcs.Set( *ClassName, ParseCrc(*ParseToken(LineStr,0)) );
+			}
+			else if( Type == TEXT("Reference") )
+			{
+				FScriptClassReference* Reference = new(References) FScriptClassReference;
+				Reference->ClassName			= ParseToken( LineStr, 0 );
+				Reference->ReferencedPathName	= ParseToken( LineStr, 0 );
+				Reference->InterfaceCrc			= ParseCrc( *ParseToken(LineStr,0) );
+			}
+		}
+		return ValidVersion;
+	}
+
+	/**
+	 * Saves the dependency information of a package.
+	 *
+	 * @param	Filename	File to save to
+	 * @return	TRUE if the file was written
+	 */
+	UBOOL Save( const TCHAR* Filename ) const
+	{
+		FString Text = FString::Printf( TEXT("Version %i\r\n"), SCRIPT_DEPENDENCIES_VERSION );
+		for( TMap<FString,DWORD>::TConstIterator It(SourceCrcs); It; ++It )
+			Text += FString::Printf( TEXT("Source %s %08X\r\n"), *It.Key(), It.Value() );
+		for( TMap<FString,DWORD>::TConstIterator It(InterfaceCrcs); It; ++It )
+			Text += FString::Printf( TEXT("Interface %s %08X\r\n"), *It.Key(), It.Value() );
+		for( INT ReferenceIndex=0; ReferenceIndex<References.Num(); ReferenceIndex++ )
+			Text += FString::Printf( TEXT("Reference %s %s %08X\r\n"), *References(ReferenceIndex).ClassName, *References(ReferenceIndex).ReferencedPathName, References(ReferenceIndex).InterfaceCrc );
+		return appSaveStringToFile( Text, Filename );
+	}
+
+private:
+	/** Parses a CRC written as 8 hex digits, appStrtoi doesn't cover the full DWORD range everywhere */
+	static DWORD ParseCrc( const TCHAR* Str )
+	{
+		DWORD Crc = 0;
+		for( ; *Str; Str++ )
+		{
+			if( *Str >= '0' && *Str <= '9' )
+				Crc = (Crc << 4) + (*Str - '0');
+			else if( *Str >= 'A' && *Str <= 'F' )
+				Crc = (Crc << 4) + (*Str - 'A' + 10);
+			else
+				break;
+		}
+		return Crc;
+	}
+};
+
 /*-----------------------------------------------------------------------------
 	UMakeCommandlet.
 -----------------------------------------------------------------------------*/
@@ -715,6 +1169,39 @@ INT UMakeCommandlet::Main( const TCHAR* Parms )
 	GIsRequestingExit			= 1; // Causes ctrl-c to immediately exit.
 	NameLookupCPP				= new FNameLookupCPP();
 
+	// -all ignores the dependency information of the packages and recompiles all of them.
+	const UBOOL FullRebuild = ParseParam( appCmdLine(), TEXT("ALL") );
+
+	// Find the sources of all packages and hash them up front. The files are independent so they are
+	// hashed in parallel, compiling can't be as the script compiler relies on global state.
+	FScriptSourceCrcs SourceCrcs;
+	TArray<INT> FirstSources;
+	for( INT PackageIndex=0; PackageIndex<GEditor->EditPackages.Num(); PackageIndex++ )
+	{
+		const TCHAR* Pkg = *GEditor->EditPackages( PackageIndex );
+		FString Spec = GEditor->EditPackagesInPath * Pkg * TEXT("Classes") * TEXT("*.uc");
+		TArray<FString> Files;
+		GFileManager->FindFiles( Files, *Spec, 1, 0 );
+
+		// Make script compilation deterministic by sorting .uc files by name.
+		if( Files.Num() )
+			Sort<USE_COMPARE_CONSTREF(FString,UMakeCommandlet)>( &Files(0), Files.Num() );
+
+		FirstSources.AddItem( SourceCrcs.Files.Num() );
+		for( INT i=0; i<Files.Num(); i++ )
+		{
+			FScriptSourceFile* File = new(SourceCrcs.Files) FScriptSourceFile;
+			File->Filename	= Files(i);
+			File->Path		= GEditor->EditPackagesInPath * Pkg * TEXT("Classes") * Files(i);
+		}
+	}
+	FirstSources.AddItem( SourceCrcs.Files.Num() );
+	appParallelFor( SourceCrcs.Files.Num(), SourceCrcs );
+
+	// Interface hashes of the classes of the packages processed so far, by path name.
+	TMap<FString,DWORD> InterfaceCrcs;
+	TArray<FString> ProcessedPackages;
+
 	// Load classes for editing.
 	UClassFactoryUC* ClassFactory = new UClassFactoryUC;
 	for( INT PackageIndex=0; PackageIndex<GEditor->EditPackages.Num(); PackageIndex++ )
@@ -722,42 +1209,46 @@ INT UMakeCommandlet::Main( const TCHAR* Parms )
 		// Try to load class.
 		const TCHAR* Pkg = *GEditor->EditPackages( PackageIndex );
 		FString Filename = FString::Printf(TEXT("%s") PATH_SEPARATOR TEXT("%s.u"), *GEditor->EditPackagesOutPath, Pkg );
+		FString DependenciesFilename = FString::Printf(TEXT("%s") PATH_SEPARATOR TEXT("%s.udep"), *GEditor->EditPackagesOutPath, Pkg );
+		const INT NumSources = FirstSources(PackageIndex + 1) - FirstSources(PackageIndex);
+		const FScriptSourceFile* Sources = NumSources ? &SourceCrcs.Files(FirstSources(PackageIndex)) : NULL;
 		GWarn->Log( NAME_Heading, FString::Printf(TEXT("%s - %s"),Pkg,ParseParam(appCmdLine(), TEXT("DEBUG"))? TEXT("Debug") : TEXT("Release"))); //DEBUGGER
-		
-		// Check whether this package needs to be recompiled because a class is newer than the package.
+
+		// Check whether this package needs to be recompiled because one of its classes changed or one of the
+		// classes in other packages they were compiled against changed its interface.
 		//@warning: This e.g. won't detect changes to resources being compiled into packages.
-		if(GFileManager->FileSize(*Filename) > 0)
+		FScriptPackageDependencies Dependencies;
+		FString Reason;
+		if( GFileManager->FileSize(*Filename) > 0 )
 		{
-			DOUBLE			PackageFileSeconds	= GFileManager->GetFileAgeSeconds(*Filename);
-			FString			ClassesWildcard		= GEditor->EditPackagesInPath * Pkg * TEXT("Classes") * TEXT("*.uc");
-			TArray<FString> ClassesFiles;
-			
-			GFileManager->FindFiles( ClassesFiles, *ClassesWildcard, 1, 0 );
-			
-			// Iterate over all .uc files in the package's Classes folder.
-			for( INT ClassIndex=0; ClassIndex<ClassesFiles.Num(); ClassIndex++ )
-			{
-				FString		ClassName			= GEditor->EditPackagesInPath * Pkg * TEXT("Classes") * ClassesFiles(ClassIndex);
-				DOUBLE		ClassFileSeconds	= GFileManager->GetFileAgeSeconds(*ClassName);
+			if( FullRebuild )
+				Reason = TEXT("Clean rebuild requested");
+			else if( !Dependencies.Load(*DependenciesFilename) )
+				Reason = FString::Printf( TEXT("No dependency information for %s"), Pkg );
+			else
+				Reason = Dependencies.FindChange( Pkg, Sources, NumSources, InterfaceCrcs, ProcessedPackages );
+		}
+		ProcessedPackages.AddItem( Pkg );
 
-				// Delete package (and subsequent ones) if there is a class newer than the package. This relies on package not already bound which
-				// is taken care of by setting GIsUCCMake to true.
-				if( ClassFileSeconds <= PackageFileSeconds )
-				{
-					// Delete package and all the ones following in EditPackages. This is required in certain cases so we rather play safe.
-					for( INT DeleteIndex=PackageIndex; DeleteIndex<GEditor->EditPackages.Num(); DeleteIndex++ )
-					{
-						FString Filename = FString::Printf(TEXT("%s") PATH_SEPARATOR TEXT("%s.u"), *GEditor->EditPackagesOutPath, *GEditor->EditPackages( DeleteIndex ) );
-						GFileManager->Delete( *Filename, 0, 0 );
-					}
-					warnf(TEXT("Class %s changed, recompiling"), *ClassName);
-					break;
-				}
-			}
+		// Delete the package if it is out of date. This relies on package not already bound which is taken
+		// care of by setting GIsUCCMake to true. Packages depending on it are only recompiled if its
+		// interface changes.
+		if( Reason.Len() )
+		{
+			GFileManager->Delete( *Filename, 0, 0 );
+			warnf(TEXT("%s, recompiling"), *Reason);
+		}
+
+		if( LoadPackage( NULL, *Filename, LOAD_NoWarn ) )
+		{
+			// Up to date, so the classes have the interfaces they were compiled with.
+			for( TMap<FString,DWORD>::TIterator It(Dependencies.InterfaceCrcs); It; ++It )
+				InterfaceCrcs.Set( *FString::Printf(TEXT("%s.%s"),Pkg,*It.Key()), It.Value() );
 		}
-		
-		if( !LoadPackage( NULL, *Filename, LOAD_NoWarn ) )
+		else
 		{
+			GFileManager->Delete( *DependenciesFilename, 0, 0 );
+
 			// Create package.
 			GWarn->Log( TEXT("Analyzing...") );
 			UPackage* Package = CreatePackage( NULL, Pkg );
@@ -774,21 +1265,14 @@ INT UMakeCommandlet::Main( const TCHAR* Parms )
 				Package->PackageFlags |= PKG_ServerSideOnly;
 
 			// Rebuild the class from its directory.
-			FString Spec = GEditor->EditPackagesInPath * Pkg * TEXT("Classes") * TEXT("*.uc");
-			TArray<FString> Files;
-			GFileManager->FindFiles( Files, *Spec, 1, 0 );
-			if( Files.Num() == 0 )
-				appErrorf( TEXT("Can't find files matching %s"), *Spec );
-
-			// Make script compilation deterministic by sorting .uc files by name.
-			Sort<USE_COMPARE_CONSTREF(FString,UMakeCommandlet)>( &Files(0), Files.Num() );
+			if( NumSources == 0 )
+				appErrorf( TEXT("Can't find files matching %s"), *(GEditor->EditPackagesInPath * Pkg * TEXT("Classes") * TEXT("*.uc")) );
 
-			for( INT i=0; i<Files.Num(); i++ )
+			for( INT i=0; i<NumSources; i++ )
 			{
 				// Import class.
-				FString Filename  = GEditor->EditPackagesInPath * Pkg * TEXT("Classes") * Files(i);
-				FString ClassName = Files(i).LeftChop(3);
-				ImportObject<UClass>( GEditor->Level, Package, *ClassName, RF_Public|RF_Standalone, *Filename, NULL, ClassFactory );
+				FString ClassName = Sources[i].Filename.LeftChop(3);
+				ImportObject<UClass>( GEditor->Level, Package, *ClassName, RF_Public|RF_Standalone, *Sources[i].Path, NULL, ClassFactory );
 			}
 
 			// Verify that all script declared superclasses exist.
@@ -798,6 +1282,7 @@ INT UMakeCommandlet::Main( const TCHAR* Parms )
 						appErrorf( TEXT("Superclass %s of class %s not found"), ItC->GetSuperClass()->GetName(), ItC->GetName() );
 
 			// Bootstrap-recompile changed scripts.
+			GScriptFieldReferences.Empty();
 			GEditor->Bootstrapping = 1;
 			GEditor->ParentContext = Package;
 			UBOOL Success = GEditor->MakeScripts( NULL, GWarn, 0, 1, 1 );
@@ -834,6 +1319,19 @@ INT UMakeCommandlet::Main( const TCHAR* Parms )
 			}
 
 			SavePackage( Package, NULL, RF_Standalone, *Filename, GError, Conform );
+
+			// Record what the package was compiled from and against for the next run.
+			FScriptPackageDependencies NewDependencies;
+			NewDependencies.Build( Package, Sources, NumSources, InterfaceCrcs );
+			GScriptFieldReferences.Empty();
+			for( TMap<FString,DWORD>::TIterator It(NewDependencies.InterfaceCrcs); It; ++It )
+			{
+				const DWORD* OldCrc = Dependencies.InterfaceCrcs.Find( It.Key() );
+				if( OldCrc && *OldCrc != It.Value() )
+					debugf( TEXT("Interface of %s.%s changed"), Pkg, *It.Key() );
+			}
+			if( !NewDependencies.Save(*DependenciesFilename) )
+				warnf( TEXT("Failed to save %s, %s will be recompiled next time"), *DependenciesFilename, Pkg );
 		}
 	}
 
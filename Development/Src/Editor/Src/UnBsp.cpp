@@ -55,9 +55,40 @@ public:
 	int     ProcessingBack;
 };
 
+//
+// Chunk of an EdPoly that fell into a leaf, filtered without calling
+// the filter function.
+//
+class FBspFilterFragment
+{
+public:
+	FPoly			EdPoly;
+	INT				iNode;
+	EPolyNodeFilter	Filter;
+	ENodePlace		NodePlace;
+};
+
+//
+// Result of filtering an EdPoly through the Bsp on a worker thread.  Also
+// records the empty children the chunks went to or were compared against,
+// as nodes added there later would have changed where the chunks went.
+//
+class FBspFilterResult
+{
+public:
+	TArray<FBspFilterFragment>	Fragments;		// Chunks in the order the filter function would be called.
+	TArray<INT>					EmptyChildren;	// Node index * 2, plus 1 for iFront.
+	INT							NumErrors;		// Errors to add to GErrors.
+
+	FBspFilterResult()
+	:	NumErrors( 0 )
+	{}
+};
+
 //
 // Function to filter an EdPoly through the Bsp, calling a callback
-// function for all chunks that fall into leaves.
+// function for all chunks that fall into leaves, or recording them
+// in Result if it isn't NULL.
 //
 void FilterEdPoly
 (
@@ -66,7 +97,8 @@ void FilterEdPoly
 	INT  			iNode, 
 	FPoly			*EdPoly, 
 	FCoplanarInfo	CoplanarInfo, 
-	int				Outside
+	int				Outside,
+	FBspFilterResult* Result=NULL
 );
 
 //
@@ -104,6 +136,187 @@ UModel		*GModel;		// Level map Model we're adding to.
    Point and Vector table functions.
 -----------------------------------------------------------------------------*/
 
+FBspPointsGrid* FBspPointsGrid::GBspPoints = NULL;
+FBspPointsGrid* FBspPointsGrid::GBspVectors = NULL;
+
+FBspPointsGrid::FBspPointsGrid( TArray<FVector>& InTable, FLOAT InCellSize )
+:	Table( InTable )
+,	CellSize( InCellSize )
+,	NumIndexed( 0 )
+{
+	HashFirst.Add( 1024 );
+	for( INT i=0; i<HashFirst.Num(); i++ )
+		HashFirst(i) = INDEX_NONE;
+}
+
+INT FBspPointsGrid::GetCell( FLOAT Value ) const
+{
+	// Clamped so huge vectors don't overflow, they merely share the outermost cells.
+	return appFloor( Clamp( Value / CellSize, -1.0e9f, 1.0e9f ) );
+}
+
+INT FBspPointsGrid::GetBucket( INT X, INT Y, INT Z ) const
+{
+	return (((DWORD)X * 73856093) ^ ((DWORD)Y * 19349663) ^ ((DWORD)Z * 83492791)) & (HashFirst.Num() - 1);
+}
+
+void FBspPointsGrid::GrowHash()
+{
+	INT NumBuckets = HashFirst.Num() * 2;
+	HashFirst.Empty( NumBuckets );
+	HashFirst.Add( NumBuckets );
+	for( INT i=0; i<NumBuckets; i++ )
+		HashFirst(i) = INDEX_NONE;
+
+	// Chain the entries in ascending order again, so each chain is descending.
+	for( INT i=0; i<NumIndexed; i++ )
+	{
+		const FVector& Point = Table(i);
+		INT Bucket = GetBucket( GetCell(Point.X), GetCell(Point.Y), GetCell(Point.Z) );
+		HashNext(i) = HashFirst(Bucket);
+		HashFirst(Bucket) = i;
+	}
+}
+
+void FBspPointsGrid::IndexPoints( INT Num )
+{
+	check(Num<=Table.Num());
+	for( ; NumIndexed<Num; NumIndexed++ )
+	{
+		if( NumIndexed >= HashFirst.Num() * 2 )
+			GrowHash();
+		const FVector& Point = Table(NumIndexed);
+		INT Bucket = GetBucket( GetCell(Point.X), GetCell(Point.Y), GetCell(Point.Z) );
+		HashNext.AddItem( HashFirst(Bucket) );
+		HashFirst(Bucket) = NumIndexed;
+	}
+}
+
+void FBspPointsGrid::Invalidate()
+{
+	NumIndexed = 0;
+	HashNext.Empty();
+	for( INT i=0; i<HashFirst.Num(); i++ )
+		HashFirst(i) = INDEX_NONE;
+}
+
+INT FBspPointsGrid::FindFirst( const FVector& V, FLOAT Thresh, FLOAT Dist ) const
+{
+	// The cell coordinates are rounded relative to the magnitude of the vector, so
+	// the range searched is widened accordingly to never skip an entry the
+	// comparisons below accept.
+	const FLOAT ReachX = Thresh + Abs(V.X) * 1.0e-6f;
+	const FLOAT ReachY = Thresh + Abs(V.Y) * 1.0e-6f;
+	const FLOAT ReachZ = Thresh + Abs(V.Z) * 1.0e-6f;
+	const INT MinX = GetCell(V.X - ReachX), MaxX = GetCell(V.X + ReachX);
+	const INT MinY = GetCell(V.Y - ReachY), MaxY = GetCell(V.Y + ReachY);
+	const INT MinZ = GetCell(V.Z - ReachZ), MaxZ = GetCell(V.Z + ReachZ);
+
+	INT Result = INDEX_NONE;
+	if( MaxX - MinX > 3 || MaxY - MinY > 3 || MaxZ - MinZ > 3 )
+	{
+		// Too many cells to visit for a threshold this large relative to the cells.
+		for( INT i=0; i<NumIndexed && Result==INDEX_NONE; i++ )
+		{
+			const FVector &TableVect = Table(i);
+			if
+			(	Abs(V.X - TableVect.X) < Thresh
+			&&	Abs(V.Y - TableVect.Y) < Thresh
+			&&	Abs(V.Z - TableVect.Z) < Thresh
+			&&	(Dist <= 0.f || (TableVect - V).SizeSquared() < Dist*Dist) )
+				Result = i;
+		}
+		return Result;
+	}
+
+	for( INT X=MinX; X<=MaxX; X++ )
+	{
+		for( INT Y=MinY; Y<=MaxY; Y++ )
+		{
+			for( INT Z=MinZ; Z<=MaxZ; Z++ )
+			{
+				// Chains are in descending order and may hold entries of other cells.
+				for( INT i=HashFirst(GetBucket(X,Y,Z)); i!=INDEX_NONE; i=HashNext(i) )
+				{
+					if( Result!=INDEX_NONE && i>=Result )
+						continue;
+					const FVector &TableVect = Table(i);
+					FLOAT Temp=(V.X - TableVect.X);
+					if( (Temp > -Thresh) && (Temp < Thresh) )
+					{
+						Temp=(V.Y - TableVect.Y);
+						if( (Temp > -Thresh) && (Temp < Thresh) )
+						{
+							Temp=(V.Z - TableVect.Z);
+							if( (Temp > -Thresh) && (Temp < Thresh) )
+							{
+								if( Dist <= 0.f || (TableVect - V).SizeSquared() < Dist*Dist )
+									Result = i;
+							}
+						}
+					}
+				}
+			}
+		}
+	}
+	return Result;
+}
+
+INT FBspPointsGrid::FindPoint( const FVector& V, FLOAT Thresh )
+{
+	// The table shrinks when unreferenced entries are removed, which moves the rest.
+	if( Table.Num() < NumIndexed )
+		Invalidate();
+	IndexPoints( Table.Num() );
+	return FindFirst( V, Thresh, 0.f );
+}
+
+INT FBspPointsGrid::FindPointInSphere( const FVector& V, FLOAT Dist )
+{
+	if( Dist <= 0.f )
+		return INDEX_NONE;
+	return FindFirst( V, Dist, Dist );
+}
+
+FBspPointsGrid* FBspPointsGrid::GetGrid( const TArray<FVector>& InTable )
+{
+	if( GBspPoints && &GBspPoints->Table == &InTable )
+		return GBspPoints;
+	if( GBspVectors && &GBspVectors->Table == &InTable )
+		return GBspVectors;
+	return NULL;
+}
+
+void FBspPointsGrid::InvalidateModel( UModel* Model )
+{
+	FBspPointsGrid* Grid = GetGrid( Model->Points );
+	if( Grid )
+		Grid->Invalidate();
+	Grid = GetGrid( Model->Vectors );
+	if( Grid )
+		Grid->Invalidate();
+}
+
+FBspPointsGridScope::FBspPointsGridScope( UModel* Model )
+:	Points( NULL )
+,	Vectors( NULL )
+,	OldPoints( FBspPointsGrid::GBspPoints )
+,	OldVectors( FBspPointsGrid::GBspVectors )
+{
+	if( !FBspPointsGrid::GetGrid( Model->Points ) )
+		Points = FBspPointsGrid::GBspPoints = new FBspPointsGrid( Model->Points, BSP_POINTS_GRID_CELL_SIZE );
+	if( !FBspPointsGrid::GetGrid( Model->Vectors ) )
+		Vectors = FBspPointsGrid::GBspVectors = new FBspPointsGrid( Model->Vectors, BSP_VECTORS_GRID_CELL_SIZE );
+}
+
+FBspPointsGridScope::~FBspPointsGridScope()
+{
+	FBspPointsGrid::GBspPoints = OldPoints;
+	FBspPointsGrid::GBspVectors = OldVectors;
+	delete Points;
+	delete Vectors;
+}
+
 //
 // Add a new point to the model (preventing duplicates) and return its
 // index.
@@ -112,6 +325,16 @@ INT AddThing( TArray<FVector>& Vectors, FVector& V, FLOAT Thresh, int Check )
 {
 	if( Check )
 	{
+		// Look the vector up in the grid of the table if a Bsp operation set one up.
+		FBspPointsGrid* Grid = FBspPointsGrid::GetGrid( Vectors );
+		if( Grid )
+		{
+			INT i = Grid->FindPoint( V, Thresh );
+			if( i != INDEX_NONE )
+				return i;
+			return Vectors.AddItem( V );
+		}
+
 		// See if this is very close to an existing point/vector.		
 		for( INT i=0; i<Vectors.Num(); i++ )
 		{
@@ -1214,6 +1437,40 @@ void DeIntersectWorldWithBrushFunc( UModel* Model, INT iNode, FPoly* EdPoly,
    CSG polygon filtering routine (calls the callbacks).
 ----------------------------------------------------------------------------*/
 
+//
+// Call the filter function for a chunk, or record it.
+//
+static void FilterChunk
+(
+	BSP_FILTER_FUNC		FilterFunc,
+	UModel*				Model,
+	INT					iNode,
+	FPoly*				EdPoly,
+	EPolyNodeFilter		Filter,
+	ENodePlace			NodePlace,
+	FBspFilterResult*	Result
+)
+{
+	if( Result )
+	{
+		FBspFilterFragment* Fragment = new(Result->Fragments)FBspFilterFragment;
+		Fragment->EdPoly	= *EdPoly;
+		Fragment->iNode		= iNode;
+		Fragment->Filter	= Filter;
+		Fragment->NodePlace	= NodePlace;
+	}
+	else FilterFunc( Model, iNode, EdPoly, Filter, NodePlace );
+}
+
+//
+// Note that a chunk depends on a child of a node being empty.
+//
+static void RecordEmptyChild( FBspFilterResult* Result, INT iNode, UBOOL IsFront )
+{
+	if( Result )
+		Result->EmptyChildren.AddItem( iNode*2 + (IsFront ? 1 : 0) );
+}
+
 //
 // Handle a piece of a polygon that was filtered to a leaf.
 //
@@ -1225,7 +1482,8 @@ void FilterLeaf
 	FPoly*			EdPoly, 
 	FCoplanarInfo	CoplanarInfo, 
 	INT				LeafOutside, 
-	ENodePlace		ENodePlace
+	ENodePlace		ENodePlace,
+	FBspFilterResult* Result
 )
 {
 	EPolyNodeFilter FilterType;
@@ -1234,7 +1492,7 @@ void FilterLeaf
 	{
 		// Processing regular, non-coplanar polygons.
 		FilterType = LeafOutside ? F_OUTSIDE : F_INSIDE;
-		FilterFunc( Model, iNode, EdPoly, FilterType, ENodePlace );
+		FilterChunk( FilterFunc, Model, iNode, EdPoly, FilterType, ENodePlace, Result );
 	}
 	else if( CoplanarInfo.ProcessingBack )
 	{
@@ -1249,7 +1507,7 @@ void FilterLeaf
 			appErrorf( TEXT("FilterLeaf: Bad Locs") );
 			return;
 		}
-		FilterFunc( Model, CoplanarInfo.iOriginalNode, EdPoly, FilterType, NODE_Plane );
+		FilterChunk( FilterFunc, Model, CoplanarInfo.iOriginalNode, EdPoly, FilterType, NODE_Plane, Result );
 	}
 	else
 	{
@@ -1267,7 +1525,7 @@ void FilterLeaf
 			// another call to FilterLeaf with iNode = leaf this falls into in the
 			// back tree and EdPoly = the final EdPoly to insert.
 			CoplanarInfo.ProcessingBack=1;
-			FilterEdPoly( FilterFunc, Model, CoplanarInfo.iBackNode, EdPoly,CoplanarInfo, CoplanarInfo.BackNodeOutside );
+			FilterEdPoly( FilterFunc, Model, CoplanarInfo.iBackNode, EdPoly,CoplanarInfo, CoplanarInfo.BackNodeOutside, Result );
 		}
 	}
 }
@@ -1286,7 +1544,8 @@ void FilterEdPoly
 	INT			    iNode, 
 	FPoly			*EdPoly, 
 	FCoplanarInfo	CoplanarInfo, 
-	INT				Outside
+	INT				Outside,
+	FBspFilterResult* Result
 )
 {
 	INT            SplitResult,iOurFront,iOurBack;
@@ -1300,7 +1559,7 @@ void FilterEdPoly
 		EdPoly->SplitInHalf(&Temp);
 
 		// Filter other half.
-		FilterEdPoly( FilterFunc, Model, iNode, &Temp, CoplanarInfo, Outside );
+		FilterEdPoly( FilterFunc, Model, iNode, &Temp, CoplanarInfo, Outside, Result );
 	}
 
 	// Split em.
@@ -1324,7 +1583,8 @@ void FilterEdPoly
 
 		if( Node->iFront == INDEX_NONE )
 		{
-			FilterLeaf(FilterFunc,Model,iNode,EdPoly,CoplanarInfo,Outside,NODE_Front);
+			RecordEmptyChild(Result,iNode,1);
+			FilterLeaf(FilterFunc,Model,iNode,EdPoly,CoplanarInfo,Outside,NODE_Front,Result);
 		}
 		else
 		{
@@ -1339,7 +1599,8 @@ void FilterEdPoly
 
 		if( Node->iBack == INDEX_NONE )
 		{
-			FilterLeaf( FilterFunc, Model, iNode, EdPoly, CoplanarInfo, Outside, NODE_Back );
+			RecordEmptyChild( Result, iNode, 0 );
+			FilterLeaf( FilterFunc, Model, iNode, EdPoly, CoplanarInfo, Outside, NODE_Back, Result );
 		}
 		else
 		{
@@ -1355,7 +1616,10 @@ void FilterEdPoly
 			// coplanar threshold and is split up into a new polygon that is
 			// is barely inside the coplanar threshold.  To handle this, just classify
 			// it as front and it will be handled propery.
-			GErrors++;
+			if( Result )
+				Result->NumErrors++;
+			else
+				GErrors++;
 			debugf( NAME_Warning, TEXT("FilterEdPoly: Encountered out-of-place coplanar") );
 			goto Front;
 		}
@@ -1392,6 +1656,10 @@ void FilterEdPoly
 		}
 
 		// Process front and back.
+		if( Model->Nodes(iNode).iFront==INDEX_NONE )
+			RecordEmptyChild( Result, iNode, 1 );
+		if( Model->Nodes(iNode).iBack==INDEX_NONE )
+			RecordEmptyChild( Result, iNode, 0 );
 		if ((iOurFront==INDEX_NONE)&&(iOurBack==INDEX_NONE))
 		{
 			// No front or back.
@@ -1405,7 +1673,8 @@ void FilterEdPoly
 				EdPoly,
 				CoplanarInfo,
 				CoplanarInfo.BackNodeOutside,
-				NODE_Plane
+				NODE_Plane,
+				Result
 			);
 		}
 		else if( iOurFront==INDEX_NONE && iOurBack!=INDEX_NONE )
@@ -1451,6 +1720,7 @@ void FilterEdPoly
 
 		if( Model->Nodes(iNode).iFront==INDEX_NONE )
 		{
+			RecordEmptyChild( Result, iNode, 1 );
 			FilterLeaf
 			(
 				FilterFunc,
@@ -1459,7 +1729,8 @@ void FilterEdPoly
 				&TempFrontEdPoly,
 				CoplanarInfo,
 				NewFrontOutside,
-				NODE_Front
+				NODE_Front,
+				Result
 			);
 		}
 		else
@@ -1471,13 +1742,15 @@ void FilterEdPoly
 				Model->Nodes(iNode).iFront,
 				&TempFrontEdPoly,
 				CoplanarInfo,
-				NewFrontOutside
+				NewFrontOutside,
+				Result
 			);
 		}
 
 		// Back half of split.
 		if( Model->Nodes(iNode).iBack==INDEX_NONE )
 		{
+			RecordEmptyChild( Result, iNode, 0 );
 			FilterLeaf
 			(
 				FilterFunc,
@@ -1486,7 +1759,8 @@ void FilterEdPoly
 				&TempBackEdPoly,
 				CoplanarInfo,
 				NewBackOutside,
-				NODE_Back
+				NODE_Back,
+				Result
 			);
 		}
 		else
@@ -1498,7 +1772,8 @@ void FilterEdPoly
 				Model->Nodes(iNode).iBack,
 				&TempBackEdPoly,
 				CoplanarInfo,
-				NewBackOutside
+				NewBackOutside,
+				Result
 			);
 		}
 	}
@@ -1524,6 +1799,90 @@ void BspFilterFPoly( BSP_FILTER_FUNC FilterFunc, UModel *Model, FPoly *EdPoly )
 	}
 }
 
+//
+// Filters one of the EdPolys passed to BspFilterFPolys.
+//
+class FBspFilterPolysBody : public FParallelForBody
+{
+public:
+	UModel*						Model;
+	const TArray<FPoly>&		EdPolys;
+	TArray<FBspFilterResult>&	Results;
+
+	// Constructor.
+	FBspFilterPolysBody( UModel* InModel, const TArray<FPoly>& InEdPolys, TArray<FBspFilterResult>& InResults )
+	:	Model( InModel )
+	,	EdPolys( InEdPolys )
+	,	Results( InResults )
+	{}
+
+	// FParallelForBody interface.
+	virtual void Execute( INT Index )
+	{
+		FPoly EdPoly = EdPolys(Index);
+		FCoplanarInfo StartingCoplanarInfo;
+		StartingCoplanarInfo.iOriginalNode = INDEX_NONE;
+		FilterEdPoly( NULL, Model, 0, &EdPoly, StartingCoplanarInfo, Model->RootOutside, &Results(Index) );
+	}
+};
+
+//
+// Filter the EdPolys through the Bsp concurrently, recording the chunks they
+// fall into instead of calling a filter function; see BspApplyFilterResult.
+// Only reads the Bsp.  Leaves Results empty if the Bsp is empty, as the first
+// EdPoly added to it would become its root.
+//
+void BspFilterFPolys( UModel* Model, const TArray<FPoly>& EdPolys, TArray<FBspFilterResult>& Results )
+{
+	Results.Empty( EdPolys.Num() );
+	if( Model->Nodes.Num() == 0 )
+		return;
+	for( INT i=0; i<EdPolys.Num(); i++ )
+		new(Results)FBspFilterResult;
+
+	// FPoly::SplitWithPlane logs slivers.
+	FParallelForLog		ParallelLog;
+	FBspFilterPolysBody	Body( Model, EdPolys, Results );
+	appParallelFor( EdPolys.Num(), Body );
+}
+
+IMPLEMENT_COMPARE_CONSTREF( INT, UnBsp, { return A - B; } )
+
+//
+// Call the filter function for the chunks BspFilterFPolys recorded for EdPoly,
+// giving them its iLink, in the order BspFilterFPoly would.  Filters EdPoly
+// again if nodes have been added where the chunks went since, or the filter
+// function may add nodes one chunk depends on for another, as the chunks
+// would then be split further.  Result may be NULL to just filter EdPoly.
+//
+void BspApplyFilterResult( BSP_FILTER_FUNC FilterFunc, UModel* Model, FPoly* EdPoly, FBspFilterResult* Result )
+{
+	UBOOL Valid = Result != NULL;
+	if( Valid && Result->EmptyChildren.Num() )
+	{
+		TArray<INT>& EmptyChildren = Result->EmptyChildren;
+		Sort<USE_COMPARE_CONSTREF(INT,UnBsp)>( &EmptyChildren(0), EmptyChildren.Num() );
+		for( INT i=0; i<EmptyChildren.Num() && Valid; i++ )
+		{
+			FBspNode& Node = Model->Nodes( EmptyChildren(i) / 2 );
+			if( (i>0 && EmptyChildren(i)==EmptyChildren(i-1))
+			||	((EmptyChildren(i) & 1) ? Node.iFront : Node.iBack) != INDEX_NONE )
+				Valid = 0;
+		}
+	}
+	if( Valid )
+	{
+		for( INT i=0; i<Result->Fragments.Num(); i++ )
+		{
+			FBspFilterFragment& Fragment = Result->Fragments(i);
+			Fragment.EdPoly.iLink = EdPoly->iLink;
+			FilterFunc( Model, Fragment.iNode, &Fragment.EdPoly, Fragment.Filter, Fragment.NodePlace );
+		}
+		GErrors += Result->NumErrors;
+	}
+	else BspFilterFPoly( FilterFunc, Model, EdPoly );
+}
+
 /*----------------------------------------------------------------------------
    Editor fundamentals.
 ----------------------------------------------------------------------------*/
@@ -1730,6 +2089,7 @@ int UEditorEngine::bspBrushCSG
 
 	// Prep the model.
 	Model->Modify();
+	FBspPointsGridScope GridScope( Model );
 	if( CSGOper==CSG_Subtract )
 		Model->NumZones = 0;
 
@@ -1794,17 +2154,26 @@ int UEditorEngine::bspBrushCSG
 		Brush->EmptyModel(1,1);
 
 		// Intersect and deintersect.
+		TArray<FBspFilterResult> Results;
+		BspFilterFPolys( Model, TempModel->Polys->Element, Results );
 		for( i=0; i<TempModel->Polys->Element.Num(); i++ )
 		{
          	FPoly EdPoly = TempModel->Polys->Element(i);
 			GModel = Brush;
-			BspFilterFPoly( CSGOper==CSG_Intersect ? IntersectBrushWithWorldFunc : DeIntersectBrushWithWorldFunc, Model,  &EdPoly );
+			BspApplyFilterResult( CSGOper==CSG_Intersect ? IntersectBrushWithWorldFunc : DeIntersectBrushWithWorldFunc, Model, &EdPoly, Results.Num() ? &Results(i) : NULL );
 		}
 		NumPolysFromBrush = Brush->Polys->Element.Num();
 	}
 	else
 	{
-		// Add and subtract.
+		// Add and subtract.  The polys are filtered through the world as it is before
+		// adding any of them; BspApplyFilterResult filters again the ones that go
+		// where the polys before them have added nodes.
+		TArray<FPoly> EdPolys = TempModel->Polys->Element;
+		for( i=0; i<EdPolys.Num(); i++ )
+			EdPolys(i).PolyFlags &= ~(PF_EdCut);
+		TArray<FBspFilterResult> Results;
+		BspFilterFPolys( Model, EdPolys, Results );
 		for( i=0; i<Brush->Polys->Element.Num(); i++ )
 		{
          	FPoly EdPoly = TempModel->Polys->Element(i);
@@ -1823,7 +2192,7 @@ int UEditorEngine::bspBrushCSG
 			}
 
 			// Filter brush through the world.
-			BspFilterFPoly( CSGOper==CSG_Add ? AddBrushToWorldFunc : SubtractBrushFromWorldFunc, Model, &EdPoly );
+			BspApplyFilterResult( CSGOper==CSG_Add ? AddBrushToWorldFunc : SubtractBrushFromWorldFunc, Model, &EdPoly, Results.Num() ? &Results(i) : NULL );
 		}
 	}
 	if( Model->Nodes.Num() && !(PolyFlags & (PF_NotSolid | PF_Semisolid)) )
@@ -2342,21 +2711,18 @@ void MergeNearPoints( UModel *Model, FLOAT Dist )
 	INT* PointRemap = new(GMem,Model->Points.Num())INT;
 	INT Merged=0,Collapsed=0;
 
-	// Find nearer point for all points.
+	// Find nearer point for all points, among the points before them.
+	FBspPointsGrid Grid( Model->Points, BSP_POINTS_GRID_CELL_SIZE );
 	for( INT i=0; i<Model->Points.Num(); i++ )
 	{
 		PointRemap[i] = i;
-		FVector &Point = Model->Points(i);
-		for( INT j=0; j<i; j++ )
+		INT j = Grid.FindPointInSphere( Model->Points(i), Dist );
+		if( j != INDEX_NONE )
 		{
-			FVector &TestPoint = Model->Points(j);
-			if( (TestPoint - Point).SizeSquared() < Dist*Dist )
-			{
-				PointRemap[i] = j;
-				Merged++;
-				break;
-			}
+			PointRemap[i] = j;
+			Merged++;
 		}
+		Grid.IndexPoints( i+1 );
 	}
 
 	// Remap VertPool.
@@ -2402,6 +2768,7 @@ void MergeNearPoints( UModel *Model, FLOAT Dist )
 void UEditorEngine::bspOptGeom( UModel *Model )
 {
 	FPointVertList PointVerts;
+	DOUBLE StartTime = appSeconds();
 
 	debugf( NAME_Log, TEXT("BspOptGeom begin") );
 
@@ -2539,6 +2906,7 @@ void UEditorEngine::bspOptGeom( UModel *Model )
 
 	bspRefresh(Model,0);
 
+	debugf( NAME_Log, TEXT("BspOptGeom took %.3f seconds"), appSeconds() - StartTime );
 }
 
 /*---------------------------------------------------------------------------------------
@@ -2664,6 +3032,9 @@ void UEditorEngine::bspRefresh( UModel *Model, int NoRemapSurfs )
 	debugf( NAME_Log, TEXT("Vectors: %i -> %i"), Model->Vectors.Num(), n );
 	Model->Vectors.Remove( n, Model->Vectors.Num()-n );
 
+	// The remaining points and vectors moved, so grids indexing them start over.
+	FBspPointsGrid::InvalidateModel( Model );
+
 	// Update Bsp surfs.
 	for( i=0; i<Model->Surfs.Num(); i++ )
 	{
@@ -0,0 +1,138 @@
+/*=============================================================================
+	UnBspPoints.h: Spatial index of the point and vector tables of a Bsp.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/*-----------------------------------------------------------------------------
+	Definitions.
+-----------------------------------------------------------------------------*/
+
+/** Size of the cells of the grid indexing UModel::Points, in world units */
+#define BSP_POINTS_GRID_CELL_SIZE		1.f
+/** Size of the cells of the grid indexing UModel::Vectors */
+#define BSP_VECTORS_GRID_CELL_SIZE		(1.f / 64.f)
+
+/*-----------------------------------------------------------------------------
+	FBspPointsGrid.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Grid hash over a point or vector table, finding the same entries as a scan
+ * of the whole table would.
+ *
+ * The grid indexes the entries added to the table since the last query, so the
+ * table can be appended to directly. If the table shrank, as it does when
+ * bspRefresh removes unreferenced entries, the grid is rebuilt. Entries that
+ * are modified in place aren't noticed, Invalidate has to be called for those.
+ */
+class FBspPointsGrid
+{
+public:
+	/** Grid indexing the points of the model being built, NULL outside of Bsp operations */
+	static FBspPointsGrid* GBspPoints;
+	/** Grid indexing the vectors of the model being built, NULL outside of Bsp operations */
+	static FBspPointsGrid* GBspVectors;
+
+	/** Table this grid indexes */
+	TArray<FVector>& Table;
+
+	/**
+	 * Constructor.
+	 *
+	 * @param	InTable		Table to index
+	 * @param	InCellSize	Size of the cells, ideally a few times the largest threshold used
+	 */
+	FBspPointsGrid( TArray<FVector>& InTable, FLOAT InCellSize );
+
+	/**
+	 * Finds the first entry differing from a vector by less than a threshold on
+	 * all axes, indexing entries added to the table since the last query first.
+	 *
+	 * @param	V			Vector to look for
+	 * @param	Thresh		Maximum difference on any axis
+	 * @return	lowest index of a matching entry, or INDEX_NONE
+	 */
+	INT FindPoint( const FVector& V, FLOAT Thresh );
+
+	/**
+	 * Finds the first indexed entry closer to a point than a distance. Doesn't
+	 * index entries added to the table, see IndexPoints.
+	 *
+	 * @param	V			Point to look for
+	 * @param	Dist		Distance entries have to be closer than
+	 * @return	lowest index of a matching entry, or INDEX_NONE
+	 */
+	INT FindPointInSphere( const FVector& V, FLOAT Dist );
+
+	/**
+	 * Indexes the entries of the table up to an index.
+	 *
+	 * @param	Num		Number of leading entries of the table to index
+	 */
+	void IndexPoints( INT Num );
+
+	/**
+	 * Forgets all indexed entries, so they are indexed again by the next query.
+	 */
+	void Invalidate();
+
+	/**
+	 * Returns the active grid indexing a table, if any.
+	 *
+	 * @param	InTable		Table to find the grid of
+	 * @return	GBspPoints or GBspVectors if they index the table, NULL otherwise
+	 */
+	static FBspPointsGrid* GetGrid( const TArray<FVector>& InTable );
+
+	/**
+	 * Invalidates the active grids indexing the tables of a model.
+	 */
+	static void InvalidateModel( UModel* Model );
+
+private:
+	/** Size of the cells */
+	FLOAT			CellSize;
+	/** Number of leading entries of the table that are indexed */
+	INT				NumIndexed;
+	/** Last entry of each hash bucket, INDEX_NONE for empty buckets */
+	TArray<INT>		HashFirst;
+	/** Previous entry of the bucket of each entry, INDEX_NONE for the first one */
+	TArray<INT>		HashNext;
+
+	/** Returns the cell coordinate of a vector component */
+	INT GetCell( FLOAT Value ) const;
+	/** Returns the bucket of a cell */
+	INT GetBucket( INT X, INT Y, INT Z ) const;
+	/** Redistributes the indexed entries over twice as many buckets */
+	void GrowHash();
+	/** Finds the lowest indexed entry within Thresh on all axes and within Dist if Dist is positive */
+	INT FindFirst( const FVector& V, FLOAT Thresh, FLOAT Dist ) const;
+};
+
+/*-----------------------------------------------------------------------------
+	FBspPointsGridScope.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Makes GBspPoints and GBspVectors index the tables of a model while in scope.
+ * Nested scopes for the same model keep using the grids of the outer scope.
+ */
+class FBspPointsGridScope
+{
+public:
+	FBspPointsGridScope( UModel* Model );
+	~FBspPointsGridScope();
+
+private:
+	/** Grids created by this scope, NULL if an outer scope already indexes the model */
+	FBspPointsGrid*	Points;
+	FBspPointsGrid*	Vectors;
+	/** Grids active before this scope */
+	FBspPointsGrid*	OldPoints;
+	FBspPointsGrid*	OldVectors;
+};
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -9,6 +9,7 @@ Revision history:
 #include "EditorPrivate.h"
 #include "UnLinker.h"
 #include "UnConsoleTools.h"
+#include "UnPackageWorkers.h"
 
 /*-----------------------------------------------------------------------------
 	UCookPackagesXenon commandlet.
@@ -75,43 +76,60 @@ INT UCookPackagesXenon::Main( const TCHAR* Parms )
 		return 0;
 	}
 
-	// Retrieve list of all packages in .ini paths.
-	TArray<FString> PackageList = GPackageFileCache->GetPackageFileList();
-
 	// Create folder for cooked data.
 	FString CookedDir = appGameDir() + TEXT("CookedXenon\\");
-	if( !GFileManager->MakeDirectory( *CookedDir ) )
+	UBOOL CookedDirExists = GFileManager->MakeDirectory( *CookedDir );
+	if( !CookedDirExists )
 	{
 		warnf(NAME_Log, TEXT("Couldn't create %s"), *CookedDir );
-		PackageList.Empty();
 	}
 
 	// Remote base folder.
 	FString RemoteBaseFolder = TEXT("E:\\UnrealEngine3");
 	Parse( appCmdLine(), TEXT("BASEDIR=" ), RemoteBaseFolder );
 
+	// Workers started by a coordinator process the packages they were assigned.
+	FPackageWorkers Workers( this );
+	if( !Workers.IsWorker() && CookedDirExists )
+	{
+		// Retrieve list of all packages in .ini paths.
+		TArray<FString> PackageList = GPackageFileCache->GetPackageFileList();
+
+		TArray<FString> CookList;
+		for( INT PackageIndex = 0; PackageIndex < PackageList.Num(); PackageIndex++ )
+		{
+			const FFilename&	InFilename		= PackageList(PackageIndex);
+			FFilename			OutFilename		= CookedDir + InFilename.GetBaseFilename() + TEXT(".xxx");
+
+			DOUBLE				OutFileAge		= GFileManager->GetFileAgeSeconds( *OutFilename );
+			DOUBLE				InFileAge		= GFileManager->GetFileAgeSeconds( *InFilename );
+			UBOOL				OutFileExists	= GFileManager->FileSize( *OutFilename ) > 0;
+			UBOOL				OutFileNewer	= OutFileAge < InFileAge;
+
+			// Skip over unchanged files.
+			if( OutFileExists && OutFileNewer )
+			{
+				warnf(NAME_Log, TEXT("Skipping %s"), *InFilename);
+			}
+			else
+			{
+				new(CookList) FString( InFilename );
+			}
+		}
+
+		// Cooked packages are saved to a separate folder, so their sources can be loaded while they are saved.
+		if( Workers.Distribute( CookList, 0 ) )
+			Workers.Packages.Empty();
+	}
+
 	// Iterate over all packages.
-	for( INT PackageIndex = 0; PackageIndex < PackageList.Num(); PackageIndex++ )
+	for( INT PackageIndex = 0; PackageIndex < Workers.Packages.Num(); PackageIndex++ )
 	{
-		const FFilename&	InFilename		= PackageList(PackageIndex);
+		const FFilename&	InFilename		= Workers.Packages(PackageIndex);
 		FFilename			OutFilename		= CookedDir + InFilename.GetBaseFilename() + TEXT(".xxx");
 		FFilename			XenonFilename	= (appGameDir() + TEXT("CookedContent\\") + InFilename.GetBaseFilename() + TEXT(".xxx")).Replace( TEXT(".."), *RemoteBaseFolder );
-		
-		DOUBLE				OutFileAge		= GFileManager->GetFileAgeSeconds( *OutFilename );
-		DOUBLE				InFileAge		= GFileManager->GetFileAgeSeconds( *InFilename );
-		UBOOL				OutFileExists	= GFileManager->FileSize( *OutFilename ) > 0;
-		UBOOL				OutFileNewer	= OutFileAge < InFileAge;
 
-		// Skip over unchanged files.
-		if( OutFileExists && OutFileNewer )
-		{
-			warnf(NAME_Log, TEXT("Skipping %s"), *InFilename);
-			continue;
-		}
-		else
-		{
-			warnf(NAME_Log, TEXT("Loading %s"), *InFilename);
-		}
+		warnf(NAME_Log, TEXT("Loading %s"), *InFilename);
 
 		UPackage* Package = Cast<UPackage>(UObject::LoadPackage( NULL, *InFilename, 0 ));
 		if( Package )
@@ -256,7 +274,7 @@ INT UCookPackagesXenon::Main( const TCHAR* Parms )
 			warnf(NAME_Log, TEXT("Failed loading %s"), *InFilename);
 		}
 
-		UObject::CollectGarbage(RF_Native);
+		Workers.CollectGarbage( PackageIndex );
 	}
 
 	DestroyTextureCooker( TextureCooker );
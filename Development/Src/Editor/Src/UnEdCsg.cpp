@@ -260,6 +260,10 @@ void UEditorEngine::csgRebuild( ULevel* Level )
 {
 	GWarn->BeginSlowTask( TEXT("Rebuilding geometry"), 1 );
 	FastRebuild = 1;
+	DOUBLE StartTime = appSeconds();
+
+	// Look up points and vectors through grids instead of scanning the tables.
+	FBspPointsGridScope GridScope( Level->Model );
 
 	UBOOL bVisibleOnly = GRebuildTools.GetCurrent()->Options & REBUILD_OnlyVisible;
 
@@ -344,6 +348,7 @@ void UEditorEngine::csgRebuild( ULevel* Level )
 
 	// Done.
 	FastRebuild = 0;
+	debugf( NAME_Log, TEXT("Map: Rebuilt geometry in %.3f seconds, %i nodes, %i points, %i vectors"), appSeconds() - StartTime, Level->Model->Nodes.Num(), Level->Model->Points.Num(), Level->Model->Vectors.Num() );
 	GWarn->EndSlowTask();
 }
 
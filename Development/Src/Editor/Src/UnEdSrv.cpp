@@ -326,11 +326,13 @@ UBOOL UEditorEngine::Exec_StaticMesh( const TCHAR* Str, FOutputDevice& Ar )
 
 		GWarn->BeginSlowTask(TEXT("Smoothing static meshes"),1);
 
+		TArray<UStaticMesh*>	StaticMeshes;
+
 		for(INT ActorIndex = 0;ActorIndex < Level->Actors.Num();ActorIndex++)
 		{
 			AStaticMeshActor*	Actor = Cast<AStaticMeshActor>(Level->Actors(ActorIndex));
 
-			if(Actor && GSelectionTools.IsSelected( Actor ) && Actor->StaticMeshComponent->StaticMesh)
+			if(Actor && GSelectionTools.IsSelected( Actor ) && Actor->StaticMeshComponent->StaticMesh && StaticMeshes.FindItemIndex(Actor->StaticMeshComponent->StaticMesh) == INDEX_NONE)
 			{
 				UStaticMesh*	StaticMesh = Actor->StaticMeshComponent->StaticMesh;
 
@@ -344,12 +346,15 @@ UBOOL UEditorEngine::Exec_StaticMesh( const TCHAR* Str, FOutputDevice& Ar )
 				for(INT i = 0;i < StaticMesh->RawTriangles.Num();i++)
 					StaticMesh->RawTriangles(i).SmoothingMask = 1;
 
-				StaticMesh->Build();
-
-				StaticMesh->RawTriangles.Detach();
+				StaticMeshes.AddItem(StaticMesh);
 			}
 		}
 
+		UStaticMesh::BuildMeshes(StaticMeshes);
+
+		for(INT MeshIndex = 0;MeshIndex < StaticMeshes.Num();MeshIndex++)
+			StaticMeshes(MeshIndex)->RawTriangles.Detach();
+
 		GWarn->EndSlowTask();
 
 		Trans->End();
@@ -364,11 +369,13 @@ UBOOL UEditorEngine::Exec_StaticMesh( const TCHAR* Str, FOutputDevice& Ar )
 
 		GWarn->BeginSlowTask(TEXT("Unsmoothing static meshes"),1);
 
+		TArray<UStaticMesh*>	StaticMeshes;
+
 		for(INT ActorIndex = 0;ActorIndex < Level->Actors.Num();ActorIndex++)
 		{
 			AStaticMeshActor*	Actor = Cast<AStaticMeshActor>(Level->Actors(ActorIndex));
 
-			if(Actor && GSelectionTools.IsSelected( Actor ) && Actor->StaticMeshComponent->StaticMesh)
+			if(Actor && GSelectionTools.IsSelected( Actor ) && Actor->StaticMeshComponent->StaticMesh && StaticMeshes.FindItemIndex(Actor->StaticMeshComponent->StaticMesh) == INDEX_NONE)
 			{
 				UStaticMesh*	StaticMesh = Actor->StaticMeshComponent->StaticMesh;
 
@@ -386,12 +393,15 @@ UBOOL UEditorEngine::Exec_StaticMesh( const TCHAR* Str, FOutputDevice& Ar )
 					Triangle1.SmoothingMask = 0;
 				}
 
-				StaticMesh->Build();
-
-				StaticMesh->RawTriangles.Detach();
+				StaticMeshes.AddItem(StaticMesh);
 			}
 		}
 
+		UStaticMesh::BuildMeshes(StaticMeshes);
+
+		for(INT MeshIndex = 0;MeshIndex < StaticMeshes.Num();MeshIndex++)
+			StaticMeshes(MeshIndex)->RawTriangles.Detach();
+
 		GWarn->EndSlowTask();
 
 		Trans->End();
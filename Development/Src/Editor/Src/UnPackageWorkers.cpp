@@ -0,0 +1,425 @@
+/*=============================================================================
+	UnPackageWorkers.cpp: Distribution of package commandlets over processes.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "EditorPrivate.h"
+#include "UnLinker.h"
+#include "UnPackageWorkers.h"
+
+/*-----------------------------------------------------------------------------
+	FPackageWorkers.
+-----------------------------------------------------------------------------*/
+
+FPackageWorkers::FPackageWorkers( UCommandlet* InCommandlet )
+:	Commandlet( InCommandlet )
+,	NumWorkers( 0 )
+{
+	Parse( appCmdLine(), TEXT("WORKERS="), NumWorkers );
+	if( Parse( appCmdLine(), TEXT("WORKERLIST="), WorkerList ) )
+	{
+		// Each line lists a package followed by the names of the packages it imports.
+		FString Text;
+		if( !appLoadFileToString( Text, *(FString(appBaseDir()) + appGameLogDir() + WorkerList) ) )
+			appErrorf( TEXT("Couldn't read worker list %s"), *WorkerList );
+
+		const TCHAR* Str = *Text;
+		FString Line;
+		while( ParseLine( &Str, Line ) )
+		{
+			const TCHAR* LineStr = *Line;
+			FString Token;
+			if( !ParseToken( LineStr, Token, 0 ) )
+				continue;
+			new(Packages) FString( Token );
+			while( ParseToken( LineStr, Token, 0 ) )
+				LastImports.Set( FName(*Token), Packages.Num() - 1 );
+		}
+	}
+}
+
+UBOOL FPackageWorkers::Distribute( const TArray<FString>& InPackages, UBOOL bInPlace )
+{
+	check(!IsWorker());
+	if( NumWorkers <= 0 || !InPackages.Num() )
+	{
+		Packages = InPackages;
+		return 0;
+	}
+
+	DOUBLE StartTime = appSeconds();
+	for( INT PackageIndex=0; PackageIndex<InPackages.Num(); PackageIndex++ )
+	{
+		if( AddScannedPackage( InPackages(PackageIndex), 1 ) == INDEX_NONE )
+		{
+			warnf( TEXT("Several packages are named like %s, processing them in this process"), *InPackages(PackageIndex) );
+			Packages = InPackages;
+			return 0;
+		}
+	}
+	ScanImports();
+
+	INT NumWaves = AssignWaves( bInPlace );
+	if( !NumWaves )
+	{
+		Packages = InPackages;
+		return 0;
+	}
+	warnf( NAME_Log, TEXT("Distributing %i packages over %i workers in %i waves, scanning imports took %.2f seconds"), InPackages.Num(), NumWorkers, NumWaves, appSeconds() - StartTime );
+
+	// Workers can't replace files this process has open.
+	if( bInPlace )
+		UObject::ResetLoaders( NULL, 0, 1 );
+
+	INT NumFailed = 0;
+	for( INT Wave=0; Wave<NumWaves; Wave++ )
+	{
+		// Packages loaded on startup are loaded by all workers, so they're saved by a single worker once all others are done.
+		UBOOL bResidentWave = 0;
+		for( INT PackageIndex=0; PackageIndex<InPackages.Num(); PackageIndex++ )
+			bResidentWave |= bInPlace && Scanned(PackageIndex).bResident && Scanned(PackageIndex).Wave == Wave;
+		NumFailed += RunWave( Wave, bResidentWave ? 1 : NumWorkers );
+	}
+	if( NumFailed )
+		warnf( NAME_Log, TEXT("%i workers failed"), NumFailed );
+	warnf( NAME_Log, TEXT("Workers finished in %.2f seconds"), appSeconds() - StartTime );
+	return 1;
+}
+
+void FPackageWorkers::CollectGarbage( INT PackageIndex )
+{
+	// Commandlets don't run the engine loop so each package counts as a frame of the frame arena.
+	GFrameArena.Tick();
+
+	if( !LastImports.Num() )
+	{
+		UObject::CollectGarbage( RF_Native );
+		return;
+	}
+
+	// Keep the packages the following packages import loaded instead of loading them again.
+	for( FObjectIterator It; It; ++It )
+	{
+		INT* LastImport = LastImports.Find( It->GetOutermost()->GetFName() );
+		if( LastImport && *LastImport > PackageIndex )
+			It->SetFlags( RF_Marked );
+		else
+			It->ClearFlags( RF_Marked );
+	}
+	UObject::CollectGarbage( RF_Native | RF_Marked );
+}
+
+INT FPackageWorkers::AddScannedPackage( const FString& Filename, UBOOL bProcess )
+{
+	FName Name( *FFilename(Filename).GetBaseFilename() );
+	if( ScannedIndices.Find( Name ) )
+		return INDEX_NONE;
+
+	INT Index = Scanned.Num();
+	FScannedPackage* Package = new(Scanned) FScannedPackage;
+	Package->Name		= Name;
+	Package->Filename	= Filename;
+	Package->Size		= Max( GFileManager->FileSize( *Filename ), 1 );
+	Package->bProcess	= bProcess;
+	Package->bResident	= FindObject<UPackage>( NULL, *Name ) != NULL;
+	Package->Wave		= 0;
+	ScannedIndices.Set( Name, Index );
+	return Index;
+}
+
+void FPackageWorkers::ScanImports()
+{
+	// Scanned grows while it is iterated, adding the packages that are imported.
+	for( INT ScannedIndex=0; ScannedIndex<Scanned.Num(); ScannedIndex++ )
+	{
+		TArray<FName> ImportNames;
+		UObject::BeginLoad();
+		ULinkerLoad* Linker = UObject::GetPackageLinker( NULL, *Scanned(ScannedIndex).Filename, LOAD_NoWarn | LOAD_NoVerify | LOAD_Quiet, NULL, NULL );
+		UObject::EndLoad();
+		if( !Linker )
+			continue;
+		for( INT ImportIndex=0; ImportIndex<Linker->ImportMap.Num(); ImportIndex++ )
+		{
+			const FObjectImport& Import = Linker->ImportMap(ImportIndex);
+			if( Import.ClassName == NAME_Package && Import.PackageIndex == 0 )
+				ImportNames.AddUniqueItem( Import.ObjectName );
+		}
+		if( !Scanned(ScannedIndex).bResident )
+			UObject::ResetLoaders( Linker->LinkerRoot, 0, 1 );
+
+		for( INT NameIndex=0; NameIndex<ImportNames.Num(); NameIndex++ )
+		{
+			INT* ScannedImport = ScannedIndices.Find( ImportNames(NameIndex) );
+			INT ImportIndex = ScannedImport ? *ScannedImport : INDEX_NONE;
+			FString ImportFilename;
+			if( ImportIndex == INDEX_NONE && GPackageFileCache->FindPackageFile( *ImportNames(NameIndex), NULL, ImportFilename ) )
+				ImportIndex = AddScannedPackage( ImportFilename, 0 );
+			if( ImportIndex != INDEX_NONE && ImportIndex != ScannedIndex )
+				Scanned(ScannedIndex).Imports.AddUniqueItem( ImportIndex );
+		}
+	}
+
+	// Gather what each package to process imports directly or indirectly.
+	TArray<INT> Visited;
+	Visited.AddZeroed( Scanned.Num() );
+	for( INT ScannedIndex=0; ScannedIndex<Scanned.Num() && Scanned(ScannedIndex).bProcess; ScannedIndex++ )
+	{
+		FScannedPackage& Package = Scanned(ScannedIndex);
+		Visited(ScannedIndex) = ScannedIndex + 1;
+		Package.Dependencies = Package.Imports;
+		for( INT DependencyIndex=0; DependencyIndex<Package.Dependencies.Num(); DependencyIndex++ )
+			Visited(Package.Dependencies(DependencyIndex)) = ScannedIndex + 1;
+		for( INT DependencyIndex=0; DependencyIndex<Package.Dependencies.Num(); DependencyIndex++ )
+		{
+			const TArray<INT>& Imports = Scanned(Package.Dependencies(DependencyIndex)).Imports;
+			for( INT ImportIndex=0; ImportIndex<Imports.Num(); ImportIndex++ )
+			{
+				if( Visited(Imports(ImportIndex)) != ScannedIndex + 1 )
+				{
+					Visited(Imports(ImportIndex)) = ScannedIndex + 1;
+					Package.Dependencies.AddItem( Imports(ImportIndex) );
+				}
+			}
+		}
+	}
+}
+
+INT FPackageWorkers::AssignWaves( UBOOL bInPlace )
+{
+	if( !bInPlace )
+		return 1;
+
+	INT NumProcess = 0;
+	while( NumProcess < Scanned.Num() && Scanned(NumProcess).bProcess )
+		NumProcess++;
+
+	// A package saved in place is processed in a later wave than all packages loading it. Packages loaded on
+	// startup go last, as every worker has them open.
+	TArray<INT> NumImporters;
+	NumImporters.AddZeroed( NumProcess );
+	for( INT PackageIndex=0; PackageIndex<NumProcess; PackageIndex++ )
+	{
+		const TArray<INT>& Dependencies = Scanned(PackageIndex).Dependencies;
+		for( INT DependencyIndex=0; DependencyIndex<Dependencies.Num(); DependencyIndex++ )
+			if( Dependencies(DependencyIndex) < NumProcess )
+				NumImporters(Dependencies(DependencyIndex))++;
+	}
+
+	TArray<INT> Ready, NextReady;
+	for( INT PackageIndex=0; PackageIndex<NumProcess; PackageIndex++ )
+		if( !NumImporters(PackageIndex) )
+			Ready.AddItem( PackageIndex );
+
+	INT NumWaves = 0, NumAssigned = 0;
+	UBOOL bAnyResident = 0;
+	while( Ready.Num() )
+	{
+		for( INT ReadyIndex=0; ReadyIndex<Ready.Num(); ReadyIndex++ )
+		{
+			FScannedPackage& Package = Scanned(Ready(ReadyIndex));
+			Package.Wave = NumWaves;
+			bAnyResident |= Package.bResident;
+			NumAssigned++;
+			for( INT DependencyIndex=0; DependencyIndex<Package.Dependencies.Num(); DependencyIndex++ )
+				if( Package.Dependencies(DependencyIndex) < NumProcess && --NumImporters(Package.Dependencies(DependencyIndex)) == 0 )
+					NextReady.AddItem( Package.Dependencies(DependencyIndex) );
+		}
+		ExchangeArray( Ready, NextReady );
+		NextReady.Empty();
+		NumWaves++;
+	}
+
+	if( NumAssigned < NumProcess )
+	{
+		for( INT PackageIndex=0; PackageIndex<NumProcess; PackageIndex++ )
+			if( NumImporters(PackageIndex) )
+				warnf( NAME_Log, TEXT("%s is part of an import cycle"), *Scanned(PackageIndex).Filename );
+		warnf( TEXT("Packages import each other so they can't be saved in parallel, processing them in this process") );
+		return 0;
+	}
+
+	// Packages loaded on startup are always loaded, so deferring them doesn't break the order.
+	if( bAnyResident )
+	{
+		for( INT PackageIndex=0; PackageIndex<NumProcess; PackageIndex++ )
+			if( Scanned(PackageIndex).bResident )
+				Scanned(PackageIndex).Wave = NumWaves;
+		NumWaves++;
+	}
+	return NumWaves;
+}
+
+INT FPackageWorkers::RunWave( INT Wave, INT WaveNumWorkers )
+{
+	// Cost of processing a package is estimated by the size of the files loaded for it.
+	TArray<INT> WavePackages;
+	TArray<DOUBLE> Costs;
+	for( INT PackageIndex=0; PackageIndex<Scanned.Num() && Scanned(PackageIndex).bProcess; PackageIndex++ )
+	{
+		if( Scanned(PackageIndex).Wave == Wave )
+		{
+			DOUBLE Cost = Scanned(PackageIndex).Size;
+			for( INT DependencyIndex=0; DependencyIndex<Scanned(PackageIndex).Dependencies.Num(); DependencyIndex++ )
+				Cost += Scanned(Scanned(PackageIndex).Dependencies(DependencyIndex)).Size;
+
+			// Insertion sort by descending cost, so the largest packages are assigned first.
+			INT InsertIndex = WavePackages.Num();
+			while( InsertIndex > 0 && Costs(InsertIndex - 1) < Cost )
+				InsertIndex--;
+			WavePackages.Insert( InsertIndex );
+			Costs.Insert( InsertIndex );
+			WavePackages(InsertIndex) = PackageIndex;
+			Costs(InsertIndex) = Cost;
+		}
+	}
+	if( !WavePackages.Num() )
+		return 0;
+	WaveNumWorkers = Min( WaveNumWorkers, WavePackages.Num() );
+
+	// Assign each package to the worker that ends up with the least work, counting only the imports the worker
+	// doesn't already load for other packages. This groups packages sharing imports.
+	TArray<DOUBLE> Loads;
+	TArray<BYTE> Loaded;
+	TArray<FString> Lists;
+	Loads.AddZeroed( WaveNumWorkers );
+	Loaded.AddZeroed( WaveNumWorkers * Scanned.Num() );
+	for( INT WorkerIndex=0; WorkerIndex<WaveNumWorkers; WorkerIndex++ )
+		new(Lists) FString;
+	for( INT WaveIndex=0; WaveIndex<WavePackages.Num(); WaveIndex++ )
+	{
+		const FScannedPackage& Package = Scanned(WavePackages(WaveIndex));
+		INT BestWorker = 0;
+		DOUBLE BestLoad = 0.0;
+		for( INT WorkerIndex=0; WorkerIndex<WaveNumWorkers; WorkerIndex++ )
+		{
+			const BYTE* WorkerLoaded = &Loaded(WorkerIndex * Scanned.Num());
+			DOUBLE Load = Loads(WorkerIndex) + Package.Size;
+			for( INT DependencyIndex=0; DependencyIndex<Package.Dependencies.Num(); DependencyIndex++ )
+				if( !WorkerLoaded[Package.Dependencies(DependencyIndex)] )
+					Load += Scanned(Package.Dependencies(DependencyIndex)).Size;
+			if( WorkerIndex == 0 || Load < BestLoad )
+			{
+				BestWorker = WorkerIndex;
+				BestLoad = Load;
+			}
+		}
+
+		BYTE* WorkerLoaded = &Loaded(BestWorker * Scanned.Num());
+		Loads(BestWorker) = BestLoad;
+		for( INT DependencyIndex=0; DependencyIndex<Package.Dependencies.Num(); DependencyIndex++ )
+			WorkerLoaded[Package.Dependencies(DependencyIndex)] = 1;
+
+		FString& List = Lists(BestWorker);
+		List += FString::Printf( TEXT("\"%s\""), *Package.Filename );
+		for( INT DependencyIndex=0; DependencyIndex<Package.Dependencies.Num(); DependencyIndex++ )
+			List += FString::Printf( TEXT(" %s"), *Scanned(Package.Dependencies(DependencyIndex)).Name );
+		List += LINE_TERMINATOR;
+	}
+
+	// Workers get the command line of this process, apart from the options controlling workers and logs.
+	FString Parms = Commandlet->GetClass()->GetPathName();
+	const TCHAR* CmdLine = appCmdLine();
+	FString Token;
+	while( ParseToken( CmdLine, Token, 0 ) )
+	{
+		FString UpperToken = Token.Caps();
+		if( UpperToken.InStr(TEXT("WORKERS=")) != -1 || UpperToken.InStr(TEXT("LOG=")) != -1 )
+			continue;
+		Parms += Token.InStr(TEXT(" ")) != -1 ? FString::Printf( TEXT(" \"%s\""), *Token ) : US + TEXT(" ") + Token;
+	}
+
+	warnf( NAME_Log, TEXT("Wave %i: %i packages on %i workers"), Wave, WavePackages.Num(), WaveNumWorkers );
+	FString LogDir = FString(appBaseDir()) + appGameLogDir();
+	GFileManager->MakeDirectory( *LogDir, 1 );
+	TArray<void*> Handles;
+	TArray<FString> LogFilenames;
+	for( INT WorkerIndex=0; WorkerIndex<WaveNumWorkers; WorkerIndex++ )
+	{
+		FString BaseName = FString::Printf( TEXT("%s-Worker%i"), Commandlet->GetClass()->GetName(), WorkerIndex );
+		new(LogFilenames) FString( LogDir + BaseName + TEXT(".log") );
+		GFileManager->Delete( *LogFilenames(WorkerIndex) );
+		if( !appSaveStringToFile( Lists(WorkerIndex), *(LogDir + BaseName + TEXT(".txt")) ) )
+			appErrorf( TEXT("Couldn't write worker list %s"), *(LogDir + BaseName + TEXT(".txt")) );
+
+		FString WorkerParms = FString::Printf( TEXT("%s -silent -workerlist=%s.txt log=%s.log"), *Parms, *BaseName, *BaseName );
+		Handles.AddItem( appCreateProc( *FString::Printf(TEXT("\"%s\""), appExecutableName()), *WorkerParms ) );
+		if( !Handles(WorkerIndex) )
+			warnf( NAME_Error, TEXT("Couldn't start worker %i"), WorkerIndex );
+	}
+
+	// Wait for the workers, merging their logs as they finish.
+	INT NumFailed = 0;
+	INT NumRunning = WaveNumWorkers;
+	while( NumRunning )
+	{
+		appSleep( 0.1f );
+		for( INT WorkerIndex=0; WorkerIndex<WaveNumWorkers; WorkerIndex++ )
+		{
+			INT ReturnCode = 0;
+			if( !Handles(WorkerIndex) )
+			{
+				if( LogFilenames(WorkerIndex).Len() )
+				{
+					NumFailed++;
+					NumRunning--;
+					LogFilenames(WorkerIndex) = TEXT("");
+				}
+			}
+			else if( appGetProcReturnCode( Handles(WorkerIndex), &ReturnCode ) )
+			{
+				INT NumErrors = MergeLog( WorkerIndex, LogFilenames(WorkerIndex) );
+				if( ReturnCode != 0 )
+				{
+					// Errors the worker logged are counted already.
+					if( !NumErrors )
+						warnf( NAME_Error, TEXT("Worker %i exited with code %i"), WorkerIndex, ReturnCode );
+					NumFailed++;
+				}
+				Handles(WorkerIndex) = NULL;
+				LogFilenames(WorkerIndex) = TEXT("");
+				NumRunning--;
+			}
+		}
+	}
+	return NumFailed;
+}
+
+INT FPackageWorkers::MergeLog( INT WorkerIndex, const FString& LogFilename )
+{
+	FString Text;
+	if( !appLoadFileToString( Text, *LogFilename ) )
+	{
+		warnf( TEXT("Couldn't read log of worker %i, %s"), WorkerIndex, *LogFilename );
+		return 0;
+	}
+
+	// Lines are prefixed with the name of their event. Warnings and errors are logged as such so they are counted.
+	INT NumErrors = 0;
+	const TCHAR* Str = *Text;
+	FString Line;
+	while( ParseLine( &Str, Line ) )
+	{
+		INT Separator = Line.InStr( TEXT(": ") );
+		FString Event = Separator != -1 ? Line.Left( Separator ) : FString();
+		FString Message = Separator != -1 ? Line.Mid( Separator + 2 ) : Line;
+		if( Event == TEXT("Error") || Event == TEXT("Critical") )
+		{
+			GWarn->Logf( NAME_Error, TEXT("Worker %i: %s"), WorkerIndex, *Message );
+			NumErrors++;
+		}
+		else if( Event == TEXT("Warning") )
+		{
+			GWarn->Logf( NAME_Warning, TEXT("Worker %i: %s"), WorkerIndex, *Message );
+		}
+		else
+		{
+			GLog->Logf( NAME_Log, TEXT("Worker %i: %s"), WorkerIndex, *Message );
+		}
+	}
+	return NumErrors;
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
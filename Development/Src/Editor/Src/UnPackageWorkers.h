@@ -0,0 +1,112 @@
+/*=============================================================================
+	UnPackageWorkers.h: Distribution of package commandlets over processes.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/*-----------------------------------------------------------------------------
+	FPackageWorkers.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Distributes the packages a commandlet loads, processes and saves one at a time over
+ * worker processes running the same commandlet, requested with -workers=N. The object
+ * system isn't thread safe so the work is split across processes rather than threads.
+ *
+ * The coordinator scans the import tables of the packages and hands each worker a list
+ * of packages that share imports, so a worker keeps a package loaded for as long as
+ * packages on its list import it. Packages that are saved over their source are processed
+ * in waves, a package being processed once all packages importing it are done, so no
+ * worker reads a package while another one writes it. The logs of the workers are merged
+ * into the log of the coordinator.
+ */
+class FPackageWorkers
+{
+public:
+	/** Packages this process has to process, in order */
+	TArray<FString> Packages;
+
+	/**
+	 * Constructor, parsing -workers=N and, in worker processes, reading the list of packages.
+	 *
+	 * @param	InCommandlet	Commandlet the packages are processed by
+	 */
+	FPackageWorkers( UCommandlet* InCommandlet );
+
+	/**
+	 * Returns whether this process is a worker started by a coordinator.
+	 */
+	UBOOL IsWorker() const
+	{
+		return WorkerList.Len() > 0;
+	}
+
+	/**
+	 * Processes packages in worker processes if -workers=N was specified, waiting for them
+	 * to finish. Otherwise the packages are left for the caller to process.
+	 *
+	 * @param	InPackages	Packages to process
+	 * @param	bInPlace	Whether packages are saved over their source
+	 * @return	TRUE if the packages have been processed by workers, FALSE if they are in Packages
+	 */
+	UBOOL Distribute( const TArray<FString>& InPackages, UBOOL bInPlace );
+
+	/**
+	 * Collects garbage after a package has been processed, keeping the packages imported by
+	 * the following packages loaded in worker processes.
+	 *
+	 * @param	PackageIndex	Index of the processed package in Packages
+	 */
+	void CollectGarbage( INT PackageIndex );
+
+private:
+	/** A package file and what it imports */
+	struct FScannedPackage
+	{
+		/** Name of the package */
+		FName			Name;
+		/** File the package is loaded from */
+		FString			Filename;
+		/** Size of the file, estimating the cost of loading it */
+		INT				Size;
+		/** Whether the package is one of the packages to process */
+		UBOOL			bProcess;
+		/** Whether the package was loaded before the packages were distributed */
+		UBOOL			bResident;
+		/** Indices of the packages imported directly */
+		TArray<INT>		Imports;
+		/** Indices of the packages imported directly or indirectly */
+		TArray<INT>		Dependencies;
+		/** Wave the package is processed in */
+		INT				Wave;
+	};
+
+	/** Commandlet the packages are processed by */
+	UCommandlet*					Commandlet;
+	/** Number of worker processes to use, 0 to process packages in this process */
+	INT								NumWorkers;
+	/** Name of the list of packages of this worker, relative to the log directory */
+	FString							WorkerList;
+	/** Index of the last package on the list of this worker importing each package */
+	TMap<FName,INT>					LastImports;
+
+	/** Scanned packages, the packages to process first */
+	TArray<FScannedPackage>			Scanned;
+	/** Index of each package in Scanned */
+	TMap<FName,INT>					ScannedIndices;
+
+	/** Adds a package file to Scanned unless a package of that name already is, returns its index or INDEX_NONE */
+	INT AddScannedPackage( const FString& Filename, UBOOL bProcess );
+	/** Scans the import tables of the packages to process and of the packages they import */
+	void ScanImports();
+	/** Assigns the packages to waves, returns the number of waves or 0 if packages import each other */
+	INT AssignWaves( UBOOL bInPlace );
+	/** Runs workers for the packages of a wave, returns the number of workers that failed */
+	INT RunWave( INT Wave, INT WaveNumWorkers );
+	/** Forwards the log of a worker to the log of this process, returns the number of errors it contains */
+	INT MergeLog( INT WorkerIndex, const FString& LogFilename );
+};
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -1100,6 +1100,22 @@ UClass* FScriptCompiler::GetQualifiedClass( const TCHAR* Thing )
 	Fields.
 -----------------------------------------------------------------------------*/
 
+TMap<UClass*,TArray<UField*> > GScriptFieldReferences;
+
+//
+// Record that the class being compiled uses a field of another package.
+//
+void FScriptCompiler::AddFieldReference( UField* Field )
+{
+	if( Class && Field && Field->GetOutermost()!=Class->GetOutermost() )
+	{
+		TArray<UField*>* Fields = GScriptFieldReferences.Find( Class );
+		if( !Fields )
+			Fields = &GScriptFieldReferences.Set( Class, TArray<UField*>() );
+		Fields->AddUniqueItem( Field );
+	}
+}
+
 UField* FScriptCompiler::FindField
 (
 	UStruct*		Scope,
@@ -1124,6 +1140,7 @@ UField* FScriptCompiler::FindField
 							appThrowf( TEXT("%s: expecting %s, got %s"), Thing, FieldClass->GetName(), It->GetClass()->GetName() );
 						return NULL;
 					}
+					AddFieldReference( *It );
 					return *It;
 				}
 			}
@@ -2083,6 +2100,7 @@ UBOOL FScriptCompiler::CompileDynamicCast( const FToken& Token, FToken& ResultTy
 		UEnum* DestEnum = FindObject<UEnum>( ANY_PACKAGE, Token.Identifier );
 		if (DestEnum)
 		{
+			AddFieldReference( DestEnum );
 			// Get expression to cast, and ending paren.
 			FToken TempType;
 			FPropertyBase RequiredType( CPT_Byte );
@@ -3724,6 +3742,7 @@ UBOOL FScriptCompiler::GetVarType
 	else if( (Field = FindObject<UEnum>( ANY_PACKAGE, VarType.Identifier ))!=NULL )
 	{
 		// In-scope enumeration or struct.
+		AddFieldReference( Field );
 		VarProperty = FPropertyBase( CastChecked<UEnum>(Field) );
 	}
     else if( (Field = FindObject<UStruct>( ANY_PACKAGE, VarType.Identifier ))!=NULL )
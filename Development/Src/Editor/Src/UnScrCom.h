@@ -855,6 +855,7 @@ public:
 	void			CheckAllow( const TCHAR* Thing, DWORD AllowFlags );
 	void			CheckInScope( UObject* Obj );
 	UField*			FindField( UStruct* InScope, const TCHAR* InIdentifier, UClass* FieldClass=UField::StaticClass(), const TCHAR* Thing=NULL );
+	void			AddFieldReference( UField* Field );
 	INT				ConversionCost( const FPropertyBase& Dest, const FPropertyBase& Source );
 	void			SkipStatements( int SubCount, const TCHAR* ErrorTag );
 	UBOOL			GetVarType( UStruct* Scope, FPropertyBase& VarProperty, DWORD& ObjectFlags, QWORD Disallow, const TCHAR* Thing );
@@ -103,6 +103,26 @@ public:
 	}
 };
 
+//
+// A portal fragment found on a worker thread, added to the portal list later.
+//
+struct FPortalFragment
+{
+	FPoly	Poly;
+	INT		iFrontLeaf, iBackLeaf;
+};
+
+//
+// A node MakePortals generates portals for, in the order MakePortals visits them.
+//
+struct FPortalNode
+{
+	INT		iNode;
+	INT		Parent;		// Index of the parent in the portal node list, INDEX_NONE for the root.
+	INT		Clip;		// Clip the parent adds for this node, the parent's index or'ed with CLIP_BACK_FLAG.
+	INT		NumClips;	// Number of parents clipping the portal of this node.
+};
+
 //
 // The visibility calculator class.
 //
@@ -110,8 +130,8 @@ class FEditorVisibility
 {
 public:
 	// Constants.
-	enum {MAX_CLIPS=16384};
 	enum {CLIP_BACK_FLAG=0x40000000};
+	enum {PORTAL_BATCH_SIZE=1024};
 
 	// Types.
 	typedef void (FEditorVisibility::*PORTAL_FUNC)(FPoly&,INT,INT,INT,INT);
@@ -120,15 +140,17 @@ public:
 	FMemMark		Mark;
 	ULevel*			Level;
 	UModel*			Model;
-	INT				Clips[MAX_CLIPS];
 	INT				NumPortals, NumLogicalLeaves;
-	INT				NumClips, NumClipTests, NumPassedClips, NumUnclipped;
+	INT				NumClipTests, NumPassedClips, NumUnclipped;
 	INT				NumBspPortals, MaxFragments, NumZonePortals, NumZoneFragments;
 	INT				Extra;
 	INT				iZonePortalSurf;
 	FPortal*		FirstPortal;
 	FPortal**		NodePortals;
 	FPortal**		LeafPortals;
+	TArray<FPortalNode>	PortalNodes;
+	INT				NextPortalNode, BatchStart;
+	TArray<TArray<FPortalFragment> > BatchPortals;	// Portals of the batch of portal nodes starting at BatchStart, reused by all batches.
 
 	// Constructor.
 	FEditorVisibility( ULevel* InLevel, UModel* InModel, INT InDebug );
@@ -140,8 +162,11 @@ public:
 	void AddPortal( FPoly &Poly, INT iFrontLeaf, INT iBackLeaf, INT iGeneratingNode, INT iGeneratingBase );
 	void BlockPortal( FPoly &Poly, INT iFrontLeaf, INT iBackLeaf, INT iGeneratingNode, INT iGeneratingBase );
 	void TagZonePortalFragment( FPoly &Poly, INT iFrontLeaf, INT iBackLeaf, INT iGeneratingNode, INT iGeneratingBase );
-	void FilterThroughSubtree( INT Pass, INT iGeneratingNode, INT iGeneratingBase, INT iParentLeaf, INT iNode, FPoly Poly, PORTAL_FUNC Func, INT iBackLeaf );
-	void MakePortalsClip( INT iNode, FPoly Poly, INT Clip, PORTAL_FUNC Func );
+	void FilterThroughSubtree( INT Pass, INT iGeneratingNode, INT iGeneratingBase, INT iParentLeaf, INT iNode, FPoly Poly, PORTAL_FUNC Func, INT iBackLeaf, TArray<FPortalFragment>* Fragments=NULL );
+	void MakePortalsClip( INT iNode, FPoly Poly, INT Clip, const INT* Clips, INT NumClips, TArray<FPortalFragment>& Fragments );
+	void GatherPortalNodes( INT iNode, INT Parent, INT Clip, INT NumClips );
+	void ClipPortalNode( INT PortalNodeIndex );
+	void ClipPortalBatch();
 	void MakePortals( INT iNode );
 	void AssignLeaves( INT iNode, INT Outside );
 
@@ -260,7 +285,8 @@ void FEditorVisibility::FilterThroughSubtree
 	INT			iNode,
 	FPoly		Poly,
 	PORTAL_FUNC Func,
-	INT			iBackLeaf
+	INT			iBackLeaf,
+	TArray<FPortalFragment>* Fragments
 )
 {
 	while( iNode != INDEX_NONE )
@@ -270,7 +296,7 @@ void FEditorVisibility::FilterThroughSubtree
 		{
 			FPoly Half;
 			Poly.SplitInHalf( &Half );
-			FilterThroughSubtree( Pass, iGeneratingNode, iGeneratingBase, iParentLeaf, iNode, Half, Func, iBackLeaf );
+			FilterThroughSubtree( Pass, iGeneratingNode, iGeneratingBase, iParentLeaf, iNode, Half, Func, iBackLeaf, Fragments );
 		}
 
 		// Test split.
@@ -288,7 +314,8 @@ void FEditorVisibility::FilterThroughSubtree
 				Model->Nodes(iNode).iFront,
 				Split==SP_Front ? Poly : Front,
 				Func,
-				iBackLeaf
+				iBackLeaf,
+				Fragments
 			);
 
 		// Consider back.
@@ -302,7 +329,10 @@ void FEditorVisibility::FilterThroughSubtree
 		iNode       = Model->Nodes(iNode).iBack;
 	}
 
-	// We reached a leaf in this subtree.
+	// We reached a leaf in this subtree. Fragments gathered for AddPortal that end up
+	// in solid space are dropped anyway, so don't bother filtering them any further.
+	if( Pass == 0 && Fragments && iParentLeaf == INDEX_NONE )
+		return;
 	if( Pass == 0 ) FilterThroughSubtree
 	(
 		1,
@@ -312,20 +342,36 @@ void FEditorVisibility::FilterThroughSubtree
 		Model->Nodes(iGeneratingBase).iFront,
 		Poly,
 		Func,
-		iParentLeaf
+		iParentLeaf,
+		Fragments
 	);
+	else if( Fragments )
+	{
+		// Gathered for AddPortal, which ignores fragments outside of the leaves.
+		if( iParentLeaf!=INDEX_NONE && iBackLeaf!=INDEX_NONE )
+		{
+			FPortalFragment* Fragment = new(*Fragments)FPortalFragment;
+			Fragment->Poly       = Poly;
+			Fragment->iFrontLeaf = iParentLeaf;
+			Fragment->iBackLeaf  = iBackLeaf;
+		}
+	}
 	else (this->*Func)( Poly, iParentLeaf, iBackLeaf, iGeneratingNode, iGeneratingBase );
 }
 
 //
-// Clip a portal by all parent nodes above it.
+// Clip a portal by all parent nodes above it, gathering the fragments that
+// end up between two leaves. Only reads the Bsp, so the portals of different
+// nodes can be clipped at the same time.
 //
 void FEditorVisibility::MakePortalsClip
 (
 	INT			iNode,
 	FPoly		Poly,
 	INT			Clip,
-	PORTAL_FUNC Func
+	const INT*	Clips,
+	INT			NumClips,
+	TArray<FPortalFragment>& Fragments
 )
 {
 	// Clip by all parents.
@@ -338,7 +384,7 @@ void FEditorVisibility::MakePortalsClip
 		{
 			FPoly TempPoly;
 			Poly.SplitInHalf( &TempPoly );
-			MakePortalsClip( iNode, TempPoly, Clip, Func );
+			MakePortalsClip( iNode, TempPoly, Clip, Clips, NumClips, Fragments );
 		}
 
 		// Split by parent.
@@ -373,41 +419,114 @@ void FEditorVisibility::MakePortalsClip
 		Model->Nodes(iNode).iLeaf[0],
 		Model->Nodes(iNode).iBack,
 		Poly,
-		Func,
-		INDEX_NONE
+		NULL,
+		INDEX_NONE,
+		&Fragments
 	);
 }
 
 //
-// Make all portals.
+// List the nodes MakePortals generates portals for in the order it visits
+// them, with the clip each parent adds.
+//
+void FEditorVisibility::GatherPortalNodes( INT iNode, INT Parent, INT Clip, INT NumClips )
+{
+	INT Index = PortalNodes.Num();
+	FPortalNode* PortalNode = new(PortalNodes)FPortalNode;
+	PortalNode->iNode    = iNode;
+	PortalNode->Parent   = Parent;
+	PortalNode->Clip     = Clip;
+	PortalNode->NumClips = NumClips;
+
+	if( Model->Nodes(iNode).iFront != INDEX_NONE )
+		GatherPortalNodes( Model->Nodes(iNode).iFront, Index, iNode, NumClips+1 );
+	if( Model->Nodes(iNode).iBack != INDEX_NONE )
+		GatherPortalNodes( Model->Nodes(iNode).iBack, Index, iNode | CLIP_BACK_FLAG, NumClips+1 );
+}
+
+//
+// Clip the portal of one node by its parents, run by the worker threads.
+//
+void FEditorVisibility::ClipPortalNode( INT PortalNodeIndex )
+{
+	// The parents' clips, root first like MakePortals stacks them. They live on the
+	// stack of the worker, as the fragments themselves do while being clipped.
+	FPortalNode& PortalNode = PortalNodes(PortalNodeIndex);
+	INT* Clips = (INT*)appAlloca( PortalNode.NumClips*sizeof(INT) );
+	INT Index = PortalNodeIndex;
+	for( INT i=PortalNode.NumClips-1; i>=0; i-- )
+	{
+		Clips[i] = PortalNodes(Index).Clip;
+		Index    = PortalNodes(Index).Parent;
+	}
+
+	MakePortalsClip( PortalNode.iNode, BuildInfiniteFPoly( Model, PortalNode.iNode ), 0, Clips, PortalNode.NumClips, BatchPortals(PortalNodeIndex-BatchStart) );
+}
+
+//
+// Clips the portal of each node in the portal node list.
+//
+class FClipPortalNodesBody : public FParallelForBody
+{
+public:
+	FEditorVisibility&	Visi;
+
+	// Constructor.
+	FClipPortalNodesBody( FEditorVisibility& InVisi )
+	:	Visi( InVisi )
+	{}
+
+	// FParallelForBody interface.
+	virtual void Execute( INT Index )
+	{
+		Visi.ClipPortalNode( Visi.BatchStart + Index );
+	}
+};
+
+//
+// Clip the portals of the next PORTAL_BATCH_SIZE nodes MakePortals visits, so only
+// the fragments of one batch are held at a time.
+//
+void FEditorVisibility::ClipPortalBatch()
+{
+	BatchStart = NextPortalNode;
+	INT BatchNum = Min<INT>( PORTAL_BATCH_SIZE, PortalNodes.Num()-BatchStart );
+	if( BatchPortals.Num() < BatchNum )
+		BatchPortals.AddZeroed( BatchNum-BatchPortals.Num() );
+	for( INT i=0; i<BatchNum; i++ )
+		BatchPortals(i).Empty( BatchPortals(i).Num() );
+
+	FParallelForLog			ParallelLog;
+	FClipPortalNodesBody	ClipBody( *this );
+	appParallelFor( BatchNum, ClipBody );
+}
+
+//
+// Make all portals, adding the fragments ClipPortalNode gathered in the
+// order they'd have been found by clipping the nodes one after another.
 //
 void FEditorVisibility::MakePortals( INT iNode )
 {
 	INT iOriginalNode = iNode;
 
-	// Make an infinite edpoly for this node.
-	FPoly Poly = BuildInfiniteFPoly( Model, iNode );
-
-	// Filter the portal through this subtree.
-	MakePortalsClip( iNode, Poly, 0, &FEditorVisibility::AddPortal );
+	// Add the portals of this node, clipping the next batch if they haven't been yet.
+	if( NextPortalNode - BatchStart >= PORTAL_BATCH_SIZE )
+		ClipPortalBatch();
+	check(PortalNodes(NextPortalNode).iNode==iNode);
+	TArray<FPortalFragment>& Portals = BatchPortals(NextPortalNode++ - BatchStart);
+	for( INT i=0; i<Portals.Num(); i++ )
+		AddPortal( Portals(i).Poly, Portals(i).iFrontLeaf, Portals(i).iBackLeaf, iNode, iNode );
 
 	// Make portals for front.
 	if( Model->Nodes(iNode).iFront != INDEX_NONE )
-	{
-		Clips[NumClips++] = iNode;
 		MakePortals( Model->Nodes(iNode).iFront );
-		NumClips--;
-	}
 
 	// Make portals for back.
 	if( Model->Nodes(iNode).iBack != INDEX_NONE )
-	{
-		Clips[NumClips++] = iNode | CLIP_BACK_FLAG;
 		MakePortals( Model->Nodes(iNode).iBack );
-		NumClips--;
-	}
 
 	// For all zone portals at this node, mark the matching FPortals as blocked.
+	FPoly Poly;
 	while( iNode != INDEX_NONE )
 	{
 		FBspNode& Node = Model->Nodes( iNode      );
@@ -782,8 +901,14 @@ void FEditorVisibility::TestVisibility()
 	LeafPortals  = new( GMem, MEM_Zeroed, Model->Leaves.Num()      )FPortal*;
 	NodePortals  = new( GMem, MEM_Zeroed, Model->Nodes.Num()*2+256)FPortal*; // Allow for 2X expansion from zone portal fragments!!
 
-	// Build all portals, with references to their front and back leaves.
+	// Build all portals, with references to their front and back leaves. The portals of
+	// the nodes are clipped concurrently in batches, then added in the order of a serial build.
+	GatherPortalNodes( 0, INDEX_NONE, 0, 0 );
+	NextPortalNode = 0;
+	ClipPortalBatch();
 	MakePortals( 0 );
+	PortalNodes.Empty();
+	BatchPortals.Empty();
 
 	// Form zones.
 	FormZonesFromLeaves();
@@ -821,7 +946,6 @@ FEditorVisibility::FEditorVisibility( ULevel* InLevel, UModel* InModel, INT InEx
 	Level			(InLevel),
 	Model			(InModel),
 	NumPortals		(0),
-	NumClips		(0),
 	NumClipTests	(0),
 	NumPassedClips	(0),
 	NumUnclipped	(0),
@@ -832,7 +956,9 @@ FEditorVisibility::FEditorVisibility( ULevel* InLevel, UModel* InModel, INT InEx
 	Extra			(InExtra),
 	FirstPortal		(NULL),
 	NodePortals		(NULL),
-	LeafPortals		(NULL)
+	LeafPortals		(NULL),
+	NextPortalNode	(0),
+	BatchStart		(0)
 {
 #if DEBUG_PORTALS || DEBUG_WRAPS || DEBUG_BADSHEETS || DEBUG_LVS
 	// Init brush for debugging.
@@ -9,3 +9,16 @@ class DistributionFloat extends Component
 /** FCurveEdInterface virtual function table. */
 var private native noexport pointer	CurveEdVTable;
 
+/** Number of samples curves are baked into for fast evaluation, less than 2 always evaluates curves exactly. */
+var()	int									LookupTableSize;
+
+/** Baked lookup table, see UDistributionFloat::GetBakedValue. */
+var private transient const	byte			LookupTableOp;
+var private transient const	float			LookupTableStartTime;
+var private transient const	float			LookupTableTimeScale;
+var private transient const	array<float>	LookupTable;
+
+defaultproperties
+{
+	LookupTableSize=64
+}
@@ -9,6 +9,16 @@ class DistributionVector extends Component
 /** FCurveEdInterface virtual function table. */
 var private native noexport pointer	CurveEdVTable; 
 
+/** Number of samples curves are baked into for fast evaluation, less than 2 always evaluates curves exactly. */
+var()	int									LookupTableSize;
+
+/** Baked lookup table, see UDistributionVector::GetBakedValue. */
+var private transient const	byte			LookupTableOp;
+var private transient const	byte			LookupTableLockedAxes;
+var private transient const	float			LookupTableStartTime;
+var private transient const	float			LookupTableTimeScale;
+var private transient const	array<float>	LookupTable;
+
 enum EDistributionVectorLockFlags
 {
     EDVLF_None,
@@ -23,4 +33,9 @@ enum EDistributionVectorMirrorFlags
 	EDVMF_Same,
 	EDVMF_Different,
 	EDVMF_Mirror
-};
\ No newline at end of file
+};
+
+defaultproperties
+{
+	LookupTableSize=64
+}
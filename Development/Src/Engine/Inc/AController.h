@@ -18,7 +18,7 @@
 	AActor* HandleSpecial(AActor *bestPath);
 	virtual INT AcceptNearbyPath(AActor* goal);
 	virtual void AdjustFromWall(FVector HitNormal, AActor* HitActor);
-	void SetRouteCache(ANavigationPoint *EndPath, FLOAT StartDist, FLOAT EndDist);
+	void SetRouteCache(const TArray<ANavigationPoint*>& Route, INT RouteWeight, FLOAT StartDist, FLOAT EndDist);
 	AActor* FindPath(FVector point, AActor* goal, UBOOL bWeightDetours);
 	AActor* SetPath(INT bInitialPath=1);
 	virtual void SetAdjustLocation(FVector NewLoc);
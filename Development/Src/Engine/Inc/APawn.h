@@ -70,13 +70,15 @@ typedef FLOAT ( *NodeEvaluator ) (ANavigationPoint*, APawn*, FLOAT);
 	// Path finding
 	UBOOL ValidAnchor();
 	FLOAT findPathToward(AActor *goal, FVector GoalLocation, NodeEvaluator NodeEval, FLOAT BestWeight, UBOOL bWeightDetours);
-	ANavigationPoint* breadthPathTo(NodeEvaluator NodeEval, ANavigationPoint *start, int moveFlags, FLOAT *Weight, UBOOL bWeightDetours);
-	ANavigationPoint* CheckDetour(ANavigationPoint* BestDest, ANavigationPoint* Start, UBOOL bWeightDetours);
+	UBOOL PreparePathQuery(class FPathQuery& Query, AActor *goal, FVector GoalLocation, NodeEvaluator NodeEval, FLOAT BestWeight, UBOOL bWeightDetours, FLOAT& Result);
+	FLOAT FinishPathQuery(class FPathQuery& Query);
+	void CheckDetour(class FPathQuery& Query, TArray<ANavigationPoint*>& Route);
 	int calcMoveFlags(); // FIXME: This used to be inline, but that didn't compile with static linking.
 	void SetAnchor(ANavigationPoint *NewAnchor);
 
 	// Pawn physics modes
 	virtual void performPhysics(FLOAT DeltaSeconds);
+	void finishPhysics(FLOAT DeltaSeconds, FVector OldVelocity);
 	virtual FVector CheckForLedges(FVector AccelDir, FVector Delta, FVector GravDir, int &bCheckedFall, int &bMustJump );
 	void physWalking(FLOAT deltaTime, INT Iterations);
 	void physFlying(FLOAT deltaTime, INT Iterations);
@@ -110,6 +112,8 @@ typedef FLOAT ( *NodeEvaluator ) (ANavigationPoint*, APawn*, FLOAT);
 	virtual void SetPushesRigidBodies( UBOOL NewPushes );
 
 private:
+	friend class FPawnMovementPhase;
+
 	UBOOL Pick3DWallAdjust(FVector WallHitNormal, AActor* HitActor);
 	FLOAT Swim(FVector Delta, FCheckResult &Hit);
 	FVector findWaterLine(FVector Start, FVector End);
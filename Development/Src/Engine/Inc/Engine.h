@@ -125,6 +125,7 @@ typedef struct FRenderInterface*	FRenderInterfacePtr;
 #include "UnCDKey.h"				// CD key validation.
 #include "UnCanvas.h"				// Canvas.
 #include "UnPNG.h"					// PNG helper code for storing compressed source art.
+#include "UnDerivedDataCache.h"		// Local cache of derived data like compressed textures.
 
 /*-----------------------------------------------------------------------------
 	Hit proxies.
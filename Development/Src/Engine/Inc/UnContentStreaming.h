@@ -56,6 +56,14 @@ struct FStreamableTextureInfo
 	friend FArchive& operator<<( FArchive& Ar, FStreamableTextureInfo& TextureInfo );
 };
 
+/** Priority of async IO requests. Higher priority requests are always serviced first. */
+enum EAsyncIOPriority
+{
+	AIOP_Low,
+	AIOP_Normal,
+	AIOP_High,
+};
+
 /**
  * Structure containing all information required for requesting removal or addition
  * of mip levels from/ to a texture.
@@ -83,6 +91,10 @@ struct FTextureMipRequest
 
 	/** Number of miplevels the texture should have after the operation completes */
 	UINT						RequestedMips;
+	/** Priority of the IO requests issued for the miplevels, see EAsyncIOPriority */
+	BYTE						IOPriority;
+	/** appSeconds by which the miplevels should be loaded, 0 if none */
+	DOUBLE						IODeadline;
 	/** Thread safe counter used to determine completion (== reaches 0). */
 	FThreadSafeCounter			OutstandingMipRequests;
 };
@@ -121,20 +133,29 @@ struct FContentStreamer
 	 * @return	TRUE if streamer is aware of resource, FALSE otherwise
 	 */
 	virtual UBOOL IsResourceConsidered( FResource* Resource ) = 0;
+
+	/**
+	 * Forgets the state kept across frames for a resource that is about to be freed.
+	 *
+	 * @param	Resource	resource being freed
+	 */
+	virtual void RemoveResource( FResource* Resource ) = 0;
 };
 
 /**
  * Static texture streaming, obtaining data from prebuilt data stored in ULevel.	
+ *
+ * Miplevels above MinStreamedInMips are handed out from a pool with a fixed byte budget. Requests
+ * are granted in order of priority, which is based on the screen space size a texture was seen at
+ * and grows the longer a request has to wait. If a request doesn't fit, miplevels of resident
+ * textures with a lower priority are evicted to make room.
  */
 struct FStaticTextureStreamer : public FContentStreamer
 {
 	/**
-	 * Default constructor	
+	 * Default constructor, reading the pool settings from the [TextureStreaming] section of the engine ini.
 	 */
-	FStaticTextureStreamer()
-	:	CurrentIndexOffset(0),
-		InitialProcessViewerCall(1)
-	{}
+	FStaticTextureStreamer();
 
 	/**
 	 * Flushs resources. Waits for all outstanding requests to be fulfilled and optionally also
@@ -166,16 +187,85 @@ struct FStaticTextureStreamer : public FContentStreamer
 	 */
 	virtual UBOOL IsResourceConsidered( FResource* Resource );
 
+	/**
+	 * Forgets the state kept across frames for a resource that is about to be freed.
+	 *
+	 * @param	Resource	resource being freed
+	 */
+	virtual void RemoveResource( FResource* Resource );
+
 protected:
+	/** Mip change requested for a texture by ProcessViewer */
+	struct FPendingMipRequest
+	{
+		/** Number of miplevels wanted */
+		UINT	RequestedMips;
+		/** Importance of texture, the largest screen space size in texels it was seen at */
+		FLOAT	Priority;
+	};
+
+	/** State kept across frames for every texture considered for streaming */
+	struct FStreamingTextureState
+	{
+		/** Importance of texture the last time it was processed, used to pick textures to evict */
+		FLOAT	Priority;
+		/** Time at which the texture was first denied miplevels due to the pool budget, 0 if it isn't waiting */
+		DOUBLE	WaitingSince;
+	};
+
+	/**
+	 * Requests a change in miplevels and passes the request on to the resource loader if data needs to be loaded.
+	 *
+	 * @param	Texture			Texture to change the number of miplevels of
+	 * @param	RequestedMips	Number of miplevels the texture should have
+	 * @param	IOPriority		Priority of the IO requests if data needs to be loaded
+	 * @param	IODeadline		appSeconds by which the data should be loaded, 0 if none
+	 */
+	void RequestMips( FTextureBase* Texture, UINT RequestedMips, EAsyncIOPriority IOPriority = AIOP_Normal, DOUBLE IODeadline = 0 );
+
 	/** Dynamic map of textures to requested miplevels */
-	TDynamicMap<FTextureBase*,UINT>					PendingRequests;
+	TDynamicMap<FTextureBase*,FPendingMipRequest>		PendingRequests;
 	/** Dynamic map of textures to outstanding mip requests */
-	TDynamicMap<FTextureBase*,FTextureMipRequest*>	OutstandingRequests;
+	TDynamicMap<FTextureBase*,FTextureMipRequest*>		OutstandingRequests;
+	/** Dynamic map of all textures considered for streaming to their streaming state */
+	TDynamicMap<FTextureBase*,FStreamingTextureState>	StreamingTextures;
 
 	/** Current offset into StaticStreamableTextures array */
 	UINT	CurrentIndexOffset;
 	/** Boolean indicating whether it's the first call to ProcessViewer either after flush or construction */
 	UBOOL	InitialProcessViewerCall;
+	/** Size of streaming pool in bytes, 0 if unlimited */
+	DWORD	PoolSize;
+	/** Relative increase in priority per second a request has been waiting for memory */
+	FLOAT	PriorityAgeFactor;
+	/** Number of most important textures per tick whose miplevels are loaded at high IO priority */
+	INT		HighPriorityRequests;
+	/** Seconds within which high priority miplevels should be loaded before they overtake everything else */
+	FLOAT	HighPriorityDeadline;
+};
+
+/** Largest number of bytes read at once when merging requests */
+#define ASYNC_IO_MAX_READ_SIZE	(1024 * 1024)
+/** Largest gap between two requests that still gets read over instead of seeking */
+#define ASYNC_IO_MAX_GAP_SIZE	(64 * 1024)
+
+/**
+ * Running totals of async IO activity, see FAsyncIOManager::GetStats.
+ */
+struct FAsyncIOStats
+{
+	/** Number of requests serviced */
+	DWORD	Requests;
+	/** Number of reads issued, which is less than the number of requests if they got merged */
+	DWORD	Reads;
+	/** Number of reads that didn't start where the previous one ended */
+	DWORD	Seeks;
+	/** Number of bytes read, including gaps read over */
+	QWORD	BytesRead;
+	/** Number of reads that were started for a request of higher priority than one queued before it */
+	DWORD	Overtakes;
+	/** Number of requests currently waiting to be serviced */
+	DWORD	QueueDepth;
 };
 
 /**
@@ -214,6 +304,14 @@ struct FStreamingManager
 	 */
 	UBOOL IsResourceConsidered( FResource* Resource );
 
+	/**
+	 * Lets all content streamers forget the state kept across frames for a resource
+	 * that is about to be freed.
+	 *
+	 * @param	Resource	resource being freed
+	 */
+	void RemoveResource( FResource* Resource );
+
 	/**
 	 * Adds a streamer to the list of content streamers to route requests to.	
 	 *
@@ -228,9 +326,18 @@ struct FStreamingManager
 	 */
 	void RemoveStreamer( FContentStreamer* Streamer );
 
+	/**
+	 * Default constructor.
+	 */
+	FStreamingManager();
+
 private:
 	/** Array of content streamers functions gets routed to */
 	TArray<FContentStreamer*> ContentStreamers;
+	/** Async IO totals at the time of the previous Tick, used to derive per frame stats */
+	FAsyncIOStats	LastIOStats;
+	/** appSeconds at the time of the previous Tick */
+	DOUBLE			LastIOStatsTime;
 };
 
 /**
@@ -299,6 +406,10 @@ struct FBackgroundLoaderUnreal : public FBackgroundLoader
 	 *			fulfilled and hence wasn't canceled.
 	 */
 	virtual UBOOL CancelMipRequest( FTextureMipRequest* TextureMipRequest );
+
+private:
+	/** Loads mips of compressed packages through the linker, as their offsets can't be read from the file directly */
+	FBlockingLoaderUnreal BlockingLoader;
 };
 
 /**
@@ -333,6 +444,93 @@ protected:
 	TArray<FBackgroundLoader*> BackgroundLoaders;
 };
 
+/**
+ * Queue of async IO requests shared by the platform specific IO managers. Requests are handed
+ * out in batches: the most urgent one, picked by deadline, priority and elevator order, along
+ * with the queued requests for data following it in the same file so they can be serviced by
+ * a single read. Not thread safe, the owning manager needs to synchronize access.
+ */
+struct FAsyncIORequestQueue
+{
+	/** A single request */
+	struct FRequest
+	{
+		/** Index of request */
+		QWORD				RequestIndex;
+		/** Index of file in the file table of the owning manager */
+		INT					FileIndex;
+		/** Offset into file */
+		UINT				Offset;
+		/** Size in bytes of data to read */
+		UINT				Size;
+		/** Pointer to memory region used to read data into */
+		void*				Dest;
+		/** Thread safe counter that is decremented once work is done */
+		FThreadSafeCounter* Counter;
+		/** Priority of request, see EAsyncIOPriority */
+		BYTE				Priority;
+		/** appSeconds by which the request should be serviced, 0 if none */
+		DOUBLE				Deadline;
+	};
+
+	/** Constructor, initializing the elevator position and stats. */
+	FAsyncIORequestQueue();
+
+	/**
+	 * Adds a request to the queue.
+	 *
+	 * @param	Request		Request to add
+	 */
+	void Add( const FRequest& Request );
+
+	/**
+	 * Removes N requests from the queue in an atomic all or nothing operation.
+	 *
+	 * @param	RequestIndices	Indices of requests to remove
+	 * @param	NumIndices		Number of indices
+	 * @return	TRUE if all requests were in the queue and got removed, FALSE otherwise
+	 */
+	UBOOL Cancel( QWORD* RequestIndices, UINT NumIndices );
+
+	/** Removes all requests from the queue. */
+	void Empty();
+
+	/**
+	 * Removes the next batch of requests from the queue. All requests of a batch are for the same
+	 * file and are sorted by offset.
+	 *
+	 * @param	Batch	[out] Requests to service
+	 * @param	OutEnd	[out] Offset following the last byte to read, requests of a batch may overlap
+	 * @return	Offset of the first byte to read; the batch is empty if there are no requests
+	 */
+	UINT GetNextBatch( TArray<FRequest>& Batch, UINT& OutEnd );
+
+	/**
+	 * Fills in the running totals.
+	 *
+	 * @param	OutStats	[out] Stats to fill in
+	 */
+	void GetStats( FAsyncIOStats& OutStats ) const;
+
+	/**
+	 * @return TRUE if there are queued requests, FALSE otherwise
+	 */
+	UBOOL HasRequests() const
+	{
+		return Requests.Num() > 0;
+	}
+
+private:
+	/** Queued requests, in the order they were added */
+	TArray<FRequest>	Requests;
+	/** File the previous batch was read from */
+	INT					LastFileIndex;
+	/** Offset at which the previous batch ended */
+	UINT				LastOffset;
+	/** Running totals */
+	FAsyncIOStats		Stats;
+};
+
 /**
  * Virtual base class of async. IO manager, explicitely thread aware.	
  */
@@ -346,10 +544,19 @@ struct FAsyncIOManager : public FRunnable
 	 * @param	Size		Size of load request
 	 * @param	Dest		Pointer to load data into
 	 * @param	Counter		Thread safe counter to decrement when loading has finished
+	 * @param	Priority	Priority of request, see EAsyncIOPriority
+	 * @param	Deadline	appSeconds by which the request should be serviced, 0 if none. Overdue requests go first.
 	 *
 	 * @return Returns an index to the request that can be used for canceling or 0 if the request failed.
 	 */
-	virtual QWORD LoadData( FString Filename, UINT Offset, UINT Size, void* Dest, FThreadSafeCounter* Counter ) = 0;
+	virtual QWORD LoadData( FString Filename, UINT Offset, UINT Size, void* Dest, FThreadSafeCounter* Counter, EAsyncIOPriority Priority = AIOP_Normal, DOUBLE Deadline = 0 ) = 0;
+
+	/**
+	 * Returns the running totals of IO activity.
+	 *
+	 * @param	Stats	[out] Stats to fill in
+	 */
+	virtual void GetStats( FAsyncIOStats& Stats ) = 0;
 	
 	/**
 	 * Removes N outstanding requests from the queue in an atomic all or nothing operation.
@@ -367,6 +574,7 @@ struct FAsyncIOManager : public FRunnable
 	virtual void CancelAllRequests() = 0;
 };
 
+#if !__LINUX__
 /**
  * Windows implementation of an async IO manager.	
  */
@@ -382,10 +590,19 @@ struct FAsyncIOManagerWindows : public FAsyncIOManager
 	 * @param	Size		Size of load request
 	 * @param	Dest		Pointer to load data into
 	 * @param	Counter		Thread safe counter to decrement when loading has finished
+	 * @param	Priority	Priority of request, see EAsyncIOPriority
+	 * @param	Deadline	appSeconds by which the request should be serviced, 0 if none. Overdue requests go first.
 	 *
 	 * @return Returns an index to the request that can be used for canceling or 0 if the request failed.
 	 */
-	virtual QWORD LoadData( FString Filename, UINT Offset, UINT Size, void* Dest, FThreadSafeCounter* Counter );
+	virtual QWORD LoadData( FString Filename, UINT Offset, UINT Size, void* Dest, FThreadSafeCounter* Counter, EAsyncIOPriority Priority = AIOP_Normal, DOUBLE Deadline = 0 );
+
+	/**
+	 * Returns the running totals of IO activity.
+	 *
+	 * @param	Stats	[out] Stats to fill in
+	 */
+	virtual void GetStats( FAsyncIOStats& Stats );
 
 	/**
 	 * Removes N outstanding requests from the queue in an atomic all or nothing operation.
@@ -433,28 +650,14 @@ struct FAsyncIOManagerWindows : public FAsyncIOManager
 	virtual void Stop();
 	
 protected:
-	struct FAsyncIORequest
-	{
-		/** Index of request */
-		QWORD				RequestIndex;
-		/** Handle to file */
-		HANDLE				FileHandle;
-		/** Offset into file */
-		UINT				Offset;
-		/** Size in bytes of data to read */
-		UINT				Size;
-		/** Pointer to memory region used to read data into */
-		void*				Dest;
-		/** Thread safe counter that is decremented once work is done */
-		FThreadSafeCounter* Counter;
-	};
-
 	/** Critical section used to syncronize access to outstanding requests map */
 	FCriticalSection*		CriticalSection;
-	/** TMap of file names to file handles */
-	TMap<FString,HANDLE>	NameToHandleMap;
-	/** Array of outstanding requests, processed in FIFO order */
-	TArray<FAsyncIORequest>	OutstandingRequests;
+	/** TMap of file names to indices into FileHandles */
+	TMap<FString,INT>		NameToFileIndexMap;
+	/** Handles of all opened files */
+	TArray<HANDLE>			FileHandles;
+	/** Outstanding requests, processed in batches */
+	FAsyncIORequestQueue	OutstandingRequests;
 	/** Event that is signaled if there are outstanding requests */
 	FEvent*					OutstandingRequestsEvent;
 	/** Thread safe counter that is 1 if the thread is currently reading from disk, 0 otherwise */
@@ -464,6 +667,140 @@ protected:
 	/** Current request index. We don't really worry about wrapping around with a QWORD */
 	QWORD					RequestIndex;
 };
+#endif
+
+#if __LINUX__
+/**
+ * Linux implementation of an async IO manager. Requests are serviced with pread by a small pool
+ * of worker threads sharing one queue so several reads can be in flight at the same time. The
+ * thread running this runnable is the first worker, the others are created in Init.
+ */
+struct FAsyncIOManagerLinux : public FAsyncIOManager
+{
+	/**
+	 * Constructor.
+	 *
+	 * @param	InNumWorkers	Number of threads servicing requests, including the one running this runnable
+	 */
+	FAsyncIOManagerLinux( INT InNumWorkers = 2 );
+
+	// FAsyncIOManager interface.
+
+	/**
+	 * Requests data to be loaded async. Returns immediately.
+	 *
+	 * @param	Filename	Filename to load
+	 * @param	Offset		Offset into file
+	 * @param	Size		Size of load request
+	 * @param	Dest		Pointer to load data into
+	 * @param	Counter		Thread safe counter to decrement when loading has finished
+	 * @param	Priority	Priority of request, see EAsyncIOPriority
+	 * @param	Deadline	appSeconds by which the request should be serviced, 0 if none. Overdue requests go first.
+	 *
+	 * @return Returns an index to the request that can be used for canceling or 0 if the request failed.
+	 */
+	virtual QWORD LoadData( FString Filename, UINT Offset, UINT Size, void* Dest, FThreadSafeCounter* Counter, EAsyncIOPriority Priority = AIOP_Normal, DOUBLE Deadline = 0 );
+
+	/**
+	 * Returns the running totals of IO activity.
+	 *
+	 * @param	Stats	[out] Stats to fill in
+	 */
+	virtual void GetStats( FAsyncIOStats& Stats );
+
+	/**
+	 * Removes N outstanding requests from the queue in an atomic all or nothing operation.
+	 * NOTE: Requests are only canceled if ALL requests are still pending and neither one
+	 * is currently in flight.
+	 *
+	 * @param	RequestIndices	Indices of requests to cancel.
+	 * @return	TRUE if all requests were still outstanding, FALSE otherwise
+	 */
+	virtual UBOOL CancelRequests( QWORD* RequestIndices, UINT NumIndices );
+	
+	/**
+	 * Blocks till all currently outstanding requests are canceled.
+	 */
+	virtual void CancelAllRequests();
+
+	// FRunnable interface.
+
+	/**
+	 * Initializes critical section, event and other used variables and creates the
+	 * additional worker threads.
+	 *
+	 * @return True if initialization was successful, false otherwise
+	 */
+	virtual UBOOL Init();
+
+	/**
+	 * Called in the context of the aggregating thread to perform cleanup. Waits for
+	 * the other worker threads to finish.
+	 */
+	virtual void Exit();
+
+	/**
+	 * Services requests till Stop is called.
+	 *
+	 * @return always 0
+	 */
+	virtual DWORD Run();
+	
+	/**
+	 * This is called if a thread is requested to terminate early
+	 */
+	virtual void Stop();
+	
+protected:
+	/** Runnable of additional worker threads, servicing requests of the owning manager */
+	struct FWorker : public FRunnable
+	{
+		/** Manager whose requests are serviced */
+		FAsyncIOManagerLinux* Manager;
+
+		FWorker( FAsyncIOManagerLinux* InManager )
+		:	Manager( InManager )
+		{}
+		virtual UBOOL Init() { return TRUE; }
+		virtual DWORD Run() { return Manager->Run(); }
+		virtual void Stop() {}
+		virtual void Exit() {}
+	};
+
+	/**
+	 * Reads from a file, retrying partial reads.
+	 *
+	 * @param	FileDescriptor	File to read from
+	 * @param	Dest			Pointer to read data into
+	 * @param	Offset			Offset into file
+	 * @param	Size			Number of bytes to read
+	 */
+	void Read( INT FileDescriptor, void* Dest, UINT Offset, UINT Size );
+
+	/** Critical section used to syncronize access to outstanding requests map */
+	FCriticalSection*			CriticalSection;
+	/** TMap of file names to indices into FileDescriptors */
+	TMap<FString,INT>			NameToFileIndexMap;
+	/** Descriptors of all opened files */
+	TArray<INT>					FileDescriptors;
+	/** Outstanding requests, processed in batches */
+	FAsyncIORequestQueue		OutstandingRequests;
+	/** Event that is signaled if there are outstanding requests */
+	FEvent*						OutstandingRequestsEvent;
+	/** Thread safe counter holding the number of threads currently reading from disk */
+	FThreadSafeCounter			BusyReading;
+	/** Thread safe counter that is 1 if the threads are available to process requests, 0 otherwise */
+	FThreadSafeCounter			IsRunning;
+	/** Current request index. We don't really worry about wrapping around with a QWORD */
+	QWORD						RequestIndex;
+	/** Number of threads servicing requests */
+	INT							NumWorkers;
+	/** Runnables of additional worker threads */
+	TArray<FWorker*>			Workers;
+	/** Additional worker threads */
+	TArray<FRunnableThread*>	WorkerThreads;
+};
+#endif
 
 /** Global async IO manager */
 extern FAsyncIOManager*		GAsyncIOManager;
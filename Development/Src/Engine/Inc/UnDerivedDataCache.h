@@ -0,0 +1,162 @@
+/*=============================================================================
+	UnDerivedDataCache.h: Local cache of data derived from source assets.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/*-----------------------------------------------------------------------------
+	FDerivedDataKey.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Archive hashing everything a builder derives data from into a cache key. Builders
+ * serialize their source data and settings into it, so the key changes whenever any of
+ * them or the version of the builder does.
+ */
+class FDerivedDataKey : public FArchive
+{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param	InBuilder	Name of the builder, used in statistics
+	 * @param	InVersion	Version of the builder, to bump whenever its output changes
+	 */
+	FDerivedDataKey( const TCHAR* InBuilder, INT InVersion );
+
+	// FArchive interface.
+	void Serialize( void* Data, INT Length );
+
+	/**
+	 * Returns the key, of the form BUILDER_VERSION_HASH. Nothing may be serialized
+	 * into the archive anymore once the key has been retrieved.
+	 */
+	const FString& GetKey();
+
+	/** Returns the name of the builder */
+	const FString& GetBuilder() const
+	{
+		return Builder;
+	}
+
+private:
+	/** Name of the builder */
+	FString			Builder;
+	/** Version of the builder */
+	INT				Version;
+	/** State of the hash of the serialized data */
+	FMD5Context		Context;
+	/** Key, empty until GetKey is called */
+	FString			Key;
+};
+
+/*-----------------------------------------------------------------------------
+	FDerivedDataCache.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Stores data derived from source assets, like compressed textures or built meshes,
+ * in files named after a hash of the source data, the build settings and the version
+ * of the builder. Builders look the data up before deriving it and store it once
+ * derived, so rebuilding unchanged assets only costs reading the cache file.
+ *
+ * The cache is shared by all processes using the same directory. An index file records
+ * when each entry was last used and Flush deletes the least recently used entries once
+ * the cache exceeds its maximum size. The directory and size are read from the
+ * [DerivedDataCache] section of the engine ini, -ddc=Path overrides the directory and
+ * -noddc disables the cache.
+ */
+class FDerivedDataCache
+{
+public:
+	/** Constructor, reading the configuration and the index */
+	FDerivedDataCache();
+
+	/** Destructor, flushing the cache */
+	~FDerivedDataCache();
+
+	/**
+	 * Retrieves derived data.
+	 *
+	 * @param	Key			Key of the data
+	 * @param	OutData		[out] data stored for the key
+	 * @return	TRUE if the data was found, FALSE if it has to be derived
+	 */
+	UBOOL Get( FDerivedDataKey& Key, TArray<BYTE>& OutData );
+
+	/**
+	 * Stores derived data. Data already stored by another process is kept.
+	 *
+	 * @param	Key			Key of the data
+	 * @param	Data		Data to store
+	 */
+	void Put( FDerivedDataKey& Key, const TArray<BYTE>& Data );
+
+	/**
+	 * Writes the index, evicting the least recently used entries if the cache exceeds its
+	 * maximum size, and logs the statistics of this process.
+	 */
+	void Flush();
+
+	/**
+	 * Logs hits and misses of each builder.
+	 *
+	 * @param	Ar		Device to log to
+	 */
+	void DumpStats( FOutputDevice& Ar );
+
+private:
+	/** An entry of the index */
+	struct FIndexEntry
+	{
+		/** Size of the file of the entry */
+		INT				Size;
+		/** Use counter value the entry was last used at */
+		INT				LastUsed;
+	};
+
+	/** Statistics of a builder */
+	struct FBuilderStats
+	{
+		INT				Hits;
+		INT				Misses;
+		INT				Puts;
+		QWORD			BytesRead;
+		QWORD			BytesWritten;
+		DOUBLE			GetTime;
+
+		FBuilderStats()
+		:	Hits( 0 )
+		,	Misses( 0 )
+		,	Puts( 0 )
+		,	BytesRead( 0 )
+		,	BytesWritten( 0 )
+		,	GetTime( 0.0 )
+		{}
+	};
+
+	/** Directory the entries are stored in, with a trailing separator, empty if the cache is disabled */
+	FString							Directory;
+	/** Size the cache is trimmed to, in bytes */
+	QWORD							MaxSize;
+	/** Entries used or stored by this process */
+	TMap<FString,FIndexEntry>		UsedEntries;
+	/** Use counter, increasing with each entry used */
+	INT								UseCounter;
+	/** Statistics of each builder */
+	TMap<FString,FBuilderStats>		Stats;
+
+	/** Returns the filename of an entry */
+	FString GetEntryFilename( const FString& Key ) const;
+	/** Reads the index into a map, returns the highest use counter value in it */
+	INT LoadIndex( TMap<FString,FIndexEntry>& OutEntries ) const;
+	/** Records the use of an entry */
+	void TouchEntry( const FString& Key, INT Size );
+};
+
+/** The derived data cache, NULL when the engine isn't initialized */
+extern FDerivedDataCache* GDerivedDataCache;
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -24,17 +24,187 @@ enum EDistributionVectorMirrorFlags
 	EDVMF_MAX
 };
 
+/**
+ * How the baked lookup table of a distribution is evaluated.
+ */
+enum EDistributionLookupTableOp
+{
+	DLTO_Dirty,			// Table needs to be baked before use.
+	DLTO_None,			// Distribution can't be baked and is evaluated with GetValue.
+	DLTO_Constant,		// Table holds a single value.
+	DLTO_Uniform,		// Table holds the min and max value.
+	DLTO_Curve,			// Table holds values sampled at regular intervals.
+};
+
+/**
+ * Distributions are baked into lookup tables on first use so they can be evaluated by
+ * GetBakedValue and GetBakedValues without virtual calls or searching curve keys. Curves
+ * are sampled LookupTableSize times across their keys and linearly interpolated, curves
+ * with stepped keys aren't baked. Tables are rebaked whenever the distribution is loaded
+ * or edited.
+ */
 class UDistributionFloat : public UComponent, public FCurveEdInterface
 {
 public:
+	/** Number of samples curves are baked into, less than 2 always evaluates curves exactly */
+	INT					LookupTableSize;
+	/** How LookupTable is evaluated, one of EDistributionLookupTableOp */
+	BYTE				LookupTableOp;
+	/** Input value of the first sample */
+	FLOAT				LookupTableStartTime;
+	/** Number of samples per unit of input value */
+	FLOAT				LookupTableTimeScale;
+	/** Baked values */
+	TArrayNoInit<FLOAT>	LookupTable;
+
     DECLARE_CLASS(UDistributionFloat,UComponent,0,Engine)
 	virtual FLOAT GetValue( FLOAT F = 0.f );
+
+	// UObject interface
+	virtual void Serialize(FArchive& Ar);
+	virtual void PostEditChange(UProperty* PropertyThatChanged);
+
+	/**
+	 * Evaluates the distribution through its lookup table. Cheaper than GetValue but curves
+	 * are approximated with the precision set by LookupTableSize.
+	 */
+	FLOAT GetBakedValue( FLOAT F = 0.f )
+	{
+		if( LookupTableOp == DLTO_Dirty )
+		{
+			BakeLookupTable();
+		}
+		switch( LookupTableOp )
+		{
+		case DLTO_Constant:
+			return LookupTable(0);
+		case DLTO_Uniform:
+			return LookupTable(1) + (LookupTable(0) - LookupTable(1)) * appFrand();
+		case DLTO_Curve:
+			{
+				const FLOAT Time	= Clamp<FLOAT>( (F - LookupTableStartTime) * LookupTableTimeScale, 0.f, LookupTable.Num() - 1 );
+				const INT	Index	= Min<INT>( appTrunc(Time), LookupTable.Num() - 2 );
+				return Lerp( LookupTable(Index), LookupTable(Index + 1), Time - Index );
+			}
+		default:
+			return GetValue( F );
+		}
+	}
+
+	/**
+	 * Evaluates the distribution through its lookup table for a batch of input values.
+	 *
+	 * @param	Count		Number of values to evaluate
+	 * @param	InValues	Input values, Count entries
+	 * @param	OutValues	[out] Evaluated values, Count entries
+	 */
+	void GetBakedValues( INT Count, const FLOAT* InValues, FLOAT* OutValues );
+
+	/**
+	 * Marks the lookup table to be baked again before its next use, called whenever the
+	 * distribution changes.
+	 */
+	void DirtyLookupTable()
+	{
+		LookupTableOp = DLTO_Dirty;
+	}
+
+private:
+	/**
+	 * Bakes the distribution into LookupTable.
+	 */
+	void BakeLookupTable();
 };
 
 
+/**
+ * Vector distributions are baked like float distributions, see UDistributionFloat. Locked
+ * axes are applied while baking, for uniform distributions the locked axes are stored
+ * along with the table.
+ */
 class UDistributionVector : public UComponent, public FCurveEdInterface
 {
 public:
+	/** Number of samples curves are baked into, less than 2 always evaluates curves exactly */
+	INT					LookupTableSize;
+	/** How LookupTable is evaluated, one of EDistributionLookupTableOp */
+	BYTE				LookupTableOp;
+	/** Axes locked together by uniform distributions, one of EDistributionVectorLockFlags */
+	BYTE				LookupTableLockedAxes;
+	/** Input value of the first sample */
+	FLOAT				LookupTableStartTime;
+	/** Number of samples per unit of input value */
+	FLOAT				LookupTableTimeScale;
+	/** Baked values, three per vector */
+	TArrayNoInit<FLOAT>	LookupTable;
+
     DECLARE_CLASS(UDistributionVector,UComponent,0,Engine)
 	virtual FVector GetValue( FLOAT F = 0.f );
+
+	// UObject interface
+	virtual void Serialize(FArchive& Ar);
+	virtual void PostEditChange(UProperty* PropertyThatChanged);
+
+	/**
+	 * Evaluates the distribution through its lookup table. Cheaper than GetValue but curves
+	 * are approximated with the precision set by LookupTableSize.
+	 */
+	FVector GetBakedValue( FLOAT F = 0.f )
+	{
+		if( LookupTableOp == DLTO_Dirty )
+		{
+			BakeLookupTable();
+		}
+		switch( LookupTableOp )
+		{
+		case DLTO_Constant:
+			return FVector( LookupTable(0), LookupTable(1), LookupTable(2) );
+		case DLTO_Uniform:
+			return GetBakedUniformValue();
+		case DLTO_Curve:
+			{
+				const INT	NumSamples	= LookupTable.Num() / 3;
+				const FLOAT	Time		= Clamp<FLOAT>( (F - LookupTableStartTime) * LookupTableTimeScale, 0.f, NumSamples - 1 );
+				const INT	Index		= Min<INT>( appTrunc(Time), NumSamples - 2 );
+				const FLOAT	Alpha		= Time - Index;
+				const FLOAT* Sample		= &LookupTable(Index * 3);
+				return FVector(
+					Lerp( Sample[0], Sample[3], Alpha ),
+					Lerp( Sample[1], Sample[4], Alpha ),
+					Lerp( Sample[2], Sample[5], Alpha )
+					);
+			}
+		default:
+			return GetValue( F );
+		}
+	}
+
+	/**
+	 * Evaluates the distribution through its lookup table for a batch of input values.
+	 *
+	 * @param	Count		Number of values to evaluate
+	 * @param	InValues	Input values, Count entries
+	 * @param	OutValues	[out] Evaluated values, Count entries
+	 */
+	void GetBakedValues( INT Count, const FLOAT* InValues, FVector* OutValues );
+
+	/**
+	 * Marks the lookup table to be baked again before its next use, called whenever the
+	 * distribution changes.
+	 */
+	void DirtyLookupTable()
+	{
+		LookupTableOp = DLTO_Dirty;
+	}
+
+private:
+	/**
+	 * Bakes the distribution into LookupTable.
+	 */
+	void BakeLookupTable();
+
+	/**
+	 * Picks a random value of a baked uniform distribution.
+	 */
+	FVector GetBakedUniformValue();
 };
\ No newline at end of file
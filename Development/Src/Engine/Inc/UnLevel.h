@@ -411,6 +411,15 @@ class ULevel : public ULevelBase, public FScene
 	/** Array of information needed for streaming static textures */
 	TArray<FStreamableTextureInfo>				StaticStreamableTextureInfos;
 
+	/** Batches AI sight and hearing checks, created on first use */
+	class FPerceptionManager*					Perception;
+	/** Moves AI pawns once all actors have ticked, created on first use */
+	class FPawnMovementPhase*					PawnMovement;
+	/** Compiled gameplay sequences and indexed actor events, created by USequence::BeginPlay */
+	class FSequenceRuntime*						SequenceRuntime;
+	/** Collision queries shared between the moves of a tick, created on first use */
+	class FActorMoveCache*						MoveCache;
+
 	// Constructor.
 	ULevel( UEngine* InEngine, UBOOL RootOutside );
 
@@ -510,6 +519,26 @@ class ULevel : public ULevelBase, public FScene
 	}
 	UBOOL ToFloor( AActor* InActor, UBOOL InAlign, AActor* InIgnoreActor );
 
+	/**
+	 * Returns the level's perception manager, creating it if necessary.
+	 */
+	class FPerceptionManager* GetPerception();
+
+	/**
+	 * Returns the level's pawn movement phase, creating it if necessary.
+	 */
+	class FPawnMovementPhase* GetPawnMovement();
+
+	/**
+	 * Returns the level's sequence runtime, creating it if necessary.
+	 */
+	class FSequenceRuntime* GetSequenceRuntime();
+
+	/**
+	 * Returns the level's move cache, creating it if necessary.
+	 */
+	class FActorMoveCache* GetMoveCache();
+
 	void ClearComponents();
 	void UpdateComponents();
 
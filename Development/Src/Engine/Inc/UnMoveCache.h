@@ -0,0 +1,176 @@
+/*=============================================================================
+	UnMoveCache.h: Collision queries shared between the moves of a level tick.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/**
+ * Shares collision work between the calls to ULevel::MoveActor made during a level tick.
+ *
+ * When an actor with attached actors moves, a move batch gathers the primitives around
+ * the actor and everything attached to it with a single octree query. The swept line
+ * checks and encroachment checks of the base and of every attached actor moved along with
+ * it are answered from that candidate set instead of traversing the octree again for each
+ * of them. Queries that leave the bounds of the batch fall back to the octree, as does
+ * everything once an actor outside the batch moves or actors are spawned or destroyed.
+ *
+ * The results of AActor::IsOverlapping used to update touch lists are cached for each pair
+ * of actors along with the placement of both, so successive moves in the same tick that
+ * leave both actors in place, such as blocked moves, don't test touching actors again.
+ */
+class FActorMoveCache
+{
+public:
+	/**
+	 * Constructor.
+	 *
+	 * @param	InLevel		Level whose moves are cached
+	 */
+	FActorMoveCache( ULevel* InLevel );
+
+	/**
+	 * Drops the cached overlaps of the previous tick, called before the actors of the
+	 * level are ticked.
+	 */
+	void Tick();
+
+	/**
+	 * Starts a move batch for an actor and everything attached to it, unless a batch is
+	 * already running. Every call returning TRUE has to be matched by a call to EndBatch.
+	 *
+	 * @param	Actor		Base that is about to be moved
+	 * @param	Delta		Move of the base
+	 * @param	NewRotation	Rotation of the base after the move
+	 * @return	TRUE if a batch was started
+	 */
+	UBOOL BeginBatch( AActor* Actor, const FVector& Delta, const FRotator& NewRotation );
+
+	/**
+	 * Ends the running move batch.
+	 */
+	void EndBatch();
+
+	/**
+	 * Called whenever an actor is about to be moved, stops answering queries from the
+	 * running batch if the actor isn't part of it.
+	 */
+	void NotifyMove( AActor* Actor )
+	{
+		if( bBatchValid && !BatchActors.ContainsItem(Actor) )
+		{
+			InvalidateBatch();
+		}
+	}
+
+	/**
+	 * Stops answering queries from the running batch, called whenever primitives are
+	 * added to or removed from the level outside of a batched move.
+	 */
+	void InvalidateBatch()
+	{
+		bBatchValid = FALSE;
+	}
+
+	/**
+	 * Drops all cached overlaps, called whenever collision settings or bases change.
+	 */
+	void InvalidateOverlaps();
+
+	/**
+	 * Answers an actor line check of ULevel::MultiLineCheck from the running batch.
+	 *
+	 * @param	OutResult	[out] Hits, in the same format FPrimitiveHashBase::ActorLineCheck returns
+	 * @return	FALSE if the batch can't answer the query and the octree has to be checked
+	 */
+	UBOOL ActorLineCheck( FMemStack& Mem, const FVector& End, const FVector& Start, const FVector& Extent, DWORD TraceFlags, AActor* SourceActor, FCheckResult*& OutResult );
+
+	/**
+	 * Answers an encroachment check of ULevel::CheckEncroachment from the running batch.
+	 *
+	 * @param	OutResult	[out] Hits, in the same format FPrimitiveHashBase::ActorEncroachmentCheck returns
+	 * @return	FALSE if the batch can't answer the query and the octree has to be checked
+	 */
+	UBOOL ActorEncroachmentCheck( FMemStack& Mem, AActor* Actor, FVector Location, FRotator Rotation, DWORD TraceFlags, FCheckResult*& OutResult );
+
+	/**
+	 * Returns whether an actor overlaps another, see AActor::IsOverlapping, reusing the
+	 * result of an earlier test this tick if neither actor has changed since.
+	 */
+	UBOOL IsOverlapping( AActor* Actor, AActor* Other );
+
+	/**
+	 * Removes all references to actors that are about to be deleted.
+	 */
+	void CleanupDestroyed();
+
+private:
+	/** State of an actor the result of AActor::IsOverlapping depends on */
+	struct FActorPlacement
+	{
+		FVector		Location;
+		FRotator	Rotation;
+		FVector		BoundsOrigin;
+		FVector		BoundsExtent;
+		AActor*		Base;
+		UBOOL		bCollideActors;
+
+		FActorPlacement( AActor* Actor );
+		UBOOL operator==( const FActorPlacement& Other ) const;
+	};
+
+	/** Cached result of AActor::IsOverlapping */
+	struct FOverlapEntry
+	{
+		AActor*				Other;
+		FActorPlacement		ActorPlacement;
+		FActorPlacement		OtherPlacement;
+		UBOOL				bOverlapping;
+		/** Next entry of the same actor, or INDEX_NONE */
+		INT					NextEntry;
+
+		FOverlapEntry( AActor* Actor, AActor* InOther )
+		:	Other( InOther )
+		,	ActorPlacement( Actor )
+		,	OtherPlacement( InOther )
+		{}
+	};
+
+	/**
+	 * Returns whether the overlap of two actors only depends on their placement.
+	 */
+	static UBOOL CanCacheOverlap( AActor* Actor, AActor* Other );
+
+	/**
+	 * Returns whether a box lies within the bounds of the running batch.
+	 */
+	UBOOL BatchContains( const FBox& Box ) const
+	{
+		return	Box.IsValid &&
+				Box.Min.X >= BatchBounds.Min.X && Box.Max.X <= BatchBounds.Max.X &&
+				Box.Min.Y >= BatchBounds.Min.Y && Box.Max.Y <= BatchBounds.Max.Y &&
+				Box.Min.Z >= BatchBounds.Min.Z && Box.Max.Z <= BatchBounds.Max.Z;
+	}
+
+	/** Level whose moves are cached */
+	ULevel*							Level;
+
+	/** Whether a batch is running */
+	UBOOL							bBatching;
+	/** Whether the running batch may answer queries */
+	UBOOL							bBatchValid;
+	/** Base of the running batch and everything attached to it */
+	TArray<AActor*>					BatchActors;
+	/** Bounds the candidates of the running batch were gathered in */
+	FBox							BatchBounds;
+	/** Primitives intersecting BatchBounds */
+	TArray<UPrimitiveComponent*>	BatchPrimitives;
+
+	/** Cached overlaps */
+	TArray<FOverlapEntry>			Overlaps;
+	/** First entry in Overlaps of each actor */
+	TMap<AActor*,INT>				FirstOverlaps;
+};
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -15,6 +15,12 @@
 #define MINMOVETHRESHOLD 4.1f // minimum distance to consider an AI predicted move valid
 #define SWIMCOSTMULTIPLIER 2.f // cost multiplier for paths which require swimming
 #define CROUCHCOSTMULTIPLIER 1.1f // cost multiplier for paths which require crouching
+#define MAXPATHEXPANSIONS 200 // nodes an evaluated search expands before settling for the best destination found so far
+#define UNREACHEDPATHWEIGHT 10000000 // weight of nodes a path search didn't reach
+#define NAVCLUSTERMAXNODES 32 // maximum number of navigation points grouped into a cluster
+#define NAVCLUSTERRADIUS 2048 // maximum distance of a cluster's navigation points from its first one
+#define NAVCLUSTERMINGRAPHNODES 256 // graphs smaller than this are always searched node by node
+#define MAXPATHCACHEENTRIES 4096 // cached cluster corridors per graph before the cache is flushed
 
 //Reachability flags - using bits to save space
 
@@ -52,11 +58,56 @@ public:
 	static AScout* GetScout(ULevel *Level);
 	static void DestroyScout(ULevel *Level);
 
+	/**
+	 * Returns whether a reach spec should be attempted between two navigation points.
+	 *
+	 * @param	Start			Navigation point the reach spec would start at
+	 * @param	End				Navigation point the reach spec would lead to
+	 * @param	bOnlyChanged	Whether only paths of changed navigation points are rebuilt
+	 * @return	TRUE if Start should try to reach End
+	 */
+	static UBOOL IsReachCandidate(ANavigationPoint* Start, ANavigationPoint* End, UBOOL bOnlyChanged);
+
+	/**
+	 * Returns the navigation points a reach spec should be attempted to, as gathered
+	 * at the start of the reach spec pass of definePaths.
+	 *
+	 * @param	Start	Navigation point to retrieve candidates for
+	 * @return	candidates in NavigationPointList order, NULL if they weren't gathered for Start
+	 */
+	static const TArray<ANavigationPoint*>* FindReachCandidates(ANavigationPoint* Start);
+
+	/**
+	 * Defines a reach spec to a reach candidate. Uses the straight walk found for the
+	 * candidate by GatherReachCandidates if there is one, the scout otherwise.
+	 *
+	 * @param	Spec			Spec to define
+	 * @param	Start			Navigation point the spec starts at
+	 * @param	End				Navigation point the spec leads to
+	 * @param	CandidateIndex	Index of End in the candidates returned by FindReachCandidates, INDEX_NONE if they weren't gathered
+	 * @param	Scout			Scout to define the spec with
+	 * @return	TRUE if the spec was defined
+	 */
+	static UBOOL DefineReachSpec(UReachSpec* Spec, ANavigationPoint* Start, ANavigationPoint* End, INT CandidateIndex, AScout* Scout);
+
 private:
 	static AScout *Scout;
 	ULevel *Level;
 	void SetPathCollision(INT bEnabled);
 
+	/**
+	 * Gathers the reach candidates of all navigation points that get reach specs added,
+	 * and finds which of them the scout can walk straight to on worker threads.
+	 *
+	 * @param	bOnlyChanged	Whether only paths of changed navigation points are rebuilt
+	 */
+	void GatherReachCandidates(UBOOL bOnlyChanged);
+
+	/**
+	 * Frees the reach candidates gathered by GatherReachCandidates.
+	 */
+	static void EmptyReachCandidates();
+
 public:
 	void definePaths (ULevel *ownerLevel,UBOOL bOnlyChanged=0);
 	void undefinePaths (ULevel *ownerLevel,UBOOL bOnlyChanged=0);
@@ -64,3 +115,416 @@ public:
 	void buildCover(ULevel *ownerLevel);
 };
 
+/*-----------------------------------------------------------------------------
+	FNavigationGraph.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Reach spec as seen by path queries.
+ */
+struct FNavGraphEdge
+{
+	/** Index of node the reach spec leads to */
+	INT			End;
+	/** Spec the edge was created from */
+	UReachSpec*	Spec;
+	/** Copied from spec */
+	INT			Distance;
+	INT			CollisionRadius;
+	INT			CollisionHeight;
+	INT			reachFlags;
+	INT			MaxLandingVelocity;
+	UBOOL		bForced;
+	/** Whether the cost of this edge is determined by the SpecialCost event of the end node */
+	UBOOL		bSpecialCost;
+
+	/**
+	 * Same as UReachSpec::supports.
+	 */
+	UBOOL supports( INT iRadius, INT iHeight, INT moveFlags, INT iMaxFallVelocity ) const
+	{
+		return ( (CollisionRadius >= iRadius) 
+			&& (CollisionHeight >= iHeight)
+			&& ((reachFlags & moveFlags) == reachFlags)
+			&& ((MaxLandingVelocity <= iMaxFallVelocity) || bForced) );
+	}
+};
+
+/**
+ * Navigation point as seen by path queries.
+ */
+struct FNavGraphNode
+{
+	/** Navigation point the node was created from */
+	ANavigationPoint*	Nav;
+	/** Location of navigation point */
+	FVector				Location;
+	/** Index of first outgoing edge */
+	INT					FirstEdge;
+	/** Number of outgoing edges */
+	INT					NumEdges;
+	/** Index of cluster containing the node */
+	INT					Cluster;
+};
+
+/**
+ * Group of nearby, connected navigation points. Clusters and the links between
+ * them form the abstract graph long distance searches are run on first.
+ */
+struct FNavGraphCluster
+{
+	/** Average location of navigation points in cluster */
+	FVector				Location;
+	/** Index of first outgoing link */
+	INT					FirstLink;
+	/** Number of outgoing links */
+	INT					NumLinks;
+};
+
+/**
+ * Connection from one cluster to another, made up of all edges leading across.
+ */
+struct FNavGraphClusterLink
+{
+	/** Index of cluster the link leads to */
+	INT					EndCluster;
+	/** Distance between cluster locations */
+	INT					Cost;
+	/** Index of first crossing edge in FNavigationGraph::CrossingEdges */
+	INT					FirstCrossing;
+	/** Number of crossing edges */
+	INT					NumCrossings;
+};
+
+/**
+ * Key of cached cluster corridors. Corridors only depend on the clusters
+ * searched between and on which reach specs the searcher is able to use.
+ */
+struct FNavPathCacheKey
+{
+	INT	StartCluster;
+	INT	GoalCluster;
+	INT	Radius;
+	INT	Height;
+	INT	MoveFlags;
+	INT	MaxFallSpeed;
+
+	UBOOL operator==( const FNavPathCacheKey& Other ) const
+	{
+		return StartCluster == Other.StartCluster
+			&& GoalCluster == Other.GoalCluster
+			&& Radius == Other.Radius
+			&& Height == Other.Height
+			&& MoveFlags == Other.MoveFlags
+			&& MaxFallSpeed == Other.MaxFallSpeed;
+	}
+	friend DWORD GetTypeHash( const FNavPathCacheKey& Key )
+	{
+		return appMemCrc( &Key, sizeof(FNavPathCacheKey) );
+	}
+};
+
+/**
+ * Compact snapshot of the navigation network of a level. Nodes are numbered in
+ * NavigationPointList order so per query state can live in flat arrays. The
+ * topology is immutable once built which makes it safe to search from several
+ * threads at once; state that changes at runtime (costs, blocked nodes) is
+ * gathered per query by FPathQuery::Prepare.
+ *
+ * Nodes are additionally grouped into clusters. Searches across large graphs
+ * first find a corridor of clusters on the much smaller cluster graph and then
+ * only search the nodes inside that corridor. Corridors are cached so pawns
+ * heading the same way share the abstract search.
+ */
+class FNavigationGraph
+{
+public:
+	/** Nodes, in NavigationPointList order */
+	TArray<FNavGraphNode>	Nodes;
+	/** Edges, grouped by start node */
+	TArray<FNavGraphEdge>	Edges;
+	/** Indices of edges with bSpecialCost set */
+	TArray<INT>				SpecialEdges;
+	/** Clusters of nodes */
+	TArray<FNavGraphCluster>		Clusters;
+	/** Links between clusters, grouped by start cluster */
+	TArray<FNavGraphClusterLink>	ClusterLinks;
+	/** Indices of edges links are made up of, grouped by link */
+	TArray<INT>						CrossingEdges;
+	/** Corridors of clusters found by previous searches, only accessed on the game thread */
+	TMap<FNavPathCacheKey,TArray<INT> >	PathCache;
+
+	/**
+	 * Returns the graph of the passed in level, building it if necessary. Game thread only.
+	 *
+	 * @param	LevelInfo	Level to retrieve graph for
+	 * @return	graph of level, NULL if the level doesn't have any navigation points
+	 */
+	static FNavigationGraph* Get( ALevelInfo* LevelInfo );
+
+	/**
+	 * Discards all graphs, called whenever paths are built or navigation points go away. Game thread only.
+	 */
+	static void Invalidate();
+
+	/**
+	 * @return index of node created from passed in navigation point, INDEX_NONE if there is none
+	 */
+	INT FindNode( ANavigationPoint* Nav ) const
+	{
+		const INT* NodeIndex = NodeIndices.Find( Nav );
+		return NodeIndex ? *NodeIndex : INDEX_NONE;
+	}
+
+private:
+	/**
+	 * Builds the graph from the navigation points of the passed in level.
+	 *
+	 * @param	LevelInfo	Level to build graph for
+	 */
+	void Build( ALevelInfo* LevelInfo );
+
+	/**
+	 * Groups the nodes into clusters and links clusters connected by edges.
+	 */
+	void BuildClusters();
+
+	/** Head of NavigationPointList the graph was built from, used to catch stale graphs */
+	ANavigationPoint*				FirstNavigationPoint;
+	/** Map from navigation point to node index */
+	TMap<ANavigationPoint*,INT>		NodeIndices;
+};
+
+/*-----------------------------------------------------------------------------
+	FPathQuery.
+-----------------------------------------------------------------------------*/
+
+/**
+ * A single path search. All search state lives in per query arrays indexed by
+ * node so any number of queries can run at the same time without touching the
+ * navigation points. Queries are set up on the game thread by Prepare, after
+ * which Execute may run on any thread as long as the node evaluation function
+ * is thread safe. Searches for a known destination use A* with the straight
+ * line distance as heuristic; searches driven by a node evaluation function
+ * expand nodes in order of path weight. Searches for a single destination on
+ * large graphs are restricted to a corridor of clusters, falling back to the
+ * whole graph if the corridor doesn't lead there.
+ *
+ * The scratch arrays are reused by subsequent queries run with the same object.
+ */
+class FPathQuery
+{
+public:
+	/** Distance from searcher to start node, set by APawn::PreparePathQuery */
+	FLOAT	StartDist;
+	/** Distance from destination node to goal, set by APawn::PreparePathQuery */
+	FLOAT	EndDist;
+	/** Whether the searcher should consider detours, set by APawn::PreparePathQuery */
+	UBOOL	bWeightDetours;
+
+	/** Constructor, initializing all members. */
+	FPathQuery();
+
+	/**
+	 * Sets up a search for the passed in pawn. Gathers all state that may only be
+	 * touched on the game thread: node costs, transient end points and script
+	 * driven costs. Consumes the transient path finding properties of all
+	 * navigation points like ANavigationPoint::ClearForPathFinding always has.
+	 *
+	 * @param	InSearcher		Pawn to find a path for
+	 * @param	Start			Node to start the search from
+	 * @param	StartWeight		Weight of reaching Start
+	 * @param	EndAnchor		Destination node, NULL if InNodeEval picks the destination
+	 * @param	InNodeEval		Node evaluation function, NULL to search for end points
+	 * @param	InBestWeight	Weight a node has to exceed to be picked as destination
+	 * @return	TRUE if the query is ready to be executed, FALSE if there is nothing to search
+	 */
+	UBOOL Prepare( APawn* InSearcher, ANavigationPoint* Start, INT StartWeight, ANavigationPoint* EndAnchor, NodeEvaluator InNodeEval, FLOAT InBestWeight );
+
+	/**
+	 * Runs the search set up by Prepare.
+	 */
+	void Execute();
+
+	/**
+	 * Updates state shared with other queries, needs to be called on the game
+	 * thread after Execute and before the graph can change.
+	 */
+	void Finish();
+
+	/**
+	 * @return best destination found by the search, NULL if none
+	 */
+	ANavigationPoint* GetBestDest() const
+	{
+		return BestNode != INDEX_NONE ? Graph->Nodes(BestNode).Nav : NULL;
+	}
+
+	/**
+	 * @return weight of best destination as returned by the node evaluation function
+	 */
+	FLOAT GetBestWeight() const
+	{
+		return BestWeight;
+	}
+
+	/**
+	 * Returns the weight of the cheapest path found to a navigation point.
+	 *
+	 * @param	Nav		Navigation point to look up
+	 * @return	path weight, UNREACHEDPATHWEIGHT if the search didn't reach Nav
+	 */
+	INT GetWeight( ANavigationPoint* Nav ) const;
+
+	/**
+	 * Returns the path from the start node to the best destination.
+	 *
+	 * @param	Route	[out] navigation points along the path, starting with the start node
+	 */
+	void GetRoute( TArray<ANavigationPoint*>& Route ) const;
+
+	/**
+	 * @return pawn the query was prepared for
+	 */
+	APawn* GetSearcher() const
+	{
+		return Searcher;
+	}
+
+private:
+	/** Flags gathered per node by Prepare */
+	enum
+	{
+		NODE_Blocked	= 1,
+		NODE_EndPoint	= 2,
+	};
+	/** Maximum number of end points the heuristic considers, beyond that the search falls back to Dijkstra */
+	enum { MAX_HEURISTIC_ENDPOINTS = 8 };
+
+	/** Entry in the open set, a binary heap ordered by Estimate */
+	struct FOpenNode
+	{
+		/** Path weight plus heuristic */
+		INT		Estimate;
+		/** Path weight at the time the entry was pushed, used to skip stale entries */
+		INT		Weight;
+		/** Index of node */
+		INT		Node;
+	};
+
+	/**
+	 * Adds an entry to a binary heap.
+	 */
+	static void PushHeap( TArray<FOpenNode>& Heap, const FOpenNode& Entry );
+
+	/**
+	 * Removes the entry with the lowest estimate from a binary heap.
+	 */
+	static FOpenNode PopHeap( TArray<FOpenNode>& Heap );
+
+	/**
+	 * Adds a node to the open set.
+	 */
+	void PushOpen( INT Node, INT Weight );
+
+	/**
+	 * Advances the generation and resets the results of the previous search.
+	 */
+	void BeginSearch();
+
+	/**
+	 * Searches the graph node by node.
+	 *
+	 * @param	bInCorridor		Whether to only consider nodes in the clusters of Corridor
+	 */
+	void Search( UBOOL bInCorridor );
+
+	/**
+	 * Searches the cluster graph for the cheapest corridor between two clusters
+	 * the searcher can traverse, storing it in Corridor.
+	 *
+	 * @param	StartCluster	Cluster to start from
+	 * @param	GoalCluster		Cluster to find corridor to
+	 * @return	TRUE if a corridor was found, FALSE if the goal can't be reached
+	 */
+	UBOOL FindCorridor( INT StartCluster, INT GoalCluster );
+
+	/**
+	 * @return lower bound of the weight of getting from the passed in node to an end point
+	 */
+	INT GetHeuristic( INT Node ) const;
+
+	/** Graph being searched */
+	FNavigationGraph*		Graph;
+	/** Pawn the query was prepared for */
+	APawn*					Searcher;
+	/** Node evaluation function, NULL to search for end points */
+	NodeEvaluator			NodeEval;
+	/** Node to start the search from */
+	INT						StartNode;
+	/** Weight of reaching start node */
+	INT						StartWeight;
+	/** Initial best weight */
+	FLOAT					InitialBestWeight;
+	/** Collision and movement capabilities of searcher */
+	INT						Radius;
+	INT						Height;
+	INT						MoveFlags;
+	INT						MaxFallSpeed;
+	/** Cost multiplier for paths too low for the searcher to walk upright */
+	FLOAT					CrouchMultiplier;
+	/** Collision height of the searcher's class, paths lower than this require crouching */
+	FLOAT					DefaultCollisionHeight;
+	/** Locations of end points used by the heuristic */
+	TArray<FVector>			EndLocations;
+	/** Whether the heuristic is used */
+	UBOOL					bUseHeuristic;
+	/** Whether the search is restricted to Corridor first */
+	UBOOL					bUseCorridor;
+	/** Set by Execute if the corridor didn't lead to the destination */
+	UBOOL					bCorridorFailed;
+	/** Set by Prepare if the cluster graph shows there is no path */
+	UBOOL					bUnreachable;
+	/** Clusters the search is restricted to */
+	TArray<INT>				Corridor;
+	/** Key Corridor is cached with */
+	FNavPathCacheKey		CorridorKey;
+
+	/** Per node cost, gathered by Prepare */
+	TArray<INT>				NodeCosts;
+	/** Per node flags, gathered by Prepare */
+	TArray<BYTE>			NodeFlags;
+	/** Cost of edges with bSpecialCost set the searcher can use, gathered by Prepare */
+	TMap<INT,INT>			SpecialCosts;
+
+	/** Per node weight of best path found, valid if the node's seen stamp matches Generation */
+	TArray<INT>				Weights;
+	/** Per node predecessor on best path found, valid if the node's seen stamp matches Generation */
+	TArray<INT>				Previous;
+	/** Per node generation in which the node was reached */
+	TArray<DWORD>			SeenStamps;
+	/** Per node generation in which the node was expanded */
+	TArray<DWORD>			ClosedStamps;
+	/** Incremented by every search so scratch state doesn't need to be cleared */
+	DWORD					Generation;
+	/** Open set */
+	TArray<FOpenNode>		OpenSet;
+
+	/** Per cluster generation in which the cluster is part of the corridor */
+	TArray<DWORD>			CorridorStamps;
+	/** Per cluster weight and predecessor of the corridor search, valid if the cluster's seen stamp matches ClusterGeneration */
+	TArray<INT>				ClusterWeights;
+	TArray<INT>				ClusterPrevious;
+	/** Per cluster generation in which the cluster was reached and expanded by the corridor search */
+	TArray<DWORD>			ClusterSeenStamps;
+	TArray<DWORD>			ClusterClosedStamps;
+	/** Incremented by every corridor search */
+	DWORD					ClusterGeneration;
+	/** Open set of corridor search */
+	TArray<FOpenNode>		ClusterOpenSet;
+
+	/** Best destination found, INDEX_NONE if none */
+	INT						BestNode;
+	/** Weight of best destination */
+	FLOAT					BestWeight;
+};
@@ -0,0 +1,184 @@
+/*=============================================================================
+	UnPawnMovement.h: Movement phase running AI pawn walking physics in parallel.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/**
+ * Static blocking geometry within some bounds, gathered on the game thread so that
+ * worker threads can sweep boxes through it. Used by the pawn movement phase and by
+ * path building. Zero initialized, as it lives in arrays grown with AddZeroed.
+ */
+struct FCollisionSnapshot
+{
+	/** Level whose BSP is swept */
+	ULevel*								Level;
+	/** Static blocking primitives overlapping the bounds the snapshot was gathered for */
+	TArray<UPrimitiveComponent*>		Primitives;
+	/** Cycles spent sweeping the BSP and static meshes off the game thread, see AddCollisionStats */
+	DWORD								BSPCycles;
+	DWORD								StaticMeshCycles;
+
+	/**
+	 * Gathers the static geometry that blocks Mover within Bounds.
+	 *
+	 * @param	InLevel		Level to gather the geometry of
+	 * @param	Bounds		Bounds any sweep through the snapshot stays within
+	 * @param	Mover		Actor the sweeps are done for, filtering out what doesn't block it
+	 * @param	Scratch		Array to reuse for octree queries
+	 * @return	FALSE if anything but static geometry that can be checked from worker threads blocks Mover within Bounds
+	 */
+	UBOOL Gather( ULevel* InLevel, const FBox& Bounds, AActor* Mover, TArray<UPrimitiveComponent*>& Scratch );
+
+	/**
+	 * Sweeps a box through the level's BSP and the primitives of the snapshot. Only
+	 * uses collision code that is safe to run on several threads at once. Time spent
+	 * off the game thread is accumulated in the snapshot rather than GCollisionStats.
+	 *
+	 * @return	TRUE if unblocked, FALSE if blocked, in which case Hit holds the first hit
+	 */
+	UBOOL LineCheck( FCheckResult& Hit, const FVector& End, const FVector& Start, const FVector& Extent );
+
+	/**
+	 * Adds the time spent sweeping off the game thread to GCollisionStats. Called on the
+	 * game thread once the workers are done.
+	 */
+	void AddCollisionStats() const;
+};
+
+/**
+ * Takes over the walking physics of AI controlled pawns during a level tick and runs
+ * it in a movement phase once all actors have been ticked.
+ *
+ * Collision queries against the level aren't thread safe, so the phase first gathers
+ * the static world geometry around each pawn into a read-only snapshot on the game
+ * thread. Pawns whose swept bounds overlap another deferred pawn or anything that
+ * isn't static blocking geometry are marked as interacting. The moves of all other
+ * pawns are then simulated in parallel against their snapshots. A simulated move is
+ * only kept if it is a plain step across flat ground that needs none of the step up,
+ * ledge, slope or zone handling of APawn::physWalking, everything else falls back to
+ * regular physics.
+ *
+ * Moves are committed with MoveActor on the game thread in the order pawns were
+ * deferred, so touch, bump and landing events are dispatched in actor tick order.
+ */
+class FPawnMovementPhase
+{
+public:
+	/**
+	 * Constructor, reading the settings from the engine ini.
+	 *
+	 * @param	InLevel		Level whose pawns are moved
+	 */
+	FPawnMovementPhase( ULevel* InLevel );
+
+	/**
+	 * Starts accepting pawns for the movement phase, called before the actors of
+	 * the level are ticked.
+	 */
+	void BeginCollecting();
+
+	/**
+	 * Defers a pawn's physics to the movement phase if possible, called by
+	 * APawn::performPhysics in place of APawn::startNewPhysics.
+	 *
+	 * @param	Pawn			Pawn to move
+	 * @param	DeltaSeconds	Time to move the pawn for
+	 * @param	OldVelocity		Velocity of the pawn before physics, passed on to APawn::finishPhysics
+	 * @return	TRUE if the movement phase took over the pawn's physics
+	 */
+	UBOOL DeferPhysics( APawn* Pawn, FLOAT DeltaSeconds, const FVector& OldVelocity );
+
+	/**
+	 * Moves all deferred pawns, called once all actors of the level have been ticked.
+	 */
+	void Tick();
+
+	/**
+	 * Removes all references to actors that are about to be deleted.
+	 */
+	void CleanupDestroyed();
+
+private:
+	/** Pawn whose physics was deferred */
+	struct FDeferredMove
+	{
+		APawn*		Pawn;
+		FLOAT		DeltaSeconds;
+		FVector		OldVelocity;
+	};
+
+	/** Read-only collision around a pawn and the result of simulating its move */
+	struct FPawnMove
+	{
+		/** Index of the move in the deferred moves */
+		INT									DeferredIndex;
+		/** Bounds the pawn can reach this frame, including probes */
+		FBox								Bounds;
+		/** Whether the move is simulated, FALSE if the pawn interacts with anything */
+		UBOOL								bCandidate;
+		/** Static blocking geometry overlapping Bounds */
+		FCollisionSnapshot					Snapshot;
+		/** Whether the pawn may do a ledge check this frame */
+		UBOOL								bLedgeCheck;
+		/** Location, velocity and acceleration the move was simulated from */
+		FVector								StartLocation;
+		FVector								StartVelocity;
+		FVector								StartAcceleration;
+
+		/** Whether the simulated move can be committed */
+		UBOOL								bValid;
+		/** Move to commit */
+		FVector								Delta;
+		/** Velocity and acceleration after APawn::calcVelocity */
+		FVector								NewVelocity;
+		FVector								NewAcceleration;
+		/** Floor the pawn ends up on */
+		FVector								NewFloor;
+	};
+
+	friend class FPawnMoveSimulator;
+
+	/**
+	 * Returns whether a pawn's physics can be deferred to the movement phase.
+	 */
+	static UBOOL CanDefer( APawn* Pawn, FLOAT DeltaSeconds );
+
+	/**
+	 * Computes the bounds of a deferred pawn's move and gathers the static blocking
+	 * geometry within them into its snapshot.
+	 *
+	 * @param	Move		Move to fill in, its DeferredIndex has to be set
+	 * @param	Scratch		Array to reuse for octree queries
+	 * @return	FALSE if the pawn can't be simulated or anything else that may interact with it is nearby
+	 */
+	UBOOL GatherSnapshot( FPawnMove& Move, TArray<UPrimitiveComponent*>& Scratch );
+
+	/**
+	 * Simulates the walking move of a pawn against its snapshot, filling in the
+	 * result fields of Move. Runs on worker threads, only touching Move and the pawn.
+	 */
+	void SimulateMove( FPawnMove& Move ) const;
+
+	/**
+	 * Applies a simulated move, or runs regular physics if the move was rejected or
+	 * its pawn has changed since.
+	 */
+	void CommitMove( const FDeferredMove& Deferred, const FPawnMove& Move );
+
+	/** Level whose pawns are moved */
+	ULevel*								Level;
+	/** Whether pawn physics may be deferred at all */
+	UBOOL								bEnabled;
+	/** Whether pawns are accepted by DeferPhysics */
+	UBOOL								bCollecting;
+
+	/** Pawns whose physics was deferred this frame, in actor tick order */
+	TArray<FDeferredMove>				DeferredMoves;
+	/** Pawns in DeferredMoves */
+	TMap<APawn*,INT>					DeferredIndices;
+};
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
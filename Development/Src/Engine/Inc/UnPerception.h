@@ -0,0 +1,193 @@
+/*=============================================================================
+	UnPerception.h: Batched AI sight and hearing.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/**
+ * Pair of observing controller and observed pawn, used as key of cached visibility results.
+ */
+struct FPerceptionPair
+{
+	AController*	Observer;
+	APawn*			Target;
+
+	FPerceptionPair()
+	{}
+	FPerceptionPair( AController* InObserver, APawn* InTarget )
+	:	Observer( InObserver )
+	,	Target( InTarget )
+	{}
+	UBOOL operator==( const FPerceptionPair& Other ) const
+	{
+		return Observer == Other.Observer && Target == Other.Target;
+	}
+	friend DWORD GetTypeHash( const FPerceptionPair& Pair )
+	{
+		return GetTypeHash(Pair.Observer) ^ (GetTypeHash(Pair.Target) * 23);
+	}
+};
+
+/**
+ * Gathers the sight and hearing checks controllers request during a level tick and
+ * runs them in one batch once all actors have been ticked. Observers and listeners
+ * are bucketed into a grid so only nearby ones are considered, visibility traces are
+ * limited per frame with the remainder carried over to the next frame, and recent
+ * visibility results are reused. SeePlayer, SeeMonster, EnemyNotVisible and HearNoise
+ * events are delivered after all checks of the batch have been run.
+ */
+class FPerceptionManager
+{
+public:
+	/**
+	 * Constructor, reading the budget settings from the engine ini.
+	 *
+	 * @param	InLevel		Level whose controllers are managed
+	 */
+	FPerceptionManager( ULevel* InLevel );
+
+	/**
+	 * Requests a controller's pawn to be shown to all controllers ready to see it,
+	 * replacing AController::ShowSelf.
+	 *
+	 * @param	Controller	Controller whose pawn is shown
+	 */
+	void AddShowSelf( AController* Controller );
+
+	/**
+	 * Requests a check whether a controller can still see its enemy, replacing
+	 * AController::CheckEnemyVisible.
+	 *
+	 * @param	Controller	Controller to check enemy visibility for
+	 */
+	void AddEnemyCheck( AController* Controller );
+
+	/**
+	 * Requests a noise to be delivered to all controllers that can hear it.
+	 *
+	 * @param	Maker			Actor making the noise
+	 * @param	Loudness		Loudness of noise
+	 * @param	bOnlySameTag	Whether only controllers with the same tag as Maker can hear the noise
+	 */
+	void AddNoise( AActor* Maker, FLOAT Loudness, UBOOL bOnlySameTag );
+
+	/**
+	 * Runs all checks requested since the last call and delivers the resulting events.
+	 */
+	void Tick();
+
+	/**
+	 * Removes all references to actors that are about to be deleted.
+	 */
+	void CleanupDestroyed();
+
+private:
+	/** Milliseconds a visibility result is reused for */
+	enum { CACHE_LIFETIME_MS = 150 };
+	/** Distance observer or target can move before a cached visibility result is discarded */
+	enum { CACHE_MAX_MOVEMENT = 64 };
+	/** Size of grid cells observers and listeners are bucketed into */
+	enum { GRID_CELL_SIZE = 2048 };
+
+	/** Noise waiting to be heard */
+	struct FPendingNoise
+	{
+		AActor*		Maker;
+		APawn*		Instigator;
+		FVector		Location;
+		FLOAT		Loudness;
+		UBOOL		bOnlySameTag;
+	};
+
+	/** Sight check waiting for the trace budget */
+	struct FPendingSight
+	{
+		AController*	Observer;
+		APawn*			Target;
+		UBOOL			bTargetIsPlayer;
+	};
+
+	/** Cached result of a sight check */
+	struct FVisibilityResult
+	{
+		FLOAT		Time;
+		FVector		ObserverLocation;
+		FVector		TargetLocation;
+		UBOOL		bVisible;
+	};
+
+	/** Event to deliver at the end of the batch */
+	struct FPerceptionEvent
+	{
+		enum EType
+		{
+			PE_SeePlayer,
+			PE_SeeMonster,
+			PE_EnemyNotVisible,
+			PE_HearNoise,
+		};
+		BYTE			Type;
+		AController*	Controller;
+		AActor*			Other;
+		FLOAT			Loudness;
+	};
+
+	/**
+	 * Buckets controllers into Grid.
+	 *
+	 * @param	Controllers		Controllers to bucket, all of which need a pawn
+	 */
+	void BuildGrid( const TArray<AController*>& Controllers );
+
+	/**
+	 * Gathers the controllers bucketed into cells overlapping a sphere.
+	 *
+	 * @param	Controllers		Controllers Grid was built from
+	 * @param	Center			Center of sphere
+	 * @param	Radius			Radius of sphere
+	 * @param	Result			[out] controllers in overlapping cells, in Controllers order
+	 */
+	void GatherNearby( const TArray<AController*>& Controllers, const FVector& Center, FLOAT Radius, TArray<AController*>& Result );
+
+	/**
+	 * Returns whether a sight check has to be run at all, applying the distance and
+	 * field of view tests of AController::SeePawn before any trace is spent on it.
+	 */
+	static UBOOL PassesSightCull( AController* Observer, APawn* Target );
+
+	/**
+	 * Runs or defers a sight check, using a cached result if possible.
+	 *
+	 * @return	TRUE if the check was run or answered from the cache, FALSE if it was deferred
+	 */
+	UBOOL CheckSight( AController* Observer, APawn* Target, UBOOL bTargetIsPlayer );
+
+	/** Level whose controllers are managed */
+	ULevel*								Level;
+	/** Maximum number of visibility checks that may trace per frame */
+	INT									MaxSightChecksPerFrame;
+	/** Visibility checks that traced this frame */
+	INT									SightChecksThisFrame;
+
+	/** Controllers that requested their pawn to be shown */
+	TArray<AController*>				ShowSelfRequests;
+	/** Controllers that requested an enemy visibility check */
+	TArray<AController*>				EnemyCheckRequests;
+	/** Noises made */
+	TArray<FPendingNoise>				PendingNoises;
+	/** Sight checks deferred by the trace budget, at most one per observer and target */
+	TMap<FPerceptionPair,FPendingSight>	DeferredSights;
+	/** Recent visibility results */
+	TMap<FPerceptionPair,FVisibilityResult>	VisibilityCache;
+	/** Time the visibility cache was last pruned */
+	FLOAT								LastCachePruneTime;
+
+	/** Grid of controllers, mapping cell to indices into the controllers the grid was built from */
+	TMap<QWORD,TArray<INT> >			Grid;
+	/** Events to deliver */
+	TArray<FPerceptionEvent>			Events;
+};
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -0,0 +1,189 @@
+/*=============================================================================
+	UnSequenceRuntime.h: Compiled gameplay sequences and event dispatch index.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+/**
+ * Kinds of sequence variables gathered by the USequenceOp::Get*Vars helpers.
+ */
+enum ESequenceVariableKind
+{
+	SVK_Bool,
+	SVK_Int,
+	SVK_Float,
+	SVK_Object,
+	SVK_String,
+	SVK_MAX,
+};
+
+/**
+ * Per level runtime data of the gameplay sequences, created by USequence::BeginPlay.
+ *
+ * Sequences are compiled into flat arrays holding only the objects USequence::BuildOpStack
+ * and USequence::UpdateOp have to look at, so plain actions, conditions and variables are
+ * never visited while ticking, and nested sequences without any events or latent actions
+ * aren't updated at all. The variable links of each op are sorted by kind of variable so
+ * the Get*Vars helpers only visit links of the requested kind. Finally the events actors
+ * generate are indexed by event class for AActor::GetEventOfClass.
+ *
+ * Compiled data is checked against the number of objects and links it was built from and
+ * rebuilt on mismatch, so sequences changed at runtime stay correct.
+ */
+class FSequenceRuntime
+{
+public:
+	/** Object of a compiled sequence that can place ops on the op stack */
+	struct FStackOp
+	{
+		enum EType
+		{
+			SO_Event,
+			SO_Latent,
+			SO_Sequence,
+		};
+		USequenceOp*	Op;
+		BYTE			Type;
+	};
+
+	/** Compiled form of a sequence */
+	struct FCompiledSequence
+	{
+		/** Number of sequence objects the sequence had when compiled */
+		INT										NumSequenceObjects;
+		/** Whether the sequence has to be compiled again before being used */
+		UBOOL									bStale;
+		/** Events, latent actions and nested sequences, in SequenceObjects order */
+		TArray<FStackOp>						StackOps;
+		/** Nested sequences that have stack ops, updated after the sequence itself */
+		TArray<USequence*>						UpdatedSequences;
+		/** Events activated through the inputs of the sequence */
+		TArray<USeqEvent_SequenceActivated*>	ActivatedEvents;
+	};
+
+	/** Compiled variable links of an op */
+	struct FCompiledOp
+	{
+		/** Number of variable links the op had when compiled */
+		INT										NumVariableLinks;
+		/** Indices into VariableLinks, by kind of variable expected */
+		TArray<INT>								VariableLinks[SVK_MAX];
+	};
+
+	/**
+	 * Constructor.
+	 *
+	 * @param	InLevel		Level whose sequences are run
+	 */
+	FSequenceRuntime( ULevel* InLevel );
+
+	/**
+	 * Destructor, freeing all compiled sequences.
+	 */
+	~FSequenceRuntime();
+
+	/**
+	 * Returns the kind of variables a variable link expecting the passed in class gathers,
+	 * or SVK_MAX if none of the Get*Vars helpers gathers it.
+	 */
+	static ESequenceVariableKind GetVariableKind( UClass* ExpectedType );
+
+	/**
+	 * Compiles a sequence and the ops it contains, replacing any earlier compiled form.
+	 * Called by USequence::BeginPlay once its events are registered and its external
+	 * and named variables resolved.
+	 *
+	 * @param	Sequence	Sequence to compile
+	 * @return	compiled sequence, owned by the runtime
+	 */
+	FCompiledSequence* CompileSequence( USequence* Sequence );
+
+	/**
+	 * Returns the compiled form of a sequence, compiling it if it is missing or out of date.
+	 * The returned pointer stays valid for the lifetime of the runtime.
+	 */
+	FCompiledSequence* GetCompiledSequence( USequence* Sequence );
+
+	/**
+	 * Marks a sequence and all sequences containing it to be compiled again.
+	 */
+	void InvalidateSequence( USequence* Sequence );
+
+	/**
+	 * Returns the compiled variable links of an op, or NULL if the op wasn't compiled
+	 * or its variable links have changed since.
+	 */
+	const FCompiledOp* FindCompiledOp( USequenceOp* Op )
+	{
+		const FCompiledOp* CompiledOp = CompiledOps.Find( Op );
+		return CompiledOp && CompiledOp->NumVariableLinks == Op->VariableLinks.Num() ? CompiledOp : NULL;
+	}
+
+	/**
+	 * Looks up the next event of a class an actor generates, see AActor::GetEventOfClass.
+	 *
+	 * @param	Actor		Actor whose generated events are searched
+	 * @param	EventClass	Class of event to search for
+	 * @param	LastEvent	Event returned by the previous call, or NULL to get the first one
+	 * @param	OutEvent	[out] next matching event after LastEvent, or NULL if there is none
+	 * @return	FALSE if the index can't answer the query, because LastEvent isn't of the class
+	 */
+	UBOOL FindEventOfClass( AActor* Actor, UClass* EventClass, USequenceEvent* LastEvent, USequenceEvent*& OutEvent );
+
+	/**
+	 * Drops the indexed events of an actor, called whenever its GeneratedEvents change.
+	 */
+	void InvalidateEvents( AActor* Actor )
+	{
+		EventIndex.Remove( Actor );
+	}
+
+	/**
+	 * Drops the indexed events of all actors.
+	 */
+	void ResetEvents()
+	{
+		EventIndex.Empty();
+	}
+
+	/**
+	 * Removes all references to actors that are about to be deleted.
+	 */
+	void CleanupDestroyed();
+
+private:
+	/** Events of one class an actor generates */
+	struct FClassEvents
+	{
+		UClass*						EventClass;
+		/** Generated events that are of EventClass, in GeneratedEvents order */
+		TArray<USequenceEvent*>		Events;
+	};
+
+	/** Indexed events of an actor */
+	struct FActorEvents
+	{
+		/** Number of generated events the actor had when indexed */
+		INT							NumGeneratedEvents;
+		/** Events by class, for each class that has been looked up */
+		TArray<FClassEvents>		Classes;
+	};
+
+	/**
+	 * Compiles the variable links of an op.
+	 */
+	void CompileOp( USequenceOp* Op );
+
+	/** Level whose sequences are run */
+	ULevel*										Level;
+	/** Compiled sequences */
+	TMap<USequence*,FCompiledSequence*>			CompiledSequences;
+	/** Compiled variable links of all ops of compiled sequences */
+	TMap<USequenceOp*,FCompiledOp>				CompiledOps;
+	/** Events of actors that have been looked up */
+	TMap<AActor*,FActorEvents>					EventIndex;
+};
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
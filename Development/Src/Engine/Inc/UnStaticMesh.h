@@ -233,6 +233,38 @@ public:
 
 	void Build();
 
+	/**
+	 * Rebuilds several static meshes, building the geometry of different meshes in parallel.
+	 * The meshes end up the same as if Build had been called on each of them.
+	 *
+	 * @param StaticMeshes Meshes to rebuild, each listed once
+	 */
+	static void BuildMeshes(const TArray<UStaticMesh*>& StaticMeshes);
+
+	/**
+	 * First step of Build, clearing the built data and loading the source triangles.
+	 * Must be called from the main thread.
+	 */
+	void BeginBuild();
+
+	/**
+	 * Second step of Build, computing the vertices, per material triangle lists, bounds and
+	 * collision tree from the source triangles. Only touches the mesh's own data, so several
+	 * meshes may be built concurrently.
+	 *
+	 * @param BuildData [out] Data for FinishBuild
+	 * @param bReportProgress Whether to update the slow task progress, main thread only
+	 */
+	void BuildGeometry(struct FStaticMeshBuildData& BuildData,UBOOL bReportProgress);
+
+	/**
+	 * Last step of Build, optimizing the index buffer, building the edges and updating the
+	 * render resources. Must be called from the main thread.
+	 *
+	 * @param BuildData Data computed by BuildGeometry
+	 */
+	void FinishBuild(struct FStaticMeshBuildData& BuildData);
+
 	/**
 	 * Returns the scale dependent texture factor used by the texture streaming code.	
 	 *
@@ -172,24 +172,35 @@ public:
 
 //
 //	FCycleCounterSection - A utility class that adds the cycles between it's creation and destruction to a cycle counter.
+//	The section is also recorded as a trace event labeled after the counter while a trace capture is running.
+//	Counters are only updated from the game thread, sections on other threads leave them alone.
 //
 
 struct FCycleCounterSection
 {
-	FCycleCounter&	Counter;
-	DWORD			StartCycles;
+	FCycleCounter&		Counter;
+#if DO_TRACE
+	FScopedTraceEvent	TraceEvent;
+#endif
+	DWORD				StartCycles;
 
 	// Constructor/destructor.
 
 	FCycleCounterSection(FCycleCounter& InCounter):
 		Counter(InCounter),
+#if DO_TRACE
+		TraceEvent(InCounter.Label),
+#endif
 		StartCycles(appCycles())
 	{
 	}
 
 	~FCycleCounterSection()
 	{
-		Counter.Value += appCycles() - StartCycles;
+		if( appGetCurrentThreadId() == GGameThreadId )
+		{
+			Counter.Value += appCycles() - StartCycles;
+		}
 	}
 };
 
@@ -279,6 +290,9 @@ struct FCollisionStatGroup: FStatGroup
 					BSPZeroExtentTime,
 					BSPExtentTime,
 					BSPPointTime;
+	FStatCounter	BatchedMoves,
+					OctreeQueriesAvoided,
+					OverlapTestsAvoided;
 
 	// Constructor.
 
@@ -292,7 +306,10 @@ struct FCollisionStatGroup: FStatGroup
 		StaticMeshPointTime(this,TEXT("Static mesh point")),
 		BSPZeroExtentTime(this,TEXT("BSP line")),
 		BSPExtentTime(this,TEXT("BSP swept box")),
-		BSPPointTime(this,TEXT("BSP point"))
+		BSPPointTime(this,TEXT("BSP point")),
+		BatchedMoves(this,TEXT("Batched attachment moves")),
+		OctreeQueriesAvoided(this,TEXT("Octree queries avoided by batched moves")),
+		OverlapTestsAvoided(this,TEXT("Overlap tests avoided"))
 	{}
 };
 
@@ -366,6 +383,16 @@ struct FStreamingStatGroup : FStatGroup
 	FStatCounter		StreamedInTextures;
 	FStatCounter		OutstandingTextureRequests;
 	FStatCounter		CanceledTextureRequests;
+	FStatCounter		DeferredTextureRequests;
+	FStatCounter		EvictedTextures;
+	FStatCounterFloat	PoolSize;
+	FStatCounterFloat	PoolUsage;
+	FStatCounter		AsyncIORequests;
+	FStatCounter		AsyncIOReads;
+	FStatCounter		AsyncIOSeeks;
+	FStatCounter		AsyncIOOvertakes;
+	FStatCounter		AsyncIOQueueDepth;
+	FStatCounterFloat	AsyncIOThroughput;
 	FCycleCounter		ProcessViewerTime;
 	FCycleCounter		TickTime;
 	FCycleCounter		DataShuffleTime;
@@ -378,6 +405,16 @@ struct FStreamingStatGroup : FStatGroup
 		StreamedInTextures(this,TEXT("Streamable textures")),
 		OutstandingTextureRequests(this,TEXT("Outstanding texture requests")),
 		CanceledTextureRequests(this,TEXT("Canceled texture requests")),
+		DeferredTextureRequests(this,TEXT("Texture requests waiting for pool memory")),
+		EvictedTextures(this,TEXT("Textures evicted from pool")),
+		PoolSize(this,TEXT("Streaming pool size in MByte")),
+		PoolUsage(this,TEXT("Streaming pool usage in MByte")),
+		AsyncIORequests(this,TEXT("Async IO requests serviced")),
+		AsyncIOReads(this,TEXT("Async IO reads")),
+		AsyncIOSeeks(this,TEXT("Async IO seeks")),
+		AsyncIOOvertakes(this,TEXT("Async IO reads ahead of lower priority requests")),
+		AsyncIOQueueDepth(this,TEXT("Async IO queue depth")),
+		AsyncIOThroughput(this,TEXT("Async IO throughput in MByte/s")),
 		ProcessViewerTime(this,TEXT("ProcessViewer time")),
 		TickTime(this,TEXT("Tick time")),
 		DataShuffleTime(this,TEXT("Data shuffling time")),
@@ -406,6 +443,14 @@ struct FMemoryStatGroup : FStatGroup
 	FStatCounterFloat	VirtualAllocations;
 	/** Size of physical allocations							*/
 	FStatCounterFloat	PhysicalAllocations;
+	/** Number of heap allocations last frame					*/
+	FStatCounter		HeapAllocations;
+	/** Number of frame arena allocations last frame			*/
+	FStatCounter		FrameArenaAllocations;
+	/** Frame arena requests last frame that fell back to heap	*/
+	FStatCounter		FrameArenaFallbacks;
+	/** Peak usage of frame arena last frame					*/
+	FStatCounterFloat	FrameArenaPeakSize;
 
 	/** Constructor, initializing variable name to caption mapping */
 	FMemoryStatGroup()
@@ -417,7 +462,11 @@ struct FMemoryStatGroup : FStatGroup
 		BSPShadowMapSize(this,TEXT("Total size of BSP shadow maps in MByte")),
 		StaticMeshShadowMapSize(this,TEXT("Total size of static mesh shadow maps in MByte")),
 		PhysicalAllocations(this,TEXT("Total size of physical allocations in MByte")),
-		VirtualAllocations(this,TEXT("Total size of virtual allocations in MByte"))
+		VirtualAllocations(this,TEXT("Total size of virtual allocations in MByte")),
+		HeapAllocations(this,TEXT("Heap allocations per frame")),
+		FrameArenaAllocations(this,TEXT("Frame arena allocations per frame")),
+		FrameArenaFallbacks(this,TEXT("Frame arena fallbacks to heap per frame")),
+		FrameArenaPeakSize(this,TEXT("Peak frame arena usage in KByte"))
 	{}
 };
 
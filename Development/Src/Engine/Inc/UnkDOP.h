@@ -32,6 +32,15 @@ Revision history:
 #define PARALLEL_LINE_KDOP_EPSILON 1e-30f
 // Amount to expand the kDOP by
 #define FUDGE_SIZE 0.1f
+// Number of buckets triangle centroids are sorted into per plane when looking
+// for the split with the lowest surface area heuristic cost
+#define KDOP_SAH_BINS 16
+// Value of FkDOPCompactNode::NumTriangles marking a node with children
+#define KDOP_COMPACT_INTERIOR 0xFFFF
+// Set in FkDOPWideNode::Children for children that are a list of triangles
+#define KDOP_WIDE_LEAF 0x80000000
+// Whether line checks traverse the four wide nodes instead of the compact nodes
+#define KDOP_WIDE_NODES 0
 
 // Forward decl
 class FkDOPLineCollisionCheck;
@@ -84,6 +93,13 @@ struct FkDOPBuildCollisionTriangle : public FkDOPCollisionTriangle
 		// Now calculate the centroid for the triangle
 		Centroid = (pSMTriangle->Vertices[0] + pSMTriangle->Vertices[1] + pSMTriangle->Vertices[2]) / 3.f;
 	}
+	// Rebuilds the build data of a triangle of an existing tree, with the
+	// centroid calculated from the welded vertices
+	FkDOPBuildCollisionTriangle(const FkDOPCollisionTriangle& Triangle,const TArray<FStaticMeshVertex>& Vertices) :
+		FkDOPCollisionTriangle(Triangle)
+	{
+		Centroid = (Vertices(v1).Position + Vertices(v2).Position + Vertices(v3).Position) / 3.f;
+	}
 };
 
 // This structure holds the min & max bounding planes that make up the DOP,
@@ -113,6 +129,9 @@ struct FkDOP
 	FORCEINLINE UBOOL PointCheck(FkDOPPointCollisionCheck& Check);
 	// Checks a bounding box against this kdop.
 	FORCEINLINE UBOOL AABBOverlapCheck(const FBox& LocalAABB);
+	// Returns the surface area of the volume, used to estimate how likely it
+	// is to be hit by a query
+	FLOAT GetSurfaceArea(void) const;
 
 	// Constructors
 	FkDOP() { Init(); }
@@ -174,25 +193,25 @@ struct FkDOPNode
 	}
 
 	// Recursively subdivide a triangle list into hierarchical volumes
-	void SplitTriangleList(TArray<FStaticMeshVertex>& Vertices,INT Start,INT NumTris,TArray<FkDOPBuildCollisionTriangle>& BuildTriangles,TArray<FkDOPNode>& Nodes);
+	void SplitTriangleList(TArray<FStaticMeshVertex>& Vertices,INT Start,INT NumTris,TArray<FkDOPBuildCollisionTriangle>& BuildTriangles,TArray<FkDOPNode>& Nodes,UBOOL bSurfaceAreaHeuristic);
 	// Performs a line check against the node
 	UBOOL LineCheck(FkDOPLineCollisionCheck& Check);
-	// Performs a line check against the triangles in this node
-	FORCEINLINE UBOOL LineCheckTriangles(FkDOPLineCollisionCheck& Check);
+	// Performs a line check against a range of the tree's triangles
+	static FORCEINLINE UBOOL LineCheckTriangles(FkDOPLineCollisionCheck& Check,INT StartIndex,INT NumTriangles);
 	// Performs a line check against a single triangle
-	FORCEINLINE UBOOL LineCheckTriangle(FkDOPLineCollisionCheck& Check,const FStaticMeshVertex& v1,const FStaticMeshVertex& v2,const FStaticMeshVertex& v3,INT MaterialIndex);
+	static FORCEINLINE UBOOL LineCheckTriangle(FkDOPLineCollisionCheck& Check,const FStaticMeshVertex& v1,const FStaticMeshVertex& v2,const FStaticMeshVertex& v3,INT MaterialIndex);
 	// Sweeps a box against this node and its children
 	UBOOL BoxCheck(FkDOPBoxCollisionCheck& Check);
-	// Checks for an intersection of the box and this node's triangles
-	FORCEINLINE UBOOL BoxCheckTriangles(FkDOPBoxCollisionCheck& Check);
+	// Checks for an intersection of the box and a range of the tree's triangles
+	static FORCEINLINE UBOOL BoxCheckTriangles(FkDOPBoxCollisionCheck& Check,INT StartIndex,INT NumTriangles);
 	// Checks for an intersection of the box and a single triangle
-	FORCEINLINE UBOOL BoxCheckTriangle(FkDOPBoxCollisionCheck& Check,const FVector& v1,const FVector& v2,const FVector& v3,INT MaterialIndex);
+	static FORCEINLINE UBOOL BoxCheckTriangle(FkDOPBoxCollisionCheck& Check,const FVector& v1,const FVector& v2,const FVector& v3,INT MaterialIndex);
 	// Checks to see if a point with extent intesects with this node
 	UBOOL PointCheck(FkDOPPointCollisionCheck& Check);
-	// Checks for an intersection of the point (plus extent) and this node's triangles
-	FORCEINLINE UBOOL PointCheckTriangles(FkDOPPointCollisionCheck& Check);
+	// Checks for an intersection of the point (plus extent) and a range of the tree's triangles
+	static FORCEINLINE UBOOL PointCheckTriangles(FkDOPPointCollisionCheck& Check,INT StartIndex,INT NumTriangles);
 	// Checks for an intersection of the point (plus extent) and a single triangle
-	FORCEINLINE UBOOL PointCheckTriangle(FkDOPPointCollisionCheck& Check, const FVector& v1,const FVector& v2,const FVector& v3, INT MaterialIndex);
+	static FORCEINLINE UBOOL PointCheckTriangle(FkDOPPointCollisionCheck& Check, const FVector& v1,const FVector& v2,const FVector& v3, INT MaterialIndex);
 	// Query tree to find overlapping triangles.
 	void SphereQuery(FkDOPSphereQuery& Query);
 
@@ -214,6 +233,52 @@ struct FkDOPNode
 	}
 };
 
+// Quantized copy of a FkDOPNode, half its size so more of the tree fits in
+// the cache. The bounds are stored in 1/65535ths of the parent's bounds and
+// are rounded outwards, so the decoded volume always contains the original.
+struct FkDOPCompactNode
+{
+	// Distance of the min planes from the parent's min planes
+	_WORD Min[NUM_PLANES];
+	// Distance of the max planes from the parent's max planes
+	_WORD Max[NUM_PLANES];
+	// Index of the first of the two consecutive child nodes, or the index of
+	// the first triangle for leaves
+	_WORD Index;
+	// Number of triangles of a leaf, or KDOP_COMPACT_INTERIOR
+	_WORD NumTriangles;
+
+	// Quantizes the bounds of a node relative to the decoded bounds of its parent
+	void SetBounds(const FkDOP& ParentBounds,const FkDOP& Bounds);
+	// Decodes the bounds of this node given the decoded bounds of its parent
+	FORCEINLINE void GetBounds(const FkDOP& ParentBounds,FkDOP& OutBounds) const
+	{
+		for (INT nPlane = 0; nPlane < NUM_PLANES; nPlane++)
+		{
+			FLOAT Scale = (ParentBounds.Max[nPlane] - ParentBounds.Min[nPlane]) * (1.f / 65535.f);
+			OutBounds.Min[nPlane] = ParentBounds.Min[nPlane] + Min[nPlane] * Scale;
+			OutBounds.Max[nPlane] = ParentBounds.Max[nPlane] - Max[nPlane] * Scale;
+		}
+	}
+};
+
+// A node with up to four children whose bounds are stored plane by plane, so
+// a line can be tested against all of them at once with SIMD instructions.
+// Built from the binary nodes by pulling up grandchildren.
+struct FkDOPWideNode
+{
+	// The bounds of the children, inside out for unused children
+	FLOAT Min[NUM_PLANES][4];
+	FLOAT Max[NUM_PLANES][4];
+	// Index of each child in FkDOPTree::WideNodes, or KDOP_WIDE_LEAF with the
+	// number of triangles in bits 16-30 and the first triangle in bits 0-15
+	DWORD Children[4];
+
+	// Tests a line against the bounds of the children, returning a bit per
+	// child that was hit and the time each one was entered at
+	FORCEINLINE DWORD LineCheck(FkDOPLineCollisionCheck& Check,FLOAT* HitTimes) const;
+};
+
 // This is the tree of kDOPs that spatially divides the static mesh. It is
 // a binary tree of kDOP nodes.
 struct FkDOPTree
@@ -223,14 +288,26 @@ struct FkDOPTree
 	TArray<FkDOPNode> Nodes;
 	// This is the list of collision triangles in this tree
 	TArray<FkDOPCollisionTriangle> Triangles;
+	// Quantized copy of Nodes used by the queries, not serialized but
+	// rebuilt from Nodes. Node 0 is decoded relative to Nodes(0)'s bounds
+	TArray<FkDOPCompactNode> CompactNodes;
+	// Nodes with four children, only built if KDOP_WIDE_NODES is set or by
+	// BuildWideNodes. Node 0 is the root
+	TArray<FkDOPWideNode> WideNodes;
 
 #ifdef KDOP_COLL_DEBUG
 	INT Level;
 	FkDOPTree() : Level(0) {}
 #endif
 
-	// Build the root node for the tree and have it recursively subdivide
-	void Build(TArray<FStaticMeshVertex>& Vertices,TArray<FkDOPBuildCollisionTriangle>& BuildTriangles);
+	// Build the root node for the tree and have it recursively subdivide,
+	// splitting at the lowest surface area heuristic cost or at the mean of
+	// the plane with the most variance
+	void Build(TArray<FStaticMeshVertex>& Vertices,TArray<FkDOPBuildCollisionTriangle>& BuildTriangles,UBOOL bSurfaceAreaHeuristic = 1);
+	// Rebuilds CompactNodes from Nodes
+	void BuildCompactNodes(void);
+	// Rebuilds WideNodes from Nodes
+	void BuildWideNodes(void);
 	// Performs a line check against the tree
 	UBOOL LineCheck(FkDOPLineCollisionCheck& Check);
 	// Performs a swept box check against the tree
@@ -240,10 +317,32 @@ struct FkDOPTree
 	// Query a sphere against the tree and return any 
 	void SphereQuery(FkDOPSphereQuery& Query);
 
+	// The same queries against the full precision nodes
+	UBOOL LineCheckNodes(FkDOPLineCollisionCheck& Check);
+	UBOOL BoxCheckNodes(FkDOPBoxCollisionCheck& Check);
+	UBOOL PointCheckNodes(FkDOPPointCollisionCheck& Check);
+	// Line check against the wide nodes, which have to be built
+	UBOOL LineCheckWide(FkDOPLineCollisionCheck& Check);
+
+	// Recursive traversal of the compact and wide nodes
+	UBOOL LineCheckCompact(FkDOPLineCollisionCheck& Check,INT NodeIndex,const FkDOP& Bounds);
+	UBOOL BoxCheckCompact(FkDOPBoxCollisionCheck& Check,INT NodeIndex,const FkDOP& Bounds);
+	UBOOL PointCheckCompact(FkDOPPointCollisionCheck& Check,INT NodeIndex,const FkDOP& Bounds);
+	void SphereQueryCompact(FkDOPSphereQuery& Query,INT NodeIndex,const FkDOP& Bounds);
+	UBOOL LineCheckWide(FkDOPLineCollisionCheck& Check,INT NodeIndex);
+
 	// Serialization
 	friend FArchive& operator<<(FArchive& Ar,FkDOPTree& Tree)
 	{
-		return Ar << Tree.Nodes << Tree.Triangles;
+		Ar << Tree.Nodes << Tree.Triangles;
+		if (Ar.IsLoading())
+		{
+			Tree.BuildCompactNodes();
+#if KDOP_WIDE_NODES
+			Tree.BuildWideNodes();
+#endif
+		}
+		return Ar;
 	}
 };
 
@@ -290,6 +389,8 @@ public:
 	const TArray<FkDOPCollisionTriangle>& CollisionTriangles;
 	// The rendering triangle data for the mesh
 	const TArray<FStaticMeshVertex>& Triangles;
+	// Number of nodes whose children or triangles were tested
+	INT NodesVisited;
 
 	// Basic constructor
 	FkDOPLineCollisionCheck(FCheckResult* InResult,UStaticMeshComponent* InComponent,const FVector& InStart,const FVector& InEnd);
@@ -12,6 +12,7 @@
 #include "EnginePhysicsClasses.h"
 #include "EngineSequenceClasses.h"
 #include "UnStatChart.h"
+#include "UnMoveCache.h"
 
 /*-----------------------------------------------------------------------------
 	AActor object implementations.
@@ -1073,6 +1074,11 @@ void AActor::SetCollision
 	}
 
 	// Set properties.
+	if( GetLevel()->MoveCache )
+	{
+		GetLevel()->MoveCache->InvalidateBatch();
+		GetLevel()->MoveCache->InvalidateOverlaps();
+	}
 	ClearComponents();
 	bCollideActors = NewCollideActors;
 	bBlockActors   = NewBlockActors;
@@ -1482,6 +1488,10 @@ void AActor::SetBase( AActor* NewBase, FVector NewFloor, int bNotifyActor, USkel
 			Base->eventDetach( this );
 		}
 
+		// Overlaps between actors joined together aren't tested, so cached ones may change.
+		if( GetLevel()->MoveCache )
+			GetLevel()->MoveCache->InvalidateOverlaps();
+
 		// Set base.
 		Base = NewBase;
 		BaseSkelComponent = NULL;
@@ -498,8 +498,8 @@ void UAnimNodeBlendBase::GetBoneAtoms( TArray<FBoneAtom>& Atoms )
 	check(LastChildIndex != INDEX_NONE);
 
 
-	// We don't allocate this array until we need it.
-	TArray<FBoneAtom> ChildAtoms;
+	// We don't fill this array until we need it. Its storage comes from the frame arena so reserving it up front is free.
+	TFrameArray<FBoneAtom> ChildAtoms( NumAtoms );
 	UBOOL bNoChildrenYet = true;
 
 	// Iterate over each child getting its atoms, scaling them and adding them to output (Atoms array)
@@ -980,7 +980,7 @@ void UAnimNodeBlendPerBone::GetBoneAtoms(TArray<FBoneAtom>& Atoms)
 	INT NumAtoms = SkelComponent->SkeletalMesh->RefSkeleton.Num();
 	check( NumAtoms == Atoms.Num() );
 
-	TArray<FBoneAtom> Child1Atoms, Child2Atoms;
+	TFrameArray<FBoneAtom> Child1Atoms( NumAtoms ), Child2Atoms( NumAtoms );
 
 	// Get bone atoms from each child (if no child - use ref pose).
 	Child1Atoms.Add(NumAtoms);
@@ -9,6 +9,12 @@
 #include "EnginePrivate.h"
 #include "UnLinker.h"
 
+#if __LINUX__
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#endif
+
 /**
  * FStreamTextureInstance serialize operator.
  *
@@ -33,6 +39,15 @@ FArchive& operator<<( FArchive& Ar, FStreamableTextureInfo& TextureInfo )
 	return Ar << TextureInfo.Texture << TextureInfo.TextureInstances;
 }
 
+/**
+ * Default constructor.
+ */
+FStreamingManager::FStreamingManager()
+:	LastIOStatsTime( appSeconds() )
+{
+	appMemzero( &LastIOStats, sizeof(LastIOStats) );
+}
+
 /**
  * Adds a streamer to the list of content streamers to route requests to.	
  *
@@ -74,6 +89,20 @@ UBOOL FStreamingManager::IsResourceConsidered( FResource* Resource )
 	return IsConsidered;
 }
 
+/**
+ * Lets all content streamers forget the state kept across frames for a resource
+ * that is about to be freed.
+ *
+ * @param	Resource	resource being freed
+ */
+void FStreamingManager::RemoveResource( FResource* Resource )
+{
+	for( INT i=0; i<ContentStreamers.Num(); i++ )
+	{
+		ContentStreamers(i)->RemoveResource( Resource );
+	}
+}
+
 /**
  * Take the current player/ context combination into account for streaming.
  *
@@ -105,6 +134,28 @@ void FStreamingManager::Tick()
 			ContentStreamers(i)->Tick();
 		}
 	}
+
+	// Derive per frame IO stats from the running totals of the async IO manager.
+	if( GAsyncIOManager )
+	{
+		FAsyncIOStats	IOStats;
+		DOUBLE			CurrentTime	= appSeconds();
+		DOUBLE			DeltaTime	= CurrentTime - LastIOStatsTime;
+		GAsyncIOManager->GetStats( IOStats );
+
+		GStreamingStats.AsyncIORequests.Value	= IOStats.Requests - LastIOStats.Requests;
+		GStreamingStats.AsyncIOReads.Value		= IOStats.Reads - LastIOStats.Reads;
+		GStreamingStats.AsyncIOSeeks.Value		= IOStats.Seeks - LastIOStats.Seeks;
+		GStreamingStats.AsyncIOOvertakes.Value	= IOStats.Overtakes - LastIOStats.Overtakes;
+		GStreamingStats.AsyncIOQueueDepth.Value	= IOStats.QueueDepth;
+		if( DeltaTime > 0 )
+		{
+			GStreamingStats.AsyncIOThroughput.Value = (FLOAT) ((IOStats.BytesRead - LastIOStats.BytesRead) / DeltaTime / 1024.0 / 1024.0);
+		}
+
+		LastIOStats		= IOStats;
+		LastIOStatsTime	= CurrentTime;
+	}
 }
 
 /**
@@ -123,6 +174,85 @@ void FStreamingManager::Flush( UBOOL OnlyOutstanding )
 	}
 }
 
+/**
+ * Calculates the amount of memory used by the smallest miplevels of a texture.
+ *
+ * @param	Texture		Texture to calculate size for
+ * @param	NumMips		Number of miplevels, counting from the smallest one
+ * @return	size of miplevels in bytes
+ */
+static DWORD CalcTextureMipSize( FTextureBase* Texture, UINT NumMips )
+{
+	const FPixelFormatInfo& FormatInfo	= GPixelFormats[Texture->Format];
+	DWORD					Size		= 0;
+	for( UINT MipIndex=Texture->NumMips - Min(NumMips,Texture->NumMips); MipIndex<Texture->NumMips; MipIndex++ )
+	{
+		UINT MipSizeX	= Max<UINT>( Texture->SizeX >> MipIndex, FormatInfo.BlockSizeX );
+		UINT MipSizeY	= Max<UINT>( Texture->SizeY >> MipIndex, FormatInfo.BlockSizeY );
+		Size			+= (MipSizeX / FormatInfo.BlockSizeX) * (MipSizeY / FormatInfo.BlockSizeY) * FormatInfo.BlockBytes;
+	}
+	return Size;
+}
+
+/**
+ * Texture that wants more miplevels than it currently has, considered by FStaticTextureStreamer::Tick.
+ */
+struct FTextureStreamingCandidate
+{
+	/** Texture wanting more miplevels */
+	FTextureBase*	Texture;
+	/** Number of miplevels wanted */
+	UINT			RequestedMips;
+	/** Number of miplevels granted */
+	UINT			GrantedMips;
+	/** Priority of request, taking the time it has been waiting into account */
+	FLOAT			Priority;
+	/** Priority of the IO requests, derived from the rank of the candidate */
+	EAsyncIOPriority IOPriority;
+	/** Linker the miplevels are loaded from, used to sort loads by file */
+	ULinker*		Linker;
+	/** Offset of first miplevel to be loaded, used to sort loads by file offset */
+	DWORD			Offset;
+};
+
+/** Sorts candidates by descending priority. */
+IMPLEMENT_COMPARE_CONSTREF( FTextureStreamingCandidate, UnContentStreamingPriority, { return B.Priority > A.Priority ? 1 : B.Priority < A.Priority ? -1 : 0; } );
+/** Sorts candidates by file and by offset within file. */
+IMPLEMENT_COMPARE_CONSTREF( FTextureStreamingCandidate, UnContentStreamingOffset, { return A.Linker != B.Linker ? (A.Linker < B.Linker ? -1 : 1) : (A.Offset < B.Offset ? -1 : A.Offset > B.Offset ? 1 : 0); } );
+
+/**
+ * Resident texture that could have miplevels evicted to make room for a more important one.
+ */
+struct FTextureEvictionCandidate
+{
+	/** Resident texture */
+	FTextureBase*	Texture;
+	/** Priority of texture the last time it was processed */
+	FLOAT			Priority;
+};
+
+/** Sorts eviction candidates by ascending priority. */
+IMPLEMENT_COMPARE_CONSTREF( FTextureEvictionCandidate, UnContentStreaming, { return A.Priority > B.Priority ? 1 : A.Priority < B.Priority ? -1 : 0; } );
+
+/**
+ * Default constructor, reading the pool settings from the [TextureStreaming] section of the engine ini.
+ */
+FStaticTextureStreamer::FStaticTextureStreamer()
+:	CurrentIndexOffset(0),
+	InitialProcessViewerCall(1),
+	PoolSize(0),
+	PriorityAgeFactor(0.f),
+	HighPriorityRequests(0),
+	HighPriorityDeadline(0.f)
+{
+	INT PoolSizeInMByte = 0;
+	GConfig->GetInt( TEXT("TextureStreaming"), TEXT("PoolSize"), PoolSizeInMByte, GEngineIni );
+	GConfig->GetFloat( TEXT("TextureStreaming"), TEXT("PriorityAgeFactor"), PriorityAgeFactor, GEngineIni );
+	GConfig->GetInt( TEXT("TextureStreaming"), TEXT("HighPriorityRequests"), HighPriorityRequests, GEngineIni );
+	GConfig->GetFloat( TEXT("TextureStreaming"), TEXT("HighPriorityDeadline"), HighPriorityDeadline, GEngineIni );
+	PoolSize = Max( PoolSizeInMByte, 0 ) * 1024 * 1024;
+}
+
 /**
  * Returns whether this content streamer currently considers a passed in resource
  * for streaming.
@@ -134,7 +264,7 @@ UBOOL FStaticTextureStreamer::IsResourceConsidered( FResource* Resource )
 {
 	FTextureBase* Texture = CastResource<FTextureBase>(Resource);
 
-	if( Texture && PendingRequests.Find( Texture ) )
+	if( Texture && (PendingRequests.Find( Texture ) || StreamingTextures.Find( Texture )) )
 	{
 		return TRUE;
 	}
@@ -144,6 +274,22 @@ UBOOL FStaticTextureStreamer::IsResourceConsidered( FResource* Resource )
 	}
 }
 
+/**
+ * Forgets the streaming state of a texture that is about to be freed, so Tick doesn't
+ * consider it for eviction anymore.
+ *
+ * @param	Resource	resource being freed
+ */
+void FStaticTextureStreamer::RemoveResource( FResource* Resource )
+{
+	FTextureBase* Texture = CastResource<FTextureBase>(Resource);
+
+	if( Texture )
+	{
+		StreamingTextures.Remove( Texture );
+	}
+}
+
 /**
  * Take the current player/ context combination into account for streaming.
  *
@@ -184,6 +330,8 @@ void FStaticTextureStreamer::ProcessViewer( ULocalPlayer* Player, FSceneContext*
 				// Default to loading all miplevels.
 				UINT	WantedMipCount			= Texture->NumMips;
 				FLOAT	Distance				= FDist( ViewLocation, TextureInstance.BoundingSphere );
+				// Being inside the bounding sphere is as important as it gets.
+				FLOAT	Priority				= MaxTextureSize;
 
 				// Calculated miplevel based on screen space size of bounding sphere unless we're actually inside the bounding sphere.			
 				if( Distance > ( TextureInstance.BoundingSphere.W + 1.f) )
@@ -195,20 +343,25 @@ void FStaticTextureStreamer::ProcessViewer( ULocalPlayer* Player, FSceneContext*
 
 					// WantedMipCount is the number of mips so we need to adjust with "+ 1".
 					WantedMipCount				= 1 + appCeilLogTwo( Min<UINT>( ScreenDimension, MaxTextureSize ) );
+					Priority					= Min<FLOAT>( ScreenDimension, MaxTextureSize );
 				}
 
 				// We can't pull the Min into the Clamp as Texture->NumMips could be less than MinStreamedInMips!
 				WantedMipCount = Min( Texture->NumMips, Clamp( WantedMipCount, GEngine->MinStreamedInMips, GEngine->MaxStreamedInMips ) );
 
-				UINT* CurrentMipRequest = PendingRequests.Find( Texture );
+				FPendingMipRequest* CurrentMipRequest = PendingRequests.Find( Texture );
 				if( CurrentMipRequest )
 				{
 					// Only request mip increases as Tick automatically resets the WantedMipCont to MinStreamedInMips each frame by removing the texture from the map.
-					*CurrentMipRequest = Max( *CurrentMipRequest, WantedMipCount );
+					CurrentMipRequest->RequestedMips	= Max( CurrentMipRequest->RequestedMips, WantedMipCount );
+					CurrentMipRequest->Priority			= Max( CurrentMipRequest->Priority, Priority );
 				}
 				else
 				{
-					PendingRequests.Set( Texture, WantedMipCount );
+					FPendingMipRequest MipRequest;
+					MipRequest.RequestedMips	= WantedMipCount;
+					MipRequest.Priority			= Priority;
+					PendingRequests.Set( Texture, MipRequest );
 				}
 			}
 		}
@@ -237,22 +390,70 @@ void FStaticTextureStreamer::Flush( UBOOL OnlyOutstanding )
 		// Also clean up pending requests, aka all textures being considered. Not needed when e.g. flushing D3D device
 		// like it occurs on resolution change or initial creation.
 		PendingRequests.Empty();
+		StreamingTextures.Empty();
 		InitialProcessViewerCall = 1;
 	}
 	OutstandingRequests.Empty();
 }
 
+/**
+ * Requests a change in miplevels and passes the request on to the resource loader if data needs to be loaded.
+ *
+ * @param	Texture			Texture to change the number of miplevels of
+ * @param	RequestedMips	Number of miplevels the texture should have
+ * @param	IOPriority		Priority of the IO requests if data needs to be loaded
+ * @param	IODeadline		appSeconds by which the data should be loaded, 0 if none
+ */
+void FStaticTextureStreamer::RequestMips( FTextureBase* Texture, UINT RequestedMips, EAsyncIOPriority IOPriority, DOUBLE IODeadline )
+{
+	check( (RequestedMips >= GEngine->MinStreamedInMips) || (Texture->NumMips < GEngine->MinStreamedInMips) );
+	check( RequestedMips <= Texture->NumMips );
+
+	// Request a change in miplevels. A return value of NULL indicates that the request is already fulfilled
+	// as no data needed to be loaded.
+	FTextureMipRequest* TextureMipRequest = GResourceManager->RequestMips( Texture, RequestedMips );	
+
+	if( TextureMipRequest )
+	{
+		TextureMipRequest->IOPriority	= IOPriority;
+		TextureMipRequest->IODeadline	= IODeadline;
+
+		// Request is still outstanding so we need to pass it to the resource loader.
+		if( !GResourceLoader->LoadTextureMips( TextureMipRequest ) )
+		{
+			appErrorf(TEXT("Failed loading mips for texture %s"), *Texture->DescribeResource() );
+		}
+		OutstandingRequests.Set( Texture, TextureMipRequest );
+	}
+}
+
 /**
  * Tick function, called before Viewport->Draw.
  */
 void FStaticTextureStreamer::Tick()
 {
+	const DOUBLE CurrentTime = appSeconds();
+
 	BEGINCYCLECOUNTER(GStreamingStats.DataShuffleTime);
+	// Textures wanting more miplevels, handed out below in order of priority.
+	TFrameArray<FTextureStreamingCandidate> Candidates( PendingRequests.Num() );
+
 	// Iterate over all considered texture requests.
-	for( TDynamicMap<FTextureBase*,UINT>::TIterator It(PendingRequests); It; ++It )
+	for( TDynamicMap<FTextureBase*,FPendingMipRequest>::TIterator It(PendingRequests); It; ++It )
 	{	
 		FTextureBase*	Texture				= It.Key();
-		UINT&			RequestedMips		= It.Value();
+		UINT			RequestedMips		= It.Value().RequestedMips;
+		FLOAT			Priority			= It.Value().Priority;
+
+		FStreamingTextureState* State = StreamingTextures.Find( Texture );
+		if( !State )
+		{
+			FStreamingTextureState NewState;
+			NewState.Priority		= Priority;
+			NewState.WaitingSince	= 0;
+			State = &StreamingTextures.Set( Texture, NewState );
+		}
+		State->Priority = Priority;
 	
 		// Find out whether we have a pending outstanding mip request for this texture...
 		FTextureMipRequest* OutstandingMipRequest = OutstandingRequests.FindRef( Texture );
@@ -285,24 +486,30 @@ void FStaticTextureStreamer::Tick()
 			}
 		}
 
-		if( RequestedMips != Texture->CurrentMips )
+		if( RequestedMips < Texture->CurrentMips || !PoolSize )
 		{
-			check( (RequestedMips >= GEngine->MinStreamedInMips) || (Texture->NumMips < GEngine->MinStreamedInMips) );
-			check( RequestedMips <= Texture->NumMips );
-
-			// Request a change in miplevels. A return value of NULL indicates that the request is already fulfilled
-			// as no data needed to be loaded.
-			FTextureMipRequest* TextureMipRequest = GResourceManager->RequestMips( Texture, RequestedMips );	
-
-			if( TextureMipRequest )
+			// Dropping miplevels frees up pool memory so it is done right away, as is everything if there is no budget.
+			if( RequestedMips != Texture->CurrentMips )
 			{
-				// Request is still outstanding so we need to pass it to the resource loader.
-				if( !GResourceLoader->LoadTextureMips( TextureMipRequest ) )
-				{
-					appErrorf(TEXT("Failed loading mips for texture %s"), *Texture->DescribeResource() );
-				}
-				OutstandingRequests.Set( Texture, TextureMipRequest );
+				RequestMips( Texture, RequestedMips );
 			}
+			State->WaitingSince = 0;
+		}
+		else if( RequestedMips > Texture->CurrentMips )
+		{
+			// Requests that have been waiting for memory for a while become more important so they don't starve.
+			FTextureStreamingCandidate& Candidate = Candidates( Candidates.Add() );
+			Candidate.Texture		= Texture;
+			Candidate.RequestedMips	= RequestedMips;
+			Candidate.GrantedMips	= 0;
+			Candidate.IOPriority	= AIOP_Normal;
+			Candidate.Priority		= Priority * (1.f + PriorityAgeFactor * (State->WaitingSince ? (FLOAT)(CurrentTime - State->WaitingSince) : 0.f));
+			Candidate.Linker		= NULL;
+			Candidate.Offset		= 0;
+		}
+		else
+		{
+			State->WaitingSince = 0;
 		}
 	
 		// Remove the texture from the map so it correctly sets a new minimum the next time it gets processed.
@@ -310,6 +517,117 @@ void FStaticTextureStreamer::Tick()
 
 		GStreamingStats.StreamedInTextures.Value++;
 	}
+
+	if( Candidates.Num() )
+	{
+		// Figure out how much of the pool is used, counting outstanding requests as already fulfilled.
+		DWORD PoolUsage = 0;
+		TFrameArray<FTextureEvictionCandidate> EvictionCandidates( StreamingTextures.Num() );
+		for( TDynamicMap<FTextureBase*,FStreamingTextureState>::TIterator It(StreamingTextures); It; ++It )
+		{
+			FTextureBase*		Texture					= It.Key();
+			FTextureMipRequest*	OutstandingMipRequest	= OutstandingRequests.FindRef( Texture );
+			PoolUsage += CalcTextureMipSize( Texture, OutstandingMipRequest ? Max( Texture->CurrentMips, OutstandingMipRequest->RequestedMips ) : Texture->CurrentMips );
+
+			// Textures with requests in flight are left alone.
+			if( !OutstandingMipRequest && Texture->CurrentMips > GEngine->MinStreamedInMips )
+			{
+				FTextureEvictionCandidate& EvictionCandidate = EvictionCandidates( EvictionCandidates.Add() );
+				EvictionCandidate.Texture	= Texture;
+				EvictionCandidate.Priority	= It.Value().Priority;
+			}
+		}
+		Sort<USE_COMPARE_CONSTREF(FTextureStreamingCandidate,UnContentStreamingPriority)>( &Candidates(0), Candidates.Num() );
+		if( EvictionCandidates.Num() )
+		{
+			Sort<USE_COMPARE_CONSTREF(FTextureEvictionCandidate,UnContentStreaming)>( &EvictionCandidates(0), EvictionCandidates.Num() );
+		}
+
+		// Hand out miplevels in order of priority, evicting less important textures if needed.
+		INT EvictionIndex = 0;
+		for( INT CandidateIndex=0; CandidateIndex<Candidates.Num(); CandidateIndex++ )
+		{
+			FTextureStreamingCandidate& Candidate	= Candidates(CandidateIndex);
+			FTextureBase*				Texture		= Candidate.Texture;
+			DWORD						CurrentSize	= CalcTextureMipSize( Texture, Texture->CurrentMips );
+
+			// The texture might have been evicted itself by a more important one in the meantime.
+			Candidate.GrantedMips = Texture->CurrentMips;
+
+			while( PoolUsage + CalcTextureMipSize( Texture, Candidate.RequestedMips ) - CurrentSize > PoolSize 
+				&&	EvictionIndex < EvictionCandidates.Num() 
+				&&	EvictionCandidates(EvictionIndex).Priority < Candidate.Priority )
+			{
+				FTextureBase*	Victim		= EvictionCandidates(EvictionIndex++).Texture;
+				UINT			VictimMips	= Min( Victim->NumMips, GEngine->MinStreamedInMips );
+				if( Victim != Texture && Victim->CurrentMips > VictimMips )
+				{
+					PoolUsage -= CalcTextureMipSize( Victim, Victim->CurrentMips ) - CalcTextureMipSize( Victim, VictimMips );
+					RequestMips( Victim, VictimMips );
+					GStreamingStats.EvictedTextures.Value++;
+				}
+			}
+
+			// The minimum number of miplevels is always granted, the budget only applies to the ones above it.
+			UINT MinMips = Min( Texture->NumMips, GEngine->MinStreamedInMips );
+			for( UINT Mips=Candidate.RequestedMips; Mips>Texture->CurrentMips; Mips-- )
+			{
+				if( Mips <= MinMips || PoolUsage + CalcTextureMipSize( Texture, Mips ) - CurrentSize <= PoolSize )
+				{
+					Candidate.GrantedMips = Mips;
+					break;
+				}
+			}
+
+			FStreamingTextureState* State = StreamingTextures.Find( Texture );
+			if( Candidate.GrantedMips < Candidate.RequestedMips )
+			{
+				if( !State->WaitingSince )
+				{
+					State->WaitingSince = CurrentTime;
+				}
+				GStreamingStats.DeferredTextureRequests.Value++;
+			}
+			else
+			{
+				State->WaitingSince = 0;
+			}
+
+			if( Candidate.GrantedMips > Texture->CurrentMips )
+			{
+				PoolUsage += CalcTextureMipSize( Texture, Candidate.GrantedMips ) - CurrentSize;
+
+				// The most important textures are loaded ahead of the IO already queued for the others.
+				if( CandidateIndex < HighPriorityRequests )
+				{
+					Candidate.IOPriority = AIOP_High;
+				}
+
+				// Find out where the largest miplevel to be loaded lives so loads can be issued in file order.
+				UTexture2D* Texture2D = Cast<UTexture2D>(Texture->GetUTexture());
+				UINT		MipIndex  = Texture->NumMips - Candidate.GrantedMips;
+				if( Texture2D && Texture2D->GetLinker() && MipIndex < (UINT)Texture2D->Mips.Num() )
+				{
+					Candidate.Linker = Texture2D->GetLinker();
+					Candidate.Offset = Texture2D->Mips(MipIndex).Data.GetOffset();
+				}
+			}
+		}
+
+		// Issue loads sorted by file and offset so the IO manager sees them in an order that minimizes seeking.
+		Sort<USE_COMPARE_CONSTREF(FTextureStreamingCandidate,UnContentStreamingOffset)>( &Candidates(0), Candidates.Num() );
+		for( INT CandidateIndex=0; CandidateIndex<Candidates.Num(); CandidateIndex++ )
+		{
+			FTextureStreamingCandidate& Candidate = Candidates(CandidateIndex);
+			if( Candidate.GrantedMips > Candidate.Texture->CurrentMips )
+			{
+				RequestMips( Candidate.Texture, Candidate.GrantedMips, Candidate.IOPriority, Candidate.IOPriority == AIOP_High ? CurrentTime + HighPriorityDeadline : 0 );
+			}
+		}
+
+		GStreamingStats.PoolUsage.Value = PoolUsage / 1024.f / 1024.f;
+	}
+	GStreamingStats.PoolSize.Value = PoolSize / 1024.f / 1024.f;
 	ENDCYCLECOUNTER;
 
 	BEGINCYCLECOUNTER(GStreamingStats.FinalizeTime);
@@ -386,6 +704,14 @@ UBOOL FBackgroundLoaderUnreal::LoadTextureMips( FTextureMipRequest* TextureMipRe
 
 	if( Texture2D )
 	{
+		// Offsets of chunk compressed packages refer to the uncompressed data, so the mips
+		// have to be decompressed by the linker rather than read from the file.
+		ULinkerLoad* Linker = Texture2D->GetLinker();
+		if( Linker->bStoredCompressed )
+		{
+			return BlockingLoader.LoadTextureMips( TextureMipRequest );
+		}
+
 		for( UINT MipIndex=0; MipIndex<ARRAY_COUNT(TextureMipRequest->Mips); MipIndex++ )
 		{
 			if( TextureMipRequest->Mips[MipIndex].Data )
@@ -398,11 +724,13 @@ UBOOL FBackgroundLoaderUnreal::LoadTextureMips( FTextureMipRequest* TextureMipRe
 				// Pass the request on to the async io manager after increasing the request count.
 				TextureMipRequest->OutstandingMipRequests.Increment();
 				TextureMipRequest->Mips[MipIndex].IORequestIndex = GAsyncIOManager->LoadData( 
-																		Texture2D->GetLinker()->Filename, 
-																		Texture2D->Mips(MipIndex).Data.GetOffset(),
+																		Linker->Filename, 
+																		Linker->GetFileOffset( Texture2D->Mips(MipIndex).Data ),
 																		TextureMipRequest->Mips[MipIndex].Size,
 																		TextureMipRequest->Mips[MipIndex].Data,
-																		&TextureMipRequest->OutstandingMipRequests
+																		&TextureMipRequest->OutstandingMipRequests,
+																		(EAsyncIOPriority) TextureMipRequest->IOPriority,
+																		TextureMipRequest->IODeadline
 																		);
 			}
 		}
@@ -481,6 +809,206 @@ void FResourceLoader::RemoveLoader( FBackgroundLoader* BackgroundLoader )
 	BackgroundLoaders.RemoveItem( BackgroundLoader );
 }
 
+/*-----------------------------------------------------------------------------
+	FAsyncIORequestQueue implementation.
+-----------------------------------------------------------------------------*/
+
+/** Constructor, initializing the elevator position and stats. */
+FAsyncIORequestQueue::FAsyncIORequestQueue()
+:	LastFileIndex( INDEX_NONE ),
+	LastOffset( 0 )
+{
+	appMemzero( &Stats, sizeof(Stats) );
+}
+
+/**
+ * Adds a request to the queue.
+ *
+ * @param	Request		Request to add
+ */
+void FAsyncIORequestQueue::Add( const FRequest& Request )
+{
+	Requests.AddItem( Request );
+}
+
+/**
+ * Removes N requests from the queue in an atomic all or nothing operation.
+ *
+ * @param	RequestIndices	Indices of requests to remove
+ * @param	NumIndices		Number of indices
+ * @return	TRUE if all requests were in the queue and got removed, FALSE otherwise
+ */
+UBOOL FAsyncIORequestQueue::Cancel( QWORD* RequestIndices, UINT NumIndices )
+{
+	UINT	NumFound			= 0;
+	UINT*	OutstandingIndices	= (UINT*) appAlloca( sizeof(UINT) * NumIndices );
+
+	for( UINT OutstandingIndex=0; OutstandingIndex<(UINT)Requests.Num() && NumFound<NumIndices; OutstandingIndex++ )
+	{
+		for( UINT RequestIndex=0; RequestIndex<NumIndices; RequestIndex++ )
+		{
+			if( Requests(OutstandingIndex).RequestIndex == RequestIndices[RequestIndex] )
+			{
+				OutstandingIndices[NumFound] = OutstandingIndex;
+				NumFound++;
+			}
+		}
+	}
+
+	if( NumFound == NumIndices )
+	{
+		for( UINT RequestIndex=0; RequestIndex<NumFound; RequestIndex++ )
+		{
+			Requests.Remove( OutstandingIndices[RequestIndex] - RequestIndex );
+		}
+
+		return TRUE;
+	}
+	else
+	{
+		return FALSE;
+	}
+}
+
+/** Removes all requests from the queue. */
+void FAsyncIORequestQueue::Empty()
+{
+	Requests.Empty();
+}
+
+/**
+ * Returns whether request A comes before the passed in file position in elevator order.
+ */
+static FORCEINLINE UBOOL IsRequestBefore( const FAsyncIORequestQueue::FRequest& A, INT FileIndex, UINT Offset )
+{
+	return A.FileIndex < FileIndex || (A.FileIndex == FileIndex && A.Offset < Offset);
+}
+
+/**
+ * Removes the next batch of requests from the queue. All requests of a batch are for the same
+ * file and are sorted by offset.
+ *
+ * @param	Batch	[out] Requests to service
+ * @param	OutEnd	[out] Offset following the last byte to read, requests of a batch may overlap
+ * @return	Offset of the first byte to read; the batch is empty if there are no requests
+ */
+UINT FAsyncIORequestQueue::GetNextBatch( TArray<FRequest>& Batch, UINT& OutEnd )
+{
+	Batch.Empty();
+	OutEnd = 0;
+	if( !Requests.Num() )
+	{
+		return 0;
+	}
+
+	// Overdue requests go first, earliest deadline first.
+	DOUBLE	CurrentTime	= appSeconds();
+	INT		First		= INDEX_NONE;
+	BYTE	MaxPriority	= 0;
+	for( INT RequestIndex=0; RequestIndex<Requests.Num(); RequestIndex++ )
+	{
+		const FRequest& Request = Requests(RequestIndex);
+		if( Request.Deadline && Request.Deadline <= CurrentTime && (First == INDEX_NONE || Request.Deadline < Requests(First).Deadline) )
+		{
+			First = RequestIndex;
+		}
+		MaxPriority = Max( MaxPriority, Request.Priority );
+	}
+
+	// Otherwise sweep across the disk in one direction, only considering the highest priority requests.
+	if( First == INDEX_NONE )
+	{
+		INT Lowest	= INDEX_NONE;
+		INT Ahead	= INDEX_NONE;
+		for( INT RequestIndex=0; RequestIndex<Requests.Num(); RequestIndex++ )
+		{
+			const FRequest& Request = Requests(RequestIndex);
+			if( Request.Priority == MaxPriority )
+			{
+				if( Lowest == INDEX_NONE || IsRequestBefore( Request, Requests(Lowest).FileIndex, Requests(Lowest).Offset ) )
+				{
+					Lowest = RequestIndex;
+				}
+				if( !IsRequestBefore( Request, LastFileIndex, LastOffset ) && (Ahead == INDEX_NONE || IsRequestBefore( Request, Requests(Ahead).FileIndex, Requests(Ahead).Offset )) )
+				{
+					Ahead = RequestIndex;
+				}
+			}
+		}
+		First = Ahead != INDEX_NONE ? Ahead : Lowest;
+	}
+
+	// Count reads started for a request that got queued after a lower priority one.
+	for( INT RequestIndex=0; RequestIndex<First; RequestIndex++ )
+	{
+		if( Requests(RequestIndex).Priority < Requests(First).Priority )
+		{
+			Stats.Overtakes++;
+			break;
+		}
+	}
+
+	FRequest	FirstRequest	= Requests(First);
+	UINT		Start			= FirstRequest.Offset;
+	UINT		End				= FirstRequest.Offset + FirstRequest.Size;
+	Batch.AddItem( FirstRequest );
+	Requests.Remove( First );
+
+	// Merge all requests for data following the first one, regardless of priority, as long as the read doesn't get too large.
+	if( FirstRequest.Size <= ASYNC_IO_MAX_READ_SIZE )
+	{
+		for( ;; )
+		{
+			INT Next = INDEX_NONE;
+			for( INT RequestIndex=0; RequestIndex<Requests.Num(); RequestIndex++ )
+			{
+				const FRequest& Request = Requests(RequestIndex);
+				if( Request.FileIndex == FirstRequest.FileIndex
+				&&	Request.Offset >= Start
+				&&	Request.Offset <= End + ASYNC_IO_MAX_GAP_SIZE
+				&&	Request.Offset + Request.Size - Start <= ASYNC_IO_MAX_READ_SIZE
+				&&	(Next == INDEX_NONE || Request.Offset < Requests(Next).Offset) )
+				{
+					Next = RequestIndex;
+				}
+			}
+			if( Next == INDEX_NONE )
+			{
+				break;
+			}
+			End = Max( End, Requests(Next).Offset + Requests(Next).Size );
+			Batch.AddItem( Requests(Next) );
+			Requests.Remove( Next );
+		}
+	}
+
+	Stats.Requests	+= Batch.Num();
+	Stats.Reads		++;
+	Stats.Seeks		+= (FirstRequest.FileIndex != LastFileIndex || Start != LastOffset) ? 1 : 0;
+	Stats.BytesRead	+= End - Start;
+
+	LastFileIndex	= FirstRequest.FileIndex;
+	LastOffset		= End;
+	OutEnd			= End;
+	return Start;
+}
+
+/**
+ * Fills in the running totals.
+ *
+ * @param	OutStats	[out] Stats to fill in
+ */
+void FAsyncIORequestQueue::GetStats( FAsyncIOStats& OutStats ) const
+{
+	OutStats			= Stats;
+	OutStats.QueueDepth	= Requests.Num();
+}
+
+/*-----------------------------------------------------------------------------
+	FAsyncIOManagerWindows implementation.
+-----------------------------------------------------------------------------*/
+
+#if !__LINUX__
 /**
  * Initializes critical section, event and other used variables. 
  *
@@ -503,11 +1031,12 @@ UBOOL FAsyncIOManagerWindows::Init()
  */
 void FAsyncIOManagerWindows::Exit()
 {
-	for( TMap<FString,HANDLE>::TIterator It(NameToHandleMap); It; ++It )
+	for( INT FileIndex=0; FileIndex<FileHandles.Num(); FileIndex++ )
 	{
-		CloseHandle( It.Value() );
+		CloseHandle( FileHandles(FileIndex) );
 	}
-	NameToHandleMap.Empty();
+	FileHandles.Empty();
+	NameToFileIndexMap.Empty();
 	GSynchronizeFactory->Destroy( CriticalSection );
 	GSynchronizeFactory->Destroy( OutstandingRequestsEvent );
 }
@@ -529,31 +1058,48 @@ void FAsyncIOManagerWindows::Stop()
  */
 DWORD FAsyncIOManagerWindows::Run()
 {
+	// Coalesced reads go through a staging buffer before being copied to their destinations.
+	BYTE*									StagingBuffer = (BYTE*) appMalloc( ASYNC_IO_MAX_READ_SIZE );
+	TArray<FAsyncIORequestQueue::FRequest>	Batch;
+
 	// IsRunning gets decremented by Stop.
 	while( IsRunning.GetValue() > 0 )
 	{
-		FAsyncIORequest IORequest = {0};
+		HANDLE	FileHandle	= NULL;
+		UINT	Start		= 0;
+		UINT	End			= 0;
 		{
 			FScopeLock ScopeLock( CriticalSection );
-			if( OutstandingRequests.Num() )
+			Start = OutstandingRequests.GetNextBatch( Batch, End );
+			if( Batch.Num() )
 			{
-				IORequest = OutstandingRequests(0);
-				OutstandingRequests.Remove( 0 );
+				FileHandle = FileHandles(Batch(0).FileIndex);
 				BusyReading.Increment();	// We're busy reading. Updated inside scoped lock to ensure CancelAllRequests works correctly.
 			}
-			else
-			{
-				IORequest.FileHandle = NULL;
-			}
 		}
 
-		if( IORequest.FileHandle )
+		if( Batch.Num() )
 		{
+			TRACE_SCOPE(TEXT("AsyncIO read"));
 			//@warning: this code doesn't handle failure as it doesn't have a way to pass back the information.
 			DWORD BytesRead;
-			SetFilePointer( IORequest.FileHandle, IORequest.Offset, 0, FILE_BEGIN );
-			ReadFile( IORequest.FileHandle, IORequest.Dest, IORequest.Size, &BytesRead, NULL );
-			IORequest.Counter->Decrement(); // Request fulfilled.
+			SetFilePointer( FileHandle, Start, 0, FILE_BEGIN );
+			if( Batch.Num() == 1 )
+			{
+				ReadFile( FileHandle, Batch(0).Dest, Batch(0).Size, &BytesRead, NULL );
+			}
+			else
+			{
+				ReadFile( FileHandle, StagingBuffer, End - Start, &BytesRead, NULL );
+				for( INT BatchIndex=0; BatchIndex<Batch.Num(); BatchIndex++ )
+				{
+					appMemcpy( Batch(BatchIndex).Dest, StagingBuffer + Batch(BatchIndex).Offset - Start, Batch(BatchIndex).Size );
+				}
+			}
+			for( INT BatchIndex=0; BatchIndex<Batch.Num(); BatchIndex++ )
+			{
+				Batch(BatchIndex).Counter->Decrement(); // Request fulfilled.
+			}
 			BusyReading.Decrement();		// We're done reading for now.
 		}
 		else
@@ -563,6 +1109,7 @@ DWORD FAsyncIOManagerWindows::Run()
 		}
 	}
 
+	appFree( StagingBuffer );
 	return 0;
 }
 
@@ -574,53 +1121,65 @@ DWORD FAsyncIOManagerWindows::Run()
  * @param	Size		Size of load request
  * @param	Dest		Pointer to load data into
  * @param	Counter		Thread safe counter to decrement when loading has finished
+ * @param	Priority	Priority of request, see EAsyncIOPriority
+ * @param	Deadline	appSeconds by which the request should be serviced, 0 if none. Overdue requests go first.
  *
  * @return Returns an index to the request that can be used for canceling or 0 if the request failed.
  */
-QWORD FAsyncIOManagerWindows::LoadData( FString Filename, UINT Offset, UINT Size, void* Dest, FThreadSafeCounter* Counter )
+QWORD FAsyncIOManagerWindows::LoadData( FString Filename, UINT Offset, UINT Size, void* Dest, FThreadSafeCounter* Counter, EAsyncIOPriority Priority, DOUBLE Deadline )
 {
-	HANDLE FileHandle = NameToHandleMap.FindRef( Filename );
+	FScopeLock ScopeLock( CriticalSection );
 
-	if( !FileHandle )
+	INT* ExistingFileIndex	= NameToFileIndexMap.Find( Filename );
+	INT	 FileIndex			= ExistingFileIndex ? *ExistingFileIndex : INDEX_NONE;
+	if( !ExistingFileIndex )
 	{
 #ifndef XBOX
-		FileHandle = TCHAR_CALL_OS(
+		HANDLE FileHandle = TCHAR_CALL_OS(
 						CreateFileW( *Filename,						GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL ) ,
 						CreateFileA( TCHAR_TO_ANSI(*Filename),		GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL ) );
 #else
 		FFilename CookedFilename = Filename;
 		CookedFilename = CookedFilename.GetPath() + TEXT("\\") + CookedFilename.GetBaseFilename() + TEXT(".xxx");
 
-		FileHandle =	CreateFileA( GetXenonFilename(*CookedFilename),	GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+		HANDLE FileHandle =	CreateFileA( GetXenonFilename(*CookedFilename),	GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
 #endif
+		if( FileHandle == INVALID_HANDLE_VALUE )
+		{
+			return 0;
+		}
+		FileIndex = FileHandles.AddItem( FileHandle );
+		NameToFileIndexMap.Set( *Filename, FileIndex );
 	}
 
-	if( FileHandle != INVALID_HANDLE_VALUE )
-	{
-		FScopeLock ScopeLock( CriticalSection );
+	FAsyncIORequestQueue::FRequest IORequest;
 
-		NameToHandleMap.Set( *Filename, FileHandle );
+	IORequest.RequestIndex	= RequestIndex++;
+	IORequest.FileIndex		= FileIndex;
+	IORequest.Offset		= Offset;
+	IORequest.Size			= Size;
+	IORequest.Dest			= Dest;
+	IORequest.Counter		= Counter;
+	IORequest.Priority		= Priority;
+	IORequest.Deadline		= Deadline;
 
-		FAsyncIORequest IORequest;
+	OutstandingRequests.Add( IORequest );
 
-		IORequest.RequestIndex	= RequestIndex++;
-		IORequest.FileHandle	= FileHandle;
-		IORequest.Offset		= Offset;
-		IORequest.Size			= Size;
-		IORequest.Dest			= Dest;
-		IORequest.Counter		= Counter;
-	
-		OutstandingRequests.AddItem( IORequest );
+	// Trigger event telling IO thread to wake up to perform work.
+	OutstandingRequestsEvent->Trigger();
 
-		// Trigger event telling IO thread to wake up to perform work.
-		OutstandingRequestsEvent->Trigger();
+	return IORequest.RequestIndex;
+}
 
-		return IORequest.RequestIndex;
-	}
-	else
-	{
-		return 0;
-	}
+/**
+ * Returns the running totals of IO activity.
+ *
+ * @param	Stats	[out] Stats to fill in
+ */
+void FAsyncIOManagerWindows::GetStats( FAsyncIOStats& Stats )
+{
+	FScopeLock ScopeLock( CriticalSection );
+	OutstandingRequests.GetStats( Stats );
 }
 
 /**
@@ -634,41 +1193,280 @@ QWORD FAsyncIOManagerWindows::LoadData( FString Filename, UINT Offset, UINT Size
 UBOOL FAsyncIOManagerWindows::CancelRequests( QWORD* RequestIndices, UINT NumIndices )
 {
 	FScopeLock ScopeLock( CriticalSection );
-	
-	UINT	NumFound			= 0;
-	UINT*	OutstandingIndices	= (UINT*) appAlloca( sizeof(UINT) * NumIndices );
+	return OutstandingRequests.Cancel( RequestIndices, NumIndices );
+}
+
+/**
+ * Blocks till all currently outstanding requests are canceled.
+ */
+void FAsyncIOManagerWindows::CancelAllRequests()
+{
+	// We need the scope lock here to ensure that BusyReading isn't being updated while we try to read from it.
+	FScopeLock ScopeLock( CriticalSection );
+
+	OutstandingRequests.Empty();
 
-	for( UINT OutstandingIndex=0; OutstandingIndex<(UINT)OutstandingRequests.Num() && NumFound<NumIndices; OutstandingIndex++ )
+	while( BusyReading.GetValue() )
 	{
-		for( UINT RequestIndex=0; RequestIndex<NumIndices; RequestIndex++ )
+		// We could probably use an event instead.
+		Sleep(1);
+	}
+}
+#endif
+
+/*-----------------------------------------------------------------------------
+	FAsyncIOManagerLinux implementation.
+-----------------------------------------------------------------------------*/
+
+#if __LINUX__
+/**
+ * Constructor.
+ *
+ * @param	InNumWorkers	Number of threads servicing requests, including the one running this runnable
+ */
+FAsyncIOManagerLinux::FAsyncIOManagerLinux( INT InNumWorkers )
+:	CriticalSection( NULL ),
+	OutstandingRequestsEvent( NULL ),
+	RequestIndex( 1 ),
+	NumWorkers( Max( InNumWorkers, 1 ) )
+{}
+
+/**
+ * Initializes critical section, event and other used variables and creates the
+ * additional worker threads.
+ *
+ * @return True if initialization was successful, false otherwise
+ */
+UBOOL FAsyncIOManagerLinux::Init()
+{
+	CriticalSection				= GSynchronizeFactory->CreateCriticalSection();
+	OutstandingRequestsEvent	= GSynchronizeFactory->CreateSynchEvent();
+	IsRunning.Increment();
+
+	for( INT WorkerIndex=1; WorkerIndex<NumWorkers; WorkerIndex++ )
+	{
+		FWorker*			Worker			= new FWorker( this );
+		FRunnableThread*	WorkerThread	= GThreadFactory->CreateThread( Worker );
+		check(WorkerThread);
+		Workers.AddItem( Worker );
+		WorkerThreads.AddItem( WorkerThread );
+	}
+	return TRUE;
+}
+
+/**
+ * Called in the context of the aggregating thread to perform cleanup. Waits for
+ * the other worker threads to finish.
+ */
+void FAsyncIOManagerLinux::Exit()
+{
+	for( INT WorkerIndex=0; WorkerIndex<WorkerThreads.Num(); WorkerIndex++ )
+	{
+		WorkerThreads(WorkerIndex)->WaitForCompletion();
+		GThreadFactory->Destroy( WorkerThreads(WorkerIndex) );
+		delete Workers(WorkerIndex);
+	}
+	WorkerThreads.Empty();
+	Workers.Empty();
+
+	for( INT FileIndex=0; FileIndex<FileDescriptors.Num(); FileIndex++ )
+	{
+		close( FileDescriptors(FileIndex) );
+	}
+	FileDescriptors.Empty();
+	NameToFileIndexMap.Empty();
+	GSynchronizeFactory->Destroy( CriticalSection );
+	GSynchronizeFactory->Destroy( OutstandingRequestsEvent );
+}
+
+/**
+ * This is called if a thread is requested to terminate early
+ */
+void FAsyncIOManagerLinux::Stop()
+{
+	IsRunning.Decrement();
+	OutstandingRequestsEvent->Trigger();
+}
+
+/**
+ * Reads from a file, retrying partial reads.
+ *
+ * @param	FileDescriptor	File to read from
+ * @param	Dest			Pointer to read data into
+ * @param	Offset			Offset into file
+ * @param	Size			Number of bytes to read
+ */
+void FAsyncIOManagerLinux::Read( INT FileDescriptor, void* Dest, UINT Offset, UINT Size )
+{
+	//@warning: this code doesn't handle failure as it doesn't have a way to pass back the information.
+	BYTE*	CurrentDest	= (BYTE*) Dest;
+	UINT	BytesLeft	= Size;
+	while( BytesLeft )
+	{
+		ssize_t BytesRead = pread( FileDescriptor, CurrentDest, BytesLeft, (off_t) Offset );
+		if( BytesRead < 0 && errno == EINTR )
 		{
-			if( OutstandingRequests(OutstandingIndex).RequestIndex == RequestIndices[RequestIndex] )
-			{
-				OutstandingIndices[NumFound] = OutstandingIndex;
-				NumFound++;
-			}
+			continue;
+		}
+		if( BytesRead <= 0 )
+		{
+			debugf( NAME_Warning, TEXT("Async read of %u bytes at offset %u failed"), BytesLeft, Offset );
+			break;
 		}
+		CurrentDest	+= BytesRead;
+		Offset		+= BytesRead;
+		BytesLeft	-= BytesRead;
 	}
+}
 
-	if( NumFound == NumIndices )
+/**
+ * Services requests till Stop is called. Runs on every worker thread.
+ *
+ * @return always 0
+ */
+DWORD FAsyncIOManagerLinux::Run()
+{
+	// Coalesced reads go through a per thread staging buffer before being copied to their destinations.
+	BYTE*									StagingBuffer = (BYTE*) appMalloc( ASYNC_IO_MAX_READ_SIZE );
+	TArray<FAsyncIORequestQueue::FRequest>	Batch;
+
+	// IsRunning gets decremented by Stop.
+	while( IsRunning.GetValue() > 0 )
 	{
-		for( UINT RequestIndex=0; RequestIndex<NumFound; RequestIndex++ )
+		INT		FileDescriptor	= -1;
+		UINT	Start			= 0;
+		UINT	End				= 0;
 		{
-			OutstandingRequests.Remove( OutstandingIndices[RequestIndex] - RequestIndex );
+			FScopeLock ScopeLock( CriticalSection );
+			Start = OutstandingRequests.GetNextBatch( Batch, End );
+			if( Batch.Num() )
+			{
+				FileDescriptor = FileDescriptors(Batch(0).FileIndex);
+				BusyReading.Increment();	// We're busy reading. Updated inside scoped lock to ensure CancelAllRequests works correctly.
+
+				// Wake up another worker if there is more work to be done.
+				if( OutstandingRequests.HasRequests() )
+				{
+					OutstandingRequestsEvent->Trigger();
+				}
+			}
 		}
 
-		return TRUE;
+		if( Batch.Num() )
+		{
+			TRACE_SCOPE(TEXT("AsyncIO read"));
+			if( Batch.Num() == 1 )
+			{
+				Read( FileDescriptor, Batch(0).Dest, Start, Batch(0).Size );
+			}
+			else
+			{
+				Read( FileDescriptor, StagingBuffer, Start, End - Start );
+				for( INT BatchIndex=0; BatchIndex<Batch.Num(); BatchIndex++ )
+				{
+					appMemcpy( Batch(BatchIndex).Dest, StagingBuffer + Batch(BatchIndex).Offset - Start, Batch(BatchIndex).Size );
+				}
+			}
+			for( INT BatchIndex=0; BatchIndex<Batch.Num(); BatchIndex++ )
+			{
+				Batch(BatchIndex).Counter->Decrement(); // Request fulfilled.
+			}
+			BusyReading.Decrement();		// We're done reading for now.
+		}
+		else
+		{
+			// Wait till the calling thread signals further work.
+			OutstandingRequestsEvent->Wait();
+		}
 	}
-	else
+
+	appFree( StagingBuffer );
+
+	// Pass on the stop signal to the next worker waiting on the event.
+	OutstandingRequestsEvent->Trigger();
+	return 0;
+}
+
+/**
+ * Requests data to be loaded async. Returns immediately.
+ *
+ * @param	Filename	Filename to load
+ * @param	Offset		Offset into file
+ * @param	Size		Size of load request
+ * @param	Dest		Pointer to load data into
+ * @param	Counter		Thread safe counter to decrement when loading has finished
+ * @param	Priority	Priority of request, see EAsyncIOPriority
+ * @param	Deadline	appSeconds by which the request should be serviced, 0 if none. Overdue requests go first.
+ *
+ * @return Returns an index to the request that can be used for canceling or 0 if the request failed.
+ */
+QWORD FAsyncIOManagerLinux::LoadData( FString Filename, UINT Offset, UINT Size, void* Dest, FThreadSafeCounter* Counter, EAsyncIOPriority Priority, DOUBLE Deadline )
+{
+	FScopeLock ScopeLock( CriticalSection );
+
+	INT* ExistingFileIndex	= NameToFileIndexMap.Find( Filename );
+	INT	 FileIndex			= ExistingFileIndex ? *ExistingFileIndex : INDEX_NONE;
+	if( !ExistingFileIndex )
 	{
-		return FALSE;
+		// Package paths use backslashes.
+		FString NativeFilename = Filename.Replace( TEXT("\\"), TEXT("/") );
+		INT FileDescriptor = open( TCHAR_TO_ANSI(*NativeFilename), O_RDONLY );
+		if( FileDescriptor < 0 )
+		{
+			return 0;
+		}
+		FileIndex = FileDescriptors.AddItem( FileDescriptor );
+		NameToFileIndexMap.Set( *Filename, FileIndex );
 	}
+
+	FAsyncIORequestQueue::FRequest IORequest;
+
+	IORequest.RequestIndex	= RequestIndex++;
+	IORequest.FileIndex		= FileIndex;
+	IORequest.Offset		= Offset;
+	IORequest.Size			= Size;
+	IORequest.Dest			= Dest;
+	IORequest.Counter		= Counter;
+	IORequest.Priority		= Priority;
+	IORequest.Deadline		= Deadline;
+
+	OutstandingRequests.Add( IORequest );
+
+	// Trigger event telling an IO thread to wake up to perform work.
+	OutstandingRequestsEvent->Trigger();
+
+	return IORequest.RequestIndex;
+}
+
+/**
+ * Returns the running totals of IO activity.
+ *
+ * @param	Stats	[out] Stats to fill in
+ */
+void FAsyncIOManagerLinux::GetStats( FAsyncIOStats& Stats )
+{
+	FScopeLock ScopeLock( CriticalSection );
+	OutstandingRequests.GetStats( Stats );
+}
+
+/**
+ * Removes N outstanding requests from the queue in an atomic all or nothing operation.
+ * NOTE: Requests are only canceled if ALL requests are still pending and neither one
+ * is currently in flight.
+ *
+ * @param	RequestIndices	Indices of requests to cancel.
+ * @return	TRUE if all requests were still outstanding, FALSE otherwise
+ */
+UBOOL FAsyncIOManagerLinux::CancelRequests( QWORD* RequestIndices, UINT NumIndices )
+{
+	FScopeLock ScopeLock( CriticalSection );
+	return OutstandingRequests.Cancel( RequestIndices, NumIndices );
 }
 
 /**
  * Blocks till all currently outstanding requests are canceled.
  */
-void FAsyncIOManagerWindows::CancelAllRequests()
+void FAsyncIOManagerLinux::CancelAllRequests()
 {
 	// We need the scope lock here to ensure that BusyReading isn't being updated while we try to read from it.
 	FScopeLock ScopeLock( CriticalSection );
@@ -677,10 +1475,10 @@ void FAsyncIOManagerWindows::CancelAllRequests()
 
 	while( BusyReading.GetValue() )
 	{
-		// We could probably use an event instead.
-		Sleep(1);
+		appSleep( 0.001f );
 	}
 }
+#endif
 
 /** Global resource loader */
 FResourceLoader*	GResourceLoader;
@@ -13,6 +13,7 @@
 #include "UnNet.h"
 #include "FConfigCacheIni.h"
 #include "UnPath.h"
+#include "UnPerception.h"
 #include "EngineAIClasses.h"
 
 IMPLEMENT_CLASS(UCheatManager);
@@ -160,12 +161,9 @@ UBOOL AController::StopAtLedge()
 }
 //-------------------------------------------------------------------------------------------------
 /*
-Node Evaluation functions, used with APawn::BreadthPathTo()
+Node Evaluation functions, used with APawn::findPathToward() (NodeEvaluator is declared in UnPath.h)
 */
 
-// declare type for node evaluation functions
-typedef FLOAT ( *NodeEvaluator ) (ANavigationPoint*, APawn*, FLOAT);
-
 
 FLOAT FindRandomPath( ANavigationPoint* CurrentNode, APawn* seeker, FLOAT bestWeight )
 {
@@ -1663,24 +1661,10 @@ void AActor::CheckNoiseHearing(FLOAT Loudness)
 	}
 
 	// if the noise is not made by a player or an AI with a player as an enemy, then only send it to
-	// other AIs with the same tag
-	if ( !Instigator->IsPlayer()
-		&& (!Instigator->Controller->Enemy || !Instigator->Controller->Enemy->IsPlayer()) )
-	{
-		for ( AController *next=Level->ControllerList; next!=NULL; next=next->NextController )
-			if ( (next->Pawn != Instigator) && next->IsProbing(NAME_HearNoise)
-				&& (next->Tag == Tag)
-				&& next->CanHear(Location, Loudness, this) )
-				next->eventHearNoise(Loudness, this);
-		return;
-	}
-
-	// all pawns can hear this noise
-	for ( AController *P=Level->ControllerList; P!=NULL; P=P->NextController )
-		if ( (P->Pawn != Instigator) && P->IsProbing(NAME_HearNoise)
-			 && P->CanHear(Location, Loudness, this) )
-			 P->eventHearNoise(Loudness, this);
-
+	// other AIs with the same tag.  Listeners are found and notified in a batch at the end of the level tick.
+	UBOOL bOnlySameTag = !Instigator->IsPlayer()
+		&& (!Instigator->Controller->Enemy || !Instigator->Controller->Enemy->IsPlayer());
+	GetLevel()->GetPerception()->AddNoise(this, Loudness, bOnlySameTag);
 }
 
 void AController::CheckEnemyVisible()
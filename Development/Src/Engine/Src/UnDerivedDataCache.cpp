@@ -0,0 +1,323 @@
+/*=============================================================================
+	UnDerivedDataCache.cpp: Local cache of data derived from source assets.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "EnginePrivate.h"
+
+/** Tag at the start of each cache file */
+#define DERIVEDDATA_MAGIC		0x44444331
+/** Extension of the cache files */
+#define DERIVEDDATA_EXTENSION	TEXT(".ddc")
+/** Name of the index file in the cache directory */
+#define DERIVEDDATA_INDEX		TEXT("Index.txt")
+
+FDerivedDataCache* GDerivedDataCache = NULL;
+
+/*-----------------------------------------------------------------------------
+	FDerivedDataKey.
+-----------------------------------------------------------------------------*/
+
+FDerivedDataKey::FDerivedDataKey( const TCHAR* InBuilder, INT InVersion )
+:	Builder( InBuilder )
+,	Version( InVersion )
+{
+	ArIsSaving = 1;
+	appMD5Init( &Context );
+}
+
+void FDerivedDataKey::Serialize( void* Data, INT Length )
+{
+	check(!Key.Len());
+	appMD5Update( &Context, (BYTE*)Data, Length );
+}
+
+const FString& FDerivedDataKey::GetKey()
+{
+	if( !Key.Len() )
+	{
+		BYTE Digest[16];
+		appMD5Final( Digest, &Context );
+		Key = FString::Printf( TEXT("%s_%i_"), *Builder, Version );
+		for( INT i=0; i<16; i++ )
+			Key += FString::Printf( TEXT("%02x"), Digest[i] );
+	}
+	return Key;
+}
+
+/*-----------------------------------------------------------------------------
+	FDerivedDataCache.
+-----------------------------------------------------------------------------*/
+
+/** A file in the cache directory, considered for eviction by Flush */
+struct FDerivedDataFile
+{
+	FString		Key;
+	INT			Size;
+	INT			LastUsed;
+};
+
+IMPLEMENT_COMPARE_CONSTREF( FDerivedDataFile, UnDerivedDataCache, { return A.LastUsed - B.LastUsed; } )
+
+FDerivedDataCache::FDerivedDataCache()
+:	MaxSize( 0 )
+,	UseCounter( 0 )
+{
+	if( ParseParam( appCmdLine(), TEXT("noddc") ) )
+		return;
+
+	FString Path;
+	if( !Parse( appCmdLine(), TEXT("DDC="), Path ) && !GConfig->GetString( TEXT("DerivedDataCache"), TEXT("Path"), Path, GEngineIni ) )
+		return;
+	if( !Path.Len() )
+		return;
+
+	INT MaxSizeMB = 4096;
+	GConfig->GetInt( TEXT("DerivedDataCache"), TEXT("MaxSizeMB"), MaxSizeMB, GEngineIni );
+	MaxSize = (QWORD)Max( MaxSizeMB, 0 ) * 1024 * 1024;
+
+	Directory = Path;
+	if( Directory.Right(1) != PATH_SEPARATOR )
+		Directory += PATH_SEPARATOR;
+	GFileManager->MakeDirectory( *Directory, 1 );
+
+	// Entries used by this process count as more recently used than any entry in the index.
+	TMap<FString,FIndexEntry> Entries;
+	UseCounter = LoadIndex( Entries ) + 1;
+
+	debugf( NAME_Init, TEXT("Derived data cache: %s, %i entries, %i MB maximum"), *Directory, Entries.Num(), MaxSizeMB );
+}
+
+FDerivedDataCache::~FDerivedDataCache()
+{
+	Flush();
+}
+
+UBOOL FDerivedDataCache::Get( FDerivedDataKey& Key, TArray<BYTE>& OutData )
+{
+	if( !Directory.Len() )
+		return 0;
+
+	FBuilderStats* BuilderStats = Stats.Find( Key.GetBuilder() );
+	if( !BuilderStats )
+		BuilderStats = &Stats.Set( *Key.GetBuilder(), FBuilderStats() );
+
+	DOUBLE StartTime = appSeconds();
+	const FString Filename = GetEntryFilename( Key.GetKey() );
+
+	UBOOL bFound = 0;
+	TArray<BYTE> File;
+	if( appLoadFileToArray( File, *Filename ) )
+	{
+		// The file starts with a tag, the size and the CRC of the data, so truncated or damaged files are detected.
+		const INT HeaderSize = 3 * sizeof(DWORD);
+		if( File.Num() > HeaderSize )
+		{
+			DWORD Magic, Crc;
+			INT Size;
+			FBufferReader Reader( File );
+			Reader << Magic << Size << Crc;
+			if( Magic == DERIVEDDATA_MAGIC && Size == File.Num() - HeaderSize && Crc == appMemCrc( &File(HeaderSize), Size ) )
+			{
+				OutData.Empty( Size );
+				OutData.Add( Size );
+				appMemcpy( &OutData(0), &File(HeaderSize), Size );
+				bFound = 1;
+			}
+		}
+		if( !bFound )
+		{
+			debugf( NAME_Warning, TEXT("Discarding damaged derived data cache file %s"), *Filename );
+			GFileManager->Delete( *Filename );
+		}
+	}
+
+	if( bFound )
+	{
+		TouchEntry( Key.GetKey(), File.Num() );
+		BuilderStats->Hits++;
+		BuilderStats->BytesRead += File.Num();
+	}
+	else
+	{
+		BuilderStats->Misses++;
+	}
+	BuilderStats->GetTime += appSeconds() - StartTime;
+
+	return bFound;
+}
+
+void FDerivedDataCache::Put( FDerivedDataKey& Key, const TArray<BYTE>& Data )
+{
+	if( !Directory.Len() || !Data.Num() )
+		return;
+
+	FBuilderStats* BuilderStats = Stats.Find( Key.GetBuilder() );
+	if( !BuilderStats )
+		BuilderStats = &Stats.Set( *Key.GetBuilder(), FBuilderStats() );
+
+	// Other processes may be reading the entry, so the file is written under a unique name and
+	// moved into place. If another process stored the same entry meanwhile, its file is kept.
+	const FString Filename = GetEntryFilename( Key.GetKey() );
+	const FString TempFilename = Filename + FString::Printf( TEXT(".%08x.tmp"), appCycles() );
+
+	FArchive* Ar = GFileManager->CreateFileWriter( *TempFilename );
+	if( !Ar )
+		return;
+	DWORD Magic = DERIVEDDATA_MAGIC;
+	INT Size = Data.Num();
+	DWORD Crc = appMemCrc( &Data(0), Size );
+	*Ar << Magic << Size << Crc;
+	Ar->Serialize( (void*)&Data(0), Size );
+	const UBOOL bWritten = Ar->Close();
+	delete Ar;
+
+	if( !bWritten || !GFileManager->Move( *Filename, *TempFilename, 0 ) )
+	{
+		GFileManager->Delete( *TempFilename );
+		if( GFileManager->FileSize( *Filename ) < 0 )
+		{
+			debugf( NAME_Warning, TEXT("Failed to write derived data cache file %s"), *Filename );
+			return;
+		}
+	}
+
+	TouchEntry( Key.GetKey(), GFileManager->FileSize( *Filename ) );
+	BuilderStats->Puts++;
+	BuilderStats->BytesWritten += Size;
+}
+
+void FDerivedDataCache::Flush()
+{
+	// Only processes that used the cache update the index.
+	if( !Directory.Len() || !UsedEntries.Num() )
+		return;
+
+	// Merge the entries used by this process into the index, other processes may have
+	// written it since it was read.
+	TMap<FString,FIndexEntry> Entries;
+	LoadIndex( Entries );
+	for( TMap<FString,FIndexEntry>::TIterator It(UsedEntries); It; ++It )
+	{
+		FIndexEntry* Entry = Entries.Find( It.Key() );
+		if( !Entry || Entry->LastUsed < It.Value().LastUsed )
+			Entries.Set( *It.Key(), It.Value() );
+	}
+	UsedEntries.Empty();
+
+	// The files in the directory are the actual entries, files missing from the index are evicted first.
+	TArray<FString> Filenames;
+	GFileManager->FindFiles( Filenames, *(Directory + TEXT("*") + DERIVEDDATA_EXTENSION), 1, 0 );
+
+	TArray<FDerivedDataFile> Files;
+	QWORD TotalSize = 0;
+	for( INT FileIndex=0; FileIndex<Filenames.Num(); FileIndex++ )
+	{
+		FDerivedDataFile File;
+		File.Key = FFilename(Filenames(FileIndex)).GetBaseFilename();
+		File.Size = GFileManager->FileSize( *(Directory + Filenames(FileIndex)) );
+		if( File.Size < 0 )
+			continue;
+		FIndexEntry* Entry = Entries.Find( File.Key );
+		File.LastUsed = Entry ? Entry->LastUsed : 0;
+		TotalSize += File.Size;
+		Files.AddItem( File );
+	}
+
+	// Evict the least recently used entries until the cache fits.
+	if( Files.Num() )
+		Sort<USE_COMPARE_CONSTREF(FDerivedDataFile,UnDerivedDataCache)>( &Files(0), Files.Num() );
+	INT NumEvicted = 0;
+	QWORD EvictedSize = 0;
+	while( NumEvicted < Files.Num() && TotalSize > MaxSize )
+	{
+		const FDerivedDataFile& File = Files(NumEvicted++);
+		GFileManager->Delete( *GetEntryFilename(File.Key) );
+		TotalSize -= File.Size;
+		EvictedSize += File.Size;
+	}
+	if( NumEvicted )
+		debugf( TEXT("Derived data cache: evicted %i entries (%.1f MB)"), NumEvicted, EvictedSize / (1024.0 * 1024.0) );
+
+	FString Index;
+	for( INT FileIndex=NumEvicted; FileIndex<Files.Num(); FileIndex++ )
+		Index += FString::Printf( TEXT("%s %i %i%s"), *Files(FileIndex).Key, Files(FileIndex).Size, Files(FileIndex).LastUsed, LINE_TERMINATOR );
+
+	const FString IndexFilename = Directory + DERIVEDDATA_INDEX;
+	const FString TempFilename = IndexFilename + FString::Printf( TEXT(".%08x.tmp"), appCycles() );
+	if( !appSaveStringToFile( Index, *TempFilename ) || !GFileManager->Move( *IndexFilename, *TempFilename ) )
+	{
+		GFileManager->Delete( *TempFilename );
+		debugf( NAME_Warning, TEXT("Failed to write derived data cache index %s"), *IndexFilename );
+	}
+}
+
+void FDerivedDataCache::DumpStats( FOutputDevice& Ar )
+{
+	if( !Directory.Len() )
+	{
+		Ar.Logf( TEXT("Derived data cache disabled") );
+		return;
+	}
+	Ar.Logf( TEXT("Derived data cache: %s"), *Directory );
+	for( TMap<FString,FBuilderStats>::TIterator It(Stats); It; ++It )
+	{
+		const FBuilderStats& BuilderStats = It.Value();
+		const INT Lookups = BuilderStats.Hits + BuilderStats.Misses;
+		Ar.Logf(
+			TEXT("  %-12s %6i hits %6i misses (%5.1f%% hit rate) %6i puts, %8.1f MB read in %.2f s, %8.1f MB written"),
+			*It.Key(),
+			BuilderStats.Hits,
+			BuilderStats.Misses,
+			Lookups ? 100.0 * BuilderStats.Hits / Lookups : 0.0,
+			BuilderStats.Puts,
+			BuilderStats.BytesRead / (1024.0 * 1024.0),
+			BuilderStats.GetTime,
+			BuilderStats.BytesWritten / (1024.0 * 1024.0)
+			);
+	}
+}
+
+FString FDerivedDataCache::GetEntryFilename( const FString& Key ) const
+{
+	return Directory + Key + DERIVEDDATA_EXTENSION;
+}
+
+INT FDerivedDataCache::LoadIndex( TMap<FString,FIndexEntry>& OutEntries ) const
+{
+	INT MaxLastUsed = 0;
+	FString Index;
+	if( !appLoadFileToString( Index, *(Directory + DERIVEDDATA_INDEX) ) )
+		return MaxLastUsed;
+
+	// Each line is "Key Size LastUsed".
+	const TCHAR* Str = *Index;
+	FString Line;
+	while( ParseLine( &Str, Line ) )
+	{
+		const TCHAR* LineStr = *Line;
+		FString Key, Size, LastUsed;
+		if( ParseToken( LineStr, Key, 0 ) && ParseToken( LineStr, Size, 0 ) && ParseToken( LineStr, LastUsed, 0 ) )
+		{
+			FIndexEntry Entry;
+			Entry.Size = appAtoi( *Size );
+			Entry.LastUsed = appAtoi( *LastUsed );
+			OutEntries.Set( *Key, Entry );
+			MaxLastUsed = Max( MaxLastUsed, Entry.LastUsed );
+		}
+	}
+	return MaxLastUsed;
+}
+
+void FDerivedDataCache::TouchEntry( const FString& Key, INT Size )
+{
+	FIndexEntry Entry;
+	Entry.Size = Size;
+	Entry.LastUsed = UseCounter++;
+	UsedEntries.Set( *Key, Entry );
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -18,6 +18,29 @@ IMPLEMENT_CLASS(UDistributionVectorConstant);
 IMPLEMENT_CLASS(UDistributionVectorConstantCurve);
 IMPLEMENT_CLASS(UDistributionVectorUniform);
 
+/**
+ * Returns whether a curve can be baked into a lookup table and the range of input values
+ * it has to be sampled across. Stepped keys would be smeared by interpolating between
+ * samples so curves with any of them are always evaluated exactly.
+ *
+ * @param	Curve		Curve to bake
+ * @param	MinIn		[out] Input value of first key
+ * @param	MaxIn		[out] Input value of last key
+ * @return	TRUE if the curve can be baked
+ */
+static UBOOL GetBakeableCurveRange( FCurveEdInterface* Curve, FLOAT& MinIn, FLOAT& MaxIn )
+{
+	for( INT KeyIndex=0; KeyIndex<Curve->GetNumKeys(); KeyIndex++ )
+	{
+		if( Curve->GetKeyInterpMode(KeyIndex) == CIM_Constant )
+		{
+			return 0;
+		}
+	}
+	Curve->GetInRange( MinIn, MaxIn );
+	return 1;
+}
+
 
 /*-----------------------------------------------------------------------------
 	UDistributionFloat implementation.
@@ -28,6 +51,123 @@ FLOAT UDistributionFloat::GetValue( FLOAT F )
 	return 0.f;
 }
 
+void UDistributionFloat::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+	// Loaded, duplicated or restored by undo.
+	if( Ar.IsLoading() )
+	{
+		DirtyLookupTable();
+	}
+}
+
+void UDistributionFloat::PostEditChange(UProperty* PropertyThatChanged)
+{
+	Super::PostEditChange(PropertyThatChanged);
+	DirtyLookupTable();
+}
+
+/**
+ * Bakes the distribution into LookupTable.
+ */
+void UDistributionFloat::BakeLookupTable()
+{
+	LookupTable.Empty();
+	LookupTableOp = DLTO_None;
+
+	// Subclasses of the known distributions may override GetValue, so classes are matched exactly.
+	UClass* Class = GetClass();
+	FLOAT MinIn, MaxIn;
+	if( Class == UDistributionFloatConstant::StaticClass() )
+	{
+		LookupTable.AddItem( GetValue() );
+		LookupTableOp = DLTO_Constant;
+	}
+	else if( Class == UDistributionFloatUniform::StaticClass() )
+	{
+		UDistributionFloatUniform* Uniform = (UDistributionFloatUniform*)this;
+		LookupTable.AddItem( Uniform->Min );
+		LookupTable.AddItem( Uniform->Max );
+		LookupTableOp = DLTO_Uniform;
+	}
+	else if( Class == UDistributionFloatConstantCurve::StaticClass() && GetBakeableCurveRange( this, MinIn, MaxIn ) )
+	{
+		if( MaxIn <= MinIn )
+		{
+			// No or a single key.
+			LookupTable.AddItem( GetValue(MinIn) );
+			LookupTableOp = DLTO_Constant;
+		}
+		else if( LookupTableSize >= 2 )
+		{
+			LookupTableStartTime = MinIn;
+			LookupTableTimeScale = (LookupTableSize - 1) / (MaxIn - MinIn);
+			LookupTable.Add( LookupTableSize );
+			for( INT SampleIndex=0; SampleIndex<LookupTableSize; SampleIndex++ )
+			{
+				LookupTable(SampleIndex) = GetValue( MinIn + SampleIndex / LookupTableTimeScale );
+			}
+			LookupTableOp = DLTO_Curve;
+		}
+	}
+}
+
+/**
+ * Evaluates the distribution through its lookup table for a batch of input values.
+ *
+ * @param	Count		Number of values to evaluate
+ * @param	InValues	Input values, Count entries
+ * @param	OutValues	[out] Evaluated values, Count entries
+ */
+void UDistributionFloat::GetBakedValues( INT Count, const FLOAT* InValues, FLOAT* OutValues )
+{
+	if( LookupTableOp == DLTO_Dirty )
+	{
+		BakeLookupTable();
+	}
+	switch( LookupTableOp )
+	{
+	case DLTO_Constant:
+		{
+			const FLOAT Value = LookupTable(0);
+			for( INT Index=0; Index<Count; Index++ )
+			{
+				OutValues[Index] = Value;
+			}
+			break;
+		}
+	case DLTO_Uniform:
+		{
+			const FLOAT MinValue = LookupTable(0);
+			const FLOAT MaxValue = LookupTable(1);
+			for( INT Index=0; Index<Count; Index++ )
+			{
+				OutValues[Index] = MaxValue + (MinValue - MaxValue) * appFrand();
+			}
+			break;
+		}
+	case DLTO_Curve:
+		{
+			const FLOAT*	Table		= &LookupTable(0);
+			const FLOAT		LastSample	= LookupTable.Num() - 1;
+			const INT		LastIndex	= LookupTable.Num() - 2;
+			for( INT Index=0; Index<Count; Index++ )
+			{
+				const FLOAT	Time		= Clamp<FLOAT>( (InValues[Index] - LookupTableStartTime) * LookupTableTimeScale, 0.f, LastSample );
+				const INT	SampleIndex	= Min<INT>( appTrunc(Time), LastIndex );
+				OutValues[Index] = Lerp( Table[SampleIndex], Table[SampleIndex + 1], Time - SampleIndex );
+			}
+			break;
+		}
+	default:
+		for( INT Index=0; Index<Count; Index++ )
+		{
+			OutValues[Index] = GetValue( InValues[Index] );
+		}
+		break;
+	}
+}
+
 /*-----------------------------------------------------------------------------
 	UDistributionFloatConstant implementation.
 -----------------------------------------------------------------------------*/
@@ -112,6 +252,7 @@ INT UDistributionFloatConstant::SetKeyIn(INT KeyIndex, FLOAT NewInVal)
 
 void UDistributionFloatConstant::SetKeyOut(INT SubIndex, INT KeyIndex, FLOAT NewOutVal) 
 {
+	DirtyLookupTable();
 	check( SubIndex == 0 );
 	check( KeyIndex == 0 );
 	Constant = NewOutVal;
@@ -203,6 +344,7 @@ FLOAT UDistributionFloatConstantCurve::EvalSub(INT SubIndex, FLOAT InVal)
 
 INT UDistributionFloatConstantCurve::CreateNewKey(FLOAT KeyIn)
 {
+	DirtyLookupTable();
 	FLOAT NewKeyOut = ConstantCurve.Eval(KeyIn, 0.f);
 	INT NewPointIndex = ConstantCurve.AddPoint(KeyIn, NewKeyOut);
 	ConstantCurve.AutoSetTangents(0.f);
@@ -211,6 +353,7 @@ INT UDistributionFloatConstantCurve::CreateNewKey(FLOAT KeyIn)
 
 void UDistributionFloatConstantCurve::DeleteKey(INT KeyIndex)
 {
+	DirtyLookupTable();
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 	ConstantCurve.Points.Remove(KeyIndex);
 	ConstantCurve.AutoSetTangents(0.f);
@@ -218,6 +361,7 @@ void UDistributionFloatConstantCurve::DeleteKey(INT KeyIndex)
 
 INT UDistributionFloatConstantCurve::SetKeyIn(INT KeyIndex, FLOAT NewInVal)
 {
+	DirtyLookupTable();
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 	INT NewPointIndex = ConstantCurve.MovePoint(KeyIndex, NewInVal);
 	ConstantCurve.AutoSetTangents(0.f);
@@ -226,6 +370,7 @@ INT UDistributionFloatConstantCurve::SetKeyIn(INT KeyIndex, FLOAT NewInVal)
 
 void UDistributionFloatConstantCurve::SetKeyOut(INT SubIndex, INT KeyIndex, FLOAT NewOutVal) 
 {
+	DirtyLookupTable();
 	check( SubIndex == 0 );
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 	ConstantCurve.Points(KeyIndex).OutVal = NewOutVal;
@@ -234,6 +379,7 @@ void UDistributionFloatConstantCurve::SetKeyOut(INT SubIndex, INT KeyIndex, FLOA
 
 void UDistributionFloatConstantCurve::SetKeyInterpMode(INT KeyIndex, EInterpCurveMode NewMode) 
 {
+	DirtyLookupTable();
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 	ConstantCurve.Points(KeyIndex).InterpMode = NewMode;
 	ConstantCurve.AutoSetTangents(0.f);
@@ -241,6 +387,7 @@ void UDistributionFloatConstantCurve::SetKeyInterpMode(INT KeyIndex, EInterpCurv
 
 void UDistributionFloatConstantCurve::SetTangents(INT SubIndex, INT KeyIndex, FLOAT ArriveTangent, FLOAT LeaveTangent)
 {
+	DirtyLookupTable();
 	check( SubIndex == 0 );
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 	ConstantCurve.Points(KeyIndex).ArriveTangent = ArriveTangent;
@@ -331,6 +478,7 @@ INT UDistributionFloatUniform::SetKeyIn(INT KeyIndex, FLOAT NewInVal)
 
 void UDistributionFloatUniform::SetKeyOut(INT SubIndex, INT KeyIndex, FLOAT NewOutVal) 
 {
+	DirtyLookupTable();
 	check( SubIndex == 0 || SubIndex == 1);
 	check( KeyIndex == 0 );
 
@@ -365,6 +513,189 @@ FVector UDistributionVector::GetValue( FLOAT F )
 	return FVector(0,0,0);
 }
 
+void UDistributionVector::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+	// Loaded, duplicated or restored by undo.
+	if( Ar.IsLoading() )
+	{
+		DirtyLookupTable();
+	}
+}
+
+void UDistributionVector::PostEditChange(UProperty* PropertyThatChanged)
+{
+	Super::PostEditChange(PropertyThatChanged);
+	DirtyLookupTable();
+}
+
+/**
+ * Bakes the distribution into LookupTable.
+ */
+void UDistributionVector::BakeLookupTable()
+{
+	LookupTable.Empty();
+	LookupTableOp = DLTO_None;
+
+	// Subclasses of the known distributions may override GetValue, so classes are matched exactly.
+	UClass* Class = GetClass();
+	FLOAT MinIn, MaxIn;
+	if( Class == UDistributionVectorConstant::StaticClass() )
+	{
+		const FVector Value = GetValue();
+		LookupTable.Add( 3 );
+		LookupTable(0) = Value.X;
+		LookupTable(1) = Value.Y;
+		LookupTable(2) = Value.Z;
+		LookupTableOp = DLTO_Constant;
+	}
+	else if( Class == UDistributionVectorUniform::StaticClass() )
+	{
+		// Resolve the mirror flags like UDistributionVectorUniform::GetValue, locked axes are resolved when evaluating.
+		UDistributionVectorUniform* Uniform = (UDistributionVectorUniform*)this;
+		FVector LocalMin = Uniform->Min;
+		for( INT i=0; i<3; i++ )
+		{
+			switch( Uniform->MirrorFlags[i] )
+			{
+			case EDVMF_Same:	LocalMin[i] =  Uniform->Max[i];		break;
+			case EDVMF_Mirror:	LocalMin[i] = -Uniform->Max[i];		break;
+			}
+		}
+		LookupTable.Add( 6 );
+		for( INT i=0; i<3; i++ )
+		{
+			LookupTable(i)		= LocalMin[i];
+			LookupTable(i + 3)	= Uniform->Max[i];
+		}
+		LookupTableLockedAxes = Uniform->LockedAxes;
+		LookupTableOp = DLTO_Uniform;
+	}
+	else if( Class == UDistributionVectorConstantCurve::StaticClass() && GetBakeableCurveRange( this, MinIn, MaxIn ) )
+	{
+		if( MaxIn <= MinIn )
+		{
+			// No or a single key.
+			const FVector Value = GetValue( MinIn );
+			LookupTable.Add( 3 );
+			LookupTable(0) = Value.X;
+			LookupTable(1) = Value.Y;
+			LookupTable(2) = Value.Z;
+			LookupTableOp = DLTO_Constant;
+		}
+		else if( LookupTableSize >= 2 )
+		{
+			LookupTableStartTime = MinIn;
+			LookupTableTimeScale = (LookupTableSize - 1) / (MaxIn - MinIn);
+			LookupTable.Add( LookupTableSize * 3 );
+			for( INT SampleIndex=0; SampleIndex<LookupTableSize; SampleIndex++ )
+			{
+				const FVector Value = GetValue( MinIn + SampleIndex / LookupTableTimeScale );
+				LookupTable(SampleIndex * 3 + 0) = Value.X;
+				LookupTable(SampleIndex * 3 + 1) = Value.Y;
+				LookupTable(SampleIndex * 3 + 2) = Value.Z;
+			}
+			LookupTableOp = DLTO_Curve;
+		}
+	}
+}
+
+/**
+ * Picks a random value of a baked uniform distribution, like UDistributionVectorUniform::GetValue.
+ */
+FVector UDistributionVector::GetBakedUniformValue()
+{
+	const FLOAT* LocalMin = &LookupTable(0);
+	const FLOAT* LocalMax = &LookupTable(3);
+
+	FLOAT fX = LocalMax[0] + (LocalMin[0] - LocalMax[0]) * appFrand();
+	FLOAT fY;
+	FLOAT fZ;
+
+	switch (LookupTableLockedAxes)
+	{
+    case EDVLF_XY:
+		fY = fX;
+		fZ = LocalMax[2] + (LocalMin[2] - LocalMax[2]) * appFrand();
+		break;
+    case EDVLF_XZ:
+		fY = LocalMax[1] + (LocalMin[1] - LocalMax[1]) * appFrand();
+		fZ = fX;
+		break;
+    case EDVLF_YZ:
+		fY = LocalMax[1] + (LocalMin[1] - LocalMax[1]) * appFrand();
+		fZ = fY;
+		break;
+	case EDVLF_XYZ:
+		fY = fX;
+		fZ = fX;
+		break;
+    case EDVLF_None:
+	default:
+		fY = LocalMax[1] + (LocalMin[1] - LocalMax[1]) * appFrand();
+		fZ = LocalMax[2] + (LocalMin[2] - LocalMax[2]) * appFrand();
+		break;
+	}
+
+	return FVector(fX, fY, fZ);
+}
+
+/**
+ * Evaluates the distribution through its lookup table for a batch of input values.
+ *
+ * @param	Count		Number of values to evaluate
+ * @param	InValues	Input values, Count entries
+ * @param	OutValues	[out] Evaluated values, Count entries
+ */
+void UDistributionVector::GetBakedValues( INT Count, const FLOAT* InValues, FVector* OutValues )
+{
+	if( LookupTableOp == DLTO_Dirty )
+	{
+		BakeLookupTable();
+	}
+	switch( LookupTableOp )
+	{
+	case DLTO_Constant:
+		{
+			const FVector Value( LookupTable(0), LookupTable(1), LookupTable(2) );
+			for( INT Index=0; Index<Count; Index++ )
+			{
+				OutValues[Index] = Value;
+			}
+			break;
+		}
+	case DLTO_Uniform:
+		for( INT Index=0; Index<Count; Index++ )
+		{
+			OutValues[Index] = GetBakedUniformValue();
+		}
+		break;
+	case DLTO_Curve:
+		{
+			const FLOAT*	Table		= &LookupTable(0);
+			const FLOAT		LastSample	= LookupTable.Num() / 3 - 1;
+			const INT		LastIndex	= LookupTable.Num() / 3 - 2;
+			for( INT Index=0; Index<Count; Index++ )
+			{
+				const FLOAT		Time		= Clamp<FLOAT>( (InValues[Index] - LookupTableStartTime) * LookupTableTimeScale, 0.f, LastSample );
+				const INT		SampleIndex	= Min<INT>( appTrunc(Time), LastIndex );
+				const FLOAT		Alpha		= Time - SampleIndex;
+				const FLOAT*	Sample		= Table + SampleIndex * 3;
+				OutValues[Index].X = Lerp( Sample[0], Sample[3], Alpha );
+				OutValues[Index].Y = Lerp( Sample[1], Sample[4], Alpha );
+				OutValues[Index].Z = Lerp( Sample[2], Sample[5], Alpha );
+			}
+			break;
+		}
+	default:
+		for( INT Index=0; Index<Count; Index++ )
+		{
+			OutValues[Index] = GetValue( InValues[Index] );
+		}
+		break;
+	}
+}
+
 /*-----------------------------------------------------------------------------
 	UDistributionVectorConstant implementation.
 -----------------------------------------------------------------------------*/
@@ -554,6 +885,7 @@ INT UDistributionVectorConstant::SetKeyIn(INT KeyIndex, FLOAT NewInVal)
 
 void UDistributionVectorConstant::SetKeyOut(INT SubIndex, INT KeyIndex, FLOAT NewOutVal) 
 {
+	DirtyLookupTable();
 	check( SubIndex >= 0 && SubIndex < 3);
 	check( KeyIndex == 0 );
 
@@ -782,6 +1114,7 @@ FLOAT UDistributionVectorConstantCurve::EvalSub(INT SubIndex, FLOAT InVal)
 
 INT UDistributionVectorConstantCurve::CreateNewKey(FLOAT KeyIn)
 {	
+	DirtyLookupTable();
 	FVector NewKeyVal = ConstantCurve.Eval(KeyIn, 0.f);
 	INT NewPointIndex = ConstantCurve.AddPoint(KeyIn, NewKeyVal);
 	ConstantCurve.AutoSetTangents(0.f);
@@ -790,6 +1123,7 @@ INT UDistributionVectorConstantCurve::CreateNewKey(FLOAT KeyIn)
 
 void UDistributionVectorConstantCurve::DeleteKey(INT KeyIndex)
 {
+	DirtyLookupTable();
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 	ConstantCurve.Points.Remove(KeyIndex);
 	ConstantCurve.AutoSetTangents(0.f);
@@ -797,6 +1131,7 @@ void UDistributionVectorConstantCurve::DeleteKey(INT KeyIndex)
 
 INT UDistributionVectorConstantCurve::SetKeyIn(INT KeyIndex, FLOAT NewInVal)
 {
+	DirtyLookupTable();
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 	INT NewPointIndex = ConstantCurve.MovePoint(KeyIndex, NewInVal);
 	ConstantCurve.AutoSetTangents(0.f);
@@ -805,6 +1140,7 @@ INT UDistributionVectorConstantCurve::SetKeyIn(INT KeyIndex, FLOAT NewInVal)
 
 void UDistributionVectorConstantCurve::SetKeyOut(INT SubIndex, INT KeyIndex, FLOAT NewOutVal) 
 {
+	DirtyLookupTable();
 	check( SubIndex >= 0 && SubIndex < 3);
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 
@@ -820,6 +1156,7 @@ void UDistributionVectorConstantCurve::SetKeyOut(INT SubIndex, INT KeyIndex, FLO
 
 void UDistributionVectorConstantCurve::SetKeyInterpMode(INT KeyIndex, EInterpCurveMode NewMode) 
 {
+	DirtyLookupTable();
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 	
 	ConstantCurve.Points(KeyIndex).InterpMode = NewMode;
@@ -828,6 +1165,7 @@ void UDistributionVectorConstantCurve::SetKeyInterpMode(INT KeyIndex, EInterpCur
 
 void UDistributionVectorConstantCurve::SetTangents(INT SubIndex, INT KeyIndex, FLOAT ArriveTangent, FLOAT LeaveTangent)
 {
+	DirtyLookupTable();
 	check( SubIndex >= 0 && SubIndex < 3);
 	check( KeyIndex >= 0 && KeyIndex < ConstantCurve.Points.Num() );
 
@@ -1203,6 +1541,7 @@ INT UDistributionVectorUniform::SetKeyIn(INT KeyIndex, FLOAT NewInVal)
 
 void UDistributionVectorUniform::SetKeyOut(INT SubIndex, INT KeyIndex, FLOAT NewOutVal) 
 {
+	DirtyLookupTable();
 	check( SubIndex >= 0 && SubIndex < 6 );
 	check( KeyIndex == 0 );
 
@@ -11,9 +11,6 @@ Revision history:
 #include "FConfigCacheIni.h"
 #include "FCodec.h"
 
-BYTE* FCodecBWT::CompressBuffer;
-INT   FCodecBWT::CompressLength;
-
 /*-----------------------------------------------------------------------------
 	UDownload implementation.
 -----------------------------------------------------------------------------*/
@@ -230,6 +230,13 @@ UBOOL UEngine::Exec( const TCHAR* Cmd, FOutputDevice& Ar )
 			GLogConsole->Show( !GLogConsole->IsShown() );
 		return 1;
 	}
+	else if( ParseCommand(&Cmd,TEXT("DDCSTATS")) )
+	{
+		// Hits and misses of the derived data cache.
+		if( GDerivedDataCache )
+			GDerivedDataCache->DumpStats( Ar );
+		return 1;
+	}
 	else if( ParseCommand(&Cmd,TEXT("CRACKURL")) )
 	{
 		FURL URL(NULL,Cmd,TRAVEL_Absolute);
@@ -286,6 +293,9 @@ INT UServerCommandlet::Main( const TCHAR* Parms )
 	DOUBLE OldTime = appSeconds();
 	while( GIsRunning && !GIsRequestingExit )
 	{
+		// Reclaim temporaries of last frame.
+		GFrameArena.Tick();
+
 		// Update the world.
 		DOUBLE NewTime = appSeconds();
 		GEngine->Tick( NewTime - OldTime );
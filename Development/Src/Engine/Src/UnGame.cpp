@@ -822,6 +822,8 @@ FLOAT UGameEngine::GetMaxTickRate()
 //
 void UGameEngine::Tick( FLOAT DeltaSeconds )
 {
+	TRACE_SCOPE(TEXT("UGameEngine::Tick"));
+
 	INT LocalTickCycles=0;
 	clock(LocalTickCycles);
 
@@ -1017,7 +1019,10 @@ void UGameEngine::Tick( FLOAT DeltaSeconds )
 		}
 	}
 
-	// Update memory stats.
+	// Update memory stats. The allocation count is cumulative so it's tracked even if stats
+	// are disabled in order for the first displayed value to be correct.
+	static DWORD LastAllocationCount	= 0;
+	DWORD AllocationCount				= GMalloc->GetAllocationCount();
 	if( GMemoryStats.Enabled )
 	{
 		SIZE_T Virtual, Physical;
@@ -1025,14 +1030,26 @@ void UGameEngine::Tick( FLOAT DeltaSeconds )
 
 		GMemoryStats.VirtualAllocations.Value	+= Virtual / 1024.f / 1024.f;
 		GMemoryStats.PhysicalAllocations.Value	+= Physical / 1024.f / 1024.f;
+
+		GMemoryStats.HeapAllocations.Value			+= AllocationCount - LastAllocationCount;
+		GMemoryStats.FrameArenaAllocations.Value	+= GFrameArena.GetLastFrameAllocations();
+		GMemoryStats.FrameArenaFallbacks.Value		+= GFrameArena.GetLastFrameFallbacks();
+		GMemoryStats.FrameArenaPeakSize.Value		+= GFrameArena.GetLastFramePeakBytes() / 1024.f;
 	}
+	LastAllocationCount = AllocationCount;
 
 	// Placed right before draw in order to delay stalling the GPU for as long as possible.
-	GStreamingManager->Tick();
+	{
+		TRACE_SCOPE(TEXT("Streaming"));
+		GStreamingManager->Tick();
+	}
 
 	// Render everything.
-	for(FPlayerIterator It(this);It;++It)
-		It->Viewport->Draw(!GIsBenchmarking);
+	{
+		TRACE_SCOPE(TEXT("Draw"));
+		for(FPlayerIterator It(this);It;++It)
+			It->Viewport->Draw(!GIsBenchmarking);
+	}
 	
 	unclock(LocalTickCycles);
 	TickCycles=LocalTickCycles;
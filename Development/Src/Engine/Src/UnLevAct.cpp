@@ -8,8 +8,12 @@ Revision history:
 
 #include "EnginePrivate.h"
 #include "UnNet.h"
+#include "UnPerception.h"
+#include "UnPawnMovement.h"
 
 #include "EngineSequenceClasses.h"
+#include "UnSequenceRuntime.h"
+#include "UnMoveCache.h"
 
 /*-----------------------------------------------------------------------------
 	Level actor management.
@@ -32,6 +36,8 @@ AActor* ULevel::SpawnActor
 	UBOOL			bNoFail
 )
 {
+	MEMORY_TAG_SCOPE(SpawnActor);
+
 	UBOOL	bBegunPlay = Actors.Num() && Cast<ALevelInfo>(Actors(0)) && Cast<ALevelInfo>(Actors(0))->bBegunPlay;
 
 	// Make sure this class is spawnable.
@@ -104,6 +110,8 @@ AActor* ULevel::SpawnActor
 	Actor->Rotation = Rotation;
 
 	// Initialize the actor's components.
+	if( MoveCache )
+		MoveCache->InvalidateBatch();
 	Actor->UpdateComponents();
 
 	// init actor's physics volume
@@ -321,6 +329,8 @@ UBOOL ULevel::DestroyActor( AActor* ThisActor, UBOOL bNetForce, UBOOL bDeferRefC
 	ThisActor->bDeleteMe = 1;
 
 	// Clean up the actor's components.
+	if( MoveCache )
+		MoveCache->InvalidateBatch();
 	ThisActor->ClearComponents();
 	if(!GetLevelInfo()->bBegunPlay)
 		ThisActor->InvalidateLightingCache();
@@ -401,6 +411,16 @@ void ULevel::CleanupDestroyed( UBOOL bForce )
 		if( c<128 )
 		return;
     }
+	// Drop pending perception checks, pawn moves, indexed events and cached overlaps involving actors tagged for deletion.
+	if( Perception )
+		Perception->CleanupDestroyed();
+	if( PawnMovement )
+		PawnMovement->CleanupDestroyed();
+	if( SequenceRuntime )
+		SequenceRuntime->CleanupDestroyed();
+	if( MoveCache )
+		MoveCache->CleanupDestroyed();
+
 	// Remove all references to actors tagged for deletion.
 	for( INT iActor=0; iActor<Actors.Num(); iActor++ )
 	{
@@ -795,6 +815,8 @@ UBOOL ULevel::FarMoveActor( AActor* Actor, const FVector& DestLocation, UBOOL te
 		return 0;
 	if ( test && (Actor->Location == DestLocation) )
 		return 1;
+	if( MoveCache )
+		MoveCache->NotifyMove( Actor );
 
     FVector prevLocation = Actor->Location;
 	FVector newLocation = DestLocation;
@@ -888,6 +910,8 @@ UBOOL ULevel::MoveActor
 	check(Actor!=NULL);
 	if( (Actor->bStatic || !Actor->bMovable) && GetLevelInfo()->bBegunPlay )
 		return 0;
+	if( MoveCache )
+		MoveCache->NotifyMove( Actor );
 
 	UBOOL bRelevantAttachments = (Actor->Attached.Num() != 0);
 	UBOOL bNoDelta = Delta.IsZero();
@@ -960,6 +984,9 @@ UBOOL ULevel::MoveActor
 
 	UBOOL doEncroachTouch = 1;
 
+	// Gather the collision around this actor and everything attached to it once for all of their moves.
+	const UBOOL bBatchedMove = !bTest && GetMoveCache()->BeginBatch( Actor, Delta, NewRotation );
+
 	// Perform movement collision checking if needed for this actor.
 	if((Actor->bCollideActors || Actor->bCollideWorld) &&
 		Actor->CollisionComponent &&
@@ -1039,6 +1066,8 @@ UBOOL ULevel::MoveActor
 	// Abort if encroachment declined.
 	if( !bTest && !bNoFail && Actor->IsEncroacher() && CheckEncroachment( Actor, Actor->Location + FinalDelta, NewRotation, doEncroachTouch ) )
 	{
+		if( bBatchedMove )
+			MoveCache->EndBatch();
 		Mark.Pop();
 		return 0;
 	}
@@ -1127,6 +1156,8 @@ UBOOL ULevel::MoveActor
 						for( INT j=0; j<Actor->Attached.Num(); j++ )
 							if ( Actor->Attached(j) )
 								MoveActor( Actor->Attached(j), -1.f * FinalDelta, Actor->Attached(j)->Rotation, OtherHit, 0, 0, 1 );
+						if( bBatchedMove )
+							MoveCache->EndBatch();
 						Mark.Pop();
 						return 0;
 					}
@@ -1135,6 +1166,9 @@ UBOOL ULevel::MoveActor
 		}
 	}
 
+	if( bBatchedMove )
+		MoveCache->EndBatch();
+
 	// Update the location.
 
 	// update relative location of this actor
@@ -1169,7 +1203,7 @@ UBOOL ULevel::MoveActor
 		// UnTouch notifications.
 		for( int i=0; i<Actor->Touching.Num(); )
 		{
-			if( Actor->Touching(i) && !Actor->IsOverlapping(Actor->Touching(i)) )
+			if( Actor->Touching(i) && !GetMoveCache()->IsOverlapping(Actor, Actor->Touching(i)) )
 				Actor->EndTouch( Actor->Touching(i), 0 );
 			else
 				i++;
@@ -1237,7 +1271,9 @@ UBOOL ULevel::CheckEncroachment
 
 	// Query the mover about what he wants to do with the actors he is encroaching.
 	FMemMark Mark(GMem);
-	FCheckResult* FirstHit = Hash ? Hash->ActorEncroachmentCheck( GMem, Actor, TestLocation, TestRotation, TRACE_AllColliding ) : NULL;	
+	FCheckResult* FirstHit = NULL;
+	if( Hash && (!MoveCache || !MoveCache->ActorEncroachmentCheck( GMem, Actor, TestLocation, TestRotation, TRACE_AllColliding, FirstHit )) )
+		FirstHit = Hash->ActorEncroachmentCheck( GMem, Actor, TestLocation, TestRotation, TRACE_AllColliding );
 	for( FCheckResult* Test = FirstHit; Test!=NULL; Test=Test->GetNext() )
 	{
 		if
@@ -1299,7 +1335,7 @@ UBOOL ULevel::CheckEncroachment
 		// UnTouch notifications.
 		for( int i=0; i<Actor->Touching.Num(); )
 		{
-			if( Actor->Touching(i) && !Actor->IsOverlapping(Actor->Touching(i)) )
+			if( Actor->Touching(i) && !GetMoveCache()->IsOverlapping(Actor, Actor->Touching(i)) )
 				Actor->EndTouch( Actor->Touching(i), 0 );
 			else
 				i++;
@@ -1536,7 +1572,11 @@ FCheckResult* ULevel::MultiLineCheck
 	// Check with actors.
 	if( (TraceFlags & TRACE_Hash) && Hash )
 	{
-		for( FCheckResult* Link=Hash->ActorLineCheck( Mem, NewEnd, Start, Extent, TraceFlags, SourceActor ); Link && NumHits<ARRAY_COUNT(Hits); Link=Link->GetNext() )
+		// Moves of attached actors are checked against the candidates gathered for their base.
+		FCheckResult* FirstLink = NULL;
+		if( !MoveCache || !MoveCache->ActorLineCheck( Mem, NewEnd, Start, Extent, TraceFlags, SourceActor, FirstLink ) )
+			FirstLink = Hash->ActorLineCheck( Mem, NewEnd, Start, Extent, TraceFlags, SourceActor );
+		for( FCheckResult* Link=FirstLink; Link && NumHits<ARRAY_COUNT(Hits); Link=Link->GetNext() )
 		{
 			Link->Time *= Dilation;
 			Hits[NumHits++] = *Link;
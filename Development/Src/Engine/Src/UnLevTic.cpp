@@ -9,6 +9,9 @@
 #include "EnginePrivate.h"
 #include "UnNet.h"
 #include "UnPath.h"
+#include "UnPerception.h"
+#include "UnPawnMovement.h"
+#include "UnMoveCache.h"
 
 #include "EngineSequenceClasses.h"
 
@@ -350,7 +353,7 @@ UBOOL AController::Tick( FLOAT DeltaSeconds, ELevelTick TickType )
 		{
 			if( IsProbing(NAME_EnemyNotVisible) )
 			{
-				CheckEnemyVisible();
+				GetLevel()->GetPerception()->AddEnemyCheck(this);
 				SightCounter = 0.05f + 0.1f * appFrand();
 			}
 			else
@@ -364,7 +367,7 @@ UBOOL AController::Tick( FLOAT DeltaSeconds, ELevelTick TickType )
 		// also
 
 		if( Pawn && !Pawn->bHidden && !Pawn->bAmbientCreature )
-			ShowSelf();
+			GetLevel()->GetPerception()->AddShowSelf(this);
 	}
 
 	if ( Pawn )
@@ -488,7 +491,7 @@ UBOOL APlayerController::Tick( FLOAT DeltaSeconds, ELevelTick TickType )
 
 		SightCounter = SightCounter - DeltaSeconds;
 		if( Pawn && !Pawn->bHidden )
-			ShowSelf();
+			GetLevel()->GetPerception()->AddShowSelf(this);
 	}
 
 	return 1;
@@ -1154,6 +1157,8 @@ UBOOL ULevel::IsPaused()
 //
 void ULevel::Tick( ELevelTick TickType, FLOAT DeltaSeconds )
 {
+	TRACE_SCOPE(TEXT("ULevel::Tick"));
+
 	ALevelInfo* Info = GetLevelInfo();
 
 	FMemMark Mark(GMem);
@@ -1198,8 +1203,17 @@ void ULevel::Tick( ELevelTick TickType, FLOAT DeltaSeconds )
 		NewlySpawned = NULL;
 		INT Updated  = 1;
 
+		// Overlaps cached by the moves of the previous tick are stale.
+		if( MoveCache )
+			MoveCache->Tick();
+
 		TickLevelRBPhys(DeltaSeconds);
 
+		// Walking AI pawns are moved in a separate phase once all actors have ticked.
+		FPawnMovementPhase* PawnMovementPhase = (TickType == LEVELTICK_All) ? GetPawnMovement() : NULL;
+		if( PawnMovementPhase )
+			PawnMovementPhase->BeginCollecting();
+
 		for( INT iActor=iFirstDynamicActor; iActor<Actors.Num(); iActor++ )
 		{
 			if( Actors( iActor ) && !Actors(iActor)->bDeleteMe )
@@ -1222,6 +1236,13 @@ void ULevel::Tick( ELevelTick TickType, FLOAT DeltaSeconds )
 			}
 		}
 
+		if( PawnMovementPhase )
+			PawnMovementPhase->Tick();
+
+		// Run the sight and hearing checks requested by the actors ticked above.
+		if( Perception )
+			Perception->Tick();
+
 		// Tick all objects inheriting from FTickableObjects.
 		for( INT i=0; i<FTickableObject::TickableObjects.Num(); i++ )
 			FTickableObject::TickableObjects(i)->Tick( DeltaSeconds );
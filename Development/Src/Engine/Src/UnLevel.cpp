@@ -11,6 +11,10 @@
 #include "EngineSequenceClasses.h"
 #include "UnTerrain.h"
 #include "UnStatChart.h"
+#include "UnPerception.h"
+#include "UnPawnMovement.h"
+#include "UnSequenceRuntime.h"
+#include "UnMoveCache.h"
 
 void ULineBatchComponent::DrawLine(const FVector& Start,const FVector& End,FColor Color)
 {
@@ -429,6 +433,15 @@ void ULevel::Destroy()
 
 	TermLevelRBPhys();
 
+	delete Perception;
+	Perception = NULL;
+	delete PawnMovement;
+	PawnMovement = NULL;
+	delete SequenceRuntime;
+	SequenceRuntime = NULL;
+	delete MoveCache;
+	MoveCache = NULL;
+
 	Super::Destroy();
 }
 IMPLEMENT_CLASS(ULevel);
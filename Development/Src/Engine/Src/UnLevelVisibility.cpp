@@ -203,7 +203,7 @@ void ULevel::AddPrimitive(UPrimitiveComponent* Primitive)
 	Hash->AddPrimitive(Primitive);
 
 	// Find the lights which affect the primitive.
-	TArray<ULightComponent*>	RelevantLights;
+	TFrameArray<ULightComponent*>	RelevantLights(16);
 	GetRelevantLights(Primitive,RelevantLights);
 	for(INT LightIndex = 0;LightIndex < RelevantLights.Num();LightIndex++)
 		Primitive->AttachLight(RelevantLights(LightIndex));
@@ -278,7 +278,7 @@ void ULevel::AddLight(ULightComponent* Light)
 	ENDCYCLECOUNTER;
 
 	// Find primitives within the visibility volume of the light.
-	TArray<UPrimitiveComponent*>	RelevantPrimitives;
+	TFrameArray<UPrimitiveComponent*>	RelevantPrimitives(256);
 	check(Hash);
 	Hash->GetVisiblePrimitives(LightVisibility->VisibilitySet,RelevantPrimitives);
 	for(INT PrimitiveIndex = 0;PrimitiveIndex < RelevantPrimitives.Num();PrimitiveIndex++)
@@ -325,7 +325,7 @@ void UModelComponent::CacheLighting()
 
 	StaticLights.Empty();
 
-	TArray<ULightComponent*>	RelevantLights;
+	TFrameArray<ULightComponent*>	RelevantLights(16);
 	Scene->GetRelevantLights(this,RelevantLights);
 	for(UINT LightIndex = 0;LightIndex < (UINT)RelevantLights.Num();LightIndex++)
 	{
@@ -0,0 +1,372 @@
+/*=============================================================================
+	UnMoveCache.cpp: Collision queries shared between the moves of a level tick.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "EnginePrivate.h"
+#include "UnMoveCache.h"
+
+/** Minimum number of attached actors for the moves of a base to be batched */
+#define MIN_BATCHED_ATTACHMENTS		2
+
+/** Distance batch bounds are grown by on top of the move, covering the extra distance MoveActor checks */
+#define BATCH_BOUNDS_SLACK			4.f
+
+/**
+ * Returns the level's move cache, creating it if necessary.
+ */
+FActorMoveCache* ULevel::GetMoveCache()
+{
+	if( !MoveCache )
+	{
+		MoveCache = new FActorMoveCache( this );
+	}
+	return MoveCache;
+}
+
+/**
+ * Returns the bounds of an actor's collision, or its location if it has no collision.
+ */
+static FBox GetCollisionBox( AActor* Actor )
+{
+	if( Actor->CollisionComponent && Actor->CollisionComponent->Initialized )
+	{
+		return Actor->CollisionComponent->Bounds.GetBox();
+	}
+	return FBox( Actor->Location, Actor->Location );
+}
+
+/*-----------------------------------------------------------------------------
+	FActorMoveCache implementation.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Constructor.
+ *
+ * @param	InLevel		Level whose moves are cached
+ */
+FActorMoveCache::FActorMoveCache( ULevel* InLevel )
+:	Level( InLevel )
+,	bBatching( FALSE )
+,	bBatchValid( FALSE )
+,	BatchBounds( 0 )
+{
+}
+
+/**
+ * Drops the cached overlaps of the previous tick.
+ */
+void FActorMoveCache::Tick()
+{
+	InvalidateOverlaps();
+}
+
+/**
+ * Starts a move batch for an actor and everything attached to it, unless a batch is
+ * already running.
+ *
+ * @param	Actor		Base that is about to be moved
+ * @param	Delta		Move of the base
+ * @param	NewRotation	Rotation of the base after the move
+ * @return	TRUE if a batch was started
+ */
+UBOOL FActorMoveCache::BeginBatch( AActor* Actor, const FVector& Delta, const FRotator& NewRotation )
+{
+	if( bBatching || !Level->Hash || Actor->Attached.Num() < MIN_BATCHED_ATTACHMENTS )
+	{
+		return FALSE;
+	}
+
+	// Everything attached moves along, directly or through its own attachments.
+	BatchActors.Empty( BatchActors.Num() );
+	BatchActors.AddItem( Actor );
+	for( INT ActorIndex=0; ActorIndex<BatchActors.Num(); ActorIndex++ )
+	{
+		AActor* BatchActor = BatchActors(ActorIndex);
+		for( INT AttachedIndex=0; AttachedIndex<BatchActor->Attached.Num(); AttachedIndex++ )
+		{
+			AActor* Other = BatchActor->Attached(AttachedIndex);
+			if( Other && !Other->bDeleteMe && !BatchActors.ContainsItem(Other) )
+			{
+				BatchActors.AddItem( Other );
+			}
+		}
+	}
+
+	// Attached actors follow the base rigidly, so rotating the base moves them at most twice
+	// their distance from its pivot, and may turn their bounds around their center.
+	const UBOOL		bRotating	= NewRotation != Actor->Rotation;
+	const FLOAT		DeltaSize	= Delta.Size();
+	BatchBounds = FBox(0);
+	for( INT ActorIndex=0; ActorIndex<BatchActors.Num(); ActorIndex++ )
+	{
+		const FBox	Box		= GetCollisionBox( BatchActors(ActorIndex) );
+		FLOAT		Reach	= DeltaSize + BATCH_BOUNDS_SLACK;
+		if( bRotating )
+		{
+			Reach += 2.f * (Box.GetCenter() - Actor->Location).Size() + Box.GetExtent().Size();
+		}
+		BatchBounds += Box.ExpandBy( Reach );
+	}
+
+	BatchPrimitives.Empty( BatchPrimitives.Num() );
+	Level->Hash->GetIntersectingPrimitives( BatchBounds, BatchPrimitives );
+
+	bBatching	= TRUE;
+	bBatchValid	= TRUE;
+	GCollisionStats.BatchedMoves.Value++;
+	return TRUE;
+}
+
+/**
+ * Ends the running move batch.
+ */
+void FActorMoveCache::EndBatch()
+{
+	check(bBatching);
+	bBatching	= FALSE;
+	bBatchValid	= FALSE;
+}
+
+/**
+ * Answers an actor line check of ULevel::MultiLineCheck from the running batch, filtering
+ * the candidates the same way FOctreeNode::ActorNonZeroExtentLineCheck does.
+ *
+ * @param	OutResult	[out] Hits, in the same format FPrimitiveHashBase::ActorLineCheck returns
+ * @return	FALSE if the batch can't answer the query and the octree has to be checked
+ */
+UBOOL FActorMoveCache::ActorLineCheck( FMemStack& Mem, const FVector& End, const FVector& Start, const FVector& Extent, DWORD TraceFlags, AActor* SourceActor, FCheckResult*& OutResult )
+{
+	// Zero extent checks and single results use octree specific traversal order.
+	if( !bBatchValid || !SourceActor || Extent.IsZero() || (TraceFlags & TRACE_SingleResult) )
+	{
+		return FALSE;
+	}
+
+	FBox CheckBox( 0 );
+	CheckBox += Start;
+	CheckBox += End;
+	CheckBox.Min -= Extent;
+	CheckBox.Max += Extent;
+	if( !BatchContains(CheckBox) )
+	{
+		return FALSE;
+	}
+
+	OutResult = NULL;
+	for( INT PrimitiveIndex=0; PrimitiveIndex<BatchPrimitives.Num(); PrimitiveIndex++ )
+	{
+		UPrimitiveComponent*	Primitive	= BatchPrimitives(PrimitiveIndex);
+		AActor*					Owner		= Primitive->Owner;
+		if( !Owner
+		||	!Primitive->ShouldCollide()
+		||	!Primitive->BlockNonZeroExtent
+		||	Owner == SourceActor
+		||	SourceActor->IsOwnedBy(Owner)
+		||	!Owner->ShouldTrace(Primitive, SourceActor, TraceFlags) )
+		{
+			continue;
+		}
+
+		// Batch actors have moved since the candidates were gathered, so test their current bounds.
+		const FVector PrimitiveExtent = Primitive->Bounds.BoxExtent + Extent;
+		if( !FBox( Primitive->Bounds.Origin - PrimitiveExtent, Primitive->Bounds.Origin + PrimitiveExtent ).Intersect( CheckBox ) )
+		{
+			continue;
+		}
+
+		FCheckResult TestHit(0);
+		if( Primitive->LineCheck( TestHit, End, Start, Extent, TraceFlags ) == 0 )
+		{
+			FCheckResult* NewResult	= new(Mem) FCheckResult(TestHit);
+			NewResult->GetNext()	= OutResult;
+			OutResult				= NewResult;
+			if( TraceFlags & TRACE_StopAtFirstHit )
+			{
+				break;
+			}
+		}
+	}
+	GCollisionStats.OctreeQueriesAvoided.Value++;
+	return TRUE;
+}
+
+/**
+ * Answers an encroachment check of ULevel::CheckEncroachment from the running batch,
+ * filtering the candidates the same way FOctreeNode::ActorEncroachmentCheck does.
+ *
+ * @param	OutResult	[out] Hits, in the same format FPrimitiveHashBase::ActorEncroachmentCheck returns
+ * @return	FALSE if the batch can't answer the query and the octree has to be checked
+ */
+UBOOL FActorMoveCache::ActorEncroachmentCheck( FMemStack& Mem, AActor* Actor, FVector Location, FRotator Rotation, DWORD TraceFlags, FCheckResult*& OutResult )
+{
+	if( !bBatchValid || !Actor->CollisionComponent || !Actor->CollisionComponent->IsValidComponent() )
+	{
+		return FALSE;
+	}
+
+	// Like the octree, checks against the bounds the collision component had before the move.
+	check(Actor->CollisionComponent->Initialized);
+	const FBox CheckBox = Actor->CollisionComponent->Bounds.GetBox();
+	if( !BatchContains(CheckBox) )
+	{
+		return FALSE;
+	}
+
+	OutResult = NULL;
+	Exchange( Location, Actor->Location );
+	Exchange( Rotation, Actor->Rotation );
+
+	// Overlaps are tested per actor, so each owner is only tested once.
+	TFrameArray<AActor*> TestedOwners( BatchPrimitives.Num() );
+	for( INT PrimitiveIndex=0; PrimitiveIndex<BatchPrimitives.Num(); PrimitiveIndex++ )
+	{
+		UPrimitiveComponent*	Primitive	= BatchPrimitives(PrimitiveIndex);
+		AActor*					Owner		= Primitive->Owner;
+		if( !Owner
+		||	!Primitive->ShouldCollide()
+		||	Owner->IsBasedOn(Actor)
+		||	!Owner->ShouldTrace(Primitive, Actor, TraceFlags)
+		||	((Actor->Physics == PHYS_Interpolating) && Owner->bWorldGeometry)
+		||	!Primitive->Bounds.GetBox().Intersect( CheckBox )
+		||	TestedOwners.ContainsItem(Owner) )
+		{
+			continue;
+		}
+		TestedOwners.AddItem( Owner );
+
+		FCheckResult TestHit(1.f);
+		if( Actor->IsOverlapping( Owner, &TestHit ) )
+		{
+			TestHit.Actor			= Owner;
+			FCheckResult* NewResult	= new(Mem) FCheckResult(TestHit);
+			NewResult->GetNext()	= OutResult;
+			OutResult				= NewResult;
+		}
+	}
+
+	Exchange( Location, Actor->Location );
+	Exchange( Rotation, Actor->Rotation );
+
+	GCollisionStats.OctreeQueriesAvoided.Value++;
+	return TRUE;
+}
+
+/**
+ * Drops all cached overlaps.
+ */
+void FActorMoveCache::InvalidateOverlaps()
+{
+	Overlaps.Empty( Overlaps.Num() );
+	FirstOverlaps.Empty();
+}
+
+/**
+ * Returns whether the overlap of two actors only depends on their placement. Articulated
+ * and rigid body actors are tested against primitives that animate or simulate in place.
+ */
+UBOOL FActorMoveCache::CanCacheOverlap( AActor* Actor, AActor* Other )
+{
+	return	Actor->Physics != PHYS_Articulated && Actor->Physics != PHYS_RigidBody &&
+			Other->Physics != PHYS_Articulated && Other->Physics != PHYS_RigidBody;
+}
+
+/**
+ * Returns whether an actor overlaps another, reusing the result of an earlier test this
+ * tick if neither actor has changed since.
+ */
+UBOOL FActorMoveCache::IsOverlapping( AActor* Actor, AActor* Other )
+{
+	if( !CanCacheOverlap( Actor, Other ) )
+	{
+		return Actor->IsOverlapping( Other );
+	}
+
+	INT* FirstEntry = FirstOverlaps.Find( Actor );
+	for( INT EntryIndex=FirstEntry ? *FirstEntry : INDEX_NONE; EntryIndex!=INDEX_NONE; EntryIndex=Overlaps(EntryIndex).NextEntry )
+	{
+		FOverlapEntry& Entry = Overlaps(EntryIndex);
+		if( Entry.Other == Other )
+		{
+			const FActorPlacement ActorPlacement( Actor );
+			const FActorPlacement OtherPlacement( Other );
+			if( Entry.ActorPlacement == ActorPlacement && Entry.OtherPlacement == OtherPlacement )
+			{
+				GCollisionStats.OverlapTestsAvoided.Value++;
+				return Entry.bOverlapping;
+			}
+			Entry.ActorPlacement	= ActorPlacement;
+			Entry.OtherPlacement	= OtherPlacement;
+			Entry.bOverlapping		= Actor->IsOverlapping( Other );
+			return Entry.bOverlapping;
+		}
+	}
+
+	const INT		EntryIndex	= Overlaps.Num();
+	FOverlapEntry*	Entry		= new(Overlaps) FOverlapEntry( Actor, Other );
+	Entry->bOverlapping			= Actor->IsOverlapping( Other );
+	Entry->NextEntry			= FirstEntry ? *FirstEntry : INDEX_NONE;
+	FirstOverlaps.Set( Actor, EntryIndex );
+	return Entry->bOverlapping;
+}
+
+/**
+ * Removes all references to actors that are about to be deleted.
+ */
+void FActorMoveCache::CleanupDestroyed()
+{
+	for( INT EntryIndex=0; EntryIndex<Overlaps.Num(); EntryIndex++ )
+	{
+		if( Overlaps(EntryIndex).Other->bDeleteMe )
+		{
+			InvalidateOverlaps();
+			break;
+		}
+	}
+	for( TMap<AActor*,INT>::TIterator It(FirstOverlaps); It; ++It )
+	{
+		if( It.Key()->bDeleteMe )
+		{
+			InvalidateOverlaps();
+			break;
+		}
+	}
+	if( bBatching )
+	{
+		InvalidateBatch();
+	}
+}
+
+/*-----------------------------------------------------------------------------
+	FActorMoveCache::FActorPlacement implementation.
+-----------------------------------------------------------------------------*/
+
+FActorMoveCache::FActorPlacement::FActorPlacement( AActor* Actor )
+:	Location( Actor->Location )
+,	Rotation( Actor->Rotation )
+,	BoundsOrigin( 0, 0, 0 )
+,	BoundsExtent( 0, 0, 0 )
+,	Base( Actor->Base )
+,	bCollideActors( Actor->bCollideActors )
+{
+	if( Actor->CollisionComponent )
+	{
+		BoundsOrigin = Actor->CollisionComponent->Bounds.Origin;
+		BoundsExtent = Actor->CollisionComponent->Bounds.BoxExtent;
+	}
+}
+
+UBOOL FActorMoveCache::FActorPlacement::operator==( const FActorPlacement& Other ) const
+{
+	return	Location == Other.Location
+		&&	Rotation == Other.Rotation
+		&&	BoundsOrigin == Other.BoundsOrigin
+		&&	BoundsExtent == Other.BoundsExtent
+		&&	Base == Other.Base
+		&&	bCollideActors == Other.bCollideActors;
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -186,6 +186,7 @@ NOTE THAT NavigationPoints should not be destroyed during gameplay!!!
 void ANavigationPoint::Destroy()
 {
 	AActor::Destroy();
+	FNavigationGraph::Invalidate();
 
 	if ( !Level->bBegunPlay && GIsEditor )
 	{
@@ -345,52 +346,52 @@ void ANavigationPoint::addReachSpecs(AScout *Scout, UBOOL bOnlyChanged)
 	}
 
 	// try to build a spec to every other pathnode in the level
+	TArray<ANavigationPoint*> AllCandidates;
+	const TArray<ANavigationPoint*>* Candidates = FPathBuilder::FindReachCandidates(this);
+	if ( !Candidates )
+	{
+		for (ANavigationPoint *Nav = Level->NavigationPointList; Nav != NULL; Nav = Nav->nextNavigationPoint)
+		{
+			if ( FPathBuilder::IsReachCandidate(this, Nav, bOnlyChanged) )
+			{
+				AllCandidates.AddItem(Nav);
+			}
+		}
+		Candidates = &AllCandidates;
+	}
+
 	UReachSpec *newSpec = ConstructObject<UReachSpec>(UReachSpec::StaticClass(),GetLevel()->GetOuter(),NAME_None,RF_Public);
 	newSpec->Init();
-	for (ANavigationPoint *Nav = Level->NavigationPointList; Nav != NULL; Nav = Nav->nextNavigationPoint)
+	for (INT CandidateIndex = 0; CandidateIndex < Candidates->Num(); CandidateIndex++)
 	{
-		if (Nav != NULL &&
-			!Nav->bDeleteMe &&
-			!Nav->bNoAutoConnect &&
-			!Nav->bSourceOnly &&
-			(Nav->Location - Location).SizeSquared() <= MAXPATHDISTSQ &&
-			Nav != this &&
-			(!bOnlyChanged || bPathsChanged || Nav->bPathsChanged) )
+		ANavigationPoint *Nav = (*Candidates)(CandidateIndex);
+		INT Proscribed = ProscribedPathTo(Nav);
+		if (Proscribed == 2)
+		{
+			ProscribePathTo(Nav,Scout);
+		}
+		else
 		{
-			//@fixme - find a better way to handle this
-			// don't connect cover to cover, only cover to normal nodes
-			if (!IsA(ACoverNode::StaticClass()) || 
-				!Nav->IsA(ACoverNode::StaticClass()))
+			// check if forced path
+			UBOOL bForced = 0;
+			for (INT idx = 0; idx < ForcedPaths.Num() && !bForced; idx++)
 			{
-				INT Proscribed = ProscribedPathTo(Nav);
-				if (Proscribed == 2)
+				if (Nav == ForcedPaths(idx))
 				{
-					ProscribePathTo(Nav,Scout);
-				}
-				else
-				{
-					// check if forced path
-					UBOOL bForced = 0;
-					for (INT idx = 0; idx < ForcedPaths.Num() && !bForced; idx++)
-					{
-						if (Nav == ForcedPaths(idx))
-						{
-							bForced = 1;
-						}
-					}
-					if ( bForced )
-					{
-						ForcePathTo(Nav,Scout);
-					}
-					else
-					if ( !bDestinationOnly && !Proscribed && newSpec->defineFor(this, Nav, Scout) )
-					{
-						debugf(TEXT("***********added new spec from %s to %s"),GetName(),Nav->GetName());
-						PathList.AddItem(newSpec);
-						newSpec = ConstructObject<UReachSpec>(UReachSpec::StaticClass(),GetLevel()->GetOuter(),NAME_None,RF_Public);
-					}
+					bForced = 1;
 				}
 			}
+			if ( bForced )
+			{
+				ForcePathTo(Nav,Scout);
+			}
+			else
+			if ( !bDestinationOnly && !Proscribed && FPathBuilder::DefineReachSpec(newSpec, this, Nav, Candidates != &AllCandidates ? CandidateIndex : INDEX_NONE, Scout) )
+			{
+				debugf(TEXT("***********added new spec from %s to %s"),GetName(),Nav->GetName());
+				PathList.AddItem(newSpec);
+				newSpec = ConstructObject<UReachSpec>(UReachSpec::StaticClass(),GetLevel()->GetOuter(),NAME_None,RF_Public);
+			}
 		}
 	}
 }
@@ -526,19 +527,15 @@ void AJumpPad::addReachSpecs(AScout *Scout, UBOOL bOnlyChanged)
 }
 
 /* ClearForPathFinding()
-clear transient path finding properties right before a navigation network search
+consume transient path finding properties right before a navigation network search
+(search state itself is kept by FPathQuery)
 */
 void ANavigationPoint::ClearForPathFinding()
 {
-	visitedWeight = 10000000;
-	nextOrdered = NULL;
-	prevOrdered = NULL;
-	previousPath = NULL;
 	bEndPoint = bTransientEndPoint;
 	bTransientEndPoint = false;
 	cost = ExtraCost + TransientCost + FearCost;
 	TransientCost = 0;
-	bAlreadyVisited = false;
 }
 
 /* ClearPaths()
@@ -139,6 +139,8 @@ void UNetDriver::AssertValid()
 }
 void UNetDriver::TickFlush()
 {
+	MEMORY_TAG_SCOPE(Net);
+
 	// Poll all sockets.
 	if( ServerConnection )
 		ServerConnection->Tick();
@@ -158,6 +160,8 @@ UBOOL UNetDriver::InitListen( FNetworkNotify* InNotify, FURL& URL, FString& Erro
 }
 void UNetDriver::TickDispatch( FLOAT DeltaTime )
 {
+	MEMORY_TAG_SCOPE(Net);
+
 	SendCycles=RecvCycles=0;
 
 	// Get new time.
@@ -378,7 +378,7 @@ void FParticleEmitterInstance::Tick(FLOAT DeltaTime, UBOOL bSuppressSpawning)
 		if (Template->EmitterLoops == 0 || SecondsSinceCreation < (Template->EmitterDuration * Template->EmitterLoops))
 		{
 			// Figure out spawn rate for this tick.
-			FLOAT SpawnRate = Template->SpawnRate->GetValue(EmitterTime);
+			FLOAT SpawnRate = Template->SpawnRate->GetBakedValue(EmitterTime);
 
 			// Spawn new particles...
 			if (SpawnRate > 0.f)
@@ -80,6 +80,32 @@ static FColor ColorFromVector(const FVector& ColorVec)
 	return Color;
 }
 
+/**
+ * Values of a distribution over particle life for all active particles of an emitter
+ * instance, evaluated in one batch through the distribution's lookup table. Indexed like
+ * the particles visited by BEGIN_UPDATE_LOOP, lives in the frame arena.
+ */
+template<class DistributionType,class ValueType> class TParticleLifeValues : public TFrameArray<ValueType>
+{
+public:
+	TParticleLifeValues( FParticleEmitterInstance* Owner, DistributionType* Distribution )
+	:	TFrameArray<ValueType>( Owner->ActiveParticles )
+	{
+		const INT NumParticles = Owner->ActiveParticles;
+		this->Add( NumParticles );
+		if( NumParticles > 0 )
+		{
+			TFrameArray<FLOAT> RelativeTimes( NumParticles );
+			RelativeTimes.Add( NumParticles );
+			for( INT i=0; i<NumParticles; i++ )
+			{
+				RelativeTimes(i) = ((FBaseParticle*) (Owner->ParticleData + Owner->ParticleIndices[i] * Owner->ParticleStride))->RelativeTime;
+			}
+			Distribution->GetBakedValues( NumParticles, &RelativeTimes(0), &(*this)(0) );
+		}
+	}
+};
+
 
 /*-----------------------------------------------------------------------------
 	UParticleModule implementation.
@@ -204,11 +230,11 @@ void UParticleModuleLocation::Spawn( FParticleEmitterInstance* Owner, INT Offset
 	SPAWN_INIT;
 	if (Owner->Template->UseLocalSpace)
 	{
-		Particle.Location += StartLocation->GetValue( Owner->EmitterTime );
+		Particle.Location += StartLocation->GetBakedValue( Owner->EmitterTime );
 	}
 	else
 	{
-		FVector StartLoc = StartLocation->GetValue(Owner->EmitterTime);
+		FVector StartLoc = StartLocation->GetBakedValue(Owner->EmitterTime);
 		StartLoc = Owner->Component->LocalToWorld.TransformNormal(StartLoc);
 		Particle.Location += StartLoc;
 	}
@@ -237,7 +263,7 @@ void UParticleModuleLocation::Render3DPreview(FParticleEmitterInstance* Owner, c
         UDistributionVectorConstantCurve* Curve = CastChecked<UDistributionVectorConstantCurve>(StartLocation);
 
         //Curve->
-		Position = StartLocation->GetValue(0.0f);
+		Position = StartLocation->GetBakedValue(0.0f);
     }
 
 	PRI->DrawWireStar(Position, 10.0f, ModuleEditorColor);
@@ -251,7 +277,7 @@ IMPLEMENT_CLASS(UParticleModuleLocation);
 void UParticleModuleMeshRotation::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-        FVector Rotation = StartRotation->GetValue(Owner->EmitterTime);
+        FVector Rotation = StartRotation->GetBakedValue(Owner->EmitterTime);
         FVector* pkVectorData = (FVector*)((BYTE*)&Particle + Owner->PayloadOffset);
         // FVector  MeshRotation
         // FVector  MeshRotationRate
@@ -270,7 +296,7 @@ IMPLEMENT_CLASS(UParticleModuleMeshRotation);
 void UParticleModuleMeshRotationRate::Spawn(FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime)
 {
 	SPAWN_INIT;
-		FVector StartRate = StartRotationRate->GetValue(Owner->EmitterTime);// * ((FLOAT)PI/180.f);
+		FVector StartRate = StartRotationRate->GetBakedValue(Owner->EmitterTime);// * ((FLOAT)PI/180.f);
         FVector* pkVectorData = (FVector*)((BYTE*)&Particle + Owner->PayloadOffset);
         // FVector  MeshRotation
         // FVector  MeshRotationRate
@@ -292,7 +318,7 @@ IMPLEMENT_CLASS(UParticleModuleMeshRotationRate);
 void UParticleModuleRotation::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-	Particle.Rotation += (PI/180.f) * 360.0f * StartRotation->GetValue( Owner->EmitterTime );
+	Particle.Rotation += (PI/180.f) * 360.0f * StartRotation->GetBakedValue( Owner->EmitterTime );
 }
 IMPLEMENT_CLASS(UParticleModuleRotation);
 
@@ -304,7 +330,7 @@ IMPLEMENT_CLASS(UParticleModuleRotation);
 void UParticleModuleRotationRate::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-	FLOAT StartRotRate = (PI/180.f) * 360.0f * StartRotationRate->GetValue( Owner->EmitterTime );
+	FLOAT StartRotRate = (PI/180.f) * 360.0f * StartRotationRate->GetBakedValue( Owner->EmitterTime );
 	Particle.RotationRate += StartRotRate;
 	Particle.BaseRotationRate += StartRotRate;
 }
@@ -315,8 +341,9 @@ IMPLEMENT_CLASS(UParticleModuleRotationRate);
 -----------------------------------------------------------------------------*/
 void UParticleModuleRotationOverLifetime::Update(FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime)
 {
+	TParticleLifeValues<UDistributionFloat,FLOAT> Rotations( Owner, RotationOverLife );
 	BEGIN_UPDATE_LOOP;
-		FLOAT Rotation = RotationOverLife->GetValue(Particle.RelativeTime);
+		FLOAT Rotation = Rotations(i);
 		// For now, we are just using the X-value
 		Particle.Rotation	*= Rotation * (PI/180.f) * 360.0f;
 	END_UPDATE_LOOP;
@@ -330,7 +357,7 @@ IMPLEMENT_CLASS(UParticleModuleRotationOverLifetime);
 void UParticleModuleSize::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-	FVector Size		 = StartSize->GetValue( Owner->EmitterTime );
+	FVector Size		 = StartSize->GetBakedValue( Owner->EmitterTime );
 	Particle.Size		+= Size;
 	Particle.BaseSize	+= Size;
 }
@@ -343,7 +370,7 @@ IMPLEMENT_CLASS(UParticleModuleSize);
 void UParticleModuleSizeMultiplyVelocity::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-	FVector SizeScale = VelocityMultiplier->GetValue( Particle.RelativeTime ) * Particle.Velocity.Size();
+	FVector SizeScale = VelocityMultiplier->GetBakedValue( Particle.RelativeTime ) * Particle.Velocity.Size();
 	if( MultiplyX )
 		Particle.Size.X *= SizeScale.X;
 	if( MultiplyY )
@@ -354,8 +381,9 @@ void UParticleModuleSizeMultiplyVelocity::Spawn( FParticleEmitterInstance* Owner
 
 void UParticleModuleSizeMultiplyVelocity::Update( FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime )
 {
+	TParticleLifeValues<UDistributionVector,FVector> Multipliers( Owner, VelocityMultiplier );
 	BEGIN_UPDATE_LOOP;
-		FVector SizeScale = VelocityMultiplier->GetValue( Particle.RelativeTime ) * Particle.Velocity.Size();
+		FVector SizeScale = Multipliers(i) * Particle.Velocity.Size();
 		if( MultiplyX )
 			Particle.Size.X *= SizeScale.X;
 		if( MultiplyY )
@@ -373,7 +401,7 @@ IMPLEMENT_CLASS(UParticleModuleSizeMultiplyVelocity);
 void UParticleModuleSizeMultiplyLife::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-	FVector SizeScale = LifeMultiplier->GetValue( Particle.RelativeTime );
+	FVector SizeScale = LifeMultiplier->GetBakedValue( Particle.RelativeTime );
 	if( MultiplyX )
 		Particle.Size.X *= SizeScale.X;
 	if( MultiplyY )
@@ -384,8 +412,9 @@ void UParticleModuleSizeMultiplyLife::Spawn( FParticleEmitterInstance* Owner, IN
 
 void UParticleModuleSizeMultiplyLife::Update( FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime )
 {
+	TParticleLifeValues<UDistributionVector,FVector> Multipliers( Owner, LifeMultiplier );
 	BEGIN_UPDATE_LOOP;
-		FVector SizeScale = LifeMultiplier->GetValue( Particle.RelativeTime );
+		FVector SizeScale = Multipliers(i);
 		if( MultiplyX )
 			Particle.Size.X *= SizeScale.X;
 		if( MultiplyY )
@@ -401,8 +430,9 @@ IMPLEMENT_CLASS(UParticleModuleSizeMultiplyLife);
 -----------------------------------------------------------------------------*/
 void UParticleModuleSizeScale::Update( FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime )
 {
+	TParticleLifeValues<UDistributionVector,FVector> ScaleFactors( Owner, SizeScale );
 	BEGIN_UPDATE_LOOP;
-		FVector ScaleFactor = SizeScale->GetValue(Particle.RelativeTime);
+		FVector ScaleFactor = ScaleFactors(i);
 		Particle.Size = Particle.BaseSize * ScaleFactor;
 	END_UPDATE_LOOP;
 }
@@ -446,7 +476,7 @@ void UParticleModuleSubUV::Update( FParticleEmitterInstance* Owner, INT Offset,
 
 		if ((eMethod == PSSUVIM_Linear) || (eMethod == PSSUVIM_Linear_Blend))
 		{
-			fInterp = SubImageIndex->GetValue(Particle.RelativeTime);
+			fInterp = SubImageIndex->GetBakedValue(Particle.RelativeTime);
 			// Assuming a 0..<# sub images> range here...
 			iImageIndex = (INT)fInterp;
 			iImageIndex = Clamp(iImageIndex, 0, iTotalSubImages - 1);
@@ -517,14 +547,15 @@ void UParticleModuleSubUV::Update( FParticleEmitterInstance* Owner, INT Offset,
 void UParticleModuleRotationRateMultiplyLife::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-	FLOAT RateScale = LifeMultiplier->GetValue( Particle.RelativeTime );
+	FLOAT RateScale = LifeMultiplier->GetBakedValue( Particle.RelativeTime );
 	Particle.RotationRate *= RateScale;
 }
 
 void UParticleModuleRotationRateMultiplyLife::Update( FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime )
 {
+	TParticleLifeValues<UDistributionFloat,FLOAT> RateScales( Owner, LifeMultiplier );
 	BEGIN_UPDATE_LOOP;
-		FLOAT RateScale = LifeMultiplier->GetValue( Particle.RelativeTime );
+		FLOAT RateScale = RateScales(i);
 		Particle.RotationRate *= RateScale;
 	END_UPDATE_LOOP;
 }
@@ -538,7 +569,7 @@ void UParticleModuleAcceleration::Spawn( FParticleEmitterInstance* Owner, INT Of
 {
 	SPAWN_INIT;
 	PARTICLE_ELEMENT( FVector, UsedAcceleration );
-	UsedAcceleration = Acceleration->GetValue(Owner->EmitterTime);
+	UsedAcceleration = Acceleration->GetBakedValue(Owner->EmitterTime);
 	Particle.Velocity		+= UsedAcceleration * SpawnTime;
 	Particle.BaseVelocity	+= UsedAcceleration * SpawnTime;
 }
@@ -564,9 +595,10 @@ IMPLEMENT_CLASS(UParticleModuleAcceleration);
 -----------------------------------------------------------------------------*/
 void UParticleModuleAccelerationOverLifetime::Update( FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime )
 {
+	TParticleLifeValues<UDistributionVector,FVector> Accels( Owner, AccelOverLife );
 	BEGIN_UPDATE_LOOP;
 		// Acceleration should always be in world space...
-		FVector Accel = AccelOverLife->GetValue(Particle.RelativeTime);
+		FVector Accel = Accels(i);
 		Particle.Velocity		+= Accel * DeltaTime;
 		Particle.BaseVelocity	+= Accel * DeltaTime;
 	END_UPDATE_LOOP;
@@ -691,7 +723,7 @@ void UParticleModuleVelocity::Spawn( FParticleEmitterInstance* Owner, INT Offset
 	SPAWN_INIT;
 
 	FVector FromOrigin;
-	FVector Vel = StartVelocity->GetValue( Owner->EmitterTime );
+	FVector Vel = StartVelocity->GetBakedValue( Owner->EmitterTime );
 	if(Owner->Template->UseLocalSpace)
 	{
 		FromOrigin = Particle.Location.SafeNormal();
@@ -702,7 +734,7 @@ void UParticleModuleVelocity::Spawn( FParticleEmitterInstance* Owner, INT Offset
 		Vel = Owner->Component->LocalToWorld.TransformNormal(Vel);
 	}
 
-	Vel += FromOrigin * StartVelocityRadial->GetValue(Owner->EmitterTime);
+	Vel += FromOrigin * StartVelocityRadial->GetBakedValue(Owner->EmitterTime);
 	Particle.Velocity		+= Vel;
 	Particle.BaseVelocity	+= Vel;
 
@@ -737,8 +769,9 @@ IMPLEMENT_CLASS(UParticleModuleVelocityInheritParent);
 -----------------------------------------------------------------------------*/
 void UParticleModuleVelocityOverLifetime::Update(FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime)
 {
+	TParticleLifeValues<UDistributionVector,FVector> Vels( Owner, VelOverLife );
 	BEGIN_UPDATE_LOOP;
-		FVector Vel = VelOverLife->GetValue(Particle.RelativeTime);
+		FVector Vel = Vels(i);
 		Particle.Velocity		*= Vel;
 	END_UPDATE_LOOP;
 }
@@ -751,7 +784,7 @@ IMPLEMENT_CLASS(UParticleModuleVelocityOverLifetime);
 void UParticleModuleColor::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-	FVector ColorVec = StartColor->GetValue( Owner->EmitterTime );
+	FVector ColorVec = StartColor->GetBakedValue( Owner->EmitterTime );
 	Particle.Color = ColorFromVector(ColorVec);
 }
 IMPLEMENT_CLASS(UParticleModuleColor);
@@ -791,14 +824,15 @@ void UParticleModuleColorByParameter::Spawn( FParticleEmitterInstance* Owner, IN
 void UParticleModuleColorOverLife::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-	FVector ColorVec = ColorOverLife->GetValue( Particle.RelativeTime );
+	FVector ColorVec = ColorOverLife->GetBakedValue( Particle.RelativeTime );
 	Particle.Color = ColorFromVector(ColorVec);
 }
 
 void UParticleModuleColorOverLife::Update( FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime )
 {
+	TParticleLifeValues<UDistributionVector,FVector> ColorVecs( Owner, ColorOverLife );
 	BEGIN_UPDATE_LOOP;
-		FVector ColorVec = ColorOverLife->GetValue( Particle.RelativeTime );
+		FVector ColorVec = ColorVecs(i);
 		Particle.Color = ColorFromVector(ColorVec);
 	END_UPDATE_LOOP;
 }
@@ -811,7 +845,7 @@ IMPLEMENT_CLASS(UParticleModuleColorOverLife);
 void UParticleModuleLifetime::Spawn( FParticleEmitterInstance* Owner, INT Offset, FLOAT SpawnTime )
 {
 	SPAWN_INIT;
-	FLOAT MaxLifetime = Lifetime->GetValue( Owner->EmitterTime );
+	FLOAT MaxLifetime = Lifetime->GetBakedValue( Owner->EmitterTime );
 	if( Particle.OneOverMaxLifetime > 0.f )
 	{
 		// Another module already modified lifetime.
@@ -896,7 +930,7 @@ void UParticleModuleAttractorLine::Update(FParticleEmitterInstance* Owner, INT O
         if (bProcess)
         {
             // Look up the Range and Strength at that position on the line
-            FLOAT AttractorRange = Range->GetValue(fRatio);
+            FLOAT AttractorRange = Range->GetBakedValue(fRatio);
             
             FVector LineToPoint = AdjustedLocation - ProjectedParticle;
     		FLOAT Distance = LineToPoint.Size();
@@ -904,7 +938,7 @@ void UParticleModuleAttractorLine::Update(FParticleEmitterInstance* Owner, INT O
             if (Distance <= AttractorRange)
             {
                 // Adjust the strength based on the range ratio
-                FLOAT AttractorStrength = Strength->GetValue((AttractorRange - Distance) / AttractorRange);
+                FLOAT AttractorStrength = Strength->GetBakedValue((AttractorRange - Distance) / AttractorRange);
                 FVector Direction = LineToPoint^Line;
     			// Adjust the VELOCITY of the particle based on the attractor... 
         		Particle.Velocity += Direction * AttractorStrength * DeltaTime;
@@ -918,7 +952,7 @@ void UParticleModuleAttractorLine::Render3DPreview(FParticleEmitterInstance* Own
     PRI->DrawLine(EndPoint0, EndPoint1, ModuleEditorColor);
 
     FLOAT CurrRatio = Owner->EmitterTime / Owner->Template->EmitterDuration;
-    FLOAT LineRange = Range->GetValue(CurrRatio);
+    FLOAT LineRange = Range->GetBakedValue(CurrRatio);
 
     // Determine the position of the range at this time.
     FVector LinePos = EndPoint0 + CurrRatio * (EndPoint1 - EndPoint0);
@@ -942,8 +976,8 @@ void UParticleModuleAttractorPoint::Spawn(FParticleEmitterInstance* Owner, INT O
 void UParticleModuleAttractorPoint::Update(FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime)
 {
 	// Grab the position of the attractor in Emitter time???
-	FVector AttractorPosition = Position->GetValue(Owner->EmitterTime);
-    FLOAT AttractorRange = Range->GetValue(Owner->EmitterTime);
+	FVector AttractorPosition = Position->GetBakedValue(Owner->EmitterTime);
+    FLOAT AttractorRange = Range->GetBakedValue(Owner->EmitterTime);
 
 	BEGIN_UPDATE_LOOP;
 		// If the particle is within range...
@@ -957,12 +991,12 @@ void UParticleModuleAttractorPoint::Update(FParticleEmitterInstance* Owner, INT
             if (StrengthByDistance)
             {
                 // on actual distance
-			    AttractorStrength = Strength->GetValue((AttractorRange - Distance) / AttractorRange);
+			    AttractorStrength = Strength->GetBakedValue((AttractorRange - Distance) / AttractorRange);
             }
             else
             {
                 // on emitter time
-                AttractorStrength = Strength->GetValue(Owner->EmitterTime);
+                AttractorStrength = Strength->GetBakedValue(Owner->EmitterTime);
             }
 
 			// Adjust the VELOCITY of the particle based on the attractor... 
@@ -974,9 +1008,9 @@ void UParticleModuleAttractorPoint::Update(FParticleEmitterInstance* Owner, INT
 
 void UParticleModuleAttractorPoint::Render3DPreview(FParticleEmitterInstance* Owner, const FSceneContext& Context,FPrimitiveRenderInterface* PRI)
 {
-    FVector PointPos = Position->GetValue(Owner->EmitterTime);
+    FVector PointPos = Position->GetBakedValue(Owner->EmitterTime);
 //    FLOAT PointStr = Strength->GetValue(Owner->EmitterTime);
-    FLOAT PointRange = Range->GetValue(Owner->EmitterTime);
+    FLOAT PointRange = Range->GetBakedValue(Owner->EmitterTime);
 
     // Draw a wire star at the position.
 	PRI->DrawWireStar(PointPos, 10.0f, ModuleEditorColor);
@@ -1039,8 +1073,8 @@ void UParticleModuleCollision::Spawn( FParticleEmitterInstance* Owner, INT Offse
 	SPAWN_INIT;
 	PARTICLE_ELEMENT( FVector,	UsedDampingFactor );
 	PARTICLE_ELEMENT( INT,		UsedMaxCollisions );
-	UsedDampingFactor	= DampingFactor->GetValue( Owner->EmitterTime );
-	UsedMaxCollisions	= MaxCollisions->GetValue( Owner->EmitterTime );
+	UsedDampingFactor	= DampingFactor->GetBakedValue( Owner->EmitterTime );
+	UsedMaxCollisions	= MaxCollisions->GetBakedValue( Owner->EmitterTime );
 }
 
 void UParticleModuleCollision::Update( FParticleEmitterInstance* Owner, INT Offset, FLOAT DeltaTime )
@@ -1077,7 +1111,7 @@ void UParticleModuleCollision::Update( FParticleEmitterInstance* Owner, INT Offs
 				if (bApplyPhysics && Hit.Component)
 				{
 					FVector vImpulse;
-					vImpulse = -(vNewVelocity - vOldVelocity) * ParticleMass->GetValue(Particle.RelativeTime);
+					vImpulse = -(vNewVelocity - vOldVelocity) * ParticleMass->GetBakedValue(Particle.RelativeTime);
 					Hit.Component->AddImpulse(vImpulse, Hit.Location, Hit.BoneName);
 				}
 
@@ -30,6 +30,7 @@
 
 #include "EnginePrivate.h"
 #include "UnPath.h"
+#include "UnPawnMovement.h"
 #include "EngineAIClasses.h"
 #include "EngineSequenceClasses.h"
 #include "EngineInterpolationClasses.h"
@@ -77,6 +78,7 @@ void FPathBuilder::undefinePaths (ULevel *ownerLevel, UBOOL bOnlyChanged)
 	}
 
 	Level->GetLevelInfo()->bPathsRebuilt = 0;
+	FNavigationGraph::Invalidate();
 	GWarn->EndSlowTask();
 }
 
@@ -277,6 +279,7 @@ void FPathBuilder::definePaths(ULevel *ownerLevel, UBOOL bOnlyChanged)
 		}
 		// calculate and add reachspecs to pathnodes
 		debugf(NAME_DevPath,TEXT("Add reachspecs"));
+		GatherReachCandidates(bOnlyChanged);
 		NumDone = 0;
 		for( ANavigationPoint *Nav=Level->GetLevelInfo()->NavigationPointList; Nav; Nav=Nav->nextNavigationPoint )
 		{
@@ -293,6 +296,7 @@ void FPathBuilder::definePaths(ULevel *ownerLevel, UBOOL bOnlyChanged)
 				debugf( NAME_DevPath, TEXT("Skipped unchanged pathnode %s"),Nav->GetName() );
 			}
 		}
+		EmptyReachCandidates();
 		//prune excess reachspecs
 		debugf(NAME_DevPath,TEXT("Prune reachspecs"));
 		INT numPruned = 0;
@@ -438,6 +442,9 @@ void FPathBuilder::buildCover(ULevel *ownerLevel)
 
 		GWarn->EndSlowTask();
 	}
+
+	// path searches need to pick up the new network
+	FNavigationGraph::Invalidate();
 }
 
 //------------------------------------------------------------------------------------------------
@@ -525,6 +532,323 @@ FVector ALadderVolume::FindTop(FVector V)
 
 AScout* FPathBuilder::Scout = NULL;
 
+/** Reach candidates per navigation point, see FPathBuilder::GatherReachCandidates */
+static TArray<TArray<ANavigationPoint*> > GReachCandidates;
+/** Index into GReachCandidates of each navigation point candidates were gathered for */
+static TMap<ANavigationPoint*,INT> GReachCandidateIndices;
+/** Largest path size index the scout can walk straight to each candidate with, INDEX_NONE if the scout has to find out */
+static TArray<TArray<INT> > GReachWalkSizes;
+
+IMPLEMENT_COMPARE_CONSTREF( INT, UnPath, { return A - B; } )
+
+/**
+ * Returns the key of the grid cell a location falls into. Cells are MAXPATHDIST wide
+ * so all navigation points within path distance are in the same or adjacent cells.
+ */
+static QWORD GetReachGridKey( INT X, INT Y, INT Z )
+{
+	return ((QWORD)(X & 0x1FFFFF) << 42) | ((QWORD)(Y & 0x1FFFFF) << 21) | (QWORD)(Z & 0x1FFFFF);
+}
+
+/**
+ * Gathers the reach candidates of a navigation point from the grid cells around it.
+ * Candidates are kept in NavigationPointList order so reach specs are defined in the
+ * same order as when walking the whole list.
+ */
+static void GatherReachCandidatesFor( ANavigationPoint* Start, const TArray<ANavigationPoint*>& Navs, const TMap<QWORD,TArray<INT> >& Grid, UBOOL bOnlyChanged, TArray<ANavigationPoint*>& Result )
+{
+	INT CellX = appFloor(Start->Location.X / MAXPATHDIST);
+	INT CellY = appFloor(Start->Location.Y / MAXPATHDIST);
+	INT CellZ = appFloor(Start->Location.Z / MAXPATHDIST);
+
+	TArray<INT> Candidates;
+	for ( INT X=CellX-1; X<=CellX+1; X++ )
+		for ( INT Y=CellY-1; Y<=CellY+1; Y++ )
+			for ( INT Z=CellZ-1; Z<=CellZ+1; Z++ )
+			{
+				const TArray<INT>* Cell = Grid.Find(GetReachGridKey(X,Y,Z));
+				if ( Cell )
+				{
+					for ( INT i=0; i<Cell->Num(); i++ )
+						if ( FPathBuilder::IsReachCandidate(Start, Navs((*Cell)(i)), bOnlyChanged) )
+							Candidates.AddItem((*Cell)(i));
+				}
+			}
+
+	if ( Candidates.Num() )
+		Sort<USE_COMPARE_CONSTREF(INT,UnPath)>(&Candidates(0), Candidates.Num());
+	Result.Empty(Candidates.Num());
+	for ( INT i=0; i<Candidates.Num(); i++ )
+		Result.AddItem(Navs(Candidates(i)));
+}
+
+/* IsReachCandidate()
+returns whether Start should attempt to build a reach spec to End
+*/
+UBOOL FPathBuilder::IsReachCandidate(ANavigationPoint* Start, ANavigationPoint* End, UBOOL bOnlyChanged)
+{
+	return ( End != NULL &&
+		!End->bDeleteMe &&
+		!End->bNoAutoConnect &&
+		!End->bSourceOnly &&
+		(End->Location - Start->Location).SizeSquared() <= MAXPATHDISTSQ &&
+		End != Start &&
+		(!bOnlyChanged || Start->bPathsChanged || End->bPathsChanged) &&
+		//@fixme - find a better way to handle this
+		// don't connect cover to cover, only cover to normal nodes
+		(!Start->IsA(ACoverNode::StaticClass()) || !End->IsA(ACoverNode::StaticClass())) );
+}
+
+/* FindReachCandidates()
+returns the reach candidates gathered for Start, or NULL if there are none
+*/
+const TArray<ANavigationPoint*>* FPathBuilder::FindReachCandidates(ANavigationPoint* Start)
+{
+	const INT* Index = GReachCandidateIndices.Find(Start);
+	return Index ? &GReachCandidates(*Index) : NULL;
+}
+
+/** Reach candidate whose reach spec is pre-evaluated on a worker thread */
+struct FReachPair
+{
+	/** Navigation point the spec starts at */
+	ANavigationPoint*	Start;
+	/** Navigation point the spec leads to */
+	ANavigationPoint*	End;
+	/** Indices into GReachCandidates the result is stored at */
+	INT					StartIndex;
+	INT					CandidateIndex;
+	/** Static blocking geometry between Start and End */
+	FCollisionSnapshot	Snapshot;
+	/** Largest path size index the scout can walk straight from Start to End with, INDEX_NONE if none */
+	INT					WalkSize;
+};
+
+/**
+ * Finds the walkable floor a scout of the passed in size stands on when placed at a
+ * navigation point.
+ *
+ * @return	FALSE if there is no walkable floor within a step of the navigation point's base
+ */
+static UBOOL FindWalkableFloor( FCollisionSnapshot& Snapshot, ANavigationPoint* Nav, const FVector& Extent, FLOAT StepHeight, FVector& OutLocation )
+{
+	FVector Location = Nav->Location;
+	Location.Z += Extent.Z - Nav->CylinderComponent->CollisionHeight;
+
+	FCheckResult Hit(1.f);
+	const FVector Up(0.f, 0.f, StepHeight);
+	if( Snapshot.LineCheck( Hit, Location - Up - FVector(0.f,0.f,4.f), Location + Up, Extent ) || Hit.Time == 0.f || Hit.Normal.Z < UCONST_MINFLOORZ )
+	{
+		return FALSE;
+	}
+	OutLocation = Hit.Location;
+	return TRUE;
+}
+
+/**
+ * Returns whether a scout of the passed in size can walk straight from Start to End
+ * across walkable floor without stepping up or down further than StepHeight at once.
+ * Conservative: anything else, including jumps and ledges, is left to the scout.
+ */
+static UBOOL CanWalkStraight( FReachPair& Pair, const FVector& Extent, FLOAT StepHeight )
+{
+	FVector StartFloor, EndFloor;
+	if( !FindWalkableFloor( Pair.Snapshot, Pair.Start, Extent, StepHeight, StartFloor )
+	||	!FindWalkableFloor( Pair.Snapshot, Pair.End, Extent, StepHeight, EndFloor ) )
+	{
+		return FALSE;
+	}
+
+	// The way has to be clear a step above the floor.
+	FCheckResult Hit(1.f);
+	const FVector Up(0.f, 0.f, StepHeight);
+	if( !Pair.Snapshot.LineCheck( Hit, EndFloor + Up, StartFloor + Up, Extent ) )
+	{
+		return FALSE;
+	}
+
+	// Probe the floor every radius along the way.
+	const INT	NumSteps	= Max( appCeil( (EndFloor - StartFloor).Size2D() / Max(Extent.X, 1.f) ), 1 );
+	FLOAT		FloorZ		= StartFloor.Z;
+	for( INT Step=1; Step<NumSteps; Step++ )
+	{
+		const FVector Probe = StartFloor + (EndFloor - StartFloor) * ((FLOAT)Step / NumSteps);
+		if( Pair.Snapshot.LineCheck( Hit, Probe - Up - FVector(0.f,0.f,4.f), Probe + Up, Extent )
+		||	Hit.Normal.Z < UCONST_MINFLOORZ
+		||	Abs(Hit.Location.Z - FloorZ) > StepHeight )
+		{
+			return FALSE;
+		}
+		FloorZ = Hit.Location.Z;
+	}
+	return Abs(EndFloor.Z - FloorZ) <= StepHeight;
+}
+
+/**
+ * Parallel loop body finding the largest path size the scout can walk straight to
+ * each reach candidate with. Only reads the scout and writes its own pair.
+ */
+class FReachPairEvaluator : public FParallelForBody
+{
+public:
+	FReachPairEvaluator( const AScout* InScout, TArray<FReachPair>& InPairs )
+	:	Scout( InScout ),
+		Pairs( InPairs )
+	{}
+
+	virtual void Execute( INT Index )
+	{
+		// Sizes are tried smallest first and the first failure ends the search, as in UReachSpec::findBestReachable.
+		FReachPair& Pair = Pairs(Index);
+		Pair.WalkSize = INDEX_NONE;
+		for( INT SizeIndex=0; SizeIndex<Scout->PathSizes.Num(); SizeIndex++ )
+		{
+			const FPathSizeInfo& Size = Scout->PathSizes(SizeIndex);
+			if( !CanWalkStraight( Pair, FVector(Size.Radius, Size.Radius, Size.Height), Scout->MaxStepHeight ) )
+			{
+				break;
+			}
+			Pair.WalkSize = SizeIndex;
+		}
+	}
+
+private:
+	const AScout*			Scout;
+	TArray<FReachPair>&		Pairs;
+};
+
+/* DefineReachSpec()
+defines Spec as the straight walk found for the candidate by GatherReachCandidates(), or
+with the scout if there is none
+*/
+UBOOL FPathBuilder::DefineReachSpec(UReachSpec* Spec, ANavigationPoint* Start, ANavigationPoint* End, INT CandidateIndex, AScout* Scout)
+{
+	const INT* Index = CandidateIndex != INDEX_NONE ? GReachCandidateIndices.Find(Start) : NULL;
+	if ( Index && GReachWalkSizes(*Index)(CandidateIndex) != INDEX_NONE )
+	{
+		check(GReachCandidates(*Index)(CandidateIndex) == End);
+		const FPathSizeInfo& Size = Scout->PathSizes(GReachWalkSizes(*Index)(CandidateIndex));
+		Spec->Start = Start;
+		Spec->End = End;
+		Spec->reachFlags = R_WALK;
+		Spec->MaxLandingVelocity = 0;
+		Spec->CollisionRadius = (INT)Size.Radius;
+		Spec->CollisionHeight = (INT)Size.Height;
+		Spec->Distance = (INT)(End->Location - Start->Location).Size();
+		return 1;
+	}
+	return Spec->defineFor(Start, End, Scout);
+}
+
+/* GatherReachCandidates()
+Finds the navigation points each navigation point getting reach specs should try to reach,
+using a grid instead of testing every pair of navigation points. Then finds the candidates
+the scout can walk straight to on worker threads, against snapshots of the static geometry
+gathered here. Jumps, ledges, water and special navigation points are left to the scout.
+*/
+void FPathBuilder::GatherReachCandidates(UBOOL bOnlyChanged)
+{
+	EmptyReachCandidates();
+
+	TArray<ANavigationPoint*> Navs;
+	TArray<INT> Starts;
+	TMap<QWORD,TArray<INT> > Grid;
+	for ( ANavigationPoint *Nav=Level->GetLevelInfo()->NavigationPointList; Nav; Nav=Nav->nextNavigationPoint )
+	{
+		const INT NavIndex = Navs.AddItem(Nav);
+		QWORD Key = GetReachGridKey(appFloor(Nav->Location.X / MAXPATHDIST), appFloor(Nav->Location.Y / MAXPATHDIST), appFloor(Nav->Location.Z / MAXPATHDIST));
+		TArray<INT>* Cell = Grid.Find(Key);
+		if ( !Cell )
+		{
+			Grid.Set(Key, TArray<INT>());
+			Cell = Grid.Find(Key);
+		}
+		Cell->AddItem(NavIndex);
+
+		if ( !bOnlyChanged || Nav->bPathsChanged )
+		{
+			GReachCandidateIndices.Set(Nav, Starts.Num());
+			Starts.AddItem(NavIndex);
+		}
+	}
+
+	GReachCandidates.AddZeroed(Starts.Num());
+	GReachWalkSizes.AddZeroed(Starts.Num());
+	for ( INT i=0; i<Starts.Num(); i++ )
+	{
+		GatherReachCandidatesFor(Navs(Starts(i)), Navs, Grid, bOnlyChanged, GReachCandidates(i));
+		GReachWalkSizes(i).Add(GReachCandidates(i).Num());
+		for ( INT j=0; j<GReachWalkSizes(i).Num(); j++ )
+			GReachWalkSizes(i)(j) = INDEX_NONE;
+	}
+	debugf(NAME_DevPath,TEXT("Gathered reach candidates for %i of %i navigation points"), Starts.Num(), Navs.Num());
+
+	if ( !Scout || !Scout->PathSizes.Num() )
+		return;
+
+	// Snapshots cover the largest scout walking between the two points, stepping up and down.
+	FLOAT MaxRadius = 0.f, MaxHeight = 0.f;
+	for ( INT i=0; i<Scout->PathSizes.Num(); i++ )
+	{
+		MaxRadius = Max(MaxRadius, Scout->PathSizes(i).Radius);
+		MaxHeight = Max(MaxHeight, Scout->PathSizes(i).Height);
+	}
+
+	TArray<FReachPair> Pairs;
+	TArray<UPrimitiveComponent*> Scratch;
+	for ( INT i=0; i<Starts.Num(); i++ )
+	{
+		ANavigationPoint* Start = Navs(Starts(i));
+		if ( !Start->IsA(APathNode::StaticClass()) || Start->bDestinationOnly || !Start->Base || Start->PhysicsVolume->bWaterVolume )
+			continue;
+		for ( INT j=0; j<GReachCandidates(i).Num(); j++ )
+		{
+			ANavigationPoint* End = GReachCandidates(i)(j);
+			if ( !End->IsA(APathNode::StaticClass()) || !End->Base || End->PhysicsVolume->bWaterVolume )
+				continue;
+
+			const FVector Slack(MaxRadius, MaxRadius, MaxHeight + 2.f * Scout->MaxStepHeight + Max(Start->CylinderComponent->CollisionHeight, End->CylinderComponent->CollisionHeight) + 4.f);
+			FBox Bounds(0);
+			Bounds += Start->Location;
+			Bounds += End->Location;
+			Bounds = FBox(Bounds.Min - Slack, Bounds.Max + Slack);
+
+			FReachPair& Pair = Pairs(Pairs.AddZeroed());
+			Pair.Start = Start;
+			Pair.End = End;
+			Pair.StartIndex = i;
+			Pair.CandidateIndex = j;
+			Pair.WalkSize = INDEX_NONE;
+			if ( !Pair.Snapshot.Gather(Level, Bounds, Scout, Scratch) )
+				Pairs.Remove(Pairs.Num() - 1);
+		}
+	}
+
+	FReachPairEvaluator Evaluator(Scout, Pairs);
+	appParallelFor(Pairs.Num(), Evaluator);
+
+	// Results are stored by candidate, addReachSpecs commits them in candidate order.
+	INT NumWalks = 0;
+	for ( INT i=0; i<Pairs.Num(); i++ )
+	{
+		const FReachPair& Pair = Pairs(i);
+		Pair.Snapshot.AddCollisionStats();
+		GReachWalkSizes(Pair.StartIndex)(Pair.CandidateIndex) = Pair.WalkSize;
+		NumWalks += (Pair.WalkSize != INDEX_NONE);
+	}
+	debugf(NAME_DevPath,TEXT("Found straight walks for %i of %i pre-evaluated reach candidates"), NumWalks, Pairs.Num());
+}
+
+/* EmptyReachCandidates()
+frees the reach candidates gathered by GatherReachCandidates()
+*/
+void FPathBuilder::EmptyReachCandidates()
+{
+	GReachCandidates.Empty();
+	GReachCandidateIndices.Empty();
+	GReachWalkSizes.Empty();
+}
+
 void FPathBuilder::DestroyScout(ULevel *Level)
 {
 	check(Level != NULL);
@@ -0,0 +1,744 @@
+/*=============================================================================
+	UnPathQuery.cpp: Navigation graph snapshots and reentrant path searches.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "EnginePrivate.h"
+#include "UnPath.h"
+
+/** Graphs of all levels that have been searched since paths last changed */
+static TMap<ALevelInfo*,FNavigationGraph*> GNavigationGraphs;
+
+/** Edge leading from one cluster to another, used while building cluster links */
+struct FNavGraphCrossing
+{
+	INT	StartCluster;
+	INT	EndCluster;
+	INT	Edge;
+};
+IMPLEMENT_COMPARE_CONSTREF( FNavGraphCrossing, UnPathQuery, { return A.StartCluster != B.StartCluster ? A.StartCluster - B.StartCluster : A.EndCluster - B.EndCluster; } )
+
+/*-----------------------------------------------------------------------------
+	FNavigationGraph implementation.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Returns the graph of the passed in level, building it if necessary. Game thread only.
+ *
+ * @param	LevelInfo	Level to retrieve graph for
+ * @return	graph of level, NULL if the level doesn't have any navigation points
+ */
+FNavigationGraph* FNavigationGraph::Get( ALevelInfo* LevelInfo )
+{
+	FNavigationGraph* Graph = GNavigationGraphs.FindRef( LevelInfo );
+	if( Graph && Graph->FirstNavigationPoint != LevelInfo->NavigationPointList )
+	{
+		// The navigation point list was rebuilt without us being told.
+		delete Graph;
+		GNavigationGraphs.Remove( LevelInfo );
+		Graph = NULL;
+	}
+	if( !Graph && LevelInfo->NavigationPointList )
+	{
+		Graph = new FNavigationGraph();
+		Graph->Build( LevelInfo );
+		GNavigationGraphs.Set( LevelInfo, Graph );
+	}
+	return Graph;
+}
+
+/**
+ * Discards all graphs, called whenever paths are built or navigation points go away. Game thread only.
+ */
+void FNavigationGraph::Invalidate()
+{
+	for( TMap<ALevelInfo*,FNavigationGraph*>::TIterator It(GNavigationGraphs); It; ++It )
+	{
+		delete It.Value();
+	}
+	GNavigationGraphs.Empty();
+}
+
+/**
+ * Builds the graph from the navigation points of the passed in level.
+ *
+ * @param	LevelInfo	Level to build graph for
+ */
+void FNavigationGraph::Build( ALevelInfo* LevelInfo )
+{
+	FirstNavigationPoint = LevelInfo->NavigationPointList;
+
+	for( ANavigationPoint* Nav=LevelInfo->NavigationPointList; Nav; Nav=Nav->nextNavigationPoint )
+	{
+		NodeIndices.Set( Nav, Nodes.Num() );
+		FNavGraphNode* Node	= new(Nodes) FNavGraphNode;
+		Node->Nav			= Nav;
+		Node->Location		= Nav->Location;
+		Node->FirstEdge		= 0;
+		Node->NumEdges		= 0;
+		Node->Cluster		= INDEX_NONE;
+	}
+
+	for( INT NodeIndex=0; NodeIndex<Nodes.Num(); NodeIndex++ )
+	{
+		FNavGraphNode& Node	= Nodes(NodeIndex);
+		Node.FirstEdge		= Edges.Num();
+		for( INT PathIndex=0; PathIndex<Node.Nav->PathList.Num(); PathIndex++ )
+		{
+			UReachSpec* Spec = Node.Nav->PathList(PathIndex);
+			INT			End	 = Spec && Spec->End ? FindNode( Spec->End ) : INDEX_NONE;
+			if( End == INDEX_NONE )
+			{
+				continue;
+			}
+
+			FNavGraphEdge* Edge			= new(Edges) FNavGraphEdge;
+			Edge->End					= End;
+			Edge->Spec					= Spec;
+			Edge->Distance				= Spec->Distance;
+			Edge->CollisionRadius		= Spec->CollisionRadius;
+			Edge->CollisionHeight		= Spec->CollisionHeight;
+			Edge->reachFlags			= Spec->reachFlags;
+			Edge->MaxLandingVelocity	= Spec->MaxLandingVelocity;
+			Edge->bForced				= Spec->bForced;
+			Edge->bSpecialCost			= Spec->bForced && Spec->End->bSpecialForced;
+			if( Edge->bSpecialCost )
+			{
+				SpecialEdges.AddItem( Edges.Num() - 1 );
+			}
+		}
+		Node.NumEdges = Edges.Num() - Node.FirstEdge;
+	}
+
+	BuildClusters();
+
+	debugf( NAME_DevPath, TEXT("Built navigation graph for %s: %i nodes, %i edges, %i clusters, %i cluster links"), *LevelInfo->GetPathName(), Nodes.Num(), Edges.Num(), Clusters.Num(), ClusterLinks.Num() );
+}
+
+/**
+ * Groups the nodes into clusters and links clusters connected by edges.
+ */
+void FNavigationGraph::BuildClusters()
+{
+	// Grow clusters breadth first from the first node not in a cluster yet. Bounding their
+	// extent keeps cluster locations meaningful for the cost of links between them.
+	TArray<INT> Pending;
+	for( INT SeedIndex=0; SeedIndex<Nodes.Num(); SeedIndex++ )
+	{
+		if( Nodes(SeedIndex).Cluster != INDEX_NONE )
+		{
+			continue;
+		}
+
+		const INT		ClusterIndex	= Clusters.Num();
+		const FVector	SeedLocation	= Nodes(SeedIndex).Location;
+		FVector			LocationSum		= SeedLocation;
+		Nodes(SeedIndex).Cluster		= ClusterIndex;
+		Pending.Empty( Pending.Num() );
+		Pending.AddItem( SeedIndex );
+		for( INT PendingIndex=0; PendingIndex<Pending.Num() && Pending.Num()<NAVCLUSTERMAXNODES; PendingIndex++ )
+		{
+			const FNavGraphNode& Node = Nodes(Pending(PendingIndex));
+			for( INT EdgeIndex=Node.FirstEdge; EdgeIndex<Node.FirstEdge+Node.NumEdges && Pending.Num()<NAVCLUSTERMAXNODES; EdgeIndex++ )
+			{
+				FNavGraphNode& End = Nodes(Edges(EdgeIndex).End);
+				if( End.Cluster == INDEX_NONE && (End.Location - SeedLocation).SizeSquared() < Square(NAVCLUSTERRADIUS) )
+				{
+					End.Cluster = ClusterIndex;
+					LocationSum += End.Location;
+					Pending.AddItem( Edges(EdgeIndex).End );
+				}
+			}
+		}
+
+		FNavGraphCluster* Cluster	= new(Clusters) FNavGraphCluster;
+		Cluster->Location			= LocationSum / Pending.Num();
+		Cluster->FirstLink			= 0;
+		Cluster->NumLinks			= 0;
+	}
+
+	// Gather edges leading across clusters, grouped by the pair of clusters they connect.
+	TArray<FNavGraphCrossing> Crossings;
+	for( INT NodeIndex=0; NodeIndex<Nodes.Num(); NodeIndex++ )
+	{
+		const FNavGraphNode& Node = Nodes(NodeIndex);
+		for( INT EdgeIndex=Node.FirstEdge; EdgeIndex<Node.FirstEdge+Node.NumEdges; EdgeIndex++ )
+		{
+			const INT EndCluster = Nodes(Edges(EdgeIndex).End).Cluster;
+			if( EndCluster != Node.Cluster )
+			{
+				FNavGraphCrossing* Crossing = new(Crossings) FNavGraphCrossing;
+				Crossing->StartCluster	= Node.Cluster;
+				Crossing->EndCluster	= EndCluster;
+				Crossing->Edge			= EdgeIndex;
+			}
+		}
+	}
+	if( Crossings.Num() )
+	{
+		Sort<USE_COMPARE_CONSTREF(FNavGraphCrossing,UnPathQuery)>( &Crossings(0), Crossings.Num() );
+	}
+
+	// Create one link per pair, Crossings being sorted by start cluster keeps links grouped the same way.
+	for( INT CrossingIndex=0; CrossingIndex<Crossings.Num(); CrossingIndex++ )
+	{
+		const FNavGraphCrossing& Crossing = Crossings(CrossingIndex);
+		if( CrossingIndex == 0
+		||	Crossings(CrossingIndex - 1).StartCluster != Crossing.StartCluster
+		||	Crossings(CrossingIndex - 1).EndCluster != Crossing.EndCluster )
+		{
+			FNavGraphCluster& Start = Clusters(Crossing.StartCluster);
+			if( Start.NumLinks == 0 )
+			{
+				Start.FirstLink = ClusterLinks.Num();
+			}
+			Start.NumLinks++;
+
+			FNavGraphClusterLink* Link	= new(ClusterLinks) FNavGraphClusterLink;
+			Link->EndCluster			= Crossing.EndCluster;
+			Link->Cost					= Max( appTrunc( (Clusters(Crossing.EndCluster).Location - Start.Location).Size() ), 1 );
+			Link->FirstCrossing			= CrossingEdges.Num();
+			Link->NumCrossings			= 0;
+		}
+		CrossingEdges.AddItem( Crossing.Edge );
+		ClusterLinks(ClusterLinks.Num() - 1).NumCrossings++;
+	}
+}
+
+/*-----------------------------------------------------------------------------
+	FPathQuery implementation.
+-----------------------------------------------------------------------------*/
+
+/** Constructor, initializing all members. */
+FPathQuery::FPathQuery()
+:	StartDist( 0.f ),
+	EndDist( 0.f ),
+	bWeightDetours( FALSE ),
+	Graph( NULL ),
+	Searcher( NULL ),
+	NodeEval( NULL ),
+	StartNode( INDEX_NONE ),
+	StartWeight( 0 ),
+	InitialBestWeight( 0.f ),
+	bUseHeuristic( FALSE ),
+	bUseCorridor( FALSE ),
+	bCorridorFailed( FALSE ),
+	bUnreachable( FALSE ),
+	Generation( 0 ),
+	ClusterGeneration( 0 ),
+	BestNode( INDEX_NONE ),
+	BestWeight( 0.f )
+{}
+
+/**
+ * Sets up a search for the passed in pawn. Gathers all state that may only be
+ * touched on the game thread: node costs, transient end points and script
+ * driven costs. Consumes the transient path finding properties of all
+ * navigation points like ANavigationPoint::ClearForPathFinding always has.
+ *
+ * @param	InSearcher		Pawn to find a path for
+ * @param	Start			Node to start the search from
+ * @param	InStartWeight	Weight of reaching Start
+ * @param	EndAnchor		Destination node, NULL if InNodeEval picks the destination
+ * @param	InNodeEval		Node evaluation function, NULL to search for end points
+ * @param	InBestWeight	Weight a node has to exceed to be picked as destination
+ * @return	TRUE if the query is ready to be executed, FALSE if there is nothing to search
+ */
+UBOOL FPathQuery::Prepare( APawn* InSearcher, ANavigationPoint* Start, INT InStartWeight, ANavigationPoint* EndAnchor, NodeEvaluator InNodeEval, FLOAT InBestWeight )
+{
+	BestNode	= INDEX_NONE;
+	BestWeight	= InBestWeight;
+	Graph		= FNavigationGraph::Get( InSearcher->Level );
+	if( !Graph || !Start )
+	{
+		return FALSE;
+	}
+	StartNode = Graph->FindNode( Start );
+	if( StartNode == INDEX_NONE )
+	{
+		return FALSE;
+	}
+
+	Searcher			= InSearcher;
+	NodeEval			= InNodeEval;
+	StartWeight			= InStartWeight;
+	InitialBestWeight	= InBestWeight;
+
+	Radius				= appFloor(Searcher->CylinderComponent->CollisionRadius);
+	Height				= appFloor(Searcher->CylinderComponent->CollisionHeight);
+	MoveFlags			= Searcher->calcMoveFlags();
+	MaxFallSpeed		= appFloor(Searcher->MaxFallSpeed);
+	CrouchMultiplier	= CROUCHCOSTMULTIPLIER * 1.f/Searcher->CrouchedPct;
+	APawn* DefaultPawn	= (APawn*)(Searcher->GetClass()->GetDefaultActor());
+	DefaultCollisionHeight = DefaultPawn->CylinderComponent->CollisionHeight;
+	if ( Searcher->bCanCrouch )
+	{
+		Height = appFloor(Searcher->CrouchHeight);
+		Radius = appFloor(Searcher->CrouchRadius);
+	}
+	if ( Searcher->Controller )
+	{
+		Searcher->Controller->eventSetupSpecialPathAbilities();
+	}
+
+	// Gather per node state. This is the only pass over all navigation points.
+	const INT NumNodes		= Graph->Nodes.Num();
+	const INT NumClusters	= Graph->Clusters.Num();
+	if( NodeCosts.Num() != NumNodes || CorridorStamps.Num() != NumClusters )
+	{
+		NodeCosts.Empty( NumNodes );
+		NodeCosts.Add( NumNodes );
+		NodeFlags.Empty( NumNodes );
+		NodeFlags.Add( NumNodes );
+		Weights.Empty( NumNodes );
+		Weights.Add( NumNodes );
+		Previous.Empty( NumNodes );
+		Previous.Add( NumNodes );
+		SeenStamps.Empty( NumNodes );
+		SeenStamps.AddZeroed( NumNodes );
+		ClosedStamps.Empty( NumNodes );
+		ClosedStamps.AddZeroed( NumNodes );
+		Generation = 0;
+
+		CorridorStamps.Empty( NumClusters );
+		CorridorStamps.AddZeroed( NumClusters );
+		ClusterWeights.Empty( NumClusters );
+		ClusterWeights.Add( NumClusters );
+		ClusterPrevious.Empty( NumClusters );
+		ClusterPrevious.Add( NumClusters );
+		ClusterSeenStamps.Empty( NumClusters );
+		ClusterSeenStamps.AddZeroed( NumClusters );
+		ClusterClosedStamps.Empty( NumClusters );
+		ClusterClosedStamps.AddZeroed( NumClusters );
+		ClusterGeneration = 0;
+	}
+	EndLocations.Empty();
+	INT NumEndPoints	= 0;
+	INT EndNode			= INDEX_NONE;
+	for( INT NodeIndex=0; NodeIndex<NumNodes; NodeIndex++ )
+	{
+		ANavigationPoint* Nav = Graph->Nodes(NodeIndex).Nav;
+		Nav->ClearForPathFinding();
+
+		BYTE Flags = 0;
+		if( Nav->bBlocked || (Nav->bMayCausePain && Searcher->HurtByVolume(Nav)) )
+		{
+			Flags |= NODE_Blocked;
+		}
+		if( Nav->bEndPoint || Nav == EndAnchor )
+		{
+			Flags |= NODE_EndPoint;
+			EndNode = NodeIndex;
+			if( ++NumEndPoints <= MAX_HEURISTIC_ENDPOINTS )
+			{
+				EndLocations.AddItem( Nav->Location );
+			}
+		}
+		NodeFlags(NodeIndex)	= Flags;
+		NodeCosts(NodeIndex)	= Nav->cost;
+	}
+
+	// Evaluation functions may prefer any node so only searches for end points can be directed.
+	bUseHeuristic = !NodeEval && NumEndPoints > 0 && NumEndPoints <= MAX_HEURISTIC_ENDPOINTS;
+
+	// Special costs are up to script so they need to be known before the search leaves the game thread.
+	SpecialCosts.Empty();
+	for( INT SpecialIndex=0; SpecialIndex<Graph->SpecialEdges.Num(); SpecialIndex++ )
+	{
+		const INT				EdgeIndex	= Graph->SpecialEdges(SpecialIndex);
+		const FNavGraphEdge&	Edge		= Graph->Edges(EdgeIndex);
+		if( !(NodeFlags(Edge.End) & NODE_Blocked) && Edge.supports( Radius, Height, MoveFlags, MaxFallSpeed ) )
+		{
+			SpecialCosts.Set( EdgeIndex, Graph->Nodes(Edge.End).Nav->eventSpecialCost( Searcher, Edge.Spec ) );
+		}
+	}
+
+	// Searches for a single destination far away first pick a corridor of clusters, reusing
+	// the one found by an earlier search between the same clusters if possible.
+	bUseCorridor	= FALSE;
+	bCorridorFailed	= FALSE;
+	bUnreachable	= FALSE;
+	if( !NodeEval && NumEndPoints == 1 && NumNodes >= NAVCLUSTERMINGRAPHNODES && Graph->Nodes(StartNode).Cluster != Graph->Nodes(EndNode).Cluster )
+	{
+		CorridorKey.StartCluster	= Graph->Nodes(StartNode).Cluster;
+		CorridorKey.GoalCluster		= Graph->Nodes(EndNode).Cluster;
+		CorridorKey.Radius			= Radius;
+		CorridorKey.Height			= Height;
+		CorridorKey.MoveFlags		= MoveFlags;
+		CorridorKey.MaxFallSpeed	= MaxFallSpeed;
+
+		const TArray<INT>* CachedCorridor = Graph->PathCache.Find( CorridorKey );
+		if( CachedCorridor )
+		{
+			Corridor		= *CachedCorridor;
+			bUseCorridor	= TRUE;
+		}
+		else if( FindCorridor( CorridorKey.StartCluster, CorridorKey.GoalCluster ) )
+		{
+			if( Graph->PathCache.Num() >= MAXPATHCACHEENTRIES )
+			{
+				Graph->PathCache.Empty();
+			}
+			Graph->PathCache.Set( CorridorKey, Corridor );
+			bUseCorridor = TRUE;
+		}
+		else
+		{
+			// Every path would have to cross the clusters along links, so there is none.
+			bUnreachable = TRUE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Searches the cluster graph for the cheapest corridor between two clusters
+ * the searcher can traverse, storing it in Corridor.
+ *
+ * @param	StartCluster	Cluster to start from
+ * @param	GoalCluster		Cluster to find corridor to
+ * @return	TRUE if a corridor was found, FALSE if the goal can't be reached
+ */
+UBOOL FPathQuery::FindCorridor( INT StartCluster, INT GoalCluster )
+{
+	if( ++ClusterGeneration == 0 )
+	{
+		appMemzero( &ClusterSeenStamps(0), ClusterSeenStamps.Num() * sizeof(DWORD) );
+		appMemzero( &ClusterClosedStamps(0), ClusterClosedStamps.Num() * sizeof(DWORD) );
+		ClusterGeneration = 1;
+	}
+
+	// A* on clusters, link costs are the distances between cluster locations so the
+	// straight line distance to the goal cluster is a consistent heuristic.
+	const FVector& GoalLocation = Graph->Clusters(GoalCluster).Location;
+	ClusterOpenSet.Empty( ClusterOpenSet.Num() );
+	ClusterSeenStamps(StartCluster)	= ClusterGeneration;
+	ClusterWeights(StartCluster)	= 0;
+	ClusterPrevious(StartCluster)	= INDEX_NONE;
+
+	FOpenNode Start;
+	Start.Estimate	= 0;
+	Start.Weight	= 0;
+	Start.Node		= StartCluster;
+	PushHeap( ClusterOpenSet, Start );
+
+	while( ClusterOpenSet.Num() )
+	{
+		FOpenNode Current = PopHeap( ClusterOpenSet );
+		if( ClusterClosedStamps(Current.Node) == ClusterGeneration || Current.Weight != ClusterWeights(Current.Node) )
+		{
+			continue;
+		}
+		ClusterClosedStamps(Current.Node) = ClusterGeneration;
+
+		if( Current.Node == GoalCluster )
+		{
+			Corridor.Empty( Corridor.Num() );
+			for( INT ClusterIndex=GoalCluster; ClusterIndex!=INDEX_NONE; ClusterIndex=ClusterPrevious(ClusterIndex) )
+			{
+				Corridor.AddItem( ClusterIndex );
+			}
+			return TRUE;
+		}
+
+		const FNavGraphCluster& Cluster = Graph->Clusters(Current.Node);
+		for( INT LinkIndex=Cluster.FirstLink; LinkIndex<Cluster.FirstLink+Cluster.NumLinks; LinkIndex++ )
+		{
+			const FNavGraphClusterLink& Link = Graph->ClusterLinks(LinkIndex);
+			if( ClusterClosedStamps(Link.EndCluster) == ClusterGeneration )
+			{
+				continue;
+			}
+
+			// The link is only usable if the searcher can take one of its edges.
+			UBOOL bTraversable = FALSE;
+			for( INT CrossingIndex=Link.FirstCrossing; CrossingIndex<Link.FirstCrossing+Link.NumCrossings && !bTraversable; CrossingIndex++ )
+			{
+				const FNavGraphEdge& Edge = Graph->Edges(Graph->CrossingEdges(CrossingIndex));
+				bTraversable = !(NodeFlags(Edge.End) & NODE_Blocked) && Edge.supports( Radius, Height, MoveFlags, MaxFallSpeed );
+			}
+			if( !bTraversable )
+			{
+				continue;
+			}
+
+			INT NewWeight = Current.Weight + Link.Cost;
+			if( ClusterSeenStamps(Link.EndCluster) != ClusterGeneration || NewWeight < ClusterWeights(Link.EndCluster) )
+			{
+				ClusterSeenStamps(Link.EndCluster)	= ClusterGeneration;
+				ClusterWeights(Link.EndCluster)		= NewWeight;
+				ClusterPrevious(Link.EndCluster)	= Current.Node;
+
+				FOpenNode Entry;
+				Entry.Estimate	= NewWeight + appFloor( (Graph->Clusters(Link.EndCluster).Location - GoalLocation).Size() );
+				Entry.Weight	= NewWeight;
+				Entry.Node		= Link.EndCluster;
+				PushHeap( ClusterOpenSet, Entry );
+			}
+		}
+	}
+	return FALSE;
+}
+
+/**
+ * Runs the search set up by Prepare.
+ */
+void FPathQuery::Execute()
+{
+	check(Graph && StartNode != INDEX_NONE);
+
+	if( bUnreachable )
+	{
+		BeginSearch();
+		return;
+	}
+	if( bUseCorridor )
+	{
+		Search( TRUE );
+		if( BestNode != INDEX_NONE )
+		{
+			return;
+		}
+		// Blocked nodes or clusters that aren't connected internally can cut off the corridor.
+		bCorridorFailed = TRUE;
+	}
+	Search( FALSE );
+}
+
+/**
+ * Updates state shared with other queries, needs to be called on the game
+ * thread after Execute and before the graph can change.
+ */
+void FPathQuery::Finish()
+{
+	if( bCorridorFailed )
+	{
+		Graph->PathCache.Remove( CorridorKey );
+		bCorridorFailed = FALSE;
+	}
+}
+
+/**
+ * Advances the generation and resets the results of the previous search.
+ */
+void FPathQuery::BeginSearch()
+{
+	// Advance the generation rather than clearing the scratch arrays, unless it wraps around.
+	if( ++Generation == 0 )
+	{
+		appMemzero( &SeenStamps(0), SeenStamps.Num() * sizeof(DWORD) );
+		appMemzero( &ClosedStamps(0), ClosedStamps.Num() * sizeof(DWORD) );
+		Generation = 1;
+	}
+
+	BestNode	= INDEX_NONE;
+	BestWeight	= InitialBestWeight;
+	OpenSet.Empty( OpenSet.Num() );
+}
+
+/**
+ * Searches the graph node by node.
+ *
+ * @param	bInCorridor		Whether to only consider nodes in the clusters of Corridor
+ */
+void FPathQuery::Search( UBOOL bInCorridor )
+{
+	BeginSearch();
+	if( bInCorridor )
+	{
+		for( INT CorridorIndex=0; CorridorIndex<Corridor.Num(); CorridorIndex++ )
+		{
+			CorridorStamps(Corridor(CorridorIndex)) = Generation;
+		}
+	}
+
+	SeenStamps(StartNode)	= Generation;
+	Weights(StartNode)		= StartWeight;
+	Previous(StartNode)		= INDEX_NONE;
+	PushOpen( StartNode, StartWeight );
+
+	INT NumExpanded = 0;
+	while( OpenSet.Num() )
+	{
+		FOpenNode Current = PopHeap( OpenSet );
+		if( ClosedStamps(Current.Node) == Generation || Current.Weight != Weights(Current.Node) )
+		{
+			// Already expanded via a cheaper path.
+			continue;
+		}
+		ClosedStamps(Current.Node) = Generation;
+
+		const FNavGraphNode& Node = Graph->Nodes(Current.Node);
+		FLOAT ThisWeight = NodeEval ? (*NodeEval)(Node.Nav, Searcher, BestWeight) : ((NodeFlags(Current.Node) & NODE_EndPoint) ? 2.f : 0.f);
+		if ( ThisWeight > BestWeight )
+		{
+			BestWeight	= ThisWeight;
+			BestNode	= Current.Node;
+		}
+		if ( BestWeight >= 1.f )
+		{
+			break;
+		}
+		if ( NumExpanded++ > MAXPATHEXPANSIONS && BestWeight > 0.f )
+		{
+			break;
+		}
+
+		for( INT EdgeIndex=Node.FirstEdge; EdgeIndex<Node.FirstEdge+Node.NumEdges; EdgeIndex++ )
+		{
+			const FNavGraphEdge& Edge = Graph->Edges(EdgeIndex);
+			if( ClosedStamps(Edge.End) == Generation
+			||	(NodeFlags(Edge.End) & NODE_Blocked)
+			||	(bInCorridor && CorridorStamps(Graph->Nodes(Edge.End).Cluster) != Generation)
+			||	!Edge.supports( Radius, Height, MoveFlags, MaxFallSpeed ) )
+			{
+				continue;
+			}
+
+			INT NextWeight;
+			if ( Edge.bSpecialCost )
+			{
+				NextWeight = Edge.Distance + SpecialCosts.FindRef( EdgeIndex );
+			}
+			else if ( Edge.CollisionHeight >= DefaultCollisionHeight )
+			{
+				NextWeight = Edge.Distance + NodeCosts(Edge.End);
+			}
+			else
+			{
+				NextWeight = appTrunc(CrouchMultiplier * Edge.Distance) + NodeCosts(Edge.End);
+			}
+			if ( NextWeight <= 0 )
+			{
+				debugf(TEXT("WARNING - negative weight %d from %s to %s"), NextWeight, Node.Nav->GetName(), Graph->Nodes(Edge.End).Nav->GetName());
+				NextWeight = 1;
+			}
+
+			INT NewWeight = Current.Weight + NextWeight;
+			if( SeenStamps(Edge.End) != Generation || NewWeight < Weights(Edge.End) )
+			{
+				SeenStamps(Edge.End)	= Generation;
+				Weights(Edge.End)		= NewWeight;
+				Previous(Edge.End)		= Current.Node;
+				PushOpen( Edge.End, NewWeight );
+			}
+		}
+	}
+}
+
+/**
+ * Returns the weight of the cheapest path found to a navigation point.
+ *
+ * @param	Nav		Navigation point to look up
+ * @return	path weight, UNREACHEDPATHWEIGHT if the search didn't reach Nav
+ */
+INT FPathQuery::GetWeight( ANavigationPoint* Nav ) const
+{
+	INT NodeIndex = Graph ? Graph->FindNode( Nav ) : INDEX_NONE;
+	if( NodeIndex == INDEX_NONE || SeenStamps(NodeIndex) != Generation )
+	{
+		return UNREACHEDPATHWEIGHT;
+	}
+	return Weights(NodeIndex);
+}
+
+/**
+ * Returns the path from the start node to the best destination.
+ *
+ * @param	Route	[out] navigation points along the path, starting with the start node
+ */
+void FPathQuery::GetRoute( TArray<ANavigationPoint*>& Route ) const
+{
+	Route.Empty();
+	for( INT NodeIndex=BestNode; NodeIndex!=INDEX_NONE; NodeIndex=Previous(NodeIndex) )
+	{
+		Route.Insert( 0 );
+		Route(0) = Graph->Nodes(NodeIndex).Nav;
+	}
+}
+
+/**
+ * Adds an entry to a binary heap.
+ */
+void FPathQuery::PushHeap( TArray<FOpenNode>& Heap, const FOpenNode& Entry )
+{
+	// Sift up.
+	INT Index = Heap.Add();
+	while( Index > 0 )
+	{
+		INT Parent = (Index - 1) / 2;
+		if( Heap(Parent).Estimate <= Entry.Estimate )
+		{
+			break;
+		}
+		Heap(Index)	= Heap(Parent);
+		Index		= Parent;
+	}
+	Heap(Index) = Entry;
+}
+
+/**
+ * Removes the entry with the lowest estimate from a binary heap.
+ */
+FPathQuery::FOpenNode FPathQuery::PopHeap( TArray<FOpenNode>& Heap )
+{
+	FOpenNode Result	= Heap(0);
+	FOpenNode Last		= Heap(Heap.Num() - 1);
+	Heap.Remove( Heap.Num() - 1 );
+
+	// Sift the last entry down from the root.
+	INT Num = Heap.Num();
+	if( Num )
+	{
+		INT Index = 0;
+		for( ;; )
+		{
+			INT Child = Index * 2 + 1;
+			if( Child >= Num )
+			{
+				break;
+			}
+			if( Child + 1 < Num && Heap(Child + 1).Estimate < Heap(Child).Estimate )
+			{
+				Child++;
+			}
+			if( Last.Estimate <= Heap(Child).Estimate )
+			{
+				break;
+			}
+			Heap(Index)	= Heap(Child);
+			Index		= Child;
+		}
+		Heap(Index) = Last;
+	}
+	return Result;
+}
+
+/**
+ * Adds a node to the open set.
+ */
+void FPathQuery::PushOpen( INT Node, INT Weight )
+{
+	FOpenNode Entry;
+	Entry.Estimate	= Weight + (bUseHeuristic ? GetHeuristic( Node ) : 0);
+	Entry.Weight	= Weight;
+	Entry.Node		= Node;
+	PushHeap( OpenSet, Entry );
+}
+
+/**
+ * @return lower bound of the weight of getting from the passed in node to an end point
+ */
+INT FPathQuery::GetHeuristic( INT Node ) const
+{
+	// Reach spec distances are at least the straight line distance and costs are rarely
+	// negative, so the distance to the nearest end point is a lower bound.
+	const FVector& Location = Graph->Nodes(Node).Location;
+	FLOAT MinDistSquared = BIG_NUMBER;
+	for( INT EndIndex=0; EndIndex<EndLocations.Num(); EndIndex++ )
+	{
+		MinDistSquared = Min( MinDistSquared, (EndLocations(EndIndex) - Location).SizeSquared() );
+	}
+	return appFloor( appSqrt( MinDistSquared ) );
+}
@@ -0,0 +1,535 @@
+/*=============================================================================
+	UnPawnMovement.cpp: Movement phase running AI pawn walking physics in parallel.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "EnginePrivate.h"
+#include "UnPawnMovement.h"
+#include "UnTerrain.h"
+
+/** Longest physics step that is simulated in one go, APawn::physWalking subdivides longer ones */
+#define MAXSIMULATEDSTEP	0.05f
+
+/**
+ * Returns the level's pawn movement phase, creating it if necessary.
+ */
+FPawnMovementPhase* ULevel::GetPawnMovement()
+{
+	if( !PawnMovement )
+	{
+		PawnMovement = new FPawnMovementPhase( this );
+	}
+	return PawnMovement;
+}
+
+/*-----------------------------------------------------------------------------
+	FCollisionSnapshot implementation.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Gathers the static geometry that blocks Mover within Bounds.
+ *
+ * @param	InLevel		Level to gather the geometry of
+ * @param	Bounds		Bounds any sweep through the snapshot stays within
+ * @param	Mover		Actor the sweeps are done for, filtering out what doesn't block it
+ * @param	Scratch		Array to reuse for octree queries
+ * @return	FALSE if anything but static geometry that can be checked from worker threads blocks Mover within Bounds
+ */
+UBOOL FCollisionSnapshot::Gather( ULevel* InLevel, const FBox& Bounds, AActor* Mover, TArray<UPrimitiveComponent*>& Scratch )
+{
+	Level = InLevel;
+	Primitives.Empty();
+	if( !Level->Hash )
+	{
+		return FALSE;
+	}
+
+	Scratch.Empty( Scratch.Num() );
+	Level->Hash->GetIntersectingPrimitives( Bounds, Scratch );
+	for( INT PrimitiveIndex=0; PrimitiveIndex<Scratch.Num(); PrimitiveIndex++ )
+	{
+		UPrimitiveComponent*	Primitive	= Scratch(PrimitiveIndex);
+		AActor*					Owner		= Primitive->Owner;
+
+		// Same filter as the octree applies to extent line checks, the mover itself and
+		// what is attached to it move along with it.
+		if( !Owner
+		||	Owner == Mover
+		||	Mover->IsOwnedBy(Owner)
+		||	Owner->IsBasedOn(Mover)
+		||	!Primitive->ShouldCollide()
+		||	!Primitive->BlockNonZeroExtent
+		||	!Owner->ShouldTrace(Primitive, Mover, TRACE_AllBlocking) )
+		{
+			continue;
+		}
+
+		// Only static geometry whose collision code has no global state can be checked from
+		// worker threads. Terrain collision shares a patch sampler between all checks.
+		if( !Owner->bStatic
+		||	Primitive->IsA(UTerrainComponent::StaticClass())
+		||	!(Primitive->IsA(UStaticMeshComponent::StaticClass()) || Primitive->IsA(UBrushComponent::StaticClass()) || Primitive->IsA(UCylinderComponent::StaticClass())) )
+		{
+			return FALSE;
+		}
+		Primitives.AddItem( Primitive );
+	}
+	return TRUE;
+}
+
+/**
+ * Sweeps a box through the level's BSP and the primitives of the snapshot. Only
+ * uses collision code that is safe to run on several threads at once. Time spent
+ * off the game thread is accumulated in the snapshot rather than GCollisionStats.
+ *
+ * @return	TRUE if unblocked, FALSE if blocked, in which case Hit holds the first hit
+ */
+UBOOL FCollisionSnapshot::LineCheck( FCheckResult& Hit, const FVector& End, const FVector& Start, const FVector& Extent )
+{
+	// Zero extent BSP checks use global state, so only box sweeps are supported.
+	check(!Extent.IsZero());
+
+	// The collision code's own cycle counters only count on the game thread.
+	const UBOOL bCountCycles = appGetCurrentThreadId() != GGameThreadId;
+
+	Hit = FCheckResult(1.f);
+
+	FCheckResult LevelHit(1.f);
+	DWORD StartCycles = appCycles();
+	if( !Level->Model->LineCheck( LevelHit, NULL, End, Start, Extent, TRACE_AllBlocking ) )
+	{
+		LevelHit.Actor = Level->GetLevelInfo();
+		Hit = LevelHit;
+	}
+	if( bCountCycles )
+	{
+		BSPCycles += appCycles() - StartCycles;
+	}
+
+	for( INT PrimitiveIndex=0; PrimitiveIndex<Primitives.Num(); PrimitiveIndex++ )
+	{
+		UPrimitiveComponent* Primitive = Primitives(PrimitiveIndex);
+		FCheckResult PrimitiveHit(1.f);
+		StartCycles = appCycles();
+		const UBOOL bBlocked = !Primitive->LineCheck( PrimitiveHit, End, Start, Extent, TRACE_AllBlocking );
+		if( bCountCycles )
+		{
+			if( Primitive->IsA(UStaticMeshComponent::StaticClass()) )
+			{
+				StaticMeshCycles += appCycles() - StartCycles;
+			}
+			else if( Primitive->IsA(UBrushComponent::StaticClass()) )
+			{
+				BSPCycles += appCycles() - StartCycles;
+			}
+		}
+		if( bBlocked && PrimitiveHit.Time < Hit.Time )
+		{
+			PrimitiveHit.Actor		= Primitive->Owner;
+			PrimitiveHit.Component	= Primitive;
+			Hit = PrimitiveHit;
+		}
+	}
+	return Hit.Time == 1.f;
+}
+
+/**
+ * Adds the time spent sweeping off the game thread to GCollisionStats. Called on the
+ * game thread once the workers are done.
+ */
+void FCollisionSnapshot::AddCollisionStats() const
+{
+	GCollisionStats.BSPExtentTime.Value			+= BSPCycles;
+	GCollisionStats.StaticMeshExtentTime.Value	+= StaticMeshCycles;
+}
+
+/*-----------------------------------------------------------------------------
+	FPawnMoveSimulator.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Parallel loop body simulating the moves of non-interacting pawns.
+ */
+class FPawnMoveSimulator : public FParallelForBody
+{
+public:
+	FPawnMoveSimulator( const FPawnMovementPhase& InPhase, TArray<FPawnMovementPhase::FPawnMove>& InMoves, const TArray<INT>& InIsolated )
+	:	Phase( InPhase ),
+		Moves( InMoves ),
+		Isolated( InIsolated )
+	{}
+
+	virtual void Execute( INT Index )
+	{
+		Phase.SimulateMove( Moves(Isolated(Index)) );
+	}
+
+private:
+	const FPawnMovementPhase&					Phase;
+	TArray<FPawnMovementPhase::FPawnMove>&		Moves;
+	const TArray<INT>&							Isolated;
+};
+
+/** Move bounds sorted along X to find overlapping ones */
+struct FMoveSweepEntry
+{
+	FLOAT	MinX;
+	INT		MoveIndex;
+};
+
+IMPLEMENT_COMPARE_CONSTREF( FMoveSweepEntry, UnPawnMovement, { return A.MinX < B.MinX ? -1 : (A.MinX > B.MinX ? 1 : 0); } )
+
+/*-----------------------------------------------------------------------------
+	FPawnMovementPhase implementation.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Constructor, reading the settings from the engine ini.
+ *
+ * @param	InLevel		Level whose pawns are moved
+ */
+FPawnMovementPhase::FPawnMovementPhase( ULevel* InLevel )
+:	Level( InLevel ),
+	bEnabled( GThreadPool != NULL ),
+	bCollecting( FALSE )
+{
+	GConfig->GetBool( TEXT("Engine.PawnMovement"), TEXT("bParallelPawnPhysics"), bEnabled, GEngineIni );
+}
+
+/**
+ * Starts accepting pawns for the movement phase, called before the actors of
+ * the level are ticked.
+ */
+void FPawnMovementPhase::BeginCollecting()
+{
+	bCollecting = bEnabled;
+}
+
+/**
+ * Defers a pawn's physics to the movement phase if possible, called by
+ * APawn::performPhysics in place of APawn::startNewPhysics.
+ *
+ * @param	Pawn			Pawn to move
+ * @param	DeltaSeconds	Time to move the pawn for
+ * @param	OldVelocity		Velocity of the pawn before physics, passed on to APawn::finishPhysics
+ * @return	TRUE if the movement phase took over the pawn's physics
+ */
+UBOOL FPawnMovementPhase::DeferPhysics( APawn* Pawn, FLOAT DeltaSeconds, const FVector& OldVelocity )
+{
+	// Pawns doing physics more than once per frame get the remaining passes inline.
+	if( !bCollecting || !CanDefer( Pawn, DeltaSeconds ) || DeferredIndices.Find( Pawn ) )
+	{
+		return FALSE;
+	}
+	DeferredIndices.Set( Pawn, DeferredMoves.Num() );
+	FDeferredMove* Deferred	= new(DeferredMoves) FDeferredMove;
+	Deferred->Pawn			= Pawn;
+	Deferred->DeltaSeconds	= DeltaSeconds;
+	Deferred->OldVelocity	= OldVelocity;
+	return TRUE;
+}
+
+/**
+ * Returns whether a pawn's physics can be deferred to the movement phase.
+ */
+UBOOL FPawnMovementPhase::CanDefer( APawn* Pawn, FLOAT DeltaSeconds )
+{
+	AController* Controller = Pawn->Controller;
+	return	!Pawn->bDeleteMe
+		&&	Pawn->Physics == PHYS_Walking
+		&&	Pawn->Role == ROLE_Authority
+		&&	Controller
+		&&	!Pawn->IsHumanControlled()
+		&&	!Controller->bPreciseDestination
+		&&	Controller->MoveTimer != -1.f
+		&&	!Pawn->IsProbing(NAME_ModifyVelocity)
+		&&	Pawn->bCollideWorld
+		&&	Pawn->CylinderComponent
+		&&	Pawn->CollisionComponent == Pawn->CylinderComponent
+		&&	!Pawn->bIsCrouched
+		&&	!Pawn->bWantsToCrouch
+		&&	Pawn->Base
+		&&	(Pawn->Base->bStatic || Pawn->Base->bWorldGeometry)
+		&&	Pawn->PhysicsVolume->ZoneVelocity.IsZero()
+		&&	DeltaSeconds <= MAXSIMULATEDSTEP;
+}
+
+/**
+ * Moves all deferred pawns, called once all actors of the level have been ticked.
+ */
+void FPawnMovementPhase::Tick()
+{
+	bCollecting = FALSE;
+	if( !DeferredMoves.Num() )
+	{
+		return;
+	}
+
+	// Gather the snapshots on the game thread, as octree queries aren't thread safe. Pawns
+	// that can't be simulated still get bounds as they may walk into the others.
+	TArray<FPawnMove> Moves;
+	TArray<UPrimitiveComponent*> Scratch;
+	Moves.AddZeroed( DeferredMoves.Num() );
+	for( INT MoveIndex=0; MoveIndex<Moves.Num(); MoveIndex++ )
+	{
+		FPawnMove& Move		= Moves(MoveIndex);
+		Move.DeferredIndex	= MoveIndex;
+		Move.bCandidate		= GatherSnapshot( Move, Scratch );
+	}
+
+	// Sweep along X to find pawns whose bounds overlap, those are moved one after the other.
+	TArray<FMoveSweepEntry> Sweep;
+	for( INT MoveIndex=0; MoveIndex<Moves.Num(); MoveIndex++ )
+	{
+		FMoveSweepEntry* Entry	= new(Sweep) FMoveSweepEntry;
+		Entry->MinX				= Moves(MoveIndex).Bounds.Min.X;
+		Entry->MoveIndex		= MoveIndex;
+	}
+	Sort<USE_COMPARE_CONSTREF(FMoveSweepEntry,UnPawnMovement)>( &Sweep(0), Sweep.Num() );
+	for( INT SweepIndex=0; SweepIndex<Sweep.Num(); SweepIndex++ )
+	{
+		FPawnMove& Move = Moves(Sweep(SweepIndex).MoveIndex);
+		for( INT OtherIndex=SweepIndex+1; OtherIndex<Sweep.Num() && Sweep(OtherIndex).MinX <= Move.Bounds.Max.X; OtherIndex++ )
+		{
+			FPawnMove& Other = Moves(Sweep(OtherIndex).MoveIndex);
+			if( Move.Bounds.Intersect( Other.Bounds ) )
+			{
+				Move.bCandidate		= FALSE;
+				Other.bCandidate	= FALSE;
+			}
+		}
+	}
+
+	// Simulate the moves of all pawns that don't interact with anything.
+	TArray<INT> Isolated;
+	for( INT MoveIndex=0; MoveIndex<Moves.Num(); MoveIndex++ )
+	{
+		if( Moves(MoveIndex).bCandidate )
+		{
+			Isolated.AddItem( MoveIndex );
+		}
+	}
+	FPawnMoveSimulator Simulator( *this, Moves, Isolated );
+	appParallelFor( Isolated.Num(), Simulator );
+
+	// Add the collision time of the moves simulated on workers to the stats.
+	for( INT IsolatedIndex=0; IsolatedIndex<Isolated.Num(); IsolatedIndex++ )
+	{
+		Moves(Isolated(IsolatedIndex)).Snapshot.AddCollisionStats();
+	}
+
+	// Commit in actor tick order so events are dispatched deterministically.
+	TArray<FDeferredMove> Deferred = DeferredMoves;
+	DeferredMoves.Empty( DeferredMoves.Num() );
+	DeferredIndices.Empty();
+	for( INT MoveIndex=0; MoveIndex<Moves.Num(); MoveIndex++ )
+	{
+		CommitMove( Deferred(MoveIndex), Moves(MoveIndex) );
+	}
+}
+
+/**
+ * Removes all references to actors that are about to be deleted.
+ */
+void FPawnMovementPhase::CleanupDestroyed()
+{
+	for( INT DeferredIndex=0; DeferredIndex<DeferredMoves.Num(); DeferredIndex++ )
+	{
+		if( DeferredMoves(DeferredIndex).Pawn->bDeleteMe )
+		{
+			DeferredMoves.Remove( DeferredIndex-- );
+		}
+	}
+	DeferredIndices.Empty();
+	for( INT DeferredIndex=0; DeferredIndex<DeferredMoves.Num(); DeferredIndex++ )
+	{
+		DeferredIndices.Set( DeferredMoves(DeferredIndex).Pawn, DeferredIndex );
+	}
+}
+
+/**
+ * Computes the bounds of a deferred pawn's move and gathers the static blocking
+ * geometry within them into its snapshot.
+ *
+ * @param	Move		Move to fill in, its DeferredIndex has to be set
+ * @param	Scratch		Array to reuse for octree queries
+ * @return	FALSE if the pawn can't be simulated or anything else that may interact with it is nearby
+ */
+UBOOL FPawnMovementPhase::GatherSnapshot( FPawnMove& Move, TArray<UPrimitiveComponent*>& Scratch )
+{
+	const FDeferredMove&	Deferred	= DeferredMoves(Move.DeferredIndex);
+	APawn*					Pawn		= Deferred.Pawn;
+
+	Move.StartLocation		= Pawn->Location;
+	Move.StartVelocity		= Pawn->Velocity;
+	Move.StartAcceleration	= Pawn->Acceleration;
+
+	// Cover the furthest the pawn can walk plus the ledge check ahead of it, and the floor probes below.
+	const FLOAT Radius	= Pawn->CylinderComponent ? Pawn->CylinderComponent->CollisionRadius : 0.f;
+	const FLOAT Height	= Pawn->CylinderComponent ? Pawn->CylinderComponent->CollisionHeight : 0.f;
+	const FLOAT Reach	= Pawn->GroundSpeed * Max(1.f, Pawn->MaxSpeedModifier()) * Deferred.DeltaSeconds + 2.f * Radius + 4.f;
+	const FLOAT Drop	= Pawn->MaxStepHeight + 4.f;
+	Move.Bounds = FBox( Pawn->Location - FVector(Reach, Reach, Height + Drop), Pawn->Location + FVector(Reach, Reach, Height + Drop) );
+
+	// Tick may have changed the pawn since it was deferred.
+	if( !CanDefer( Pawn, Deferred.DeltaSeconds ) )
+	{
+		return FALSE;
+	}
+	Move.bLedgeCheck = Pawn->Controller->WantsLedgeCheck();
+
+	return Move.Snapshot.Gather( Level, Move.Bounds, Pawn, Scratch );
+}
+
+/**
+ * Simulates the walking move of a pawn against its snapshot, filling in the
+ * result fields of Move. Runs on worker threads, only touching Move and the pawn.
+ */
+void FPawnMovementPhase::SimulateMove( FPawnMove& Move ) const
+{
+	const FDeferredMove&	Deferred	= DeferredMoves(Move.DeferredIndex);
+	APawn*					Pawn		= Deferred.Pawn;
+	const FLOAT				DeltaTime	= Deferred.DeltaSeconds;
+
+	Move.bValid = FALSE;
+
+	// Velocity as APawn::physWalking computes it. calcVelocity updates the pawn so its state is restored afterwards.
+	Pawn->Velocity.Z		= 0.f;
+	Pawn->Acceleration.Z	= 0.f;
+	const FVector AccelDir = Pawn->Acceleration.IsZero() ? Pawn->Acceleration : Pawn->Acceleration.SafeNormal();
+	Pawn->calcVelocity( AccelDir, DeltaTime, Pawn->GroundSpeed, Pawn->PhysicsVolume->GroundFriction, 0, 1, 0 );
+	Move.NewVelocity		= Pawn->Velocity;
+	Move.NewAcceleration	= Pawn->Acceleration;
+	Pawn->Velocity			= Move.StartVelocity;
+	Pawn->Acceleration		= Move.StartAcceleration;
+
+	FVector DesiredMove = Move.NewVelocity;
+	DesiredMove.Z = 0.f;
+	Move.Delta = DesiredMove * DeltaTime;
+
+	const FVector	Extent	= Pawn->GetCylinderExtent();
+	const FVector	GravDir	= (Pawn->PhysicsVolume->Gravity.Z > 0.f) ? FVector(0.f,0.f,1.f) : FVector(0.f,0.f,-1.f);
+	FCheckResult	Hit(1.f);
+
+	if( Move.Delta.IsNearlyZero() )
+	{
+		Move.Delta = FVector(0.f,0.f,0.f);
+	}
+	else
+	{
+		// Walking onto a steep slope goes through stepUp.
+		if( (Pawn->Floor.Z < 0.98f) && ((Pawn->Floor | Move.Delta) < 0.f) )
+		{
+			return;
+		}
+
+		// Rather than replicating APawn::CheckForLedges, require footing where it would look for a ledge.
+		if( Move.bLedgeCheck )
+		{
+			FVector Destination = Move.StartLocation + Move.Delta;
+			if( Pawn->bAvoidLedges )
+			{
+				Destination += AccelDir * Pawn->CylinderComponent->CollisionRadius;
+			}
+			if( Move.Snapshot.LineCheck( Hit, Destination + GravDir * (Pawn->MaxStepHeight + 4.f), Destination, Extent ) || Hit.Normal.Z < UCONST_MINFLOORZ )
+			{
+				return;
+			}
+		}
+
+		// The move has to be unblocked, including the extra distance ULevel::MoveActor tests.
+		const FVector TestDelta = Move.Delta + 2.f * Move.Delta.SafeNormal();
+		if( !Move.Snapshot.LineCheck( Hit, Move.StartLocation + TestDelta, Move.StartLocation, Extent ) )
+		{
+			return;
+		}
+
+		// Zone changes send script events.
+		const FPointRegion NewRegion = Level->Model->PointRegion( Level->GetLevelInfo(), Move.StartLocation + Move.Delta );
+		if( NewRegion.ZoneNumber != Pawn->Region.ZoneNumber )
+		{
+			return;
+		}
+	}
+
+	// The pawn has to end up at the right height above its current base, on a floor too flat to slide down.
+	const FVector	NewLocation	= Move.StartLocation + Move.Delta;
+	const FLOAT		DropDist	= Pawn->MaxStepHeight + 2.f;
+	if( Move.Snapshot.LineCheck( Hit, NewLocation + GravDir * DropDist, NewLocation, Extent ) )
+	{
+		return;
+	}
+	const FLOAT FloorDist = Hit.Time * DropDist;
+	if(	Hit.Actor != Pawn->Base
+	||	FloorDist < MINFLOORDIST
+	||	FloorDist > MAXFLOORDIST
+	||	Hit.Normal.Z < UCONST_MINFLOORZ
+	||	((Hit.Normal.Z < 0.99f) && ((Hit.Normal.Z * Pawn->PhysicsVolume->GroundFriction) < 3.3f)) )
+	{
+		return;
+	}
+
+	Move.NewFloor	= Hit.Normal;
+	Move.bValid		= TRUE;
+}
+
+/**
+ * Applies a simulated move, or runs regular physics if the move was rejected or
+ * its pawn has changed since.
+ */
+void FPawnMovementPhase::CommitMove( const FDeferredMove& Deferred, const FPawnMove& Move )
+{
+	APawn* Pawn = Deferred.Pawn;
+	if( Pawn->bDeleteMe )
+	{
+		return;
+	}
+
+	// Events sent by moves committed before this one may have changed the pawn.
+	if( Move.bValid
+	&&	Pawn->Location == Move.StartLocation
+	&&	Pawn->Velocity == Move.StartVelocity
+	&&	Pawn->Acceleration == Move.StartAcceleration
+	&&	CanDefer( Pawn, Deferred.DeltaSeconds ) )
+	{
+		const FVector OldLocation = Pawn->Location;
+		Pawn->Velocity			= Move.NewVelocity;
+		Pawn->Acceleration		= Move.NewAcceleration;
+		Pawn->bJustTeleported	= 0;
+
+		FCheckResult Hit(1.f);
+		if( !Move.Delta.IsZero() )
+		{
+			Level->MoveActor( Pawn, Move.Delta, Pawn->Rotation, Hit );
+		}
+		if( Hit.Time < 1.f )
+		{
+			// Something the snapshot didn't know about got in the way, walk the rest of the way regularly.
+			Pawn->startNewPhysics( Deferred.DeltaSeconds * (1.f - Hit.Time), 1 );
+		}
+		else
+		{
+			Pawn->Floor = Move.NewFloor;
+			if( !Pawn->bJustTeleported && !Pawn->bNoVelocityUpdate )
+			{
+				Pawn->Velocity = (Pawn->Location - OldLocation) / Deferred.DeltaSeconds;
+			}
+			Pawn->bNoVelocityUpdate = 0;
+			Pawn->Velocity.Z = 0.f;
+		}
+	}
+	else
+	{
+		Pawn->startNewPhysics( Deferred.DeltaSeconds, 0 );
+	}
+
+	if( !Pawn->bDeleteMe )
+	{
+		Pawn->finishPhysics( Deferred.DeltaSeconds, Deferred.OldVelocity );
+	}
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
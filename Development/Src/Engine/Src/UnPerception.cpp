@@ -0,0 +1,482 @@
+/*=============================================================================
+	UnPerception.cpp: Batched AI sight and hearing.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "EnginePrivate.h"
+#include "UnPerception.h"
+
+IMPLEMENT_COMPARE_CONSTREF( INT, UnPerception, { return A - B; } )
+
+/**
+ * Returns the key of the grid cell with the passed in coordinates.
+ */
+static FORCEINLINE QWORD GetPerceptionGridKey( INT X, INT Y, INT Z )
+{
+	return ((QWORD)(X & 0x1FFFFF) << 42) | ((QWORD)(Y & 0x1FFFFF) << 21) | (QWORD)(Z & 0x1FFFFF);
+}
+
+/**
+ * Returns the level's perception manager, creating it if necessary.
+ */
+FPerceptionManager* ULevel::GetPerception()
+{
+	if( !Perception )
+	{
+		Perception = new FPerceptionManager( this );
+	}
+	return Perception;
+}
+
+/*-----------------------------------------------------------------------------
+	FPerceptionManager implementation.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Constructor, reading the budget settings from the engine ini.
+ *
+ * @param	InLevel		Level whose controllers are managed
+ */
+FPerceptionManager::FPerceptionManager( ULevel* InLevel )
+:	Level( InLevel ),
+	MaxSightChecksPerFrame( 64 ),
+	SightChecksThisFrame( 0 ),
+	LastCachePruneTime( 0.f )
+{
+	GConfig->GetInt( TEXT("Engine.Perception"), TEXT("MaxSightChecksPerFrame"), MaxSightChecksPerFrame, GEngineIni );
+	MaxSightChecksPerFrame = Max( MaxSightChecksPerFrame, 1 );
+}
+
+/**
+ * Requests a controller's pawn to be shown to all controllers ready to see it,
+ * replacing AController::ShowSelf.
+ *
+ * @param	Controller	Controller whose pawn is shown
+ */
+void FPerceptionManager::AddShowSelf( AController* Controller )
+{
+	ShowSelfRequests.AddUniqueItem( Controller );
+}
+
+/**
+ * Requests a check whether a controller can still see its enemy, replacing
+ * AController::CheckEnemyVisible.
+ *
+ * @param	Controller	Controller to check enemy visibility for
+ */
+void FPerceptionManager::AddEnemyCheck( AController* Controller )
+{
+	EnemyCheckRequests.AddUniqueItem( Controller );
+}
+
+/**
+ * Requests a noise to be delivered to all controllers that can hear it.
+ *
+ * @param	Maker			Actor making the noise
+ * @param	Loudness		Loudness of noise
+ * @param	bOnlySameTag	Whether only controllers with the same tag as Maker can hear the noise
+ */
+void FPerceptionManager::AddNoise( AActor* Maker, FLOAT Loudness, UBOOL bOnlySameTag )
+{
+	FPendingNoise* Noise	= new(PendingNoises) FPendingNoise;
+	Noise->Maker			= Maker;
+	Noise->Instigator		= Maker->Instigator;
+	Noise->Location			= Maker->Location;
+	Noise->Loudness			= Loudness;
+	Noise->bOnlySameTag		= bOnlySameTag;
+}
+
+/**
+ * Runs all checks requested since the last call and delivers the resulting events.
+ */
+void FPerceptionManager::Tick()
+{
+	ALevelInfo*	LevelInfo	= Level->GetLevelInfo();
+	const FLOAT	Now			= LevelInfo->TimeSeconds;
+
+	// Take ownership of this frame's requests so checks requested by delivered events go into the next batch.
+	TArray<AController*>	ShowSelfs		= ShowSelfRequests;
+	TArray<AController*>	EnemyChecks		= EnemyCheckRequests;
+	TArray<FPendingNoise>	Noises			= PendingNoises;
+	TMap<FPerceptionPair,FPendingSight>	Deferred	= DeferredSights;
+	ShowSelfRequests.Empty();
+	EnemyCheckRequests.Empty();
+	PendingNoises.Empty();
+	DeferredSights.Empty();
+	Events.Empty( Events.Num() );
+	SightChecksThisFrame = 0;
+
+	// Enemy checks come first as losing sight of an enemy matters most, whatever is over budget waits a frame.
+	for( INT CheckIndex=0; CheckIndex<EnemyChecks.Num(); CheckIndex++ )
+	{
+		AController* Controller = EnemyChecks(CheckIndex);
+		if( Controller->bDeleteMe || !Controller->Enemy || !Controller->IsProbing(NAME_EnemyNotVisible) )
+		{
+			continue;
+		}
+		if( SightChecksThisFrame >= MaxSightChecksPerFrame )
+		{
+			EnemyCheckRequests.AddUniqueItem( Controller );
+			continue;
+		}
+		SightChecksThisFrame++;
+		check(Controller->Enemy->IsValid());
+		if( !Controller->LineOfSightTo(Controller->Enemy) )
+		{
+			FPerceptionEvent* Event	= new(Events) FPerceptionEvent;
+			Event->Type				= FPerceptionEvent::PE_EnemyNotVisible;
+			Event->Controller		= Controller;
+			Event->Other			= NULL;
+			Event->Loudness			= 0.f;
+		}
+	}
+
+	// Sight checks deferred last frame go before new ones so none of them starve.
+	for( TMap<FPerceptionPair,FPendingSight>::TIterator It(Deferred); It; ++It )
+	{
+		const FPendingSight& Sight = It.Value();
+		if( !Sight.Observer->bDeleteMe && Sight.Observer->Pawn && !Sight.Target->bDeleteMe && Sight.Target->Controller )
+		{
+			CheckSight( Sight.Observer, Sight.Target, Sight.bTargetIsPlayer );
+		}
+	}
+
+	// Show pawns to the controllers ready to see them, only looking at controllers within sight radius.
+	if( ShowSelfs.Num() )
+	{
+		TArray<AController*> Observers;
+		FLOAT MaxSightRadius = 0.f;
+		for( AController* Controller=LevelInfo->ControllerList; Controller; Controller=Controller->NextController )
+		{
+			if( !Controller->bDeleteMe
+			&&	Controller->Pawn
+			&&	Controller->SightCounter < 0.f
+			&&	(Controller->IsProbing(NAME_SeePlayer) || Controller->IsProbing(NAME_SeeMonster)) )
+			{
+				Observers.AddItem( Controller );
+				MaxSightRadius = Max( MaxSightRadius, Controller->Pawn->SightRadius );
+			}
+		}
+		BuildGrid( Observers );
+
+		TArray<AController*> Nearby;
+		for( INT ShowIndex=0; ShowIndex<ShowSelfs.Num(); ShowIndex++ )
+		{
+			AController*	Shown	= ShowSelfs(ShowIndex);
+			APawn*			Target	= Shown->Pawn;
+			if( Shown->bDeleteMe || !Target || Target->bDeleteMe )
+			{
+				continue;
+			}
+			GatherNearby( Observers, Target->Location, MaxSightRadius, Nearby );
+			for( INT ObserverIndex=0; ObserverIndex<Nearby.Num(); ObserverIndex++ )
+			{
+				AController* Observer = Nearby(ObserverIndex);
+				if( Observer != Shown
+				&&	(Shown->bIsPlayer || Observer->bIsPlayer)
+				&&	(Shown->bIsPlayer ? Observer->IsProbing(NAME_SeePlayer) : Observer->IsProbing(NAME_SeeMonster))
+				&&	PassesSightCull( Observer, Target ) )
+				{
+					CheckSight( Observer, Target, Shown->bIsPlayer );
+				}
+			}
+		}
+	}
+
+	// Deliver noises to the controllers close enough to possibly hear them.
+	if( Noises.Num() )
+	{
+		TArray<AController*> Listeners;
+		FLOAT MaxHearingFactor = 0.f;
+		for( AController* Controller=LevelInfo->ControllerList; Controller; Controller=Controller->NextController )
+		{
+			if( !Controller->bDeleteMe && Controller->Pawn && Controller->IsProbing(NAME_HearNoise) )
+			{
+				Listeners.AddItem( Controller );
+				MaxHearingFactor = Max( MaxHearingFactor, Square(Controller->Pawn->HearingThreshold) * Max(0.f, Controller->Pawn->Alertness + 1.f) );
+			}
+		}
+		BuildGrid( Listeners );
+
+		TArray<AController*> Nearby;
+		for( INT NoiseIndex=0; NoiseIndex<Noises.Num(); NoiseIndex++ )
+		{
+			const FPendingNoise& Noise = Noises(NoiseIndex);
+			if( Noise.Maker->bDeleteMe )
+			{
+				continue;
+			}
+
+			// AController::CanHear rejects anything further away than this.
+			GatherNearby( Listeners, Noise.Location, appSqrt( Noise.Loudness * MaxHearingFactor ), Nearby );
+			for( INT ListenerIndex=0; ListenerIndex<Nearby.Num(); ListenerIndex++ )
+			{
+				AController* Listener = Nearby(ListenerIndex);
+				if( Listener->Pawn != Noise.Instigator
+				&&	(!Noise.bOnlySameTag || Listener->Tag == Noise.Maker->Tag)
+				&&	Listener->CanHear( Noise.Location, Noise.Loudness, Noise.Maker ) )
+				{
+					FPerceptionEvent* Event	= new(Events) FPerceptionEvent;
+					Event->Type				= FPerceptionEvent::PE_HearNoise;
+					Event->Controller		= Listener;
+					Event->Other			= Noise.Maker;
+					Event->Loudness			= Noise.Loudness;
+				}
+			}
+		}
+	}
+
+	// Deliver all events, skipping those whose controller or subject went away in the meantime.
+	for( INT EventIndex=0; EventIndex<Events.Num(); EventIndex++ )
+	{
+		const FPerceptionEvent Event = Events(EventIndex);
+		if( Event.Controller->bDeleteMe )
+		{
+			continue;
+		}
+		switch( Event.Type )
+		{
+		case FPerceptionEvent::PE_SeePlayer:
+			if( !Event.Other->bDeleteMe )
+			{
+				Event.Controller->eventSeePlayer( (APawn*) Event.Other );
+			}
+			break;
+		case FPerceptionEvent::PE_SeeMonster:
+			if( !Event.Other->bDeleteMe )
+			{
+				Event.Controller->eventSeeMonster( (APawn*) Event.Other );
+			}
+			break;
+		case FPerceptionEvent::PE_EnemyNotVisible:
+			if( Event.Controller->Enemy && Event.Controller->IsProbing(NAME_EnemyNotVisible) )
+			{
+				Event.Controller->eventEnemyNotVisible();
+			}
+			break;
+		case FPerceptionEvent::PE_HearNoise:
+			if( !Event.Other->bDeleteMe )
+			{
+				Event.Controller->eventHearNoise( Event.Loudness, Event.Other );
+			}
+			break;
+		}
+	}
+	Events.Empty( Events.Num() );
+
+	// Drop visibility results that have expired.
+	if( Now - LastCachePruneTime > 1.f )
+	{
+		LastCachePruneTime = Now;
+		for( TMap<FPerceptionPair,FVisibilityResult>::TIterator It(VisibilityCache); It; ++It )
+		{
+			if( Now - It.Value().Time > CACHE_LIFETIME_MS * 0.001f )
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+}
+
+/**
+ * Removes all references to actors that are about to be deleted.
+ */
+void FPerceptionManager::CleanupDestroyed()
+{
+	for( INT Index=0; Index<ShowSelfRequests.Num(); Index++ )
+	{
+		if( ShowSelfRequests(Index)->bDeleteMe )
+		{
+			ShowSelfRequests.Remove( Index-- );
+		}
+	}
+	for( INT Index=0; Index<EnemyCheckRequests.Num(); Index++ )
+	{
+		if( EnemyCheckRequests(Index)->bDeleteMe )
+		{
+			EnemyCheckRequests.Remove( Index-- );
+		}
+	}
+	for( INT Index=0; Index<PendingNoises.Num(); Index++ )
+	{
+		const FPendingNoise& Noise = PendingNoises(Index);
+		if( Noise.Maker->bDeleteMe || (Noise.Instigator && Noise.Instigator->bDeleteMe) )
+		{
+			PendingNoises.Remove( Index-- );
+		}
+	}
+	for( TMap<FPerceptionPair,FPendingSight>::TIterator It(DeferredSights); It; ++It )
+	{
+		if( It.Key().Observer->bDeleteMe || It.Key().Target->bDeleteMe )
+		{
+			It.RemoveCurrent();
+		}
+	}
+	for( TMap<FPerceptionPair,FVisibilityResult>::TIterator It(VisibilityCache); It; ++It )
+	{
+		if( It.Key().Observer->bDeleteMe || It.Key().Target->bDeleteMe )
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+/**
+ * Buckets controllers into Grid.
+ *
+ * @param	Controllers		Controllers to bucket, all of which need a pawn
+ */
+void FPerceptionManager::BuildGrid( const TArray<AController*>& Controllers )
+{
+	Grid.Empty();
+	for( INT ControllerIndex=0; ControllerIndex<Controllers.Num(); ControllerIndex++ )
+	{
+		const FVector& Location = Controllers(ControllerIndex)->Pawn->Location;
+		const QWORD Key = GetPerceptionGridKey( appFloor(Location.X / GRID_CELL_SIZE), appFloor(Location.Y / GRID_CELL_SIZE), appFloor(Location.Z / GRID_CELL_SIZE) );
+		TArray<INT>* Cell = Grid.Find( Key );
+		if( !Cell )
+		{
+			Grid.Set( Key, TArray<INT>() );
+			Cell = Grid.Find( Key );
+		}
+		Cell->AddItem( ControllerIndex );
+	}
+}
+
+/**
+ * Gathers the controllers bucketed into cells overlapping a sphere.
+ *
+ * @param	Controllers		Controllers Grid was built from
+ * @param	Center			Center of sphere
+ * @param	Radius			Radius of sphere
+ * @param	Result			[out] controllers in overlapping cells, in Controllers order
+ */
+void FPerceptionManager::GatherNearby( const TArray<AController*>& Controllers, const FVector& Center, FLOAT Radius, TArray<AController*>& Result )
+{
+	Result.Empty( Result.Num() );
+
+	const INT MinX = appFloor((Center.X - Radius) / GRID_CELL_SIZE), MaxX = appFloor((Center.X + Radius) / GRID_CELL_SIZE);
+	const INT MinY = appFloor((Center.Y - Radius) / GRID_CELL_SIZE), MaxY = appFloor((Center.Y + Radius) / GRID_CELL_SIZE);
+	const INT MinZ = appFloor((Center.Z - Radius) / GRID_CELL_SIZE), MaxZ = appFloor((Center.Z + Radius) / GRID_CELL_SIZE);
+
+	// Looking up more cells than there are controllers is slower than taking all of them.
+	if( (FLOAT)(MaxX - MinX + 1) * (MaxY - MinY + 1) * (MaxZ - MinZ + 1) > Controllers.Num() )
+	{
+		Result = Controllers;
+		return;
+	}
+
+	TArray<INT> Indices;
+	for( INT X=MinX; X<=MaxX; X++ )
+	{
+		for( INT Y=MinY; Y<=MaxY; Y++ )
+		{
+			for( INT Z=MinZ; Z<=MaxZ; Z++ )
+			{
+				const TArray<INT>* Cell = Grid.Find( GetPerceptionGridKey( X, Y, Z ) );
+				if( Cell )
+				{
+					for( INT CellIndex=0; CellIndex<Cell->Num(); CellIndex++ )
+					{
+						Indices.AddItem( (*Cell)(CellIndex) );
+					}
+				}
+			}
+		}
+	}
+
+	// Keep ControllerList order so events are delivered in the same order as before batching.
+	if( Indices.Num() )
+	{
+		Sort<USE_COMPARE_CONSTREF(INT,UnPerception)>( &Indices(0), Indices.Num() );
+	}
+	for( INT Index=0; Index<Indices.Num(); Index++ )
+	{
+		Result.AddItem( Controllers(Indices(Index)) );
+	}
+}
+
+/**
+ * Returns whether a sight check has to be run at all, applying the distance and
+ * field of view tests of AController::SeePawn before any trace is spent on it.
+ */
+UBOOL FPerceptionManager::PassesSightCull( AController* Observer, APawn* Target )
+{
+	// Enemies are always traced.
+	if( Target == Observer->Enemy )
+	{
+		return TRUE;
+	}
+
+	APawn*	Pawn	= Observer->Pawn;
+	FLOAT	MaxDist	= Pawn->SightRadius * Min(1.f, (FLOAT)(Target->Visibility * 0.0078125f)); // * 1/128
+	FVector	Delta	= Target->Location - Pawn->Location;
+	if( Delta.SizeSquared() > MaxDist * MaxDist )
+	{
+		return FALSE;
+	}
+	return (Delta.SafeNormal() | Observer->Rotation.Vector()) >= Pawn->PeripheralVision;
+}
+
+/**
+ * Runs or defers a sight check, using a cached result if possible.
+ *
+ * @return	TRUE if the check was run or answered from the cache, FALSE if it was deferred
+ */
+UBOOL FPerceptionManager::CheckSight( AController* Observer, APawn* Target, UBOOL bTargetIsPlayer )
+{
+	const FLOAT				Now		= Level->GetLevelInfo()->TimeSeconds;
+	const FPerceptionPair	Pair( Observer, Target );
+
+	// Enemy checks update the observer's enemy info so they are never answered from the cache.
+	const UBOOL bCacheable = Target != Observer->Enemy;
+	UBOOL bVisible = FALSE;
+
+	FVisibilityResult* Cached = bCacheable ? VisibilityCache.Find( Pair ) : NULL;
+	if( Cached
+	&&	Now - Cached->Time <= CACHE_LIFETIME_MS * 0.001f
+	&&	(Cached->ObserverLocation - Observer->Pawn->Location).SizeSquared() < Square(CACHE_MAX_MOVEMENT)
+	&&	(Cached->TargetLocation - Target->Location).SizeSquared() < Square(CACHE_MAX_MOVEMENT) )
+	{
+		bVisible = Cached->bVisible;
+	}
+	else if( SightChecksThisFrame >= MaxSightChecksPerFrame )
+	{
+		// Requesting the same check again while it waits only refreshes it, so the queue can't outgrow the number of pairs.
+		FPendingSight Sight;
+		Sight.Observer			= Observer;
+		Sight.Target			= Target;
+		Sight.bTargetIsPlayer	= bTargetIsPlayer;
+		DeferredSights.Set( Pair, Sight );
+		return FALSE;
+	}
+	else
+	{
+		SightChecksThisFrame++;
+		bVisible = Observer->SeePawn( Target ) != 0;
+		if( bCacheable )
+		{
+			FVisibilityResult Result;
+			Result.Time				= Now;
+			Result.ObserverLocation	= Observer->Pawn->Location;
+			Result.TargetLocation	= Target->Location;
+			Result.bVisible			= bVisible;
+			VisibilityCache.Set( Pair, Result );
+		}
+	}
+
+	if( bVisible )
+	{
+		FPerceptionEvent* Event	= new(Events) FPerceptionEvent;
+		Event->Type				= bTargetIsPlayer ? FPerceptionEvent::PE_SeePlayer : FPerceptionEvent::PE_SeeMonster;
+		Event->Controller		= Observer;
+		Event->Other			= Target;
+		Event->Loudness			= 0.f;
+	}
+	return TRUE;
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
@@ -8,6 +8,7 @@
 =============================================================================*/
 
 #include "EnginePrivate.h"
+#include "UnPawnMovement.h"
 
 #include "EngineSequenceClasses.h"
 #include "EngineInterpolationClasses.h"
@@ -250,8 +251,18 @@ void APawn::performPhysics(FLOAT DeltaSeconds)
 		}
 	}
 
-	// change position
+	// change position, AI pawns walking around may be moved later on by the level's movement phase
+	if ( GetLevel()->GetPawnMovement()->DeferPhysics(this, DeltaSeconds, OldVelocity) )
+		return;
 	startNewPhysics(DeltaSeconds,0);
+	finishPhysics(DeltaSeconds, OldVelocity);
+}
+
+/* finishPhysics()
+Updates crouching, rotation and pending touches once the pawn has moved
+*/
+void APawn::finishPhysics(FLOAT DeltaSeconds, FVector OldVelocity)
+{
 	bSimulateGravity = ( (Physics == PHYS_Falling) || (Physics == PHYS_Walking) );
 
 	// uncrouch if no longer desiring crouch
@@ -52,6 +52,9 @@ void FResourceManager::AllocateResource(FResource* Resource)
 void FResourceManager::FreeResource(FResource* Resource)
 {
 	check( Resource->ResourceIndex != INDEX_NONE );
+
+	// Textures stay known to the streamer across frames, pending requests have to be flushed though.
+	GStreamingManager->RemoveResource( Resource );
 	check( !GStreamingManager->IsResourceConsidered( Resource ) );
 
 	// Deregister the resource with all the resource clients.
@@ -93,6 +96,7 @@ FTextureMipRequest* FResourceManager::RequestMips( FTextureBase* Texture, UINT R
 		appMemzero( TextureMipRequest, sizeof(FTextureMipRequest) );
 		TextureMipRequest->Texture		 = Texture;
 		TextureMipRequest->RequestedMips = RequestedMips;
+		TextureMipRequest->IOPriority	 = AIOP_Normal;
 	}
 
 	if( Clients.Num() )
@@ -91,33 +91,51 @@ UBOOL APawn::ValidAnchor()
 	return false;
 }
 
-typedef FLOAT ( *NodeEvaluator ) (ANavigationPoint*, APawn*, FLOAT);
+//#define DEBUG_PATHFIND
+
+/** Path queries available to searches on the game thread; searches can nest through script events */
+static TArray<FPathQuery*> GFreePathQueries;
 
-static FLOAT FindEndPoint( ANavigationPoint* CurrentNode, APawn* seeker, FLOAT bestWeight )
+/**
+ * Clears transient path finding properties of all navigation points, for searches
+ * that are answered without querying the navigation network.
+ */
+static void ClearForPathFinding( ALevelInfo* LevelInfo )
 {
-	if ( CurrentNode->bEndPoint )
+	for ( ANavigationPoint *Nav=LevelInfo->NavigationPointList; Nav; Nav=Nav->nextNavigationPoint )
+		Nav->ClearForPathFinding();
+}
+
+FLOAT APawn::findPathToward(AActor *goal, FVector GoalLocation, NodeEvaluator NodeEval, FLOAT BestWeight, UBOOL bWeightDetours)
+{
+	FPathQuery* Query = GFreePathQueries.Num() ? GFreePathQueries.Pop() : new FPathQuery();
+	FLOAT Result = 0.f;
+	if ( PreparePathQuery(*Query, goal, GoalLocation, NodeEval, BestWeight, bWeightDetours, Result) )
 	{
-//		debugf(TEXT("Found endpoint %s"),CurrentNode->GetName());
-		return 2.f;
+		Query->Execute();
+		Result = FinishPathQuery(*Query);
 	}
-	else
-		return 0.f;
+	GFreePathQueries.AddItem(Query);
+	return Result;
 }
 
-//#define DEBUG_PATHFIND
-
-FLOAT APawn::findPathToward(AActor *goal, FVector GoalLocation, NodeEvaluator NodeEval, FLOAT BestWeight, UBOOL bWeightDetours)
+/* PreparePathQuery()
+Finds the anchors of a search and sets up the query. Returns false if no search is needed,
+in which case Result holds what findPathToward should return. Game thread only.
+*/
+UBOOL APawn::PreparePathQuery(FPathQuery& Query, AActor *goal, FVector GoalLocation, NodeEvaluator NodeEval, FLOAT BestWeight, UBOOL bWeightDetours, FLOAT& Result)
 {
 #ifdef DEBUG_PATHFIND
 	debugf(TEXT("%s FindPathToward: %s"),GetName(), goal != NULL ? goal->GetName() : TEXT("Point"));
 #endif
+	Result = 0.f;
 	NextPathRadius = 0.f;
 	if ( !Level->NavigationPointList || (FindAnchorFailedTime == Level->TimeSeconds) || !Controller )
 	{
 #ifdef DEBUG_PATHFIND
 		debugf(TEXT("- initial abort, %2.1f"),FindAnchorFailedTime);
 #endif
-		return 0.f;
+		return false;
 	}
 
 	Controller->RouteCache.Empty();
@@ -208,7 +226,6 @@ FLOAT APawn::findPathToward(AActor *goal, FVector GoalLocation, NodeEvaluator No
 		int dist;
 		for ( ANavigationPoint *Nav=Level->NavigationPointList; Nav; Nav=Nav->nextNavigationPoint )
 		{
-			Nav->ClearForPathFinding();
 			if ( !Nav->bBlocked )
 			{
 				if ( !Anchor )
@@ -234,8 +251,9 @@ FLOAT APawn::findPathToward(AActor *goal, FVector GoalLocation, NodeEvaluator No
 				Anchor = StartPoints.findStartAnchor(this);
 			if ( !Anchor )
 			{
+				ClearForPathFinding(Level);
 				FindAnchorFailedTime = Level->TimeSeconds;
-				return 0.f;
+				return false;
 			}
 			LastValidAnchorTime = Level->TimeSeconds;
 			LastAnchor = Anchor;
@@ -252,7 +270,10 @@ FLOAT APawn::findPathToward(AActor *goal, FVector GoalLocation, NodeEvaluator No
 			if ( DestPoints.numPoints > 0 )
 				EndAnchor = DestPoints.findEndAnchor(this, goal, GoalLocation, (goal && Controller->AcceptNearbyPath(goal)), bOnlyCheckVisible );
 			if ( !EndAnchor )
-				return 0.f;
+			{
+				ClearForPathFinding(Level);
+				return false;
+			}
 			if ( goal )
 			{
 				APawn* PawnGoal = goal->GetAPawn();
@@ -278,12 +299,13 @@ FLOAT APawn::findPathToward(AActor *goal, FVector GoalLocation, NodeEvaluator No
 			// no way to get closer on the navigation network
 			INT PassedAnchor = 0;
 
+			ClearForPathFinding(Level);
 			if ( ReachedDestination(Anchor->Location - Location, goal) )
 			{
 				PassedAnchor = 1;
 				if ( !goal )
 				{
-					return 0.f;
+					return false;
 				}
 			}
 			else
@@ -305,44 +327,50 @@ FLOAT APawn::findPathToward(AActor *goal, FVector GoalLocation, NodeEvaluator No
 			{
 				Controller->RouteCache.AddItem(Anchor);
 			}
-			return (GoalLocation - Location).Size();
+			Result = (GoalLocation - Location).Size();
+			return false;
 		}
 	}
-	else
-	{
-		for ( ANavigationPoint *Nav=Level->NavigationPointList; Nav; Nav=Nav->nextNavigationPoint )
-			Nav->ClearForPathFinding();
-	}
 	//debugf(TEXT("Found anchors"));
 
-	if ( EndAnchor )
-		EndAnchor->bEndPoint = 1;
-
 	GetLevel()->FarMoveActor(this, RealLocation, 1, 1);
-	Anchor->visitedWeight = appRound(StartDist);
-	if ( bSpecifiedEnd )
-	{
-		NodeEval = &FindEndPoint;
-	}
 #ifdef DEBUG_PATHFIND
-	debugf(TEXT("- searching for path from %s to %s"),Anchor->GetName(),EndAnchor->GetName());
+	debugf(TEXT("- searching for path from %s to %s"),Anchor->GetName(),EndAnchor ? EndAnchor->GetName() : TEXT("None"));
 #endif
-	ANavigationPoint* BestDest = breadthPathTo(NodeEval,Anchor,calcMoveFlags(),&BestWeight, bWeightDetours);
-	if ( BestDest )
+	// Clears the transient path finding properties of all navigation points, even if there is nothing to search.
+	if ( !Query.Prepare(this, Anchor, appRound(StartDist), EndAnchor, bSpecifiedEnd ? NULL : NodeEval, BestWeight) )
 	{
-#ifdef DEBUG_PATHFIND
-		debugf(TEXT("- found path!"));
-#endif
-		Controller->SetRouteCache(BestDest,StartDist,EndDist);
-		return BestWeight;
+		ClearForPathFinding(Level);
+		return false;
 	}
-#ifdef DEBUG_PATHFIND
-	else
+	Query.StartDist			= StartDist;
+	Query.EndDist			= EndDist;
+	Query.bWeightDetours	= bWeightDetours;
+	return true;
+}
+
+/* FinishPathQuery()
+Applies the result of an executed query to the controller's route cache. Returns the weight
+of the best destination found, or 0 if there was none. Game thread only.
+*/
+FLOAT APawn::FinishPathQuery(FPathQuery& Query)
+{
+	Query.Finish();
+	if ( !Query.GetBestDest() || !Controller )
 	{
+#ifdef DEBUG_PATHFIND
 		debugf(TEXT("- no path!"));
+#endif
+		return 0.f;
 	}
+#ifdef DEBUG_PATHFIND
+	debugf(TEXT("- found path!"));
 #endif
-	return 0.f;
+	TArray<ANavigationPoint*> Route;
+	Query.GetRoute(Route);
+	CheckDetour(Query, Route);
+	Controller->SetRouteCache(Route, Query.GetWeight(Query.GetBestDest()), Query.StartDist, Query.EndDist);
+	return Query.GetBestWeight();
 }
 
 /* addPath()
@@ -398,161 +426,18 @@ void FSortedPathList::addPath(ANavigationPoint *node, INT dist)
 }
 }
 
-//-------------------------------------------------------------------------------------------------
-/* breadthPathTo()
-Breadth First Search through navigation network
-starting from path bot is on.
-
-Return when NodeEval function returns 1
+/* CheckDetour()
+Offers the controller a detour through a neighbor of the anchor that isn't on the route,
+inserting it into the route if the controller accepts.
 */
-ANavigationPoint* APawn::breadthPathTo(NodeEvaluator NodeEval, ANavigationPoint *start, int moveFlags, FLOAT *Weight, UBOOL bWeightDetours)
-{
-	ANavigationPoint* currentnode = start;
-	ANavigationPoint* nextnode = NULL;
-	ANavigationPoint* LastAdd = currentnode;
-	ANavigationPoint* BestDest = NULL;
-
-	INT iRadius = appFloor(CylinderComponent->CollisionRadius);
-	INT iHeight = appFloor(CylinderComponent->CollisionHeight);
-	INT iMaxFallSpeed = appFloor(MaxFallSpeed);
-	FLOAT CrouchMultiplier = CROUCHCOSTMULTIPLIER * 1.f/CrouchedPct;
-	APawn* DefaultPawn = (APawn*)(GetClass()->GetDefaultActor());
-	INT DefaultCollisionHeight = DefaultPawn->CylinderComponent->CollisionHeight;
-	
-	if ( bCanCrouch )
-	{
-		iHeight = appFloor(CrouchHeight);
-		iRadius = appFloor(CrouchRadius);
-	}
-	INT n = 0;
-	if ( Controller )
-		Controller->eventSetupSpecialPathAbilities();
-
-	while ( currentnode )
-	{
-		currentnode->bAlreadyVisited = true;
-#ifdef DEBUG_PATHFIND
-		debugf(TEXT("-> Distance to %s is %d"), currentnode->GetName(), currentnode->visitedWeight);
-#endif
-		FLOAT thisWeight = (*NodeEval)(currentnode, this, *Weight);
-		if ( thisWeight > *Weight )
-		{
-			*Weight = thisWeight;
-			BestDest = currentnode;
-		}
-		if ( *Weight >= 1.f )
-		{
-			return CheckDetour(BestDest, start, bWeightDetours);
-		}
-		if ( n++ > 200 )
-		{
-			if ( *Weight > 0 )
-			{
-				return CheckDetour(BestDest, start, bWeightDetours);
-			}
-			else
-			{
-				n = 150;
-			}
-		}
-		INT nextweight = 0;
-
-		for ( INT i=0; i<currentnode->PathList.Num(); i++ )
-		{
-			ANavigationPoint* endnode = NULL;
-			UReachSpec *spec = currentnode->PathList(i);
-#ifdef DEBUG_PATHFIND
-			debugf(TEXT("-> check path from %s to %s with %d, %d, supports? %s, visited? %s"),spec->Start->GetName(), spec->End->GetName(), spec->CollisionRadius, spec->CollisionHeight, spec->supports(iRadius, iHeight, moveFlags, iMaxFallSpeed) ? TEXT("True") : TEXT("False"), spec->End->bAlreadyVisited ? TEXT("TRUE") : TEXT("FALSE"));
-#endif
-			if ( spec && spec->End && !spec->End->bAlreadyVisited && spec->supports(iRadius, iHeight, moveFlags, iMaxFallSpeed) )
-			{
-				endnode = spec->End;
-				if ( !endnode->bBlocked && (!endnode->bMayCausePain || !HurtByVolume(endnode)) )
-				{
-					if ( spec->bForced && endnode->bSpecialForced )
-					{
-						nextweight = spec->Distance + endnode->eventSpecialCost(this,spec);
-					}
-					else if( spec->CollisionHeight >= DefaultPawn->CylinderComponent->CollisionHeight )
-					{
-						nextweight = spec->Distance + endnode->cost;
-					}
-					else
-					{
-						nextweight = CrouchMultiplier * spec->Distance + endnode->cost;
-					}
-					
-					if ( nextweight <= 0 )
-					{
-						debugf(TEXT("WARNING - negative weight %d from %s to %s"), nextweight, currentnode->GetName(), endnode->GetName());
-						nextweight = 1;
-					}
-					INT newVisit = nextweight + currentnode->visitedWeight; 
-#ifdef DEBUG_PATHFIND
-					debugf(TEXT("--> Path from %s to %s costs %d total %d"), currentnode->GetName(), endnode->GetName(), nextweight, newVisit);
-#endif
-					if ( endnode->visitedWeight > newVisit )
-					{
-						// found a better path to endnode
-						endnode->previousPath = currentnode;
-						if ( endnode->prevOrdered ) //remove from old position
-						{
-							endnode->prevOrdered->nextOrdered = endnode->nextOrdered;
-							if (endnode->nextOrdered)
-							{
-								endnode->nextOrdered->prevOrdered = endnode->prevOrdered;
-							}
-							if ( (LastAdd == endnode) || (LastAdd->visitedWeight > endnode->visitedWeight) )
-							{
-								LastAdd = endnode->prevOrdered;
-							}
-							endnode->prevOrdered = NULL;
-							endnode->nextOrdered = NULL;
-						}
-						endnode->visitedWeight = newVisit;
-
-						// LastAdd is a good starting point for searching the list and inserting this node
-						nextnode = LastAdd;
-						if ( nextnode->visitedWeight <= newVisit )
-						{
-							while (nextnode->nextOrdered && (nextnode->nextOrdered->visitedWeight < newVisit))
-							{
-								nextnode = nextnode->nextOrdered;
-							}
-						}
-						else
-						{
-							while ( nextnode->prevOrdered && (nextnode->visitedWeight > newVisit) )
-							{
-								nextnode = nextnode->prevOrdered;
-							}
-						}
-
-						if (nextnode->nextOrdered != endnode)
-						{
-							if (nextnode->nextOrdered)
-								nextnode->nextOrdered->prevOrdered = endnode;
-							endnode->nextOrdered = nextnode->nextOrdered;
-							nextnode->nextOrdered = endnode;
-							endnode->prevOrdered = nextnode;
-						}
-						LastAdd = endnode;
-					}
-				}
-			}
-		}
-		currentnode = currentnode->nextOrdered;
-	}
-	return CheckDetour(BestDest, start, bWeightDetours);
-}
-
-ANavigationPoint* APawn::CheckDetour(ANavigationPoint* BestDest, ANavigationPoint* Start, UBOOL bWeightDetours)
+void APawn::CheckDetour(FPathQuery& Query, TArray<ANavigationPoint*>& Route)
 {
-	if ( !bWeightDetours || !Start || !BestDest || (Start == BestDest) || !Anchor )
+	if ( !Query.bWeightDetours || (Route.Num() < 2) || !Anchor )
 	{
-		return BestDest;
+		return;
 	}
 
+	ANavigationPoint* BestDest = Route.Last();
 	ANavigationPoint* DetourDest = NULL;
 	FLOAT DetourWeight = 0.f;
 
@@ -560,104 +445,83 @@ ANavigationPoint* APawn::CheckDetour(ANavigationPoint* BestDest, ANavigationPoin
 	for ( INT i=0; i<Anchor->PathList.Num(); i++ )
 	{
 		UReachSpec *spec = Anchor->PathList(i);
-		if ( spec->End->visitedWeight < 2.f * MAXPATHDIST )
+		INT SpecWeight = Query.GetWeight(spec->End);
+		if ( SpecWeight < 2.f * MAXPATHDIST )
 		{
 			UReachSpec *Return = spec->End->GetReachSpecTo(Anchor);
 			if ( Return && !Return->bForced )
 			{
-				spec->End->LastDetourWeight = spec->End->eventDetourWeight(this,spec->End->visitedWeight);
+				spec->End->LastDetourWeight = spec->End->eventDetourWeight(this,SpecWeight);
 				if ( spec->End->LastDetourWeight > DetourWeight )
+				{
+					DetourWeight = spec->End->LastDetourWeight;
 					DetourDest = spec->End;
+				}
 			}
 		}
 	}
-	if ( !DetourDest )
-	return BestDest;
-
-	ANavigationPoint *FirstPath = BestDest;
 	// check that detourdest doesn't occur in route
-	for ( ANavigationPoint *Path=BestDest; Path!=NULL; Path=Path->previousPath )
-	{
-		FirstPath = Path;
-		if ( Path == DetourDest )
-			return BestDest;
-	}
+	if ( !DetourDest || Route.ContainsItem(DetourDest) )
+		return;
 
 	// check that AI really wants to detour
 	if ( !Controller )
-		return BestDest;
+		return;
 	Controller->RouteGoal = BestDest;
-	Controller->RouteDist = BestDest->visitedWeight;
+	Controller->RouteDist = Query.GetWeight(BestDest);
 	if ( !Controller->eventAllowDetourTo(DetourDest) )
-		return BestDest;
+		return;
 
 	// add detourdest to start of route
-	if ( FirstPath != Anchor )
+	if ( Route(0) != Anchor )
 	{
-		FirstPath->previousPath = Anchor;
-		Anchor->previousPath = DetourDest;
-		DetourDest->previousPath = NULL;
+		Route.Insert(0,2);
+		Route(0) = DetourDest;
+		Route(1) = Anchor;
 	}
 	else
 	{
-		for ( ANavigationPoint *Path=BestDest; Path!=NULL; Path=Path->previousPath )
-			if ( Path->previousPath == Anchor )
-			{
-				Path->previousPath = DetourDest;
-				DetourDest->previousPath = Anchor;
-				break;
-			}
+		Route.Insert(1);
+		Route(1) = DetourDest;
 	}
-
-	return BestDest;
 }
 
-/* SetRouteCache() puts the first 16 navigationpoints in the best route found in the
-Controller's RouteCache[].
+/* SetRouteCache() puts the best route found in the Controller's RouteCache[].
+Route starts with the node the search started from and ends with the destination.
 */
-void AController::SetRouteCache(ANavigationPoint *EndPath, FLOAT StartDist, FLOAT EndDist)
+void AController::SetRouteCache(const TArray<ANavigationPoint*>& Route, INT RouteWeight, FLOAT StartDist, FLOAT EndDist)
 {
-	RouteGoal = EndPath;
-	if ( !EndPath )
+	RouteGoal = Route.Num() ? Route.Last() : NULL;
+	if ( !Route.Num() )
 		return;
-	RouteDist = EndPath->visitedWeight + EndDist;
+	RouteDist = RouteWeight + EndDist;
 
-	// reverse order of linked node list
-	EndPath->nextOrdered = NULL;
-	while ( EndPath->previousPath )
-	{
-		EndPath->previousPath->nextOrdered = EndPath;
-		EndPath = EndPath->previousPath;
-	}
 	// if the pawn is on the start node, then the first node in the path should be the next one
-
+	INT First = 0;
 	if ( Pawn && (StartDist > 0.f) )
 	{
 		// if pawn not on the start node, check if second node on path is a better destination
-		if ( EndPath->nextOrdered )
+		if ( Route.Num() > 1 )
 		{
-			FLOAT TwoDist = (Pawn->Location - EndPath->nextOrdered->Location).Size();
-			FLOAT PathDist = (EndPath->Location - EndPath->nextOrdered->Location).Size();
+			FLOAT TwoDist = (Pawn->Location - Route(1)->Location).Size();
+			FLOAT PathDist = (Route(0)->Location - Route(1)->Location).Size();
 			if ( (TwoDist < 0.75f * MAXPATHDIST) && (TwoDist < PathDist)
 				&& ((Level->NetMode != NM_Standalone) || (Level->TimeSeconds - Pawn->LastRenderTime < 5.f) || (StartDist > 250.f)) )
 			{
 				FCheckResult Hit(1.f);
-				GetLevel()->SingleLineCheck( Hit, this, EndPath->nextOrdered->Location, Pawn->Location, TRACE_World|TRACE_StopAtFirstHit );
-				if ( !Hit.Actor	&& Pawn->actorReachable(EndPath->nextOrdered, 1, 1) )
-					EndPath = EndPath->nextOrdered;
+				GetLevel()->SingleLineCheck( Hit, this, Route(1)->Location, Pawn->Location, TRACE_World|TRACE_StopAtFirstHit );
+				if ( !Hit.Actor	&& Pawn->actorReachable(Route(1), 1, 1) )
+					First = 1;
 			}
 		}
 
 	}
-	else if ( EndPath->nextOrdered )
-		EndPath = EndPath->nextOrdered;
+	else if ( Route.Num() > 1 )
+		First = 1;
 
 	// place all of the path into the controller route cache
-	while (EndPath != NULL)
-	{
-		RouteCache.AddItem(EndPath);
-		EndPath = EndPath->nextOrdered;
-	}
+	for ( INT i=First; i<Route.Num(); i++ )
+		RouteCache.AddItem(Route(i));
 	if ( Pawn && RouteCache.Num() > 1 )
 	{
 		ANavigationPoint *FirstPath = Cast<ANavigationPoint>(RouteCache(0));
@@ -674,6 +538,3 @@ void AController::SetRouteCache(ANavigationPoint *EndPath, FLOAT StartDist, FLOA
 			Pawn->NextPathRadius = 0.f;
 	}
 }
-
-
-
@@ -9,6 +9,7 @@
 #include "EnginePrivate.h"
 #include "EngineSequenceClasses.h"
 #include "UnLinkedObjDrawUtils.h"
+#include "UnSequenceRuntime.h"
 
 // how many operations are we allowed to execute in a single frame?
 #define MAX_SEQUENCE_STEPS				1000
@@ -218,8 +219,16 @@ USequenceEvent* AActor::GetEventOfClass(UClass *inEventClass,USequenceEvent* inL
 	// search for a matching sequence event in the actor
 	USequenceEvent *newEvent = NULL;
 	UBOOL bFoundLast = inLastEvent == NULL;
-	if (inEventClass != NULL)
+	if (inEventClass != NULL &&
+		GeneratedEvents.Num() > 0)
 	{
+		// use the level's event index once sequences have begun play
+		if (XLevel != NULL &&
+			XLevel->SequenceRuntime != NULL &&
+			XLevel->SequenceRuntime->FindEventOfClass(this,inEventClass,inLastEvent,newEvent))
+		{
+			return newEvent;
+		}
 		for (INT eventIdx = 0; eventIdx < GeneratedEvents.Num() && newEvent == NULL; eventIdx++)
 		{
 			if (!bFoundLast)
@@ -401,54 +410,57 @@ void USequenceOp::CleanupConnections()
 	}
 }
 
-//@todo: templatize these helper funcs
-void USequenceOp::GetBoolVars(TArray<UBOOL*> &outBools, const TCHAR *inDesc)
+/**
+ * Returns the sequence runtime of the level an op is in, or NULL if its sequences
+ * haven't begun play.  Unlike GetLevel() this doesn't require the op to be in a level.
+ */
+static FSequenceRuntime* FindSequenceRuntime(USequenceObject *inObj)
 {
-	// search for all variables of the expected type
-	for (INT idx = 0; idx < VariableLinks.Num(); idx++)
+	for (UObject *outer = inObj->GetOuter(); outer != NULL; outer = outer->GetOuter())
 	{
-		// if correct type, and
-		// no desc requested, or matches requested desc
-		if (VariableLinks(idx).ExpectedType == USeqVar_Bool::StaticClass() &&
-			(inDesc == NULL ||
-			 VariableLinks(idx).LinkDesc == inDesc))
+		if (outer->IsA(ULevel::StaticClass()))
 		{
-			// add the refs to out list
-			for (INT linkIdx = 0; linkIdx < VariableLinks(idx).LinkedVariables.Num(); linkIdx++)
-			{
-				if (VariableLinks(idx).LinkedVariables(linkIdx) != NULL)
-				{
-					UBOOL *boolRef = VariableLinks(idx).LinkedVariables(linkIdx)->GetBoolRef();
-					if (boolRef != NULL)
-					{
-						outBools.AddItem(boolRef);
-					}
-				}
-			}
+			return ((ULevel*)outer)->SequenceRuntime;
 		}
 	}
+	return NULL;
 }
 
-void USequenceOp::GetIntVars(TArray<INT*> &outInts, const TCHAR *inDesc)
+/**
+ * Gathers the values of all variables of a kind linked to an op, using the op's
+ * compiled variable links when available.
+ * 
+ * @param	inOp - op whose variables are gathered
+ * @param	inKind - kind of variables to gather
+ * @param	inGetRef - accessor returning the value of a variable of that kind
+ * @param	outRefs - list the values are added to
+ * @param	inDesc - if not NULL, only links with this description are gathered
+ */
+template<class T> static void GetOpVars(USequenceOp *inOp, ESequenceVariableKind inKind, T* (USequenceVariable::*inGetRef)(), TArray<T*> &outRefs, const TCHAR *inDesc)
 {
-	// search for all variables of the expected type
-	for (INT idx = 0; idx < VariableLinks.Num(); idx++)
+	FSequenceRuntime *runtime = FindSequenceRuntime(inOp);
+	const FSequenceRuntime::FCompiledOp *compiledOp = runtime != NULL ? runtime->FindCompiledOp(inOp) : NULL;
+	// visit either the pre-sorted links of the requested kind, or all of them
+	const INT numLinks = compiledOp != NULL ? compiledOp->VariableLinks[inKind].Num() : inOp->VariableLinks.Num();
+	for (INT idx = 0; idx < numLinks; idx++)
 	{
+		FSeqVarLink &varLink = inOp->VariableLinks(compiledOp != NULL ? compiledOp->VariableLinks[inKind](idx) : idx);
 		// if correct type, and
 		// no desc requested, or matches requested desc
-		if (VariableLinks(idx).ExpectedType == USeqVar_Int::StaticClass() &&
+		if ((compiledOp != NULL ||
+			 FSequenceRuntime::GetVariableKind(varLink.ExpectedType) == inKind) &&
 			(inDesc == NULL ||
-			 VariableLinks(idx).LinkDesc == inDesc))
+			 varLink.LinkDesc == inDesc))
 		{
 			// add the refs to out list
-			for (INT linkIdx = 0; linkIdx < VariableLinks(idx).LinkedVariables.Num(); linkIdx++)
+			for (INT linkIdx = 0; linkIdx < varLink.LinkedVariables.Num(); linkIdx++)
 			{
-				if (VariableLinks(idx).LinkedVariables(linkIdx) != NULL)
+				if (varLink.LinkedVariables(linkIdx) != NULL)
 				{
-					INT *intRef = VariableLinks(idx).LinkedVariables(linkIdx)->GetIntRef();
-					if (intRef != NULL)
+					T *ref = (varLink.LinkedVariables(linkIdx)->*inGetRef)();
+					if (ref != NULL)
 					{
-						outInts.AddItem(intRef);
+						outRefs.AddItem(ref);
 					}
 				}
 			}
@@ -456,58 +468,24 @@ void USequenceOp::GetIntVars(TArray<INT*> &outInts, const TCHAR *inDesc)
 	}
 }
 
+void USequenceOp::GetBoolVars(TArray<UBOOL*> &outBools, const TCHAR *inDesc)
+{
+	GetOpVars(this,SVK_Bool,&USequenceVariable::GetBoolRef,outBools,inDesc);
+}
+
+void USequenceOp::GetIntVars(TArray<INT*> &outInts, const TCHAR *inDesc)
+{
+	GetOpVars(this,SVK_Int,&USequenceVariable::GetIntRef,outInts,inDesc);
+}
+
 void USequenceOp::GetFloatVars(TArray<FLOAT*> &outFloats, const TCHAR *inDesc)
 {
-	// search for all variables of the expected type
-	for (INT idx = 0; idx < VariableLinks.Num(); idx++)
-	{
-		// if correct type, and
-		// no desc requested, or matches requested desc
-		if (VariableLinks(idx).ExpectedType == USeqVar_Float::StaticClass() &&
-			(inDesc == NULL ||
-			 VariableLinks(idx).LinkDesc == inDesc))
-		{
-			// add the refs to out list
-			for (INT linkIdx = 0; linkIdx < VariableLinks(idx).LinkedVariables.Num(); linkIdx++)
-			{
-				if (VariableLinks(idx).LinkedVariables(linkIdx) != NULL)
-				{
-					FLOAT *floatRef = VariableLinks(idx).LinkedVariables(linkIdx)->GetFloatRef();
-					if (floatRef != NULL)
-					{
-						outFloats.AddItem(floatRef);
-					}
-				}
-			}
-		}
-	}
+	GetOpVars(this,SVK_Float,&USequenceVariable::GetFloatRef,outFloats,inDesc);
 }
 
 void USequenceOp::GetObjectVars(TArray<UObject**> &outObjects, const TCHAR *inDesc)
 {
-	// search for all variables of the expected type
-	for (INT idx = 0; idx < VariableLinks.Num(); idx++)
-	{
-		// if correct type, and
-		// no desc requested, or matches requested desc
-		if (VariableLinks(idx).ExpectedType->IsChildOf(USeqVar_Object::StaticClass()) &&
-			(inDesc == NULL ||
-			 VariableLinks(idx).LinkDesc == inDesc))
-		{
-			// add the refs to out list
-			for (INT linkIdx = 0; linkIdx < VariableLinks(idx).LinkedVariables.Num(); linkIdx++)
-			{
-				if (VariableLinks(idx).LinkedVariables(linkIdx) != NULL)
-				{
-					UObject **objectRef = VariableLinks(idx).LinkedVariables(linkIdx)->GetObjectRef();
-					if (objectRef != NULL)
-					{
-						outObjects.AddItem(objectRef);
-					}
-				}
-			}
-		}
-	}
+	GetOpVars(this,SVK_Object,&USequenceVariable::GetObjectRef,outObjects,inDesc);
 }
 
 void USequenceOp::execGetObjectVars(FFrame &Stack,RESULT_DECL)
@@ -528,29 +506,7 @@ void USequenceOp::execGetObjectVars(FFrame &Stack,RESULT_DECL)
 
 void USequenceOp::GetStringVars(TArray<FString*> &outStrings, const TCHAR *inDesc)
 {
-	// search for all variables of the expected type
-	for (INT idx = 0; idx < VariableLinks.Num(); idx++)
-	{
-		// if correct type, and
-		// no desc requested, or matches requested desc
-		if (VariableLinks(idx).ExpectedType == USeqVar_String::StaticClass() &&
-			(inDesc == NULL ||
-			 VariableLinks(idx).LinkDesc == inDesc))
-		{
-			// add the refs to out list
-			for (INT linkIdx = 0; linkIdx < VariableLinks(idx).LinkedVariables.Num(); linkIdx++)
-			{
-				if (VariableLinks(idx).LinkedVariables(linkIdx) != NULL)
-				{
-					FString *stringRef = VariableLinks(idx).LinkedVariables(linkIdx)->GetStringRef();
-					if (stringRef != NULL)
-					{
-						outStrings.AddItem(stringRef);
-					}
-				}
-			}
-		}
-	}
+	GetOpVars(this,SVK_String,&USequenceVariable::GetStringRef,outStrings,inDesc);
 }
 
 /* epic ===============================================
@@ -750,6 +706,7 @@ void USequence::BeginPlay()
 	}
 	// clear all actor's events
 	ULevel *level = GetLevel();
+	FSequenceRuntime *runtime = level->GetSequenceRuntime();
 	if (GetOuter() == level)
 	{
 		for (INT idx = 0; idx < level->Actors.Num(); idx++)
@@ -760,6 +717,7 @@ void USequence::BeginPlay()
 				evtActor->GeneratedEvents.Empty();
 			}
 		}
+		runtime->ResetEvents();
 	}
 	// first register all events
 	TArray<USequence*> nestedSeqs;
@@ -775,6 +733,7 @@ void USequence::BeginPlay()
 			if (evt->Originator != NULL)
 			{
 				evt->Originator->GeneratedEvents.AddUniqueItem(evt);
+				runtime->InvalidateEvents(evt->Originator);
 			}
 		}
 		else
@@ -831,6 +790,8 @@ void USequence::BeginPlay()
 		USequence *seq = nestedSeqs.Pop();
 		seq->BeginPlay();
 	}
+	// now that all variables are resolved, compile the sequence for updating
+	runtime->CompileSequence(this);
 	// check for any auto-fire events
 	for (INT idx = 0; idx < SequenceObjects.Num(); idx++)
 	{
@@ -923,13 +884,15 @@ void USequence::CheckForErrors()
 */
 void USequence::BuildOpStack(TArray<USequenceOp*> &opStack)
 {
-	// iterate through all events
-	for (INT objIdx = 0; objIdx < SequenceObjects.Num(); objIdx++)
+	// only events, latent actions and subsequences can place ops on the stack
+	FSequenceRuntime::FCompiledSequence *compiled = GetLevel()->GetSequenceRuntime()->GetCompiledSequence(this);
+	for (INT stackIdx = 0; stackIdx < compiled->StackOps.Num(); stackIdx++)
 	{
+		const FSequenceRuntime::FStackOp &stackOp = compiled->StackOps(stackIdx);
 		// if active event,
-		if (SequenceObjects(objIdx)->IsA(USequenceEvent::StaticClass()))
+		if (stackOp.Type == FSequenceRuntime::FStackOp::SO_Event)
 		{
-			USequenceEvent *event = (USequenceEvent*)(SequenceObjects(objIdx));
+			USequenceEvent *event = (USequenceEvent*)(stackOp.Op);
 			if (event->bActive)
 			{
 				// make sure the event is enabled
@@ -948,21 +911,18 @@ void USequence::BuildOpStack(TArray<USequenceOp*> &opStack)
 		}
 		else
 		// if it's a latent action
-		if (SequenceObjects(objIdx)->IsA(USeqAct_Latent::StaticClass()))
+		if (stackOp.Type == FSequenceRuntime::FStackOp::SO_Latent)
 		{
-			USeqAct_Latent *latent = (USeqAct_Latent*)(SequenceObjects(objIdx));
-			if (latent != NULL &&
-				latent->bActive)
+			if (stackOp.Op->bActive)
 			{
 				// place at the top of the stack
-				opStack.AddItem(latent);
+				opStack.AddItem(stackOp.Op);
 			}
 		}
 		else
 		// check for a subsequence with active outputs
-		if (SequenceObjects(objIdx)->IsA(USequence::StaticClass()))
 		{
-			USequence *seq = (USequence*)(SequenceObjects(objIdx));
+			USequence *seq = (USequence*)(stackOp.Op);
 			// check to see if this sequence has activated any output links
 			for (INT outputIdx = 0; outputIdx < seq->OutputLinks.Num(); outputIdx++)
 			{
@@ -1120,14 +1080,12 @@ UBOOL USequence::UpdateOp(FLOAT deltaTime)
 	TArray<USequenceOp*> opStack;
 	BuildOpStack(opStack);
 	ExecuteOpStack(deltaTime,opStack);
-	// iterate through all active child sequences and update them as well
-	for (INT idx = 0; idx < SequenceObjects.Num(); idx++)
+	// iterate through all child sequences that have anything to update and update them as well,
+	// the compiled sequence is indexed each iteration as it may be recompiled by the children
+	FSequenceRuntime::FCompiledSequence *compiled = GetLevel()->GetSequenceRuntime()->GetCompiledSequence(this);
+	for (INT idx = 0; idx < compiled->UpdatedSequences.Num(); idx++)
 	{
-		USequence *seq = Cast<USequence>(SequenceObjects(idx));
-		if (seq != NULL)
-		{
-			seq->UpdateOp(deltaTime);
-		}
+		compiled->UpdatedSequences(idx)->UpdateOp(deltaTime);
 	}
 	return 0;
 }
@@ -1269,11 +1227,11 @@ void USequence::Activated()
 		if (InputLinks(idx).bHasImpulse)
 		{
 			// find the matching sequence event to activate
-			for (INT objIdx = 0; objIdx < SequenceObjects.Num(); objIdx++)
+			FSequenceRuntime::FCompiledSequence *compiled = GetLevel()->GetSequenceRuntime()->GetCompiledSequence(this);
+			for (INT evtIdx = 0; evtIdx < compiled->ActivatedEvents.Num(); evtIdx++)
 			{
-				USeqEvent_SequenceActivated *evt = Cast<USeqEvent_SequenceActivated>(SequenceObjects(objIdx));
-				if (evt != NULL &&
-					evt->GetFName() == InputLinks(idx).LinkAction)
+				USeqEvent_SequenceActivated *evt = compiled->ActivatedEvents(evtIdx);
+				if (evt->GetFName() == InputLinks(idx).LinkAction)
 				{
 					//@todo - figure out the instigator and run through CheckActivate
 					evt->bActive = 1;
@@ -2954,6 +2912,13 @@ void USeqAct_AttachToEvent::Activated()
 				targets(idx)->GeneratedEvents.AddItem(evt);
 			}
 		}
+		// have the new events picked up by the sequence and the event index
+		FSequenceRuntime *runtime = GetLevel()->GetSequenceRuntime();
+		runtime->InvalidateSequence(seq);
+		for (INT idx = 0; idx < targets.Num(); idx++)
+		{
+			runtime->InvalidateEvents(targets(idx));
+		}
 	}
 	else
 	{
@@ -0,0 +1,283 @@
+/*=============================================================================
+	UnSequenceRuntime.cpp: Compiled gameplay sequences and event dispatch index.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "EnginePrivate.h"
+#include "EngineSequenceClasses.h"
+#include "UnSequenceRuntime.h"
+
+/**
+ * Returns the level's sequence runtime, creating it if necessary.
+ */
+FSequenceRuntime* ULevel::GetSequenceRuntime()
+{
+	if( !SequenceRuntime )
+	{
+		SequenceRuntime = new FSequenceRuntime( this );
+	}
+	return SequenceRuntime;
+}
+
+/*-----------------------------------------------------------------------------
+	FSequenceRuntime implementation.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Constructor.
+ *
+ * @param	InLevel		Level whose sequences are run
+ */
+FSequenceRuntime::FSequenceRuntime( ULevel* InLevel )
+:	Level( InLevel )
+{
+}
+
+/**
+ * Destructor, freeing all compiled sequences.
+ */
+FSequenceRuntime::~FSequenceRuntime()
+{
+	for( TMap<USequence*,FCompiledSequence*>::TIterator It(CompiledSequences); It; ++It )
+	{
+		delete It.Value();
+	}
+}
+
+/**
+ * Returns the kind of variables a variable link expecting the passed in class gathers,
+ * or SVK_MAX if none of the Get*Vars helpers gathers it.
+ */
+ESequenceVariableKind FSequenceRuntime::GetVariableKind( UClass* ExpectedType )
+{
+	if( ExpectedType == USeqVar_Bool::StaticClass() )
+	{
+		return SVK_Bool;
+	}
+	else if( ExpectedType == USeqVar_Int::StaticClass() )
+	{
+		return SVK_Int;
+	}
+	else if( ExpectedType == USeqVar_Float::StaticClass() )
+	{
+		return SVK_Float;
+	}
+	else if( ExpectedType == USeqVar_String::StaticClass() )
+	{
+		return SVK_String;
+	}
+	else if( ExpectedType && ExpectedType->IsChildOf(USeqVar_Object::StaticClass()) )
+	{
+		return SVK_Object;
+	}
+	return SVK_MAX;
+}
+
+/**
+ * Compiles a sequence and the ops it contains, replacing any earlier compiled form.
+ *
+ * @param	Sequence	Sequence to compile
+ * @return	compiled sequence, owned by the runtime
+ */
+FSequenceRuntime::FCompiledSequence* FSequenceRuntime::CompileSequence( USequence* Sequence )
+{
+	// Compile nested sequences first as whether they have to be updated depends on their contents.
+	// The compiled form is looked up again afterwards as compiling them may rehash the map.
+	for( INT ObjIndex=0; ObjIndex<Sequence->SequenceObjects.Num(); ObjIndex++ )
+	{
+		USequence* Nested = Cast<USequence>( Sequence->SequenceObjects(ObjIndex) );
+		if( Nested )
+		{
+			GetCompiledSequence( Nested );
+		}
+	}
+
+	FCompiledSequence** Existing = CompiledSequences.Find( Sequence );
+	FCompiledSequence* Compiled = Existing ? *Existing : NULL;
+	if( !Compiled )
+	{
+		Compiled = new FCompiledSequence;
+		CompiledSequences.Set( Sequence, Compiled );
+	}
+	Compiled->NumSequenceObjects = Sequence->SequenceObjects.Num();
+	Compiled->bStale = 0;
+	Compiled->StackOps.Empty();
+	Compiled->UpdatedSequences.Empty();
+	Compiled->ActivatedEvents.Empty();
+
+	CompileOp( Sequence );
+	for( INT ObjIndex=0; ObjIndex<Sequence->SequenceObjects.Num(); ObjIndex++ )
+	{
+		USequenceObject* SeqObj = Sequence->SequenceObjects(ObjIndex);
+		if( !SeqObj || !SeqObj->IsA(USequenceOp::StaticClass()) )
+		{
+			continue;
+		}
+		USequenceOp* Op = (USequenceOp*)SeqObj;
+		CompileOp( Op );
+
+		FStackOp StackOp;
+		StackOp.Op = Op;
+		if( Op->IsA(USequenceEvent::StaticClass()) )
+		{
+			StackOp.Type = FStackOp::SO_Event;
+			Compiled->StackOps.AddItem( StackOp );
+			if( Op->IsA(USeqEvent_SequenceActivated::StaticClass()) )
+			{
+				Compiled->ActivatedEvents.AddItem( (USeqEvent_SequenceActivated*)Op );
+			}
+		}
+		else if( Op->IsA(USeqAct_Latent::StaticClass()) )
+		{
+			StackOp.Type = FStackOp::SO_Latent;
+			Compiled->StackOps.AddItem( StackOp );
+		}
+		else if( Op->IsA(USequence::StaticClass()) )
+		{
+			StackOp.Type = FStackOp::SO_Sequence;
+			Compiled->StackOps.AddItem( StackOp );
+			// Nested sequences without stack ops of their own never have anything to update.
+			USequence* Nested = (USequence*)Op;
+			if( GetCompiledSequence(Nested)->StackOps.Num() > 0 )
+			{
+				Compiled->UpdatedSequences.AddItem( Nested );
+			}
+		}
+	}
+	return Compiled;
+}
+
+/**
+ * Returns the compiled form of a sequence, compiling it if it is missing or out of date.
+ */
+FSequenceRuntime::FCompiledSequence* FSequenceRuntime::GetCompiledSequence( USequence* Sequence )
+{
+	FCompiledSequence** Compiled = CompiledSequences.Find( Sequence );
+	if( Compiled && !(*Compiled)->bStale && (*Compiled)->NumSequenceObjects == Sequence->SequenceObjects.Num() )
+	{
+		return *Compiled;
+	}
+	return CompileSequence( Sequence );
+}
+
+/**
+ * Marks a sequence and all sequences containing it to be compiled again.
+ */
+void FSequenceRuntime::InvalidateSequence( USequence* Sequence )
+{
+	for( ; Sequence; Sequence = Cast<USequence>(Sequence->GetOuter()) )
+	{
+		FCompiledSequence** Compiled = CompiledSequences.Find( Sequence );
+		if( Compiled )
+		{
+			(*Compiled)->bStale = 1;
+		}
+	}
+}
+
+/**
+ * Compiles the variable links of an op.
+ */
+void FSequenceRuntime::CompileOp( USequenceOp* Op )
+{
+	FCompiledOp CompiledOp;
+	CompiledOp.NumVariableLinks = Op->VariableLinks.Num();
+	for( INT LinkIndex=0; LinkIndex<Op->VariableLinks.Num(); LinkIndex++ )
+	{
+		const ESequenceVariableKind Kind = GetVariableKind( Op->VariableLinks(LinkIndex).ExpectedType );
+		if( Kind != SVK_MAX )
+		{
+			CompiledOp.VariableLinks[Kind].AddItem( LinkIndex );
+		}
+	}
+	CompiledOps.Set( Op, CompiledOp );
+}
+
+/**
+ * Looks up the next event of a class an actor generates, see AActor::GetEventOfClass.
+ *
+ * @param	Actor		Actor whose generated events are searched
+ * @param	EventClass	Class of event to search for
+ * @param	LastEvent	Event returned by the previous call, or NULL to get the first one
+ * @param	OutEvent	[out] next matching event after LastEvent, or NULL if there is none
+ * @return	FALSE if the index can't answer the query, because LastEvent isn't of the class
+ */
+UBOOL FSequenceRuntime::FindEventOfClass( AActor* Actor, UClass* EventClass, USequenceEvent* LastEvent, USequenceEvent*& OutEvent )
+{
+	FActorEvents* ActorEvents = EventIndex.Find( Actor );
+	if( !ActorEvents || ActorEvents->NumGeneratedEvents != Actor->GeneratedEvents.Num() )
+	{
+		FActorEvents NewEvents;
+		NewEvents.NumGeneratedEvents = Actor->GeneratedEvents.Num();
+		EventIndex.Set( Actor, NewEvents );
+		ActorEvents = EventIndex.Find( Actor );
+	}
+
+	FClassEvents* ClassEvents = NULL;
+	for( INT ClassIndex=0; ClassIndex<ActorEvents->Classes.Num(); ClassIndex++ )
+	{
+		if( ActorEvents->Classes(ClassIndex).EventClass == EventClass )
+		{
+			ClassEvents = &ActorEvents->Classes(ClassIndex);
+			break;
+		}
+	}
+	if( !ClassEvents )
+	{
+		ClassEvents = new(ActorEvents->Classes) FClassEvents;
+		ClassEvents->EventClass = EventClass;
+		for( INT GeneratedIndex=0; GeneratedIndex<Actor->GeneratedEvents.Num(); GeneratedIndex++ )
+		{
+			USequenceEvent* Event = Actor->GeneratedEvents(GeneratedIndex);
+			if( Event && Event->IsA(EventClass) )
+			{
+				ClassEvents->Events.AddItem( Event );
+			}
+		}
+	}
+
+	const TArray<USequenceEvent*>& Events = ClassEvents->Events;
+	OutEvent = NULL;
+	if( !LastEvent )
+	{
+		if( Events.Num() > 0 )
+		{
+			OutEvent = Events(0);
+		}
+		return 1;
+	}
+	INT LastIndex = INDEX_NONE;
+	if( !Events.FindItem(LastEvent, LastIndex) )
+	{
+		return 0;
+	}
+	// Skip duplicates of the last event, the same event may be attached more than once.
+	for( INT NextIndex=LastIndex+1; NextIndex<Events.Num(); NextIndex++ )
+	{
+		if( Events(NextIndex) != LastEvent )
+		{
+			OutEvent = Events(NextIndex);
+			break;
+		}
+	}
+	return 1;
+}
+
+/**
+ * Removes all references to actors that are about to be deleted.
+ */
+void FSequenceRuntime::CleanupDestroyed()
+{
+	for( TMap<AActor*,FActorEvents>::TIterator It(EventIndex); It; ++It )
+	{
+		if( It.Key()->bDeleteMe )
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
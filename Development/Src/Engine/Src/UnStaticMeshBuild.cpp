@@ -8,6 +8,12 @@
 
 #include "EnginePrivate.h"
 
+/** Size of the grid cells positions are hashed by, at least the tolerance of PointsEqual so points it considers equal are at most one cell apart */
+#define STATICMESH_HASH_CELL_SIZE	(THRESH_POINTS_ARE_SAME * 8.0f)
+
+/** Version of the geometry UStaticMesh::Build stores in the derived data cache, bump when the build output changes */
+#define STATICMESH_DERIVEDDATA_VERSION	1
+
 //
 //	PointsEqual
 //
@@ -41,6 +47,83 @@ inline UBOOL UVsEqual(FVector2D& UV1,FVector2D& UV2)
 	return 1;
 }
 
+//
+//	GetPointCell - Returns the grid cell containing a position.
+//
+
+inline void GetPointCell(const FVector& Position,INT* Cell)
+{
+	Cell[0] = appFloor(Position.X / STATICMESH_HASH_CELL_SIZE);
+	Cell[1] = appFloor(Position.Y / STATICMESH_HASH_CELL_SIZE);
+	Cell[2] = appFloor(Position.Z / STATICMESH_HASH_CELL_SIZE);
+}
+
+//
+//	HashPointCell
+//
+
+inline DWORD HashPointCell(INT X,INT Y,INT Z)
+{
+	return ((DWORD)X * 73856093) ^ ((DWORD)Y * 19349663) ^ ((DWORD)Z * 83492791);
+}
+
+inline DWORD HashPointCell(const FVector& Position)
+{
+	INT	Cell[3];
+	GetPointCell(Position,Cell);
+	return HashPointCell(Cell[0],Cell[1],Cell[2]);
+}
+
+//
+//	FStaticMeshBuildHash - Chains entries with consecutive indices by a hash key, used to find the vertices, triangles and edges
+//	near a position without comparing against all of them. Entries are chained in descending order.
+//
+
+struct FStaticMeshBuildHash
+{
+	TArray<INT>	HashFirst;
+	TArray<INT>	HashNext;
+
+	// Constructor.
+
+	FStaticMeshBuildHash(INT ExpectedEntries)
+	{
+		INT	NumBuckets = 256;
+		while(NumBuckets < ExpectedEntries)
+			NumBuckets *= 2;
+
+		HashFirst.Add(NumBuckets);
+		for(INT BucketIndex = 0;BucketIndex < NumBuckets;BucketIndex++)
+			HashFirst(BucketIndex) = INDEX_NONE;
+
+		HashNext.Empty(ExpectedEntries);
+	}
+
+	// Add - Chains the next entry, Index has to be the number of entries added so far.
+
+	void Add(DWORD Key,INT Index)
+	{
+		check(Index == HashNext.Num());
+
+		INT&	First = HashFirst(Key & (HashFirst.Num() - 1));
+
+		HashNext.AddItem(First);
+		First = Index;
+	}
+
+	// Accessors.
+
+	INT First(DWORD Key) const
+	{
+		return HashFirst(Key & (HashFirst.Num() - 1));
+	}
+
+	INT Next(INT Index) const
+	{
+		return HashNext(Index);
+	}
+};
+
 //
 // FanFace - Smoothing group interpretation helper structure.
 //
@@ -52,61 +135,92 @@ struct FanFace
 	UBOOL Filled;		
 };
 
+//
+//	FStaticMeshBuildData - Results of UStaticMesh::BuildGeometry used by UStaticMesh::FinishBuild.
+//
+
+struct FStaticMeshBuildData
+{
+	TArray<FRawIndexBuffer>	MaterialIndices;
+	INT						NumDegenerates;
+
+	// Constructor.
+
+	FStaticMeshBuildData():
+		NumDegenerates(0)
+	{}
+};
+
 //
 //	FindVertexIndex
 //
 
-INT FindVertexIndex(UStaticMesh* StaticMesh,FVector Position,FPackedNormal TangentX,FPackedNormal TangentY,FPackedNormal TangentZ,FColor Color,FVector2D* UVs,INT NumUVs)
+static INT FindVertexIndex(UStaticMesh* StaticMesh,FStaticMeshBuildHash& VertexHash,FVector Position,FPackedNormal TangentX,FPackedNormal TangentY,FPackedNormal TangentZ,FColor Color,FVector2D* UVs,INT NumUVs)
 {
-	// Find any identical vertices already in the vertex buffer.
+	// Find any identical vertices already in the vertex buffer.  Only the vertices in the cells around the position can be
+	// close enough, and of those the lowest matching index is used, which is the vertex a search through all vertices would find.
 
 	INT	VertexBufferIndex = INDEX_NONE;
+	INT	Cell[3];
 
-	for(INT VertexIndex = 0;VertexIndex < StaticMesh->Vertices.Num();VertexIndex++)
+	GetPointCell(Position,Cell);
+
+	for(INT X = Cell[0] - 1;X <= Cell[0] + 1;X++)
 	{
-		// Compare vertex position and normal.
+		for(INT Y = Cell[1] - 1;Y <= Cell[1] + 1;Y++)
+		{
+			for(INT Z = Cell[2] - 1;Z <= Cell[2] + 1;Z++)
+			{
+				for(INT VertexIndex = VertexHash.First(HashPointCell(X,Y,Z));VertexIndex != INDEX_NONE;VertexIndex = VertexHash.Next(VertexIndex))
+				{
+					if(VertexBufferIndex != INDEX_NONE && VertexIndex > VertexBufferIndex)
+						continue;
 
-		FStaticMeshVertex*	CompareVertex = &StaticMesh->Vertices(VertexIndex);
+					// Compare vertex position and normal.
 
-		if(!PointsEqual(CompareVertex->Position,Position))
-			continue;
+					FStaticMeshVertex*	CompareVertex = &StaticMesh->Vertices(VertexIndex);
 
-		if(!(CompareVertex->TangentX == TangentX))
-			continue;
+					if(!PointsEqual(CompareVertex->Position,Position))
+						continue;
 
-		if(!(CompareVertex->TangentY == TangentY))
-			continue;
-		
-		if(!(CompareVertex->TangentZ == TangentZ))
-			continue;
+					if(!(CompareVertex->TangentX == TangentX))
+						continue;
 
-		// Compare vertex color.
+					if(!(CompareVertex->TangentY == TangentY))
+						continue;
+					
+					if(!(CompareVertex->TangentZ == TangentZ))
+						continue;
+
+					// Compare vertex color.
 
 #if VIEWPORT_ACTOR_DISABLED
-		if(StaticMesh->ColorBuffer.Colors(VertexIndex) != Color)
-			continue;
+					if(StaticMesh->ColorBuffer.Colors(VertexIndex) != Color)
+						continue;
 #endif
 
-		// Compare vertex UVs.
+					// Compare vertex UVs.
 
-		UBOOL	UVsMatch = 1;
+					UBOOL	UVsMatch = 1;
 
-		for(INT UVIndex = 0;UVIndex < NumUVs;UVIndex++)
-		{
-			if(!UVsEqual(StaticMesh->UVBuffers(UVIndex).UVs(VertexIndex),UVs[UVIndex]))
-			{
-				UVsMatch = 0;
-				break;
-			}
-		}
+					for(INT UVIndex = 0;UVIndex < NumUVs;UVIndex++)
+					{
+						if(!UVsEqual(StaticMesh->UVBuffers(UVIndex).UVs(VertexIndex),UVs[UVIndex]))
+						{
+							UVsMatch = 0;
+							break;
+						}
+					}
 
-		if(!UVsMatch)
-			continue;
+					if(!UVsMatch)
+						continue;
 
-		// The vertex matches!
+					// The vertex matches!
 
-		VertexBufferIndex = VertexIndex;
-		break;
+					VertexBufferIndex = VertexIndex;
+				}
+			}
+		}
 	}
 
 	// If there is no identical vertex already in the vertex buffer...
@@ -123,6 +237,7 @@ INT FindVertexIndex(UStaticMesh* StaticMesh,FVector Position,FPackedNormal Tange
 		Vertex.TangentZ = TangentZ;
 
 		VertexBufferIndex = StaticMesh->Vertices.AddItem(Vertex);
+		VertexHash.Add(HashPointCell(Cell[0],Cell[1],Cell[2]),VertexBufferIndex);
 
 #if VIEWPORT_ACTOR_DISABLED
 		verify(StaticMesh->ColorBuffer.Colors.AddItem(Color) == VertexBufferIndex);
@@ -146,14 +261,31 @@ INT FindVertexIndex(UStaticMesh* StaticMesh,FVector Position,FPackedNormal Tange
 
 }
 
+//
+//	HashEdge - Edges are hashed by the cells of their positions, in order, so an edge and the reversed edge of a neighbouring face
+//	with exactly the same positions hash to the same key.
+//
+
+inline DWORD HashEdge(const FVector& Position0,const FVector& Position1)
+{
+	return HashPointCell(Position0) * 31 + HashPointCell(Position1);
+}
+
 //
 //	FindEdgeIndex
 //
 
-INT FindEdgeIndex(UStaticMesh* StaticMesh,FMeshEdge& Edge)
+static INT FindEdgeIndex(UStaticMesh* StaticMesh,FStaticMeshBuildHash& EdgeHash,FMeshEdge& Edge)
 {
-	for(INT EdgeIndex = 0;EdgeIndex < StaticMesh->Edges.Num();EdgeIndex++)
+	// Find the lowest indexed edge going the other way that doesn't have a second face yet.
+
+	INT	MatchingEdgeIndex = INDEX_NONE;
+
+	for(INT EdgeIndex = EdgeHash.First(HashEdge(StaticMesh->Vertices(Edge.Vertices[1]).Position,StaticMesh->Vertices(Edge.Vertices[0]).Position));EdgeIndex != INDEX_NONE;EdgeIndex = EdgeHash.Next(EdgeIndex))
 	{
+		if(MatchingEdgeIndex != INDEX_NONE && EdgeIndex > MatchingEdgeIndex)
+			continue;
+
 		FMeshEdge&	OtherEdge = StaticMesh->Edges(EdgeIndex);
 
 		if(StaticMesh->Vertices(OtherEdge.Vertices[0]).Position != StaticMesh->Vertices(Edge.Vertices[1]).Position)
@@ -165,11 +297,17 @@ INT FindEdgeIndex(UStaticMesh* StaticMesh,FMeshEdge& Edge)
 		if(OtherEdge.Faces[1] != INDEX_NONE)
 			continue;
 
-		OtherEdge.Faces[1] = Edge.Faces[0];
-		return EdgeIndex;
+		MatchingEdgeIndex = EdgeIndex;
+	}
+
+	if(MatchingEdgeIndex != INDEX_NONE)
+	{
+		StaticMesh->Edges(MatchingEdgeIndex).Faces[1] = Edge.Faces[0];
+		return MatchingEdgeIndex;
 	}
 
 	new(StaticMesh->Edges) FMeshEdge(Edge);
+	EdgeHash.Add(HashEdge(StaticMesh->Vertices(Edge.Vertices[0]).Position,StaticMesh->Vertices(Edge.Vertices[1]).Position),StaticMesh->Edges.Num() - 1);
 
 	return StaticMesh->Edges.Num() - 1;
 
@@ -206,6 +344,74 @@ ESplitType ClassifyTriangleVertices(FPlane Plane,FVector* Vertices)
 	return Classification;
 }
 
+IMPLEMENT_COMPARE_CONSTREF( INT, UnStaticMeshBuild, { return A - B; } )
+
+//
+//	SerializeBuiltGeometry - Serializes the data built from the source data of a mesh, storing it in or restoring it from the derived data cache.
+//
+
+static void SerializeBuiltGeometry(FArchive& Ar,UStaticMesh* StaticMesh)
+{
+	Ar << StaticMesh->Bounds << StaticMesh->kDOPTree;
+	Ar << StaticMesh->Vertices << StaticMesh->UVBuffers << StaticMesh->IndexBuffer << StaticMesh->WireframeIndexBuffer << StaticMesh->Edges;
+	Ar << StaticMesh->ShadowTriangleDoubleSided;
+
+	for(INT MaterialIndex = 0;MaterialIndex < StaticMesh->Materials.Num();MaterialIndex++)
+	{
+		FStaticMeshMaterial&	Material = StaticMesh->Materials(MaterialIndex);
+		Ar << Material.FirstIndex << Material.NumTriangles << Material.MinVertexIndex << Material.MaxVertexIndex;
+	}
+}
+
+//
+//	LoadDerivedGeometry - Hashes the source data of a mesh after BeginBuild and restores the geometry built from it if it is in the derived data cache.
+//
+
+static UBOOL LoadDerivedGeometry(UStaticMesh* StaticMesh,FDerivedDataKey& DerivedDataKey)
+{
+	INT	Version = STATICMESH_VERSION,
+		NumMaterials = StaticMesh->Materials.Num(),
+		NumTriangles = StaticMesh->RawTriangles.Num();
+
+	DerivedDataKey << Version << NumMaterials << NumTriangles;
+	for(INT MaterialIndex = 0;MaterialIndex < NumMaterials;MaterialIndex++)
+		DerivedDataKey << StaticMesh->Materials(MaterialIndex).EnableCollision;
+	for(INT TriangleIndex = 0;TriangleIndex < NumTriangles;TriangleIndex++)
+		DerivedDataKey << StaticMesh->RawTriangles(TriangleIndex);
+
+	TArray<BYTE>	DerivedData;
+	if(!GDerivedDataCache || !GDerivedDataCache->Get(DerivedDataKey,DerivedData))
+		return 0;
+
+	FBufferReader	DerivedDataReader(DerivedData);
+	SerializeBuiltGeometry(DerivedDataReader,StaticMesh);
+
+	// The UV and index buffers update their resources when loaded, the vertex buffers need to be told.
+
+	StaticMesh->PositionVertexBuffer.Update();
+	StaticMesh->TangentVertexBuffer.Update();
+
+	if( !GIsEditor )
+		StaticMesh->RawTriangles.Unload();
+
+	return 1;
+}
+
+//
+//	SaveDerivedGeometry - Stores the geometry of a mesh in the derived data cache after FinishBuild.
+//
+
+static void SaveDerivedGeometry(UStaticMesh* StaticMesh,FDerivedDataKey& DerivedDataKey)
+{
+	if(GDerivedDataCache)
+	{
+		TArray<BYTE>	DerivedData;
+		FBufferWriter	DerivedDataWriter(DerivedData);
+		SerializeBuiltGeometry(DerivedDataWriter,StaticMesh);
+		GDerivedDataCache->Put(DerivedDataKey,DerivedData);
+	}
+}
+
 //
 //	UStaticMesh::Build
 //
@@ -216,6 +422,112 @@ void UStaticMesh::Build()
 
 	GWarn->BeginSlowTask(*FString::Printf(TEXT("(%s) Building"),*GetPathName()),1);
 
+	BeginBuild();
+
+	// Meshes whose source data didn't change are restored from the derived data cache.
+
+	FDerivedDataKey	DerivedDataKey(TEXT("StaticMesh"),STATICMESH_DERIVEDDATA_VERSION);
+
+	if(!LoadDerivedGeometry(this,DerivedDataKey))
+	{
+		FStaticMeshBuildData	BuildData;
+
+		BuildGeometry(BuildData,1);
+		FinishBuild(BuildData);
+		SaveDerivedGeometry(this,DerivedDataKey);
+	}
+
+	GWarn->EndSlowTask();
+
+}
+
+//
+//	FStaticMeshBuildBody - Builds the geometry of one of the meshes passed to UStaticMesh::BuildMeshes.
+//
+
+class FStaticMeshBuildBody : public FParallelForBody
+{
+public:
+	const TArray<UStaticMesh*>&		StaticMeshes;
+	TArray<FStaticMeshBuildData>&	BuildData;
+
+	// Constructor.
+
+	FStaticMeshBuildBody(const TArray<UStaticMesh*>& InStaticMeshes,TArray<FStaticMeshBuildData>& InBuildData):
+		StaticMeshes(InStaticMeshes),
+		BuildData(InBuildData)
+	{}
+
+	// FParallelForBody interface.
+
+	virtual void Execute(INT Index)
+	{
+		StaticMeshes(Index)->BuildGeometry(BuildData(Index),0);
+	}
+};
+
+//
+//	UStaticMesh::BuildMeshes
+//
+
+void UStaticMesh::BuildMeshes(const TArray<UStaticMesh*>& StaticMeshes)
+{
+	GWarn->BeginSlowTask(TEXT("Building static meshes"),1);
+
+	TArray<FStaticMeshComponentRecreateContext*>	ComponentRecreateContexts;
+	TArray<UStaticMesh*>							BuiltMeshes;
+	TArray<FDerivedDataKey*>						DerivedDataKeys;
+	TArray<FStaticMeshBuildData>					BuildData;
+
+	for(INT MeshIndex = 0;MeshIndex < StaticMeshes.Num();MeshIndex++)
+	{
+		ComponentRecreateContexts.AddItem(new FStaticMeshComponentRecreateContext(StaticMeshes(MeshIndex)));
+		StaticMeshes(MeshIndex)->BeginBuild();
+
+		// Meshes whose source data didn't change are restored from the derived data cache, the others are built.
+
+		FDerivedDataKey*	DerivedDataKey = new FDerivedDataKey(TEXT("StaticMesh"),STATICMESH_DERIVEDDATA_VERSION);
+
+		if(LoadDerivedGeometry(StaticMeshes(MeshIndex),*DerivedDataKey))
+		{
+			delete DerivedDataKey;
+		}
+		else
+		{
+			BuiltMeshes.AddItem(StaticMeshes(MeshIndex));
+			DerivedDataKeys.AddItem(DerivedDataKey);
+		}
+	}
+
+	BuildData.Empty(BuiltMeshes.Num());
+	for(INT MeshIndex = 0;MeshIndex < BuiltMeshes.Num();MeshIndex++)
+		new(BuildData) FStaticMeshBuildData;
+
+	// The meshes don't share any data, so their geometry is built concurrently.
+
+	FStaticMeshBuildBody	BuildBody(BuiltMeshes,BuildData);
+	appParallelFor(BuiltMeshes.Num(),BuildBody);
+
+	for(INT MeshIndex = 0;MeshIndex < BuiltMeshes.Num();MeshIndex++)
+	{
+		BuiltMeshes(MeshIndex)->FinishBuild(BuildData(MeshIndex));
+		SaveDerivedGeometry(BuiltMeshes(MeshIndex),*DerivedDataKeys(MeshIndex));
+		delete DerivedDataKeys(MeshIndex);
+	}
+
+	for(INT MeshIndex = 0;MeshIndex < ComponentRecreateContexts.Num();MeshIndex++)
+		delete ComponentRecreateContexts(MeshIndex);
+
+	GWarn->EndSlowTask();
+
+}
+
+//
+//	UStaticMesh::BeginBuild
+//
+
+void UStaticMesh::BeginBuild()
+{
 	// Mark the parent package as dirty.
 
 	UObject* Outer = GetOuter();
@@ -247,6 +559,24 @@ void UStaticMesh::Build()
 	if(!RawTriangles.Num())
 		RawTriangles.Load();
 
+	// Create the necessary number of UV buffers.
+
+	for(INT TriangleIndex = 0;TriangleIndex < RawTriangles.Num();TriangleIndex++)
+	{
+		FStaticMeshTriangle*	Triangle = &RawTriangles(TriangleIndex);
+
+		while(UVBuffers.Num() < Triangle->NumUVs)
+			new(UVBuffers) FStaticMeshUVBuffer();
+	}
+
+}
+
+//
+//	UStaticMesh::BuildGeometry
+//
+
+void UStaticMesh::BuildGeometry(FStaticMeshBuildData& BuildData,UBOOL bReportProgress)
+{
 	// Calculate triangle normals.
 
 	TArray<FVector>	TriangleTangentX(RawTriangles.Num());
@@ -297,23 +627,30 @@ void UStaticMesh::Build()
 		TriangleTangentZ(TriangleIndex) = TangentZ.SafeNormal();
 	}
 
-	// Initialize material index buffers.
+	// Hash the triangles' vertices by position, so the faces sharing a vertex are found without checking every triangle.
 
-	TArray<FRawIndexBuffer>	MaterialIndices;
+	FStaticMeshBuildHash	TriangleVertexHash(RawTriangles.Num() * 3);
 
-	for(INT MaterialIndex = 0;MaterialIndex < Materials.Num();MaterialIndex++)
-		new(MaterialIndices) FRawIndexBuffer();
+	for(INT TriangleIndex = 0;TriangleIndex < RawTriangles.Num();TriangleIndex++)
+	{
+		for(INT VertexIndex = 0;VertexIndex < 3;VertexIndex++)
+			TriangleVertexHash.Add(HashPointCell(RawTriangles(TriangleIndex).Vertices[VertexIndex]),TriangleIndex * 3 + VertexIndex);
+	}
 
-	// Create the necessary number of UV buffers.
+	TArray<INT>	CandidateTriangles;
+	TArray<INT>	CandidateMarks(RawTriangles.Num());
 
 	for(INT TriangleIndex = 0;TriangleIndex < RawTriangles.Num();TriangleIndex++)
-	{
-		FStaticMeshTriangle*	Triangle = &RawTriangles(TriangleIndex);
+		CandidateMarks(TriangleIndex) = INDEX_NONE;
 
-		while(UVBuffers.Num() < Triangle->NumUVs)
-			new(UVBuffers) FStaticMeshUVBuffer();
-	}
+	// Initialize material index buffers.
+
+	TArray<FRawIndexBuffer>&	MaterialIndices = BuildData.MaterialIndices;
 
+	for(INT MaterialIndex = 0;MaterialIndex < Materials.Num();MaterialIndex++)
+		new(MaterialIndices) FRawIndexBuffer();
+
+	FStaticMeshBuildHash				VertexHash(RawTriangles.Num() * 3);
 	TArray<FkDOPBuildCollisionTriangle> kDOPBuildTriangles;
 
 	// Process each triangle.
@@ -333,7 +670,8 @@ void UStaticMesh::Build()
 			continue;
 		}
 
-		GWarn->StatusUpdatef(TriangleIndex,RawTriangles.Num(),TEXT("(%s) Indexing vertices..."),*GetPathName());
+		if(bReportProgress)
+			GWarn->StatusUpdatef(TriangleIndex,RawTriangles.Num(),TEXT("(%s) Indexing vertices..."),*GetPathName());
 
 		// Calculate smooth vertex normals.
 
@@ -354,12 +692,45 @@ void UStaticMesh::Build()
 					TriangleTangentZ(TriangleIndex)
 					);
 		
+		// Only triangles with a vertex in the cells around one of ours can share a vertex with this triangle.  They're visited
+		// in ascending order like a loop over all triangles would, so the tangents are summed in the same order.
+
+		CandidateTriangles.Empty();
+
+		for(INT VertexIndex = 0;VertexIndex < 3;VertexIndex++)
+		{
+			INT	Cell[3];
+			GetPointCell(Triangle->Vertices[VertexIndex],Cell);
+
+			for(INT X = Cell[0] - 1;X <= Cell[0] + 1;X++)
+			{
+				for(INT Y = Cell[1] - 1;Y <= Cell[1] + 1;Y++)
+				{
+					for(INT Z = Cell[2] - 1;Z <= Cell[2] + 1;Z++)
+					{
+						for(INT HashIndex = TriangleVertexHash.First(HashPointCell(X,Y,Z));HashIndex != INDEX_NONE;HashIndex = TriangleVertexHash.Next(HashIndex))
+						{
+							INT	OtherTriangleIndex = HashIndex / 3;
+							if(CandidateMarks(OtherTriangleIndex) != TriangleIndex)
+							{
+								CandidateMarks(OtherTriangleIndex) = TriangleIndex;
+								CandidateTriangles.AddItem(OtherTriangleIndex);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		Sort<USE_COMPARE_CONSTREF(INT,UnStaticMeshBuild)>( &CandidateTriangles(0), CandidateTriangles.Num() );
+
 		// Determine contributing faces for correct smoothing group behaviour  according to the orthodox Max interpretation of smoothing groups.    O(n^2)      - EDN
 
 		TArray<FanFace> RelevantFacesForVertex[3];
 
-		for(INT OtherTriangleIndex = 0;OtherTriangleIndex < RawTriangles.Num();OtherTriangleIndex++)
+		for(INT CandidateIndex = 0;CandidateIndex < CandidateTriangles.Num();CandidateIndex++)
 		{
+			INT	OtherTriangleIndex = CandidateTriangles(CandidateIndex);
 			for(INT OurVertexIndex = 0; OurVertexIndex < 3; OurVertexIndex++)
 			{		
 				FStaticMeshTriangle*	OtherTriangle = &RawTriangles(OtherTriangleIndex);
@@ -492,6 +863,7 @@ void UStaticMesh::Build()
 		for(INT VertexIndex = 0;VertexIndex < 3;VertexIndex++)
 			VertexIndices[VertexIndex] = FindVertexIndex(
 											this,
+											VertexHash,
 											Triangle->Vertices[VertexIndex],
 											VertexTangentX[VertexIndex],
 											VertexTangentY[VertexIndex],
@@ -518,8 +890,36 @@ void UStaticMesh::Build()
 		}
 	}
 
-	if(NumDegenerates)
-    	debugf(TEXT("%s StaticMesh had %i degenerates"), GetName(), NumDegenerates );
+	BuildData.NumDegenerates = NumDegenerates;
+
+	// Calculate the bounding box.
+
+	FBox	BoundingBox(0);
+
+	for(INT VertexIndex = 0;VertexIndex < Vertices.Num();VertexIndex++)
+		BoundingBox += Vertices(VertexIndex).Position;
+	BoundingBox.GetCenterAndExtents(Bounds.Origin,Bounds.BoxExtent);
+
+	// Calculate the bounding sphere, using the center of the bounding box as the origin.
+
+	Bounds.SphereRadius = 0.0f;
+	for(INT VertexIndex = 0;VertexIndex < Vertices.Num();VertexIndex++)
+		Bounds.SphereRadius = Max((Vertices(VertexIndex).Position - Bounds.Origin).Size(),Bounds.SphereRadius);
+
+	kDOPTree.Build(Vertices,kDOPBuildTriangles);
+
+}
+
+//
+//	UStaticMesh::FinishBuild
+//
+
+void UStaticMesh::FinishBuild(FStaticMeshBuildData& BuildData)
+{
+	TArray<FRawIndexBuffer>&	MaterialIndices = BuildData.MaterialIndices;
+
+	if(BuildData.NumDegenerates)
+    	debugf(TEXT("%s StaticMesh had %i degenerates"), GetName(), BuildData.NumDegenerates );
 
 	PositionVertexBuffer.Update();
 	TangentVertexBuffer.Update();
@@ -570,6 +970,8 @@ void UStaticMesh::Build()
 
 	// Build a list of wireframe edges in the static mesh.
 
+	FStaticMeshBuildHash	EdgeHash(IndexBuffer.Indices.Num());
+
 	for(INT TriangleIndex = 0;TriangleIndex < IndexBuffer.Indices.Num() / 3;TriangleIndex++)
 	{
 		_WORD*	TriangleIndices = &IndexBuffer.Indices(TriangleIndex * 3);
@@ -583,7 +985,7 @@ void UStaticMesh::Build()
 			Edge.Faces[0] = TriangleIndex;
 			Edge.Faces[1] = -1;
 
-			FindEdgeIndex(this,Edge);
+			FindEdgeIndex(this,EdgeHash,Edge);
 		}
 	}
 
@@ -622,27 +1024,9 @@ void UStaticMesh::Build()
 	for(UINT TriangleIndex = 0;TriangleIndex < (UINT)SeparateTriangles.Num();TriangleIndex++)
 		ShadowTriangleDoubleSided(SeparateTriangles(TriangleIndex)) = 1;
 
-	// Calculate the bounding box.
-
-	FBox	BoundingBox(0);
-
-	for(INT VertexIndex = 0;VertexIndex < Vertices.Num();VertexIndex++)
-		BoundingBox += Vertices(VertexIndex).Position;
-	BoundingBox.GetCenterAndExtents(Bounds.Origin,Bounds.BoxExtent);
-
-	// Calculate the bounding sphere, using the center of the bounding box as the origin.
-
-	Bounds.SphereRadius = 0.0f;
-	for(INT VertexIndex = 0;VertexIndex < Vertices.Num();VertexIndex++)
-		Bounds.SphereRadius = Max((Vertices(VertexIndex).Position - Bounds.Origin).Size(),Bounds.SphereRadius);
-
-	kDOPTree.Build(Vertices,kDOPBuildTriangles);
-
 	if( !GIsEditor )
 		RawTriangles.Unload();
 
-	GWarn->EndSlowTask();
-
 }
 
 IMPLEMENT_COMPARE_CONSTREF( FLOAT, UnStaticMeshBuild, { return B - A; } )
@@ -93,7 +93,7 @@ void UStaticMeshComponent::CacheLighting()
 	StaticLightMaps.Empty();
 	IgnoreLights.Empty();
 
-	TArray<ULightComponent*>	RelevantLights;
+	TFrameArray<ULightComponent*>	RelevantLights(16);
 	Scene->GetRelevantLights(this,RelevantLights);
 	for(UINT LightIndex = 0;LightIndex < (UINT)RelevantLights.Num();LightIndex++)
 	{
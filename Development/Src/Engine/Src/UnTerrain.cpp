@@ -1489,7 +1489,7 @@ void UTerrainComponent::CacheLighting()
 
 	const FMatrix&	LocalToWorld = Terrain->LocalToWorld();
 
-	TArray<ULightComponent*>	RelevantLights;
+	TFrameArray<ULightComponent*>	RelevantLights(16);
 	Scene->GetRelevantLights(this,RelevantLights);
 	for(UINT LightIndex = 0;LightIndex < (UINT)RelevantLights.Num();LightIndex++)
 	{
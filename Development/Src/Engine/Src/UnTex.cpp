@@ -171,12 +171,13 @@ void UTextureMovie::PostLoad()
 		}
 
 		// Newly imported objects won't have a linker till they are saved so we have to play from memory. We also play
-		// from memory in the Editor to avoid having an open file handle to an existing package.
-		if( !GIsEditor && GetLinker() )
+		// from memory in the Editor to avoid having an open file handle to an existing package, and for chunk compressed
+		// packages as RawData's offset doesn't point into the file on disk.
+		if( !GIsEditor && GetLinker() && !GetLinker()->bStoredCompressed )
 		{
 			// Have the decoder open the file itself. RawData does NOT need to be loaded as
 			// the data is going to be streamed in from disk.
-			ValidStream = Decoder->Open( GetLinker()->Filename, RawData.GetOffset(), RawSize );
+			ValidStream = Decoder->Open( GetLinker()->Filename, GetLinker()->GetFileOffset( RawData ), RawSize );
 		}
 		else
 		{
@@ -15,6 +15,8 @@
 #pragma pack (pop)
 #endif
 
+/** Version of the compressed mips UTexture2D::Compress stores in the derived data cache, bump when they change */
+#define TEXTURE2D_DERIVEDDATA_VERSION	2
 
 /*-----------------------------------------------------------------------------
 	DXT functions.
@@ -108,6 +110,38 @@ private:
     unsigned int        m_iCurDataSize;
 };
 
+/**
+ * Serializes the format and the mips of a compressed texture, storing them in or
+ * restoring them from the derived data cache.
+ *
+ * @param	Ar			Archive to serialize to or from
+ * @param	Texture		Texture to serialize the mips of
+ */
+static void SerializeCompressedMips( FArchive& Ar, UTexture2D* Texture )
+{
+	INT MipCount = Texture->Mips.Num();
+	Ar << Texture->Format << MipCount;
+	if( Ar.IsLoading() )
+		Texture->Mips.Empty( MipCount );
+
+	for( INT MipIndex=0; MipIndex<MipCount; MipIndex++ )
+	{
+		UINT MipSizeX = 0, MipSizeY = 0;
+		INT NumBytes = 0;
+		if( Ar.IsSaving() )
+		{
+			MipSizeX = Texture->Mips(MipIndex).SizeX;
+			MipSizeY = Texture->Mips(MipIndex).SizeY;
+			NumBytes = Texture->Mips(MipIndex).Data.Num();
+		}
+		Ar << MipSizeX << MipSizeY << NumBytes;
+
+		FStaticMipMap2D* Mip = Ar.IsLoading() ? new(Texture->Mips) FStaticMipMap2D( MipSizeX, MipSizeY, NumBytes ) : &Texture->Mips(MipIndex);
+		if( NumBytes )
+			Ar.Serialize( &Mip->Data(0), NumBytes );
+	}
+}
+
 #endif
 
 /**
@@ -150,6 +184,35 @@ void UTexture2D::Compress()
 	if( !SourceArt.Num() )
 		return;
 
+	// Don't compress textures smaller than DXT blocksize.
+	if( SizeX < 4 || SizeY < 4 )
+		CompressionNone = 1;
+
+	// The compressed mips only depend on the source art and the compression settings, so unchanged
+	// textures are restored from the derived data cache.
+	FDerivedDataKey DerivedDataKey( TEXT("Texture2D"), TEXTURE2D_DERIVEDDATA_VERSION );
+	UBOOL	bSRGB							= SRGB,
+			bRGBE							= RGBE,
+			bCompressionNoAlpha				= CompressionNoAlpha,
+			bCompressionNone				= CompressionNone,
+			bCompressionNoMipmaps			= CompressionNoMipmaps,
+			bCompressionFullDynamicRange	= CompressionFullDynamicRange;
+	DerivedDataKey << SizeX << SizeY << CompressionSettings << bSRGB << bRGBE << bCompressionNoAlpha << bCompressionNone << bCompressionNoMipmaps << bCompressionFullDynamicRange;
+	DerivedDataKey.Serialize( &SourceArt(0), SourceArt.Num() );
+
+	TArray<BYTE> DerivedData;
+	if( GDerivedDataCache && GDerivedDataCache->Get( DerivedDataKey, DerivedData ) )
+	{
+		SourceArt.Unload();
+
+		FBufferReader DerivedDataReader( DerivedData );
+		SerializeCompressedMips( DerivedDataReader, this );
+
+		NumMips = Mips.Num();
+		GResourceManager->UpdateResource( this );
+		return;
+	}
+
 	// Decompress source art.
 	FPNGHelper PNG;
 	PNG.InitCompressed( &SourceArt(0), SourceArt.Num(), SizeX, SizeY );
@@ -158,10 +221,6 @@ void UTexture2D::Compress()
 	// Unload source art as we have raw uncompressed data now.
 	SourceArt.Unload();
 
-	// Don't compress textures smaller than DXT blocksize.
-	if( SizeX < 4 || SizeY < 4 )
-		CompressionNone = 1;
-
 	// Displacement maps get stored as PF_G8
 	if( CompressionSettings == TC_Displacementmap )
 	{
@@ -320,6 +379,14 @@ void UTexture2D::Compress()
 	}
 
 	NumMips = Mips.Num();
+
+	if( GDerivedDataCache )
+	{
+		FBufferWriter DerivedDataWriter( DerivedData );
+		SerializeCompressedMips( DerivedDataWriter, this );
+		GDerivedDataCache->Put( DerivedDataKey, DerivedData );
+	}
+
 	GResourceManager->UpdateResource( this );
 #endif
 }
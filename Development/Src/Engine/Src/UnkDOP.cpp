@@ -238,6 +238,22 @@ UBOOL FkDOP::AABBOverlapCheck(const FBox& LocalAABB)
 	return 1;
 }
 
+/* ===========================================================================
+ * FkDOP::GetSurfaceArea
+ * 
+ * Returns the surface area of the volume. Note this assumes a AABB. If more
+ * planes are to be used, this needs to be rewritten.
+ *
+ * ============================================================================
+ */
+FLOAT FkDOP::GetSurfaceArea(void) const
+{
+	FLOAT SizeX = Max[0] - Min[0];
+	FLOAT SizeY = Max[1] - Min[1];
+	FLOAT SizeZ = Max[2] - Min[2];
+	return 2.f * (SizeX * SizeY + SizeY * SizeZ + SizeZ * SizeX);
+}
+
 /* scion ======================================================================
  * FkDOPTree::Build
  * Author: jg
@@ -247,10 +263,12 @@ UBOOL FkDOP::AABBOverlapCheck(const FBox& LocalAABB)
  *
  * input:	Vertices -- The mesh's vertex data
  *			BuildTriangles -- The list of triangles to use for the build process
+ *			bSurfaceAreaHeuristic -- Whether to split at the lowest surface area
+ *				heuristic cost instead of the mean
  *
  * ============================================================================
  */
-void FkDOPTree::Build(TArray<FStaticMeshVertex>& Vertices,TArray<FkDOPBuildCollisionTriangle>& BuildTriangles)
+void FkDOPTree::Build(TArray<FStaticMeshVertex>& Vertices,TArray<FkDOPBuildCollisionTriangle>& BuildTriangles,UBOOL bSurfaceAreaHeuristic)
 {
 	// Empty the current set of nodes and preallocate the memory so it doesn't
 	// reallocate memory while we are recursively walking the tree
@@ -258,7 +276,7 @@ void FkDOPTree::Build(TArray<FStaticMeshVertex>& Vertices,TArray<FkDOPBuildColli
 	// Add the root node
 	Nodes.Add();
 	// Now tell that node to recursively subdivide the entire set of triangles
-	Nodes(0).SplitTriangleList(Vertices,0,BuildTriangles.Num(),BuildTriangles,Nodes);
+	Nodes(0).SplitTriangleList(Vertices,0,BuildTriangles.Num(),BuildTriangles,Nodes,bSurfaceAreaHeuristic);
 	// Don't waste memory.
 	Nodes.Shrink();
 	// Copy over the triangle information afterward, since they will have
@@ -270,6 +288,104 @@ void FkDOPTree::Build(TArray<FStaticMeshVertex>& Vertices,TArray<FkDOPBuildColli
 	{
 		Triangles(nIndex) = BuildTriangles(nIndex);
 	}
+	// Derive the nodes used by the queries
+	BuildCompactNodes();
+#if KDOP_WIDE_NODES
+	BuildWideNodes();
+#endif
+}
+
+/* ===========================================================================
+ * FindSurfaceAreaSplit
+ * 
+ * Sorts the centroids of the triangles into KDOP_SAH_BINS buckets along each
+ * plane and finds the bucket boundary where the number of triangles on each
+ * side weighted by the surface area of their volume, which is proportional to
+ * the chance of that side being visited by a query, is the lowest.
+ *
+ * input:	Vertices -- The mesh's rendering data
+ *			Start -- The triangle index to start processing with
+ *			NumTris -- The number of triangles to process
+ *			BuildTriangles -- The list of triangles to use for the build process
+ * output:	BestPlane -- The plane to split along
+ *			SplitValue -- Triangles whose centroid projects below this go left
+ *			Returns FALSE if the centroids are all at the same place
+ *
+ * ============================================================================
+ */
+static UBOOL FindSurfaceAreaSplit(TArray<FStaticMeshVertex>& Vertices,INT Start,INT NumTris,TArray<FkDOPBuildCollisionTriangle>& BuildTriangles,INT& BestPlane,FLOAT& SplitValue)
+{
+	FLOAT BestCost = MAX_FLT;
+	BestPlane = -1;
+	for (INT nPlane = 0; nPlane < NUM_PLANES; nPlane++)
+	{
+		// Find the range of the centroids, the bins evenly divide it
+		FLOAT CentroidMin = MAX_FLT;
+		FLOAT CentroidMax = -MAX_FLT;
+		for (INT nTriangle = Start; nTriangle < Start + NumTris; nTriangle++)
+		{
+			FLOAT Dot = BuildTriangles(nTriangle).Centroid | PlaneNormals[nPlane];
+			CentroidMin = Min(CentroidMin,Dot);
+			CentroidMax = Max(CentroidMax,Dot);
+		}
+		if (CentroidMax - CentroidMin <= KINDA_SMALL_NUMBER)
+		{
+			continue;
+		}
+		// Accumulate the bounds and number of the triangles in each bin
+		FkDOP BinBounds[KDOP_SAH_BINS];
+		INT BinCounts[KDOP_SAH_BINS];
+		appMemzero(BinCounts,sizeof(BinCounts));
+		FLOAT BinScale = KDOP_SAH_BINS / (CentroidMax - CentroidMin);
+		for (INT nTriangle = Start; nTriangle < Start + NumTris; nTriangle++)
+		{
+			const FkDOPBuildCollisionTriangle& Triangle = BuildTriangles(nTriangle);
+			INT Bin = Min<INT>(appTrunc(((Triangle.Centroid | PlaneNormals[nPlane]) - CentroidMin) * BinScale),KDOP_SAH_BINS - 1);
+			BinCounts[Bin]++;
+			BinBounds[Bin].AddPoint(Vertices(Triangle.v1).Position);
+			BinBounds[Bin].AddPoint(Vertices(Triangle.v2).Position);
+			BinBounds[Bin].AddPoint(Vertices(Triangle.v3).Position);
+		}
+		// Sweep from the right to get the cost of the right side of each split
+		FLOAT RightCosts[KDOP_SAH_BINS];
+		FkDOP RightBounds;
+		INT RightCount = 0;
+		for (INT nBin = KDOP_SAH_BINS - 1; nBin > 0; nBin--)
+		{
+			for (INT nBoundsPlane = 0; nBoundsPlane < NUM_PLANES; nBoundsPlane++)
+			{
+				RightBounds.Min[nBoundsPlane] = Min(RightBounds.Min[nBoundsPlane],BinBounds[nBin].Min[nBoundsPlane]);
+				RightBounds.Max[nBoundsPlane] = Max(RightBounds.Max[nBoundsPlane],BinBounds[nBin].Max[nBoundsPlane]);
+			}
+			RightCount += BinCounts[nBin];
+			RightCosts[nBin] = RightCount ? RightBounds.GetSurfaceArea() * RightCount : -1.f;
+		}
+		// And from the left, splitting after each bin
+		FkDOP LeftBounds;
+		INT LeftCount = 0;
+		for (INT nBin = 0; nBin < KDOP_SAH_BINS - 1; nBin++)
+		{
+			for (INT nBoundsPlane = 0; nBoundsPlane < NUM_PLANES; nBoundsPlane++)
+			{
+				LeftBounds.Min[nBoundsPlane] = Min(LeftBounds.Min[nBoundsPlane],BinBounds[nBin].Min[nBoundsPlane]);
+				LeftBounds.Max[nBoundsPlane] = Max(LeftBounds.Max[nBoundsPlane],BinBounds[nBin].Max[nBoundsPlane]);
+			}
+			LeftCount += BinCounts[nBin];
+			// Both sides need triangles
+			if (LeftCount == 0 || RightCosts[nBin + 1] < 0.f)
+			{
+				continue;
+			}
+			FLOAT Cost = LeftBounds.GetSurfaceArea() * LeftCount + RightCosts[nBin + 1];
+			if (Cost < BestCost)
+			{
+				BestCost = Cost;
+				BestPlane = nPlane;
+				SplitValue = CentroidMin + (nBin + 1) / BinScale;
+			}
+		}
+	}
+	return BestPlane != -1;
 }
 
 /* scion ======================================================================
@@ -277,18 +393,20 @@ void FkDOPTree::Build(TArray<FStaticMeshVertex>& Vertices,TArray<FkDOPBuildColli
  * Author: jg
  * 
  * Determines if the node is a leaf or not. If it is not a leaf, it subdivides
- * the list of triangles again adding two child nodes and splitting them on
- * the mean (splatter method). Otherwise it sets up the triangle information.
+ * the list of triangles again adding two child nodes and splitting them with
+ * the lowest surface area heuristic cost or on the mean (splatter method).
+ * Otherwise it sets up the triangle information.
  *
  * input:	Vertices -- The mesh's rendering data
  *			Start -- The triangle index to start processing with
  *			NumTris -- The number of triangles to process
  *			BuildTriangles -- The list of triangles to use for the build process
  *			Nodes -- The list of nodes in this tree
+ *			bSurfaceAreaHeuristic -- Whether to use the surface area heuristic
  *
  * ============================================================================
  */
-void FkDOPNode::SplitTriangleList(TArray<FStaticMeshVertex>& Vertices,INT Start,INT NumTris,TArray<FkDOPBuildCollisionTriangle>& BuildTriangles,TArray<FkDOPNode>& Nodes)
+void FkDOPNode::SplitTriangleList(TArray<FStaticMeshVertex>& Vertices,INT Start,INT NumTris,TArray<FkDOPBuildCollisionTriangle>& BuildTriangles,TArray<FkDOPNode>& Nodes,UBOOL bSurfaceAreaHeuristic)
 {
 	// Add all of the triangles to the bounding volume
 	BoundingVolume.AddTriangles(Vertices,Start,NumTris,BuildTriangles);
@@ -301,8 +419,11 @@ void FkDOPNode::SplitTriangleList(TArray<FStaticMeshVertex>& Vertices,INT Start,
         INT BestPlane = -1;
         FLOAT BestMean = 0.f;
         FLOAT BestVariance = 0.f;
+		// Try the surface area heuristic first, it fails if there is nothing
+		// to choose between and then the splatter algorithm handles it
+		UBOOL bFoundSplit = bSurfaceAreaHeuristic && FindSurfaceAreaSplit(Vertices,Start,NumTris,BuildTriangles,BestPlane,BestMean);
         // Determine how to split using the splatter algorithm
-        for (INT nPlane = 0; nPlane < NUM_PLANES; nPlane++)
+        for (INT nPlane = 0; nPlane < NUM_PLANES && !bFoundSplit; nPlane++)
         {
             FLOAT Mean = 0.f;
 			FLOAT Variance = 0.f;
@@ -374,9 +495,9 @@ void FkDOPNode::SplitTriangleList(TArray<FStaticMeshVertex>& Vertices,INT Start,
 		n.LeftNode = Nodes.Add(2);
 		n.RightNode = n.LeftNode + 1;
 		// Have the left node recursively subdivide it's list
-		Nodes(n.LeftNode).SplitTriangleList(Vertices,Start,Left - Start,BuildTriangles,Nodes);
+		Nodes(n.LeftNode).SplitTriangleList(Vertices,Start,Left - Start,BuildTriangles,Nodes,bSurfaceAreaHeuristic);
 		// And now have the right node recursively subdivide it's list
-		Nodes(n.RightNode).SplitTriangleList(Vertices,Left,Start + NumTris - Left,BuildTriangles,Nodes);
+		Nodes(n.RightNode).SplitTriangleList(Vertices,Left,Start + NumTris - Left,BuildTriangles,Nodes,bSurfaceAreaHeuristic);
 	}
 	else
 	{
@@ -403,6 +524,7 @@ void FkDOPNode::SplitTriangleList(TArray<FStaticMeshVertex>& Vertices,INT Start,
 UBOOL FkDOPNode::LineCheck(FkDOPLineCollisionCheck& Check)
 {
 	UBOOL bHit = 0;
+	Check.NodesVisited++;
 	// If this is a node, check the two child nodes and pick the closest one
 	// to recursively check against and only check the second one if there is
 	// not a hit or the hit returned is further out than the second node
@@ -452,7 +574,7 @@ UBOOL FkDOPNode::LineCheck(FkDOPLineCollisionCheck& Check)
 	else
 	{
 		// This is a leaf, check the triangles for a hit
-		bHit = LineCheckTriangles(Check);
+		bHit = LineCheckTriangles(Check,t.StartIndex,t.NumTriangles);
 	}
 	return bHit;
 }
@@ -461,21 +583,23 @@ UBOOL FkDOPNode::LineCheck(FkDOPLineCollisionCheck& Check)
  * FkDOPNode::LineCheckTriangles
  * Author: jg
  * 
- * Works through the list of triangles in this node checking each one for a
+ * Works through a range of the tree's triangles checking each one for a
  * collision.
  *
  * input:	Check -- The aggregated line check data
+ *			StartIndex -- The first triangle to check
+ *			NumTriangles -- The number of triangles to check
  *
  * ============================================================================
  */
-UBOOL FkDOPNode::LineCheckTriangles(FkDOPLineCollisionCheck& Check)
+UBOOL FkDOPNode::LineCheckTriangles(FkDOPLineCollisionCheck& Check,INT StartIndex,INT NumTriangles)
 {
 	// Assume a miss
 	UBOOL bHit = 0;
 	// Loop through all of our triangles. We need to check them all in case
 	// there are two (or more) potential triangles that would collide and let
 	// the code choose the closest
-	for( INT nCollTriIndex = t.StartIndex; nCollTriIndex < t.StartIndex + t.NumTriangles;	nCollTriIndex++ )
+	for( INT nCollTriIndex = StartIndex; nCollTriIndex < StartIndex + NumTriangles;	nCollTriIndex++ )
 	{
 		// Get the collision triangle that we are checking against
 		const FkDOPCollisionTriangle& CollTri =	Check.CollisionTriangles(nCollTriIndex);
@@ -563,6 +687,7 @@ UBOOL FkDOPNode::LineCheckTriangle(FkDOPLineCollisionCheck& Check,const FStaticM
 UBOOL FkDOPNode::BoxCheck(FkDOPBoxCollisionCheck& Check)
 {
 	UBOOL bHit = 0;
+	Check.NodesVisited++;
 	// If this is a node, check the two child nodes and pick the closest one
 	// to recursively check against and only check the second one if there is
 	// not a hit or the hit returned is further out than the second node
@@ -616,7 +741,7 @@ UBOOL FkDOPNode::BoxCheck(FkDOPBoxCollisionCheck& Check)
 	else
 	{
 		// This is a leaf, check the triangles for a hit
-		bHit = BoxCheckTriangles(Check);
+		bHit = BoxCheckTriangles(Check,t.StartIndex,t.NumTriangles);
 	}
 	return bHit;
 }
@@ -625,21 +750,23 @@ UBOOL FkDOPNode::BoxCheck(FkDOPBoxCollisionCheck& Check)
  * FkDOPNode::BoxCheckTriangles
  * Author: jg
  * 
- * Works through the list of triangles in this node checking each one for a
+ * Works through a range of the tree's triangles checking each one for a
  * collision.
  *
  * input:	Check -- The aggregated box check data
+ *			StartIndex -- The first triangle to check
+ *			NumTriangles -- The number of triangles to check
  *
  * ============================================================================
  */
-UBOOL FkDOPNode::BoxCheckTriangles(FkDOPBoxCollisionCheck& Check)
+UBOOL FkDOPNode::BoxCheckTriangles(FkDOPBoxCollisionCheck& Check,INT StartIndex,INT NumTriangles)
 {
 	// Assume a miss
 	UBOOL bHit = 0;
 	// Loop through all of our triangles. We need to check them all in case
 	// there are two (or more) potential triangles that would collide and let
 	// the code choose the closest
-	for( INT nCollTriIndex = t.StartIndex; nCollTriIndex < t.StartIndex + t.NumTriangles;	nCollTriIndex++ )
+	for( INT nCollTriIndex = StartIndex; nCollTriIndex < StartIndex + NumTriangles;	nCollTriIndex++ )
 	{
 		// Get the collision triangle that we are checking against
 		const FkDOPCollisionTriangle& CollTri = Check.CollisionTriangles(nCollTriIndex);
@@ -704,6 +831,7 @@ UBOOL FkDOPNode::BoxCheckTriangle(FkDOPBoxCollisionCheck& Check,const FVector& v
 UBOOL FkDOPNode::PointCheck(FkDOPPointCollisionCheck& Check)
 {
 	UBOOL bHit = 0;
+	Check.NodesVisited++;
 	// If this is a node, check the two child nodes recursively
 	if (bIsLeaf == 0)
 	{
@@ -746,7 +874,7 @@ UBOOL FkDOPNode::PointCheck(FkDOPPointCollisionCheck& Check)
 	else
 	{
 		// This is a leaf, check the triangles for a hit
-		bHit = PointCheckTriangles(Check);
+		bHit = PointCheckTriangles(Check,t.StartIndex,t.NumTriangles);
 	}
 	return bHit;
 }
@@ -786,21 +914,23 @@ void FkDOPNode::SphereQuery(FkDOPSphereQuery& Query)
  * FkDOPNode::PointCheckTriangles
  * Author: jg
  * 
- * Works through the list of triangles in this node checking each one for a
+ * Works through a range of the tree's triangles checking each one for a
  * collision.
  *
  * input:	Check -- The aggregated point check data
+ *			StartIndex -- The first triangle to check
+ *			NumTriangles -- The number of triangles to check
  *
  * ============================================================================
  */
-UBOOL FkDOPNode::PointCheckTriangles(FkDOPPointCollisionCheck& Check)
+UBOOL FkDOPNode::PointCheckTriangles(FkDOPPointCollisionCheck& Check,INT StartIndex,INT NumTriangles)
 {
 	// Assume a miss
 	UBOOL bHit = 0;
 	// Loop through all of our triangles. We need to check them all in case
 	// there are two (or more) potential triangles that would collide and let
 	// the code choose the closest
-	for( INT nCollTriIndex = t.StartIndex; nCollTriIndex < t.StartIndex + t.NumTriangles;	nCollTriIndex++ )
+	for( INT nCollTriIndex = StartIndex; nCollTriIndex < StartIndex + NumTriangles;	nCollTriIndex++ )
 	{
 		// Get the collision triangle that we are checking against
 		const FkDOPCollisionTriangle& CollTri =	Check.CollisionTriangles(nCollTriIndex);
@@ -846,6 +976,291 @@ UBOOL FkDOPNode::PointCheckTriangle(FkDOPPointCollisionCheck& Check, const FVect
 	return 0;
 }
 
+/* ===========================================================================
+ * FkDOPCompactNode::SetBounds
+ * 
+ * Quantizes the bounds relative to the parent's, rounding outwards. The steps
+ * are verified with the same arithmetic GetBounds uses, so the decoded volume
+ * always contains the original one despite rounding errors.
+ *
+ * input:	ParentBounds -- The decoded bounds of the parent node
+ *			Bounds -- The full precision bounds of this node
+ *
+ * ============================================================================
+ */
+void FkDOPCompactNode::SetBounds(const FkDOP& ParentBounds,const FkDOP& Bounds)
+{
+	for (INT nPlane = 0; nPlane < NUM_PLANES; nPlane++)
+	{
+		FLOAT Scale = (ParentBounds.Max[nPlane] - ParentBounds.Min[nPlane]) * (1.f / 65535.f);
+		INT MinSteps = 0;
+		INT MaxSteps = 0;
+		if (Scale > 0.f)
+		{
+			MinSteps = Clamp<INT>(appFloor((Bounds.Min[nPlane] - ParentBounds.Min[nPlane]) / Scale),0,65535);
+			MaxSteps = Clamp<INT>(appFloor((ParentBounds.Max[nPlane] - Bounds.Max[nPlane]) / Scale),0,65535);
+			// Zero steps decode to the parent's planes exactly
+			while (MinSteps > 0 && ParentBounds.Min[nPlane] + MinSteps * Scale > Bounds.Min[nPlane])
+			{
+				MinSteps--;
+			}
+			while (MaxSteps > 0 && ParentBounds.Max[nPlane] - MaxSteps * Scale < Bounds.Max[nPlane])
+			{
+				MaxSteps--;
+			}
+		}
+		Min[nPlane] = (_WORD)MinSteps;
+		Max[nPlane] = (_WORD)MaxSteps;
+	}
+}
+
+/* ===========================================================================
+ * BuildCompactNode
+ * 
+ * Fills in the compact copy of a node and recursively of its children, which
+ * are quantized relative to the decoded bounds of this node.
+ *
+ * input:	Tree -- The tree being built
+ *			NodeIndex -- The node to copy
+ *			Bounds -- The decoded bounds of the node
+ *
+ * ============================================================================
+ */
+static void BuildCompactNode(FkDOPTree& Tree,INT NodeIndex,const FkDOP& Bounds)
+{
+	const FkDOPNode& Node = Tree.Nodes(NodeIndex);
+	if (Node.bIsLeaf)
+	{
+		Tree.CompactNodes(NodeIndex).Index = Node.t.StartIndex;
+		Tree.CompactNodes(NodeIndex).NumTriangles = Node.t.NumTriangles;
+	}
+	else
+	{
+		// The compact node only stores the first child
+		check(Node.n.RightNode == Node.n.LeftNode + 1);
+		Tree.CompactNodes(NodeIndex).Index = Node.n.LeftNode;
+		Tree.CompactNodes(NodeIndex).NumTriangles = KDOP_COMPACT_INTERIOR;
+		for (INT nChild = Node.n.LeftNode; nChild <= Node.n.RightNode; nChild++)
+		{
+			FkDOP ChildBounds;
+			Tree.CompactNodes(nChild).SetBounds(Bounds,Tree.Nodes(nChild).BoundingVolume);
+			Tree.CompactNodes(nChild).GetBounds(Bounds,ChildBounds);
+			BuildCompactNode(Tree,nChild,ChildBounds);
+		}
+	}
+}
+
+/* ===========================================================================
+ * FkDOPTree::BuildCompactNodes
+ * 
+ * Quantizes the nodes into CompactNodes, which have the same indices.
+ *
+ * ============================================================================
+ */
+void FkDOPTree::BuildCompactNodes(void)
+{
+	CompactNodes.Empty(Nodes.Num());
+	CompactNodes.AddZeroed(Nodes.Num());
+	if (Nodes.Num())
+	{
+		// The root is decoded relative to its own bounds, which zero steps do exactly
+		BuildCompactNode(*this,0,Nodes(0).BoundingVolume);
+	}
+}
+
+/* ===========================================================================
+ * BuildWideNode
+ * 
+ * Creates the wide node covering the subtree of a binary node. The children of
+ * the binary node become its children, and then the child with the biggest
+ * surface area is replaced by its own children until there are four.
+ *
+ * input:	Tree -- The tree being built
+ *			NodeIndex -- The binary node
+ * output:	Returns the index of the wide node
+ *
+ * ============================================================================
+ */
+static INT BuildWideNode(FkDOPTree& Tree,INT NodeIndex)
+{
+	INT Children[4];
+	INT NumChildren = 0;
+	const FkDOPNode& Node = Tree.Nodes(NodeIndex);
+	if (Node.bIsLeaf)
+	{
+		// Only happens for a root holding all triangles
+		Children[NumChildren++] = NodeIndex;
+	}
+	else
+	{
+		Children[NumChildren++] = Node.n.LeftNode;
+		Children[NumChildren++] = Node.n.RightNode;
+	}
+	while (NumChildren < 4)
+	{
+		INT BestChild = -1;
+		FLOAT BestArea = -1.f;
+		for (INT nChild = 0; nChild < NumChildren; nChild++)
+		{
+			const FkDOPNode& Child = Tree.Nodes(Children[nChild]);
+			if (!Child.bIsLeaf && Child.BoundingVolume.GetSurfaceArea() > BestArea)
+			{
+				BestChild = nChild;
+				BestArea = Child.BoundingVolume.GetSurfaceArea();
+			}
+		}
+		if (BestChild == -1)
+		{
+			break;
+		}
+		const FkDOPNode& Child = Tree.Nodes(Children[BestChild]);
+		Children[BestChild] = Child.n.LeftNode;
+		Children[NumChildren++] = Child.n.RightNode;
+	}
+	INT WideIndex = Tree.WideNodes.Add();
+	for (INT nChild = 0; nChild < 4; nChild++)
+	{
+		// Unused children are inside out so they are never hit
+		FkDOP ChildBounds;
+		DWORD ChildValue = KDOP_WIDE_LEAF;
+		if (nChild < NumChildren)
+		{
+			const FkDOPNode& Child = Tree.Nodes(Children[nChild]);
+			ChildBounds = Child.BoundingVolume;
+			if (Child.bIsLeaf)
+			{
+				ChildValue = KDOP_WIDE_LEAF | (Child.t.NumTriangles << 16) | Child.t.StartIndex;
+			}
+			else
+			{
+				ChildValue = BuildWideNode(Tree,Children[nChild]);
+			}
+		}
+		// The recursion may have reallocated the nodes
+		FkDOPWideNode& WideNode = Tree.WideNodes(WideIndex);
+		for (INT nPlane = 0; nPlane < NUM_PLANES; nPlane++)
+		{
+			WideNode.Min[nPlane][nChild] = ChildBounds.Min[nPlane];
+			WideNode.Max[nPlane][nChild] = ChildBounds.Max[nPlane];
+		}
+		WideNode.Children[nChild] = ChildValue;
+	}
+	return WideIndex;
+}
+
+/* ===========================================================================
+ * FkDOPTree::BuildWideNodes
+ * 
+ * Collapses the binary nodes into WideNodes.
+ *
+ * ============================================================================
+ */
+void FkDOPTree::BuildWideNodes(void)
+{
+	WideNodes.Empty(Nodes.Num() / 3 + 1);
+	if (Nodes.Num())
+	{
+		BuildWideNode(*this,0);
+	}
+	WideNodes.Shrink();
+}
+
+/* ===========================================================================
+ * FkDOPWideNode::LineCheck
+ * 
+ * Clips the line against the slabs of the four children's bounds expanded by
+ * FUDGE_SIZE. Note this assumes a AABB. If more planes are to be used, this
+ * needs to be rewritten.
+ *
+ * input:	Check -- The aggregated line check data
+ * output:	HitTimes -- The time each child was entered at, 0 if the line
+ *				starts inside
+ *			Returns a bit per child that was hit
+ *
+ * ============================================================================
+ */
+DWORD FkDOPWideNode::LineCheck(FkDOPLineCollisionCheck& Check,FLOAT* HitTimes) const
+{
+	const FLOAT* Start = &Check.LocalStart.X;
+	const FLOAT* Dir = &Check.LocalDir.X;
+	const FLOAT* OneOverDir = &Check.LocalOneOverDir.X;
+#if __HAS_SSE__
+	const __m128 Fudge = _mm_set_ps1(FUDGE_SIZE);
+	__m128 Entry = _mm_setzero_ps();
+	__m128 Exit = _mm_set_ps1(1.f);
+	__m128 Valid = _mm_cmpeq_ps(Entry,Entry);
+	for (INT nPlane = 0; nPlane < NUM_PLANES; nPlane++)
+	{
+		__m128 SlabMin = _mm_sub_ps(_mm_loadu_ps(Min[nPlane]),Fudge);
+		__m128 SlabMax = _mm_add_ps(_mm_loadu_ps(Max[nPlane]),Fudge);
+		__m128 PlaneStart = _mm_set_ps1(Start[nPlane]);
+		if (Dir[nPlane] == 0.f)
+		{
+			// Parallel to the slab, so the line has to start between its planes
+			Valid = _mm_and_ps(Valid,_mm_and_ps(_mm_cmpge_ps(PlaneStart,SlabMin),_mm_cmple_ps(PlaneStart,SlabMax)));
+		}
+		else
+		{
+			__m128 PlaneOneOverDir = _mm_set_ps1(OneOverDir[nPlane]);
+			__m128 MinTime = _mm_mul_ps(_mm_sub_ps(SlabMin,PlaneStart),PlaneOneOverDir);
+			__m128 MaxTime = _mm_mul_ps(_mm_sub_ps(SlabMax,PlaneStart),PlaneOneOverDir);
+			// Picking the near plane by direction keeps inside out bounds missing
+			if (Dir[nPlane] > 0.f)
+			{
+				Entry = _mm_max_ps(Entry,MinTime);
+				Exit = _mm_min_ps(Exit,MaxTime);
+			}
+			else
+			{
+				Entry = _mm_max_ps(Entry,MaxTime);
+				Exit = _mm_min_ps(Exit,MinTime);
+			}
+		}
+	}
+	Valid = _mm_and_ps(Valid,_mm_cmple_ps(Entry,Exit));
+	_mm_storeu_ps(HitTimes,Entry);
+	return _mm_movemask_ps(Valid);
+#else
+	DWORD HitMask = 0;
+	for (INT nChild = 0; nChild < 4; nChild++)
+	{
+		FLOAT Entry = 0.f;
+		FLOAT Exit = 1.f;
+		UBOOL bValid = 1;
+		for (INT nPlane = 0; nPlane < NUM_PLANES; nPlane++)
+		{
+			FLOAT SlabMin = Min[nPlane][nChild] - FUDGE_SIZE;
+			FLOAT SlabMax = Max[nPlane][nChild] + FUDGE_SIZE;
+			if (Dir[nPlane] == 0.f)
+			{
+				bValid &= Start[nPlane] >= SlabMin && Start[nPlane] <= SlabMax;
+			}
+			else
+			{
+				FLOAT MinTime = (SlabMin - Start[nPlane]) * OneOverDir[nPlane];
+				FLOAT MaxTime = (SlabMax - Start[nPlane]) * OneOverDir[nPlane];
+				if (Dir[nPlane] > 0.f)
+				{
+					Entry = Max(Entry,MinTime);
+					Exit = Min(Exit,MaxTime);
+				}
+				else
+				{
+					Entry = Max(Entry,MaxTime);
+					Exit = Min(Exit,MinTime);
+				}
+			}
+		}
+		HitTimes[nChild] = Entry;
+		if (bValid && Entry <= Exit)
+		{
+			HitMask |= 1 << nChild;
+		}
+	}
+	return HitMask;
+#endif
+}
+
 /* scion ======================================================================
  * FkDOPTree::LineCheck
  * Author: jg
@@ -858,6 +1273,156 @@ UBOOL FkDOPNode::PointCheckTriangle(FkDOPPointCollisionCheck& Check, const FVect
  * ============================================================================
  */
 UBOOL FkDOPTree::LineCheck(FkDOPLineCollisionCheck& Check)
+{
+#if KDOP_WIDE_NODES
+	return LineCheckWide(Check);
+#else
+	UBOOL bHit = 0;
+	FLOAT HitTime;
+	// Check against the first bounding volume and decide whether to go further
+	if (Nodes(0).BoundingVolume.LineCheck(Check,HitTime))
+	{
+		// Recursively check for a hit
+		bHit = LineCheckCompact(Check,0,Nodes(0).BoundingVolume);
+	}
+	return bHit;
+#endif
+}
+
+/* ===========================================================================
+ * FkDOPTree::LineCheckCompact
+ * 
+ * Checks the children of a compact node the same way FkDOPNode::LineCheck
+ * does, nearest first, or the node's triangles if it is a leaf.
+ *
+ * input:	Check -- The aggregated line check data
+ *			NodeIndex -- The node to check
+ *			Bounds -- The decoded bounds of the node
+ *
+ * ============================================================================
+ */
+UBOOL FkDOPTree::LineCheckCompact(FkDOPLineCollisionCheck& Check,INT NodeIndex,const FkDOP& Bounds)
+{
+	Check.NodesVisited++;
+	const FkDOPCompactNode& Node = CompactNodes(NodeIndex);
+	if (Node.NumTriangles != KDOP_COMPACT_INTERIOR)
+	{
+		return FkDOPNode::LineCheckTriangles(Check,Node.Index,Node.NumTriangles);
+	}
+	FkDOP ChildBounds[2];
+	FLOAT ChildTimes[2];
+	UBOOL ChildHits[2];
+	for (INT nChild = 0; nChild < 2; nChild++)
+	{
+		CompactNodes(Node.Index + nChild).GetBounds(Bounds,ChildBounds[nChild]);
+		ChildHits[nChild] = ChildBounds[nChild].LineCheck(Check,ChildTimes[nChild]);
+	}
+	// Check the right node first if it is closer
+	INT NearChild = (ChildHits[0] && ChildHits[1] && ChildTimes[1] < ChildTimes[0]) ? 1 : 0;
+	UBOOL bHit = 0;
+	for (INT nOrder = 0; nOrder < 2; nOrder++)
+	{
+		INT nChild = nOrder ^ NearChild;
+		// Only search the node if it may hold a closer hit
+		if (ChildHits[nChild] && Check.Result->Time > ChildTimes[nChild])
+		{
+			bHit |= LineCheckCompact(Check,Node.Index + nChild,ChildBounds[nChild]);
+		}
+	}
+	return bHit;
+}
+
+/* ===========================================================================
+ * FkDOPTree::LineCheckWide
+ * 
+ * Figures out whether the check even hits the root node's bounding volume. If
+ * it does, it recursively searches the wide nodes for a triangle to hit.
+ *
+ * input:	Check -- The aggregated line check data
+ *
+ * ============================================================================
+ */
+UBOOL FkDOPTree::LineCheckWide(FkDOPLineCollisionCheck& Check)
+{
+	UBOOL bHit = 0;
+	FLOAT HitTime;
+	// Check against the first bounding volume and decide whether to go further
+	if (WideNodes.Num() && Nodes(0).BoundingVolume.LineCheck(Check,HitTime))
+	{
+		// Recursively check for a hit
+		bHit = LineCheckWide(Check,0);
+	}
+	return bHit;
+}
+
+/* ===========================================================================
+ * FkDOPTree::LineCheckWide
+ * 
+ * Tests the line against all children of a wide node at once and searches
+ * the ones that were hit in the order they are entered.
+ *
+ * input:	Check -- The aggregated line check data
+ *			NodeIndex -- The wide node to check
+ *
+ * ============================================================================
+ */
+UBOOL FkDOPTree::LineCheckWide(FkDOPLineCollisionCheck& Check,INT NodeIndex)
+{
+	Check.NodesVisited++;
+	const FkDOPWideNode& Node = WideNodes(NodeIndex);
+	FLOAT HitTimes[4];
+	DWORD HitMask = Node.LineCheck(Check,HitTimes);
+	// Insertion sort the children that were hit by their entry time
+	INT Order[4];
+	INT NumHits = 0;
+	for (INT nChild = 0; nChild < 4; nChild++)
+	{
+		if (HitMask & (1 << nChild))
+		{
+			INT nInsert = NumHits++;
+			while (nInsert > 0 && HitTimes[Order[nInsert - 1]] > HitTimes[nChild])
+			{
+				Order[nInsert] = Order[nInsert - 1];
+				nInsert--;
+			}
+			Order[nInsert] = nChild;
+		}
+	}
+	UBOOL bHit = 0;
+	for (INT nHit = 0; nHit < NumHits; nHit++)
+	{
+		INT nChild = Order[nHit];
+		// The remaining children are entered after the closest hit so far
+		if (Check.Result->Time <= HitTimes[nChild])
+		{
+			break;
+		}
+		DWORD Child = Node.Children[nChild];
+		if (Child & KDOP_WIDE_LEAF)
+		{
+			bHit |= FkDOPNode::LineCheckTriangles(Check,Child & 0xFFFF,(Child >> 16) & 0x7FFF);
+		}
+		else
+		{
+			bHit |= LineCheckWide(Check,Child);
+		}
+	}
+	return bHit;
+}
+
+/* scion ======================================================================
+ * FkDOPTree::LineCheckNodes
+ * Author: jg
+ * 
+ * Figures out whether the check even hits the root node's bounding volume. If
+ * it does, it recursively searches the full precision nodes for a triangle to
+ * hit.
+ *
+ * input:	Check -- The aggregated line check data
+ *
+ * ============================================================================
+ */
+UBOOL FkDOPTree::LineCheckNodes(FkDOPLineCollisionCheck& Check)
 {
 	UBOOL bHit = 0;
 	FLOAT HitTime;
@@ -882,6 +1447,79 @@ UBOOL FkDOPTree::LineCheck(FkDOPLineCollisionCheck& Check)
  * ============================================================================
  */
 UBOOL FkDOPTree::BoxCheck(FkDOPBoxCollisionCheck& Check)
+{
+	UBOOL bHit = 0;
+	FLOAT HitTime;
+	// Check the root node's bounding volume expanded by the extent
+	FkDOP kDOP(Nodes(0).BoundingVolume,Check.LocalExtent);
+	// Check against the first bounding volume and decide whether to go further
+	if (kDOP.LineCheck(Check,HitTime))
+	{
+		// Recursively check for a hit
+		bHit = BoxCheckCompact(Check,0,Nodes(0).BoundingVolume);
+	}
+	return bHit;
+}
+
+/* ===========================================================================
+ * FkDOPTree::BoxCheckCompact
+ * 
+ * Checks the children of a compact node the same way FkDOPNode::BoxCheck
+ * does, or the node's triangles if it is a leaf.
+ *
+ * input:	Check -- The aggregated box check data
+ *			NodeIndex -- The node to check
+ *			Bounds -- The decoded bounds of the node
+ *
+ * ============================================================================
+ */
+UBOOL FkDOPTree::BoxCheckCompact(FkDOPBoxCollisionCheck& Check,INT NodeIndex,const FkDOP& Bounds)
+{
+	Check.NodesVisited++;
+	const FkDOPCompactNode& Node = CompactNodes(NodeIndex);
+	if (Node.NumTriangles != KDOP_COMPACT_INTERIOR)
+	{
+		return FkDOPNode::BoxCheckTriangles(Check,Node.Index,Node.NumTriangles);
+	}
+	FkDOP ChildBounds[2];
+	FLOAT ChildTimes[2];
+	UBOOL ChildHits[2];
+	for (INT nChild = 0; nChild < 2; nChild++)
+	{
+		CompactNodes(Node.Index + nChild).GetBounds(Bounds,ChildBounds[nChild]);
+		// Test the kDOP expanded by the extent
+		FkDOP kDOP(ChildBounds[nChild],Check.LocalExtent);
+		ChildHits[nChild] = kDOP.LineCheck(Check,ChildTimes[nChild]);
+	}
+	// Check the right node first if it is closer
+	INT NearChild = (ChildHits[0] && ChildHits[1] && ChildTimes[1] < ChildTimes[0]) ? 1 : 0;
+	UBOOL bHit = 0;
+	if (ChildHits[NearChild])
+	{
+		bHit = BoxCheckCompact(Check,Node.Index + NearChild,ChildBounds[NearChild]);
+	}
+	// The far node is only searched after a miss or if it may hold a closer hit
+	INT FarChild = NearChild ^ 1;
+	if (ChildHits[FarChild] && (Check.Result->Time > ChildTimes[FarChild] || bHit == 0))
+	{
+		bHit |= BoxCheckCompact(Check,Node.Index + FarChild,ChildBounds[FarChild]);
+	}
+	return bHit;
+}
+
+/* scion ======================================================================
+ * FkDOPTree::BoxCheckNodes
+ * Author: jg
+ * 
+ * Figures out whether the check even hits the root node's bounding volume. If
+ * it does, it recursively searches the full precision nodes for a triangle to
+ * hit.
+ *
+ * input:	Check -- The aggregated box check data
+ *
+ * ============================================================================
+ */
+UBOOL FkDOPTree::BoxCheckNodes(FkDOPBoxCollisionCheck& Check)
 {
 	UBOOL bHit = 0;
 	FLOAT HitTime;
@@ -908,6 +1546,67 @@ UBOOL FkDOPTree::BoxCheck(FkDOPBoxCollisionCheck& Check)
  * ============================================================================
  */
 UBOOL FkDOPTree::PointCheck(FkDOPPointCollisionCheck& Check)
+{
+	UBOOL bHit = 0;
+	// Check the root node's bounding volume expanded by the extent
+	FkDOP kDOP(Nodes(0).BoundingVolume,Check.LocalExtent);
+	// Check against the first bounding volume and decide whether to go further
+	if (kDOP.PointCheck(Check))
+	{
+		// Recursively check for a hit
+		bHit = PointCheckCompact(Check,0,Nodes(0).BoundingVolume);
+	}
+	return bHit;
+}
+
+/* ===========================================================================
+ * FkDOPTree::PointCheckCompact
+ * 
+ * Checks all children of a compact node the point is inside of, or the
+ * node's triangles if it is a leaf.
+ *
+ * input:	Check -- The aggregated point check data
+ *			NodeIndex -- The node to check
+ *			Bounds -- The decoded bounds of the node
+ *
+ * ============================================================================
+ */
+UBOOL FkDOPTree::PointCheckCompact(FkDOPPointCollisionCheck& Check,INT NodeIndex,const FkDOP& Bounds)
+{
+	Check.NodesVisited++;
+	const FkDOPCompactNode& Node = CompactNodes(NodeIndex);
+	if (Node.NumTriangles != KDOP_COMPACT_INTERIOR)
+	{
+		return FkDOPNode::PointCheckTriangles(Check,Node.Index,Node.NumTriangles);
+	}
+	UBOOL bHit = 0;
+	for (INT nChild = 0; nChild < 2; nChild++)
+	{
+		FkDOP ChildBounds;
+		CompactNodes(Node.Index + nChild).GetBounds(Bounds,ChildBounds);
+		// Test the kDOP expanded by the extent
+		FkDOP kDOP(ChildBounds,Check.LocalExtent);
+		if (kDOP.PointCheck(Check))
+		{
+			bHit |= PointCheckCompact(Check,Node.Index + nChild,ChildBounds);
+		}
+	}
+	return bHit;
+}
+
+/* scion ======================================================================
+ * FkDOPTree::PointCheckNodes
+ * Author: jg
+ * 
+ * Figures out whether the check even hits the root node's bounding volume. If
+ * it does, it recursively searches the full precision nodes for a triangle to
+ * hit.
+ *
+ * input:	Check -- The aggregated point check data
+ *
+ * ============================================================================
+ */
+UBOOL FkDOPTree::PointCheckNodes(FkDOPPointCollisionCheck& Check)
 {
 	UBOOL bHit = 0;
 	// Check the root node's bounding volume expanded by the extent
@@ -935,9 +1634,45 @@ UBOOL FkDOPTree::PointCheck(FkDOPPointCollisionCheck& Check)
 void FkDOPTree::SphereQuery(FkDOPSphereQuery& Query)
 {
 	// Check the query box overlaps the root node KDOP. If so, run query recursively.
-	if( Query.Nodes(0).BoundingVolume.AABBOverlapCheck( Query.LocalBox ) )
+	if( Nodes(0).BoundingVolume.AABBOverlapCheck( Query.LocalBox ) )
 	{
-		Query.Nodes(0).SphereQuery( Query );
+		SphereQueryCompact( Query, 0, Nodes(0).BoundingVolume );
+	}
+
+}
+
+/* ===========================================================================
+ * FkDOPTree::SphereQueryCompact
+ * 
+ * Find triangles that overlap the given sphere. We assume that the supplied
+ * box overlaps this node.
+ *
+ * input:	Query -- Query information
+ *			NodeIndex -- The node to check
+ *			Bounds -- The decoded bounds of the node
+ *
+ * ============================================================================
+ */
+void FkDOPTree::SphereQueryCompact(FkDOPSphereQuery& Query,INT NodeIndex,const FkDOP& Bounds)
+{
+	const FkDOPCompactNode& Node = CompactNodes(NodeIndex);
+	// If not leaf, check against each child.
+	if( Node.NumTriangles == KDOP_COMPACT_INTERIOR )
+	{
+		for( INT nChild = 0; nChild < 2; nChild++ )
+		{
+			FkDOP ChildBounds;
+			CompactNodes(Node.Index + nChild).GetBounds(Bounds,ChildBounds);
+			if( ChildBounds.AABBOverlapCheck(Query.LocalBox) )
+				SphereQueryCompact(Query,Node.Index + nChild,ChildBounds);
+		}
+	}
+	else // Otherwise, add all the triangles in this node to the list.
+	{
+		for(INT i=Node.Index; i<Node.Index+Node.NumTriangles; i++)
+		{
+			Query.ReturnTriangles.AddItem( i );
+		}
 	}
 
 }
@@ -974,7 +1709,8 @@ FkDOPLineCollisionCheck::FkDOPLineCollisionCheck(FCheckResult* InResult,UStaticM
 	Start(InStart), End(InEnd),
 	kDOPTree(InComponent->StaticMesh->kDOPTree), Nodes(InComponent->StaticMesh->kDOPTree.Nodes),
 	CollisionTriangles(InComponent->StaticMesh->kDOPTree.Triangles),
-	Triangles(InComponent->StaticMesh->Vertices)
+	Triangles(InComponent->StaticMesh->Vertices),
+	NodesVisited(0)
 {
 	// For calculating hit normals
 	WorldToLocal = Component->LocalToWorld.Inverse();
@@ -25,6 +25,13 @@ class UDecompressCommandlet : public UCommandlet
 	INT Main( const TCHAR* Parms );
 };
 
+class UCodecBenchmarkCommandlet : public UCommandlet
+{
+	DECLARE_CLASS(UCodecBenchmarkCommandlet, UCommandlet, CLASS_Transient,IpDrv);
+
+	INT Main( const TCHAR* Parms );
+};
+
 /*-----------------------------------------------------------------------------
 	The End.
 -----------------------------------------------------------------------------*/
@@ -182,6 +182,8 @@ UBOOL UTcpNetDriver::InitListen( FNetworkNotify* InNotify, FURL& LocalURL, FStri
 
 void UTcpNetDriver::TickDispatch( FLOAT DeltaTime )
 {
+	MEMORY_TAG_SCOPE(Net);
+
 	Super::TickDispatch( DeltaTime );
 
 	// Process all incoming packets.
@@ -0,0 +1,213 @@
+/*=============================================================================
+	UCodecBenchmarkCommandlet.cpp: Compression ratio and throughput of the
+	download codec chain.
+	Copyright 2004 Epic Games, Inc. All Rights Reserved.
+=============================================================================*/
+
+#include "UnIpDrv.h"
+#include "UnIpDrvCommandlets.h"
+#include "FCodec.h"
+#include "../../zlib/zlib.h"
+
+/*-----------------------------------------------------------------------------
+	FCodecBWTReference.
+-----------------------------------------------------------------------------*/
+
+/**
+ * The block sorting transform as it was implemented before FCodecBWT::SortSuffixes,
+ * sorting suffixes with appQsort and a byte by byte comparison. Produces the same stream
+ * as FCodecBWT, so FCodecBWT decodes it. Uses static state, benchmark use only.
+ */
+class FCodecBWTReference : public FCodecBWT
+{
+private:
+	enum {MAX_BUFFER_SIZE=0x40000};
+	static BYTE* CompressBuffer;
+	static INT CompressLength;
+	static INT ClampedBufferCompare( const INT* P1, const INT* P2 )
+	{
+		BYTE* B1 = CompressBuffer + *P1;
+		BYTE* B2 = CompressBuffer + *P2;
+		for( INT Count=CompressLength-Max(*P1,*P2); Count>0; Count--,B1++,B2++ )
+		{
+			if( *B1 < *B2 )
+				return -1;
+			else if( *B1 > *B2 )
+				return 1;
+		}
+		return *P1 - *P2;
+	}
+public:
+	FCodecBWTReference()
+	: FCodecBWT( 0 )
+	{}
+	UBOOL Encode( FArchive& In, FArchive& Out )
+	{
+		TArray<BYTE> CompressBufferArray(MAX_BUFFER_SIZE);
+		TArray<INT>  CompressPosition   (MAX_BUFFER_SIZE+1);
+		CompressBuffer = &CompressBufferArray(0);
+		INT i, First=0, Last=0;
+		while( !In.AtEnd() )
+		{
+			CompressLength = Min<INT>( In.TotalSize()-In.Tell(), MAX_BUFFER_SIZE );
+			In.Serialize( CompressBuffer, CompressLength );
+			for( i=0; i<CompressLength+1; i++ )
+				CompressPosition(i) = i;
+			appQsort( &CompressPosition(0), CompressLength+1, sizeof(INT), (QSORT_COMPARE)ClampedBufferCompare );
+			for( i=0; i<CompressLength+1; i++ )
+				if( CompressPosition(i)==1 )
+					First = i;
+				else if( CompressPosition(i)==0 )
+					Last = i;
+			Out << CompressLength << First << Last;
+			for( i=0; i<CompressLength+1; i++ )
+				Out << CompressBuffer[CompressPosition(i)?CompressPosition(i)-1:0];
+		}
+		return 0;
+	}
+};
+BYTE* FCodecBWTReference::CompressBuffer;
+INT   FCodecBWTReference::CompressLength;
+
+/*-----------------------------------------------------------------------------
+	UCodecBenchmarkCommandlet.
+-----------------------------------------------------------------------------*/
+
+/**
+ * Builds the codec chain UDownload decodes compressed files with.
+ *
+ * @param	Codec	Chain to fill in
+ * @param	BWT		Block sorting stage to use
+ */
+static void BuildCodecChain( FCodecFull& Codec, FCodecBWT* BWT )
+{
+	Codec.AddCodec(new FCodecRLE);
+	Codec.AddCodec(BWT);
+	Codec.AddCodec(new FCodecMTF);
+	Codec.AddCodec(new FCodecRLE);
+	Codec.AddCodec(new FCodecHuffman);
+}
+
+/**
+ * Encodes and decodes a file with a codec chain, logging ratio and throughput.
+ *
+ * @param	Name		Name of the chain to log
+ * @param	Encoder		Chain to encode with
+ * @param	Decoder		Chain to decode with
+ * @param	Src			Data to encode
+ * @param	Encoded		[out] encoded data
+ */
+static void BenchmarkCodec( const TCHAR* Name, FCodec& Encoder, FCodec& Decoder, const TArray<BYTE>& Src, TArray<BYTE>& Encoded )
+{
+	Encoded.Empty();
+	TArray<BYTE> Decoded;
+
+	DOUBLE StartTime = appSeconds();
+	FBufferReader EncodeReader( Src );
+	FBufferWriter EncodeWriter( Encoded );
+	Encoder.Encode( EncodeReader, EncodeWriter );
+	const DOUBLE EncodeTime = appSeconds() - StartTime;
+
+	StartTime = appSeconds();
+	FBufferReader DecodeReader( Encoded );
+	FBufferWriter DecodeWriter( Decoded );
+	Decoder.Decode( DecodeReader, DecodeWriter );
+	const DOUBLE DecodeTime = appSeconds() - StartTime;
+
+	if( Decoded.Num() != Src.Num() || appMemcmp( &Decoded(0), &Src(0), Src.Num() ) )
+		appErrorf( TEXT("%s failed to reproduce the input"), Name );
+
+	const DOUBLE MegaBytes = Src.Num() / (1024.0 * 1024.0);
+	warnf( TEXT("  %-10s %6.2f%%  encode %8.2f MB/s  decode %8.2f MB/s"), Name, 100.0 * Encoded.Num() / Src.Num(), MegaBytes / Max(EncodeTime,0.0001), MegaBytes / Max(DecodeTime,0.0001) );
+}
+
+/**
+ * Compresses and decompresses files with zlib, logging ratio and throughput.
+ */
+static void BenchmarkZlib( const TArray<BYTE>& Src )
+{
+	TArray<BYTE> Encoded( Src.Num() + Src.Num() / 100 + 12 );
+	TArray<BYTE> Decoded( Src.Num() );
+
+	DOUBLE StartTime = appSeconds();
+	uLongf EncodedSize = Encoded.Num();
+	if( compress2( &Encoded(0), &EncodedSize, &Src(0), Src.Num(), Z_BEST_COMPRESSION ) != Z_OK )
+		appErrorf( TEXT("zlib failed to compress the input") );
+	const DOUBLE EncodeTime = appSeconds() - StartTime;
+
+	StartTime = appSeconds();
+	uLongf DecodedSize = Decoded.Num();
+	if( uncompress( &Decoded(0), &DecodedSize, &Encoded(0), EncodedSize ) != Z_OK || DecodedSize != (uLongf)Src.Num() || appMemcmp( &Decoded(0), &Src(0), Src.Num() ) )
+		appErrorf( TEXT("zlib failed to reproduce the input") );
+	const DOUBLE DecodeTime = appSeconds() - StartTime;
+
+	const DOUBLE MegaBytes = Src.Num() / (1024.0 * 1024.0);
+	warnf( TEXT("  %-10s %6.2f%%  encode %8.2f MB/s  decode %8.2f MB/s"), TEXT("zlib"), 100.0 * EncodedSize / Src.Num(), MegaBytes / Max(EncodeTime,0.0001), MegaBytes / Max(DecodeTime,0.0001) );
+}
+
+INT UCodecBenchmarkCommandlet::Main( const TCHAR* Parms )
+{
+	// The reference sort is quadratic on repetitive data, -noreference skips it.
+	UBOOL Reference = !ParseParam( Parms, TEXT("noreference") );
+	FString Wildcard;
+	if( !ParseToken(Parms,Wildcard,0) )
+		appErrorf(TEXT("Source file(s) not specified"));
+	do
+	{
+		if( (Wildcard.Len() > 0) && (Wildcard[0] == '-') )
+			continue;
+
+		FString Dir;
+		INT i = Wildcard.InStr( PATH_SEPARATOR, 1 );
+		if( i != -1 )
+			Dir = Wildcard.Left( i+1 );
+		TArray<FString> Files;
+		GFileManager->FindFiles( Files, *Wildcard, 1, 0 );
+		if( Files.Num() == 0 )
+			appErrorf(TEXT("Source %s not found"), *Wildcard);
+		for( INT j=0;j<Files.Num();j++)
+		{
+			FString Src = Dir + Files(j);
+			TArray<BYTE> Data;
+			if( !appLoadFileToArray( Data, *Src ) )
+				appErrorf(TEXT("Error occurred opening %s"), *Src);
+			if( Data.Num() == 0 )
+				continue;
+			warnf(TEXT("%s: %i bytes"), *Src, Data.Num());
+
+			TArray<BYTE> ReferenceEncoded, SerialEncoded, ParallelEncoded;
+			if( Reference )
+			{
+				FCodecFull Encoder, Decoder;
+				BuildCodecChain( Encoder, new FCodecBWTReference );
+				BuildCodecChain( Decoder, new FCodecBWT(0) );
+				BenchmarkCodec( TEXT("reference"), Encoder, Decoder, Data, ReferenceEncoded );
+			}
+			{
+				FCodecFull Codec;
+				BuildCodecChain( Codec, new FCodecBWT(0) );
+				BenchmarkCodec( TEXT("serial"), Codec, Codec, Data, SerialEncoded );
+			}
+			{
+				FCodecFull Codec;
+				BuildCodecChain( Codec, new FCodecBWT(1) );
+				BenchmarkCodec( TEXT("parallel"), Codec, Codec, Data, ParallelEncoded );
+			}
+			BenchmarkZlib( Data );
+
+			// All block sorting implementations have to produce the same stream.
+			if( SerialEncoded.Num() != ParallelEncoded.Num() || appMemcmp( &SerialEncoded(0), &ParallelEncoded(0), SerialEncoded.Num() ) )
+				appErrorf( TEXT("Serial and parallel streams of %s differ"), *Src );
+			if( Reference && (ReferenceEncoded.Num() != SerialEncoded.Num() || appMemcmp( &ReferenceEncoded(0), &SerialEncoded(0), SerialEncoded.Num() )) )
+				appErrorf( TEXT("Reference and serial streams of %s differ"), *Src );
+		}
+	}
+	while( ParseToken(Parms,Wildcard,0) );
+	return 0;
+}
+IMPLEMENT_CLASS(UCodecBenchmarkCommandlet)
+
+/*-----------------------------------------------------------------------------
+	The End.
+-----------------------------------------------------------------------------*/
+
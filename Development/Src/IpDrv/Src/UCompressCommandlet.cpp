@@ -15,9 +15,16 @@ Revision history:
 -----------------------------------------------------------------------------*/
 INT UCompressCommandlet::Main( const TCHAR* Parms )
 {
+	// -chunked compresses packages in place into chunks the linker can seek in.
+	UBOOL Chunked = ParseParam( Parms, TEXT("chunked") );
 	FString Wildcard;
-	if( !ParseToken(Parms,Wildcard,0) )
-		appErrorf(TEXT("Source file(s) not specified"));
+	// Skip switches like -chunked so they aren't taken for the first source.
+	do
+	{
+		if( !ParseToken(Parms,Wildcard,0) )
+			appErrorf(TEXT("Source file(s) not specified"));
+	}
+	while( Wildcard.Len() > 0 && Wildcard[0] == '-' );
 	do
 	{
         // skip "-nohomedir", etc... --ryan.
@@ -35,6 +42,21 @@ INT UCompressCommandlet::Main( const TCHAR* Parms )
 		for( INT j=0;j<Files.Num();j++)
 		{
 			FString Src = Dir + Files(j);
+			if( Chunked )
+			{
+				FString Temp = Src + TEXT(".tmp");
+				INT SrcSize = GFileManager->FileSize(*Src);
+				if( !appCompressPackage( *Src, *Temp ) )
+				{
+					warnf(TEXT("Skipped %s, not an uncompressed package"), *Src);
+					continue;
+				}
+				INT DstSize = GFileManager->FileSize(*Temp);
+				if( !GFileManager->Move( *Src, *Temp, 1, 1 ) )
+					appErrorf(TEXT("Error occurred replacing %s"), *Src);
+				warnf(TEXT("Compressed %s in chunks (%d%%)"), *Src, 100*DstSize / SrcSize);
+				continue;
+			}
 			DWORD Result = GFileManager->Copy( *Src, *Src, 1, 1, 0, FILECOPY_Compress, NULL );
 			switch( Result )
 			{
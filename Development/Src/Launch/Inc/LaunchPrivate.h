@@ -44,6 +44,7 @@ Revision history:
 #include "FMallocWindows.h"
 #include "FMallocDebugProxyWindows.h"
 #include "FMallocThreadSafeProxy.h"
+#include "FMallocTagProxy.h"
 #include "FOutputDeviceDebug.h"
 #include "FOutputDeviceAnsiError.h"
 #include "FFeedbackContextAnsi.h"
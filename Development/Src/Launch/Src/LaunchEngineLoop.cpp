@@ -55,6 +55,16 @@ static FMallocWindows				Malloc;
 static FMallocDebugProxyWindows		MallocDebugProxy( &Malloc );
 #endif
 
+#if TRACK_MEMORY_TAGS
+#if KEEP_ALLOCATION_BACKTRACE
+/** Memory tagging proxy, attributing allocations to the tag active on the allocating thread					*/
+static FMallocTagProxy				MallocTagProxy( &MallocDebugProxy );
+#else
+/** Memory tagging proxy, attributing allocations to the tag active on the allocating thread					*/
+static FMallocTagProxy				MallocTagProxy( &Malloc );
+#endif
+#endif
+
 #ifndef XBOX
 /** Critical section used by MallocThreadSafeProxy for synchronization										*/
 static FCriticalSectionWin			MallocCriticalSection;
@@ -67,7 +77,10 @@ static __declspec(allocate(XENON_NOCLOBBER_SEG)) FCriticalSectionWin	RemoteDebug
 static __declspec(allocate(XENON_NOCLOBBER_SEG)) FCriticalSectionWin	MallocCriticalSection;
 #endif
 
-#if KEEP_ALLOCATION_BACKTRACE
+#if TRACK_MEMORY_TAGS
+/** Thread safe malloc proxy, rendering any FMalloc thread safe												*/
+static FMallocThreadSafeProxy		MallocThreadSafeProxy( &MallocTagProxy, &MallocCriticalSection );
+#elif KEEP_ALLOCATION_BACKTRACE
 /** Thread safe malloc proxy, rendering any FMalloc thread safe												*/
 static FMallocThreadSafeProxy		MallocThreadSafeProxy( &MallocDebugProxy, &MallocCriticalSection );
 #else
@@ -204,6 +217,9 @@ INT FEngineLoop::Init( const TCHAR* CmdLine )
 	// Create a new resource manager. Needs to happen before commandlet execution.
 	GResourceManager = new FResourceManager();
 
+	// Create the derived data cache, used by commandlets as well.
+	GDerivedDataCache = new FDerivedDataCache();
+
 	// Create the streaming manager and add the default static texture streamer.
 	GStreamingManager = new FStreamingManager();
 	GStreamingManager->AddStreamer( new FStaticTextureStreamer() );
@@ -213,11 +229,31 @@ INT FEngineLoop::Init( const TCHAR* CmdLine )
 	GResourceLoader->AddLoader(  new FBackgroundLoaderUnreal() );
 	
 	// Create the async IO manager and have it run on CPU 1.
+#if __LINUX__
+	GAsyncIOManager = new FAsyncIOManagerLinux();
+#else
 	GAsyncIOManager = new FAsyncIOManagerWindows();
+#endif
 	AsyncIOThread = GThreadFactory->CreateThread( GAsyncIOManager );
 	check(AsyncIOThread);
 	AsyncIOThread->SetProcessorAffinity( 1 );
 
+#if !__LINUX__
+	// Create the shared worker thread pool, leaving one hardware thread to the game thread.
+	if( GNumHardwareThreads > 1 )
+	{
+		FQueuedThreadPoolWin* ThreadPool = new FQueuedThreadPoolWin();
+		if( ThreadPool->Create( GNumHardwareThreads - 1, 128 * 1024 ) )
+		{
+			GThreadPool = ThreadPool;
+		}
+		else
+		{
+			delete ThreadPool;
+		}
+	}
+#endif
+
 #ifndef XBOX
 	// Set the game icon used by Window.cpp/ WinClient.cpp.
 #if GAMENAME == WARGAME
@@ -320,6 +356,10 @@ INT FEngineLoop::Init( const TCHAR* CmdLine )
 			Commandlet->ParseParms( appCmdLine() );
 			Commandlet->Main( appCmdLine() );
 
+			// Log how much derived data was reused and trim the cache.
+			GDerivedDataCache->DumpStats( *GLog );
+			GDerivedDataCache->Flush();
+
 			INT ErrorLevel = 0;
 
 			// Log warning/ error summary.
@@ -486,6 +526,9 @@ void FEngineLoop::Exit()
 
 	delete GEngine;
 	GEngine				= NULL;
+
+	delete GDerivedDataCache;
+	GDerivedDataCache	= NULL;
 	
 	appPreExit();
 	DestroyGameRBPhys();
@@ -499,6 +542,13 @@ void FEngineLoop::Exit()
 	delete GResourceLoader;
 	GResourceLoader		= NULL;
 
+	if( GThreadPool )
+	{
+		GThreadPool->Destroy();
+		delete GThreadPool;
+		GThreadPool		= NULL;
+	}
+
 	GThreadFactory->Destroy( AsyncIOThread );
 }
 
@@ -510,6 +560,17 @@ void FEngineLoop::Tick()
 	for(FStatGroup* Group = GFirstStatGroup;Group;Group = Group->NextGroup)
 		Group->AdvanceFrame();
 
+	// Stream out the events recorded last frame before opening this frame's scope.
+	GTraceManager.AdvanceFrame();
+	TRACE_SCOPE(TEXT("Frame"));
+
+#if TRACK_MEMORY_TAGS
+	GMemoryTagTracker.AdvanceFrame();
+#endif
+
+	// Reclaim temporaries of last frame.
+	GFrameArena.Tick();
+
 	DOUBLE	CurrentRealTime = appSeconds();
 
 	if( GIsBenchmarking && MaxFrameCounter && (FrameCounter > MaxFrameCounter) )